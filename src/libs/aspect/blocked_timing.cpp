@@ -22,9 +22,12 @@
  */
 
 #include <aspect/blocked_timing.h>
+#include <aspect/blocked_timing/graph.h>
 #include <core/threading/thread.h>
 #include <core/exception.h>
 
+#include <stdexcept>
+
 
 namespace fawkes {
 
@@ -37,6 +40,13 @@ namespace fawkes {
  * Your thread must run in Thread::OPMODE_WAITFORWAKEUP mode, otherwise it
  * is not started. This is a requirement for having the BlockedTimingAspect.
  *
+ * Optionally, a thread can declare which interfaces it reads and writes
+ * and on which earlier hooks it depends. If the main loop runs in
+ * dependency mode, threads of different hooks which do not depend on each
+ * other then run concurrently, see BlockedTimingGraph. Declarations must be
+ * made in the constructor or in init(). Threads which do not declare
+ * anything keep the strict hook order.
+ *
  * @see Thread::OpMode
  * @ingroup Aspects
  * @author Tim Niemueller
@@ -57,6 +67,7 @@ BlockedTimingAspect::BlockedTimingAspect(WakeupHook wakeup_hook)
   add_aspect("BlockedTimingAspect");
   wakeup_hook_ = wakeup_hook;
   loop_listener_ = new BlockedTimingLoopListener();
+  deps_declared_ = false;
 }
 
 
@@ -100,6 +111,114 @@ BlockedTimingAspect::blockedTimingAspectHook() const
   return wakeup_hook_;
 }
 
+
+/** Declare interface read by this thread.
+ * The thread is run after all threads of earlier hooks which write this
+ * interface, and before threads of later hooks which write it.
+ * @param interface_uid UID of the interface, i.e. type::id, may contain
+ * wildcards as supported by fnmatch()
+ */
+void
+BlockedTimingAspect::add_blocked_timing_input(const char *interface_uid)
+{
+  deps_inputs_.insert(interface_uid);
+  deps_declared_ = true;
+}
+
+
+/** Declare interface written by this thread.
+ * The thread is run after all threads of earlier hooks which read or write
+ * this interface, and before threads of later hooks which read or write it.
+ * @param interface_uid UID of the interface, i.e. type::id, may contain
+ * wildcards as supported by fnmatch()
+ */
+void
+BlockedTimingAspect::add_blocked_timing_output(const char *interface_uid)
+{
+  deps_outputs_.insert(interface_uid);
+  deps_declared_ = true;
+}
+
+
+/** Declare dependency on an earlier hook.
+ * The thread is run after all threads of the hook have finished, no
+ * matter which interfaces they use.
+ * @param syncpoint identifier of the end syncpoint of the hook, e.g.
+ * /sensors/acquire/end, see blocked_timing_hook_to_end_syncpoint()
+ * @exception Exception thrown if the syncpoint is not the end syncpoint
+ * of a hook which precedes the hook of this thread
+ */
+void
+BlockedTimingAspect::add_blocked_timing_dependency(const std::string &syncpoint)
+{
+  std::map<const WakeupHook, const std::string>::const_iterator h;
+  for (h = hook_to_syncpoint.begin(); h != hook_to_syncpoint.end(); ++h) {
+    if (blocked_timing_hook_to_end_syncpoint(h->first) == syncpoint)  break;
+  }
+  if (h == hook_to_syncpoint.end()) {
+    throw Exception("Syncpoint %s is not the end of a wakeup hook", syncpoint.c_str());
+  }
+  if (h->first >= wakeup_hook_) {
+    throw Exception("Cannot depend on %s, hook %s does not precede %s",
+		    syncpoint.c_str(), blocked_timing_hook_to_string(h->first),
+		    blocked_timing_hook_to_string(wakeup_hook_));
+  }
+  deps_hooks_.insert(h->first);
+  deps_declared_ = true;
+}
+
+
+/** Check if the thread declared its dependencies.
+ * @return true if any input, output, or dependency has been declared
+ */
+bool
+BlockedTimingAspect::blocked_timing_dependencies_declared() const
+{
+  return deps_declared_;
+}
+
+
+/** Get declared inputs.
+ * @return UIDs of interfaces read by this thread
+ */
+const std::set<std::string> &
+BlockedTimingAspect::blocked_timing_inputs() const
+{
+  return deps_inputs_;
+}
+
+
+/** Get declared outputs.
+ * @return UIDs of interfaces written by this thread
+ */
+const std::set<std::string> &
+BlockedTimingAspect::blocked_timing_outputs() const
+{
+  return deps_outputs_;
+}
+
+
+/** Get declared hook dependencies.
+ * @return hooks which must have finished before this thread runs
+ */
+const std::set<BlockedTimingAspect::WakeupHook> &
+BlockedTimingAspect::blocked_timing_dependencies() const
+{
+  return deps_hooks_;
+}
+
+
+/** Set dependency graph.
+ * Called by the graph the thread is added to.
+ * @param graph graph which gates the loop of this thread, NULL to run
+ * the loop whenever the hook is woken up
+ */
+void
+BlockedTimingAspect::set_blocked_timing_graph(BlockedTimingGraph *graph)
+{
+  loop_listener_->set_graph(graph);
+}
+
 /** Get string for wakeup hook.
  * @param hook wakeup hook to get string for
  * @return string representation of hook
@@ -166,6 +285,33 @@ BlockedTimingAspect::blocked_timing_hook_to_start_syncpoint(WakeupHook hook)
   }
 }
 
+/** Constructor. */
+BlockedTimingLoopListener::BlockedTimingLoopListener()
+{
+  graph_ = NULL;
+}
+
+/** Set dependency graph.
+ * @param graph graph to wait for before each loop, NULL to not wait
+ */
+void
+BlockedTimingLoopListener::set_graph(BlockedTimingGraph *graph)
+{
+  graph_ = graph;
+}
+
+/** The pre loop function of the BlockedTimingAspect
+ * This function is called right before the loop of the thread with the
+ * aspect. If the thread is part of a dependency graph, it waits until all
+ * threads it depends on have finished their loop.
+ * @param thread thread this loop listener belongs to
+ */
+void
+BlockedTimingLoopListener::pre_loop(Thread *thread)
+{
+  if (graph_)  graph_->wait(thread);
+}
+
 /** The post loop function of the BlockedTimingAspect
  * This function is called right after the loop of the thread with the aspect.
  * @param thread thread this loop listener belongs to
@@ -173,6 +319,7 @@ BlockedTimingAspect::blocked_timing_hook_to_start_syncpoint(WakeupHook hook)
 void
 BlockedTimingLoopListener::post_loop(Thread *thread)
 {
+  if (graph_)  graph_->done(thread);
   thread->wakeup();
 }
 
@@ -29,10 +29,12 @@
 #include <core/threading/thread_loop_listener.h>
 
 #include <map>
+#include <set>
 #include <string>
 
 namespace fawkes {
 
+class BlockedTimingGraph;
 
 /** @class BlockedTimingLoopListener
  * Loop Listener of the BlockedTimingAspect.
@@ -45,7 +47,15 @@ namespace fawkes {
 class BlockedTimingLoopListener : public ThreadLoopListener
 {
  public:
+  BlockedTimingLoopListener();
+
+  void pre_loop(Thread *thread);
   void post_loop(Thread *thread);
+
+  void set_graph(BlockedTimingGraph *graph);
+
+ private:
+  BlockedTimingGraph *graph_;
 };
 
 class BlockedTimingAspect : public SyncPointAspect
@@ -84,14 +94,32 @@ class BlockedTimingAspect : public SyncPointAspect
 
   WakeupHook blockedTimingAspectHook() const;
 
+  void add_blocked_timing_input(const char *interface_uid);
+  void add_blocked_timing_output(const char *interface_uid);
+  void add_blocked_timing_dependency(const std::string &syncpoint);
+
+  bool blocked_timing_dependencies_declared() const;
+  const std::set<std::string> &  blocked_timing_inputs() const;
+  const std::set<std::string> &  blocked_timing_outputs() const;
+  const std::set<WakeupHook> &   blocked_timing_dependencies() const;
+
   /** Translation from WakeupHooks to SyncPoints. Each WakeupHook corresponds to
    *  exactly one SyncPoint, e.g., WAKEUP_HOOK_PRE_LOOP becomes /preloop.
    */
   static const std::map<const WakeupHook, const std::string> hook_to_syncpoint;
 
+ private:
+  friend class BlockedTimingGraph;
+  void set_blocked_timing_graph(BlockedTimingGraph *graph);
+
  private:
   WakeupHook wakeup_hook_;
   BlockedTimingLoopListener *loop_listener_;
+
+  bool                   deps_declared_;
+  std::set<std::string>  deps_inputs_;
+  std::set<std::string>  deps_outputs_;
+  std::set<WakeupHook>   deps_hooks_;
 };
 
 } // end namespace fawkes
@@ -0,0 +1,510 @@
+
+/***************************************************************************
+ *  graph.cpp - Dependency graph of BlockedTimingAspect threads
+ *
+ *  Created: Fri Oct 16 18:12:40 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <aspect/blocked_timing/graph.h>
+#include <core/threading/thread.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <core/threading/wait_condition.h>
+
+#include <fnmatch.h>
+#include <ctime>
+
+namespace fawkes {
+
+/** @class BlockedTimingGraph <aspect/blocked_timing/graph.h>
+ * Dependency graph of BlockedTimingAspect threads.
+ * In the default main loop the hooks are woken up strictly one after
+ * another. With the graph, the main loop wakes up all hooks at once and
+ * every thread waits only for the threads it actually depends on.
+ *
+ * A thread of a later hook depends on a thread of an earlier hook if
+ * - either of them did not declare its dependencies, which keeps the strict
+ *   hook order for threads which are not aware of the graph,
+ * - it declared a dependency on the hook of the other thread,
+ * - it reads an interface the other thread writes,
+ * - it writes an interface the other thread reads or writes, such that
+ *   the other thread still sees the data it would have seen in the
+ *   sequential order.
+ *
+ * Threads of the same hook never depend on each other, they have always
+ * run concurrently. Since all dependencies point from an earlier to a later
+ * hook the graph is acyclic and the hook order is a valid topological order.
+ *
+ * A thread which exceeds the maximum thread time releases its dependents
+ * once its time is up, as the sequential main loop would proceed with the
+ * next hook. A thread which still runs when the next iteration starts
+ * misses that iteration, and its dependents do not wait for it.
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+BlockedTimingGraph::BlockedTimingGraph()
+{
+  mutex_            = new Mutex();
+  waitcond_         = new WaitCondition(mutex_);
+  enabled_          = false;
+  dirty_            = false;
+  running_          = false;
+  generation_       = 0;
+  num_dependencies_ = 0;
+  depth_            = 0;
+  num_waiting_      = 0;
+  max_thread_time_  = 0;
+}
+
+
+/** Destructor. */
+BlockedTimingGraph::~BlockedTimingGraph()
+{
+  delete waitcond_;
+  delete mutex_;
+}
+
+
+/** Add thread.
+ * The declarations of the thread are copied, changes after adding the
+ * thread are not considered. Threads without the BlockedTimingAspect are
+ * ignored.
+ * @param thread thread to add
+ */
+void
+BlockedTimingGraph::add(Thread *thread)
+{
+  BlockedTimingAspect *bt = dynamic_cast<BlockedTimingAspect *>(thread);
+  if (! bt)  return;
+
+  MutexLocker lock(mutex_);
+  Node &n = nodes_[thread];
+  n.hook     = bt->blockedTimingAspectHook();
+  n.name     = thread->name();
+  n.declared = bt->blocked_timing_dependencies_declared();
+  n.inputs   = bt->blocked_timing_inputs();
+  n.outputs  = bt->blocked_timing_outputs();
+  n.deps     = bt->blocked_timing_dependencies();
+  n.num_predecessors = n.level = n.pending = 0;
+  n.released = n.finished = n.expired = n.skipped = 0;
+  n.deadline = 0;
+  dirty_ = true;
+
+  bt->set_blocked_timing_graph(this);
+}
+
+
+/** Remove thread.
+ * The thread must not run its loop while it is removed.
+ * @param thread thread to remove
+ */
+void
+BlockedTimingGraph::remove(Thread *thread)
+{
+  BlockedTimingAspect *bt = dynamic_cast<BlockedTimingAspect *>(thread);
+  if (! bt)  return;
+
+  MutexLocker lock(mutex_);
+  if (nodes_.erase(thread) > 0) {
+    bt->set_blocked_timing_graph(NULL);
+    dirty_ = true;
+    // successors may point to the removed node, rebuild right away
+    build();
+  }
+}
+
+
+/** Enable or disable the graph.
+ * If disabled, threads do not wait for each other, which is required if
+ * the main loop wakes up the hooks one after another.
+ * @param enabled true to enable, false to disable
+ */
+void
+BlockedTimingGraph::set_enabled(bool enabled)
+{
+  MutexLocker lock(mutex_);
+  __atomic_store_n(&enabled_, enabled, __ATOMIC_RELEASE);
+  if (! enabled) {
+    running_ = false;
+    waitcond_->wake_all();
+  }
+}
+
+
+/** Check if graph is enabled.
+ * @return true if enabled, false otherwise
+ */
+bool
+BlockedTimingGraph::enabled() const
+{
+  return __atomic_load_n(&enabled_, __ATOMIC_ACQUIRE);
+}
+
+
+/** Set maximum thread time.
+ * Threads waiting for a thread which runs longer are released.
+ * @param max_thread_time_usec maximum time in microseconds a thread may run
+ * per loop, 0 to wait for threads without limit
+ */
+void
+BlockedTimingGraph::set_max_thread_time(unsigned int max_thread_time_usec)
+{
+  MutexLocker lock(mutex_);
+  max_thread_time_ = max_thread_time_usec;
+}
+
+
+/** Start iteration.
+ * Call this before waking up the hooks. The graph is rebuilt if threads
+ * have been added or removed. Threads which have not finished the last
+ * iteration are skipped, they cannot be woken up in this iteration.
+ */
+void
+BlockedTimingGraph::start_iteration()
+{
+  MutexLocker lock(mutex_);
+  if (dirty_)  build();
+
+  unsigned int last = generation_++;
+  std::map<Thread *, Node>::iterator n;
+  for (n = nodes_.begin(); n != nodes_.end(); ++n) {
+    n->second.pending = n->second.num_predecessors;
+  }
+  for (n = nodes_.begin(); n != nodes_.end(); ++n) {
+    if ((last > 0) && (n->second.released == last) && (n->second.finished != last)) {
+      n->second.skipped = generation_;
+      release_successors(&n->second);
+    }
+  }
+  running_ = true;
+}
+
+
+/** Finish iteration.
+ * Call this after all hooks have finished or timed out. Threads still
+ * waiting for their predecessors, e.g. because a predecessor exceeded
+ * its time limit, are released and run late.
+ */
+void
+BlockedTimingGraph::finish_iteration()
+{
+  MutexLocker lock(mutex_);
+  running_ = false;
+  waitcond_->wake_all();
+}
+
+
+/** Wait for predecessors.
+ * Called by the thread before its loop. Returns immediately if the graph
+ * is disabled, outside of an iteration, or if the thread does not depend
+ * on any thread which has not finished yet. Cancellation is deferred while
+ * waiting, the wait ends when all predecessors finished or exceeded the
+ * maximum thread time, and with the iteration at the latest.
+ * @param thread calling thread
+ */
+void
+BlockedTimingGraph::wait(Thread *thread)
+{
+  if (! __atomic_load_n(&enabled_, __ATOMIC_ACQUIRE))  return;
+
+  // the wait is bounded by the iteration, do not get cancelled holding the lock
+  Thread::CancelState old_cancel_state;
+  Thread::set_cancel_state(Thread::CANCEL_DISABLED, &old_cancel_state);
+
+  mutex_->lock();
+  std::map<Thread *, Node>::iterator n = nodes_.find(thread);
+  if (n != nodes_.end()) {
+    unsigned int generation = generation_;
+    ++num_waiting_;
+    while (enabled_ && running_ && (generation == generation_) && (n->second.pending > 0)) {
+      long int timeout_usec = expire_overdue();
+      if (n->second.pending == 0)  break;
+      if (timeout_usec > 0) {
+	waitcond_->reltimed_wait(timeout_usec / 1000000, (timeout_usec % 1000000) * 1000);
+      } else {
+	waitcond_->wait();
+      }
+    }
+    --num_waiting_;
+    n->second.released = generation;
+    n->second.deadline = now_usec() + max_thread_time_;
+    // waiting threads must consider the deadline of this thread
+    if ((num_waiting_ > 0) && (max_thread_time_ > 0))  waitcond_->wake_all();
+  }
+  mutex_->unlock();
+
+  Thread::set_cancel_state(old_cancel_state);
+}
+
+
+/** Mark thread as done.
+ * Called by the thread after its loop, releases threads which only waited
+ * for this thread.
+ * @param thread calling thread
+ */
+void
+BlockedTimingGraph::done(Thread *thread)
+{
+  if (! __atomic_load_n(&enabled_, __ATOMIC_ACQUIRE))  return;
+
+  MutexLocker lock(mutex_);
+  std::map<Thread *, Node>::iterator n = nodes_.find(thread);
+  // ignore threads which ran late in a previous iteration
+  if ((n == nodes_.end()) || (n->second.released != generation_))  return;
+
+  n->second.finished = generation_;
+  // successors have been released already if the thread ran too long
+  if (! running_ || (n->second.expired == generation_) ||
+      (n->second.skipped == generation_))
+  {
+    return;
+  }
+  if (release_successors(&n->second))  waitcond_->wake_all();
+}
+
+
+/** Get threads which finished.
+ * @param hook hook to get threads for
+ * @return names of the threads of the given hook which have finished their
+ * loop in the current or, after finish_iteration(), the last iteration
+ */
+std::set<std::string>
+BlockedTimingGraph::finished(BlockedTimingAspect::WakeupHook hook)
+{
+  MutexLocker lock(mutex_);
+  std::set<std::string> rv;
+  std::map<Thread *, Node>::iterator n;
+  for (n = nodes_.begin(); n != nodes_.end(); ++n) {
+    if ((n->second.hook == hook) && (n->second.finished == generation_)) {
+      rv.insert(n->second.name);
+    }
+  }
+  return rv;
+}
+
+
+/** Get predecessors of a thread.
+ * @param thread_name name of the thread
+ * @return names of the threads the given thread waits for
+ */
+std::list<std::string>
+BlockedTimingGraph::predecessors(const char *thread_name)
+{
+  MutexLocker lock(mutex_);
+  if (dirty_)  build();
+
+  std::list<std::string> rv;
+  std::map<Thread *, Node>::iterator n;
+  for (n = nodes_.begin(); n != nodes_.end(); ++n) {
+    for (size_t i = 0; i < n->second.successors.size(); ++i) {
+      if (n->second.successors[i]->name == thread_name) {
+	rv.push_back(n->second.name);
+      }
+    }
+  }
+  return rv;
+}
+
+
+/** Get number of dependencies.
+ * @return number of edges in the graph
+ */
+unsigned int
+BlockedTimingGraph::num_dependencies()
+{
+  MutexLocker lock(mutex_);
+  if (dirty_)  build();
+  return num_dependencies_;
+}
+
+
+/** Get depth of the graph.
+ * @return number of threads on the longest chain of dependencies, i.e. the
+ * maximum number of threads which run one after another in an iteration
+ */
+unsigned int
+BlockedTimingGraph::depth()
+{
+  MutexLocker lock(mutex_);
+  if (dirty_)  build();
+  return depth_;
+}
+
+
+void
+BlockedTimingGraph::build()
+{
+  std::map<Thread *, Node>::iterator a, b;
+  for (a = nodes_.begin(); a != nodes_.end(); ++a) {
+    a->second.successors.clear();
+    a->second.num_predecessors = 0;
+    a->second.level = 1;
+  }
+
+  num_dependencies_ = 0;
+  for (a = nodes_.begin(); a != nodes_.end(); ++a) {
+    for (b = nodes_.begin(); b != nodes_.end(); ++b) {
+      if ((a->second.hook < b->second.hook) && depends(&a->second, &b->second)) {
+	a->second.successors.push_back(&b->second);
+	b->second.num_predecessors += 1;
+	++num_dependencies_;
+      }
+    }
+  }
+
+  // edges only lead to later hooks, visit nodes in hook order
+  std::multimap<BlockedTimingAspect::WakeupHook, Node *> order;
+  for (a = nodes_.begin(); a != nodes_.end(); ++a) {
+    order.insert(std::make_pair(a->second.hook, &a->second));
+  }
+  depth_ = 0;
+  std::multimap<BlockedTimingAspect::WakeupHook, Node *>::iterator o;
+  for (o = order.begin(); o != order.end(); ++o) {
+    Node *n = o->second;
+    for (size_t i = 0; i < n->successors.size(); ++i) {
+      if (n->successors[i]->level <= n->level)  n->successors[i]->level = n->level + 1;
+    }
+    if (n->level > depth_)  depth_ = n->level;
+  }
+  dirty_ = false;
+}
+
+
+/** Release successors of a node.
+ * The mutex must be locked.
+ * @param n node whose successors no longer wait for it
+ * @return true if a successor has no pending predecessors anymore
+ */
+bool
+BlockedTimingGraph::release_successors(Node *n)
+{
+  bool ready = false;
+  for (size_t i = 0; i < n->successors.size(); ++i) {
+    Node *s = n->successors[i];
+    if ((s->pending > 0) && (--s->pending == 0))  ready = true;
+  }
+  return ready;
+}
+
+
+/** Release successors of threads which ran too long.
+ * The mutex must be locked.
+ * @return time in microseconds until the next running thread exceeds the
+ * maximum thread time, 0 if there is no such thread
+ */
+long int
+BlockedTimingGraph::expire_overdue()
+{
+  if (max_thread_time_ == 0)  return 0;
+
+  long int now  = now_usec();
+  long int next = 0;
+  bool wake = false;
+  std::map<Thread *, Node>::iterator n;
+  for (n = nodes_.begin(); n != nodes_.end(); ++n) {
+    Node &m = n->second;
+    if ((m.released != generation_) || (m.finished == generation_) ||
+	(m.expired == generation_) || (m.skipped == generation_))
+    {
+      continue;
+    }
+    if (now >= m.deadline) {
+      m.expired = generation_;
+      if (release_successors(&m))  wake = true;
+    } else if ((next == 0) || (m.deadline - now < next)) {
+      next = m.deadline - now;
+    }
+  }
+  if (wake)  waitcond_->wake_all();
+  return next;
+}
+
+
+long int
+BlockedTimingGraph::now_usec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+
+/** Check if b must run after a.
+ * @param a node of an earlier hook
+ * @param b node of a later hook
+ * @return true if b depends on a
+ */
+bool
+BlockedTimingGraph::depends(const Node *a, const Node *b)
+{
+  if (! a->declared || ! b->declared)  return true;
+  if (b->deps.find(a->hook) != b->deps.end())  return true;
+  return (intersect(a->outputs, b->inputs) ||
+	  intersect(a->inputs, b->outputs) ||
+	  intersect(a->outputs, b->outputs));
+}
+
+
+/** Check if two patterns may match the same string.
+ * Two patterns with wildcards are assumed to overlap.
+ * @param a first pattern
+ * @param b second pattern
+ * @return true if a string may match both patterns
+ */
+static bool
+overlap(const std::string &a, const std::string &b)
+{
+  bool wild_a = (a.find_first_of("*?[") != std::string::npos);
+  bool wild_b = (b.find_first_of("*?[") != std::string::npos);
+  if (wild_a && wild_b)  return true;
+  return ((a == b) ||
+	  (wild_a && (fnmatch(a.c_str(), b.c_str(), 0) == 0)) ||
+	  (wild_b && (fnmatch(b.c_str(), a.c_str(), 0) == 0)));
+}
+
+
+/** Check if two sets of interface UIDs share an interface.
+ * Type and ID of the UIDs are compared separately, such that for example
+ * Position3DInterface::* and *::Pose are considered to intersect.
+ * @param a first set of UIDs
+ * @param b second set of UIDs
+ * @return true if an interface may be in both sets
+ */
+bool
+BlockedTimingGraph::intersect(const std::set<std::string> &a, const std::set<std::string> &b)
+{
+  std::set<std::string>::const_iterator i, j;
+  for (i = a.begin(); i != a.end(); ++i) {
+    std::string::size_type isep = i->find("::");
+    for (j = b.begin(); j != b.end(); ++j) {
+      std::string::size_type jsep = j->find("::");
+      if ((isep == std::string::npos) || (jsep == std::string::npos)) {
+	if (overlap(*i, *j))  return true;
+      } else if (overlap(i->substr(0, isep), j->substr(0, jsep)) &&
+		 overlap(i->substr(isep + 2), j->substr(jsep + 2)))
+      {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // end namespace fawkes
@@ -0,0 +1,112 @@
+
+/***************************************************************************
+ *  graph.h - Dependency graph of BlockedTimingAspect threads
+ *
+ *  Created: Fri Oct 16 18:12:40 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _ASPECT_BLOCKED_TIMING_GRAPH_H_
+#define _ASPECT_BLOCKED_TIMING_GRAPH_H_
+
+#include <aspect/blocked_timing.h>
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace fawkes {
+
+class Thread;
+class Mutex;
+class WaitCondition;
+
+class BlockedTimingGraph
+{
+ public:
+  BlockedTimingGraph();
+  ~BlockedTimingGraph();
+
+  void add(Thread *thread);
+  void remove(Thread *thread);
+
+  void set_enabled(bool enabled);
+  bool enabled() const;
+  void set_max_thread_time(unsigned int max_thread_time_usec);
+
+  void start_iteration();
+  void finish_iteration();
+
+  void wait(Thread *thread);
+  void done(Thread *thread);
+
+  std::set<std::string>  finished(BlockedTimingAspect::WakeupHook hook);
+  std::list<std::string> predecessors(const char *thread_name);
+  unsigned int           num_dependencies();
+  unsigned int           depth();
+
+ private:
+  /// @cond INTERNALS
+  struct Node {
+    BlockedTimingAspect::WakeupHook         hook;
+    std::string                             name;
+    bool                                    declared;
+    std::set<std::string>                   inputs;
+    std::set<std::string>                   outputs;
+    std::set<BlockedTimingAspect::WakeupHook> deps;
+
+    std::vector<Node *>                     successors;
+    unsigned int                            num_predecessors;
+    unsigned int                            level;
+    unsigned int                            pending;
+    unsigned int                            released;
+    unsigned int                            finished;
+    unsigned int                            expired;
+    unsigned int                            skipped;
+    long int                                deadline;
+  };
+  /// @endcond
+
+  void build();
+  bool release_successors(Node *n);
+  long int expire_overdue();
+  static long int now_usec();
+  static bool depends(const Node *a, const Node *b);
+  static bool intersect(const std::set<std::string> &a, const std::set<std::string> &b);
+
+ private:
+  Mutex         *mutex_;
+  WaitCondition *waitcond_;
+
+  std::map<Thread *, Node>  nodes_;
+
+  bool          enabled_;
+  bool          dirty_;
+  bool          running_;
+  unsigned int  generation_;
+  unsigned int  num_dependencies_;
+  unsigned int  depth_;
+  unsigned int  num_waiting_;
+  unsigned int  max_thread_time_;
+};
+
+} // end namespace fawkes
+
+#endif
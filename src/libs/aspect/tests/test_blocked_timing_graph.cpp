@@ -0,0 +1,324 @@
+/***************************************************************************
+ *  test_blocked_timing_graph.cpp - BlockedTimingGraph Unit Test
+ *
+ *  Created: Sat Oct 17 10:12:25 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <aspect/blocked_timing.h>
+#include <aspect/blocked_timing/graph.h>
+#include <core/threading/thread.h>
+#include <core/exception.h>
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <list>
+#include <set>
+#include <string>
+
+using namespace fawkes;
+using namespace std;
+
+/** @class GraphTestThread
+ * Thread with the BlockedTimingAspect for testing purposes.
+ * It is never started, the graph only uses it as a key and reads its
+ * declarations.
+ */
+class GraphTestThread : public Thread, public BlockedTimingAspect
+{
+ public:
+  /** Constructor.
+   * @param name thread name
+   * @param hook wakeup hook
+   */
+  GraphTestThread(const char *name, WakeupHook hook)
+    : Thread(name, Thread::OPMODE_WAITFORWAKEUP), BlockedTimingAspect(hook)
+  {
+  }
+
+  /** Declare interface read by the thread.
+   * @param uid interface UID
+   * @return this thread
+   */
+  GraphTestThread * in(const char *uid)
+  {
+    add_blocked_timing_input(uid);
+    return this;
+  }
+
+  /** Declare interface written by the thread.
+   * @param uid interface UID
+   * @return this thread
+   */
+  GraphTestThread * out(const char *uid)
+  {
+    add_blocked_timing_output(uid);
+    return this;
+  }
+
+  /** Declare dependency on an earlier hook.
+   * @param hook hook to depend on
+   * @return this thread
+   */
+  GraphTestThread * after(WakeupHook hook)
+  {
+    add_blocked_timing_dependency(blocked_timing_hook_to_end_syncpoint(hook));
+    return this;
+  }
+
+ protected:
+  virtual void loop() {}
+};
+
+
+/** @class BlockedTimingGraphTest
+ * Test class for BlockedTimingGraph.
+ */
+class BlockedTimingGraphTest : public ::testing::Test
+{
+ protected:
+  /** Clean up */
+  virtual void TearDown()
+  {
+    for (list<GraphTestThread *>::iterator t = threads.begin(); t != threads.end(); ++t) {
+      graph.remove(*t);
+      delete *t;
+    }
+  }
+
+  /** Create thread and add it to the graph later.
+   * @param name thread name
+   * @param hook wakeup hook
+   * @return new thread
+   */
+  GraphTestThread * thread(const char *name, BlockedTimingAspect::WakeupHook hook)
+  {
+    GraphTestThread *t = new GraphTestThread(name, hook);
+    threads.push_back(t);
+    return t;
+  }
+
+  /** Add all threads to the graph. */
+  void add_all()
+  {
+    for (list<GraphTestThread *>::iterator t = threads.begin(); t != threads.end(); ++t) {
+      graph.add(*t);
+    }
+  }
+
+  /** Check if a thread waits for another one.
+   * @param later name of the thread of the later hook
+   * @param earlier name of the thread of the earlier hook
+   * @return true if later waits for earlier
+   */
+  bool waits_for(const char *later, const char *earlier)
+  {
+    list<string> p = graph.predecessors(later);
+    return find(p.begin(), p.end(), earlier) != p.end();
+  }
+
+  /** Graph under test */
+  BlockedTimingGraph graph;
+  /** Threads added to the graph */
+  list<GraphTestThread *> threads;
+};
+
+
+TEST_F(BlockedTimingGraphTest, UndeclaredThreadsKeepHookOrder)
+{
+  thread("acquire", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  thread("think",   BlockedTimingAspect::WAKEUP_HOOK_THINK);
+  thread("act",     BlockedTimingAspect::WAKEUP_HOOK_ACT);
+  thread("act2",    BlockedTimingAspect::WAKEUP_HOOK_ACT)->in("A::a");
+  add_all();
+
+  EXPECT_TRUE(waits_for("think", "acquire"));
+  EXPECT_TRUE(waits_for("act", "think"));
+  EXPECT_TRUE(waits_for("act", "acquire"));
+  EXPECT_TRUE(waits_for("act2", "think"));
+  EXPECT_FALSE(waits_for("act2", "act"));
+  EXPECT_FALSE(waits_for("acquire", "think"));
+  EXPECT_EQ(5u, graph.num_dependencies());
+  EXPECT_EQ(3u, graph.depth());
+}
+
+TEST_F(BlockedTimingGraphTest, InterfaceDependencies)
+{
+  thread("writer",   BlockedTimingAspect::WAKEUP_HOOK_SENSOR_PROCESS)->out("Pose::odom");
+  thread("reader",   BlockedTimingAspect::WAKEUP_HOOK_THINK)->in("Pose::odom");
+  thread("other",    BlockedTimingAspect::WAKEUP_HOOK_SKILL)->in("Laser::front");
+  thread("overwrite", BlockedTimingAspect::WAKEUP_HOOK_ACT)->out("Pose::odom");
+  thread("coreader", BlockedTimingAspect::WAKEUP_HOOK_ACT_EXEC)->in("Laser::front");
+  thread("cowriter", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_PROCESS)->out("Pose::odom");
+  add_all();
+
+  // read after write
+  EXPECT_TRUE(waits_for("reader", "writer"));
+  // write after read and write after write
+  EXPECT_TRUE(waits_for("overwrite", "reader"));
+  EXPECT_TRUE(waits_for("overwrite", "writer"));
+  // unrelated interfaces and read after read
+  EXPECT_FALSE(waits_for("other", "writer"));
+  EXPECT_FALSE(waits_for("coreader", "other"));
+  // threads of the same hook never wait for each other
+  EXPECT_FALSE(waits_for("cowriter", "writer"));
+  EXPECT_FALSE(waits_for("writer", "cowriter"));
+
+  EXPECT_EQ(3u, graph.depth());
+}
+
+TEST_F(BlockedTimingGraphTest, WildcardsIntersect)
+{
+  thread("writer", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_PROCESS)->out("Pose::odom");
+  thread("front",  BlockedTimingAspect::WAKEUP_HOOK_SENSOR_PROCESS)->out("Laser::front");
+  thread("all",    BlockedTimingAspect::WAKEUP_HOOK_THINK)->in("Pose::*");
+  thread("none",   BlockedTimingAspect::WAKEUP_HOOK_THINK)->in("Laser::*");
+  thread("late",   BlockedTimingAspect::WAKEUP_HOOK_ACT)->out("*::odom");
+  add_all();
+
+  EXPECT_TRUE(waits_for("all", "writer"));
+  EXPECT_FALSE(waits_for("none", "writer"));
+  EXPECT_TRUE(waits_for("late", "all"));
+  EXPECT_TRUE(waits_for("late", "writer"));
+  EXPECT_FALSE(waits_for("late", "front"));
+  // both could match Laser::odom
+  EXPECT_TRUE(waits_for("late", "none"));
+}
+
+TEST_F(BlockedTimingGraphTest, HookDependencies)
+{
+  thread("acquire", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE)->out("A::a");
+  thread("prepare", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_PREPARE)->out("B::b");
+  thread("think",   BlockedTimingAspect::WAKEUP_HOOK_THINK)
+    ->after(BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  add_all();
+
+  EXPECT_TRUE(waits_for("think", "acquire"));
+  EXPECT_FALSE(waits_for("think", "prepare"));
+  EXPECT_EQ(1u, graph.num_dependencies());
+  EXPECT_EQ(2u, graph.depth());
+
+  GraphTestThread *t = thread("invalid", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  EXPECT_THROW(t->after(BlockedTimingAspect::WAKEUP_HOOK_THINK), Exception);
+  EXPECT_THROW(t->after(BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE), Exception);
+}
+
+TEST_F(BlockedTimingGraphTest, RemoveRebuilds)
+{
+  thread("acquire", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  thread("think",   BlockedTimingAspect::WAKEUP_HOOK_THINK);
+  add_all();
+  EXPECT_EQ(1u, graph.num_dependencies());
+
+  GraphTestThread *t = threads.front();
+  threads.pop_front();
+  graph.remove(t);
+  delete t;
+  EXPECT_EQ(0u, graph.num_dependencies());
+  EXPECT_TRUE(graph.predecessors("think").empty());
+  EXPECT_EQ(1u, graph.depth());
+}
+
+/// @cond INTERNALS
+struct waiter_params {
+  BlockedTimingGraph *graph;
+  Thread             *thread;
+  double              waited_sec;
+};
+/// @endcond
+
+static double
+now_sec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+call_wait(void *data)
+{
+  waiter_params *p = (waiter_params *)data;
+  double start = now_sec();
+  p->graph->wait(p->thread);
+  p->waited_sec = now_sec() - start;
+  return NULL;
+}
+
+TEST_F(BlockedTimingGraphTest, DoneReleasesDependents)
+{
+  GraphTestThread *a = thread("acquire", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  GraphTestThread *b = thread("think",   BlockedTimingAspect::WAKEUP_HOOK_THINK);
+  add_all();
+  graph.set_enabled(true);
+  graph.start_iteration();
+
+  waiter_params p = { &graph, b, -1. };
+  pthread_t waiter;
+  pthread_create(&waiter, NULL, call_wait, &p);
+  graph.wait(a);
+  usleep(50000);
+  EXPECT_LT(p.waited_sec, 0.);
+  graph.done(a);
+  pthread_join(waiter, NULL);
+  EXPECT_GE(p.waited_sec, 0.04);
+  graph.done(b);
+
+  set<string> finished = graph.finished(BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  EXPECT_EQ(1u, finished.count("acquire"));
+  graph.finish_iteration();
+  graph.set_enabled(false);
+}
+
+TEST_F(BlockedTimingGraphTest, OverrunReleasesDependents)
+{
+  GraphTestThread *a = thread("acquire", BlockedTimingAspect::WAKEUP_HOOK_SENSOR_ACQUIRE);
+  GraphTestThread *b = thread("think",   BlockedTimingAspect::WAKEUP_HOOK_THINK);
+  add_all();
+  graph.set_max_thread_time(50000);
+  graph.set_enabled(true);
+  graph.start_iteration();
+
+  // acquire never finishes, think is released after the maximum thread time
+  graph.wait(a);
+  waiter_params p = { &graph, b, -1. };
+  pthread_t waiter;
+  pthread_create(&waiter, NULL, call_wait, &p);
+  pthread_join(waiter, NULL);
+  EXPECT_GE(p.waited_sec, 0.04);
+  EXPECT_LT(p.waited_sec, 1.);
+  graph.done(b);
+  graph.finish_iteration();
+
+  // acquire still runs and misses the next iteration, think does not wait
+  graph.start_iteration();
+  p.waited_sec = -1.;
+  pthread_create(&waiter, NULL, call_wait, &p);
+  pthread_join(waiter, NULL);
+  EXPECT_LT(p.waited_sec, 0.04);
+  graph.done(b);
+
+  // acquire finishes late, it does not release anything twice
+  graph.done(a);
+  graph.finish_iteration();
+  graph.set_enabled(false);
+}
@@ -32,6 +32,8 @@
 #include <utils/time/wait.h>
 
 #include <aspect/manager.h>
+#include <aspect/blocked_timing/graph.h>
+#include <baseapp/thread_loop_times.h>
 #include <plugin/manager.h>
 #include <plugin/loader.h>
 
@@ -50,6 +52,11 @@ namespace fawkes {
  * This thread initializes all important stuff like the BlackBoard,
  * handles plugins and wakes up threads at defined hooks.
  *
+ * By default the hooks are woken up one after another. If the wakeup mode
+ * is set to "dependencies" in the configuration, all hooks are woken up at
+ * once and threads only wait for the threads they depend on, see
+ * BlockedTimingGraph.
+ *
  * @author Tim Niemueller
  */
 
@@ -81,6 +88,7 @@ FawkesMainThread::FawkesMainThread(Configuration *config,
   config_            = config;
 
   mainloop_thread_   = NULL;
+  bt_graph_          = NULL;
   mainloop_mutex_    = new Mutex();
   mainloop_barrier_  = new InterruptibleBarrier(mainloop_mutex_, 2);
 
@@ -132,6 +140,19 @@ FawkesMainThread::FawkesMainThread(Configuration *config,
   } catch(Exception &e) {
     enable_looptime_warnings_ = true;
   }
+
+  try {
+    std::string wakeup_mode = config_->get_string("/fawkes/mainapp/wakeup_mode");
+    if (wakeup_mode == "dependencies") {
+      bt_graph_ = thread_manager_->blocked_timing_graph();
+      bt_graph_->set_max_thread_time(max_thread_time_usec_);
+      bt_graph_->set_enabled(true);
+      multi_logger_->log_info("FawkesMainApp", "Waking up threads by dependencies");
+    } else if (wakeup_mode != "sequential") {
+      multi_logger_->log_warn("FawkesMainApp", "Unknown wakeup mode '%s', "
+			       "using sequential", wakeup_mode.c_str());
+    }
+  } catch (Exception &e) {} // ignored, use default
 }
 
 
@@ -175,6 +196,7 @@ FawkesMainThread::destruct()
     multi_logger_->log_warn("FawkesMainThread", e);
   }
 
+  if (bt_graph_)       bt_graph_->set_enabled(false);
   if (load_plugins_)   free(load_plugins_);
   if (default_plugin_) free(default_plugin_);
 
@@ -334,11 +356,36 @@ FawkesMainThread::loop()
       }
     } else {
       uint num_hooks = syncpoints_start_hook_.size();
+      ThreadLoopTimes *loop_times = thread_manager_->loop_times();
       if (syncpoints_end_hook_.size() != num_hooks) {
         multi_logger_->log_error("FawkesMainThread",
           "Hook syncpoints are not initialized properly, not waking up any threads!");
+      } else if (bt_graph_) {
+        wait_for_hook_threads();
+        bt_graph_->start_iteration();
+        // each thread on the longest chain of dependencies may take the
+        // maximum thread time, as if woken up hook after hook
+        Time deadline;
+        deadline.stamp_systime();
+        deadline += (long int)bt_graph_->depth() * max_thread_time_usec_;
+        // threads of later hooks may finish first, keep their end syncpoints
+        // from completing before we wait for them
+        for (uint i = 0; i < num_hooks; i++) {
+          syncpoints_end_hook_[i]->lock_until_next_wait("FawkesMainThread");
+        }
+        for (uint i = 0; i < num_hooks; i++) {
+          loop_times->wakeup((BlockedTimingAspect::WakeupHook)i);
+          syncpoints_start_hook_[i]->emit("FawkesMainThread");
+        }
+        for (uint i = 0; i < num_hooks; i++) {
+          unsigned int sec = 0, nsec = 0;
+          if (max_thread_time_usec_ > 0)  time_left(deadline, sec, nsec);
+          syncpoints_end_hook_[i]->reltime_wait_for_all("FawkesMainThread", sec, nsec);
+        }
+        bt_graph_->finish_iteration();
       } else {
         for (uint i = 0; i < num_hooks; i++) {
+          loop_times->wakeup((BlockedTimingAspect::WakeupHook)i);
           syncpoints_start_hook_[i]->emit("FawkesMainThread");
           syncpoints_end_hook_[i]->reltime_wait_for_all("FawkesMainThread",
               0, max_thread_time_nanosec_);
@@ -373,6 +420,8 @@ FawkesMainThread::loop()
       recovered_threads_.clear();
     }
 
+    thread_manager_->loop_times()->publish();
+
     if (desired_loop_time_sec_ > 0) {
       loop_end_->stamp_systime();
       float loop_time = *loop_end_ - loop_start_;
@@ -410,6 +459,60 @@ FawkesMainThread::loop()
 }
 
 
+/** Wait until threads wait for the next start of their hook.
+ * Without the sequential order, the thread which finished last can be of
+ * any hook. It may not wait for its start syncpoint yet when all hooks are
+ * woken up right away, and would miss the start. Threads which did not
+ * finish in the last iteration are not waited for. All threads together
+ * are waited for at most the maximum thread time.
+ */
+void
+FawkesMainThread::wait_for_hook_threads()
+{
+  if (max_thread_time_usec_ == 0)  return;
+
+  Time deadline;
+  deadline.stamp_systime();
+  deadline += (long int)max_thread_time_usec_;
+
+  for (uint i = 0; i < syncpoints_start_hook_.size(); i++) {
+    std::set<std::string> threads =
+      bt_graph_->finished((BlockedTimingAspect::WakeupHook)i);
+    if (threads.empty())  continue;
+
+    unsigned int sec, nsec;
+    if (! time_left(deadline, sec, nsec))  return;
+    syncpoints_start_hook_[i]->wait_until_waiting(threads, SyncPoint::WAIT_FOR_ALL,
+                                                  sec, nsec);
+  }
+}
+
+
+/** Get time left until a deadline.
+ * @param deadline deadline, system time
+ * @param sec upon return contains the seconds left
+ * @param nsec upon return contains the nanoseconds left in addition to sec,
+ * at least one nanosecond in total such that the time can be used as a
+ * timeout
+ * @return true if the deadline has not passed yet, false otherwise
+ */
+bool
+FawkesMainThread::time_left(const Time &deadline, unsigned int &sec, unsigned int &nsec)
+{
+  Time now;
+  now.stamp_systime();
+  long int usec = deadline.in_usec() - now.in_usec();
+  if (usec <= 0) {
+    sec  = 0;
+    nsec = 1;
+    return false;
+  }
+  sec  = usec / 1000000;
+  nsec = (usec % 1000000) * 1000;
+  return true;
+}
+
+
 /** Get logger.
  * @return logger
  */
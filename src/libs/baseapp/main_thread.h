@@ -54,6 +54,7 @@ class Mutex;
 class ThreadManager;
 class SyncPointManager;
 class FawkesNetworkManager;
+class BlockedTimingGraph;
 
 class FawkesMainThread
 : public Thread,
@@ -98,6 +99,8 @@ class FawkesMainThread
 
  private:
   void destruct();
+  void wait_for_hook_threads();
+  static bool time_left(const Time &deadline, unsigned int &sec, unsigned int &nsec);
 
   inline void safe_wake(BlockedTimingAspect::WakeupHook hook, unsigned int timeout_usec)
   {
@@ -143,6 +146,7 @@ class FawkesMainThread
 
   std::vector<RefPtr<SyncPoint> > syncpoints_start_hook_;
   std::vector<RefPtr<SyncPoint> > syncpoints_end_hook_;
+  BlockedTimingGraph             *bt_graph_;
 
 };
 
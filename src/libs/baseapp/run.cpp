@@ -25,6 +25,7 @@
 #include <baseapp/daemonize.h>
 #include <baseapp/main_thread.h>
 #include <baseapp/thread_manager.h>
+#include <baseapp/thread_loop_times.h>
 
 #include <core/threading/thread.h>
 
@@ -68,6 +69,8 @@
 #include <sys/stat.h>
 #include <pwd.h>
 #include <grp.h>
+#include <cerrno>
+#include <climits>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
@@ -306,6 +309,9 @@ init(const InitOptions& options, int & retval)
   std::string listen_ipv4;
   std::string listen_ipv6;
   unsigned int net_tcp_port     = 1910;
+  unsigned int net_io_threads   = 0;
+  unsigned int net_batch_size   = 16384;
+  unsigned int net_batch_age    = 0;
   std::string  net_service_name = "Fawkes on %h";
   if (options.has_net_tcp_port()) {
     net_tcp_port = options.net_tcp_port();
@@ -323,6 +329,16 @@ init(const InitOptions& options, int & retval)
     } catch (Exception &e) {}  // ignore, we stick with the default
   }
 
+  try {
+    net_io_threads = config->get_uint("/network/fawkes/io_threads");
+  } catch (Exception &e) {}  // ignore, we stick with the default
+  try {
+    net_batch_size = config->get_uint("/network/fawkes/batch_max_size");
+  } catch (Exception &e) {}  // ignore, we stick with the default
+  try {
+    net_batch_age = config->get_uint("/network/fawkes/batch_max_age_usec");
+  } catch (Exception &e) {}  // ignore, we stick with the default
+
   if (net_tcp_port > 65535) {
     logger->log_warn("FawkesMainThread", "Invalid port '%u', using 1910",
 		     net_tcp_port);
@@ -382,12 +398,49 @@ init(const InitOptions& options, int & retval)
     SharedMemoryRegistry::cleanup();
   }
 
+  bool bb_size_classes = false;
+  try {
+    bb_size_classes = config->get_bool("/fawkes/mainapp/blackboard_size_classes");
+  } catch (Exception &e) {} // ignored, use default first-fit allocation
+
   LocalBlackBoard *lbb = NULL;
   if ( bb_magic_token == "") {
-    lbb = new LocalBlackBoard(bb_size);
+    lbb = new LocalBlackBoard(bb_size, bb_size_classes);
   } else {
-    lbb = new LocalBlackBoard(bb_size, bb_magic_token.c_str());
+    lbb = new LocalBlackBoard(bb_size, bb_magic_token.c_str(), true, bb_size_classes);
   }
+  try {
+    std::vector<std::string> bb_history =
+      config->get_strings("/fawkes/mainapp/blackboard_history");
+    for (const std::string &h : bb_history) {
+      // entries are of the form Type::ID=slots, type and ID may be patterns
+      std::string::size_type eq_pos = h.rfind('=');
+      std::string::size_type sep_pos = h.find("::");
+      if (eq_pos == std::string::npos || sep_pos == std::string::npos || sep_pos > eq_pos) {
+	logger->log_warn("FawkesMainApp", "Invalid BlackBoard history entry '%s', "
+			 "must be Type::ID=slots", h.c_str());
+	continue;
+      }
+      std::string type_pattern = h.substr(0, sep_pos);
+      std::string id_pattern   = h.substr(sep_pos + 2, eq_pos - sep_pos - 2);
+      std::string slots_str = h.substr(eq_pos + 1);
+      errno = 0;
+      unsigned long slots = strtoul(slots_str.c_str(), NULL, 10);
+      if (slots_str.empty() || slots_str.find_first_not_of("0123456789") != std::string::npos ||
+	  errno == ERANGE || slots > UINT_MAX)
+      {
+	logger->log_warn("FawkesMainApp", "Invalid number of slots in BlackBoard history "
+			 "entry '%s', must be Type::ID=slots", h.c_str());
+	continue;
+      }
+      lbb->set_history_size(type_pattern.c_str(), id_pattern.c_str(), slots);
+    }
+  } catch (Exception &e) {} // ignored, no history configured
+  try {
+    unsigned int bb_notifier_workers =
+      config->get_uint("/fawkes/mainapp/blackboard_notifier_workers");
+    lbb->set_async_notification(bb_notifier_workers);
+  } catch (Exception &e) {} // ignored, notify synchronously
   blackboard = lbb;
 #endif
 
@@ -399,6 +452,21 @@ init(const InitOptions& options, int & retval)
   aspect_manager     = new AspectManager();
   thread_manager     = new ThreadManager(aspect_manager, aspect_manager);
 
+  try {
+    if (config->get_bool("/fawkes/mainapp/loop_time_stats/enable")) {
+      thread_manager->loop_times()->set_enabled(true);
+#ifdef HAVE_BLACKBOARD
+      float publish_interval = 1.0;
+      try {
+	publish_interval =
+	  config->get_float("/fawkes/mainapp/loop_time_stats/publish_interval");
+      } catch (Exception &e) {} // ignored, use default
+      thread_manager->loop_times()->set_blackboard(blackboard, logger,
+						   publish_interval);
+#endif
+    }
+  } catch (Exception &e) {} // ignored, loop time stats disabled
+
   syncpoint_manager  = new SyncPointManager(logger);
 
   plugin_manager     = new PluginManager(thread_manager, config,
@@ -410,7 +478,9 @@ init(const InitOptions& options, int & retval)
                                                 enable_ipv4, enable_ipv6,
                                                 listen_ipv4, listen_ipv6,
                                                 net_tcp_port,
-                                                net_service_name.c_str());
+                                                net_service_name.c_str(),
+                                                net_io_threads);
+  network_manager->set_batching(net_batch_size, net_batch_age);
 #  ifdef HAVE_CONFIG_NETWORK_HANDLER
   nethandler_config  = new ConfigNetworkHandler(config,
                                                 network_manager->hub());
@@ -496,6 +566,14 @@ cleanup()
 #ifdef HAVE_PLUGIN_NETWORK_HANDLER
   delete nethandler_plugin;
 #endif
+  if (thread_manager) {
+    try {
+      if (config->get_bool("/fawkes/mainapp/loop_time_stats/dump_on_shutdown")) {
+	thread_manager->loop_times()->log(logger);
+      }
+    } catch (Exception &e) {} // ignored, do not dump
+    thread_manager->loop_times()->set_blackboard(NULL, NULL, 0);
+  }
   delete plugin_manager;
   delete main_thread;
 #ifdef HAVE_TF
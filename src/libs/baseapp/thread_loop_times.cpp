@@ -0,0 +1,370 @@
+
+/***************************************************************************
+ *  thread_loop_times.cpp - Loop time statistics of timed threads
+ *
+ *  Created: Sat Oct 17 10:02:31 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <baseapp/thread_loop_times.h>
+#include <core/threading/thread.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <logging/logger.h>
+
+#ifdef HAVE_BLACKBOARD
+#  include <blackboard/blackboard.h>
+#  include <interfaces/ThreadLoopTimeInterface.h>
+#endif
+
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+
+namespace fawkes {
+
+static inline int64_t
+monotonic_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#ifdef HAVE_BLACKBOARD
+/** Get blackboard interface ID for a thread.
+ * Names which are too long are truncated and get a hash of the full name
+ * appended, threads whose names only differ after the cut do not share
+ * an interface.
+ * @param name thread name
+ * @return interface ID
+ */
+static std::string
+interface_id(const std::string &name)
+{
+  if (name.size() < INTERFACE_ID_SIZE_)  return name;
+
+  // 32 bit FNV-1a, stable across runs
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < name.size(); ++i) {
+    hash = (hash ^ (unsigned char)name[i]) * 16777619U;
+  }
+  char suffix[10];
+  snprintf(suffix, sizeof(suffix), "#%08x", hash);
+  return name.substr(0, INTERFACE_ID_SIZE_ - 1 - strlen(suffix)) + suffix;
+}
+#endif
+
+
+/** @class ThreadLoopTimes <baseapp/thread_loop_times.h>
+ * Loop time statistics of timed threads.
+ * For every thread with the BlockedTimingAspect a loop listener records
+ * the duration of loop() and the wakeup latency, that is the time from
+ * waking up the hook of the thread until its loop() starts, into
+ * histograms. The latency includes the time the thread waited for its
+ * predecessors if threads are woken up by dependencies.
+ *
+ * The statistics can be queried, logged, and published periodically to
+ * the blackboard with one ThreadLoopTimeInterface per thread. Its ID is
+ * the thread name, long names are shortened and get a hash of the full
+ * name appended.
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+ThreadLoopTimes::ThreadLoopTimes()
+{
+  mutex_   = new Mutex();
+  enabled_ = false;
+  memset(wakeup_ns_, 0, sizeof(wakeup_ns_));
+
+  blackboard_          = NULL;
+  logger_              = NULL;
+  publish_interval_ns_ = 0;
+  last_publish_ns_     = 0;
+}
+
+
+/** Destructor.
+ * Threads which are still registered must not run anymore, they are not
+ * touched. Call set_blackboard() with NULL before the blackboard is
+ * destroyed.
+ */
+ThreadLoopTimes::~ThreadLoopTimes()
+{
+  std::map<Thread *, Entry>::iterator e;
+  for (e = entries_.begin(); e != entries_.end(); ++e) {
+    delete e->second.timer;
+  }
+  delete mutex_;
+}
+
+
+/** Enable or disable recording.
+ * Only affects threads added afterwards.
+ * @param enabled true to record loop times of new threads
+ */
+void
+ThreadLoopTimes::set_enabled(bool enabled)
+{
+  enabled_ = enabled;
+}
+
+
+/** Check if recording is enabled.
+ * @return true if enabled, false otherwise
+ */
+bool
+ThreadLoopTimes::enabled() const
+{
+  return enabled_;
+}
+
+
+/** Add thread.
+ * Does nothing if disabled.
+ * @param thread thread to record loop times for
+ * @param hook wakeup hook of the thread
+ */
+void
+ThreadLoopTimes::add(Thread *thread, BlockedTimingAspect::WakeupHook hook)
+{
+  if (! enabled_)  return;
+
+  MutexLocker lock(mutex_);
+  if (entries_.find(thread) != entries_.end())  return;
+
+  Entry &e = entries_[thread];
+  e.name  = thread->name();
+  e.hook  = hook;
+  e.timer = new Timer(&wakeup_ns_[hook]);
+  e.iface = NULL;
+  e.iface_failed = false;
+  thread->add_loop_listener(e.timer);
+}
+
+
+/** Remove thread.
+ * The thread must not run its loop while it is removed.
+ * @param thread thread to remove
+ */
+void
+ThreadLoopTimes::remove(Thread *thread)
+{
+  MutexLocker lock(mutex_);
+  std::map<Thread *, Entry>::iterator e = entries_.find(thread);
+  if (e == entries_.end())  return;
+
+  close_interface(e->second);
+  thread->remove_loop_listener(e->second.timer);
+  delete e->second.timer;
+  entries_.erase(e);
+}
+
+
+/** Note wakeup of a hook.
+ * Call this right before waking up the threads of a hook.
+ * @param hook hook which is woken up
+ */
+void
+ThreadLoopTimes::wakeup(BlockedTimingAspect::WakeupHook hook)
+{
+  __atomic_store_n(&wakeup_ns_[hook], monotonic_ns(), __ATOMIC_RELEASE);
+}
+
+
+/** Get statistics.
+ * @return statistics of all threads
+ */
+std::list<ThreadLoopTimes::Stats>
+ThreadLoopTimes::stats()
+{
+  MutexLocker lock(mutex_);
+  std::list<Stats> rv;
+  std::map<Thread *, Entry>::iterator e;
+  for (e = entries_.begin(); e != entries_.end(); ++e) {
+    rv.push_back(make_stats(e->second));
+  }
+  return rv;
+}
+
+
+/** Log statistics.
+ * Logs one line per thread.
+ * @param logger logger to log to
+ */
+void
+ThreadLoopTimes::log(Logger *logger)
+{
+  std::list<Stats> s = stats();
+  for (std::list<Stats>::iterator i = s.begin(); i != s.end(); ++i) {
+    logger->log_info("ThreadLoopTimes",
+		     "%s (%s): %llu loops, loop mean %.0f p50 %.0f p90 %.0f p99 %.0f "
+		     "max %.0f usec, latency mean %.0f p50 %.0f p99 %.0f max %.0f usec",
+		     i->thread.c_str(),
+		     BlockedTimingAspect::blocked_timing_hook_to_string(i->hook),
+		     (unsigned long long)i->loops, i->loop_mean, i->loop_p50,
+		     i->loop_p90, i->loop_p99, i->loop_max, i->latency_mean,
+		     i->latency_p50, i->latency_p99, i->latency_max);
+  }
+}
+
+
+/** Set blackboard to publish to.
+ * @param blackboard blackboard to open the interfaces on, NULL to stop
+ * publishing
+ * @param logger logger for errors when opening interfaces
+ * @param interval_sec minimum time between two updates in seconds
+ */
+void
+ThreadLoopTimes::set_blackboard(BlackBoard *blackboard, Logger *logger,
+				float interval_sec)
+{
+  MutexLocker lock(mutex_);
+  std::map<Thread *, Entry>::iterator e;
+  for (e = entries_.begin(); e != entries_.end(); ++e) {
+    close_interface(e->second);
+    e->second.iface_failed = false;
+  }
+
+#ifdef HAVE_BLACKBOARD
+  blackboard_ = blackboard;
+#else
+  blackboard_ = NULL;
+#endif
+  logger_ = logger;
+  publish_interval_ns_ = (int64_t)(interval_sec * 1e9);
+  last_publish_ns_ = 0;
+}
+
+
+/** Publish statistics to blackboard.
+ * Does nothing if no blackboard is set or if the publish interval has not
+ * elapsed since the last update. Interfaces of new threads are opened on
+ * the first update.
+ */
+void
+ThreadLoopTimes::publish()
+{
+#ifdef HAVE_BLACKBOARD
+  if (! blackboard_)  return;
+
+  int64_t now = monotonic_ns();
+  if (now - last_publish_ns_ < publish_interval_ns_)  return;
+  last_publish_ns_ = now;
+
+  MutexLocker lock(mutex_);
+  std::map<Thread *, Entry>::iterator e;
+  for (e = entries_.begin(); e != entries_.end(); ++e) {
+    if (e->second.iface_failed)  continue;
+    if (! e->second.iface) {
+      std::string id = interface_id(e->second.name);
+      try {
+	e->second.iface =
+	  blackboard_->open_for_writing<ThreadLoopTimeInterface>(id.c_str());
+      } catch (Exception &ex) {
+	if (logger_) {
+	  logger_->log_warn("ThreadLoopTimes", "Cannot publish loop times of %s",
+			    e->second.name.c_str());
+	  logger_->log_warn("ThreadLoopTimes", ex);
+	}
+	// do not try again
+	e->second.iface_failed = true;
+	continue;
+      }
+    }
+
+    Stats s = make_stats(e->second);
+    ThreadLoopTimeInterface *i = e->second.iface;
+    i->set_thread(s.thread.c_str());
+    i->set_hook(BlockedTimingAspect::blocked_timing_hook_to_string(s.hook));
+    i->set_loops(s.loops);
+    i->set_loop_mean(s.loop_mean);
+    i->set_loop_p50(s.loop_p50);
+    i->set_loop_p90(s.loop_p90);
+    i->set_loop_p99(s.loop_p99);
+    i->set_loop_max(s.loop_max);
+    i->set_latency_mean(s.latency_mean);
+    i->set_latency_p50(s.latency_p50);
+    i->set_latency_p99(s.latency_p99);
+    i->set_latency_max(s.latency_max);
+    i->write();
+  }
+#endif
+}
+
+
+ThreadLoopTimes::Stats
+ThreadLoopTimes::make_stats(const Entry &e)
+{
+  Stats s;
+  s.thread       = e.name;
+  s.hook         = e.hook;
+  s.loops        = e.timer->loop.count();
+  s.loop_mean    = e.timer->loop.mean() / 1000.;
+  s.loop_p50     = e.timer->loop.percentile(50.) / 1000.;
+  s.loop_p90     = e.timer->loop.percentile(90.) / 1000.;
+  s.loop_p99     = e.timer->loop.percentile(99.) / 1000.;
+  s.loop_max     = e.timer->loop.max() / 1000.;
+  s.latency_mean = e.timer->latency.mean() / 1000.;
+  s.latency_p50  = e.timer->latency.percentile(50.) / 1000.;
+  s.latency_p99  = e.timer->latency.percentile(99.) / 1000.;
+  s.latency_max  = e.timer->latency.max() / 1000.;
+  return s;
+}
+
+
+void
+ThreadLoopTimes::close_interface(Entry &e)
+{
+#ifdef HAVE_BLACKBOARD
+  if (e.iface && blackboard_) {
+    blackboard_->close(e.iface);
+  }
+#endif
+  e.iface = NULL;
+}
+
+
+/// @cond INTERNALS
+ThreadLoopTimes::Timer::Timer(const int64_t *wakeup_ns)
+  : wakeup_ns_(wakeup_ns)
+{
+  start_ns_ = monotonic_ns();
+}
+
+
+void
+ThreadLoopTimes::Timer::pre_loop(Thread *thread)
+{
+  int64_t now = monotonic_ns();
+  int64_t wakeup = __atomic_load_n(wakeup_ns_, __ATOMIC_ACQUIRE);
+  // without a new wakeup the thread was not woken up through its hook
+  if (wakeup > start_ns_)  latency.record(now - wakeup);
+  start_ns_ = now;
+}
+
+
+void
+ThreadLoopTimes::Timer::post_loop(Thread *thread)
+{
+  loop.record(monotonic_ns() - start_ns_);
+}
+/// @endcond
+
+} // end namespace fawkes
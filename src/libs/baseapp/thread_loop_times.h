@@ -0,0 +1,125 @@
+
+/***************************************************************************
+ *  thread_loop_times.h - Loop time statistics of timed threads
+ *
+ *  Created: Sat Oct 17 10:02:31 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _LIBS_BASEAPP_THREAD_LOOP_TIMES_H_
+#define _LIBS_BASEAPP_THREAD_LOOP_TIMES_H_
+
+#include <aspect/blocked_timing.h>
+#include <core/threading/thread_loop_listener.h>
+#include <utils/time/histogram.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+
+namespace fawkes {
+
+class Thread;
+class Mutex;
+class Logger;
+class BlackBoard;
+class ThreadLoopTimeInterface;
+
+class ThreadLoopTimes
+{
+ public:
+  /** Loop time statistics of a thread. All times are in microseconds. */
+  typedef struct {
+    std::string                      thread;		///< thread name
+    BlockedTimingAspect::WakeupHook  hook;		///< wakeup hook
+    uint64_t                         loops;		///< number of loops
+    float                            loop_mean;		///< mean loop time
+    float                            loop_p50;		///< median loop time
+    float                            loop_p90;		///< 90th percentile loop time
+    float                            loop_p99;		///< 99th percentile loop time
+    float                            loop_max;		///< maximum loop time
+    float                            latency_mean;	///< mean wakeup latency
+    float                            latency_p50;	///< median wakeup latency
+    float                            latency_p99;	///< 99th percentile wakeup latency
+    float                            latency_max;	///< maximum wakeup latency
+  } Stats;
+
+  ThreadLoopTimes();
+  ~ThreadLoopTimes();
+
+  void set_enabled(bool enabled);
+  bool enabled() const;
+
+  void add(Thread *thread, BlockedTimingAspect::WakeupHook hook);
+  void remove(Thread *thread);
+
+  void wakeup(BlockedTimingAspect::WakeupHook hook);
+
+  std::list<Stats> stats();
+  void             log(Logger *logger);
+
+  void set_blackboard(BlackBoard *blackboard, Logger *logger, float interval_sec);
+  void publish();
+
+ private:
+  /// @cond INTERNALS
+  class Timer : public ThreadLoopListener
+  {
+   public:
+    Timer(const int64_t *wakeup_ns);
+
+    virtual void pre_loop(Thread *thread);
+    virtual void post_loop(Thread *thread);
+
+    TimeHistogram  loop;
+    TimeHistogram  latency;
+
+   private:
+    const int64_t *wakeup_ns_;
+    int64_t        start_ns_;
+  };
+
+  struct Entry {
+    std::string                      name;
+    BlockedTimingAspect::WakeupHook  hook;
+    Timer                           *timer;
+    ThreadLoopTimeInterface         *iface;
+    bool                             iface_failed;
+  };
+  /// @endcond
+
+  static Stats make_stats(const Entry &e);
+  void close_interface(Entry &e);
+
+ private:
+  Mutex     *mutex_;
+  bool       enabled_;
+  int64_t    wakeup_ns_[BlockedTimingAspect::WAKEUP_HOOK_POST_LOOP + 1];
+
+  std::map<Thread *, Entry>  entries_;
+
+  BlackBoard *blackboard_;
+  Logger     *logger_;
+  int64_t     publish_interval_ns_;
+  int64_t     last_publish_ns_;
+};
+
+} // end namespace fawkes
+
+#endif
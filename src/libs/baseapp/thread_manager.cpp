@@ -31,6 +31,8 @@
 #include <core/exceptions/system.h>
 
 #include <aspect/blocked_timing.h>
+#include <aspect/blocked_timing/graph.h>
+#include <baseapp/thread_loop_times.h>
 
 namespace fawkes {
 
@@ -42,6 +44,9 @@ namespace fawkes {
  * can be used for "garbage collection" of threads.
  *
  * The thread manager allows easy wakeup of threads of a given wakeup hook.
+ * All threads with the BlockedTimingAspect are also added to a dependency
+ * graph, which can be enabled to run independent threads of different
+ * hooks concurrently, see blocked_timing_graph().
  *
  * The thread manager needs a thread initializer. Each thread that is added
  * to the thread manager is initialized with this. The runtime type information
@@ -141,6 +146,8 @@ ThreadManager::ThreadManager()
   waitcond_timedthreads_ = new WaitCondition();
   interrupt_timed_thread_wait_ = false;
   aspect_collector_ = new ThreadManagerAspectCollector(this);
+  bt_graph_ = new BlockedTimingGraph();
+  loop_times_ = new ThreadLoopTimes();
 }
 
 /** Constructor.
@@ -158,6 +165,8 @@ ThreadManager::ThreadManager(ThreadInitializer *initializer,
   waitcond_timedthreads_ = new WaitCondition();
   interrupt_timed_thread_wait_ = false;
   aspect_collector_ = new ThreadManagerAspectCollector(this);
+  bt_graph_ = new BlockedTimingGraph();
+  loop_times_ = new ThreadLoopTimes();
   set_inifin(initializer, finalizer);
 }
 
@@ -165,6 +174,8 @@ ThreadManager::ThreadManager(ThreadInitializer *initializer,
 /** Destructor. */
 ThreadManager::~ThreadManager()
 {
+  bt_graph_->set_enabled(false);
+
   // stop all threads, we call finalize, and we run through it as long as there are
   // still running threads, after that, we force the thread's death.
   for (tit_ = threads_.begin(); tit_ != threads_.end(); ++tit_) {
@@ -179,6 +190,8 @@ ThreadManager::~ThreadManager()
 
   delete waitcond_timedthreads_;
   delete aspect_collector_;
+  delete bt_graph_;
+  delete loop_times_;
 }
 
 
@@ -214,6 +227,8 @@ ThreadManager::internal_remove_thread(Thread *t)
       threads_[hook].remove_locked(t);
       if (threads_[hook].empty())  threads_.erase(hook);
     }
+    bt_graph_->remove(t);
+    loop_times_->remove(t);
   } else {
     untimed_threads_.remove_locked(t);
   }
@@ -239,6 +254,8 @@ ThreadManager::internal_add_thread(Thread *t)
       threads_[hook].set_maintain_barrier(true);
     }
     threads_[hook].push_back_locked(t);
+    bt_graph_->add(t);
+    loop_times_->add(t, hook);
 
     waitcond_timedthreads_->wake_all();
   } else {
@@ -562,6 +579,7 @@ ThreadManager::wakeup_and_wait(BlockedTimingAspect::WakeupHook hook,
 
   // Note that the following lines might throw an exception, we just pass it on
   if ( threads_.find(hook) != threads_.end() ) {
+    loop_times_->wakeup(hook);
     threads_[hook].wakeup_and_wait(timeout_sec, timeout_usec * 1000);
   }
 }
@@ -573,6 +591,7 @@ ThreadManager::wakeup(BlockedTimingAspect::WakeupHook hook, Barrier *barrier)
   MutexLocker lock(threads_.mutex());
 
   if ( threads_.find(hook) != threads_.end() ) {
+    loop_times_->wakeup(hook);
     if ( barrier ) {
       threads_[hook].wakeup(barrier);
     } else {
@@ -632,4 +651,28 @@ ThreadManager::aspect_collector() const
   return aspect_collector_;
 }
 
+
+/** Get dependency graph of timed threads.
+ * The graph contains all threads with the BlockedTimingAspect. It is
+ * disabled by default, enable it only if all hooks are woken up at once.
+ * @return dependency graph
+ */
+BlockedTimingGraph *
+ThreadManager::blocked_timing_graph() const
+{
+  return bt_graph_;
+}
+
+
+/** Get loop time statistics of timed threads.
+ * Recording is disabled by default, it must be enabled before the threads
+ * to record are added.
+ * @return loop time statistics
+ */
+ThreadLoopTimes *
+ThreadManager::loop_times() const
+{
+  return loop_times_;
+}
+
 } // end namespace fawkes
@@ -38,6 +38,8 @@ class Mutex;
 class WaitCondition;
 class ThreadInitializer;
 class ThreadFinalizer;
+class BlockedTimingGraph;
+class ThreadLoopTimes;
 
 class ThreadManager
 : public ThreadCollector,
@@ -84,7 +86,9 @@ class ThreadManager
   virtual void wait_for_timed_threads();
   virtual void interrupt_timed_thread_wait();
 
-  ThreadCollector *  aspect_collector() const;
+  ThreadCollector *     aspect_collector() const;
+  BlockedTimingGraph *  blocked_timing_graph() const;
+  ThreadLoopTimes *     loop_times() const;
 
  private:
   void internal_add_thread(Thread *t);
@@ -125,6 +129,9 @@ class ThreadManager
   ThreadManagerAspectCollector *aspect_collector_;
   bool interrupt_timed_thread_wait_;
 
+  BlockedTimingGraph *bt_graph_;
+  ThreadLoopTimes    *loop_times_;
+
 };
 
 } // end namespace fawkes
@@ -63,6 +63,20 @@ class BlackBoardInterfaceListener
   /** Map of currently active event subscriptions. */
  typedef std::map<std::string, Interface *> InterfaceMap;
 
+ /** Statistics of asynchronous data change dispatch.
+  * Only collected if the notifier runs in asynchronous mode. Latencies
+  * are measured from the data change to the end of the callback. */
+ typedef struct {
+   unsigned long int num_events;	///< data change events for this listener
+   unsigned long int num_coalesced;	///< events merged into a pending event
+   unsigned long int num_dispatched;	///< callbacks invoked
+   unsigned int      backlog;		///< number of currently pending interfaces
+   unsigned int      max_backlog;	///< maximum number of pending interfaces
+   unsigned long int latency_total_usec;///< sum of latencies of all callbacks
+   unsigned long int latency_max_usec;	///< maximum latency of a single callback
+   unsigned long int runtime_total_usec;///< total time spent in callbacks
+ } DispatchStats;
+
  /** Structure to hold maps for active subscriptions. */
  typedef struct {
    InterfaceMap  data;		///< Data event subscriptions
@@ -44,6 +44,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <fnmatch.h>
 
 namespace fawkes {
@@ -53,10 +54,19 @@ namespace fawkes {
  * This class is used by the BlackBoard to manage interfaces stored in the
  * shared memory.
  *
+ * Interfaces are kept in a directory which is split into BBIM_NUM_SHARDS
+ * shards by the hash of the interface UID (type::id). Opening and closing
+ * only locks the shard of the respective interface, therefore unrelated
+ * interfaces can be opened concurrently, e.g. while plugins are loaded.
+ * The directory and the serials are kept by the master process, which is
+ * the only one which may open interfaces. Slave processes attached to a
+ * shared memory BlackBoard list the interfaces from the memory chunks.
+ *
  * @author Tim Niemueller
  */
 
 
+
 /** Constructor.
  * The shared memory segment is created with data from bbconfig.h.
  * @param bb_memmgr BlackBoard memory manager to use
@@ -76,14 +86,32 @@ BlackBoardInterfaceManager::BlackBoardInterfaceManager(BlackBoardMemoryManager *
   instance_factory = new BlackBoardInstanceFactory();
   mutex = new Mutex();
 
+  for (unsigned int i = 0; i < BBIM_NUM_SHARDS; ++i) {
+    shards_[i].mutex = new Mutex();
+  }
+
+  // continue after the highest serial already in memory
+  mem_serial_ = 1;
+  memmgr->lock();
+  BlackBoardMemoryManager::ChunkIterator cit;
+  for ( cit = memmgr->begin(); cit != memmgr->end(); ++cit ) {
+    interface_header_t *ih = (interface_header_t *)*cit;
+    if ( ih->serial >= mem_serial_ ) {
+      mem_serial_ = ih->serial + 1;
+    }
+  }
+  memmgr->unlock();
+
   writer_interfaces.clear();
-  rwlocks.clear();
 }
 
 
 /** Destructor */
 BlackBoardInterfaceManager::~BlackBoardInterfaceManager()
 {
+  for (unsigned int i = 0; i < BBIM_NUM_SHARDS; ++i) {
+    delete shards_[i].mutex;
+  }
   delete mutex;
   delete instance_factory;
 }
@@ -107,6 +135,8 @@ BlackBoardInterfaceManager::new_interface_instance(const char *type, const char
   iface->set_instance_serial(next_instance_serial());
   iface->set_mediators(this, msgmgr);
   if (owner) iface->set_owner(owner);
+  // messages are appended by any sending thread and consumed by the writer
+  iface->message_queue_->set_mpsc(true);
   return iface;
 }
 
@@ -121,6 +151,7 @@ BlackBoardInterfaceManager::new_interface_instance(const char *type, const char
 void
 BlackBoardInterfaceManager::delete_interface_instance(Interface *interface)
 {
+  owner_info_.lock();
   if (owner_info_.find(interface->uid()) != owner_info_.end()) {
     OwnerInfo &info = owner_info_[interface->uid()];
     if (interface->is_writer()) {
@@ -131,31 +162,84 @@ BlackBoardInterfaceManager::delete_interface_instance(Interface *interface)
       info.readers.remove(interface);
     }
   }
+  owner_info_.unlock();
   instance_factory->delete_interface_instance(interface);
 }
 
 
-/** search memory chunks if the desired interface has been allocated already.
- * @param type type of the interface to look for
- * @param identifier identifier of the interface to look for
- * @return a pointer to the memory of the interface or NULL if not found
+/** Get directory shard for an interface.
+ * @param uid unique ID of the interface, i.e. type::id
+ * @return shard responsible for the given interface
  */
-void *
-BlackBoardInterfaceManager::find_interface_in_memory(const char *type, const char *identifier)
+BlackBoardInterfaceManager::DirectoryShard &
+BlackBoardInterfaceManager::shard_for(const std::string &uid)
 {
-  interface_header_t *ih;
-  BlackBoardMemoryManager::ChunkIterator cit;
-  for ( cit = memmgr->begin(); cit != memmgr->end(); ++cit ) {
-    ih = (interface_header_t *)*cit;
-    if ( (strncmp(ih->type, type, INTERFACE_TYPE_SIZE_) == 0) &&
-	 (strncmp(ih->id, identifier, INTERFACE_ID_SIZE_) == 0)
-	 ) {
-      // found it!
-      return *cit;
+  return shards_[std::hash<std::string>()(uid) % BBIM_NUM_SHARDS];
+}
+
+
+/** Assign shared memory chunk to interface.
+ * @param interface interface to assign memory to
+ * @param ptr pointer to the memory chunk, starting with the interface header
+ */
+void
+BlackBoardInterfaceManager::set_interface_memory(Interface *interface, void *ptr)
+{
+  interface_header_t *ih = (interface_header_t *)ptr;
+  char *data = (char *)ptr + sizeof(interface_header_t);
+
+  interface->set_memory(ih->serial, ptr, data, &ih->data_version);
+  interface->set_history(&ih->sequence,
+			 (ih->history_slots > 0) ? data + interface->history_offset() : NULL,
+			 ih->history_slots);
+}
+
+
+/** Get number of history slots for an interface.
+ * @param type type of the interface
+ * @param identifier identifier of the interface
+ * @return number of history slots configured for the interface, the
+ * first matching pattern set with set_history_size() wins
+ */
+unsigned int
+BlackBoardInterfaceManager::history_size_for(const char *type, const char *identifier)
+{
+  MutexLocker lock(mutex);
+  std::list<HistoryConfig>::iterator h;
+  for (h = history_config_.begin(); h != history_config_.end(); ++h) {
+    if ((fnmatch(h->type_pattern.c_str(), type, 0) != FNM_NOMATCH) &&
+	(fnmatch(h->id_pattern.c_str(), identifier, 0) != FNM_NOMATCH))
+    {
+      return h->slots;
     }
   }
+  return 0;
+}
+
 
-  return NULL;
+/** Set size of interface history.
+ * Configure the number of past states kept in shared memory for the
+ * interfaces matching the given patterns. This only affects interfaces
+ * which are created after the call, i.e. which currently have neither
+ * a reader nor a writer. Patterns are evaluated in the order they have
+ * been added.
+ * @param type_pattern pattern of interface types, supports wildcards
+ * similar to filenames (*, ?, []), see "man fnmatch" for all supported.
+ * @param id_pattern pattern of interface IDs, supports wildcards similar
+ * to filenames (*, ?, []), see "man fnmatch" for all supported.
+ * @param slots number of states to keep, 0 to disable the history
+ */
+void
+BlackBoardInterfaceManager::set_history_size(const char *type_pattern,
+					     const char *id_pattern,
+					     unsigned int slots)
+{
+  MutexLocker lock(mutex);
+  HistoryConfig h;
+  h.type_pattern = type_pattern;
+  h.id_pattern   = id_pattern;
+  h.slots        = slots;
+  history_config_.push_back(h);
 }
 
 
@@ -165,17 +249,7 @@ BlackBoardInterfaceManager::find_interface_in_memory(const char *type, const cha
 unsigned int
 BlackBoardInterfaceManager::next_mem_serial()
 {
-  unsigned int serial = 1;
-  interface_header_t *ih;
-  BlackBoardMemoryManager::ChunkIterator cit;
-  for ( cit = memmgr->begin(); cit != memmgr->end(); ++cit ) {
-    ih = (interface_header_t *)*cit;
-    if ( ih->serial >= serial ) {
-      serial = ih->serial + 1;
-    }
-  }
-
-  return serial;
+  return __atomic_fetch_add(&mem_serial_, 1, __ATOMIC_RELAXED);
 }
 
 
@@ -187,7 +261,7 @@ BlackBoardInterfaceManager::next_instance_serial()
 {
   if ( memmgr->is_master() ) {
     // simple, just increment value and return it
-    return instance_serial++;
+    return __atomic_fetch_add(&instance_serial, 1, __ATOMIC_RELAXED);
   } else {
     throw BBNotMasterException("Instance serial can only be requested by BB Master");
   }
@@ -196,33 +270,50 @@ BlackBoardInterfaceManager::next_instance_serial()
 
 /** Create an interface instance.
  * This will create a new interface instance. Storage in the shared memory
- * is allocated to hold the interface data.
+ * is allocated to hold the interface data. The caller must hold the lock
+ * of the directory shard the interface belongs to and add the entry to it.
  * @param type type of the interface
  * @param identifier identifier of the interface
+ * @param owner owner of the new interface instance
  * @param interface reference to a pointer where the interface will be created
- * @param ptr reference to pointer of interface memory
+ * @param entry upon return contains memory chunk and read/write lock
  * @exception OutOfMemoryException thrown if there is not enough memory in the
  * BlackBoard to create the interface
  */
 void
 BlackBoardInterfaceManager::create_interface(const char *type, const char *identifier,
 					     const char *owner,
-					     Interface* &interface, void* &ptr)
+					     Interface* &interface, DirectoryEntry &entry)
 {
   interface_header_t *ih;
 
   // create new interface and allocate appropriate chunk
   interface = new_interface_instance(type, identifier, owner);
+  unsigned int history_slots = history_size_for(type, identifier);
+  size_t chunk_size = sizeof(interface_header_t);
+  if (history_slots > 0) {
+    chunk_size += interface->history_offset()
+      + history_slots * interface->history_slot_size();
+  } else {
+    chunk_size += interface->datasize();
+  }
+  // Keep the size a multiple of the alignment of the 64 bit fields in
+  // the header and history, the memory manager places chunks back to
+  // back, so this keeps the following chunks aligned as well.
+  chunk_size = (chunk_size + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+  // keep the memory locked until the header is initialized, slaves
+  // listing the interfaces read it directly from the memory chunks
+  void *ptr;
+  memmgr->lock();
   try {
-    ptr = memmgr->alloc_nolock(interface->datasize() + sizeof(interface_header_t));
+    ptr = memmgr->alloc_nolock(chunk_size);
     ih  = (interface_header_t *)ptr;
   } catch (OutOfMemoryException &e) {
-    e.append("BlackBoardInterfaceManager::createInterface: interface of type %s could not be created", type);
     memmgr->unlock();
-    mutex->unlock();
+    e.append("BlackBoardInterfaceManager::createInterface: interface of type %s could not be created", type);
     throw;
   }
-  memset(ptr, 0, interface->datasize() + sizeof(interface_header_t));
+  memset(ptr, 0, chunk_size);
 
   strncpy(ih->type, type, INTERFACE_TYPE_SIZE_-1);
   strncpy(ih->id, identifier, INTERFACE_ID_SIZE_-1);
@@ -232,9 +323,15 @@ BlackBoardInterfaceManager::create_interface(const char *type, const char *ident
   ih->serial             = next_mem_serial();
   ih->flag_writer_active = 0;
   ih->num_readers        = 0;
-  rwlocks[ih->serial] = new RefCountRWLock();
+  ih->data_version       = 0;
+  ih->history_slots      = history_slots;
+  ih->sequence           = 0;
+  memmgr->unlock();
+
+  entry.ptr    = ptr;
+  entry.rwlock = new RefCountRWLock();
 
-  interface->set_memory(ih->serial, ptr, (char *)ptr + sizeof(interface_header_t));
+  set_interface_memory(interface, ptr);
 }
 
 
@@ -248,6 +345,7 @@ BlackBoardInterfaceManager::create_interface(const char *type, const char *ident
  * @return new fully initialized interface instance of requested type
  * @exception OutOfMemoryException thrown if there is not enough free space for
  * the requested interface.
+ * @exception BBNotMasterException thrown if called on a slave
  */
 Interface *
 BlackBoardInterfaceManager::open_for_reading(const char *type, const char *identifier, const char *owner)
@@ -261,40 +359,47 @@ BlackBoardInterfaceManager::open_for_reading(const char *type, const char *ident
 		    type, INTERFACE_ID_SIZE_);
   }
 
-  mutex->lock();
+  if ( ! memmgr->is_master() ) {
+    throw BBNotMasterException("Interfaces can only be opened by the BlackBoard master");
+  }
+
+  std::string uid = std::string(type) + "::" + identifier;
+  DirectoryShard &shard = shard_for(uid);
+
+  shard.mutex->lock();
   Interface *iface = NULL;
-  void *ptr = NULL;
   interface_header_t *ih;
   bool created = false;
 
-  memmgr->lock();
-
-  ptr = find_interface_in_memory(type, identifier);
-
   try {
-    if ( ptr != NULL ) {
+    std::map<std::string, DirectoryEntry>::iterator e = shard.entries.find(uid);
+    DirectoryEntry entry;
+    if ( e != shard.entries.end() ) {
       // found, instantiate new interface for given memory chunk
+      entry = e->second;
       iface = new_interface_instance(type, identifier, owner);
-      ih  = (interface_header_t *)ptr;
+      ih  = (interface_header_t *)entry.ptr;
       if ( (iface->hash_size() != INTERFACE_HASH_SIZE_ ) ||
 	   (memcmp(iface->hash(), ih->hash, INTERFACE_HASH_SIZE_) != 0) ) {
 	throw BlackBoardInterfaceVersionMismatchException();
       }
-      iface->set_memory(ih->serial, ptr, (char *)ptr + sizeof(interface_header_t));
-      rwlocks[ih->serial]->ref();
+      set_interface_memory(iface, entry.ptr);
+      entry.rwlock->ref();
     } else {
       created = true;
-      create_interface(type, identifier, owner, iface, ptr);
-      ih  = (interface_header_t *)ptr;
+      create_interface(type, identifier, owner, iface, entry);
+      ih  = (interface_header_t *)entry.ptr;
+      shard.entries[uid] = entry;
     }
 
-    owner_info_[iface->uid()].readers.push_back(iface);
-    iface->set_readwrite(false, rwlocks[ih->serial]);
+    owner_info_.lock();
+    owner_info_[uid].readers.push_back(iface);
+    owner_info_.unlock();
+    iface->set_readwrite(false, entry.rwlock);
     ih->refcount++;
     ih->num_readers++;
 
-    memmgr->unlock();
-    mutex->unlock();
+    shard.mutex->unlock();
 
     if ( created ) {
       notifier->notify_of_interface_created(type, identifier);
@@ -303,8 +408,7 @@ BlackBoardInterfaceManager::open_for_reading(const char *type, const char *ident
 
   } catch (Exception &e) {
     if (iface)  delete_interface_instance(iface);
-    memmgr->unlock();
-    mutex->unlock();
+    shard.mutex->unlock();
     throw;
   }
 
@@ -324,75 +428,80 @@ BlackBoardInterfaceManager::open_for_reading(const char *type, const char *ident
  * @return list of new fully initialized interface instances of requested type. The
  * is allocated using new and you have to free it using delete after you are done
  * with it!
+ * @exception BBNotMasterException thrown if called on a slave
  */
 std::list<Interface *>
 BlackBoardInterfaceManager::open_multiple_for_reading(const char *type_pattern,
 						      const char *id_pattern,
 						      const char *owner)
 {
-  mutex->lock();
-  memmgr->lock();
+  if ( ! memmgr->is_master() ) {
+    throw BBNotMasterException("Interfaces can only be opened by the BlackBoard master");
+  }
 
   std::list<Interface *> rv;
 
   Interface *iface = NULL;
   interface_header_t *ih;
-  BlackBoardMemoryManager::ChunkIterator cit;
 
-  try {
-    for ( cit = memmgr->begin(); cit != memmgr->end(); ++cit ) {
-      iface = NULL;
-      ih = (interface_header_t *)*cit;
-
-      // ensure 0-termination
-      char type[INTERFACE_TYPE_SIZE_ + 1];
-      char id[INTERFACE_ID_SIZE_ + 1];
-      type[INTERFACE_TYPE_SIZE_] = 0;
-      id[INTERFACE_TYPE_SIZE_] = 0;
-      strncpy(type, ih->type, INTERFACE_TYPE_SIZE_);
-      strncpy(id, ih->id, INTERFACE_ID_SIZE_);
-
-      if ((fnmatch(type_pattern, type, 0) == FNM_NOMATCH) ||
-	  (fnmatch(id_pattern, id, 0) == FNM_NOMATCH) ) {
-	// type or ID prefix does not match, go on
-	continue;
+  for (unsigned int s = 0; s < BBIM_NUM_SHARDS; ++s) {
+    DirectoryShard &shard = shards_[s];
+    shard.mutex->lock();
+
+    try {
+      std::map<std::string, DirectoryEntry>::iterator e;
+      for (e = shard.entries.begin(); e != shard.entries.end(); ++e) {
+	iface = NULL;
+	ih = (interface_header_t *)e->second.ptr;
+
+	// ensure 0-termination
+	char type[INTERFACE_TYPE_SIZE_ + 1];
+	char id[INTERFACE_ID_SIZE_ + 1];
+	type[INTERFACE_TYPE_SIZE_] = 0;
+	id[INTERFACE_ID_SIZE_] = 0;
+	strncpy(type, ih->type, INTERFACE_TYPE_SIZE_);
+	strncpy(id, ih->id, INTERFACE_ID_SIZE_);
+
+	if ((fnmatch(type_pattern, type, 0) == FNM_NOMATCH) ||
+	    (fnmatch(id_pattern, id, 0) == FNM_NOMATCH) ) {
+	  // type or ID prefix does not match, go on
+	  continue;
+	}
+
+	iface = new_interface_instance(type, id, owner);
+	set_interface_memory(iface, e->second.ptr);
+
+	if ( (iface->hash_size() != INTERFACE_HASH_SIZE_ ) ||
+	     (memcmp(iface->hash(), ih->hash, INTERFACE_HASH_SIZE_) != 0) ) {
+	  throw BlackBoardInterfaceVersionMismatchException();
+	}
+
+	e->second.rwlock->ref();
+
+	owner_info_.lock();
+	owner_info_[e->first].readers.push_back(iface);
+	owner_info_.unlock();
+	iface->set_readwrite(false, e->second.rwlock);
+	ih->refcount++;
+	ih->num_readers++;
+
+	rv.push_back(iface);
       }
 
-      void *ptr = *cit;
-      iface = new_interface_instance(ih->type, ih->id, owner);
-      iface->set_memory(ih->serial, ptr, (char *)ptr + sizeof(interface_header_t));
+      shard.mutex->unlock();
 
-      if ( (iface->hash_size() != INTERFACE_HASH_SIZE_ ) ||
-	   (memcmp(iface->hash(), ih->hash, INTERFACE_HASH_SIZE_) != 0) ) {
-	throw BlackBoardInterfaceVersionMismatchException();
+    } catch (Exception &e) {
+      if (iface)  delete_interface_instance( iface );
+      for (std::list<Interface *>::iterator i = rv.begin(); i != rv.end(); ++i) {
+	delete_interface_instance(*i);
       }
-
-      rwlocks[ih->serial]->ref();
-
-      owner_info_[iface->uid()].readers.push_back(iface);
-      iface->set_readwrite(false, rwlocks[ih->serial]);
-      ih->refcount++;
-      ih->num_readers++;
-
-      rv.push_back(iface);
-    }
-
-    mutex->unlock();
-    memmgr->unlock();
-
-    for (std::list<Interface *>::iterator j = rv.begin(); j != rv.end(); ++j) {
-      notifier->notify_of_reader_added(*j, (*j)->serial());
+      shard.mutex->unlock();
+      throw;
     }
+  }
 
-
-  } catch (Exception &e) {
-    if (iface)  delete_interface_instance( iface );
-    for (std::list<Interface *>::iterator i = rv.begin(); i != rv.end(); ++i) {
-      delete_interface_instance(*i);
-    }
-    memmgr->unlock();
-    mutex->unlock();
-    throw;
+  for (std::list<Interface *>::iterator j = rv.begin(); j != rv.end(); ++j) {
+    notifier->notify_of_reader_added(*j, (*j)->serial());
   }
 
   return rv;
@@ -410,6 +519,7 @@ BlackBoardInterfaceManager::open_multiple_for_reading(const char *type_pattern,
  * @return new fully initialized interface instance of requested type
  * @exception OutOfMemoryException thrown if there is not enough free space for
  * the requested interface.
+ * @exception BBNotMasterException thrown if called on a slave
  * @exception BlackBoardWriterActiveException thrown if there is already a writing
  * instance with the same type/id
  */
@@ -425,21 +535,27 @@ BlackBoardInterfaceManager::open_for_writing(const char *type, const char *ident
 		    type, INTERFACE_ID_SIZE_);
   }
 
-  mutex->lock();
-  memmgr->lock();
+  if ( ! memmgr->is_master() ) {
+    throw BBNotMasterException("Interfaces can only be opened by the BlackBoard master");
+  }
+
+  std::string uid = std::string(type) + "::" + identifier;
+  DirectoryShard &shard = shard_for(uid);
+
+  shard.mutex->lock();
 
   Interface *iface = NULL;
-  void *ptr = NULL;
   interface_header_t *ih;
   bool created = false;
 
   try {
-    ptr = find_interface_in_memory(type, identifier);
-
-    if ( ptr != NULL ) {
+    std::map<std::string, DirectoryEntry>::iterator e = shard.entries.find(uid);
+    DirectoryEntry entry;
+    if ( e != shard.entries.end() ) {
       // found, check if there is already a writer
       //instantiate new interface for given memory chunk
-      ih  = (interface_header_t *)ptr;
+      entry = e->second;
+      ih  = (interface_header_t *)entry.ptr;
       if ( ih->flag_writer_active ) {
 	throw BlackBoardWriterActiveException(identifier, type);
       }
@@ -448,23 +564,27 @@ BlackBoardInterfaceManager::open_for_writing(const char *type, const char *ident
 	   (memcmp(iface->hash(), ih->hash, INTERFACE_HASH_SIZE_) != 0) ) {
 	throw BlackBoardInterfaceVersionMismatchException();
       }
-      iface->set_memory(ih->serial, ptr, (char *)ptr + sizeof(interface_header_t));
-      rwlocks[ih->serial]->ref();
+      set_interface_memory(iface, entry.ptr);
+      entry.rwlock->ref();
     } else {
       created = true;
-      create_interface(type, identifier, owner, iface, ptr);
-      ih = (interface_header_t *)ptr;
+      create_interface(type, identifier, owner, iface, entry);
+      ih = (interface_header_t *)entry.ptr;
+      shard.entries[uid] = entry;
     }
 
-    owner_info_[iface->uid()].writer = iface;
-    iface->set_readwrite(true, rwlocks[ih->serial]);
+    owner_info_.lock();
+    owner_info_[uid].writer = iface;
+    owner_info_.unlock();
+    iface->set_readwrite(true, entry.rwlock);
     ih->flag_writer_active = 1;
     ih->refcount++;
 
-    memmgr->unlock();
+    writer_interfaces.lock();
     writer_interfaces[ih->serial] = iface;
+    writer_interfaces.unlock();
 
-    mutex->unlock();
+    shard.mutex->unlock();
 
     if ( created ) {
       notifier->notify_of_interface_created(type, identifier);
@@ -472,8 +592,7 @@ BlackBoardInterfaceManager::open_for_writing(const char *type, const char *ident
     notifier->notify_of_writer_added(iface, iface->serial());
   } catch (Exception &e) {
     if (iface)  delete_interface_instance(iface);
-    memmgr->unlock();
-    mutex->unlock();
+    shard.mutex->unlock();
     throw;
   }
 
@@ -488,29 +607,38 @@ void
 BlackBoardInterfaceManager::close(Interface *interface)
 {
   if ( interface == NULL ) return;
-  mutex->lock();
+  DirectoryShard &shard = shard_for(interface->uid());
   bool destroyed = false;
 
   // reduce refcount and free memory if refcount is zero
   interface_header_t *ih = (interface_header_t *)interface->mem_real_ptr_;
   bool killed_writer = interface->write_access_;
-  if ( --(ih->refcount) == 0 ) {
-    // redeem from memory
-    if ( interface->write_access_ ) {
-      writer_interfaces.erase( interface->mem_serial_ );
-    }
-    memmgr->free( interface->mem_real_ptr_ );
-    destroyed = true;
-  } else {
-    if ( interface->write_access_ ) {
-      ih->flag_writer_active = 0;
-      writer_interfaces.erase( interface->mem_serial_ );
+  if ( interface->write_access_ ) {
+    writer_interfaces.lock();
+    writer_interfaces.erase( interface->mem_serial_ );
+    writer_interfaces.unlock();
+  }
+
+  shard.mutex->lock();
+  try {
+    if ( --(ih->refcount) == 0 ) {
+      // redeem from memory
+      shard.entries.erase(interface->uid());
+      destroyed = true;
+      memmgr->free( interface->mem_real_ptr_ );
     } else {
-      ih->num_readers--;
+      if ( interface->write_access_ ) {
+	ih->flag_writer_active = 0;
+      } else {
+	ih->num_readers--;
+      }
     }
+  } catch (Exception &e) {
+    shard.mutex->unlock();
+    throw;
   }
+  shard.mutex->unlock();
 
-  mutex->unlock();
   if (killed_writer) {
     notifier->notify_of_writer_removed(interface, interface->serial());
   } else {
@@ -520,8 +648,18 @@ BlackBoardInterfaceManager::close(Interface *interface)
     notifier->notify_of_interface_destroyed(interface->type_, interface->id_);
   }
 
-  MutexLocker lock(mutex);
-  delete_interface_instance( interface );
+  // the reference to the read/write lock is released here instead of in
+  // the destructor, such that it is released even if the instance cannot
+  // be destroyed
+  RefCountRWLock *rwlock = interface->rwlock_;
+  interface->rwlock_ = NULL;
+  try {
+    delete_interface_instance( interface );
+  } catch (Exception &e) {
+    if (rwlock)  rwlock->unref();
+    throw;
+  }
+  if (rwlock)  rwlock->unref();
 }
 
 
@@ -532,32 +670,7 @@ BlackBoardInterfaceManager::close(Interface *interface)
 InterfaceInfoList *
 BlackBoardInterfaceManager::list_all() const
 {
-  InterfaceInfoList *infl = new InterfaceInfoList();
-
-  memmgr->lock();
-  interface_header_t *ih;
-  BlackBoardMemoryManager::ChunkIterator cit;
-  for ( cit = memmgr->begin(); cit != memmgr->end(); ++cit ) {
-    ih = (interface_header_t *)*cit;
-    Interface::interface_data_ts_t *data_ts =
-      (Interface::interface_data_ts_t *)((char *)*cit + sizeof(interface_header_t));
-    char type[INTERFACE_TYPE_SIZE_ + 1];
-    char id[INTERFACE_ID_SIZE_ + 1];
-    // ensure NULL-termination
-    type[INTERFACE_TYPE_SIZE_] = 0;
-    id[INTERFACE_ID_SIZE_] = 0;
-    strncpy(type, ih->type, INTERFACE_TYPE_SIZE_);
-    strncpy(id, ih->id, INTERFACE_ID_SIZE_);
-    std::string uid = std::string(type) + "::" + id;
-    infl->append(ih->type, ih->id, ih->hash, ih->serial,
-		 ih->flag_writer_active, ih->num_readers,
-		 readers(uid), writer(uid),
-		 Time(data_ts->timestamp_sec, data_ts->timestamp_usec));
-  }
-
-  memmgr->unlock();
-
-  return infl;
+  return list("*", "*");
 }
 
 
@@ -573,6 +686,52 @@ BlackBoardInterfaceManager::list_all() const
 InterfaceInfoList *
 BlackBoardInterfaceManager::list(const char *type_pattern,
 				 const char *id_pattern) const
+{
+  if ( ! memmgr->is_master() ) {
+    return list_from_memory(type_pattern, id_pattern);
+  }
+
+  InterfaceInfoList *infl = new InterfaceInfoList();
+
+  for (unsigned int s = 0; s < BBIM_NUM_SHARDS; ++s) {
+    const DirectoryShard &shard = shards_[s];
+    MutexLocker lock(shard.mutex);
+    std::map<std::string, DirectoryEntry>::const_iterator e;
+    for (e = shard.entries.begin(); e != shard.entries.end(); ++e) {
+      interface_header_t *ih = (interface_header_t *)e->second.ptr;
+      Interface::interface_data_ts_t *data_ts =
+	(Interface::interface_data_ts_t *)((char *)e->second.ptr + sizeof(interface_header_t));
+      char type[INTERFACE_TYPE_SIZE_ + 1];
+      char id[INTERFACE_ID_SIZE_ + 1];
+      // ensure NULL-termination
+      type[INTERFACE_TYPE_SIZE_] = 0;
+      id[INTERFACE_ID_SIZE_] = 0;
+      strncpy(type, ih->type, INTERFACE_TYPE_SIZE_);
+      strncpy(id, ih->id, INTERFACE_ID_SIZE_);
+      if ((fnmatch(type_pattern, type, FNM_NOESCAPE) == 0) &&
+	  (fnmatch(id_pattern, id, FNM_NOESCAPE) == 0))
+      {
+	infl->append(ih->type, ih->id, ih->hash, ih->serial,
+		     ih->flag_writer_active, ih->num_readers,
+		     readers(e->first), writer(e->first),
+		     fawkes::Time(data_ts->timestamp_sec, data_ts->timestamp_usec));
+      }
+    }
+  }
+
+  return infl;
+}
+
+
+/** Get a constrained list of interfaces from the memory chunks.
+ * This is used by slaves which do not maintain an interface directory.
+ * @param type_pattern tyoe pattern, may contain shell-like wildcards
+ * @param id_pattern ID pattern, may contain shell-like wildcards
+ * @return list of interfaces in memory matching the given patterns
+ */
+InterfaceInfoList *
+BlackBoardInterfaceManager::list_from_memory(const char *type_pattern,
+					     const char *id_pattern) const
 {
   InterfaceInfoList *infl = new InterfaceInfoList();
 
@@ -600,7 +759,6 @@ BlackBoardInterfaceManager::list(const char *type_pattern,
 		   fawkes::Time(data_ts->timestamp_sec, data_ts->timestamp_usec));
     }
   }
-
   memmgr->unlock();
 
   return infl;
@@ -616,9 +774,14 @@ BlackBoardInterfaceManager::list(const char *type_pattern,
 Interface *
 BlackBoardInterfaceManager::writer_for_mem_serial(unsigned int mem_serial)
 {
-  if ( writer_interfaces.find(mem_serial) != writer_interfaces.end() ) {
-    return writer_interfaces[mem_serial];
+  writer_interfaces.lock();
+  LockMap<unsigned int, Interface *>::iterator w = writer_interfaces.find(mem_serial);
+  if ( w != writer_interfaces.end() ) {
+    Interface *writer = w->second;
+    writer_interfaces.unlock();
+    return writer;
   } else {
+	  writer_interfaces.unlock();
 	  char type[INTERFACE_TYPE_SIZE_ + 1] = "Unknown";
 	  char id[INTERFACE_ID_SIZE_ + 1] = "Invalid";
 	  // ensure NULL-termination
@@ -651,7 +814,10 @@ BlackBoardInterfaceManager::notify_of_data_change(const Interface *interface)
 bool
 BlackBoardInterfaceManager::exists_writer(const Interface *interface) const
 {
-  return (writer_interfaces.find(interface->mem_serial_) != writer_interfaces.end());
+  writer_interfaces.lock();
+  bool rv = (writer_interfaces.find(interface->mem_serial_) != writer_interfaces.end());
+  writer_interfaces.unlock();
+  return rv;
 }
 
 
@@ -29,8 +29,14 @@
 #include <utils/misc/string_compare.h>
 
 #include <list>
+#include <map>
 #include <string>
 
+/** Number of shards of the interface directory.
+ * Opening or closing interfaces which hash to different shards does not
+ * contend for a common lock. */
+#define BBIM_NUM_SHARDS 64
+
 namespace fawkes {
 
 class Interface;
@@ -68,6 +74,9 @@ class BlackBoardInterfaceManager : public InterfaceMediator
 						   const char *id_pattern = "*",
 						   const char *owner = NULL);
 
+  void set_history_size(const char *type_pattern, const char *id_pattern,
+			unsigned int slots);
+
   /* InterfaceMediator methods */
   virtual bool exists_writer(const Interface *interface) const;
   virtual unsigned int num_readers(const Interface *interface) const;
@@ -84,16 +93,33 @@ class BlackBoardInterfaceManager : public InterfaceMediator
   Interface *  new_interface_instance(const char *type, const char *identifier, const char *owner);
   void         delete_interface_instance(Interface *interface);
 
-  void *       find_interface_in_memory(const char *type, const char *identifier);
+  /** Entry in the interface directory. */
+  typedef struct {
+    void           *ptr;	/**< memory chunk, starting with interface header */
+    RefCountRWLock *rwlock;	/**< read/write lock shared by all instances */
+  } DirectoryEntry;
+
+  /** Shard of the interface directory, maps interface UIDs to entries. */
+  typedef struct {
+    Mutex                                  *mutex;	/**< protects entries and headers */
+    std::map<std::string, DirectoryEntry>   entries;	/**< entries by UID */
+  } DirectoryShard;
+
+  DirectoryShard & shard_for(const std::string &uid);
   unsigned int next_mem_serial();
   unsigned int next_instance_serial();
   void         create_interface(const char *type, const char *identifier, const char *owner,
-				Interface* &interface, void* &ptr);
+				Interface* &interface, DirectoryEntry &entry);
+  void         set_interface_memory(Interface *interface, void *ptr);
+  unsigned int history_size_for(const char *type, const char *identifier);
 
   Interface *  writer_for_mem_serial(unsigned int mem_serial);
+  InterfaceInfoList *  list_from_memory(const char *type_pattern,
+					const char *id_pattern) const;
 
  private:
   unsigned int                  instance_serial;
+  unsigned int                  mem_serial_;
 
   BlackBoardMemoryManager      *memmgr;
   BlackBoardMessageManager     *msgmgr;
@@ -102,7 +128,7 @@ class BlackBoardInterfaceManager : public InterfaceMediator
   BlackBoardNotifier           *notifier;
 
   LockMap< unsigned int, Interface * >              writer_interfaces;
-  LockMap< unsigned int, RefCountRWLock * >         rwlocks;
+  DirectoryShard                                    shards_[BBIM_NUM_SHARDS];
 
   typedef struct _OwnerInfo {
     _OwnerInfo() : writer(NULL) {}
@@ -110,6 +136,13 @@ class BlackBoardInterfaceManager : public InterfaceMediator
     std::list<Interface *>  readers;
   } OwnerInfo;
   LockMap<std::string, OwnerInfo> owner_info_;
+
+  typedef struct {
+    std::string  type_pattern;
+    std::string  id_pattern;
+    unsigned int slots;
+  } HistoryConfig;
+  std::list<HistoryConfig> history_config_;
 };
 
 } // end namespace fawkes
@@ -42,6 +42,11 @@ typedef struct {
   uint16_t         num_readers;			/**< number of active readers */
   uint32_t         refcount;			/**< reference count */
   uint32_t         serial;			/**< memory serial */
+  uint32_t         data_version;		/**< data version counter, odd while
+						 * the writer copies data (seqlock) */
+  uint32_t         history_slots;		/**< number of history slots following
+						 * the data, 0 if no history is kept */
+  uint64_t         sequence;			/**< sequence number of last write */
 } interface_header_t;
 
 } // end namespace fawkes
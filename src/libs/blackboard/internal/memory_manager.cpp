@@ -38,6 +38,9 @@
 #include <cstdio>
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <vector>
+
 /** If a free chunk is allocated it may be split up into an allocated
  * and a new free chunk. This value determines when this is done. If
  * there are at least this many data bytes (without the list header)
@@ -46,6 +49,9 @@
  */
 #define BBMM_MIN_FREE_CHUNK_SIZE sizeof(chunk_list_t)
 
+/** Size of the smallest size class in size class mode. */
+#define BBMM_SIZE_CLASS_MIN 64
+
 // shortcuts
 #define chunk_ptr(a)  (shmem_ ? (chunk_list_t *)shmem_->ptr(a)  : a)
 #define chunk_addr(a) (shmem_ ? (chunk_list_t *)shmem_->addr(a) : a)
@@ -82,6 +88,23 @@ namespace fawkes {
  * of free memory are merged to one. Afterwards the free chunks list will contain
  * non-ajdacent free memory regions of maximum size between allocated chunks.
  *
+ * Optionally the memory manager can operate in size class mode. Then the
+ * requested size is rounded up to one of BBMM_NUM_SIZE_CLASSES size
+ * classes, four per power of two from 64 bytes up to 64 KB. Freed chunks
+ * are not merged back into the free chunks list, but are kept in a free
+ * list of their size class, from which they are re-used in O(1) by later
+ * allocations of the same class. If a class has no cached chunk a new one
+ * is split off in O(1) from the end of the slab, a big chunk in the free
+ * chunks list. Only when the slab is used up the biggest free chunk
+ * becomes the new slab. The
+ * allocated chunks list is unsorted and doubly linked in this mode, such
+ * that free() is O(1) as well. This avoids fragmentation when interfaces
+ * of mixed sizes are repeatedly opened and closed. Allocations larger than
+ * the biggest size class are served and freed with the default strategy.
+ * If the free chunks list cannot satisfy an allocation all cached chunks
+ * are released and merged before giving up. The mode is chosen by the
+ * master and stored in the shared memory header.
+ *
  * The memory manager is thread-safe as all appropriate operations are protected
  * by a mutex.
  *
@@ -100,8 +123,10 @@ namespace fawkes {
 /** Heap Memory Constructor.
  * Constructs a memory segment on the heap.
  * @param memsize memory size
+ * @param size_classes true to use size class allocation, false to use
+ * the default first-fit allocation
  */
-BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize)
+BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize, bool size_classes)
 {
   shmem_        = NULL;
   shmem_header_ = NULL;
@@ -109,6 +134,13 @@ BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize)
   memory_       = malloc(memsize);
   mutex_        = new Mutex();
   master_       = true;
+  sc_mode_      = size_classes;
+  size_classes_ = NULL;
+  sc_slab_      = NULL;
+  if (sc_mode_) {
+    size_classes_ = new size_class_t[BBMM_NUM_SIZE_CLASSES];
+    memset(size_classes_, 0, sizeof(size_class_t) * BBMM_NUM_SIZE_CLASSES);
+  }
 
   // Lock memory to RAM to avoid swapping
   mlock(memory_, memsize_);
@@ -118,6 +150,9 @@ BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize)
   f->size = memsize_ - sizeof(chunk_list_t);
   f->overhang = 0;
   f->next = NULL;
+  f->prev = NULL;
+  f->size_class = 0;
+  f->allocated = 0;
 
   free_list_head_  = f;
   alloc_list_head_ = NULL;
@@ -130,6 +165,9 @@ BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize)
  * @param version version of the BlackBoard
  * @param master master mode, this memory manager has to be owner of shared memory segment
  * @param shmem_token shared memory token, passed to SharedMemory
+ * @param size_classes true to use size class allocation, false to use
+ * the default first-fit allocation. Only considered in master mode,
+ * otherwise the mode of the existing segment is used.
  * @exception BBMemMgrNotMasterException A matching shared memory segment
  * has already been created.
  * @see SharedMemory::SharedMemory()
@@ -137,11 +175,14 @@ BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize)
 BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize,
 						 unsigned int version,
 						 bool master,
-						 const char *shmem_token)
+						 const char *shmem_token,
+						 bool size_classes)
 {
-  memory_    = NULL;
-  memsize_   = memsize;
-  master_    = master;
+  memory_       = NULL;
+  memsize_      = memsize;
+  master_       = master;
+  size_classes_ = NULL;
+  sc_slab_      = NULL;
 
   // open shared memory segment, if it exists try to aquire exclusive
   // semaphore, if that fails, throw an exception
@@ -190,11 +231,17 @@ BlackBoardMemoryManager::BlackBoardMemoryManager(size_t memsize,
     f->size = memsize_ - sizeof(chunk_list_t);
     f->overhang = 0;
     f->next = NULL;
+    f->prev = NULL;
+    f->size_class = 0;
+    f->allocated = 0;
 
     shmem_header_->set_free_list_head(f);
     shmem_header_->set_alloc_list_head(NULL);
+    shmem_header_->set_size_class_mode(size_classes);
   }
 
+  sc_mode_ = shmem_header_->size_class_mode();
+
   mutex_ = new Mutex();
 }
 
@@ -208,6 +255,7 @@ BlackBoardMemoryManager::~BlackBoardMemoryManager()
   if (memory_) {
     ::free(memory_);
   }
+  delete[] size_classes_;
   delete mutex_;
 }
 
@@ -223,6 +271,34 @@ BlackBoardMemoryManager::~BlackBoardMemoryManager()
  */
 void *
 BlackBoardMemoryManager::alloc_nolock(unsigned int num_bytes)
+{
+  if (sc_mode_)  return sc_alloc(num_bytes);
+
+  chunk_list_t *f = take_free_chunk(num_bytes);
+
+  // alloc new chunk
+  if ( shmem_ ) {
+    shmem_header_->set_alloc_list_head( list_add(shmem_header_->alloc_list_head(), f) );
+    return shmem_->ptr(f->ptr);
+  } else {
+    alloc_list_head_ = list_add(alloc_list_head_, f);
+    return f->ptr;
+  }
+}
+
+
+/** Take a chunk from the free chunks list.
+ * Searches the smallest free chunk big enough for the requested size,
+ * removes it from the free chunks list and splits off the remaining
+ * memory as a new free chunk if it is big enough. The chunk is not added
+ * to the allocated chunks list.
+ * @param num_bytes number of bytes to allocate
+ * @return chunk of at least the given size
+ * @exception OutOfMemoryException thrown if not enough free memory is available to
+ *                                 accommodate a chunk of the desired size
+ */
+chunk_list_t *
+BlackBoardMemoryManager::take_free_chunk(unsigned int num_bytes)
 {
   // search for smallest chunk just big enough for desired size
   chunk_list_t *l = shmem_ ? shmem_header_->free_list_head() : free_list_head_;
@@ -243,6 +319,7 @@ BlackBoardMemoryManager::alloc_nolock(unsigned int num_bytes)
   }
 
   // remove chunk from free_list
+  if (f == sc_slab())  sc_set_slab(NULL);
   if ( shmem_ ) {
     shmem_header_->set_free_list_head( list_remove(shmem_header_->free_list_head(), f) );
   } else {
@@ -268,6 +345,9 @@ BlackBoardMemoryManager::alloc_nolock(unsigned int num_bytes)
     nfc->ptr = shmem_ ? shmem_->addr((char *)nfc + sizeof(chunk_list_t)) : (char *)nfc + sizeof(chunk_list_t);
     nfc->size = f->size - num_bytes - sizeof(chunk_list_t);
     nfc->overhang = 0;
+    nfc->prev = NULL;
+    nfc->size_class = 0;
+    nfc->allocated = 0;
     
     if ( shmem_ ) {
       shmem_header_->set_free_list_head( list_add(shmem_header_->free_list_head(), nfc) );
@@ -283,15 +363,7 @@ BlackBoardMemoryManager::alloc_nolock(unsigned int num_bytes)
     f->overhang = f->size - num_bytes;
   }
 
-  // alloc new chunk
-  if ( shmem_ ) {
-    shmem_header_->set_alloc_list_head( list_add(shmem_header_->alloc_list_head(), f) );
-    return shmem_->ptr(f->ptr);
-  } else {
-    alloc_list_head_ = list_add(alloc_list_head_, f);
-    return f->ptr;
-  }
-
+  return f;
 }
 
 
@@ -336,7 +408,17 @@ void
 BlackBoardMemoryManager::free(void *ptr)
 {
   mutex_->lock();
-  if (shmem_) {
+  if (sc_mode_) {
+    if (shmem_) shmem_->lock_for_write();
+    try {
+      sc_free(ptr);
+    } catch (Exception &e) {
+      if (shmem_) shmem_->unlock();
+      mutex_->unlock();
+      throw;
+    }
+    if (shmem_) shmem_->unlock();
+  } else if (shmem_) {
     shmem_->lock_for_write();
 
     // find chunk in alloc_chunks
@@ -388,6 +470,11 @@ BlackBoardMemoryManager::free(void *ptr)
 void
 BlackBoardMemoryManager::check()
 {
+  if (sc_mode_) {
+    sc_check();
+    return;
+  }
+
   chunk_list_t *f = shmem_ ? shmem_header_->free_list_head() : free_list_head_;
   chunk_list_t *a = shmem_ ? shmem_header_->alloc_list_head() : alloc_list_head_;
   chunk_list_t *t = NULL;
@@ -489,6 +576,16 @@ BlackBoardMemoryManager::print_performance_info() const
 	 list_length( shmem_ ? shmem_header_->free_list_head() : free_list_head_),
 	 list_length( shmem_ ? shmem_header_->alloc_list_head() : alloc_list_head_),
 	 max_free_size(), max_allocated_size(), overhang_size());
+
+  if (sc_mode_) {
+    const size_class_t *sc = sc_classes();
+    for (unsigned int i = 0; i < BBMM_NUM_SIZE_CLASSES; ++i) {
+      if (sc[i].num_allocs == 0)  continue;
+      printf("  size class %2u (%6u bytes): alloc: %6u, cached: %6u, allocs: %8u, refills: %8u\n",
+	     i, size_class_size(i), sc[i].num_allocated, sc[i].num_free,
+	     sc[i].num_allocs, sc[i].num_refills);
+    }
+  }
 }
 
 
@@ -525,6 +622,14 @@ BlackBoardMemoryManager::free_size() const
     free_size += l->size;
     l = chunk_ptr(l->next);
   }
+  if (sc_mode_) {
+    const size_class_t *sc = sc_classes();
+    for (unsigned int i = 0; i < BBMM_NUM_SIZE_CLASSES; ++i) {
+      for (l = chunk_ptr(sc[i].free_head); l; l = chunk_ptr(l->next)) {
+	free_size += l->size;
+      }
+    }
+  }
   return free_size;
 }
 
@@ -562,7 +667,14 @@ BlackBoardMemoryManager::num_allocated_chunks() const
 unsigned int
 BlackBoardMemoryManager::num_free_chunks() const
 {
-  return list_length( shmem_ ? shmem_header_->free_list_head() : free_list_head_ );
+  unsigned int num = list_length( shmem_ ? shmem_header_->free_list_head() : free_list_head_ );
+  if (sc_mode_) {
+    const size_class_t *sc = sc_classes();
+    for (unsigned int i = 0; i < BBMM_NUM_SIZE_CLASSES; ++i) {
+      num += sc[i].num_free;
+    }
+  }
+  return num;
 }
 
 
@@ -587,6 +699,317 @@ BlackBoardMemoryManager::version() const
 }
 
 
+/** Check if size class allocation is used.
+ * @return true if the memory manager operates in size class mode, false
+ * if it uses the default first-fit allocation
+ */
+bool
+BlackBoardMemoryManager::size_classes() const
+{
+  return sc_mode_;
+}
+
+
+/** Get size class for size.
+ * @param num_bytes number of bytes to allocate
+ * @return index of the smallest size class which can hold the given
+ * number of bytes, BBMM_NUM_SIZE_CLASSES or larger if the size exceeds
+ * the biggest size class
+ */
+unsigned int
+BlackBoardMemoryManager::size_class_index(unsigned int num_bytes)
+{
+  if (num_bytes <= BBMM_SIZE_CLASS_MIN)  return 0;
+  // four classes per power of two, determine the highest bit and quarter
+  unsigned int m    = num_bytes - 1;
+  unsigned int p    = 31 - __builtin_clz(m);
+  unsigned int base = 1u << p;
+  return (p - 6) * 4 + (m - base) / (base >> 2) + 1;
+}
+
+
+/** Get size of a size class.
+ * @param index index of the size class
+ * @return number of bytes of chunks in the given size class
+ */
+unsigned int
+BlackBoardMemoryManager::size_class_size(unsigned int index)
+{
+  if (index == 0)  return BBMM_SIZE_CLASS_MIN;
+  unsigned int base = BBMM_SIZE_CLASS_MIN << ((index - 1) / 4);
+  return base + ((index - 1) % 4 + 1) * (base >> 2);
+}
+
+
+/** Get size classes.
+ * @return array of BBMM_NUM_SIZE_CLASSES size classes
+ */
+size_class_t *
+BlackBoardMemoryManager::sc_classes() const
+{
+  return shmem_ ? shmem_header_->size_classes() : size_classes_;
+}
+
+
+/** Allocate memory in size class mode.
+ * Note: this method does NOT lock the shared memory system.
+ * @param num_bytes number of bytes to allocate
+ * @return pointer to the memory chunk
+ * @exception OutOfMemoryException thrown if not enough free memory is available to
+ *                                 accommodate a chunk of the desired size
+ */
+void *
+BlackBoardMemoryManager::sc_alloc(unsigned int num_bytes)
+{
+  size_class_t *classes = sc_classes();
+  unsigned int idx = size_class_index(num_bytes);
+  size_class_t *sc = (idx < BBMM_NUM_SIZE_CLASSES) ? &classes[idx] : NULL;
+  // keep chunk headers 8-byte aligned, size classes are multiples of 16
+  unsigned int chunk_size = sc ? size_class_size(idx) : (num_bytes + 7) & ~7u;
+
+  chunk_list_t *f = sc ? chunk_ptr(sc->free_head) : NULL;
+  if (f) {
+    sc->free_head = f->next;
+    sc->num_free -= 1;
+  } else {
+    try {
+      f = sc ? sc_take_slab_chunk(chunk_size) : take_free_chunk(chunk_size);
+    } catch (OutOfMemoryException &e) {
+      // release all cached chunks and try once more
+      bool released = false;
+      for (unsigned int i = 0; i < BBMM_NUM_SIZE_CLASSES; ++i) {
+	chunk_list_t *c = chunk_ptr(classes[i].free_head);
+	while (c) {
+	  chunk_list_t *next = chunk_ptr(c->next);
+	  c->size_class = 0;
+	  if ( shmem_ ) {
+	    shmem_header_->set_free_list_head( list_add(shmem_header_->free_list_head(), c) );
+	  } else {
+	    free_list_head_ = list_add(free_list_head_, c);
+	  }
+	  released = true;
+	  c = next;
+	}
+	classes[i].free_head = NULL;
+	classes[i].num_free  = 0;
+      }
+      if (! released)  throw;
+      cleanup_free_chunks();
+      f = take_free_chunk(chunk_size);
+    }
+    if (sc)  sc->num_refills += 1;
+  }
+
+  if (sc) {
+    sc->num_allocs    += 1;
+    sc->num_allocated += 1;
+  }
+  f->size_class = sc ? idx + 1 : 0;
+  f->overhang   = f->size - num_bytes;
+  f->allocated  = 1;
+  sc_alloc_list_push(f);
+
+  return shmem_ ? shmem_->ptr(f->ptr) : f->ptr;
+}
+
+
+/** Take a chunk for a size class refill from the slab.
+ * The slab is a big chunk in the free chunks list. The chunk is split off
+ * its end, such that the slab keeps its position in the list. Only if the
+ * slab is too small the biggest free chunk becomes the new slab. If no
+ * free chunk can be split the chunk is taken from the free chunks list.
+ * Note: this method does NOT lock the shared memory system.
+ * @param num_bytes number of bytes of the chunk, multiple of 8
+ * @return chunk of the given size
+ * @exception OutOfMemoryException thrown if not enough free memory is available to
+ *                                 accommodate a chunk of the desired size
+ */
+chunk_list_t *
+BlackBoardMemoryManager::sc_take_slab_chunk(unsigned int num_bytes)
+{
+  const unsigned int min_size = num_bytes + BBMM_MIN_FREE_CHUNK_SIZE + sizeof(chunk_list_t);
+
+  chunk_list_t *s = sc_slab();
+  if (! s || (s->size < min_size)) {
+    s = list_get_biggest( shmem_ ? shmem_header_->free_list_head() : free_list_head_ );
+    if (! s || (s->size < min_size)) {
+      sc_set_slab(NULL);
+      return take_free_chunk(num_bytes);
+    }
+    sc_set_slab(s);
+  }
+
+  s->size -= num_bytes + sizeof(chunk_list_t);
+  chunk_list_t *f = (chunk_list_t *)((char *)s + sizeof(chunk_list_t) + s->size);
+  f->ptr = shmem_ ? shmem_->addr((char *)f + sizeof(chunk_list_t)) : (char *)f + sizeof(chunk_list_t);
+  f->size = num_bytes;
+  f->overhang = 0;
+  f->next = NULL;
+  f->prev = NULL;
+  f->size_class = 0;
+  f->allocated = 0;
+
+  return f;
+}
+
+
+/** Get the size class refill slab.
+ * @return slab chunk, NULL if there is none
+ */
+chunk_list_t *
+BlackBoardMemoryManager::sc_slab() const
+{
+  return shmem_ ? shmem_header_->sc_slab() : sc_slab_;
+}
+
+
+/** Set the size class refill slab.
+ * @param slab new slab chunk, NULL if there is none
+ */
+void
+BlackBoardMemoryManager::sc_set_slab(chunk_list_t *slab)
+{
+  if (shmem_) {
+    shmem_header_->set_sc_slab(slab);
+  } else {
+    sc_slab_ = slab;
+  }
+}
+
+
+/** Free memory in size class mode.
+ * Note: this method does NOT lock the shared memory system.
+ * @param ptr pointer to the chunk of memory
+ * @exception BlackBoardMemMgrInvalidPointerException the pointer has not
+ * been returned by alloc() or has already been freed
+ */
+void
+BlackBoardMemoryManager::sc_free(void *ptr)
+{
+  char *base = shmem_ ? (char *)shmem_->memptr() : (char *)memory_;
+  if ( ((char *)ptr < base + sizeof(chunk_list_t)) ||
+       ((char *)ptr >= base + memsize_) )
+  {
+    throw BlackBoardMemMgrInvalidPointerException();
+  }
+
+  // the chunk header directly precedes the data
+  chunk_list_t *c = (chunk_list_t *)((char *)ptr - sizeof(chunk_list_t));
+  if ( (c->ptr != (shmem_ ? shmem_->addr(ptr) : ptr)) || ! c->allocated ) {
+    throw BlackBoardMemMgrInvalidPointerException();
+  }
+
+  sc_alloc_list_unlink(c);
+  c->allocated = 0;
+  c->overhang  = 0;
+  c->prev      = NULL;
+
+  if (c->size_class > 0) {
+    size_class_t *sc = &sc_classes()[c->size_class - 1];
+    c->next = sc->free_head;
+    sc->free_head = chunk_addr(c);
+    sc->num_free      += 1;
+    sc->num_allocated -= 1;
+  } else {
+    if ( shmem_ ) {
+      shmem_header_->set_free_list_head( list_add(shmem_header_->free_list_head(), c) );
+    } else {
+      free_list_head_ = list_add(free_list_head_, c);
+    }
+    cleanup_free_chunks();
+  }
+}
+
+
+/** Add chunk to head of allocated chunks list.
+ * @param c chunk to add
+ */
+void
+BlackBoardMemoryManager::sc_alloc_list_push(chunk_list_t *c)
+{
+  chunk_list_t *head = shmem_ ? shmem_header_->alloc_list_head() : alloc_list_head_;
+  c->prev = NULL;
+  c->next = chunk_addr(head);
+  if (head)  head->prev = chunk_addr(c);
+  if (shmem_) {
+    shmem_header_->set_alloc_list_head(c);
+  } else {
+    alloc_list_head_ = c;
+  }
+}
+
+
+/** Remove chunk from allocated chunks list.
+ * @param c chunk to remove
+ */
+void
+BlackBoardMemoryManager::sc_alloc_list_unlink(chunk_list_t *c)
+{
+  chunk_list_t *p = chunk_ptr(c->prev);
+  chunk_list_t *n = chunk_ptr(c->next);
+  if (p) {
+    p->next = c->next;
+  } else if (shmem_) {
+    shmem_header_->set_alloc_list_head(n);
+  } else {
+    alloc_list_head_ = n;
+  }
+  if (n)  n->prev = c->prev;
+}
+
+
+/** Check memory consistency in size class mode.
+ * The free, allocated and cached chunks must together cover the whole
+ * memory segment without gaps or overlaps.
+ * @exception BBInconsistentMemoryException thrown if the memory segment has been
+ * corrupted. Contains descriptive message.
+ */
+void
+BlackBoardMemoryManager::sc_check()
+{
+  std::vector<chunk_list_t *> chunks;
+  chunk_list_t *l = shmem_ ? shmem_header_->free_list_head() : free_list_head_;
+  for (; l; l = chunk_ptr(l->next))  chunks.push_back(l);
+  l = shmem_ ? shmem_header_->alloc_list_head() : alloc_list_head_;
+  for (; l; l = chunk_ptr(l->next)) {
+    if (! l->allocated) {
+      throw BBInconsistentMemoryException("free chunk in allocated chunks list");
+    }
+    chunks.push_back(l);
+  }
+  size_class_t *sc = sc_classes();
+  for (unsigned int i = 0; i < BBMM_NUM_SIZE_CLASSES; ++i) {
+    for (l = chunk_ptr(sc[i].free_head); l; l = chunk_ptr(l->next)) {
+      if (l->size_class != i + 1) {
+	throw BBInconsistentMemoryException("chunk cached in wrong size class");
+      }
+      chunks.push_back(l);
+    }
+  }
+  if ( sc_slab() &&
+       ! list_find_ptr(shmem_ ? shmem_header_->free_list_head() : free_list_head_,
+		       sc_slab()->ptr) )
+  {
+    throw BBInconsistentMemoryException("slab chunk not in free chunks list");
+  }
+
+  std::sort(chunks.begin(), chunks.end());
+  unsigned int mem = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    mem += chunks[i]->size + sizeof(chunk_list_t);
+    if ( (i + 1 < chunks.size()) &&
+	 ((char *)chunks[i] + sizeof(chunk_list_t) + chunks[i]->size != (char *)chunks[i+1]) )
+    {
+      throw BBInconsistentMemoryException("non-contiguous or overlapping chunks");
+    }
+  }
+
+  if ( mem != memsize_ ) {
+    throw BBInconsistentMemoryException("unmanaged memory found, managed memory size != total memory size");
+  }
+}
+
+
 /** Lock memory.
  * Locks the whole memory segment used and managed by the memory manager. Will
  * aquire local mutex lock and global semaphore lock in shared memory segment.
@@ -688,6 +1111,7 @@ BlackBoardMemoryManager::cleanup_free_chunks()
     while ( l && n) {
       if ( ((char *)l->ptr + l->size + sizeof(chunk_list_t)) == n->ptr ) {
 	// re-unite
+	if (n == sc_slab())  sc_set_slab(l);
 	l->size += n->size + sizeof(chunk_list_t);
 	l->next = n->next;
 	modified = true;
@@ -47,6 +47,27 @@ struct chunk_list_t {
   unsigned int   size;		/**< total size of chunk, including overhanging bytes,
 				 * excluding header */
   unsigned int   overhang;	/**< number of overhanging bytes in this chunk */
+  chunk_list_t  *prev;		/**< offset to previous element, only maintained for
+				 * the allocated chunks list in size class mode */
+  unsigned int   size_class;	/**< size class index plus one, 0 if the chunk does
+				 * not belong to a size class */
+  unsigned int   allocated;	/**< 1 if the chunk is allocated, size class mode only */
+};
+
+/** Number of size classes in size class allocation mode. */
+#define BBMM_NUM_SIZE_CLASSES 41
+
+/** Size class as stored in BlackBoard shared memory segment.
+ * In size class mode freed chunks are not merged into the free list but
+ * kept in the free list of their size class for re-use.
+ */
+struct size_class_t {
+  chunk_list_t  *free_head;	/**< offset of cached free chunks list head */
+  unsigned int   num_free;	/**< number of cached free chunks */
+  unsigned int   num_allocated;	/**< number of currently allocated chunks */
+  unsigned int   num_allocs;	/**< number of allocations in this class */
+  unsigned int   num_refills;	/**< number of allocations for which a new chunk
+				 * had to be taken from the free list */
 };
 
 // May be added later if we want/need per chunk semaphores
@@ -59,10 +80,11 @@ class BlackBoardMemoryManager
 {
   friend BlackBoardInterfaceManager;
  public:
-  BlackBoardMemoryManager(size_t memsize);
+  BlackBoardMemoryManager(size_t memsize, bool size_classes = false);
   BlackBoardMemoryManager(size_t memsize, unsigned int version,
 			  bool use_shmem,
-			  const char *shmem_token = "FawkesBlackBoard");
+			  const char *shmem_token = "FawkesBlackBoard",
+			  bool size_classes = false);
   ~BlackBoardMemoryManager();
 
   void * alloc(unsigned int num_bytes);
@@ -84,6 +106,10 @@ class BlackBoardMemoryManager
 
   unsigned int memory_size() const;
   unsigned int version() const;
+  bool         size_classes() const;
+
+  static unsigned int size_class_index(unsigned int num_bytes);
+  static unsigned int size_class_size(unsigned int index);
 
   void   print_free_chunks_info() const;
   void   print_allocated_chunks_info() const;
@@ -138,12 +164,24 @@ class BlackBoardMemoryManager
 
   void cleanup_free_chunks();
 
+  chunk_list_t * take_free_chunk(unsigned int num_bytes);
+  chunk_list_t * sc_take_slab_chunk(unsigned int num_bytes);
+  chunk_list_t * sc_slab() const;
+  void           sc_set_slab(chunk_list_t *slab);
+  void *         sc_alloc(unsigned int num_bytes);
+  void           sc_free(void *ptr);
+  void           sc_alloc_list_push(chunk_list_t *c);
+  void           sc_alloc_list_unlink(chunk_list_t *c);
+  void           sc_check();
+  size_class_t * sc_classes() const;
+
   void list_print_info(const chunk_list_t *list) const;
 
   void * alloc_nolock(unsigned int num_bytes);
 
  private:
   bool master_;
+  bool sc_mode_;
 
   size_t memsize_;
 
@@ -158,6 +196,8 @@ class BlackBoardMemoryManager
   void  *memory_;
   chunk_list_t *free_list_head_;	/**< offset of the free chunks list head */
   chunk_list_t *alloc_list_head_;	/**< offset of the allocated chunks list head */
+  size_class_t *size_classes_;		/**< size classes, heap memory only */
+  chunk_list_t *sc_slab_;		/**< size class refill slab, heap memory only */
 
 };
 
@@ -28,6 +28,8 @@
 
 #include <core/threading/mutex.h>
 #include <core/threading/mutex_locker.h>
+#include <core/threading/wait_condition.h>
+#include <core/threading/thread.h>
 #include <core/utils/lock_hashset.h>
 #include <core/utils/lock_hashmap.h>
 #include <logging/liblogger.h>
@@ -38,14 +40,58 @@
 #include <cstdlib>
 #include <cstring>
 #include <fnmatch.h>
+#include <set>
+#include <time.h>
 
 namespace fawkes {
 
+/// @cond INTERNALS
+class BlackBoardNotifier::WorkerThread : public Thread
+{
+ public:
+  WorkerThread(BlackBoardNotifier *notifier)
+    : Thread("BlackBoardNotifierWorker", Thread::OPMODE_CONTINUOUS),
+      notifier_(notifier)
+  {}
+
+  virtual void run()
+  {
+    notifier_->async_dispatch_loop();
+  }
+
+ private:
+  BlackBoardNotifier *notifier_;
+};
+
+static long int
+monotonic_usec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000L + ts.tv_nsec / 1000L;
+}
+/// @endcond
+
 /** @class BlackBoardNotifier <blackboard/internal/notifier.h>
  * BlackBoard notifier.
  * This class is used by the BlackBoard to notify listeners and observers
  * of changes. 
  *
+ * By default data change events are dispatched synchronously from within
+ * Interface::write(). With set_async_dispatch() the callbacks are run by
+ * a pool of worker threads instead. Each listener is served by at most one
+ * worker at a time, and multiple changes of the same interface which occur
+ * while the listener is still busy are coalesced into a single callback.
+ * Dispatch statistics of a listener are logged when it is unregistered.
+ *
+ * Unregistering a listener waits for its running callback, such that
+ * the listener may be deleted afterwards. This holds as well if it is
+ * unregistered from the callback of another listener. Only if two
+ * listeners unregister each other concurrently from their callbacks,
+ * one of them returns without waiting, as waiting would deadlock. Such
+ * listeners must only be deleted after asynchronous dispatch has been
+ * disabled.
+ *
  * @author Tim Niemueller
  */
 
@@ -67,12 +113,23 @@ BlackBoardNotifier::BlackBoardNotifier()
 
   bbio_events_            = 0;
   bbio_mutex_             = new Mutex();
+
+  async_enabled_          = false;
+  async_stop_             = false;
+  async_mutex_            = new Mutex();
+  async_work_cond_        = new WaitCondition(async_mutex_);
+  async_done_cond_        = new WaitCondition(async_mutex_);
 }
 
 
 /** Destructor */
 BlackBoardNotifier::~BlackBoardNotifier()
 {
+  async_stop_workers();
+  delete async_work_cond_;
+  delete async_done_cond_;
+  delete async_mutex_;
+
   delete bbil_writer_mutex_;
   delete bbil_reader_mutex_;
   delete bbil_data_mutex_;
@@ -144,6 +201,12 @@ BlackBoardNotifier::update_listener(BlackBoardInterfaceListener *listener,
   }
 
   listener->bbil_release_queue(flag);
+
+  if (__atomic_load_n(&async_enabled_, __ATOMIC_ACQUIRE) &&
+      (flag & BlackBoard::BBIL_FLAG_DATA))
+  {
+    async_add_listener(listener);
+  }
 }
 
 void
@@ -210,6 +273,8 @@ BlackBoardNotifier::unregister_listener(BlackBoardInterfaceListener *listener)
   }
 
   listener->bbil_release_maps();
+
+  async_remove_listener(listener);
 }
 
 /** Add listener for specified map.
@@ -653,6 +718,8 @@ BlackBoardNotifier::process_reader_queue()
  * This also influences logging and sending data over the network so it is
  * mandatory to call this function! The interface base class write method does
  * that for you.
+ * In asynchronous mode the event is only queued for the listeners and
+ * this method returns without waiting for the callbacks.
  * @param interface interface whose subscribers to notify
  * @see Interface::write()
  * @see BlackBoardInterfaceListener::bb_interface_data_changed()
@@ -670,6 +737,11 @@ BlackBoardNotifier::notify_of_data_change(const Interface *interface)
   for (BBilMap::iterator j = ret.first; j != ret.second; ++j) {
     BlackBoardInterfaceListener *bbil = j->second;
     if (! is_in_queue(/* remove op*/ false, bbil_data_queue_, uid, bbil)) {
+      if (__atomic_load_n(&async_enabled_, __ATOMIC_ACQUIRE) &&
+	  async_queue_data_change(bbil, uid))
+      {
+	continue;
+      }
       Interface *bbil_iface = bbil->bbil_data_interface(uid);
       if (bbil_iface != NULL ) {
         bbil->bb_interface_data_changed(bbil_iface);
@@ -720,9 +792,12 @@ BlackBoardNotifier::notify_of_message_received(const Interface *interface, Messa
 
   bool enqueue = true;
 
+  // avoid constructing the lookup key if nobody listens for messages
+  std::pair<BBilMap::iterator, BBilMap::iterator> ret;
   const char *uid = interface->uid();
-  std::pair<BBilMap::iterator, BBilMap::iterator> ret =
-    bbil_messages_.equal_range(uid);
+  if (! bbil_messages_.empty()) {
+    ret = bbil_messages_.equal_range(uid);
+  }
   for (BBilMap::iterator j = ret.first; j != ret.second; ++j) {
     BlackBoardInterfaceListener *bbil = j->second;
     if (! is_in_queue(/* remove op*/ false, bbil_messages_queue_, uid, bbil)) {
@@ -762,4 +837,299 @@ BlackBoardNotifier::notify_of_message_received(const Interface *interface, Messa
   return enqueue;
 }
 
+
+/** Enable or disable asynchronous data change dispatch.
+ * If enabled, data change events are queued per listener and the
+ * listeners are called from a pool of worker threads, such that a slow
+ * listener does not stall the writer. If a listener falls behind, all
+ * changes of an interface which have not been dispatched yet are
+ * coalesced into a single call. Other events are always dispatched
+ * synchronously. Disabling dispatches pending events before returning.
+ * @param num_workers number of worker threads, 0 for synchronous dispatch
+ */
+void
+BlackBoardNotifier::set_async_dispatch(unsigned int num_workers)
+{
+  async_stop_workers();
+  if (num_workers == 0)  return;
+
+  // listeners registered before are switched to asynchronous dispatch as well
+  std::set<BlackBoardInterfaceListener *> listeners;
+  bbil_data_mutex_->lock();
+  for (BBilMap::iterator i = bbil_data_.begin(); i != bbil_data_.end(); ++i) {
+    listeners.insert(i->second);
+  }
+  bbil_data_mutex_->unlock();
+  for (std::set<BlackBoardInterfaceListener *>::iterator l = listeners.begin();
+       l != listeners.end(); ++l)
+  {
+    async_add_listener(*l);
+  }
+
+  async_mutex_->lock();
+  async_stop_ = false;
+  for (unsigned int i = 0; i < num_workers; ++i) {
+    WorkerThread *t = new WorkerThread(this);
+    async_workers_.push_back(t);
+    t->start();
+  }
+  __atomic_store_n(&async_enabled_, true, __ATOMIC_RELEASE);
+  async_mutex_->unlock();
+}
+
+
+/** Get number of asynchronous dispatch workers.
+ * @return number of worker threads, 0 if dispatching synchronously
+ */
+unsigned int
+BlackBoardNotifier::async_dispatch_workers()
+{
+  MutexLocker lock(async_mutex_);
+  return async_workers_.size();
+}
+
+
+/** Get asynchronous dispatch statistics.
+ * Use this to find listeners which cannot keep up with the data rate.
+ * @return map from listener name to dispatch statistics, empty if the
+ * notifier dispatches synchronously
+ */
+std::map<std::string, BlackBoardInterfaceListener::DispatchStats>
+BlackBoardNotifier::dispatch_stats()
+{
+  std::map<std::string, BlackBoardInterfaceListener::DispatchStats> rv;
+  MutexLocker lock(async_mutex_);
+  for (AsyncStateMap::iterator s = async_state_.begin(); s != async_state_.end(); ++s) {
+    rv[s->first->bbil_name()] = s->second->stats;
+  }
+  return rv;
+}
+
+
+void
+BlackBoardNotifier::async_stop_workers()
+{
+  async_mutex_->lock();
+  __atomic_store_n(&async_enabled_, false, __ATOMIC_RELEASE);
+  async_stop_    = true;
+  async_work_cond_->wake_all();
+  std::list<WorkerThread *> workers;
+  workers.swap(async_workers_);
+  async_mutex_->unlock();
+
+  // workers drain the queue before terminating
+  for (std::list<WorkerThread *>::iterator w = workers.begin(); w != workers.end(); ++w) {
+    (*w)->join();
+    delete *w;
+  }
+
+  async_mutex_->lock();
+  std::list<std::pair<std::string, BlackBoardInterfaceListener::DispatchStats> > stats;
+  for (AsyncStateMap::iterator s = async_state_.begin(); s != async_state_.end(); ++s) {
+    stats.push_back(std::make_pair(s->second->name, s->second->stats));
+    delete s->second;
+  }
+  async_state_.clear();
+  async_queue_.clear();
+  async_mutex_->unlock();
+
+  std::list<std::pair<std::string, BlackBoardInterfaceListener::DispatchStats> >::iterator i;
+  for (i = stats.begin(); i != stats.end(); ++i) {
+    async_log_stats(i->first.c_str(), i->second);
+  }
+}
+
+
+void
+BlackBoardNotifier::async_add_listener(BlackBoardInterfaceListener *listener)
+{
+  MutexLocker lock(async_mutex_);
+  if (async_state_.find(listener) == async_state_.end()) {
+    AsyncListenerState *state = new AsyncListenerState();
+    state->name        = listener->bbil_name();
+    state->scheduled   = false;
+    state->dispatching = false;
+    state->dispatcher  = NULL;
+    state->removed     = false;
+    memset(&state->stats, 0, sizeof(state->stats));
+    async_state_[listener] = state;
+  }
+}
+
+
+void
+BlackBoardNotifier::async_remove_listener(BlackBoardInterfaceListener *listener)
+{
+  MutexLocker lock(async_mutex_);
+  AsyncStateMap::iterator s = async_state_.find(listener);
+  if (s == async_state_.end())  return;
+
+  AsyncListenerState *state = s->second;
+  async_state_.erase(s);
+  async_queue_.remove(listener);
+
+  if (state->dispatching) {
+    // the worker deletes the state once the running callback returns
+    state->removed = true;
+
+    // A listener unregistering itself from its callback must not wait
+    // for that very callback.
+    Thread *current = Thread::current_thread_noexc();
+    if (state->dispatcher == current)  return;
+
+    // The listener may be deleted after we return, wait for the running
+    // callback. If the dispatching worker in turn waits for a callback
+    // of the current thread, e.g. two listeners unregistering each other
+    // concurrently from their callbacks, waiting would deadlock. Then
+    // return right away, such listeners may only be deleted once
+    // asynchronous dispatch has been disabled.
+    for (AsyncListenerState *s = state; s != NULL; ) {
+      std::map<Thread *, AsyncListenerState *>::iterator a =
+	async_awaiting_.find(s->dispatcher);
+      s = (a != async_awaiting_.end()) ? a->second : NULL;
+      if (s != NULL && s->dispatcher == current)  return;
+    }
+
+    if (current)  async_awaiting_[current] = state;
+    while (async_dispatching_.find(listener) != async_dispatching_.end()) {
+      async_done_cond_->wait();
+    }
+    if (current)  async_awaiting_.erase(current);
+  } else {
+    std::string name = state->name;
+    BlackBoardInterfaceListener::DispatchStats stats = state->stats;
+    delete state;
+    lock.unlock();
+    async_log_stats(name.c_str(), stats);
+  }
+}
+
+
+void
+BlackBoardNotifier::async_log_stats(const char *name,
+                                    const BlackBoardInterfaceListener::DispatchStats &stats)
+{
+  if (stats.num_dispatched == 0)  return;
+  LibLogger::log_debug("BlackBoardNotifier",
+                       "BBIL[%s] %lu events, %lu coalesced, %lu callbacks, "
+                       "max backlog %u, latency avg %lu usec max %lu usec, "
+                       "runtime avg %lu usec",
+                       name, stats.num_events, stats.num_coalesced,
+                       stats.num_dispatched, stats.max_backlog,
+                       stats.latency_total_usec / stats.num_dispatched,
+                       stats.latency_max_usec,
+                       stats.runtime_total_usec / stats.num_dispatched);
+}
+
+
+bool
+BlackBoardNotifier::async_queue_data_change(BlackBoardInterfaceListener *listener,
+                                            const char *uid)
+{
+  MutexLocker lock(async_mutex_);
+  AsyncStateMap::iterator s = async_state_.find(listener);
+  if (s == async_state_.end())  return false;
+
+  AsyncListenerState *state = s->second;
+  state->stats.num_events += 1;
+  std::pair<std::map<std::string, long int>::iterator, bool> ins =
+    state->pending.insert(std::make_pair(std::string(uid), monotonic_usec()));
+  if (! ins.second) {
+    // keep time of the oldest undispatched change for latency
+    state->stats.num_coalesced += 1;
+  } else {
+    state->stats.backlog = state->pending.size();
+    if (state->stats.backlog > state->stats.max_backlog) {
+      state->stats.max_backlog = state->stats.backlog;
+    }
+  }
+
+  if (! state->scheduled) {
+    state->scheduled = true;
+    async_queue_.push_back(listener);
+    async_work_cond_->wake_one();
+  }
+  return true;
+}
+
+
+void
+BlackBoardNotifier::async_dispatch_loop()
+{
+  async_mutex_->lock();
+  while (true) {
+    while (async_queue_.empty() && ! async_stop_) {
+      async_work_cond_->wait();
+    }
+    if (async_queue_.empty())  break;
+
+    BlackBoardInterfaceListener *listener = async_queue_.front();
+    async_queue_.pop_front();
+    AsyncStateMap::iterator s = async_state_.find(listener);
+    if (s == async_state_.end())  continue;
+
+    AsyncListenerState *state = s->second;
+    std::map<std::string, long int> pending;
+    pending.swap(state->pending);
+    state->stats.backlog = 0;
+    state->dispatching = true;
+    state->dispatcher  = Thread::current_thread_noexc();
+    async_dispatching_.insert(listener);
+    async_mutex_->unlock();
+
+    unsigned long int num_dispatched = 0;
+    unsigned long int latency_total = 0, latency_max = 0, runtime_total = 0;
+    std::map<std::string, long int>::iterator p;
+    for (p = pending.begin(); p != pending.end(); ++p) {
+      // interface may have been removed from the listener in the meantime
+      Interface *bbil_iface = listener->bbil_data_interface(p->first.c_str());
+      if (bbil_iface != NULL) {
+        long int start = monotonic_usec();
+        listener->bb_interface_data_changed(bbil_iface);
+        long int end = monotonic_usec();
+        unsigned long int latency = end - p->second;
+        num_dispatched += 1;
+        latency_total += latency;
+        runtime_total += end - start;
+        if (latency > latency_max)  latency_max = latency;
+      }
+    }
+
+    async_mutex_->lock();
+    state->dispatching = false;
+    state->dispatcher  = NULL;
+    async_dispatching_.erase(async_dispatching_.find(listener));
+    state->stats.num_dispatched     += num_dispatched;
+    state->stats.latency_total_usec += latency_total;
+    state->stats.runtime_total_usec += runtime_total;
+    if (latency_max > state->stats.latency_max_usec) {
+      state->stats.latency_max_usec = latency_max;
+    }
+    if (state->removed) {
+      // unregistered during the callback, the remover left clean up to us
+      std::map<Thread *, AsyncListenerState *>::iterator a = async_awaiting_.begin();
+      while (a != async_awaiting_.end()) {
+	if (a->second == state)  async_awaiting_.erase(a++);
+	else                     ++a;
+      }
+      std::string name = state->name;
+      BlackBoardInterfaceListener::DispatchStats stats = state->stats;
+      delete state;
+      async_done_cond_->wake_all();
+      async_mutex_->unlock();
+      async_log_stats(name.c_str(), stats);
+      async_mutex_->lock();
+    } else {
+      if (state->pending.empty()) {
+        state->scheduled = false;
+      } else {
+        async_queue_.push_back(listener);
+        async_work_cond_->wake_one();
+      }
+      async_done_cond_->wake_all();
+    }
+  }
+  async_mutex_->unlock();
+}
+
 } // end namespace fawkes
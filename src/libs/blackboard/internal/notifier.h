@@ -31,6 +31,8 @@
 #include <core/utils/rwlock_map.h>
 
 #include <list>
+#include <map>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -39,6 +41,8 @@ namespace fawkes {
 class Interface;
 class Message;
 class Mutex;
+class WaitCondition;
+class Thread;
 
 class BlackBoardNotifier
 {
@@ -68,7 +72,14 @@ class BlackBoardNotifier
   void notify_of_reader_removed(const Interface *interface,
 				unsigned int event_instance_serial) throw();
 
+  void set_async_dispatch(unsigned int num_workers);
+  unsigned int async_dispatch_workers();
+  std::map<std::string, BlackBoardInterfaceListener::DispatchStats>
+    dispatch_stats();
+
  private:
+  class WorkerThread;
+
   /// @cond INTERNALS
   typedef struct {
     bool                           op;
@@ -79,6 +90,19 @@ class BlackBoardNotifier
   /// @endcond INTERNALS
   typedef std::list< BBilQueueEntry > BBilQueue;
 
+  /// @cond INTERNALS
+  typedef struct {
+    std::string                                 name;
+    std::map<std::string, long int>             pending;
+    bool                                        scheduled;
+    bool                                        dispatching;
+    Thread                                    * dispatcher;
+    bool                                        removed;
+    BlackBoardInterfaceListener::DispatchStats  stats;
+  } AsyncListenerState;
+  /// @endcond INTERNALS
+  typedef std::map<BlackBoardInterfaceListener *, AsyncListenerState *> AsyncStateMap;
+
   typedef std::multimap<std::string, BlackBoardInterfaceListener *> BBilMap;
   typedef std::pair<BlackBoardInterfaceObserver *, std::list<std::string> > BBioPair;
   typedef std::list< BBioPair>                  BBioList;
@@ -122,6 +146,14 @@ class BlackBoardNotifier
   bool is_in_queue(bool op, BBilQueue &queue, const char *uid,
                    BlackBoardInterfaceListener *bbil);
 
+  void async_add_listener(BlackBoardInterfaceListener *listener);
+  void async_remove_listener(BlackBoardInterfaceListener *listener);
+  bool async_queue_data_change(BlackBoardInterfaceListener *listener, const char *uid);
+  void async_dispatch_loop();
+  void async_stop_workers();
+  void async_log_stats(const char *name,
+                       const BlackBoardInterfaceListener::DispatchStats &stats);
+
   BBilMap bbil_data_;
   BBilMap bbil_reader_;
   BBilMap bbil_writer_;
@@ -153,6 +185,16 @@ class BlackBoardNotifier
   unsigned int    bbio_events_;
   BBioQueue       bbio_queue_;
 
+  Mutex          *async_mutex_;
+  WaitCondition  *async_work_cond_;
+  WaitCondition  *async_done_cond_;
+  bool            async_enabled_;
+  bool            async_stop_;
+  std::list<BlackBoardInterfaceListener *>  async_queue_;
+  AsyncStateMap                             async_state_;
+  std::multiset<BlackBoardInterfaceListener *> async_dispatching_;
+  std::map<Thread *, AsyncListenerState *>  async_awaiting_;
+  std::list<WorkerThread *>                 async_workers_;
 };
 
 } // end namespace fawkes
@@ -52,11 +52,15 @@ namespace fawkes {
  * @param memsize size of memory in bytes
  * @param magic_token magic token used for shared memory segment
  * @param master true to operate in master mode, false otherwise
+ * @param size_classes true to manage the memory in size classes, see
+ * BlackBoardMemoryManager
  */
 LocalBlackBoard::LocalBlackBoard(size_t memsize,
-				 const char *magic_token, bool master)
+				 const char *magic_token, bool master,
+				 bool size_classes)
 {
-  memmgr_ = new BlackBoardMemoryManager(memsize, BLACKBOARD_VERSION, master);
+  memmgr_ = new BlackBoardMemoryManager(memsize, BLACKBOARD_VERSION, master,
+					magic_token, size_classes);
 
   msgmgr_ = new BlackBoardMessageManager(notifier_);
   im_ = new BlackBoardInterfaceManager(memmgr_, msgmgr_, notifier_);
@@ -69,10 +73,12 @@ LocalBlackBoard::LocalBlackBoard(size_t memsize,
 
 /** Heap Memory Constructor.
  * @param memsize size of memory in bytes
+ * @param size_classes true to manage the memory in size classes, see
+ * BlackBoardMemoryManager
  */
-LocalBlackBoard::LocalBlackBoard(size_t memsize)
+LocalBlackBoard::LocalBlackBoard(size_t memsize, bool size_classes)
 {
-  memmgr_ = new BlackBoardMemoryManager(memsize);
+  memmgr_ = new BlackBoardMemoryManager(memsize, size_classes);
 
   msgmgr_ = new BlackBoardMessageManager(notifier_);
   im_ = new BlackBoardInterfaceManager(memmgr_, msgmgr_, notifier_);
@@ -167,6 +173,53 @@ LocalBlackBoard::try_aliveness_restore() throw()
 }
 
 
+/** Set size of interface history.
+ * Configure the number of past states kept in shared memory for
+ * interfaces matching the given patterns. This only affects
+ * interfaces created after the call. Readers can access the history
+ * with Interface::read_history() and Interface::read_history_since().
+ * @param type_pattern pattern of interface types, supports wildcards
+ * similar to filenames (*, ?, []), see "man fnmatch" for all supported.
+ * @param id_pattern pattern of interface IDs, supports wildcards similar
+ * to filenames (*, ?, []), see "man fnmatch" for all supported.
+ * @param slots number of states to keep, 0 to disable the history
+ */
+void
+LocalBlackBoard::set_history_size(const char *type_pattern, const char *id_pattern,
+				  unsigned int slots)
+{
+  im_->set_history_size(type_pattern, id_pattern, slots);
+}
+
+
+/** Enable asynchronous data change notification.
+ * Listener callbacks for data changes are run by a pool of worker
+ * threads instead of from within Interface::write() of the writer.
+ * Changes of the same interface are coalesced if a listener falls
+ * behind. Unregistering a listener waits for its running callback,
+ * see BlackBoardNotifier for the exception of listeners unregistering
+ * each other concurrently from their callbacks.
+ * @param num_workers number of notification worker threads, 0 to
+ * notify synchronously (default)
+ */
+void
+LocalBlackBoard::set_async_notification(unsigned int num_workers)
+{
+  notifier_->set_async_dispatch(num_workers);
+}
+
+
+/** Get dispatch statistics of interface listeners.
+ * Statistics are only collected for asynchronous notification.
+ * @return map from listener name to statistics
+ */
+std::map<std::string, BlackBoardInterfaceListener::DispatchStats>
+LocalBlackBoard::listener_dispatch_stats()
+{
+  return notifier_->dispatch_stats();
+}
+
+
 /** Cleanup orphaned BlackBoard segments.
  * This erase orphaned shared memory segments that belonged to a
  * BlackBoard.
@@ -24,9 +24,12 @@
 #define _BLACKBOARD_LOCAL_H_
 
 #include <blackboard/blackboard.h>
+#include <blackboard/interface_listener.h>
 #include <core/exceptions/software.h>
 
 #include <list>
+#include <map>
+#include <string>
 
 namespace fawkes {
 
@@ -44,9 +47,9 @@ class FawkesNetworkHub;
 class LocalBlackBoard : public BlackBoard
 {
  public:
-  LocalBlackBoard(size_t memsize);
+  LocalBlackBoard(size_t memsize, bool size_classes = false);
   LocalBlackBoard(size_t memsize, const char *magic_token,
-		  bool master = true);
+		  bool master = true, bool size_classes = false);
   virtual ~LocalBlackBoard();
 
   virtual Interface *  open_for_reading(const char *interface_type,
@@ -70,6 +73,13 @@ class LocalBlackBoard : public BlackBoard
 
   virtual void start_nethandler(FawkesNetworkHub *hub);
 
+  void set_history_size(const char *type_pattern, const char *id_pattern,
+			unsigned int slots);
+
+  void set_async_notification(unsigned int num_workers);
+  std::map<std::string, BlackBoardInterfaceListener::DispatchStats>
+    listener_dispatch_stats();
+
   static void cleanup(const char *magic_token, bool use_lister = false);
 
   /* for debugging only */
@@ -0,0 +1,251 @@
+
+/***************************************************************************
+ *  delta.cpp - BlackBoard network data delta encoding
+ *
+ *  Created: Fri Oct 16 14:21:07 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <blackboard/net/delta.h>
+#include <blackboard/net/messages.h>
+
+#include <interface/interface.h>
+#include <interface/field_iterator.h>
+#include <core/exception.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+
+namespace fawkes {
+
+/** @class BlackBoardDataDelta <blackboard/net/delta.h>
+ * Delta encoding of interface data for network transmission.
+ * The data chunk of an interface is split into units along the interface
+ * fields, with every element of an array field being a unit of its own.
+ * Strings, the timestamp and any padding are treated as a single unit.
+ * A delta contains all units which differ from the base, i.e. the data
+ * last encoded, merged into ranges. Ranges which are only separated by
+ * a few unchanged bytes are merged if that is cheaper than sending
+ * another range header.
+ *
+ * The network connection is a reliable ordered stream, therefore the
+ * last data sent is what the receiver has and serves as the base for
+ * the next delta.
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param interface interface to encode data for, determines the field layout
+ */
+BlackBoardDataDelta::BlackBoardDataDelta(Interface *interface)
+{
+  data_size_ = interface->datasize();
+  base_      = (char *)calloc(1, data_size_);
+  has_base_  = false;
+
+  std::vector<std::pair<size_t, size_t> > fields;
+  const char *data = (const char *)interface->datachunk();
+  InterfaceFieldIterator f;
+  for (f = interface->fields(); f != interface->fields_end(); ++f) {
+    size_t offset = (const char *)f.get_value() - data;
+    size_t elsize;
+    switch (f.get_type()) {
+    case IFT_BOOL:   elsize = sizeof(bool);     break;
+    case IFT_INT8:
+    case IFT_UINT8:
+    case IFT_BYTE:   elsize = 1;                break;
+    case IFT_INT16:
+    case IFT_UINT16: elsize = 2;                break;
+    case IFT_INT32:
+    case IFT_UINT32:
+    case IFT_FLOAT:
+    case IFT_ENUM:   elsize = 4;                break;
+    case IFT_INT64:
+    case IFT_UINT64:
+    case IFT_DOUBLE: elsize = 8;                break;
+    default:         elsize = f.get_length();   break;
+    }
+    size_t num = (f.get_type() == IFT_STRING) ? 1 : f.get_length();
+    for (size_t i = 0; i < num; ++i) {
+      fields.push_back(std::make_pair(offset + i * elsize, elsize));
+    }
+  }
+  std::sort(fields.begin(), fields.end());
+
+  // fill gaps (timestamp, padding) so that the whole chunk is covered
+  size_t pos = 0;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].first < pos || fields[i].first + fields[i].second > data_size_) {
+      continue;
+    }
+    if (fields[i].first > pos) {
+      units_.push_back(std::make_pair(pos, fields[i].first - pos));
+    }
+    units_.push_back(fields[i]);
+    pos = fields[i].first + fields[i].second;
+  }
+  if (pos < data_size_) {
+    units_.push_back(std::make_pair(pos, data_size_ - pos));
+  }
+}
+
+
+/** Destructor. */
+BlackBoardDataDelta::~BlackBoardDataDelta()
+{
+  free(base_);
+}
+
+
+/** Set the base for the next delta.
+ * Call this with the data the receiver has, e.g. the data sent with
+ * the open success message.
+ * @param data data chunk of the interface
+ */
+void
+BlackBoardDataDelta::set_base(const void *data)
+{
+  memcpy(base_, data, data_size_);
+  has_base_ = true;
+}
+
+
+/** Check if base has been set.
+ * @return true if set_base() has been called, false otherwise
+ */
+bool
+BlackBoardDataDelta::has_base() const
+{
+  return has_base_;
+}
+
+
+/** Encode delta message.
+ * The delta contains all changes of the given data compared to the
+ * base, which is updated to the given data afterwards. A delta with
+ * zero ranges is created if the data did not change.
+ * @param serial instance serial to put into the message
+ * @param data current data chunk of the interface
+ * @param payload_size upon return contains the size of the payload
+ * @return payload of a MSG_BB_DATA_DELTA message allocated with malloc,
+ * ownership is passed to the caller
+ */
+void *
+BlackBoardDataDelta::encode(unsigned int serial, const void *data, size_t &payload_size)
+{
+  const char *d = (const char *)data;
+
+  // determine changed ranges
+  std::vector<std::pair<size_t, size_t> > ranges;
+  for (size_t i = 0; i < units_.size(); ++i) {
+    size_t offset = units_[i].first;
+    size_t length = units_[i].second;
+    if (memcmp(base_ + offset, d + offset, length) == 0)  continue;
+
+    if (! ranges.empty() &&
+	(offset - (ranges.back().first + ranges.back().second) <= sizeof(bb_idelta_range_t)))
+    {
+      ranges.back().second = offset + length - ranges.back().first;
+    } else {
+      ranges.push_back(std::make_pair(offset, length));
+    }
+  }
+
+  payload_size = sizeof(bb_idelta_msg_t);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    payload_size += sizeof(bb_idelta_range_t) + ranges[i].second;
+  }
+
+  void *payload = malloc(payload_size);
+  bb_idelta_msg_t *dm = (bb_idelta_msg_t *)payload;
+  dm->serial     = htonl(serial);
+  dm->data_size  = htonl(data_size_);
+  dm->num_ranges = htonl(ranges.size());
+
+  char *p = (char *)payload + sizeof(bb_idelta_msg_t);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    bb_idelta_range_t r;
+    r.offset = htonl(ranges[i].first);
+    r.length = htonl(ranges[i].second);
+    memcpy(p, &r, sizeof(bb_idelta_range_t));
+    p += sizeof(bb_idelta_range_t);
+    memcpy(p, d + ranges[i].first, ranges[i].second);
+    memcpy(base_ + ranges[i].first, d + ranges[i].first, ranges[i].second);
+    p += ranges[i].second;
+  }
+  has_base_ = true;
+
+  return payload;
+}
+
+
+/** Apply delta to data.
+ * @param data data chunk to modify
+ * @param data_size size of data chunk
+ * @param payload payload of a MSG_BB_DATA_DELTA message
+ * @param payload_size size of payload
+ * @exception Exception thrown if the message is malformed or does not
+ * match the data size, in that case the data is not modified
+ */
+void
+BlackBoardDataDelta::apply(void *data, size_t data_size,
+			   const void *payload, size_t payload_size)
+{
+  if (payload_size < sizeof(bb_idelta_msg_t)) {
+    throw Exception("Delta message too short");
+  }
+  const bb_idelta_msg_t *dm = (const bb_idelta_msg_t *)payload;
+  if (ntohl(dm->data_size) != data_size) {
+    throw Exception("Delta data size mismatch, expected %zu, but got %u",
+		    data_size, ntohl(dm->data_size));
+  }
+
+  // validate completely before modifying anything
+  unsigned int num_ranges = ntohl(dm->num_ranges);
+  const char *start = (const char *)payload + sizeof(bb_idelta_msg_t);
+  const char *end   = (const char *)payload + payload_size;
+  const char *p = start;
+  for (unsigned int i = 0; i < num_ranges; ++i) {
+    bb_idelta_range_t r;
+    if ((size_t)(end - p) < sizeof(bb_idelta_range_t)) {
+      throw Exception("Delta message truncated");
+    }
+    memcpy(&r, p, sizeof(bb_idelta_range_t));
+    size_t offset = ntohl(r.offset), length = ntohl(r.length);
+    p += sizeof(bb_idelta_range_t);
+    if ((offset > data_size) || (length > data_size - offset) ||
+	((size_t)(end - p) < length))
+    {
+      throw Exception("Delta range %u out of bounds", i);
+    }
+    p += length;
+  }
+
+  p = start;
+  for (unsigned int i = 0; i < num_ranges; ++i) {
+    bb_idelta_range_t r;
+    memcpy(&r, p, sizeof(bb_idelta_range_t));
+    p += sizeof(bb_idelta_range_t);
+    memcpy((char *)data + ntohl(r.offset), p, ntohl(r.length));
+    p += ntohl(r.length);
+  }
+}
+
+} // end namespace fawkes
@@ -0,0 +1,57 @@
+
+/***************************************************************************
+ *  delta.h - BlackBoard network data delta encoding
+ *
+ *  Created: Fri Oct 16 14:21:07 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _BLACKBOARD_NET_DELTA_H_
+#define _BLACKBOARD_NET_DELTA_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace fawkes {
+
+class Interface;
+
+class BlackBoardDataDelta
+{
+ public:
+  BlackBoardDataDelta(Interface *interface);
+  ~BlackBoardDataDelta();
+
+  void   set_base(const void *data);
+  bool   has_base() const;
+  void * encode(unsigned int serial, const void *data, size_t &payload_size);
+
+  static void apply(void *data, size_t data_size,
+		    const void *payload, size_t payload_size);
+
+ private:
+  std::vector<std::pair<size_t, size_t> >  units_;
+  size_t  data_size_;
+  char   *base_;
+  bool    has_base_;
+};
+
+} // end namespace fawkes
+
+#endif
@@ -28,10 +28,12 @@
 #include <blackboard/exceptions.h>
 #include <blackboard/net/interface_listener.h>
 #include <blackboard/net/interface_observer.h>
+#include <blackboard/net/delta.h>
 
 #include <interface/interface.h>
 #include <interface/interface_info.h>
 
+#include <core/threading/mutex_locker.h>
 #include <logging/liblogger.h>
 #include <netcomm/fawkes/component_ids.h>
 #include <netcomm/fawkes/hub.h>
@@ -47,6 +49,12 @@ namespace fawkes {
  * This class provides a network handler that can be registered with the
  * FawkesServerThread to handle client requests to a BlackBoard instance.
  *
+ * Clients may request optional protocol features with
+ * MSG_BB_FEATURES_REQUEST. If BB_FEATURE_DELTA has been negotiated, data
+ * changes are sent as MSG_BB_DATA_DELTA from this thread, coalescing all
+ * changes of an interface since the last loop, and the client may send
+ * its writes as deltas as well.
+ *
  * @author Tim Niemueller
  */
 
@@ -145,6 +153,27 @@ BlackBoardNetworkHandler::loop()
       }
       break;
 
+    case MSG_BB_FEATURES_REQUEST:
+      {
+	bb_features_msg_t *fm = msg->msg<bb_features_msg_t>();
+	unsigned int features = ntohl(fm->features) & BB_FEATURES_SUPPORTED;
+	client_features_.lock();
+	client_features_[clid] = features;
+	client_features_.unlock();
+
+	bb_features_msg_t *rm = (bb_features_msg_t *)malloc(sizeof(bb_features_msg_t));
+	rm->features = htonl(features);
+	try {
+	  nhub_->send(clid, FAWKES_CID_BLACKBOARD, MSG_BB_FEATURES,
+		      rm, sizeof(bb_features_msg_t));
+	} catch (Exception &e) {
+	  LibLogger::log_error("BlackBoardNetworkHandler", "Failed to send "
+			       "features to %u, exception follows", clid);
+	  LibLogger::log_error("BlackBoardNetworkHandler", e);
+	}
+      }
+      break;
+
     case MSG_BB_OPEN_FOR_READING:
     case MSG_BB_OPEN_FOR_WRITING:
       {
@@ -172,14 +201,25 @@ BlackBoardNetworkHandler::loop()
 				"hash mismatch", type, id);
 	    send_openfailure(clid, BB_ERR_HASH_MISMATCH);
 	  } else {
+	    bool delta = false;
+	    client_features_.lock();
+	    if (client_features_.find(clid) != client_features_.end()) {
+	      delta = client_features_[clid] & BB_FEATURE_DELTA;
+	    }
+	    client_features_.unlock();
+
 	    interfaces_[iface->serial()] = iface;
 	    client_interfaces_[clid].push_back(iface);
 	    serial_to_clid_[iface->serial()] = clid;
-	    listeners_[iface->serial()] = new BlackBoardNetHandlerInterfaceListener(bb_,
-										     iface,
-										     nhub_,
-										     clid);
+	    BlackBoardNetHandlerInterfaceListener *listener =
+	      new BlackBoardNetHandlerInterfaceListener(bb_, iface, nhub_, clid,
+							delta ? this : NULL);
+	    listeners_.lock();
+	    listeners_[iface->serial()] = listener;
+	    listeners_.unlock();
 	    send_opensuccess(clid, iface);
+	    // the client now has the data sent with the open success
+	    listener->set_delta_base(iface->datachunk());
 	  }
 	} catch (BlackBoardInterfaceNotFoundException &nfe) {
 	  LibLogger::log_warn("BlackBoardNetworkHandler", "Opening interface %s::%s failed, "
@@ -230,8 +270,10 @@ BlackBoardNetworkHandler::loop()
 	    interfaces_.lock();
 	    LibLogger::log_debug("BlackBoardNetworkHandler", "Remote %u closing interface %s",
 				 clid, interfaces_[sm_serial]->uid());
+	    listeners_.lock();
 	    delete listeners_[sm_serial];
 	    listeners_.erase(sm_serial);
+	    listeners_.unlock();
 	    bb_->close(interfaces_[sm_serial]);
 	    interfaces_.erase(sm_serial);
 	    interfaces_.unlock();
@@ -274,6 +316,41 @@ BlackBoardNetworkHandler::loop()
       }
       break;
 
+    case MSG_BB_DATA_DELTA:
+      {
+	if ( msg->payload_size() < sizeof(bb_idelta_msg_t) ) {
+	  LibLogger::log_error("BlackBoardNetworkHandler", "DATA_DELTA: Message too "
+			       "short (%zu bytes), ignoring.", msg->payload_size());
+	  break;
+	}
+	void *payload = msg->payload();
+	bb_idelta_msg_t *dm = (bb_idelta_msg_t *)payload;
+	unsigned int dm_serial = ntohl(dm->serial);
+	interfaces_.lock();
+	if ( interfaces_.find(dm_serial) != interfaces_.end() ) {
+	  Interface *iface = interfaces_[dm_serial];
+	  // the writer's buffer holds the data last sent by the client
+	  void *data = malloc(iface->datasize());
+	  memcpy(data, iface->datachunk(), iface->datasize());
+	  try {
+	    BlackBoardDataDelta::apply(data, iface->datasize(),
+				       payload, msg->payload_size());
+	    iface->set_from_chunk(data);
+	    iface->write();
+	  } catch (Exception &e) {
+	    LibLogger::log_error("BlackBoardNetworkHandler", "DATA_DELTA: Invalid "
+				 "delta for %s, ignoring.", iface->uid());
+	    LibLogger::log_error("BlackBoardNetworkHandler", e);
+	  }
+	  free(data);
+	} else {
+	  LibLogger::log_error("BlackBoardNetworkHandler", "DATA_DELTA: Interface with "
+			       "serial %u not found, ignoring.", dm_serial);
+	}
+	interfaces_.unlock();
+      }
+      break;
+
     case MSG_BB_INTERFACE_MESSAGE:
       {
 	void *payload = msg->payload();
@@ -322,6 +399,19 @@ BlackBoardNetworkHandler::loop()
     msg->unref();
     inbound_queue_.pop_locked();
   }
+
+  send_pending_deltas();
+}
+
+
+/** Send coalesced data changes to clients using delta updates. */
+void
+BlackBoardNetworkHandler::send_pending_deltas()
+{
+  MutexLocker lock(listeners_.mutex());
+  for (lit_ = listeners_.begin(); lit_ != listeners_.end(); ++lit_) {
+    lit_->second->send_pending_delta();
+  }
 }
 
 
@@ -420,13 +510,16 @@ BlackBoardNetworkHandler::client_disconnected(unsigned int clid)
       unsigned int serial = (*ciit_)->serial();
       serial_to_clid_.erase(serial);
       interfaces_.erase_locked(serial);
+      listeners_.lock();
       delete listeners_[serial];
       listeners_.erase(serial);
+      listeners_.unlock();
       bb_->close(*ciit_);
     }
     client_interfaces_.erase(clid);
   }
   client_interfaces_.unlock();
+  client_features_.erase_locked(clid);
 }
 
 } // end namespace fawkes
@@ -60,6 +60,7 @@ class BlackBoardNetworkHandler
  private:
   void send_opensuccess(unsigned int clid, Interface *interface);
   void send_openfailure(unsigned int clid, unsigned int error_code);
+  void send_pending_deltas();
 
 
   BlackBoard *bb_;
@@ -69,8 +70,11 @@ class BlackBoardNetworkHandler
   LockMap< unsigned int, Interface * > interfaces_;
   LockMap< unsigned int, Interface * >::iterator iit_;
 
-  std::map<unsigned int, BlackBoardNetHandlerInterfaceListener *>  listeners_;
-  std::map<unsigned int, BlackBoardNetHandlerInterfaceListener *>::iterator  lit_;
+  LockMap<unsigned int, BlackBoardNetHandlerInterfaceListener *>  listeners_;
+  LockMap<unsigned int, BlackBoardNetHandlerInterfaceListener *>::iterator  lit_;
+
+  // Negotiated protocol features per client, key is the client ID
+  LockMap<unsigned int, unsigned int> client_features_;
 
   BlackBoardNetHandlerInterfaceObserver *observer_;
 
@@ -147,10 +147,9 @@ BlackBoardInterfaceListContent::append_interface(InterfaceInfo &iinfo)
 void
 BlackBoardInterfaceListContent::serialize()
 {
-  _payload_size = sizeof(msg) + interface_list->buffer_size();
-  _payload = malloc(_payload_size);
-  copy_payload(0, &msg, sizeof(msg));
-  copy_payload(sizeof(msg), interface_list->buffer(), interface_list->buffer_size());
+  clear_segments();
+  add_segment(&msg, sizeof(msg));
+  add_segment(interface_list->buffer(), interface_list->buffer_size());
 }
 
 
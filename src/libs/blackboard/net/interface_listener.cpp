@@ -23,9 +23,13 @@
 
 #include <blackboard/net/interface_listener.h>
 #include <blackboard/net/messages.h>
+#include <blackboard/net/delta.h>
 
 #include <blackboard/blackboard.h>
 #include <interface/interface.h>
+#include <core/threading/thread.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
 
 #include <netcomm/fawkes/hub.h>
 #include <netcomm/fawkes/message.h>
@@ -43,6 +47,11 @@ namespace fawkes {
  * Interface listener for network handler.
  * This class is used by the BlackBoardNetworkHandler to track interface changes and
  * send out notifications timely.
+ *
+ * If the client negotiated BB_FEATURE_DELTA a data change only marks the
+ * interface as changed and wakes up the sending thread, which then calls
+ * send_pending_delta(). All changes in between are therefore coalesced into
+ * a single delta against the previously sent data.
  * @author Tim Niemueller
  */
 
@@ -51,13 +60,22 @@ namespace fawkes {
  * @param interface interface to care about
  * @param hub Fawkes network hub to use to send messages
  * @param clid client ID of the client which opened this interface
+ * @param delta_sender if not NULL, data changes are sent as deltas, this
+ * thread is woken up to call send_pending_delta() once data changed. No
+ * data is sent before set_delta_base() has been called.
  */
 BlackBoardNetHandlerInterfaceListener::BlackBoardNetHandlerInterfaceListener(BlackBoard *blackboard,
 									     Interface *interface,
 									     FawkesNetworkHub *hub,
-									     unsigned int clid)
+									     unsigned int clid,
+									     Thread *delta_sender)
   : BlackBoardInterfaceListener("NetIL/%s", interface->uid())
 {
+  delta_          = delta_sender ? new BlackBoardDataDelta(interface) : NULL;
+  delta_sender_   = delta_sender;
+  delta_mutex_    = new Mutex();
+  delta_pending_  = false;
+
   bbil_add_data_interface(interface);
   bbil_add_reader_interface(interface);
   bbil_add_writer_interface(interface);
@@ -78,12 +96,64 @@ BlackBoardNetHandlerInterfaceListener::BlackBoardNetHandlerInterfaceListener(Bla
 BlackBoardNetHandlerInterfaceListener::~BlackBoardNetHandlerInterfaceListener()
 {
   blackboard_->unregister_listener(this);
+  delete delta_;
+  delete delta_mutex_;
+}
+
+
+/** Set base for delta encoding.
+ * @param data data the client has received with the open success message
+ */
+void
+BlackBoardNetHandlerInterfaceListener::set_delta_base(const void *data)
+{
+  MutexLocker lock(delta_mutex_);
+  if (delta_)  delta_->set_base(data);
+}
+
+
+/** Send pending data changes.
+ * If the interface changed since the last call, read the current data
+ * and send the difference to the data sent last. This must be called by
+ * the thread passed to the constructor.
+ */
+void
+BlackBoardNetHandlerInterfaceListener::send_pending_delta()
+{
+  delta_mutex_->lock();
+  if (! delta_ || ! delta_pending_ || ! delta_->has_base()) {
+    delta_mutex_->unlock();
+    return;
+  }
+  delta_pending_ = false;
+  delta_mutex_->unlock();
+
+  interface_->read();
+
+  size_t payload_size;
+  void *payload = delta_->encode(interface_->serial(), interface_->datachunk(),
+				 payload_size);
+  try {
+    fnh_->send(clid_, FAWKES_CID_BLACKBOARD, MSG_BB_DATA_DELTA, payload, payload_size);
+  } catch (Exception &e) {
+    LibLogger::log_warn(bbil_name(), "Failed to send BlackBoard data delta, exception follows");
+    LibLogger::log_warn(bbil_name(), e);
+  }
 }
 
 
 void
 BlackBoardNetHandlerInterfaceListener::bb_interface_data_changed(Interface *interface) throw()
 {
+  if (delta_) {
+    // coalesce, sent by the delta sender thread
+    delta_mutex_->lock();
+    delta_pending_ = true;
+    delta_mutex_->unlock();
+    delta_sender_->wakeup();
+    return;
+  }
+
   // send out data changed notification
   interface->read();
 
@@ -30,15 +30,22 @@ namespace fawkes {
 
 class FawkesNetworkHub;
 class BlackBoard;
+class BlackBoardDataDelta;
+class Mutex;
+class Thread;
 
 class BlackBoardNetHandlerInterfaceListener
 : public BlackBoardInterfaceListener
 {
  public:
   BlackBoardNetHandlerInterfaceListener(BlackBoard *blackboard, Interface *interface,
-					FawkesNetworkHub *hub, unsigned int clid);
+					FawkesNetworkHub *hub, unsigned int clid,
+					Thread *delta_sender = NULL);
   virtual ~BlackBoardNetHandlerInterfaceListener();
 
+  void set_delta_base(const void *data);
+  void send_pending_delta();
+
   virtual void bb_interface_data_changed(Interface *interface) throw();
   virtual bool bb_interface_message_received(Interface *interface, Message *message) throw();
   virtual void bb_interface_writer_added(Interface *interface,
@@ -58,6 +65,11 @@ class BlackBoardNetHandlerInterfaceListener
   FawkesNetworkHub *fnh_;
 
   unsigned int      clid_;
+
+  BlackBoardDataDelta *delta_;
+  Thread              *delta_sender_;
+  Mutex               *delta_mutex_;
+  bool                 delta_pending_;
 };
 
 } // end namespace fawkes
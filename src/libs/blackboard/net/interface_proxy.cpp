@@ -24,10 +24,13 @@
 #include <blackboard/net/interface_proxy.h>
 #include <blackboard/internal/instance_factory.h>
 #include <blackboard/net/messages.h>
+#include <blackboard/net/delta.h>
 #include <blackboard/internal/interface_mem_header.h>
 #include <blackboard/internal/notifier.h>
 
 #include <core/threading/refc_rwlock.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
 #include <logging/liblogger.h>
 #include <netcomm/fawkes/client.h>
 #include <netcomm/fawkes/message.h>
@@ -74,6 +77,8 @@ BlackBoardInterfaceProxy::BlackBoardInterfaceProxy(FawkesNetworkClient *client,
   data_size_       = ntohl(osm->data_size);
   clid_            = msg->clid();
   next_msg_id_     = 1;
+  delta_           = NULL;
+  delta_mutex_     = new Mutex();
 
   if ( interface->datasize() != data_size_ ) {
     // Boom, sizes do not match
@@ -104,10 +109,34 @@ BlackBoardInterfaceProxy::BlackBoardInterfaceProxy(FawkesNetworkClient *client,
 /** Destructor. */
 BlackBoardInterfaceProxy::~BlackBoardInterfaceProxy()
 {
+  delete delta_;
+  delete delta_mutex_;
   free(mem_chunk_);
 }
 
 
+/** Enable or disable delta updates.
+ * If enabled, writes are sent as MSG_BB_DATA_DELTA. Only enable this if
+ * BB_FEATURE_DELTA has been negotiated with the remote BlackBoard.
+ * This may be called from the inbound thread while a writer is sending
+ * data, the delta encoder is guarded by a mutex.
+ * @param delta true to send deltas, false to send the full data
+ */
+void
+BlackBoardInterfaceProxy::set_delta_mode(bool delta)
+{
+  MutexLocker lock(delta_mutex_);
+  if (delta && ! delta_) {
+    delta_ = new BlackBoardDataDelta(interface_);
+    // the remote writer instance has the data last sent or received on open
+    delta_->set_base(data_chunk_);
+  } else if (! delta && delta_) {
+    delete delta_;
+    delta_ = NULL;
+  }
+}
+
+
 /** Process MSG_BB_DATA_CHANGED message.
  * @param msg message to process.
  */
@@ -140,6 +169,44 @@ BlackBoardInterfaceProxy::process_data_changed(FawkesNetworkMessage *msg)
 }
 
 
+/** Process MSG_BB_DATA_DELTA message.
+ * @param msg message to process.
+ */
+void
+BlackBoardInterfaceProxy::process_data_delta(FawkesNetworkMessage *msg)
+{
+  if ( msg->msgid() != MSG_BB_DATA_DELTA ) {
+    LibLogger::log_error("BlackBoardInterfaceProxy", "Expected data delta BB message, but "
+			 "received message of type %u, ignoring.", msg->msgid());
+    return;
+  }
+
+  if ( msg->payload_size() < sizeof(bb_idelta_msg_t) ) {
+    LibLogger::log_error("BlackBoardInterfaceProxy", "Data delta message too short "
+			 "(%zu bytes), ignoring.", msg->payload_size());
+    return;
+  }
+
+  bb_idelta_msg_t *dm = (bb_idelta_msg_t *)msg->payload();
+  if ( ntohl(dm->serial) != instance_serial_ ) {
+    LibLogger::log_error("BlackBoardInterfaceProxy", "Serial mismatch, expected %u, "
+			 "but got %u, ignoring.", instance_serial_, ntohl(dm->serial));
+    return;
+  }
+
+  try {
+    BlackBoardDataDelta::apply(data_chunk_, data_size_, msg->payload(), msg->payload_size());
+  } catch (Exception &e) {
+    LibLogger::log_error("BlackBoardInterfaceProxy", "Invalid data delta for %s, ignoring",
+			 interface_->uid());
+    LibLogger::log_error("BlackBoardInterfaceProxy", e);
+    return;
+  }
+
+  notifier_->notify_of_data_change(interface_);
+}
+
+
 /** Process MSG_BB_INTERFACE message.
  * @param msg message to process.
  */
@@ -298,6 +365,20 @@ BlackBoardInterfaceProxy::writer(const Interface *interface) const
 void
 BlackBoardInterfaceProxy::notify_of_data_change(const Interface *interface)
 {
+  MutexLocker lock(delta_mutex_);
+  if (delta_) {
+    // enqueue while locked, the base must match the order of messages
+    size_t payload_size;
+    void *payload = delta_->encode(interface->serial(), interface->datachunk(),
+				   payload_size);
+    FawkesNetworkMessage *omsg = new FawkesNetworkMessage(clid_, FAWKES_CID_BLACKBOARD,
+							  MSG_BB_DATA_DELTA,
+							  payload, payload_size);
+    fnc_->enqueue(omsg);
+    return;
+  }
+  lock.unlock();
+
   // need to send write message
   size_t payload_size = sizeof(bb_idata_msg_t) + interface->datasize();
   void *payload = malloc(payload_size);
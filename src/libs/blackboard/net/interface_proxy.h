@@ -33,7 +33,9 @@ namespace fawkes {
 class FawkesNetworkClient;
 class FawkesNetworkMessage;
 class RefCountRWLock;
+class Mutex;
 class BlackBoardNotifier;
+class BlackBoardDataDelta;
 class Interface;
 
 class BlackBoardInterfaceProxy
@@ -47,6 +49,8 @@ class BlackBoardInterfaceProxy
   ~BlackBoardInterfaceProxy();
 
   void process_data_changed(FawkesNetworkMessage *msg);
+  void process_data_delta(FawkesNetworkMessage *msg);
+  void set_delta_mode(bool delta);
   void process_interface_message(FawkesNetworkMessage *msg);
   void reader_added(unsigned int event_serial);
   void reader_removed(unsigned int event_serial);
@@ -89,6 +93,9 @@ class BlackBoardInterfaceProxy
   unsigned int         num_readers_;
   bool                 has_writer_;
   unsigned int         clid_;
+
+  Mutex               *delta_mutex_;
+  BlackBoardDataDelta *delta_;
 };
 
 } // end namespace fawkes
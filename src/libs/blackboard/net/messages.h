@@ -50,9 +50,21 @@ typedef enum {
   MSG_BB_WRITER_REMOVED		= 13,
   MSG_BB_INTERFACE_CREATED	= 14,
   MSG_BB_INTERFACE_DESTROYED	= 15,
-  MSG_BB_LIST			= 16
+  MSG_BB_LIST			= 16,
+  MSG_BB_FEATURES_REQUEST	= 17,
+  MSG_BB_FEATURES		= 18,
+  MSG_BB_DATA_DELTA		= 19
 } blackboard_msgid_t;
 
+/** Optional protocol features, negotiated per connection. */
+typedef enum {
+  BB_FEATURE_DELTA	= 0x00000001	/**< Data is sent as MSG_BB_DATA_DELTA
+					 * instead of MSG_BB_DATA_CHANGED. */
+} blackboard_feature_t;
+
+/** Protocol features supported by this implementation. */
+#define BB_FEATURES_SUPPORTED BB_FEATURE_DELTA
+
 /** Error codes */
 typedef enum {
   BB_ERR_UNKNOWN_ERR,	/**< Unknown error occured. Check log. */
@@ -163,6 +175,39 @@ typedef struct {
 } bb_idata_msg_t;
 
 
+/** Protocol features message.
+ * Sent by the client as MSG_BB_FEATURES_REQUEST with the features it
+ * would like to use. The server answers with MSG_BB_FEATURES containing
+ * the subset of features it supports, which are then used for the rest
+ * of the connection. Servers which do not know the request do not answer,
+ * hence clients must assume that no optional features are available.
+ */
+typedef struct {
+  uint32_t features;	/**< bit field of blackboard_feature_t (big endian) */
+} bb_features_msg_t;
+
+
+/** Interface data delta message.
+ * Sent instead of MSG_BB_WRITE and MSG_BB_DATA_CHANGED if BB_FEATURE_DELTA
+ * has been negotiated. It only carries the parts of the data chunk which
+ * changed since the last update sent for this instance on the connection.
+ * This struct is followed by num_ranges blocks, each consisting of a
+ * bb_idelta_range_t immediately followed by length bytes of data.
+ */
+typedef struct {
+  uint32_t serial;	/**< instance serial to unique identify this instance */
+  uint32_t data_size;	/**< size in bytes of the complete data chunk */
+  uint32_t num_ranges;	/**< number of ranges that follow */
+} bb_idelta_msg_t;
+
+
+/** Changed range in a delta message. */
+typedef struct {
+  uint32_t offset;	/**< offset in bytes from start of data chunk */
+  uint32_t length;	/**< number of bytes that follow */
+} bb_idelta_range_t;
+
+
 /** Interface message.
  * This type is used to transport interface messages. This struct is always followed
  * by a data chunk of the size data_size that transports the message data.
@@ -0,0 +1,181 @@
+
+/***************************************************************************
+ *  qa_bb_concurrent_open.cpp - BlackBoard concurrent open/close benchmark
+ *
+ *  Created: Fri Oct 16 10:12:31 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+
+/// @cond QA
+
+#include <blackboard/local.h>
+#include <blackboard/exceptions.h>
+
+#include <interfaces/TestInterface.h>
+#include <interface/interface_info.h>
+
+#include <core/threading/thread.h>
+#include <core/threading/barrier.h>
+#include <core/exceptions/system.h>
+#include <utils/time/time.h>
+
+#include <cstdlib>
+#include <cstdio>
+
+#include <list>
+#include <vector>
+
+using namespace std;
+using namespace fawkes;
+
+#define NUM_SHARED_INTERFACES 64
+
+class OpenThread : public Thread
+{
+ public:
+  OpenThread(unsigned int id, BlackBoard *bb, Barrier *barrier,
+	     unsigned int num_interfaces)
+    : Thread("OpenThread", Thread::OPMODE_CONTINUOUS)
+  {
+    id_             = id;
+    bb_             = bb;
+    barrier_        = barrier;
+    num_interfaces_ = num_interfaces;
+    failed_         = false;
+  }
+
+  virtual void run()
+  {
+    char tmp[INTERFACE_ID_SIZE_];
+    barrier_->wait();
+
+    // phase 1: open own writers and readers for shared interfaces
+    try {
+      for (unsigned int i = 0; i < num_interfaces_; ++i) {
+	snprintf(tmp, sizeof(tmp), "Thread %u Iface %u", id_, i);
+	interfaces_.push_back(bb_->open_for_writing<TestInterface>(tmp));
+	snprintf(tmp, sizeof(tmp), "Shared %u", i % NUM_SHARED_INTERFACES);
+	interfaces_.push_back(bb_->open_for_reading<TestInterface>(tmp));
+      }
+    } catch (Exception &e) {
+      e.print_trace();
+      failed_ = true;
+    }
+    barrier_->wait();
+
+    // phase 2: main thread checks the interface list
+    barrier_->wait();
+
+    // phase 3: close everything
+    for (list<Interface *>::iterator i = interfaces_.begin(); i != interfaces_.end(); ++i) {
+      bb_->close(*i);
+    }
+    interfaces_.clear();
+    barrier_->wait();
+  }
+
+  bool failed() const
+  {
+    return failed_;
+  }
+
+ private:
+  unsigned int        id_;
+  BlackBoard         *bb_;
+  Barrier            *barrier_;
+  unsigned int        num_interfaces_;
+  bool                failed_;
+  list<Interface *>   interfaces_;
+};
+
+
+int
+main(int argc, char **argv)
+{
+  unsigned int num_threads    = 16;
+  unsigned int num_interfaces = 500;
+  if (argc > 1)  num_threads    = atoi(argv[1]);
+  if (argc > 2)  num_interfaces = atoi(argv[2]);
+  if ((num_threads == 0) || (num_interfaces == 0)) {
+    printf("Usage: %s [num_threads] [interfaces_per_thread]\n", argv[0]);
+    exit(1);
+  }
+
+  BlackBoard *bb = new LocalBlackBoard(64 * 1024 * 1024);
+  Barrier *barrier = new Barrier(num_threads + 1);
+
+  vector<OpenThread *> threads(num_threads);
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    threads[i] = new OpenThread(i, bb, barrier, num_interfaces);
+    threads[i]->start();
+  }
+
+  printf("Opening %u writers and %u readers from %u threads\n",
+	 num_threads * num_interfaces, num_threads * num_interfaces, num_threads);
+
+  Time start;
+  barrier->wait();
+  barrier->wait();
+  Time opened;
+
+  bool failed = false;
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    failed = failed || threads[i]->failed();
+  }
+
+  InterfaceInfoList *infl = bb->list_all();
+  size_t expected = num_threads * num_interfaces +
+    min(num_interfaces, (unsigned int)NUM_SHARED_INTERFACES);
+  if (infl->size() != expected) {
+    printf("Interface count mismatch: %zu instead of %zu\n", infl->size(), expected);
+    failed = true;
+  }
+  delete infl;
+
+  Time close_start;
+  barrier->wait();
+  barrier->wait();
+  Time closed;
+
+  infl = bb->list_all();
+  if (! infl->empty()) {
+    printf("%zu interfaces left after closing\n", infl->size());
+    failed = true;
+  }
+  delete infl;
+
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  unsigned int num_ops = 2 * num_threads * num_interfaces;
+  printf("open:  %8.3f sec (%.1f us/op)\n", opened - &start,
+	 (opened - &start) * 1000000. / num_ops);
+  printf("close: %8.3f sec (%.1f us/op)\n", closed - &close_start,
+	 (closed - &close_start) * 1000000. / num_ops);
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+
+  delete barrier;
+  delete bb;
+  return failed ? 1 : 0;
+}
+
+
+/// @endcond
@@ -33,6 +33,7 @@
 #include <signal.h>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #include <iostream>
 #include <vector>
@@ -62,7 +63,10 @@ main(int argc, char **argv)
   //  BlackBoardMemoryManager *mm = new BlackBoardMemoryManager( BLACKBOARD_MEMORY_SIZE,
   //							    BLACKBOARD_VERSION,
   //							    "FawkesBBMemMgrQA" /* token */ );
-  BlackBoardMemoryManager *mm = new BlackBoardMemoryManager(BLACKBOARD_MEMORY_SIZE);
+  // pass "sc" as argument to test size class mode
+  bool size_classes = (argc > 1) && (strcmp(argv[1], "sc") == 0);
+  BlackBoardMemoryManager *mm = new BlackBoardMemoryManager(BLACKBOARD_MEMORY_SIZE,
+							    size_classes);
 
   void *m[NUM_CHUNKS];
 
@@ -79,8 +83,13 @@ main(int argc, char **argv)
     cout << "done" << endl;
   }
 
-  if ( mm->max_allocated_size() != (NUM_CHUNKS * 1000) ) {
-    cout << "Largest chunk is not " << NUM_CHUNKS * 1000 << " bytes, error, aborting" << endl;
+  unsigned int expected_max = NUM_CHUNKS * 1000;
+  if (size_classes) {
+    expected_max =
+      BlackBoardMemoryManager::size_class_size(BlackBoardMemoryManager::size_class_index(expected_max));
+  }
+  if ( mm->max_allocated_size() != expected_max ) {
+    cout << "Largest chunk is not " << expected_max << " bytes, error, aborting" << endl;
     delete mm;
     exit(1);
   }
@@ -103,7 +112,13 @@ main(int argc, char **argv)
     exit(2);
   }
 
-  if ( mm->max_free_size() != free_before ) {
+  if ( size_classes ) {
+    if ( mm->free_size() + NUM_CHUNKS * sizeof(chunk_list_t) != free_before ) {
+      cout << "Free size after tests differs from before test, error, aborting" << endl;
+      delete mm;
+      exit(3);
+    }
+  } else if ( mm->max_free_size() != free_before ) {
     cout << "Max free size after tests differe from before test, error, aborting" << endl;
     delete mm;
     exit(3);
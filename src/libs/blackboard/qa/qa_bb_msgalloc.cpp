@@ -0,0 +1,137 @@
+
+/***************************************************************************
+ *  qa_bb_msgalloc.cpp - BlackBoard message allocation QA
+ *
+ *  Created: Fri Oct 16 21:05:12 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+
+/// @cond QA
+
+#include <blackboard/local.h>
+#include <interfaces/TestInterface.h>
+
+#include <core/threading/thread.h>
+#include <utils/time/time.h>
+
+#include <cstdlib>
+#include <cstdio>
+
+using namespace fawkes;
+
+// Count heap allocations by interposing the C allocator, operator new
+// ends up here as well.
+extern "C" {
+  extern void *__libc_malloc(size_t size);
+  extern void *__libc_calloc(size_t nmemb, size_t size);
+  extern void *__libc_realloc(void *ptr, size_t size);
+}
+
+static unsigned long num_allocs = 0;
+
+extern "C" void *
+malloc(size_t size)
+{
+  __atomic_add_fetch(&num_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+extern "C" void *
+calloc(size_t nmemb, size_t size)
+{
+  __atomic_add_fetch(&num_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(nmemb, size);
+}
+
+extern "C" void *
+realloc(void *ptr, size_t size)
+{
+  __atomic_add_fetch(&num_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
+
+
+#define BLACKBOARD_MEMSIZE 2 * 1024 * 1024
+#define WARMUP_MESSAGES    1000
+
+static void
+run(const char *name, TestInterface *reader, TestInterface *writer,
+    unsigned int num_messages, bool copy)
+{
+  Message *proto = new TestInterface::SetTestIntMessage(0);
+
+  unsigned long allocs = 0;
+  Time start;
+  for (unsigned int i = 0; i < WARMUP_MESSAGES + num_messages; ++i) {
+    if (i == WARMUP_MESSAGES) {
+      allocs = __atomic_load_n(&num_allocs, __ATOMIC_RELAXED);
+      start.stamp();
+    }
+
+    // sending side
+    if (copy) {
+      reader->msgq_enqueue_copy(proto);
+    } else {
+      reader->msgq_enqueue(new TestInterface::SetTestIntMessage(i));
+    }
+
+    // receiving side
+    while (! writer->msgq_empty()) {
+      if (writer->msgq_first_is<TestInterface::SetTestIntMessage>()) {
+	TestInterface::SetTestIntMessage *m =
+	  writer->msgq_first<TestInterface::SetTestIntMessage>();
+	writer->set_test_int(m->test_int());
+      }
+      writer->msgq_pop();
+    }
+  }
+  Time end;
+  allocs = __atomic_load_n(&num_allocs, __ATOMIC_RELAXED) - allocs;
+
+  printf("%-22s %8u msgs  %10.3f allocs/msg  %8.1f ns/msg\n", name, num_messages,
+	 (double)allocs / num_messages, (end.in_sec() - start.in_sec()) * 1e9 / num_messages);
+
+  proto->unref();
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned int num_messages = (argc > 1) ? atoi(argv[1]) : 100000;
+
+  Thread::init_main();
+
+  BlackBoard *bb = new LocalBlackBoard(BLACKBOARD_MEMSIZE);
+
+  TestInterface *writer = bb->open_for_writing<TestInterface>("SomeID");
+  TestInterface *reader = bb->open_for_reading<TestInterface>("SomeID");
+
+  run("msgq_enqueue", reader, writer, num_messages, false);
+  run("msgq_enqueue_copy", reader, writer, num_messages, true);
+
+  bb->close(reader);
+  bb->close(writer);
+  delete bb;
+
+  Thread::destroy_main();
+  return 0;
+}
+
+
+/// @endcond
@@ -34,10 +34,12 @@
 #include <core/threading/mutex.h>
 #include <core/threading/mutex_locker.h>
 #include <core/threading/wait_condition.h>
+#include <logging/liblogger.h>
 #include <netcomm/fawkes/client.h>
 #include <utils/time/time.h>
 
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <fnmatch.h>
 #include <arpa/inet.h>
@@ -49,6 +51,11 @@ namespace fawkes {
  * This class implements the access to a remote BlackBoard using the Fawkes
  * network protocol.
  *
+ * On connection, the optional protocol features are negotiated. With a
+ * server supporting it, interface data is exchanged as deltas against the
+ * previously transmitted data (BB_FEATURE_DELTA). Older servers ignore the
+ * request and the full data is transmitted on each write.
+ *
  * @author Tim Niemueller
  */
 
@@ -74,6 +81,9 @@ RemoteBlackBoard::RemoteBlackBoard(FawkesNetworkClient *client)
 
   inbound_thread_ = NULL;
   m_ = NULL;
+  features_ = 0;
+
+  request_features();
 }
 
 
@@ -109,6 +119,9 @@ RemoteBlackBoard::RemoteBlackBoard(const char *hostname, unsigned short int port
 
   inbound_thread_ = NULL;
   m_ = NULL;
+  features_ = 0;
+
+  request_features();
 }
 
 
@@ -133,6 +146,23 @@ RemoteBlackBoard::~RemoteBlackBoard()
 }
 
 
+/** Request optional protocol features from the remote BlackBoard.
+ * The reply is processed asynchronously, but before any reply to
+ * requests sent later on the same connection.
+ */
+void
+RemoteBlackBoard::request_features()
+{
+  __atomic_store_n(&features_, 0, __ATOMIC_RELEASE);
+  bb_features_msg_t *fm = (bb_features_msg_t *)malloc(sizeof(bb_features_msg_t));
+  fm->features = htonl(BB_FEATURES_SUPPORTED);
+  FawkesNetworkMessage *omsg = new FawkesNetworkMessage(FAWKES_CID_BLACKBOARD,
+							MSG_BB_FEATURES_REQUEST,
+							fm, sizeof(bb_features_msg_t));
+  fnc_->enqueue(omsg);
+}
+
+
 bool
 RemoteBlackBoard::is_alive() const throw()
 {
@@ -167,6 +197,7 @@ RemoteBlackBoard::try_aliveness_restore() throw()
     if ( ! fnc_->connected() ) {
       fnc_->connect();
 
+      request_features();
       reopen_interfaces();
     }
   } catch (...) {
@@ -226,6 +257,7 @@ RemoteBlackBoard::open_interface(const char *type, const char *identifier, const
     // We got the interface, create internal storage and prepare instance for return
     BlackBoardInterfaceProxy *proxy = new BlackBoardInterfaceProxy(fnc_, m_, notifier_,
 								   iface, writer);
+    proxy->set_delta_mode(__atomic_load_n(&features_, __ATOMIC_ACQUIRE) & BB_FEATURE_DELTA);
     proxies_[proxy->serial()] = proxy;
   } else if ( m_->msgid() == MSG_BB_OPEN_FAILURE ) {
     bb_iopenfail_msg_t *fm = m_->msg<bb_iopenfail_msg_t>();
@@ -474,6 +506,25 @@ RemoteBlackBoard::inbound_received(FawkesNetworkMessage *m,
 	if ( proxies_.find(serial) != proxies_.end() ) {
 	  proxies_[serial]->process_data_changed(m);
 	}
+      } else if ( msgid == MSG_BB_DATA_DELTA ) {
+	if ( m->payload_size() < sizeof(bb_idelta_msg_t) ) {
+	  LibLogger::log_error("RemoteBlackBoard", "Data delta message too short "
+			       "(%zu bytes), ignoring.", m->payload_size());
+	} else {
+	  unsigned int serial = ntohl(((bb_idelta_msg_t *)m->payload())->serial);
+	  if ( proxies_.find(serial) != proxies_.end() ) {
+	    proxies_[serial]->process_data_delta(m);
+	  }
+	}
+      } else if (msgid == MSG_BB_FEATURES) {
+	bb_features_msg_t *fm = m->msg<bb_features_msg_t>();
+	unsigned int features = ntohl(fm->features) & BB_FEATURES_SUPPORTED;
+	__atomic_store_n(&features_, features, __ATOMIC_RELEASE);
+	proxies_.lock();
+	for (pit_ = proxies_.begin(); pit_ != proxies_.end(); ++pit_) {
+	  pit_->second->set_delta_mode(features & BB_FEATURE_DELTA);
+	}
+	proxies_.unlock();
       } else if (msgid == MSG_BB_INTERFACE_MESSAGE) {
 	unsigned int serial = ntohl(((unsigned int *)m->payload())[0]);
 	if ( proxies_.find(serial) != proxies_.end() ) {
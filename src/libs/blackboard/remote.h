@@ -85,6 +85,7 @@ class RemoteBlackBoard
 			     bool writer, Interface *iface);
   Interface * open_interface(const char *type, const char *identifier, const char *owner, bool writer);
   void        reopen_interfaces();
+  void        request_features();
 
 
  private: /* members */
@@ -102,6 +103,7 @@ class RemoteBlackBoard
   WaitCondition *wait_cond_;
 
   const char *inbound_thread_;
+  unsigned int features_;
 };
 
 } // end namespace fawkes
@@ -24,6 +24,7 @@
 #include <blackboard/shmem/header.h>
 #include <utils/ipc/shm.h>
 #include <cstddef>
+#include <cstring>
 
 namespace fawkes {
 
@@ -161,6 +162,9 @@ BlackBoardSharedMemoryHeader::initialize(void *memptr)
   data->shm_addr        = memptr;
   data->free_list_head  = NULL;
   data->alloc_list_head = NULL;
+  data->size_class_mode = 0;
+  memset(data->size_classes, 0, sizeof(data->size_classes));
+  data->sc_slab         = NULL;
 }
 
 
@@ -237,6 +241,63 @@ BlackBoardSharedMemoryHeader::set_alloc_list_head(chunk_list_t *alh)
 }
 
 
+/** Check if size class allocation is used.
+ * @return true if the memory is managed in size class mode, false for
+ * the default first-fit allocation
+ */
+bool
+BlackBoardSharedMemoryHeader::size_class_mode() const
+{
+  return (data->size_class_mode != 0);
+}
+
+
+/** Set size class allocation mode.
+ * Must only be set by the master before the first allocation.
+ * @param enabled true to enable size class mode, false otherwise
+ */
+void
+BlackBoardSharedMemoryHeader::set_size_class_mode(bool enabled)
+{
+  data->size_class_mode = enabled ? 1 : 0;
+}
+
+
+/** Get size classes.
+ * @return pointer to the array of BBMM_NUM_SIZE_CLASSES size classes in
+ * the shared memory segment. The list heads stored therein are shared
+ * memory addresses which must be converted before use.
+ */
+size_class_t *
+BlackBoardSharedMemoryHeader::size_classes()
+{
+  return data->size_classes;
+}
+
+
+/** Get the size class refill slab.
+ * @return pointer to the chunk from which size class refills are
+ * carved, NULL if there is none, local pointer, already transformed,
+ * you can use this without further conversion.
+ */
+chunk_list_t *
+BlackBoardSharedMemoryHeader::sc_slab()
+{
+  return (chunk_list_t *)shmem->ptr(data->sc_slab);
+}
+
+
+/** Set the size class refill slab.
+ * @param slab pointer to the new slab, must be a pointer to the local
+ * shared memory segment. Will be transformed to a shared memory address.
+ */
+void
+BlackBoardSharedMemoryHeader::set_sc_slab(chunk_list_t *slab)
+{
+  data->sc_slab = (chunk_list_t *)shmem->addr(slab);
+}
+
+
 /** Get BlackBoard version.
  * @return BlackBoard version
  */
@@ -41,6 +41,9 @@ class BlackBoardSharedMemoryHeader : public SharedMemoryHeader
     void         *shm_addr;             /**< base addr of shared memory */
     chunk_list_t *free_list_head;	/**< offset of the free chunks list head */
     chunk_list_t *alloc_list_head;	/**< offset of the allocated chunks list head */
+    unsigned int  size_class_mode;	/**< 1 if size class allocation is used */
+    size_class_t  size_classes[BBMM_NUM_SIZE_CLASSES];	/**< size classes */
+    chunk_list_t *sc_slab;		/**< offset of the size class refill slab */
   } BlackBoardSharedMemoryHeaderData;
 
  public:
@@ -61,6 +64,11 @@ class BlackBoardSharedMemoryHeader : public SharedMemoryHeader
   chunk_list_t * alloc_list_head();
   void set_free_list_head(chunk_list_t *flh);
   void set_alloc_list_head(chunk_list_t *alh);
+  bool size_class_mode() const;
+  void set_size_class_mode(bool enabled);
+  size_class_t * size_classes();
+  chunk_list_t * sc_slab();
+  void set_sc_slab(chunk_list_t *slab);
 
   unsigned int version() const;
 
@@ -0,0 +1,278 @@
+/***************************************************************************
+ *  test_async_notify.cpp - BlackBoard asynchronous notification unit test
+ *
+ *  Created: Fri Oct 16 22:31:05 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <blackboard/local.h>
+#include <blackboard/bbconfig.h>
+#include <blackboard/interface_listener.h>
+#include <interfaces/TestInterface.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace fawkes;
+
+/** @class AsyncTestListener
+ * Listener recording its callbacks, optionally unregistering itself or
+ * another listener from its callback.
+ */
+class AsyncTestListener : public BlackBoardInterfaceListener
+{
+ public:
+  /** Constructor.
+   * @param name listener name
+   * @param bb blackboard to unregister from
+   * @param iface interface to listen to
+   * @param sleep_usec time to sleep in each callback
+   */
+  AsyncTestListener(const char *name, BlackBoard *bb, Interface *iface,
+		    unsigned int sleep_usec = 0)
+    : BlackBoardInterfaceListener("%s", name), bb_(bb), sleep_usec_(sleep_usec)
+  {
+    main_thread_ = pthread_self();
+    calls = 0;
+    last_value = 0;
+    in_writer_thread = false;
+    unregister_self = false;
+    unregister_other = NULL;
+    other_done_on_return = false;
+    entered = false;
+    rendezvous = NULL;
+    bbil_add_data_interface(iface);
+  }
+
+  virtual void bb_interface_data_changed(Interface *interface) throw()
+  {
+    TestInterface *ti = dynamic_cast<TestInterface *>(interface);
+    ti->read();
+    __atomic_store_n(&entered, true, __ATOMIC_RELEASE);
+    if (pthread_equal(pthread_self(), main_thread_))  in_writer_thread = true;
+    if (sleep_usec_ > 0)  usleep(sleep_usec_);
+    last_value = ti->test_int();
+    __atomic_add_fetch(&calls, 1, __ATOMIC_RELEASE);
+
+    if (rendezvous) {
+      // wait until the other listener is in its callback as well
+      __atomic_add_fetch(rendezvous, 1, __ATOMIC_ACQ_REL);
+      while (__atomic_load_n(rendezvous, __ATOMIC_ACQUIRE) < 2)  usleep(100);
+    }
+    if (unregister_other) {
+      bb_->unregister_listener(unregister_other);
+      other_done_on_return = (unregister_other->num_calls() > 0);
+      __atomic_store_n(&unregister_other, (AsyncTestListener *)NULL, __ATOMIC_RELEASE);
+    }
+    if (unregister_self) {
+      unregister_self = false;
+      bb_->unregister_listener(this);
+    }
+  }
+
+  /** Get number of callbacks.
+   * @return number of callbacks */
+  unsigned int num_calls() const
+  { return __atomic_load_n(&calls, __ATOMIC_ACQUIRE); }
+
+  /** Wait until the listener has seen the given value, at most 5 sec.
+   * @param value value to wait for
+   * @return true if the value has been seen */
+  bool wait_for_value(int value)
+  {
+    for (unsigned int i = 0; i < 5000; ++i) {
+      if (num_calls() > 0 && last_value == value)  return true;
+      usleep(1000);
+    }
+    return false;
+  }
+
+  /** Number of callbacks */
+  unsigned int        calls;
+  /** Last value read in a callback */
+  int                 last_value;
+  /** True if a callback was run by the writing thread */
+  bool                in_writer_thread;
+  /** Unregister from the next callback */
+  bool                unregister_self;
+  /** Listener to unregister from the next callback */
+  AsyncTestListener  *unregister_other;
+  /** True if the other listener's callback had completed when
+   * unregistering it returned */
+  bool                other_done_on_return;
+  /** True once a callback has been entered */
+  bool                entered;
+  /** Counter to meet another listener in the callback */
+  unsigned int       *rendezvous;
+
+ private:
+  BlackBoard   *bb_;
+  unsigned int  sleep_usec_;
+  pthread_t     main_thread_;
+};
+
+
+/** @class BlackBoardAsyncNotifyTest
+ * Test class for asynchronous data change notification.
+ */
+class BlackBoardAsyncNotifyTest : public ::testing::Test
+{
+ protected:
+  /** Create blackboard with two workers and open interfaces */
+  virtual void SetUp()
+  {
+    lbb = new LocalBlackBoard(BLACKBOARD_MEMSIZE);
+    lbb->set_async_notification(2);
+    bb = lbb;
+    w  = bb->open_for_writing<TestInterface>("Async 1");
+    r1 = bb->open_for_reading<TestInterface>("Async 1");
+    r2 = bb->open_for_reading<TestInterface>("Async 1");
+    w2 = bb->open_for_writing<TestInterface>("Async 2");
+    r3 = bb->open_for_reading<TestInterface>("Async 2");
+  }
+
+  /** Close interfaces and delete blackboard */
+  virtual void TearDown()
+  {
+    bb->close(r3);
+    bb->close(w2);
+    bb->close(r2);
+    bb->close(r1);
+    bb->close(w);
+    delete bb;
+  }
+
+  /** Write value to interface.
+   * @param writer interface to write to
+   * @param value value to write
+   */
+  void write(TestInterface *writer, int value)
+  {
+    writer->set_test_int(value);
+    writer->write();
+  }
+
+  /** Local blackboard */
+  LocalBlackBoard *lbb;
+  /** Blackboard */
+  BlackBoard      *bb;
+  /** Writer of Async 1 */
+  TestInterface   *w;
+  /** First reader of Async 1 */
+  TestInterface   *r1;
+  /** Second reader of Async 1 */
+  TestInterface   *r2;
+  /** Writer of Async 2 */
+  TestInterface   *w2;
+  /** Reader of Async 2 */
+  TestInterface   *r3;
+};
+
+
+TEST_F(BlackBoardAsyncNotifyTest, CoalesceAndStats)
+{
+  // fast listener gets the latest value from a worker thread
+  AsyncTestListener fast("Fast", bb, r1);
+  AsyncTestListener slow("Slow", bb, r2, 5000);
+  bb->register_listener(&fast, BlackBoard::BBIL_FLAG_DATA);
+  bb->register_listener(&slow, BlackBoard::BBIL_FLAG_DATA);
+
+  const int NUM_WRITES = 200;
+  for (int i = 1; i <= NUM_WRITES; ++i)  write(w, i);
+
+  EXPECT_TRUE(fast.wait_for_value(NUM_WRITES));
+  EXPECT_TRUE(slow.wait_for_value(NUM_WRITES));
+  EXPECT_FALSE(fast.in_writer_thread);
+  EXPECT_FALSE(slow.in_writer_thread);
+  EXPECT_LT(slow.num_calls(), (unsigned int)NUM_WRITES);
+
+  std::map<std::string, BlackBoardInterfaceListener::DispatchStats> stats =
+    lbb->listener_dispatch_stats();
+  ASSERT_TRUE(stats.find("Slow") != stats.end());
+  const BlackBoardInterfaceListener::DispatchStats &s = stats["Slow"];
+  EXPECT_EQ((unsigned long)NUM_WRITES, s.num_events);
+  EXPECT_GT(s.num_coalesced, 0ul);
+  EXPECT_EQ(s.num_events, s.num_dispatched + s.num_coalesced);
+  EXPECT_EQ((unsigned long)slow.num_calls(), s.num_dispatched);
+
+  bb->unregister_listener(&fast);
+  bb->unregister_listener(&slow);
+}
+
+TEST_F(BlackBoardAsyncNotifyTest, UnregisterSelfFromCallback)
+{
+  AsyncTestListener self("Self", bb, r1);
+  self.unregister_self = true;
+  bb->register_listener(&self, BlackBoard::BBIL_FLAG_DATA);
+  write(w, 1000);
+  EXPECT_TRUE(self.wait_for_value(1000));
+  usleep(10000);
+  write(w, 1001);
+  usleep(50000);
+  EXPECT_EQ(1u, self.num_calls());
+}
+
+TEST_F(BlackBoardAsyncNotifyTest, UnregisterEachOtherFromCallbacks)
+{
+  unsigned int rendezvous = 0;
+  AsyncTestListener a("A", bb, r1);
+  AsyncTestListener b("B", bb, r3);
+  a.rendezvous = b.rendezvous = &rendezvous;
+  a.unregister_other = &b;
+  b.unregister_other = &a;
+  bb->register_listener(&a, BlackBoard::BBIL_FLAG_DATA);
+  bb->register_listener(&b, BlackBoard::BBIL_FLAG_DATA);
+  write(w, 2000);
+  write(w2, 3000);
+  EXPECT_TRUE(a.wait_for_value(2000));
+  EXPECT_TRUE(b.wait_for_value(3000));
+  // synchronizes with the workers, hangs if they deadlocked
+  lbb->set_async_notification(0);
+  EXPECT_EQ(1u, a.num_calls());
+  EXPECT_EQ(1u, b.num_calls());
+}
+
+TEST_F(BlackBoardAsyncNotifyTest, UnregisterOtherFromCallback)
+{
+  AsyncTestListener a("A", bb, r1);
+  AsyncTestListener *b = new AsyncTestListener("B", bb, r3, 200000);
+  a.unregister_other = b;
+  bb->register_listener(&a, BlackBoard::BBIL_FLAG_DATA);
+  bb->register_listener(b, BlackBoard::BBIL_FLAG_DATA);
+
+  write(w2, 3000);
+  for (unsigned int i = 0; i < 5000 && ! __atomic_load_n(&b->entered, __ATOMIC_ACQUIRE); ++i) {
+    usleep(1000);
+  }
+  ASSERT_TRUE(__atomic_load_n(&b->entered, __ATOMIC_ACQUIRE));
+
+  // A unregisters B while B's callback is still running on the other worker
+  write(w, 2000);
+  EXPECT_TRUE(a.wait_for_value(2000));
+  for (unsigned int i = 0; i < 5000 && __atomic_load_n(&a.unregister_other, __ATOMIC_ACQUIRE); ++i) {
+    usleep(1000);
+  }
+  ASSERT_TRUE(__atomic_load_n(&a.unregister_other, __ATOMIC_ACQUIRE) == NULL);
+  EXPECT_TRUE(a.other_done_on_return);
+  EXPECT_EQ(1u, b->num_calls());
+  delete b;
+
+  bb->unregister_listener(&a);
+}
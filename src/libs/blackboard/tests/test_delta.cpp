@@ -0,0 +1,209 @@
+/***************************************************************************
+ *  test_delta.cpp - BlackBoard network data delta unit test
+ *
+ *  Created: Fri Oct 16 23:02:41 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <blackboard/local.h>
+#include <blackboard/bbconfig.h>
+#include <blackboard/net/delta.h>
+#include <blackboard/net/messages.h>
+#include <interfaces/TestInterface.h>
+#include <core/exception.h>
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace fawkes;
+
+/** @class BlackBoardDeltaTest
+ * Test class for encoding and applying interface data deltas.
+ */
+class BlackBoardDeltaTest : public ::testing::Test
+{
+ protected:
+  /** Open writer and create delta with a remote base copy */
+  virtual void SetUp()
+  {
+    bb = new LocalBlackBoard(BLACKBOARD_MEMSIZE);
+    w = bb->open_for_writing<TestInterface>("Delta");
+    data_size = w->datasize();
+    delta = new BlackBoardDataDelta(w);
+    remote = (char *)malloc(data_size);
+    memcpy(remote, w->datachunk(), data_size);
+    delta->set_base(remote);
+  }
+
+  /** Free delta and close interface */
+  virtual void TearDown()
+  {
+    delete delta;
+    free(remote);
+    bb->close(w);
+    delete bb;
+  }
+
+  /** Apply delta to remote copy.
+   * @param payload delta message
+   * @param payload_size size of payload
+   * @return true if the delta was rejected, false if it was applied
+   */
+  bool rejected(const void *payload, size_t payload_size)
+  {
+    try {
+      BlackBoardDataDelta::apply(remote, data_size, payload, payload_size);
+      return false;
+    } catch (Exception &e) {
+      return true;
+    }
+  }
+
+  /** Create delta message with a single zeroed range.
+   * @param dsize data size to announce
+   * @param num_ranges number of ranges to announce
+   * @param offset range offset
+   * @param length range length
+   * @param payload_size upon return contains size of the message
+   * @return delta message, free after use
+   */
+  void * make_delta(size_t dsize, unsigned int num_ranges,
+		    unsigned int offset, unsigned int length, size_t &payload_size)
+  {
+    payload_size = sizeof(bb_idelta_msg_t) + sizeof(bb_idelta_range_t) + 8;
+    void *payload = calloc(1, payload_size);
+    bb_idelta_msg_t *dm = (bb_idelta_msg_t *)payload;
+    dm->serial     = htonl(1);
+    dm->data_size  = htonl(dsize);
+    dm->num_ranges = htonl(num_ranges);
+    bb_idelta_range_t r;
+    r.offset = htonl(offset);
+    r.length = htonl(length);
+    memcpy((char *)payload + sizeof(bb_idelta_msg_t), &r, sizeof(r));
+    return payload;
+  }
+
+  /** Blackboard */
+  BlackBoard          *bb;
+  /** Writing interface */
+  TestInterface       *w;
+  /** Interface data size */
+  size_t               data_size;
+  /** Delta encoder */
+  BlackBoardDataDelta *delta;
+  /** Remote copy of the data */
+  char                *remote;
+};
+
+
+TEST_F(BlackBoardDeltaTest, Base)
+{
+  BlackBoardDataDelta d(w);
+  EXPECT_FALSE(d.has_base());
+  d.set_base(remote);
+  EXPECT_TRUE(d.has_base());
+}
+
+TEST_F(BlackBoardDeltaTest, Unchanged)
+{
+  size_t payload_size;
+  void *payload = delta->encode(w->serial(), w->datachunk(), payload_size);
+  EXPECT_EQ(sizeof(bb_idelta_msg_t), payload_size);
+  EXPECT_EQ(0u, ntohl(((bb_idelta_msg_t *)payload)->num_ranges));
+  EXPECT_EQ(w->serial(), ntohl(((bb_idelta_msg_t *)payload)->serial));
+  free(payload);
+}
+
+TEST_F(BlackBoardDeltaTest, RoundTrip)
+{
+  size_t payload_size = 0;
+  srand(42);
+  for (unsigned int i = 0; i < 1000; ++i) {
+    switch (rand() % 5) {
+    case 0: w->set_test_int(rand());                  break;
+    case 1: w->set_test_bool(! w->is_test_bool());    break;
+    case 2: w->set_test_uint(rand());                 break;
+    case 3: w->set_flags(rand() & 0xFF);              break;
+    case 4: {
+	char s[30];
+	snprintf(s, sizeof(s), "string %d", rand());
+	w->set_test_string(s);
+      }
+      break;
+    }
+    if (rand() % 3 == 0)  w->set_result(i);
+
+    void *payload = delta->encode(w->serial(), w->datachunk(), payload_size);
+    EXPECT_FALSE(rejected(payload, payload_size));
+    free(payload);
+    ASSERT_EQ(0, memcmp(remote, w->datachunk(), data_size)) << "iteration " << i;
+  }
+  EXPECT_LT(payload_size, sizeof(bb_idelta_msg_t) + data_size);
+}
+
+TEST_F(BlackBoardDeltaTest, Truncated)
+{
+  w->set_test_int(4711);
+  w->set_test_string("truncated");
+  w->set_test_uint(815);
+  size_t payload_size;
+  void *payload = delta->encode(w->serial(), w->datachunk(), payload_size);
+  char *copy = (char *)malloc(data_size);
+  memcpy(copy, remote, data_size);
+  for (size_t s = 0; s < payload_size; ++s) {
+    EXPECT_TRUE(rejected(payload, s)) << "truncated to " << s;
+  }
+  EXPECT_EQ(0, memcmp(copy, remote, data_size));
+  EXPECT_FALSE(rejected(payload, payload_size));
+  EXPECT_EQ(0, memcmp(remote, w->datachunk(), data_size));
+  free(payload);
+  free(copy);
+}
+
+TEST_F(BlackBoardDeltaTest, Malformed)
+{
+  char *copy = (char *)malloc(data_size);
+  memcpy(copy, remote, data_size);
+  size_t payload_size;
+
+  void *payload = make_delta(data_size + 1, 1, 0, 8, payload_size);
+  EXPECT_TRUE(rejected(payload, payload_size)) << "data size mismatch";
+  free(payload);
+  payload = make_delta(data_size, 1, data_size - 4, 8, payload_size);
+  EXPECT_TRUE(rejected(payload, payload_size)) << "range beyond data";
+  free(payload);
+  payload = make_delta(data_size, 1, data_size + 8, 0, payload_size);
+  EXPECT_TRUE(rejected(payload, payload_size)) << "offset beyond data";
+  free(payload);
+  payload = make_delta(data_size, 1, 8, 0xFFFFFFFC, payload_size);
+  EXPECT_TRUE(rejected(payload, payload_size)) << "overflowing range";
+  free(payload);
+  payload = make_delta(data_size, 0xFFFFFFFF, 0, 8, payload_size);
+  EXPECT_TRUE(rejected(payload, payload_size)) << "bogus range count";
+  free(payload);
+  payload = make_delta(data_size, 1, 0, 8, payload_size);
+  EXPECT_TRUE(rejected(payload, sizeof(bb_idelta_msg_t) - 1)) << "short header";
+  EXPECT_EQ(0, memcmp(copy, remote, data_size));
+  EXPECT_FALSE(rejected(payload, payload_size));
+  free(payload);
+  free(copy);
+}
@@ -0,0 +1,169 @@
+/***************************************************************************
+ *  test_history.cpp - BlackBoard interface history unit test
+ *
+ *  Created: Fri Oct 16 21:05:37 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <blackboard/local.h>
+#include <blackboard/bbconfig.h>
+#include <interfaces/TestInterface.h>
+#include <utils/time/time.h>
+
+using namespace fawkes;
+
+/** Number of history slots */
+static const unsigned int SLOTS = 4;
+
+/** @class BlackBoardHistoryTest
+ * Test class for interface histories.
+ * Opens several interfaces with odd data sizes back to back in memory,
+ * the "History *" ones keep a history.
+ */
+class BlackBoardHistoryTest : public ::testing::Test
+{
+ protected:
+  /** Create blackboard and open interfaces */
+  virtual void SetUp()
+  {
+    LocalBlackBoard *lbb = new LocalBlackBoard(BLACKBOARD_MEMSIZE);
+    lbb->set_history_size("TestInterface", "History*", SLOTS);
+    bb = lbb;
+    w  = bb->open_for_writing<TestInterface>("History 1");
+    w2 = bb->open_for_writing<TestInterface>("History 2");
+    r  = bb->open_for_reading<TestInterface>("History 1");
+    nh = bb->open_for_reading<TestInterface>("No History");
+    w->set_auto_timestamping(false);
+    w2->set_auto_timestamping(false);
+  }
+
+  /** Close interfaces and delete blackboard */
+  virtual void TearDown()
+  {
+    bb->close(nh);
+    bb->close(r);
+    bb->close(w2);
+    bb->close(w);
+    delete bb;
+  }
+
+  /** Write states, state i has test_int i and timestamp 1000+i.
+   * @param writer interface to write to
+   * @param first number of the first state
+   * @param num number of states to write
+   */
+  void write_states(TestInterface *writer, int first, int num)
+  {
+    for (int i = first; i < first + num; ++i) {
+      Time t(1000 + i, 0);
+      writer->set_timestamp(&t);
+      writer->set_test_int(i);
+      writer->write();
+    }
+  }
+
+  /** Blackboard */
+  BlackBoard    *bb;
+  /** Writer of History 1 */
+  TestInterface *w;
+  /** Writer of History 2 */
+  TestInterface *w2;
+  /** Reader of History 1 */
+  TestInterface *r;
+  /** Reader of interface without history */
+  TestInterface *nh;
+};
+
+TEST_F(BlackBoardHistoryTest, HistorySize)
+{
+  EXPECT_EQ(SLOTS, r->history_size());
+  EXPECT_EQ(0u, nh->history_size());
+  Time t0(1001, 0);
+  EXPECT_FALSE(nh->read_history(&t0));
+}
+
+TEST_F(BlackBoardHistoryTest, PartiallyFilled)
+{
+  write_states(w, 1, 3);
+  write_states(w2, 101, 7);
+  uint64_t seq = 0;
+  unsigned int n = r->read_history_since(seq);
+  ASSERT_EQ(3u, n);
+  EXPECT_EQ(3u, seq);
+  for (unsigned int b = 0; b < n; ++b) {
+    r->read_from_buffer(b);
+    EXPECT_EQ((int)b + 1, r->test_int());
+  }
+}
+
+TEST_F(BlackBoardHistoryTest, WrapAround)
+{
+  write_states(w, 1, 13);
+  write_states(w2, 101, 7);
+  r->read();
+  EXPECT_EQ(13, r->test_int());
+  EXPECT_EQ(13u, r->sequence());
+
+  // only the last SLOTS states remain
+  uint64_t seq = 0;
+  unsigned int n = r->read_history_since(seq);
+  ASSERT_EQ(SLOTS, n);
+  EXPECT_EQ(13u, seq);
+  for (unsigned int b = 0; b < n; ++b) {
+    r->read_from_buffer(b);
+    EXPECT_EQ((int)(13 - SLOTS + 1 + b), r->test_int());
+  }
+
+  seq = 11;
+  EXPECT_EQ(2u, r->read_history_since(seq));
+  EXPECT_EQ(13u, seq);
+  EXPECT_EQ(0u, r->read_history_since(seq));
+  EXPECT_EQ(13u, seq);
+}
+
+TEST_F(BlackBoardHistoryTest, ReadByTime)
+{
+  write_states(w, 1, 13);
+
+  Time t1(1011, 500000);
+  ASSERT_TRUE(r->read_history(&t1));
+  EXPECT_EQ(11, r->test_int());
+  EXPECT_EQ(11u, r->sequence());
+  Time t2(1013, 0);
+  ASSERT_TRUE(r->read_history(&t2));
+  EXPECT_EQ(13, r->test_int());
+  // overwritten state
+  Time t3(1005, 0);
+  EXPECT_FALSE(r->read_history(&t3));
+}
+
+TEST_F(BlackBoardHistoryTest, NeighbourUnaffected)
+{
+  write_states(w, 1, 13);
+  write_states(w2, 101, 7);
+
+  TestInterface *r2 = bb->open_for_reading<TestInterface>("History 2");
+  uint64_t seq = 0;
+  EXPECT_EQ(SLOTS, r2->read_history_since(seq));
+  EXPECT_EQ(7u, seq);
+  r2->read_from_buffer(0);
+  EXPECT_EQ(104, r2->test_int());
+  bb->close(r2);
+}
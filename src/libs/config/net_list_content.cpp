@@ -192,10 +192,9 @@ ConfigListContent::append(Configuration::ValueIterator *i)
 void
 ConfigListContent::serialize()
 {
-  _payload_size = sizeof(msg) + config_list->buffer_size();
-  _payload = calloc(1, _payload_size);
-  copy_payload(0, &msg, sizeof(msg));
-  copy_payload(sizeof(msg), config_list->buffer(), config_list->buffer_size());
+  clear_segments();
+  add_segment(&msg, sizeof(msg));
+  add_segment(config_list->buffer(), config_list->buffer_size());
 }
 
 
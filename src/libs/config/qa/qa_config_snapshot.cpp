@@ -0,0 +1,106 @@
+
+/***************************************************************************
+ *  qa_config_snapshot.cpp - QA for configuration snapshots and handles
+ *
+ *  Created: Mon Oct 19 15:31:07 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL file in the doc directory.
+ */
+
+/// @cond QA
+
+#include <config/yaml.h>
+#include <config/snapshot.h>
+
+#include <cstdio>
+#include <ctime>
+
+using namespace fawkes;
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.;
+}
+
+int
+main(int argc, char **argv)
+{
+  YamlConfiguration *config = new YamlConfiguration(CONFDIR);
+
+  try {
+    config->load("config.yaml");
+  } catch (CouldNotOpenConfigException &e) {
+    e.print_trace();
+    return -1;
+  }
+
+  ConfigSnapshotPublisher *publisher = new ConfigSnapshotPublisher(config, "/");
+  std::shared_ptr<const ConfigSnapshot> s = publisher->snapshot();
+  printf("Snapshot with %zu values\n", s->size());
+
+  const char *path = "/fawkes/mainapp/blackboard_size";
+  printf("%s: config %u  snapshot %u\n", path, config->get_uint(path), s->get_uint(path));
+
+  ConfigHandle<unsigned int> h_bbsize = publisher->handle<unsigned int>(path);
+  ConfigHandle<float>        h_float  = publisher->handle<float>("/z/snapshot/float");
+  ConfigHandle<std::string>  h_string = publisher->handle<std::string>("/z/snapshot/string");
+  printf("Handle %s: %u\n", h_bbsize.path(), h_bbsize.get());
+  printf("Handle %s exists: %s\n", h_float.path(), h_float.exists() ? "yes" : "no");
+
+  printf("\n=== Setting values ===\n");
+  config->set_float("/z/snapshot/float", 1.5);
+  config->set_string("/z/snapshot/string", "foo");
+  printf("Version %u, float %f, string %s, old snapshot has float: %s\n",
+	 publisher->version(), h_float.get(), h_string.get().c_str(),
+	 s->exists("/z/snapshot/float") ? "yes" : "no");
+
+  config->erase("/z/snapshot/float");
+  printf("After erase float exists: %s, default %f\n",
+	 h_float.exists() ? "yes" : "no", h_float.get_or_default(-1.));
+
+  try {
+    publisher->handle<int>("/z/snapshot/string").get();
+    printf("!!! Failed, no type mismatch\n");
+  } catch (ConfigTypeMismatchException &e) {
+    printf("Type mismatch as expected: %s\n", e.what_no_backtrace());
+  }
+
+  printf("\n=== Benchmark ===\n");
+  const unsigned int N = 1000000;
+  unsigned long sum = 0;
+  double start = now();
+  for (unsigned int i = 0; i < N; ++i)  sum += config->get_uint(path);
+  double t_config = (now() - start) / N * 1e9;
+  start = now();
+  s = publisher->snapshot();
+  for (unsigned int i = 0; i < N; ++i)  sum += s->get_uint(path);
+  double t_snapshot = (now() - start) / N * 1e9;
+  start = now();
+  for (unsigned int i = 0; i < N; ++i)  sum += h_bbsize.get();
+  double t_handle = (now() - start) / N * 1e9;
+  printf("get_uint: config %.1f ns  snapshot %.1f ns  handle %.1f ns  (%lu)\n",
+	 t_config, t_snapshot, t_handle, sum);
+
+  config->erase("/z/snapshot/string");
+  delete publisher;
+  delete config;
+  return 0;
+}
+
+/// @endcond
@@ -0,0 +1,600 @@
+
+/***************************************************************************
+ *  snapshot.cpp - Immutable configuration snapshots and value handles
+ *
+ *  Created: Mon Oct 19 09:12:48 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <config/snapshot.h>
+
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+
+#include <memory>
+
+namespace fawkes {
+
+/** @class ConfigSnapshot <config/snapshot.h>
+ * Immutable copy of configuration values.
+ * A snapshot holds all values below a prefix in a hash table. Each value
+ * is stored in all types it can be read as according to the configuration
+ * it was taken from, therefore reading it yields the same result as
+ * reading it from the configuration, without locking and tree or database
+ * lookups.
+ *
+ * Snapshots are published by the ConfigSnapshotPublisher. Once published
+ * a snapshot is never modified, a change creates a new snapshot.
+ * @author Tim Niemueller
+ */
+
+/// @cond INTERNALS
+static void
+read_value(const Configuration::ValueIterator *v, ConfigSnapshot::Value &val)
+{
+  val.type       = v->type();
+  val.types      = 0;
+  val.is_list    = v->is_list();
+  val.is_default = v->is_default();
+  val.f = 0.;
+  val.u = 0;
+  val.i = 0;
+  val.b = false;
+
+  // a value may be readable as multiple types, e.g. an unsigned int also as
+  // int and float, record all of them as the configuration would return
+  if (val.is_list) {
+    try {
+      val.floats = v->get_floats();
+      val.types |= ConfigSnapshot::TYPE_FLOAT;
+    } catch (Exception &e) {}
+    try {
+      val.uints = v->get_uints();
+      val.types |= ConfigSnapshot::TYPE_UINT;
+    } catch (Exception &e) {}
+    try {
+      val.ints = v->get_ints();
+      val.types |= ConfigSnapshot::TYPE_INT;
+    } catch (Exception &e) {}
+    try {
+      val.bools = v->get_bools();
+      val.types |= ConfigSnapshot::TYPE_BOOL;
+    } catch (Exception &e) {}
+    try {
+      val.strings = v->get_strings();
+      val.types |= ConfigSnapshot::TYPE_STRING;
+    } catch (Exception &e) {}
+  } else {
+    try {
+      if (v->is_float()) {
+	val.f = v->get_float();
+	val.types |= ConfigSnapshot::TYPE_FLOAT;
+      }
+    } catch (Exception &e) {}
+    try {
+      if (v->is_uint()) {
+	val.u = v->get_uint();
+	val.types |= ConfigSnapshot::TYPE_UINT;
+      }
+    } catch (Exception &e) {}
+    try {
+      if (v->is_int()) {
+	val.i = v->get_int();
+	val.types |= ConfigSnapshot::TYPE_INT;
+      }
+    } catch (Exception &e) {}
+    try {
+      if (v->is_bool()) {
+	val.b = v->get_bool();
+	val.types |= ConfigSnapshot::TYPE_BOOL;
+      }
+    } catch (Exception &e) {}
+    try {
+      if (v->is_string()) {
+	val.s = v->get_string();
+	val.types |= ConfigSnapshot::TYPE_STRING;
+      }
+    } catch (Exception &e) {}
+  }
+}
+/// @endcond
+
+
+/** Constructor, creates an empty snapshot. */
+ConfigSnapshot::ConfigSnapshot()
+{
+}
+
+
+/** Constructor.
+ * Reads all values below the prefix.
+ * @param config configuration to read from
+ * @param prefix path prefix of values to read
+ */
+ConfigSnapshot::ConfigSnapshot(Configuration *config, const char *prefix)
+{
+  Configuration::ValueIterator *i = config->search(prefix);
+  try {
+    while (i->next()) {
+      read_value(i, values_[i->path()]);
+    }
+  } catch (Exception &e) {
+    delete i;
+    throw;
+  }
+  delete i;
+}
+
+
+/** Set value.
+ * Only call this on snapshots which have not been published, yet.
+ * @param v value iterator pointing to the value to set
+ */
+void
+ConfigSnapshot::set(const Configuration::ValueIterator *v)
+{
+  read_value(v, values_[v->path()]);
+}
+
+
+/** Erase value.
+ * Erases the value and all values below it. Only call this on snapshots
+ * which have not been published, yet.
+ * @param path path of value to erase
+ */
+void
+ConfigSnapshot::erase(const char *path)
+{
+  values_.erase(path);
+
+  std::string prefix = std::string(path) + "/";
+  for (std::unordered_map<std::string, Value>::iterator v = values_.begin();
+       v != values_.end(); )
+  {
+    if (v->first.compare(0, prefix.length(), prefix) == 0) {
+      v = values_.erase(v);
+    } else {
+      ++v;
+    }
+  }
+}
+
+
+/** Get number of values.
+ * @return number of values in snapshot
+ */
+size_t
+ConfigSnapshot::size() const
+{
+  return values_.size();
+}
+
+
+/** Get value.
+ * @param path path of value
+ * @return value, NULL if it does not exist
+ */
+const ConfigSnapshot::Value *
+ConfigSnapshot::get(const char *path) const
+{
+  std::unordered_map<std::string, Value>::const_iterator v = values_.find(path);
+  return (v != values_.end()) ? &v->second : NULL;
+}
+
+
+/** Get name of type.
+ * @param type type
+ * @return name of type as used by the configuration
+ */
+const char *
+ConfigSnapshot::type_name(Type type)
+{
+  switch (type) {
+  case TYPE_FLOAT:  return "float";
+  case TYPE_UINT:   return "unsigned int";
+  case TYPE_INT:    return "int";
+  case TYPE_BOOL:   return "bool";
+  case TYPE_STRING: return "string";
+  default:          return "unknown";
+  }
+}
+
+
+const ConfigSnapshot::Value &
+ConfigSnapshot::value(const char *path, Type type, bool list) const
+{
+  std::unordered_map<std::string, Value>::const_iterator v = values_.find(path);
+  if (v == values_.end()) {
+    throw ConfigEntryNotFoundException(path);
+  }
+  if (! (v->second.types & type) || (v->second.is_list != list)) {
+    throw ConfigTypeMismatchException(path, v->second.type.c_str(),
+				      list ? (std::string("list of ") + type_name(type)).c_str()
+				           : type_name(type));
+  }
+  return v->second;
+}
+
+
+/** Check if value exists.
+ * @param path path of value
+ * @return true if the value exists, false otherwise
+ */
+bool
+ConfigSnapshot::exists(const char *path) const
+{
+  return values_.find(path) != values_.end();
+}
+
+
+/** Check if value is a default value.
+ * @param path path of value
+ * @return true if the value is a default value, false otherwise
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ */
+bool
+ConfigSnapshot::is_default(const char *path) const
+{
+  const Value *v = get(path);
+  if (! v)  throw ConfigEntryNotFoundException(path);
+  return v->is_default;
+}
+
+
+/** Get float value.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+float
+ConfigSnapshot::get_float(const char *path) const
+{
+  return value(path, TYPE_FLOAT, false).f;
+}
+
+
+/** Get unsigned int value.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+unsigned int
+ConfigSnapshot::get_uint(const char *path) const
+{
+  return value(path, TYPE_UINT, false).u;
+}
+
+
+/** Get int value.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+int
+ConfigSnapshot::get_int(const char *path) const
+{
+  return value(path, TYPE_INT, false).i;
+}
+
+
+/** Get bool value.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+bool
+ConfigSnapshot::get_bool(const char *path) const
+{
+  return value(path, TYPE_BOOL, false).b;
+}
+
+
+/** Get string value.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::string
+ConfigSnapshot::get_string(const char *path) const
+{
+  return value(path, TYPE_STRING, false).s;
+}
+
+
+/** Get float list.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::vector<float>
+ConfigSnapshot::get_floats(const char *path) const
+{
+  return value(path, TYPE_FLOAT, true).floats;
+}
+
+
+/** Get unsigned int list.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::vector<unsigned int>
+ConfigSnapshot::get_uints(const char *path) const
+{
+  return value(path, TYPE_UINT, true).uints;
+}
+
+
+/** Get int list.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::vector<int>
+ConfigSnapshot::get_ints(const char *path) const
+{
+  return value(path, TYPE_INT, true).ints;
+}
+
+
+/** Get bool list.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::vector<bool>
+ConfigSnapshot::get_bools(const char *path) const
+{
+  return value(path, TYPE_BOOL, true).bools;
+}
+
+
+/** Get string list.
+ * @param path path of value
+ * @return value
+ * @exception ConfigEntryNotFoundException thrown if value does not exist
+ * @exception ConfigTypeMismatchException thrown if value has a different type
+ */
+std::vector<std::string>
+ConfigSnapshot::get_strings(const char *path) const
+{
+  return value(path, TYPE_STRING, true).strings;
+}
+
+
+
+/** @class ConfigHandle <config/snapshot.h>
+ * Handle for a single configuration value.
+ * A handle is resolved once with ConfigSnapshotPublisher::handle() and
+ * afterwards reads the current value without locking and lookups. Numeric
+ * and bool values are read with a single atomic load, strings with an
+ * atomic load of a shared pointer. The handle is updated by the publisher
+ * whenever the value changes.
+ * @author Tim Niemueller
+ *
+ * @fn ConfigSnapshot::Type ConfigHandle::type()
+ * Get type of handle.
+ * @return snapshot type corresponding to T
+ */
+
+
+/** @class ConfigSnapshotPublisher <config/snapshot.h>
+ * Publisher of configuration snapshots.
+ * The publisher takes a snapshot of all values below its prefix and
+ * registers as change handler with the configuration. On a change it
+ * copies the current snapshot, applies the change, and then atomically
+ * swaps in the new snapshot and updates all handles. Readers which hold a
+ * snapshot continue to use their copy, it is freed when the last reader
+ * releases it (read-copy-update).
+ *
+ * Use snapshot() to read several values consistently or for lists, and
+ * handle() for values read frequently, e.g. in a thread's loop.
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param config configuration to take snapshots of
+ * @param prefix path prefix of values to include
+ */
+ConfigSnapshotPublisher::ConfigSnapshotPublisher(Configuration *config, const char *prefix)
+  : ConfigurationChangeHandler(prefix)
+{
+  config_  = config;
+  prefix_  = prefix;
+  mutex_   = new Mutex();
+  version_ = 0;
+
+  // register first so that no change gets lost, changes notified before
+  // the first snapshot has been taken are contained in it
+  config_->add_change_handler(this);
+  try {
+    refresh();
+  } catch (Exception &e) {
+    config_->rem_change_handler(this);
+    delete mutex_;
+    throw;
+  }
+}
+
+
+/** Destructor.
+ * All handles become invalid.
+ */
+ConfigSnapshotPublisher::~ConfigSnapshotPublisher()
+{
+  config_->rem_change_handler(this);
+  std::map<std::pair<std::string, int>, ConfigHandleSlot *>::iterator s;
+  for (s = slots_.begin(); s != slots_.end(); ++s) {
+    delete s->second;
+  }
+  delete mutex_;
+}
+
+
+/** Get current snapshot.
+ * @return current snapshot, remains valid and unchanged as long as it is
+ * referenced
+ */
+std::shared_ptr<const ConfigSnapshot>
+ConfigSnapshotPublisher::snapshot() const
+{
+  return std::atomic_load(&snapshot_);
+}
+
+
+/** Get snapshot version.
+ * @return number of snapshots published so far, increases with every change
+ */
+unsigned int
+ConfigSnapshotPublisher::version() const
+{
+  return __atomic_load_n(&version_, __ATOMIC_ACQUIRE);
+}
+
+
+/** Take a new snapshot of the configuration and publish it. */
+void
+ConfigSnapshotPublisher::refresh()
+{
+  // read under the lock, changes notified meanwhile are applied afterwards
+  MutexLocker lock(mutex_);
+  std::shared_ptr<const ConfigSnapshot> s(new ConfigSnapshot(config_, prefix_.c_str()));
+  publish(s);
+}
+
+
+const ConfigHandleSlot *
+ConfigSnapshotPublisher::slot(const char *path, ConfigSnapshot::Type type)
+{
+  MutexLocker lock(mutex_);
+
+  std::pair<std::string, int> key(path, type);
+  std::map<std::pair<std::string, int>, ConfigHandleSlot *>::iterator s = slots_.find(key);
+  if (s != slots_.end())  return s->second;
+
+  ConfigHandleSlot *slot = new ConfigHandleSlot();
+  slot->path = path;
+  slot->type = type;
+  slot->value = 0;
+  slot->actual_type = "unknown";
+  update_slot(slot, *snapshot_);
+  slots_[key] = slot;
+  return slot;
+}
+
+
+void
+ConfigSnapshotPublisher::update_slot(ConfigHandleSlot *slot, const ConfigSnapshot &snapshot)
+{
+  const ConfigSnapshot::Value *v = snapshot.get(slot->path.c_str());
+
+  uint64_t state = ConfigHandleSlot::MISSING;
+  uint32_t bits  = 0;
+  std::shared_ptr<const std::string> string;
+
+  if (v) {
+    if (v->is_list || ! (v->types & slot->type)) {
+      state = ConfigHandleSlot::MISMATCH;
+      // readers may access the name at any time, use a static string
+      const char *actual_type = "unknown";
+      if (v->is_list) {
+	actual_type = "list";
+      } else {
+	for (unsigned int t = ConfigSnapshot::TYPE_FLOAT; t <= ConfigSnapshot::TYPE_STRING; t <<= 1) {
+	  const char *name = ConfigSnapshot::type_name((ConfigSnapshot::Type)t);
+	  if (v->type == name)  actual_type = name;
+	}
+      }
+      __atomic_store_n(&slot->actual_type, actual_type, __ATOMIC_RELEASE);
+    } else {
+      state = ConfigHandleSlot::VALID;
+      switch (slot->type) {
+      case ConfigSnapshot::TYPE_FLOAT: memcpy(&bits, &v->f, sizeof(bits)); break;
+      case ConfigSnapshot::TYPE_UINT:  bits = v->u;                        break;
+      case ConfigSnapshot::TYPE_INT:   memcpy(&bits, &v->i, sizeof(bits)); break;
+      case ConfigSnapshot::TYPE_BOOL:  bits = v->b ? 1 : 0;                break;
+      case ConfigSnapshot::TYPE_STRING:
+	string = std::make_shared<const std::string>(v->s);
+	break;
+      }
+    }
+  }
+
+  std::atomic_store(&slot->string, string);
+  __atomic_store_n(&slot->value, (state << 32) | bits, __ATOMIC_RELEASE);
+}
+
+
+void
+ConfigSnapshotPublisher::publish(std::shared_ptr<const ConfigSnapshot> snapshot)
+{
+  std::atomic_store(&snapshot_, snapshot);
+
+  std::map<std::pair<std::string, int>, ConfigHandleSlot *>::iterator s;
+  for (s = slots_.begin(); s != slots_.end(); ++s) {
+    update_slot(s->second, *snapshot);
+  }
+  __atomic_add_fetch(&version_, 1, __ATOMIC_RELEASE);
+}
+
+
+void
+ConfigSnapshotPublisher::config_tag_changed(const char *new_tag)
+{
+  refresh();
+}
+
+
+void
+ConfigSnapshotPublisher::config_value_changed(const Configuration::ValueIterator *v)
+{
+  MutexLocker lock(mutex_);
+  if (! snapshot_)  return;
+  std::shared_ptr<ConfigSnapshot> s(new ConfigSnapshot(*snapshot_));
+  s->set(v);
+  publish(s);
+}
+
+
+void
+ConfigSnapshotPublisher::config_comment_changed(const Configuration::ValueIterator *v)
+{
+}
+
+
+void
+ConfigSnapshotPublisher::config_value_erased(const char *path)
+{
+  MutexLocker lock(mutex_);
+  if (! snapshot_)  return;
+  std::shared_ptr<ConfigSnapshot> s(new ConfigSnapshot(*snapshot_));
+  s->erase(path);
+  publish(s);
+}
+
+
+} // end namespace fawkes
@@ -0,0 +1,322 @@
+
+/***************************************************************************
+ *  snapshot.h - Immutable configuration snapshots and value handles
+ *
+ *  Created: Mon Oct 19 09:12:48 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _CONFIG_SNAPSHOT_H_
+#define _CONFIG_SNAPSHOT_H_
+
+#include <config/config.h>
+#include <config/change_handler.h>
+
+#include <stdint.h>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fawkes {
+
+class Mutex;
+
+class ConfigSnapshot
+{
+ public:
+  /** Types a value can be read as. */
+  typedef enum {
+    TYPE_FLOAT  = 1,	/**< float */
+    TYPE_UINT   = 2,	/**< unsigned int */
+    TYPE_INT    = 4,	/**< int */
+    TYPE_BOOL   = 8,	/**< bool */
+    TYPE_STRING = 16	/**< string */
+  } Type;
+
+  /** Configuration value as stored in a snapshot. */
+  class Value {
+   public:
+    std::string   type;		/**< type as reported by the configuration */
+    unsigned int  types;	/**< bit mask of types the value can be read as */
+    bool          is_list;	/**< true if the value is a list */
+    bool          is_default;	/**< true if this is a default value */
+
+    float         f;		/**< float value */
+    unsigned int  u;		/**< unsigned int value */
+    int           i;		/**< int value */
+    bool          b;		/**< bool value */
+    std::string   s;		/**< string value */
+
+    std::vector<float>         floats;	/**< float list */
+    std::vector<unsigned int>  uints;	/**< unsigned int list */
+    std::vector<int>           ints;	/**< int list */
+    std::vector<bool>          bools;	/**< bool list */
+    std::vector<std::string>   strings;	/**< string list */
+  };
+
+  ConfigSnapshot();
+  ConfigSnapshot(Configuration *config, const char *prefix = "/");
+
+  void           set(const Configuration::ValueIterator *v);
+  void           erase(const char *path);
+
+  size_t         size() const;
+  const Value *  get(const char *path) const;
+
+  bool           exists(const char *path) const;
+  bool           is_default(const char *path) const;
+
+  float          get_float(const char *path) const;
+  unsigned int   get_uint(const char *path) const;
+  int            get_int(const char *path) const;
+  bool           get_bool(const char *path) const;
+  std::string    get_string(const char *path) const;
+
+  std::vector<float>         get_floats(const char *path) const;
+  std::vector<unsigned int>  get_uints(const char *path) const;
+  std::vector<int>           get_ints(const char *path) const;
+  std::vector<bool>          get_bools(const char *path) const;
+  std::vector<std::string>   get_strings(const char *path) const;
+
+  static const char *  type_name(Type type);
+
+ private:
+  const Value &  value(const char *path, Type type, bool list) const;
+
+ private:
+  std::unordered_map<std::string, Value> values_;
+};
+
+
+/// @cond INTERNALS
+class ConfigHandleSlot
+{
+ public:
+  /** States stored in the upper half of value. */
+  enum { MISSING = 0, VALID = 1, MISMATCH = 2 };
+
+  std::string    path;
+  ConfigSnapshot::Type type;
+  uint64_t       value;
+  std::shared_ptr<const std::string> string;
+  const char    *actual_type;
+};
+/// @endcond
+
+
+template <typename T>
+class ConfigHandle
+{
+ public:
+  /** Constructor, creates an unresolved handle. */
+  ConfigHandle() : slot_(NULL) {}
+
+  /** Constructor.
+   * @param slot slot to read from
+   */
+  ConfigHandle(const ConfigHandleSlot *slot) : slot_(slot) {}
+
+  /** Check if the handle has been resolved.
+   * @return true if the handle refers to a path, false otherwise
+   */
+  bool resolved() const
+  { return slot_ != NULL; }
+
+  /** Get path of value.
+   * @return path of value
+   */
+  const char * path() const
+  { return slot_->path.c_str(); }
+
+  bool exists() const;
+  T    get() const;
+  T    get_or_default(const T &default_val) const;
+
+  static ConfigSnapshot::Type type();
+
+ private:
+  const ConfigHandleSlot *slot_;
+};
+
+
+class ConfigSnapshotPublisher : public ConfigurationChangeHandler
+{
+ public:
+  ConfigSnapshotPublisher(Configuration *config, const char *prefix = "/");
+  virtual ~ConfigSnapshotPublisher();
+
+  std::shared_ptr<const ConfigSnapshot> snapshot() const;
+  unsigned int  version() const;
+
+  void          refresh();
+
+  /** Get handle for a value.
+   * Handles are resolved once and afterwards read the current value without
+   * locking. They are valid as long as the publisher exists.
+   * @param path path of value
+   * @return handle for value at the given path
+   */
+  template <typename T>
+    ConfigHandle<T> handle(const char *path)
+  { return ConfigHandle<T>(slot(path, ConfigHandle<T>::type())); }
+
+  virtual void config_tag_changed(const char *new_tag);
+  virtual void config_value_changed(const Configuration::ValueIterator *v);
+  virtual void config_comment_changed(const Configuration::ValueIterator *v);
+  virtual void config_value_erased(const char *path);
+
+ private:
+  const ConfigHandleSlot * slot(const char *path, ConfigSnapshot::Type type);
+  void  publish(std::shared_ptr<const ConfigSnapshot> snapshot);
+  void  update_slot(ConfigHandleSlot *slot, const ConfigSnapshot &snapshot);
+
+ private:
+  Configuration   *config_;
+  std::string      prefix_;
+  Mutex           *mutex_;
+  unsigned int     version_;
+
+  std::shared_ptr<const ConfigSnapshot>  snapshot_;
+  std::map<std::pair<std::string, int>, ConfigHandleSlot *>  slots_;
+};
+
+
+/** Check if value exists with the type of the handle.
+ * @return true if the value exists and can be read as type T
+ */
+template <typename T>
+inline bool
+ConfigHandle<T>::exists() const
+{
+  return (__atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE) >> 32) == ConfigHandleSlot::VALID;
+}
+
+
+/** Get value.
+ * @return current value
+ * @exception ConfigEntryNotFoundException thrown if the value does not exist
+ * @exception ConfigTypeMismatchException thrown if the value cannot be read
+ * as type T
+ */
+template <typename T>
+inline T
+ConfigHandle<T>::get() const
+{
+  uint64_t v = __atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE);
+  switch (v >> 32) {
+  case ConfigHandleSlot::VALID:
+    {
+      uint32_t bits = v & 0xFFFFFFFF;
+      T rv;
+      memcpy(&rv, &bits, sizeof(T));
+      return rv;
+    }
+  case ConfigHandleSlot::MISSING:
+    throw ConfigEntryNotFoundException(slot_->path.c_str());
+  default:
+    throw ConfigTypeMismatchException(slot_->path.c_str(),
+				      __atomic_load_n(&slot_->actual_type, __ATOMIC_ACQUIRE),
+				      ConfigSnapshot::type_name(type()));
+  }
+}
+
+
+/** Get value or default.
+ * @param default_val value to return if the value does not exist or has a
+ * different type
+ * @return current value or default
+ */
+template <typename T>
+inline T
+ConfigHandle<T>::get_or_default(const T &default_val) const
+{
+  uint64_t v = __atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE);
+  if ((v >> 32) != ConfigHandleSlot::VALID)  return default_val;
+  uint32_t bits = v & 0xFFFFFFFF;
+  T rv;
+  memcpy(&rv, &bits, sizeof(T));
+  return rv;
+}
+
+
+/// @cond INTERNALS
+template <>
+inline bool
+ConfigHandle<bool>::get() const
+{
+  uint64_t v = __atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE);
+  switch (v >> 32) {
+  case ConfigHandleSlot::VALID:    return (v & 0xFFFFFFFF) != 0;
+  case ConfigHandleSlot::MISSING:  throw ConfigEntryNotFoundException(slot_->path.c_str());
+  default:
+    throw ConfigTypeMismatchException(slot_->path.c_str(),
+				      __atomic_load_n(&slot_->actual_type, __ATOMIC_ACQUIRE),
+				      "bool");
+  }
+}
+
+template <>
+inline bool
+ConfigHandle<bool>::get_or_default(const bool &default_val) const
+{
+  uint64_t v = __atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE);
+  if ((v >> 32) != ConfigHandleSlot::VALID)  return default_val;
+  return (v & 0xFFFFFFFF) != 0;
+}
+
+template <>
+inline std::string
+ConfigHandle<std::string>::get() const
+{
+  std::shared_ptr<const std::string> s = std::atomic_load(&slot_->string);
+  if (s)  return *s;
+  if ((__atomic_load_n(&slot_->value, __ATOMIC_ACQUIRE) >> 32) == ConfigHandleSlot::MISSING) {
+    throw ConfigEntryNotFoundException(slot_->path.c_str());
+  } else {
+    throw ConfigTypeMismatchException(slot_->path.c_str(),
+				      __atomic_load_n(&slot_->actual_type, __ATOMIC_ACQUIRE),
+				      "string");
+  }
+}
+
+template <>
+inline std::string
+ConfigHandle<std::string>::get_or_default(const std::string &default_val) const
+{
+  std::shared_ptr<const std::string> s = std::atomic_load(&slot_->string);
+  return s ? *s : default_val;
+}
+
+template <> inline ConfigSnapshot::Type
+ConfigHandle<float>::type() { return ConfigSnapshot::TYPE_FLOAT; }
+template <> inline ConfigSnapshot::Type
+ConfigHandle<unsigned int>::type() { return ConfigSnapshot::TYPE_UINT; }
+template <> inline ConfigSnapshot::Type
+ConfigHandle<int>::type() { return ConfigSnapshot::TYPE_INT; }
+template <> inline ConfigSnapshot::Type
+ConfigHandle<bool>::type() { return ConfigSnapshot::TYPE_BOOL; }
+template <> inline ConfigSnapshot::Type
+ConfigHandle<std::string>::type() { return ConfigSnapshot::TYPE_STRING; }
+/// @endcond
+
+} // end namespace fawkes
+
+#endif
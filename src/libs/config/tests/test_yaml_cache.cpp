@@ -0,0 +1,241 @@
+/***************************************************************************
+ *  test_yaml_cache.cpp - YAML configuration cache unit test
+ *
+ *  Created: Sat Oct 17 16:48:20 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL file in the doc directory.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <config/yaml.h>
+#include <core/exception.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace fawkes;
+
+/** Write content to file.
+ * @param filename file to write to
+ * @param content content to write
+ */
+static void
+write_file(const std::string &filename, const std::string &content)
+{
+  FILE *f = fopen(filename.c_str(), "w");
+  fwrite(content.data(), content.size(), 1, f);
+  fclose(f);
+}
+
+/** Read content of file.
+ * @param filename file to read
+ * @return file content, empty string if the file cannot be opened
+ */
+static std::string
+read_file(const std::string &filename)
+{
+  std::string rv;
+  FILE *f = fopen(filename.c_str(), "r");
+  if (! f)  return rv;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)  rv.append(buf, n);
+  fclose(f);
+  return rv;
+}
+
+/** @class YamlCacheTest
+ * Fixture providing a temporary configuration with an included directory
+ * and a missing optional file. The configuration is loaded once so that
+ * the cache has been written when a test starts.
+ */
+class YamlCacheTest : public ::testing::Test
+{
+ protected:
+  virtual void SetUp()
+  {
+    char tmpl[] = "/tmp/test_yaml_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+    basedir = tmpl;
+    mkdir((basedir + "/sys").c_str(), 0755);
+    mkdir((basedir + "/sys/conf.d").c_str(), 0755);
+    mkdir((basedir + "/user").c_str(), 0755);
+
+    write_file(basedir + "/sys/config.yaml",
+	       "%YAML 1.2\n%TAG ! tag:fawkesrobotics.org,cfg/\n---\n"
+	       "include:\n  - " + basedir + "/sys/conf.d/\n"
+	       "  - !ignore-missing " + basedir + "/sys/optional.yaml\n"
+	       "---\nqa:\n  main: main value\n");
+    write_value("conf.d/a.yaml", "a", "original");
+
+    // first load parses and writes the cache
+    ASSERT_EQ("original", load_value("/qa/a"));
+    ASSERT_NE("", cache_file());
+  }
+
+  virtual void TearDown()
+  {
+    if (system(("rm -rf " + basedir).c_str()) != 0) {
+      ADD_FAILURE() << "Failed to remove " << basedir;
+    }
+  }
+
+  /** Get the only file in the cache directory.
+   * @return cache file name, empty string if there is none
+   */
+  std::string cache_file()
+  {
+    std::string dirname = basedir + "/user/cache";
+    std::string rv;
+    DIR *d = opendir(dirname.c_str());
+    if (! d)  return rv;
+    struct dirent *dent;
+    while ((dent = readdir(d)) != NULL) {
+      if (dent->d_name[0] != '.')  rv = dirname + "/" + dent->d_name;
+    }
+    closedir(d);
+    return rv;
+  }
+
+  /** Write configuration file with a single value below /qa.
+   * @param filename file name relative to the system config directory
+   * @param key key of the value
+   * @param value value
+   */
+  void write_value(const char *filename, const char *key, const char *value)
+  {
+    write_file(basedir + "/sys/" + filename,
+	       std::string("%YAML 1.2\n---\nqa:\n  ") + key + ": " + value + "\n");
+  }
+
+  /** Load configuration and get a value.
+   * @param path path of the value
+   * @return value, empty string on failure
+   */
+  std::string load_value(const char *path)
+  {
+    YamlConfiguration *config =
+      new YamlConfiguration((basedir + "/sys").c_str(), (basedir + "/user").c_str());
+    std::string rv;
+    try {
+      config->load("config.yaml");
+      rv = config->get_string(path);
+    } catch (Exception &e) {
+      e.print_trace();
+    }
+    delete config;
+    return rv;
+  }
+
+  /** Replace string in cache file keeping its size.
+   * A load that reads the cache then yields the replacement, while
+   * parsing yields the original.
+   * @param from string to replace
+   * @param to replacement of the same size
+   * @return true if the string was found and replaced, false otherwise
+   */
+  bool tamper_cache(const std::string &from, const std::string &to)
+  {
+    std::string c = read_file(cache_file());
+    size_t pos = c.find(from);
+    if (pos == std::string::npos)  return false;
+    c.replace(pos, from.size(), to);
+    write_file(cache_file(), c);
+    return true;
+  }
+
+  /** Temporary base directory. */
+  std::string basedir;
+};
+
+TEST_F(YamlCacheTest, CacheHit)
+{
+  ASSERT_TRUE(tamper_cache("original", "ORIGINAL"));
+  EXPECT_EQ("ORIGINAL", load_value("/qa/a"));
+  EXPECT_EQ("main value", load_value("/qa/main"));
+}
+
+TEST_F(YamlCacheTest, ChangedFile)
+{
+  // changed file invalidates the cache, which is rewritten
+  write_value("conf.d/a.yaml", "a", "changed value");
+  EXPECT_EQ("changed value", load_value("/qa/a"));
+  ASSERT_TRUE(tamper_cache("changed value", "CHANGED VALUE"));
+  EXPECT_EQ("CHANGED VALUE", load_value("/qa/a"));
+}
+
+TEST_F(YamlCacheTest, NewFileInDirectory)
+{
+  ASSERT_TRUE(tamper_cache("original", "ORIGINAL"));
+  write_value("conf.d/b.yaml", "b", "new file");
+  EXPECT_EQ("new file", load_value("/qa/b"));
+  EXPECT_EQ("original", load_value("/qa/a"));
+}
+
+TEST_F(YamlCacheTest, AppearingOptionalFile)
+{
+  ASSERT_TRUE(tamper_cache("original", "ORIGINAL"));
+  write_value("optional.yaml", "o", "optional");
+  EXPECT_EQ("optional", load_value("/qa/o"));
+  EXPECT_EQ("original", load_value("/qa/a"));
+}
+
+TEST_F(YamlCacheTest, TruncatedCache)
+{
+  // corrupt caches are ignored and replaced
+  std::string valid = read_file(cache_file());
+  const size_t cuts[] = { 0, 4, 8, 12, valid.size() / 2, valid.size() - 1 };
+  for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); ++i) {
+    write_file(cache_file(), valid.substr(0, cuts[i]));
+    EXPECT_EQ("original", load_value("/qa/a")) << "cut at " << cuts[i];
+    EXPECT_EQ(valid, read_file(cache_file())) << "cut at " << cuts[i];
+  }
+}
+
+TEST_F(YamlCacheTest, CorruptTree)
+{
+  // huge counts and invalid node types in the tree, the child key "main"
+  // is followed by the node with type, default flag, name and value
+  std::string valid = read_file(cache_file());
+  std::string marker = std::string("\x04\0\0\0main", 8);
+  size_t pos = valid.find(marker);
+  ASSERT_NE(std::string::npos, pos);
+  size_t node_pos = pos + marker.size();
+  size_t count_pos = node_pos + 2 + marker.size() + 4 + strlen("main value");
+
+  std::string corrupt = valid;
+  corrupt.replace(count_pos, 4, "\xff\xff\xff\x7f", 4);
+  write_file(cache_file(), corrupt);
+  EXPECT_EQ("main value", load_value("/qa/main")) << "huge list count";
+
+  corrupt = valid;
+  corrupt.replace(count_pos + 4, 4, "\xff\xff\xff\x7f", 4);
+  write_file(cache_file(), corrupt);
+  EXPECT_EQ("main value", load_value("/qa/main")) << "huge child count";
+
+  // type byte of the node
+  corrupt = valid;
+  corrupt[node_pos] = 42;
+  write_file(cache_file(), corrupt);
+  EXPECT_EQ("main value", load_value("/qa/main")) << "invalid node type";
+}
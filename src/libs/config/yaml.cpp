@@ -40,6 +40,9 @@
 #include <cerrno>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/socket.h>
 #include <regex>
 
@@ -313,6 +316,7 @@ YamlConfiguration::YamlConfiguration()
 	mutex = new Mutex();
 	write_pending_ = false;
 	write_pending_mutex_ = new Mutex();
+	cache_enabled_ = true;
 
 	sysconfdir_   = NULL;
 	userconfdir_  = NULL;
@@ -334,6 +338,7 @@ YamlConfiguration::YamlConfiguration(const char *sysconfdir,
 	mutex = new Mutex();
 	write_pending_ = false;
 	write_pending_mutex_ = new Mutex();
+	cache_enabled_ = true;
 
 	sysconfdir_   = strdup(sysconfdir);
 
@@ -409,7 +414,11 @@ YamlConfiguration::load(const char *file_path)
 
 	host_file_ = "";
 	std::list<std::string> files, dirs;
-	read_yaml_config(filename, host_file_, root_, host_root_, files, dirs);
+	if (! read_cache(files, dirs)) {
+		CacheSourceList sources;
+		read_yaml_config(filename, host_file_, root_, host_root_, files, dirs, &sources);
+		write_cache(sources, files, dirs);
+	}
 
 #ifdef HAVE_INOTIFY
 	fam_thread_ = new FamThread();
@@ -480,7 +489,8 @@ void
 YamlConfiguration::read_yaml_config(std::string filename, std::string &host_file,
                                     std::shared_ptr<YamlConfigurationNode>& root,
                                     std::shared_ptr<YamlConfigurationNode>& host_root,
-                                    std::list<std::string> &files, std::list<std::string> &dirs)
+                                    std::list<std::string> &files, std::list<std::string> &dirs,
+                                    CacheSourceList *sources)
 {
 	root = std::make_shared<YamlConfigurationNode>();
 
@@ -489,6 +499,7 @@ YamlConfiguration::read_yaml_config(std::string filename, std::string &host_file
 
 	while (! load_queue.empty()) {
 		LoadQueueEntry &qe = load_queue.front();
+		if (sources)  sources->push_back(std::make_pair(qe.filename, qe.state));
 
 		if (qe.is_dir) {
 			dirs.push_back(qe.filename);
@@ -513,6 +524,11 @@ YamlConfiguration::read_yaml_config(std::string filename, std::string &host_file
 		//LibLogger::log_debug("YamlConfiguration",
 		//			 "Reading Host YAML file '%s'", host_file.c_str());
 		std::queue<LoadQueueEntry> host_load_queue;
+		if (sources) {
+			CacheSourceState state;
+			cache_stat(host_file, state);
+			sources->push_back(std::make_pair(host_file, state));
+		}
 		host_root = read_yaml_file(host_file, true, host_load_queue, host_file);
 		if (! host_load_queue.empty()) {
 			throw CouldNotOpenConfigException("YamlConfig: includes are not allowed "
@@ -692,6 +708,222 @@ YamlConfiguration::write_host_file()
 }
 
 
+/** Enable or disable the configuration cache.
+ * If enabled (the default), load() stores the merged configuration tree
+ * in a binary cache file in the user configuration directory. Subsequent
+ * loads read that file instead of parsing the YAML files, as long as none
+ * of the files (or the included directories) has changed. Call this
+ * before load().
+ * @param enabled true to enable the cache, false to disable it
+ */
+void
+YamlConfiguration::set_cache_enabled(bool enabled)
+{
+	cache_enabled_ = enabled;
+}
+
+
+/// @cond INTERNALS
+#define YAML_CACHE_MAGIC   "FFYCACHE"
+#define YAML_CACHE_VERSION 1
+/// @endcond
+
+
+/** Get state of a configuration source.
+ * @param path path of the file or directory
+ * @param s upon return the state of the source, zero if it does not exist
+ */
+void
+YamlConfiguration::cache_stat(const std::string &path, CacheSourceState &s)
+{
+	memset(&s, 0, sizeof(s));
+	struct stat st;
+	if (stat(path.c_str(), &st) == 0) {
+		s.exists     = 1;
+		s.mtime_sec  = st.st_mtim.tv_sec;
+		s.mtime_nsec = st.st_mtim.tv_nsec;
+		s.size       = st.st_size;
+		s.ino        = st.st_ino;
+	}
+}
+
+
+/** Get path of cache file.
+ * @return path of cache file for the current configuration file, empty
+ * string if caching is not possible
+ */
+std::string
+YamlConfiguration::cache_file() const
+{
+	if (! cache_enabled_ || ! userconfdir_)  return "";
+
+	// FNV-1a hash of the config file path to support multiple configs
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < config_file_.length(); ++i) {
+		hash = (hash ^ (unsigned char)config_file_[i]) * 16777619u;
+	}
+	char *filename;
+	if (asprintf(&filename, "%s/cache/config-%08x.bin", userconfdir_, hash) == -1) {
+		return "";
+	}
+	std::string rv = filename;
+	free(filename);
+	return rv;
+}
+
+
+/** Read configuration from cache.
+ * @param files upon success contains the files to watch
+ * @param dirs upon success contains the directories to watch
+ * @return true if the cache was valid and has been read, false otherwise
+ */
+bool
+YamlConfiguration::read_cache(std::list<std::string> &files, std::list<std::string> &dirs)
+{
+	std::string filename = cache_file();
+	if (filename == "")  return false;
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1)  return false;
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+		close(fd);
+		return false;
+	}
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)  return false;
+
+	const char *p   = (const char *)data;
+	const char *end = p + st.st_size;
+	bool valid = false;
+
+	try {
+		if ((end - p < 8) || (memcmp(p, YAML_CACHE_MAGIC, 8) != 0)) {
+			throw Exception("YamlConfig: invalid cache file");
+		}
+		p += 8;
+		if (YamlConfigurationNode::deserialize_size(p, end) != YAML_CACHE_VERSION) {
+			throw Exception("YamlConfig: cache file version mismatch");
+		}
+		if (YamlConfigurationNode::deserialize_string(p, end) != config_file_) {
+			throw Exception("YamlConfig: cache file of other configuration");
+		}
+		std::string host_file = YamlConfigurationNode::deserialize_string(p, end);
+
+		uint32_t num_sources = YamlConfigurationNode::deserialize_size(p, end);
+		for (uint32_t i = 0; i < num_sources; ++i) {
+			std::string source = YamlConfigurationNode::deserialize_string(p, end);
+			CacheSourceState cached, current;
+			if (end - p < (ptrdiff_t)sizeof(cached)) {
+				throw Exception("YamlConfig: truncated cache file");
+			}
+			memcpy(&cached, p, sizeof(cached));
+			p += sizeof(cached);
+			cache_stat(source, current);
+			if (memcmp(&cached, &current, sizeof(cached)) != 0) {
+				// source has changed, parse again
+				munmap(data, st.st_size);
+				return false;
+			}
+		}
+
+		std::list<std::string> cfiles, cdirs;
+		uint32_t num_files = YamlConfigurationNode::deserialize_size(p, end);
+		for (uint32_t i = 0; i < num_files; ++i) {
+			cfiles.push_back(YamlConfigurationNode::deserialize_string(p, end));
+		}
+		uint32_t num_dirs = YamlConfigurationNode::deserialize_size(p, end);
+		for (uint32_t i = 0; i < num_dirs; ++i) {
+			cdirs.push_back(YamlConfigurationNode::deserialize_string(p, end));
+		}
+
+		std::shared_ptr<YamlConfigurationNode> root =
+			YamlConfigurationNode::deserialize(p, end);
+		std::shared_ptr<YamlConfigurationNode> host_root =
+			YamlConfigurationNode::deserialize(p, end);
+
+		root_      = root;
+		host_root_ = host_root;
+		host_file_ = host_file;
+		files.swap(cfiles);
+		dirs.swap(cdirs);
+		valid = true;
+	} catch (Exception &e) {
+		LibLogger::log_warn("YamlConfiguration", "Ignoring config cache %s: %s",
+		                    filename.c_str(), e.what_no_backtrace());
+	} catch (std::exception &e) {
+		// e.g. std::bad_alloc on corrupt sizes
+		LibLogger::log_warn("YamlConfiguration", "Ignoring config cache %s: %s",
+		                    filename.c_str(), e.what());
+	}
+
+	munmap(data, st.st_size);
+	return valid;
+}
+
+
+/** Write configuration cache.
+ * Errors are ignored, the configuration is then parsed on the next load.
+ * @param sources all files and directories the configuration was read from,
+ * including missing optional files, with their state taken before they
+ * were read, such that changes during parsing invalidate the cache
+ * @param files files to watch
+ * @param dirs directories to watch
+ */
+void
+YamlConfiguration::write_cache(const CacheSourceList &sources,
+                               const std::list<std::string> &files,
+                               const std::list<std::string> &dirs)
+{
+	std::string filename = cache_file();
+	if (filename == "")  return;
+
+	std::string cachedir = filename.substr(0, filename.rfind('/'));
+	if ( ((mkdir(userconfdir_, 0755) != 0) && (errno != EEXIST)) ||
+	     ((mkdir(cachedir.c_str(), 0755) != 0) && (errno != EEXIST)) )
+	{
+		return;
+	}
+
+	std::string out = YAML_CACHE_MAGIC;
+	YamlConfigurationNode::serialize_size(out, YAML_CACHE_VERSION);
+	YamlConfigurationNode::serialize_string(out, config_file_);
+	YamlConfigurationNode::serialize_string(out, host_file_);
+
+	YamlConfigurationNode::serialize_size(out, sources.size());
+	for (CacheSourceList::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+		YamlConfigurationNode::serialize_string(out, s->first);
+		out.append((const char *)&s->second, sizeof(s->second));
+	}
+	std::list<std::string>::const_iterator i;
+	YamlConfigurationNode::serialize_size(out, files.size());
+	for (i = files.begin(); i != files.end(); ++i) {
+		YamlConfigurationNode::serialize_string(out, *i);
+	}
+	YamlConfigurationNode::serialize_size(out, dirs.size());
+	for (i = dirs.begin(); i != dirs.end(); ++i) {
+		YamlConfigurationNode::serialize_string(out, *i);
+	}
+	root_->serialize(out);
+	host_root_->serialize(out);
+
+	// write to temporary file and rename, concurrent loads read either
+	// the old or the new cache
+	char *tmpfile;
+	if (asprintf(&tmpfile, "%s.%i", filename.c_str(), getpid()) == -1)  return;
+	FILE *f = fopen(tmpfile, "w");
+	if (f) {
+		bool ok = (fwrite(out.data(), out.size(), 1, f) == 1);
+		ok = (fclose(f) == 0) && ok;
+		if (! ok || (rename(tmpfile, filename.c_str()) != 0)) {
+			unlink(tmpfile);
+		}
+	}
+	free(tmpfile);
+}
+
+
 void
 YamlConfiguration::copy(Configuration *copyconf)
 {
@@ -1048,6 +1280,7 @@ YamlConfiguration::erase(const char *path)
 	host_root_->erase(path);
 	root_->erase(path);
 	write_host_file();
+	notify_handlers(path, false);
 }
 
 void
@@ -32,6 +32,9 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <list>
+#include <utility>
+#include <stdint.h>
 
 namespace fawkes {
 
@@ -114,6 +117,8 @@ class YamlConfiguration
 
   virtual void            try_dump();
 
+  void set_cache_enabled(bool enabled);
+
   virtual void fam_event(const char *filename, unsigned int mask);
 
  public:
@@ -162,14 +167,32 @@ class YamlConfiguration
 
  private:
   /// @cond INTERNALS
+  /** Source file state used to validate the cache. */
+  typedef struct {
+    int64_t   mtime_sec;
+    int64_t   mtime_nsec;
+    int64_t   size;
+    uint64_t  ino;
+    uint32_t  exists;
+    uint32_t  reserved;
+  } CacheSourceState;
+
+  typedef std::list<std::pair<std::string, CacheSourceState>> CacheSourceList;
+
+  static void cache_stat(const std::string &path, CacheSourceState &state);
+
+  // the state of the source is taken when it is queued, i.e. before it
+  // is read or, for directories, listed
   class LoadQueueEntry {
    public:
   LoadQueueEntry(std::string fn, bool im, bool id = false)
-    : filename(fn), ignore_missing(im), is_dir(id) {}
+    : filename(fn), ignore_missing(im), is_dir(id)
+    { cache_stat(filename, state); }
 
     std::string filename;
     bool ignore_missing;
     bool is_dir;
+    CacheSourceState state;
   };
   /// @endcond
 
@@ -182,9 +205,16 @@ class YamlConfiguration
   void read_yaml_config(std::string filename, std::string &host_file,
                         std::shared_ptr<YamlConfigurationNode>& root,
                         std::shared_ptr<YamlConfigurationNode>& host_root,
-                        std::list<std::string> &files, std::list<std::string> &dirs);
+                        std::list<std::string> &files, std::list<std::string> &dirs,
+                        CacheSourceList *sources = NULL);
   void write_host_file();
 
+  std::string cache_file() const;
+  bool read_cache(std::list<std::string> &files, std::list<std::string> &dirs);
+  void write_cache(const CacheSourceList &sources,
+                   const std::list<std::string> &files,
+                   const std::list<std::string> &dirs);
+
   std::string config_file_;
   std::string host_file_;
 
@@ -194,6 +224,8 @@ class YamlConfiguration
   bool   write_pending_;
   Mutex *write_pending_mutex_;
 
+  bool   cache_enabled_;
+
  private:
   Mutex *mutex;
 
@@ -43,6 +43,8 @@
 #include <arpa/inet.h>
 #include <regex>
 #include <memory>
+#include <cstring>
+#include <stdint.h>
 
 namespace fawkes {
 
@@ -937,6 +939,110 @@ class YamlConfigurationNode : public std::enable_shared_from_this<YamlConfigurat
 		name() const
 	{ return name_; }
 
+	/** Serialize node and its children.
+	 * The result can be restored with deserialize() without parsing and
+	 * verifying the values again.
+	 * @param out string to append serialized node to
+	 */
+	void serialize(std::string &out) const
+	{
+		out.push_back((char)type_);
+		out.push_back(is_default_ ? 1 : 0);
+		serialize_string(out, name_);
+		serialize_string(out, scalar_value_);
+		serialize_size(out, list_values_.size());
+		for (size_t i = 0; i < list_values_.size(); ++i) {
+			serialize_string(out, list_values_[i]);
+		}
+		serialize_size(out, children_.size());
+		std::map<std::string, std::shared_ptr<YamlConfigurationNode>>::const_iterator c;
+		for (c = children_.begin(); c != children_.end(); ++c) {
+			serialize_string(out, c->first);
+			c->second->serialize(out);
+		}
+	}
+
+	/** Restore serialized node.
+	 * Counts are checked against the remaining data before anything is
+	 * allocated, such that corrupt data cannot cause huge allocations.
+	 * @param p pointer to serialized data, upon return points behind node
+	 * @param end end of serialized data
+	 * @param depth depth of the node in the tree
+	 * @return restored node
+	 * @exception Exception thrown if the data is truncated or corrupt
+	 */
+	static std::shared_ptr<YamlConfigurationNode>
+		deserialize(const char *&p, const char *end, unsigned int depth = 0)
+	{
+		// type, default flag, name, value, list and children counts
+		const size_t min_node_size = 2 + 4 * sizeof(uint32_t);
+
+		if (depth > 256) {
+			throw Exception("YamlConfig: serialized tree too deep");
+		}
+		if (end - p < 2) {
+			throw Exception("YamlConfig: truncated serialized node");
+		}
+		if ((unsigned char)*p > Type::UNKNOWN) {
+			throw Exception("YamlConfig: invalid serialized node type %u", (unsigned char)*p);
+		}
+		auto n = std::make_shared<YamlConfigurationNode>();
+		n->type_       = (Type::value)*p++;
+		n->is_default_ = (*p++ != 0);
+		n->name_         = deserialize_string(p, end);
+		n->scalar_value_ = deserialize_string(p, end);
+		uint32_t num_list = deserialize_size(p, end);
+		if (num_list > (size_t)(end - p) / sizeof(uint32_t)) {
+			throw Exception("YamlConfig: truncated serialized node");
+		}
+		n->list_values_.resize(num_list);
+		for (uint32_t i = 0; i < num_list; ++i) {
+			n->list_values_[i] = deserialize_string(p, end);
+		}
+		uint32_t num_children = deserialize_size(p, end);
+		if (num_children > (size_t)(end - p) / (sizeof(uint32_t) + min_node_size)) {
+			throw Exception("YamlConfig: truncated serialized node");
+		}
+		for (uint32_t i = 0; i < num_children; ++i) {
+			std::string key = deserialize_string(p, end);
+			n->children_[key] = deserialize(p, end, depth + 1);
+		}
+		return n;
+	}
+
+	static void serialize_size(std::string &out, uint32_t size)
+	{
+		out.append((const char *)&size, sizeof(size));
+	}
+
+	static void serialize_string(std::string &out, const std::string &s)
+	{
+		serialize_size(out, s.length());
+		out.append(s);
+	}
+
+	static uint32_t deserialize_size(const char *&p, const char *end)
+	{
+		uint32_t size;
+		if (end - p < (ptrdiff_t)sizeof(size)) {
+			throw Exception("YamlConfig: truncated serialized node");
+		}
+		memcpy(&size, p, sizeof(size));
+		p += sizeof(size);
+		return size;
+	}
+
+	static std::string deserialize_string(const char *&p, const char *end)
+	{
+		uint32_t len = deserialize_size(p, end);
+		if ((uint32_t)(end - p) < len) {
+			throw Exception("YamlConfig: truncated serialized node");
+		}
+		std::string s(p, len);
+		p += len;
+		return s;
+	}
+
  private:
 	void set_name(const std::string &name)
 	{
@@ -22,7 +22,6 @@
  */
 
 #include <core/utils/refcount.h>
-#include <core/threading/mutex.h>
 #include <core/exceptions/software.h>
 
 #include <unistd.h>
@@ -39,6 +38,9 @@ namespace fawkes {
  * class. This is the recommended way. If you want to use reference counting with
  * a class that you cannot or do not want to modify you can use the RefCounter
  * template class to accomplish the desired task.
+ *
+ * The reference count is modified with atomic operations, no lock or any
+ * other memory is allocated per instance.
  * @see RefCounter
  *
  * @ingroup FCL
@@ -49,7 +51,6 @@ namespace fawkes {
 /** Constructor. */
 RefCount::RefCount()
 {
-  ref_mutex = new Mutex();
   refc = 1;
 }
 
@@ -57,7 +58,6 @@ RefCount::RefCount()
 /** Destructor. */
 RefCount::~RefCount()
 {
-  delete ref_mutex;
 }
 
 
@@ -69,12 +69,13 @@ RefCount::~RefCount()
 void
 RefCount::ref()
 {
-  ref_mutex->lock();
-  if ( refc == 0 ) {
-    throw DestructionInProgressException("Tried to reference that is currently being deleted");
-  }
-  ++refc;
-  ref_mutex->unlock();
+  unsigned int r = __atomic_load_n(&refc, __ATOMIC_RELAXED);
+  do {
+    if ( r == 0 ) {
+      throw DestructionInProgressException("Tried to reference that is currently being deleted");
+    }
+  } while (! __atomic_compare_exchange_n(&refc, &r, r + 1, /* weak */ true,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 }
 
 
@@ -98,18 +99,18 @@ RefCount::ref()
 void
 RefCount::unref()
 {
-  
-  ref_mutex->lock();
-  if ( refc == 0 ) {
-    throw DestructionInProgressException("Tried to reference that is currently being deleted");
-  }
-  if ( refc > 0 )  --refc;
-  if ( refc == 0 ) {
+  unsigned int r = __atomic_load_n(&refc, __ATOMIC_RELAXED);
+  do {
+    if ( r == 0 ) {
+      throw DestructionInProgressException("Tried to reference that is currently being deleted");
+    }
+  } while (! __atomic_compare_exchange_n(&refc, &r, r - 1, /* weak */ true,
+					 __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  if ( r == 1 ) {
     // commit suicide
     delete this;
-    return;
   }
-  ref_mutex->unlock();
 }
 
 
@@ -124,7 +125,7 @@ RefCount::unref()
 unsigned int
 RefCount::refcount()
 {
-  return refc;
+  return __atomic_load_n(&refc, __ATOMIC_RELAXED);
 }
 
 
@@ -42,7 +42,6 @@ class RefCount
  private:
 
   unsigned int  refc;
-  Mutex        *ref_mutex;
 };
 
 
@@ -50,6 +50,7 @@ InterfaceFieldIterator::InterfaceFieldIterator()
 {
   interface_ = NULL;
   infol_ = NULL;
+  data_ = NULL;
   value_string_ = NULL;
 }
 
@@ -58,12 +59,17 @@ InterfaceFieldIterator::InterfaceFieldIterator()
  * This creates an iterator pointing to the given entry of the info list.
  * @param interface interface this field iterator is assigned to
  * @param info_list pointer to info list entry to start from
+ * @param data if not NULL, the values in the info list are offsets relative
+ * to this data chunk instead of absolute pointers, this is used for the
+ * field info tables shared among all messages of a type
  */
 InterfaceFieldIterator::InterfaceFieldIterator(Interface *interface,
-						 const interface_fieldinfo_t *info_list)
+						 const interface_fieldinfo_t *info_list,
+						 void *data)
 {
   interface_ = interface;
   infol_ = info_list;
+  data_ = (char *)data;
   value_string_ = NULL;
 }
 
@@ -75,6 +81,7 @@ InterfaceFieldIterator::InterfaceFieldIterator(const InterfaceFieldIterator &fit
 {
   interface_ = fit.interface_;
   infol_ = fit.infol_;
+  data_ = fit.data_;
   if ( fit.value_string_ ) {
     value_string_ = strdup(fit.value_string_);
   } else {
@@ -178,7 +185,7 @@ InterfaceFieldIterator::operator*() const
   if ( infol_ == NULL ) {
     throw NullPointerException("Cannot get value of end element");
   } else {
-    return infol_->value;
+    return value_ptr();
   }
 }
 
@@ -192,6 +199,7 @@ InterfaceFieldIterator::operator=(const InterfaceFieldIterator & fi)
 {
   interface_ = fi.interface_;
   infol_     = fi.infol_;
+  data_      = fi.data_;
 
   return *this;
 }
@@ -291,7 +299,7 @@ InterfaceFieldIterator::get_value() const
   if ( infol_ == NULL ) {
     throw NullPointerException("Cannot get value of end element");
   } else {
-    return infol_->value;
+    return value_ptr();
   }
 }
 
@@ -333,54 +341,54 @@ InterfaceFieldIterator::get_value_string(const char *array_sep)
           int rv = 0;
 	  switch (infol_->type) {
 	  case IFT_BOOL:
-	    rv = asprintf(&tmp2, "%s%s", tmp1, (((bool *)infol_->value)[i]) ? "true" : "false");
+	    rv = asprintf(&tmp2, "%s%s", tmp1, (((bool *)value_ptr())[i]) ? "true" : "false");
 	    break;
 	  case IFT_INT8:
-	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int8_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int8_t *)value_ptr())[i]);
 	    break;
 	  case IFT_INT16:
-	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int16_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int16_t *)value_ptr())[i]);
 	    break;
 	  case IFT_INT32:
-	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int32_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%i", tmp1, ((int32_t *)value_ptr())[i]);
 	    break;
 	  case IFT_INT64:
 #if (defined(__WORDSIZE) && __WORDSIZE == 64) || (defined(LONG_BIT) && LONG_BIT == 64) || defined(__x86_64__)
-	    rv = asprintf(&tmp2, "%s%li", tmp1, ((int64_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%li", tmp1, ((int64_t *)value_ptr())[i]);
 #else
-	    rv = asprintf(&tmp2, "%s%lli", tmp1, ((int64_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%lli", tmp1, ((int64_t *)value_ptr())[i]);
 #endif
 	    break;
 	  case IFT_UINT8:
-	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint8_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint8_t *)value_ptr())[i]);
 	    break;
 	  case IFT_UINT16:
-	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint16_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint16_t *)value_ptr())[i]);
 	    break;
 	  case IFT_UINT32:
-	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint32_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint32_t *)value_ptr())[i]);
 	    break;
 	  case IFT_UINT64:
 #if (defined(__WORDSIZE) && __WORDSIZE == 64) || (defined(LONG_BIT) && LONG_BIT == 64) || defined(__x86_64__)
-	    rv = asprintf(&tmp2, "%s%lu", tmp1, ((uint64_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%lu", tmp1, ((uint64_t *)value_ptr())[i]);
 #else
-	    rv = asprintf(&tmp2, "%s%llu", tmp1, ((uint64_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%llu", tmp1, ((uint64_t *)value_ptr())[i]);
 #endif
 	    break;
 	  case IFT_FLOAT:
-	    rv = asprintf(&tmp2, "%s%f", tmp1, ((float *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%f", tmp1, ((float *)value_ptr())[i]);
 	    break;
 	  case IFT_DOUBLE:
-	    rv = asprintf(&tmp2, "%s%f", tmp1, ((double *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%f", tmp1, ((double *)value_ptr())[i]);
 	    break;
 	  case IFT_BYTE:
-	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint8_t *)infol_->value)[i]);
+	    rv = asprintf(&tmp2, "%s%u", tmp1, ((uint8_t *)value_ptr())[i]);
 	    break;
 	  case IFT_STRING:
 	    // cannot happen, caught with surrounding if statement
 
 	  case IFT_ENUM:
-	    rv = asprintf(&tmp2, "%s%s", tmp1, interface_->enum_tostring(infol_->enumtype, ((int *)infol_->value)[i]));
+	    rv = asprintf(&tmp2, "%s%s", tmp1, interface_->enum_tostring(infol_->enumtype, ((int *)value_ptr())[i]));
 	    break;
 	  }
 
@@ -403,11 +411,11 @@ InterfaceFieldIterator::get_value_string(const char *array_sep)
       } else {
 	// it's a string, or a small number
 	if ( infol_->length > 1 ) {
-	  if (asprintf(&value_string_, "%s", (const char *)infol_->value) == -1) {
+	  if (asprintf(&value_string_, "%s", (const char *)value_ptr()) == -1) {
 	    throw OutOfMemoryException("InterfaceFieldIterator::get_value_string(): asprintf() failed (3)");
 	  }
 	} else {
-	  if (asprintf(&value_string_, "%c", *((const char *)infol_->value)) == -1) {
+	  if (asprintf(&value_string_, "%c", *((const char *)value_ptr())) == -1) {
 	    throw OutOfMemoryException("InterfaceFieldIterator::get_value_string(): asprintf() failed (4)");
 	  }
 	}
@@ -435,7 +443,7 @@ InterfaceFieldIterator::get_bool(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((bool *)infol_->value)[index];
+    return ((bool *)value_ptr())[index];
   }
 }
 
@@ -457,7 +465,7 @@ InterfaceFieldIterator::get_int8(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((int8_t *)infol_->value)[index];
+    return ((int8_t *)value_ptr())[index];
   }
 }
 
@@ -479,7 +487,7 @@ InterfaceFieldIterator::get_uint8(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((uint8_t *)infol_->value)[index];
+    return ((uint8_t *)value_ptr())[index];
   }
 }
 
@@ -500,7 +508,7 @@ InterfaceFieldIterator::get_int16(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((int16_t *)infol_->value)[index];
+    return ((int16_t *)value_ptr())[index];
   }
 }
 
@@ -522,7 +530,7 @@ InterfaceFieldIterator::get_uint16(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((uint16_t *)infol_->value)[index];
+    return ((uint16_t *)value_ptr())[index];
   }
 }
 
@@ -543,7 +551,7 @@ InterfaceFieldIterator::get_int32(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((int32_t *)infol_->value)[index];
+    return ((int32_t *)value_ptr())[index];
   }
 }
 
@@ -565,7 +573,7 @@ InterfaceFieldIterator::get_uint32(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((uint32_t *)infol_->value)[index];
+    return ((uint32_t *)value_ptr())[index];
   }
 }
 
@@ -586,7 +594,7 @@ InterfaceFieldIterator::get_int64(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((int64_t *)infol_->value)[index];
+    return ((int64_t *)value_ptr())[index];
   }
 }
 
@@ -608,7 +616,7 @@ InterfaceFieldIterator::get_uint64(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((uint64_t *)infol_->value)[index];
+    return ((uint64_t *)value_ptr())[index];
   }
 }
 
@@ -630,7 +638,7 @@ InterfaceFieldIterator::get_float(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((float *)infol_->value)[index];
+    return ((float *)value_ptr())[index];
   }
 }
 
@@ -652,7 +660,7 @@ InterfaceFieldIterator::get_double(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((double *)infol_->value)[index];
+    return ((double *)value_ptr())[index];
   }
 }
 
@@ -674,7 +682,7 @@ InterfaceFieldIterator::get_byte(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((uint8_t *)infol_->value)[index];
+    return ((uint8_t *)value_ptr())[index];
   }
 }
 
@@ -696,7 +704,7 @@ InterfaceFieldIterator::get_enum(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    return ((int32_t *)infol_->value)[index];
+    return ((int32_t *)value_ptr())[index];
   }
 }
 
@@ -720,7 +728,7 @@ InterfaceFieldIterator::get_enum_string(unsigned int index) const
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    int32_t int_val = ((int32_t *)infol_->value)[index];
+    int32_t int_val = ((int32_t *)value_ptr())[index];
     interface_enum_map_t::const_iterator ev = infol_->enum_map->find(int_val);
     if (ev == infol_->enum_map->end()) {
       throw IllegalArgumentException("Integer value is not a canonical enum value");
@@ -745,7 +753,7 @@ InterfaceFieldIterator::get_bools() const
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    return (bool *)infol_->value;
+    return (bool *)value_ptr();
   }
 }
 
@@ -764,7 +772,7 @@ InterfaceFieldIterator::get_int8s() const
   } else if ( infol_->type != IFT_INT8 ) {
     throw TypeMismatchException("Requested value is not of type int");
   } else {
-    return (int8_t *)infol_->value;
+    return (int8_t *)value_ptr();
   }
 }
 
@@ -783,7 +791,7 @@ InterfaceFieldIterator::get_uint8s() const
   } else if ( infol_->type != IFT_UINT8 ) {
     throw TypeMismatchException("Requested value is not of type unsigned int");
   } else {
-    return (uint8_t *)infol_->value;
+    return (uint8_t *)value_ptr();
   }
 }
 
@@ -802,7 +810,7 @@ InterfaceFieldIterator::get_int16s() const
   } else if ( infol_->type != IFT_INT16 ) {
     throw TypeMismatchException("Requested value is not of type int");
   } else {
-    return (int16_t *)infol_->value;
+    return (int16_t *)value_ptr();
   }
 }
 
@@ -821,7 +829,7 @@ InterfaceFieldIterator::get_uint16s() const
   } else if ( infol_->type != IFT_UINT16 ) {
     throw TypeMismatchException("Requested value is not of type unsigned int");
   } else {
-    return (uint16_t *)infol_->value;
+    return (uint16_t *)value_ptr();
   }
 }
 
@@ -840,7 +848,7 @@ InterfaceFieldIterator::get_int32s() const
   } else if ( infol_->type != IFT_INT32 ) {
     throw TypeMismatchException("Requested value is not of type int");
   } else {
-    return (int32_t *)infol_->value;
+    return (int32_t *)value_ptr();
   }
 }
 
@@ -859,7 +867,7 @@ InterfaceFieldIterator::get_uint32s() const
   } else if ( infol_->type != IFT_UINT32 ) {
     throw TypeMismatchException("Requested value is not of type unsigned int");
   } else {
-    return (uint32_t *)infol_->value;
+    return (uint32_t *)value_ptr();
   }
 }
 
@@ -878,7 +886,7 @@ InterfaceFieldIterator::get_int64s() const
   } else if ( infol_->type != IFT_INT64 ) {
     throw TypeMismatchException("Requested value is not of type int");
   } else {
-    return (int64_t *)infol_->value;
+    return (int64_t *)value_ptr();
   }
 }
 
@@ -897,7 +905,7 @@ InterfaceFieldIterator::get_uint64s() const
   } else if ( infol_->type != IFT_UINT64 ) {
     throw TypeMismatchException("Requested value is not of type unsigned int");
   } else {
-    return (uint64_t *)infol_->value;
+    return (uint64_t *)value_ptr();
   }
 }
 
@@ -916,7 +924,7 @@ InterfaceFieldIterator::get_floats() const
   } else if ( infol_->type != IFT_FLOAT ) {
     throw TypeMismatchException("Requested value is not of type float");
   } else {
-    return (float *)infol_->value;
+    return (float *)value_ptr();
   }
 }
 
@@ -935,7 +943,7 @@ InterfaceFieldIterator::get_doubles() const
   } else if ( infol_->type != IFT_DOUBLE ) {
     throw TypeMismatchException("Requested value is not of type double");
   } else {
-    return (double *)infol_->value;
+    return (double *)value_ptr();
   }
 }
 
@@ -954,7 +962,7 @@ InterfaceFieldIterator::get_bytes() const
   } else if ( infol_->type != IFT_BYTE ) {
     throw TypeMismatchException("Requested value is not of type byte");
   } else {
-    return (uint8_t *)infol_->value;
+    return (uint8_t *)value_ptr();
   }
 }
 
@@ -973,7 +981,7 @@ InterfaceFieldIterator::get_enums() const
   } else if ( infol_->type != IFT_ENUM ) {
     throw TypeMismatchException("Requested value is not of type enum");
   } else {
-    return (int32_t *)infol_->value;
+    return (int32_t *)value_ptr();
   }
 }
 
@@ -991,7 +999,7 @@ InterfaceFieldIterator::get_string() const
   } else if ( infol_->type != IFT_STRING ) {
     throw TypeMismatchException("Requested value is not of type string");
   } else {
-    return (const char *)infol_->value;
+    return (const char *)value_ptr();
   }
 }
 
@@ -1013,7 +1021,7 @@ InterfaceFieldIterator::set_bool(bool v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(bool);
+    char* dst = (char *) value_ptr() + index * sizeof(bool);
     memcpy((void *) dst, &v, sizeof(bool));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1037,7 +1045,7 @@ InterfaceFieldIterator::set_int8(int8_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(int8_t);
+    char* dst = (char *) value_ptr() + index * sizeof(int8_t);
     memcpy((void *) dst, &v, sizeof(int8_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1061,7 +1069,7 @@ InterfaceFieldIterator::set_uint8(uint8_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(uint8_t);
+    char* dst = (char *) value_ptr() + index * sizeof(uint8_t);
     memcpy((void *) dst, &v, sizeof(uint8_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1085,7 +1093,7 @@ InterfaceFieldIterator::set_int16(int16_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(int16_t);
+    char* dst = (char *) value_ptr() + index * sizeof(int16_t);
     memcpy((void *) dst, &v, sizeof(int16_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1109,7 +1117,7 @@ InterfaceFieldIterator::set_uint16(uint16_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(uint16_t);
+    char* dst = (char *) value_ptr() + index * sizeof(uint16_t);
     memcpy((void *) dst, &v, sizeof(uint16_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1133,7 +1141,7 @@ InterfaceFieldIterator::set_int32(int32_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(int32_t);
+    char* dst = (char *) value_ptr() + index * sizeof(int32_t);
     memcpy((void *) dst, &v, sizeof(int32_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1157,7 +1165,7 @@ InterfaceFieldIterator::set_uint32(uint32_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(uint32_t);
+    char* dst = (char *) value_ptr() + index * sizeof(uint32_t);
     memcpy((void *) dst, &v, sizeof(uint32_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1181,7 +1189,7 @@ InterfaceFieldIterator::set_int64(int64_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(int64_t);
+    char* dst = (char *) value_ptr() + index * sizeof(int64_t);
     memcpy((void *) dst, &v, sizeof(int64_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1205,7 +1213,7 @@ InterfaceFieldIterator::set_uint64(uint64_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(uint64_t);
+    char* dst = (char *) value_ptr() + index * sizeof(uint64_t);
     memcpy((void *) dst, &v, sizeof(uint64_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1229,7 +1237,7 @@ InterfaceFieldIterator::set_float(float v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(float);
+    char* dst = (char *) value_ptr() + index * sizeof(float);
     memcpy((void *) dst, &v, sizeof(float));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1253,7 +1261,7 @@ InterfaceFieldIterator::set_double(double v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(double);
+    char* dst = (char *) value_ptr() + index * sizeof(double);
     memcpy((void *) dst, &v, sizeof(double));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1277,7 +1285,7 @@ InterfaceFieldIterator::set_byte(uint8_t v, unsigned int index)
   } else if (index >= infol_->length) {
     throw OutOfBoundsException("Field index out of bounds", index, 0, infol_->length);
   } else {
-    char* dst = (char *) infol_->value + index * sizeof(uint8_t);
+    char* dst = (char *) value_ptr() + index * sizeof(uint8_t);
     memcpy((void *) dst, &v, sizeof(uint8_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1304,7 +1312,7 @@ InterfaceFieldIterator::set_enum(int32_t e, unsigned int index)
     if (ev == infol_->enum_map->end()) {
       throw IllegalArgumentException("Integer value is not a canonical enum value");
     }
-    char* dst = (char *) infol_->value + index * sizeof(int32_t);
+    char* dst = (char *) value_ptr() + index * sizeof(int32_t);
     memcpy((void *) dst, &e, sizeof(int32_t));
     if (interface_)  interface_->mark_data_changed();
   }
@@ -1331,7 +1339,7 @@ InterfaceFieldIterator::set_enum_string(const char *e, unsigned int index)
     interface_enum_map_t::const_iterator ev;
     for (ev = infol_->enum_map->begin(); ev != infol_->enum_map->end(); ++ev) {
       if (ev->second == e) {
-	char* dst = (char *) infol_->value + index * sizeof(int32_t);
+	char* dst = (char *) value_ptr() + index * sizeof(int32_t);
 	memcpy((void *) dst, &ev->first, sizeof(int32_t));
 	if (interface_)  interface_->mark_data_changed();
 	return;
@@ -1359,7 +1367,7 @@ InterfaceFieldIterator::set_bools(bool *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(bool));
+    memcpy(value_ptr(), v, infol_->length * sizeof(bool));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1381,7 +1389,7 @@ InterfaceFieldIterator::set_int8s(int8_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(int8_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(int8_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1403,7 +1411,7 @@ InterfaceFieldIterator::set_uint8s(uint8_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(uint8_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(uint8_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1425,7 +1433,7 @@ InterfaceFieldIterator::set_int16s(int16_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(int16_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(int16_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1447,7 +1455,7 @@ InterfaceFieldIterator::set_uint16s(uint16_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(uint16_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(uint16_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1469,7 +1477,7 @@ InterfaceFieldIterator::set_int32s(int32_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(int32_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(int32_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1491,7 +1499,7 @@ InterfaceFieldIterator::set_uint32s(uint32_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(uint32_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(uint32_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1513,7 +1521,7 @@ InterfaceFieldIterator::set_int64s(int64_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(int64_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(int64_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1535,7 +1543,7 @@ InterfaceFieldIterator::set_uint64s(uint64_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(uint64_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(uint64_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1557,7 +1565,7 @@ InterfaceFieldIterator::set_floats(float *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(float));
+    memcpy(value_ptr(), v, infol_->length * sizeof(float));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1578,7 +1586,7 @@ InterfaceFieldIterator::set_doubles(double *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(double));
+    memcpy(value_ptr(), v, infol_->length * sizeof(double));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1600,7 +1608,7 @@ InterfaceFieldIterator::set_bytes(uint8_t *v)
   } else if (infol_->length == 1) {
     throw TypeMismatchException("Field %s is not an array", infol_->name);
   } else {
-    memcpy(infol_->value, v, infol_->length * sizeof(uint8_t));
+    memcpy(value_ptr(), v, infol_->length * sizeof(uint8_t));
     if (interface_)  interface_->mark_data_changed();
   }
 }
@@ -1619,9 +1627,20 @@ InterfaceFieldIterator::set_string(const char *v)
   } else if ( infol_->type != IFT_STRING ) {
     throw TypeMismatchException("Field to be written is not of type string");
   } else {
-    strncpy((char *) infol_->value, v, infol_->length);
+    strncpy((char *) value_ptr(), v, infol_->length);
     if (interface_)  interface_->mark_data_changed();
   }
 }
 
+
+/** Get pointer to value of current field.
+ * @return pointer to the value, resolved against the data chunk if the
+ * info list stores offsets
+ */
+void *
+InterfaceFieldIterator::value_ptr() const
+{
+  return (void *)((uintptr_t)data_ + (uintptr_t)infol_->value);
+}
+
 } // end namespace fawkes
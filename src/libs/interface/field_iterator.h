@@ -120,10 +120,15 @@ class InterfaceFieldIterator
   
  protected:
   InterfaceFieldIterator(Interface *interface,
-			 const interface_fieldinfo_t *info_list);
+			 const interface_fieldinfo_t *info_list,
+			 void *data = 0);
   
+ private:
+  void *                 value_ptr() const;
+
  private:
   const interface_fieldinfo_t   *infol_;
+  char                          *data_;
   char                          *value_string_;
   Interface                     *interface_;
 };
@@ -38,6 +38,7 @@
 #include <cerrno>
 #include <typeinfo>
 #include <regex.h>
+#include <sched.h>
 
 namespace fawkes {
 
@@ -140,6 +141,24 @@ InterfaceInvalidException::InterfaceInvalidException(const Interface *interface,
  * section. Upon opening the interface, the private section is copied
  * once from the shared section, even when opening a writer.
  *
+ * Interfaces opened on a LocalBlackBoard additionally use a version
+ * counter stored in the shared memory chunk header (seqlock). The
+ * writer increments the counter before and after copying the data to
+ * the shared section, so that it is odd while a write is in
+ * progress. Readers then copy the data without acquiring the
+ * ReadWriteLock and simply retry if the counter changed during the
+ * copy. Interfaces without a version counter, for example proxied
+ * interfaces of a RemoteBlackBoard, use the lock for reading.
+ *
+ * Each write to a local interface is assigned a sequence number, see
+ * sequence(). If the blackboard has been configured to keep a history
+ * for an interface, the shared chunk additionally contains a ring of
+ * the most recent states. Readers can then fetch the latest state
+ * written at or before a given time with read_history() or copy all
+ * states written after a known sequence number into the buffers with
+ * read_history_since(). This allows for processing every update even
+ * if a reader missed some of the writer's cycles.
+ *
  * An interface has an internal timestamp. This timestamp indicates
  * when the data in the interface has been modified last. The
  * timestamp is usually automatically updated. But it some occasions
@@ -232,6 +251,12 @@ Interface::Interface()
 {
   write_access_ = false;
   rwlock_ = NULL;
+  mem_version_ = NULL;
+  mem_sequence_ = NULL;
+  mem_history_ = NULL;
+  mem_history_slots_ = 0;
+  history_scratch_ = NULL;
+  data_sequence_ = 0;
   valid_ = true;
   next_message_id_ = 0;
   num_fields_ = 0;
@@ -264,6 +289,7 @@ Interface::~Interface()
   delete data_mutex_;
   delete message_queue_;
   if (buffers_)  free(buffers_);
+  if (history_scratch_)  free(history_scratch_);
   // free fieldinfo list
   interface_fieldinfo_t *finfol = fieldinfo_list_;
   while ( finfol ) {
@@ -470,12 +496,29 @@ Interface::is_valid() const
 
 
 /** Read from BlackBoard into local copy.
+ * If the interface memory provides a version counter the data is
+ * copied without locking the shared section, otherwise the
+ * ReadWriteLock is acquired for reading.
  * @exception InterfaceInvalidException thrown if the interface has
  * been marked invalid
  */
 void
 Interface::read()
 {
+  if (mem_version_) {
+    data_mutex_->lock();
+    if ( valid_ ) {
+      data_sequence_ = copy_shared_versioned(data_ptr);
+      *local_read_timestamp_ = *timestamp_;
+      timestamp_->set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
+    } else {
+      data_mutex_->unlock();
+      throw InterfaceInvalidException(this, "read()");
+    }
+    data_mutex_->unlock();
+    return;
+  }
+
   rwlock_->lock_for_read();
   data_mutex_->lock();
   if ( valid_ ) {
@@ -492,6 +535,244 @@ Interface::read()
 }
 
 
+/** Copy shared memory section guarded by the version counter.
+ * Optimistically copies the shared data section and retries if a
+ * write was in progress or happened during the copy. Must only be
+ * called if the memory has a version counter.
+ * @param dest destination to copy data_size bytes to
+ * @return write sequence number of the copied data
+ */
+uint64_t
+Interface::copy_shared_versioned(void *dest)
+{
+  uint32_t v_begin, v_end;
+  uint64_t sequence = 0;
+  unsigned int spins = 0;
+  do {
+    while ((v_begin = __atomic_load_n(mem_version_, __ATOMIC_ACQUIRE)) & 1) {
+      // writer is currently copying, give it a chance to finish
+      if (++spins > 100) {
+	sched_yield();
+	spins = 0;
+      }
+    }
+    memcpy(dest, mem_data_ptr_, data_size);
+    if (mem_sequence_)  sequence = __atomic_load_n(mem_sequence_, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    v_end = __atomic_load_n(mem_version_, __ATOMIC_RELAXED);
+  } while (v_begin != v_end);
+
+  return sequence;
+}
+
+
+/** Get offset of the history from the start of the data in shared memory.
+ * The history follows the data, padded such that the 64 bit sequence
+ * numbers of the slots are naturally aligned.
+ * @return offset in bytes from the data to the first history slot
+ */
+size_t
+Interface::history_offset() const
+{
+  const size_t a = alignof(uint64_t);
+  return (data_size + a - 1) & ~(a - 1);
+}
+
+
+/** Get size of a history slot.
+ * @return size in bytes of a history slot including its header, padded
+ * to keep the 64 bit sequence numbers of all slots naturally aligned
+ */
+size_t
+Interface::history_slot_size() const
+{
+  const size_t a = alignof(uint64_t);
+  return (sizeof(interface_history_slot_t) + data_size + a - 1) & ~(a - 1);
+}
+
+
+/** Get history slot for sequence number.
+ * @param sequence write sequence number
+ * @return pointer to the slot in shared memory the given sequence
+ * number is stored in
+ */
+Interface::interface_history_slot_t *
+Interface::history_slot(uint64_t sequence) const
+{
+  return (interface_history_slot_t *)
+    ((char *)mem_history_ + (sequence % mem_history_slots_) * history_slot_size());
+}
+
+
+/** Write private data to a history slot.
+ * Called by the writer during write(). The slot is determined by the
+ * sequence number and guarded by its own version counter.
+ * @param sequence write sequence number of the data
+ */
+void
+Interface::write_history_slot(uint64_t sequence)
+{
+  interface_history_slot_t *slot = history_slot(sequence);
+
+  uint32_t v = __atomic_load_n(&slot->version, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->version, v + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELAXED);
+  memcpy((char *)slot + sizeof(interface_history_slot_t), data_ptr, data_size);
+  __atomic_store_n(&slot->version, v + 2, __ATOMIC_RELEASE);
+}
+
+
+/** Copy data from a history slot.
+ * @param sequence write sequence number of the desired data
+ * @param dest destination to copy data to
+ * @param size number of bytes to copy, at most data_size
+ * @return true if the data was copied, false if the slot does not (or
+ * no longer) contain the data for the given sequence number. In the
+ * latter case dest may have been modified.
+ */
+bool
+Interface::copy_history_slot(uint64_t sequence, void *dest, size_t size)
+{
+  interface_history_slot_t *slot = history_slot(sequence);
+
+  uint32_t v_begin, v_end;
+  uint64_t slot_sequence;
+  do {
+    while ((v_begin = __atomic_load_n(&slot->version, __ATOMIC_ACQUIRE)) & 1) {
+      sched_yield();
+    }
+    slot_sequence = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+    if (slot_sequence == sequence) {
+      memcpy(dest, (char *)slot + sizeof(interface_history_slot_t), size);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    v_end = __atomic_load_n(&slot->version, __ATOMIC_RELAXED);
+  } while (v_begin != v_end);
+
+  return (slot_sequence == sequence);
+}
+
+
+/** Get number of history slots.
+ * @return number of states kept in the interface history, 0 if the
+ * interface has no history (for example because it is a proxied
+ * interface of a RemoteBlackBoard or no history has been configured).
+ */
+unsigned int
+Interface::history_size() const
+{
+  return mem_history_slots_;
+}
+
+
+/** Get sequence number of private data.
+ * Each write() to a local interface increments a sequence number
+ * which is kept alongside the data in shared memory. This returns the
+ * sequence number of the data currently in the private memory, as
+ * last set by read(), read_history() or write().
+ * @return write sequence number of private data, 0 if unknown
+ */
+uint64_t
+Interface::sequence() const
+{
+  return data_sequence_;
+}
+
+
+/** Read latest history state written at or before the given time.
+ * The data timestamp of the states in the history is compared to the
+ * given time. The newest state which is not newer than the given time
+ * is copied into the private memory.
+ * @param time time to read the state for
+ * @return true if a matching state was found and has been read,
+ * false if the history contains no such state or if the interface has
+ * no history. In the latter case the private memory is not modified.
+ * @exception InterfaceInvalidException thrown if the interface has
+ * been marked invalid
+ */
+bool
+Interface::read_history(const Time *time)
+{
+  if (mem_history_slots_ == 0)  return false;
+
+  MutexLocker lock(data_mutex_);
+  if ( ! valid_ ) {
+    throw InterfaceInvalidException(this, "read_history()");
+  }
+
+  const long sec = time->get_sec(), usec = time->get_usec();
+  uint64_t latest = __atomic_load_n(mem_sequence_, __ATOMIC_ACQUIRE);
+  uint64_t oldest = (latest > mem_history_slots_) ? latest - mem_history_slots_ + 1 : 1;
+
+  for (uint64_t s = latest; s >= oldest && s > 0; --s) {
+    interface_data_ts_t ts;
+    if (! copy_history_slot(s, &ts, sizeof(interface_data_ts_t))) {
+      // overwritten by the writer meanwhile, all older states are gone as well
+      return false;
+    }
+    if ( (ts.timestamp_sec < sec) ||
+	 ((ts.timestamp_sec == sec) && (ts.timestamp_usec <= usec)) )
+    {
+      if (! copy_history_slot(s, history_scratch_, data_size))  return false;
+      memcpy(data_ptr, history_scratch_, data_size);
+      data_sequence_ = s;
+      *local_read_timestamp_ = *timestamp_;
+      timestamp_->set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+/** Copy all history states written after a given sequence number to buffers.
+ * The states are copied to the interface buffers in the order they
+ * have been written, i.e. the oldest state is copied to buffer 0. The
+ * buffers are enlarged if necessary, use read_from_buffer() to
+ * process the individual states. States which have already been
+ * overwritten in the history are skipped.
+ * @param sequence sequence number of the last state that has already
+ * been processed, 0 to copy all states in the history. Upon return
+ * contains the sequence number of the last state that has been copied.
+ * @return number of states copied to buffers, 0 if there was no newer
+ * state or if the interface has no history.
+ * @exception InterfaceInvalidException thrown if the interface has
+ * been marked invalid
+ */
+unsigned int
+Interface::read_history_since(uint64_t &sequence)
+{
+  if (mem_history_slots_ == 0)  return 0;
+
+  uint64_t latest = __atomic_load_n(mem_sequence_, __ATOMIC_ACQUIRE);
+  if (latest <= sequence)  return 0;
+
+  uint64_t first = sequence + 1;
+  if (latest - first >= mem_history_slots_)  first = latest - mem_history_slots_ + 1;
+  unsigned int num_states = latest - first + 1;
+
+  if (num_buffers_ < num_states)  resize_buffers(num_states);
+
+  MutexLocker lock(data_mutex_);
+  if ( ! valid_ ) {
+    throw InterfaceInvalidException(this, "read_history_since()");
+  }
+
+  unsigned int b = 0;
+  for (uint64_t s = first; s <= latest; ++s) {
+    void *buf = (char *)buffers_ + b * data_size;
+    if (copy_history_slot(s, buf, data_size)) {
+      sequence = s;
+      ++b;
+    }
+  }
+
+  return b;
+}
+
+
 /** Write from local copy into BlackBoard memory.
  * @exception InterfaceInvalidException thrown if the interface has
  * been marked invalid
@@ -514,7 +795,21 @@ Interface::write()
       data_ts->timestamp_usec = usec;
       data_changed = false;
     }
-    memcpy(mem_data_ptr_, data_ptr, data_size);
+    if (mem_version_) {
+      // odd version marks the write in progress for lock-free readers
+      uint32_t v = __atomic_load_n(mem_version_, __ATOMIC_RELAXED);
+      __atomic_store_n(mem_version_, v + 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      memcpy(mem_data_ptr_, data_ptr, data_size);
+      if (mem_sequence_) {
+	data_sequence_ = __atomic_load_n(mem_sequence_, __ATOMIC_RELAXED) + 1;
+	if (mem_history_slots_ > 0)  write_history_slot(data_sequence_);
+	__atomic_store_n(mem_sequence_, data_sequence_, __ATOMIC_RELEASE);
+      }
+      __atomic_store_n(mem_version_, v + 2, __ATOMIC_RELEASE);
+    } else {
+      memcpy(mem_data_ptr_, data_ptr, data_size);
+    }
   } else {
     data_mutex_->unlock();
     rwlock_->unlock();
@@ -583,13 +878,35 @@ Interface::set_mediators(InterfaceMediator *iface_mediator,
  * @param serial mem serial
  * @param real_ptr pointer to whole chunk
  * @param data_ptr pointer to data chunk
+ * @param data_version pointer to version counter of the data chunk, if
+ * NULL the shared section is only accessed with the ReadWriteLock held
  */
 void
-Interface::set_memory(unsigned int serial, void *real_ptr, void *data_ptr)
+Interface::set_memory(unsigned int serial, void *real_ptr, void *data_ptr,
+		      uint32_t *data_version)
 {
   mem_serial_   = serial;
   mem_real_ptr_ = real_ptr;
   mem_data_ptr_ = data_ptr;
+  mem_version_  = data_version;
+}
+
+
+/** Set history information.
+ * @param sequence pointer to the write sequence counter in shared memory
+ * @param history pointer to the first history slot in shared memory, may
+ * be NULL if num_slots is zero
+ * @param num_slots number of history slots
+ */
+void
+Interface::set_history(uint64_t *sequence, void *history, unsigned int num_slots)
+{
+  mem_sequence_      = sequence;
+  mem_history_       = history;
+  mem_history_slots_ = num_slots;
+  if (num_slots > 0 && history_scratch_ == NULL) {
+    history_scratch_ = malloc(data_size);
+  }
 }
 
 
@@ -1285,6 +1602,19 @@ Interface::copy_shared_to_buffer(unsigned int buffer)
   }
 
 
+  if (mem_version_) {
+    data_mutex_->lock();
+    void *buf = (char *)buffers_ + buffer * data_size;
+    if ( valid_ ) {
+      copy_shared_versioned(buf);
+    } else {
+      data_mutex_->unlock();
+      throw InterfaceInvalidException(this, "copy_shared_to_buffer()");
+    }
+    data_mutex_->unlock();
+    return;
+  }
+
   rwlock_->lock_for_read();
   data_mutex_->lock();
 
@@ -121,6 +121,11 @@ class Interface
   void          read();
   void          write();
 
+  unsigned int  history_size() const;
+  uint64_t      sequence() const;
+  bool          read_history(const Time *time);
+  unsigned int  read_history_since(uint64_t &sequence);
+
   bool          has_writer() const;
   unsigned int  num_readers() const;
   std::string   writer() const;
@@ -228,9 +233,25 @@ class Interface
   void set_instance_serial(unsigned short instance_serial);
   void set_mediators(InterfaceMediator *iface_mediator,
 				   MessageMediator *msg_mediator);
-  void set_memory(unsigned int serial, void *real_ptr, void *data_ptr);
+  void set_memory(unsigned int serial, void *real_ptr, void *data_ptr,
+                  uint32_t *data_version = NULL);
+  void set_history(uint64_t *sequence, void *history, unsigned int num_slots);
   void set_readwrite(bool write_access, RefCountRWLock *rwlock);
   void set_owner(const char *owner);
+  uint64_t copy_shared_versioned(void *dest);
+
+  /** Header of a history slot in shared memory, the data follows it. */
+  typedef struct {
+    uint32_t version;	/**< slot version counter, odd while being written */
+    uint32_t reserved;	/**< reserved for future use, aligns sequence */
+    uint64_t sequence;	/**< write sequence number of the slot data */
+  } interface_history_slot_t;
+
+  size_t                     history_offset() const;
+  size_t                     history_slot_size() const;
+  interface_history_slot_t * history_slot(uint64_t sequence) const;
+  void                       write_history_slot(uint64_t sequence);
+  bool                       copy_history_slot(uint64_t sequence, void *dest, size_t size);
 
   inline unsigned int next_msg_id()
   {
@@ -249,6 +270,12 @@ class Interface
 
   void *             mem_data_ptr_;
   void *             mem_real_ptr_;
+  uint32_t *         mem_version_;
+  uint64_t *         mem_sequence_;
+  void *             mem_history_;
+  unsigned int       mem_history_slots_;
+  void *             history_scratch_;
+  uint64_t           data_sequence_;
   unsigned int       mem_serial_;
   bool               write_access_;
 
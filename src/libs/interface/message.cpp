@@ -31,15 +31,191 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <new>
+#include <sched.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <typeinfo>
 
 namespace fawkes {
 
+/// @cond INTERNALS
+#define MESSAGE_POOL_GRANULARITY  16
+#define MESSAGE_POOL_MAX_SIZE     4096
+#define MESSAGE_POOL_MAX_CACHED   1024
+#define MESSAGE_REGISTRY_BUCKETS  256
+
+// Keyed by the C++ class, messages of different interfaces commonly
+// share the same name (e.g. SetMaxVelocityMessage).
+struct Message::TypeInfo {
+  const std::type_info   *cxxtype;
+  interface_fieldinfo_t  *fieldinfo_list;
+  interface_fieldinfo_t  *fieldinfo_last;
+  unsigned int            num_fields;
+  TypeInfo               *next;
+
+  static TypeInfo * get(const std::type_info &cxxtype);
+  static TypeInfo * buckets[MESSAGE_REGISTRY_BUCKETS];
+};
+
+struct InternedName {
+  const char    *name;
+  InternedName  *next;
+};
+
+struct PoolBlock {
+  PoolBlock     *next;
+};
+
+struct PoolList {
+  bool           lock;
+  PoolBlock     *head;
+  unsigned int   num_cached;
+};
+
+// All of the following is POD and zero-initialized before any constructor
+// runs, messages can safely be created during static initialization.
+Message::TypeInfo * Message::TypeInfo::buckets[MESSAGE_REGISTRY_BUCKETS];
+static InternedName * name_buckets_[MESSAGE_REGISTRY_BUCKETS];
+static bool           registry_lock_;
+static PoolList       pool_lists_[MESSAGE_POOL_MAX_SIZE / MESSAGE_POOL_GRANULARITY + 1];
+
+static inline void
+spin_lock(bool *lock)
+{
+  while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED))  sched_yield();
+  }
+}
+
+static inline void
+spin_unlock(bool *lock)
+{
+  __atomic_clear(lock, __ATOMIC_RELEASE);
+}
+
+static inline void
+type_registry_lock()
+{
+  spin_lock(&registry_lock_);
+}
+
+static inline void
+type_registry_unlock()
+{
+  spin_unlock(&registry_lock_);
+}
+
+static inline unsigned int
+registry_hash(const char *s)
+{
+  unsigned int h = 2166136261u;
+  while (*s)  h = (h ^ (unsigned char)*s++) * 16777619u;
+  return h % MESSAGE_REGISTRY_BUCKETS;
+}
+
+Message::TypeInfo *
+Message::TypeInfo::get(const std::type_info &cxxtype)
+{
+  TypeInfo **bucket = &buckets[cxxtype.hash_code() % MESSAGE_REGISTRY_BUCKETS];
+  for (TypeInfo *ti = __atomic_load_n(bucket, __ATOMIC_ACQUIRE); ti; ti = ti->next) {
+    if (*ti->cxxtype == cxxtype)  return ti;
+  }
+
+  type_registry_lock();
+  TypeInfo *ti;
+  for (ti = *bucket; ti; ti = ti->next) {
+    if (*ti->cxxtype == cxxtype)  break;
+  }
+  if (! ti) {
+    ti = (TypeInfo *)calloc(1, sizeof(TypeInfo));
+    ti->cxxtype = &cxxtype;
+    ti->next = *bucket;
+    __atomic_store_n(bucket, ti, __ATOMIC_RELEASE);
+  }
+  type_registry_unlock();
+  return ti;
+}
+
+static const char *
+intern_name(const char *name)
+{
+  InternedName **bucket = &name_buckets_[registry_hash(name)];
+  for (InternedName *n = __atomic_load_n(bucket, __ATOMIC_ACQUIRE); n; n = n->next) {
+    if (strcmp(n->name, name) == 0)  return n->name;
+  }
+
+  type_registry_lock();
+  InternedName *n;
+  for (n = *bucket; n; n = n->next) {
+    if (strcmp(n->name, name) == 0)  break;
+  }
+  if (! n) {
+    n = (InternedName *)malloc(sizeof(InternedName));
+    n->name = strdup(name);
+    n->next = *bucket;
+    __atomic_store_n(bucket, n, __ATOMIC_RELEASE);
+  }
+  type_registry_unlock();
+  return n->name;
+}
+
+static void *
+pool_alloc(size_t size)
+{
+  size_t idx = (size + MESSAGE_POOL_GRANULARITY - 1) / MESSAGE_POOL_GRANULARITY;
+  if (idx == 0)  idx = 1;
+  if (idx < sizeof(pool_lists_) / sizeof(PoolList)) {
+    PoolList &l = pool_lists_[idx];
+    spin_lock(&l.lock);
+    PoolBlock *b = l.head;
+    if (b) {
+      l.head = b->next;
+      l.num_cached -= 1;
+    }
+    spin_unlock(&l.lock);
+    if (b)  return b;
+  }
+
+  void *rv = malloc(idx * MESSAGE_POOL_GRANULARITY);
+  if (! rv)  throw std::bad_alloc();
+  return rv;
+}
+
+static void
+pool_free(void *ptr, size_t size)
+{
+  if (! ptr)  return;
+
+  size_t idx = (size + MESSAGE_POOL_GRANULARITY - 1) / MESSAGE_POOL_GRANULARITY;
+  if (idx == 0)  idx = 1;
+  if (idx < sizeof(pool_lists_) / sizeof(PoolList)) {
+    PoolList &l = pool_lists_[idx];
+    spin_lock(&l.lock);
+    if (l.num_cached < MESSAGE_POOL_MAX_CACHED) {
+      PoolBlock *b = (PoolBlock *)ptr;
+      b->next = l.head;
+      l.head  = b;
+      l.num_cached += 1;
+      ptr = NULL;
+    }
+    spin_unlock(&l.lock);
+  }
+  free(ptr);
+}
+/// @endcond
+
 /** @class Message <interface/message.h>
  * Base class for all messages passed through interfaces in Fawkes BlackBoard.
  * Do not use directly, but instead use the interface generator to generate
  * an interface with accompanying messages.
  *
+ * Messages are built to be sent at high rates without heap allocations.
+ * Message objects and their data chunks are taken from pools per size,
+ * i.e. effectively per message type, and returned to the pool when the
+ * message is deleted. The type name, the name of the sending thread and
+ * the field info list are shared among all messages of the same type.
+ *
  * The sender ID of the message is automatically determined and is the instance
  * serial of the interface where the message was enqueued using
  * Interface::msgq_enqueue().
@@ -49,7 +225,7 @@ namespace fawkes {
 
 /** @var Message::data_ptr
  * Pointer to memory that contains local data. This memory has to be allocated
- * by deriving classes with the approppriate size!
+ * by deriving classes with the approppriate size using alloc_data()!
  */
 
 /** @var Message::data_size
@@ -64,6 +240,7 @@ namespace fawkes {
 Message::Message(const char *type)
 {
   fieldinfo_list_ = NULL;
+  fieldinfo_last_ = NULL;
 
   message_id_ = 0;
   hops_       = 0;
@@ -72,19 +249,12 @@ Message::Message(const char *type)
   data_ptr     = NULL;
   data_ts      = NULL;
   _sender_id   = 0;
-  _type        = strdup(type);
-  time_enqueued_ = new Time();
 
   _transmit_via_iface              = NULL;
   sender_interface_instance_serial = 0;
   recipient_interface_mem_serial   = 0;
 
-  std::string sender_name = Thread::current_thread_name();
-  if (sender_name != "") {
-	  _sender_thread_name = strdup(sender_name.c_str());
-  } else {
-	  _sender_thread_name = strdup("Unknown");
-  }
+  init(type);
 }
 
 
@@ -92,17 +262,16 @@ Message::Message(const char *type)
  * @param mesg Message to copy.
  */
 Message::Message(const Message &mesg)
+  : time_enqueued_(mesg.time_enqueued_)
 {
   message_id_ = 0;
   hops_       = mesg.hops_;
   enqueued_   = false;
   num_fields_ = mesg.num_fields_;
   data_size    = mesg.data_size;
-  data_ptr     = malloc(data_size);
+  data_ptr     = alloc_data(data_size);
   data_ts      = (message_data_ts_t *)data_ptr;
   _sender_id   = 0;
-  _type        = strdup(mesg._type);
-  time_enqueued_ = new Time(mesg.time_enqueued_);
 
   _transmit_via_iface              = NULL;
   sender_interface_instance_serial = 0;
@@ -110,23 +279,12 @@ Message::Message(const Message &mesg)
 
   memcpy(data_ptr, mesg.data_ptr, data_size);
 
-  interface_fieldinfo_t  *info_src  = mesg.fieldinfo_list_;
-  interface_fieldinfo_t **info_dest = &fieldinfo_list_;
-  while ( info_src ) {
-    interface_fieldinfo_t *new_info = (interface_fieldinfo_t *)malloc(sizeof(interface_fieldinfo_t));
-    memcpy(new_info, info_src, sizeof(interface_fieldinfo_t));
-    *info_dest = new_info;
+  // the field info table is shared and stores offsets into the data chunk
+  fieldinfo_list_ = mesg.fieldinfo_list_;
+  fieldinfo_last_ = mesg.fieldinfo_last_;
 
-    info_dest = &((*info_dest)->next);
-    info_src  = info_src->next;
-  }
-
-  Thread *t = Thread::current_thread_noexc();
-  if ( t ) {
-    _sender_thread_name = strdup(t->name());
-  } else {
-    _sender_thread_name    = strdup("Unknown");
-  }
+  init(mesg._type);
+  type_info_ = mesg.type_info_;
 }
 
 
@@ -134,56 +292,66 @@ Message::Message(const Message &mesg)
  * @param mesg Message to copy.
  */
 Message::Message(const Message *mesg)
+  : time_enqueued_(mesg->time_enqueued_)
 {
   message_id_ = 0;
   hops_       = mesg->hops_;
   enqueued_   = false;
   num_fields_ = mesg->num_fields_;
   data_size    = mesg->data_size;
-  data_ptr     = malloc(data_size);
+  data_ptr     = alloc_data(data_size);
   data_ts      = (message_data_ts_t *)data_ptr;
   _sender_id   = 0;
-  _type        = strdup(mesg->_type);
   _transmit_via_iface              = NULL;
   sender_interface_instance_serial = 0;
   recipient_interface_mem_serial   = 0;
-  time_enqueued_ = new Time(mesg->time_enqueued_);
 
   memcpy(data_ptr, mesg->data_ptr, data_size);
 
-  interface_fieldinfo_t  *info_src  = mesg->fieldinfo_list_;
-  interface_fieldinfo_t **info_dest = &fieldinfo_list_;
-  while ( info_src ) {
-    interface_fieldinfo_t *new_info = (interface_fieldinfo_t *)malloc(sizeof(interface_fieldinfo_t));
-    memcpy(new_info, info_src, sizeof(interface_fieldinfo_t));
-    *info_dest = new_info;
-
-    info_dest = &((*info_dest)->next);
-    info_src  = info_src->next;
-  }
+  fieldinfo_list_ = mesg->fieldinfo_list_;
+  fieldinfo_last_ = mesg->fieldinfo_last_;
 
-  Thread *t = Thread::current_thread_noexc();
-  if ( t ) {
-    _sender_thread_name    = strdup(t->name());
-  } else {
-    _sender_thread_name    = strdup("Unknown");
-  }
+  init(mesg->_type);
+  type_info_ = mesg->type_info_;
 }
 
 
 /** Destructor. */
 Message::~Message()
 {
-  free(_sender_thread_name);
-  free(_type);
-  delete time_enqueued_;
+  // type name, sender name and field info are shared, nothing to free
+}
+
+
+/** Initialize type and sender information.
+ * Looks up the interned type name and the interned name of the sending
+ * thread. Both are cached per thread, such that constructing a message of
+ * the same type as the last one does not require any locking or
+ * allocation. The shared field info is looked up when the first field is
+ * added, only then the actual message class is known.
+ * @param type message type
+ */
+void
+Message::init(const char *type)
+{
+  static __thread const char *last_type_name = NULL;
+  static __thread const char *last_sender_name = NULL;
+
+  msgq_link_.next = NULL;
+  msgq_link_.msg  = this;
 
-  interface_fieldinfo_t *infol = fieldinfo_list_;
-  while ( infol ) {
-    fieldinfo_list_ = fieldinfo_list_->next;
-    free(infol);
-    infol = fieldinfo_list_;
+  type_info_ = NULL;
+  if (! last_type_name || (strcmp(last_type_name, type) != 0)) {
+    last_type_name = intern_name(type);
   }
+  _type = last_type_name;
+
+  Thread *t = Thread::current_thread_noexc();
+  const char *sender_name = t ? t->name() : "Unknown";
+  if (! last_sender_name || (strcmp(last_sender_name, sender_name) != 0)) {
+    last_sender_name = intern_name(sender_name);
+  }
+  _sender_thread_name = last_sender_name;
 }
 
 
@@ -231,9 +399,9 @@ Message::set_hops(unsigned int hops)
 void
 Message::mark_enqueued()
 {
-  time_enqueued_->stamp();
+  time_enqueued_.stamp();
   long sec = 0, usec = 0;
-  time_enqueued_->get_timestamp(sec, usec);
+  time_enqueued_.get_timestamp(sec, usec);
   data_ts->timestamp_sec  = sec;
   data_ts->timestamp_usec = usec;
 
@@ -261,7 +429,7 @@ Message::enqueued() const
 const Time *
 Message::time_enqueued() const
 {
-  return time_enqueued_;
+  return &time_enqueued_;
 }
 
 
@@ -304,7 +472,7 @@ void
 Message::set_from_chunk(const void *chunk)
 {
   memcpy(data_ptr, chunk, data_size);
-  time_enqueued_->set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
+  time_enqueued_.set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
 }
 
 
@@ -318,7 +486,7 @@ Message::operator=  (const Message & m)
 {
   if ( data_size == m.data_size ) {
     memcpy(data_ptr, m.data_ptr, data_size);
-    time_enqueued_->set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
+    time_enqueued_.set_time(data_ts->timestamp_sec, data_ts->timestamp_usec);
   }
 
   return *this;
@@ -384,7 +552,7 @@ Message::type() const
 InterfaceFieldIterator
 Message::fields()
 {
-  return InterfaceFieldIterator(_transmit_via_iface, fieldinfo_list_);
+  return InterfaceFieldIterator(_transmit_via_iface, fieldinfo_list_, data_ptr);
 }
 
 
@@ -422,42 +590,133 @@ Message::clone() const
  * Never use directly, use the interface generator instead. The info list
  * is used for introspection purposes to allow for iterating over all fields
  * of an interface.
+ *
+ * The info list is shared among all messages of the same class. It is built
+ * by the first message of a class, subsequent messages only verify that
+ * they add the same fields in the same order and do not allocate any
+ * memory. Values are stored as offsets relative to the data chunk, hence
+ * data_ptr must be set before adding fields.
  * @param type field type
  * @param name name of the field, this is referenced, not copied
  * @param length length of the field
  * @param value pointer to the value in the data struct
  * @param enumtype in case the type parameter is enum the name of the enum type
  * @param enum_map enum value map
+ * @exception TypeMismatchException thrown if the field does not match the
+ * field at the same position in the shared info list of the message type
  */
 void
 Message::add_fieldinfo(interface_fieldtype_t type, const char *name,
 		       size_t length, void *value, const char *enumtype,
 		       const interface_enum_map_t *enum_map)
 {
-  interface_fieldinfo_t *infol = fieldinfo_list_;
-  interface_fieldinfo_t *newinfo = (interface_fieldinfo_t *)malloc(sizeof(interface_fieldinfo_t));
-
-  newinfo->type     = type;
-  newinfo->enumtype = enumtype;
-  newinfo->name     = name;
-  newinfo->length   = length;
-  newinfo->value    = value;
-  newinfo->enum_map = enum_map;
-  newinfo->next     = NULL;
-
-  if ( infol == NULL ) {
-    // first entry
-    fieldinfo_list_ = newinfo;
-  } else {
-    // append to list
-    while ( infol->next != NULL ) {
-      infol = infol->next;
+  static __thread TypeInfo *last_type_info = NULL;
+
+  if (! type_info_) {
+    // called from the constructor of the message class, hence typeid
+    // yields that class and not a base class
+    const std::type_info &cxxtype = typeid(*this);
+    if (last_type_info && (*last_type_info->cxxtype == cxxtype)) {
+      type_info_ = last_type_info;
+    } else {
+      type_info_ = last_type_info = TypeInfo::get(cxxtype);
     }
-    infol->next = newinfo;
   }
 
+  TypeInfo *ti = type_info_;
+  void *offset = (void *)((uintptr_t)value - (uintptr_t)data_ptr);
+
+  if (num_fields_ >= __atomic_load_n(&ti->num_fields, __ATOMIC_ACQUIRE)) {
+    // first message of this type, or another thread is just building the list
+    type_registry_lock();
+    if (num_fields_ >= ti->num_fields) {
+      interface_fieldinfo_t *newinfo =
+	(interface_fieldinfo_t *)malloc(sizeof(interface_fieldinfo_t));
+
+      newinfo->type     = type;
+      newinfo->enumtype = enumtype;
+      newinfo->name     = name;
+      newinfo->length   = length;
+      newinfo->value    = offset;
+      newinfo->enum_map = enum_map;
+      newinfo->next     = NULL;
+
+      if (ti->fieldinfo_last) {
+	ti->fieldinfo_last->next = newinfo;
+      } else {
+	ti->fieldinfo_list = newinfo;
+      }
+      ti->fieldinfo_last = newinfo;
+      __atomic_store_n(&ti->num_fields, ti->num_fields + 1, __ATOMIC_RELEASE);
+    }
+    type_registry_unlock();
+  }
+
+  interface_fieldinfo_t *info =
+    fieldinfo_last_ ? fieldinfo_last_->next : ti->fieldinfo_list;
+
+  if ((info->type != type) || (info->length != length) || (info->value != offset) ||
+      ((info->name != name) && (strcmp(info->name, name) != 0)))
+  {
+    throw TypeMismatchException("Field %s of message type %s does not match "
+				"the shared field info", name, _type);
+  }
+
+  if (! fieldinfo_list_)  fieldinfo_list_ = info;
+  fieldinfo_last_ = info;
+
   ++num_fields_;
 }
 
 
+/** Allocate message object.
+ * Message objects are taken from pools of the size of the message class.
+ * @param size size of the message object
+ * @return memory for the message object
+ */
+void *
+Message::operator new(size_t size)
+{
+  return pool_alloc(size);
+}
+
+
+/** Free message object.
+ * The memory is returned to the pool for the size of the message class.
+ * @param ptr message object memory
+ * @param size size of the message object
+ */
+void
+Message::operator delete(void *ptr, size_t size)
+{
+  pool_free(ptr, size);
+}
+
+
+/** Allocate data chunk.
+ * Use this instead of malloc() in derived classes to allocate data_ptr.
+ * The chunk is taken from a pool of the given size, such that constructing
+ * a message does not allocate memory after the first few messages of a type.
+ * @param size size of the data chunk, usually data_size
+ * @return memory for the data chunk
+ */
+void *
+Message::alloc_data(size_t size)
+{
+  return pool_alloc(size);
+}
+
+
+/** Free data chunk.
+ * Return a data chunk allocated with alloc_data() to the pool.
+ * @param ptr data chunk
+ * @param size size of the data chunk as passed to alloc_data()
+ */
+void
+Message::free_data(void *ptr, size_t size)
+{
+  pool_free(ptr, size);
+}
+
+
 } // end namespace fawkes
@@ -28,6 +28,9 @@
 #include <interface/types.h>
 #include <core/utils/refcount.h>
 #include <core/exceptions/software.h>
+#include <utils/time/time.h>
+
+#include <cstddef>
 
 #define INTERFACE_MESSAGE_TYPE_SIZE_ 32
 
@@ -36,11 +39,12 @@ namespace fawkes {
 class Mutex;
 class Interface;
 class InterfaceFieldIterator;
-class Time;
+class MessageQueue;
 
 class Message : public RefCount
 {
  friend Interface;
+ friend MessageQueue;
  public:
   Message(const char *type);
   Message(const Message *mesg);
@@ -77,6 +81,9 @@ class Message : public RefCount
 
   virtual Message * clone() const;
 
+  static void *     operator new(size_t size);
+  static void       operator delete(void *ptr, size_t size);
+
   /** Check if message has desired type.
    * @return true, if message has desired type, false otherwise
    */
@@ -92,32 +99,50 @@ class Message : public RefCount
     MessageType * as_type();
 
  private: // fields
+  /// @cond INTERNALS
+  struct TypeInfo;
+  /// @endcond
+
   unsigned int  message_id_;
   unsigned int  hops_;
   bool          enqueued_;
-  Time         *time_enqueued_;
+  Time          time_enqueued_;
 
   unsigned int  recipient_interface_mem_serial;  
   unsigned int  sender_interface_instance_serial;  
 
-  char          *_type;
-  char          *_sender_thread_name;
+  TypeInfo      *type_info_;
+  const char    *_type;
+  const char    *_sender_thread_name;
   unsigned int   _sender_id;
 
   Interface     *_transmit_via_iface;
 
   interface_fieldinfo_t  *fieldinfo_list_;
+  interface_fieldinfo_t  *fieldinfo_last_;
 
   unsigned int num_fields_;
 
+  /// @cond INTERNALS
+  struct QueueLink {
+    QueueLink   *next;
+    Message     *msg;
+  };
+  /// @endcond
+  QueueLink      msgq_link_;
+
  private: // methods
   void              set_interface(Interface *iface);
+  void              init(const char *type);
 
  protected:
   void add_fieldinfo(interface_fieldtype_t type, const char *name,
 		     size_t length, void *value, const char *enumtype = 0,
 		     const interface_enum_map_t *enum_map = 0);
 
+  static void * alloc_data(size_t size);
+  static void   free_data(void *ptr, size_t size);
+
   void         *data_ptr;
   unsigned int  data_size;
 
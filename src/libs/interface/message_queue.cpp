@@ -53,6 +53,16 @@ MessageAlreadyQueuedException::MessageAlreadyQueuedException()
  * This message queue handles the basic messaging operations. The methods the
  * Interface provides for handling message queues are forwarded to a
  * MessageQueue instance.
+ *
+ * By default all operations are serialized by a mutex. In MPSC mode
+ * (multiple producers, single consumer, see set_mpsc()), messages are
+ * appended without taking the lock. They are linked into a lock-free
+ * intake queue (an intrusive MPSC queue as described by Dmitry Vyukov)
+ * and moved to the queue in the order of their appending by the next
+ * operation of the consumer. The consumer side still uses
+ * the mutex, which is uncontended if a single thread consumes messages.
+ * Iterators see the queue as it was when the queue was locked, messages
+ * appended while the queue is locked become visible after unlocking.
  * @see Interface
  */
 
@@ -62,6 +72,11 @@ MessageQueue::MessageQueue()
 {
   list_ = NULL;
   end_el_ = NULL;
+  free_list_ = NULL;
+  intake_stub_.next = NULL;
+  intake_stub_.msg  = NULL;
+  intake_head_ = intake_tail_ = &intake_stub_;
+  mpsc_ = false;
   mutex_ = new Mutex();
 }
 
@@ -70,6 +85,11 @@ MessageQueue::MessageQueue()
 MessageQueue::~MessageQueue()
 {
   flush();
+  while ( free_list_ ) {
+    msg_list_t *next = free_list_->next;
+    free(free_list_);
+    free_list_ = next;
+  }
   delete mutex_;
 }
 
@@ -81,16 +101,18 @@ void
 MessageQueue::flush()
 {
   mutex_->lock();
+  drain();
   // free list elements
   msg_list_t *l = list_;
   msg_list_t *next;
   while ( l ) {
     next = l->next;
     l->msg->unref();
-    free(l);
+    free_node(l);
     l = next;
   }
   list_ = NULL;
+  end_el_ = NULL;
   mutex_->unlock();
 }
 
@@ -106,24 +128,118 @@ MessageQueue::append(Message *msg)
   if ( msg->enqueued() != 0 ) {
     throw MessageAlreadyQueuedException();
   }
+  if ( __atomic_load_n(&mpsc_, __ATOMIC_ACQUIRE) ) {
+    msg->mark_enqueued();
+    push_intake(&msg->msgq_link_);
+    return;
+  }
+
   mutex_->lock();
   msg->mark_enqueued();
+  push_back(msg);
+  mutex_->unlock();
+}
+
+
+/** Enable or disable MPSC mode.
+ * In MPSC mode appending a message does not take the lock, such that
+ * multiple producers do not contend with each other or with the consumer.
+ * Message IDs and the order of messages are kept.
+ * @param enabled true to enable MPSC mode, false to disable
+ */
+void
+MessageQueue::set_mpsc(bool enabled)
+{
+  mutex_->lock();
+  __atomic_store_n(&mpsc_, enabled, __ATOMIC_RELEASE);
+  drain();
+  mutex_->unlock();
+}
+
+
+/** Check if MPSC mode is enabled.
+ * @return true if MPSC mode is enabled, false otherwise
+ */
+bool
+MessageQueue::mpsc() const
+{
+  return __atomic_load_n(&mpsc_, __ATOMIC_ACQUIRE);
+}
+
+
+/** Append message to list.
+ * The queue must be locked.
+ * @param msg message to append
+ */
+void
+MessageQueue::push_back(Message *msg)
+{
+  msg_list_t *l = alloc_node();
+  l->next = NULL;
+  l->msg = msg;
+  l->msg_id = msg->id();
   if ( list_ == NULL ) {
-    list_ = (msg_list_t *)malloc(sizeof(msg_list_t));
-    list_->next = NULL;
-    list_->msg = msg;
-    list_->msg_id = msg->id();
-    end_el_ = list_;
+    list_ = l;
   } else {
-    msg_list_t *l = (msg_list_t *)malloc(sizeof(msg_list_t));
-    l->next = NULL;
-    l->msg = msg;
-    l->msg_id = msg->id();
     end_el_->next = l;
-    end_el_ = l;
   }
+  end_el_ = l;
+}
 
-  mutex_->unlock();
+
+/** Link element into intake queue.
+ * Wait-free, may be called by any number of threads concurrently.
+ * @param link link of the message to append, or the stub
+ */
+void
+MessageQueue::push_intake(Message::QueueLink *link)
+{
+  link->next = NULL;
+  Message::QueueLink *prev = __atomic_exchange_n(&intake_head_, link, __ATOMIC_ACQ_REL);
+  // until this store the consumer cannot see link and the elements after it
+  __atomic_store_n(&prev->next, link, __ATOMIC_RELEASE);
+}
+
+
+/** Check if intake queue is empty.
+ * The queue must be locked.
+ * @return true if no message is waiting in the intake queue
+ */
+bool
+MessageQueue::intake_empty() const
+{
+  return ( (intake_tail_ == &intake_stub_) &&
+	   (__atomic_load_n(&intake_head_, __ATOMIC_ACQUIRE) == &intake_stub_) );
+}
+
+
+/** Move messages from intake to list.
+ * Takes all messages appended in MPSC mode and appends them to the list
+ * in the order they were appended. A message whose producer has not
+ * finished linking it is left in the intake, together with all messages
+ * appended after it, and moved by a later call. The queue must be locked.
+ */
+void
+MessageQueue::drain()
+{
+  for (;;) {
+    Message::QueueLink *tail = intake_tail_;
+    Message::QueueLink *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if ( tail == &intake_stub_ ) {
+      if ( next == NULL )  return;
+      intake_tail_ = tail = next;
+      next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+    if ( next == NULL ) {
+      if ( tail != __atomic_load_n(&intake_head_, __ATOMIC_ACQUIRE) )  return;
+      // tail is the last message, put the stub behind it to take it
+      push_intake(&intake_stub_);
+      next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+      if ( next == NULL )  return;
+    }
+    intake_tail_ = next;
+    push_back(tail->msg);
+  }
 }
 
 
@@ -150,7 +266,7 @@ MessageQueue::insert_after(const MessageIterator &it, Message *msg)
     throw MessageAlreadyQueuedException();
   }
   msg->mark_enqueued();
-  msg_list_t *l = (msg_list_t *)malloc(sizeof(msg_list_t));
+  msg_list_t *l = alloc_node();
   l->next = it.cur->next;
   l->msg = msg;
   l->msg_id = msg->id();
@@ -168,6 +284,7 @@ void
 MessageQueue::remove(const Message *msg)
 {
   mutex_->lock();
+  drain();
   msg_list_t *l = list_;
   msg_list_t *p = NULL;
   while ( l ) {
@@ -190,6 +307,7 @@ void
 MessageQueue::remove(const unsigned int msg_id)
 {
   mutex_->lock();
+  drain();
   msg_list_t *l = list_;
   msg_list_t *p = NULL;
   while ( l ) {
@@ -222,8 +340,42 @@ MessageQueue::remove(msg_list_t *l, msg_list_t *p)
     // was first element
     list_ = l->next;
   }
+  if ( l == end_el_ ) {
+    end_el_ = p;
+  }
   l->msg->unref();
-  free(l);
+  free_node(l);
+}
+
+
+/** Get list element.
+ * Elements of removed messages are recycled, such that enqueuing a message
+ * does not allocate memory once the queue has been filled before. The queue
+ * must be locked.
+ * @return unused list element
+ */
+MessageQueue::msg_list_t *
+MessageQueue::alloc_node()
+{
+  msg_list_t *l = free_list_;
+  if ( l ) {
+    free_list_ = l->next;
+  } else {
+    l = (msg_list_t *)malloc(sizeof(msg_list_t));
+  }
+  return l;
+}
+
+
+/** Put list element to recycle list.
+ * The queue must be locked.
+ * @param l list element which is no longer used
+ */
+void
+MessageQueue::free_node(msg_list_t *l)
+{
+  l->next = free_list_;
+  free_list_ = l;
 }
 
 
@@ -240,6 +392,12 @@ MessageQueue::size() const
     ++rv;
     l = l->next;
   }
+  // linked intake elements are not modified until drained
+  Message::QueueLink *i = intake_tail_;
+  while ( i ) {
+    if ( i != &intake_stub_ )  ++rv;
+    i = __atomic_load_n(&i->next, __ATOMIC_ACQUIRE);
+  }
 
   mutex_->unlock();
   return rv;
@@ -253,7 +411,7 @@ bool
 MessageQueue::empty() const
 {
   mutex_->lock();
-  bool rv = ( list_ == NULL );
+  bool rv = ( list_ == NULL ) && intake_empty();
   mutex_->unlock();
   return rv;
 }
@@ -269,6 +427,7 @@ void
 MessageQueue::lock()
 {
   mutex_->lock();
+  drain();
 }
 
 
@@ -282,7 +441,12 @@ MessageQueue::lock()
 bool
 MessageQueue::try_lock()
 {
-  return mutex_->try_lock();
+  if ( mutex_->try_lock() ) {
+    drain();
+    return true;
+  } else {
+    return false;
+  }
 }
 
 
@@ -296,11 +460,20 @@ MessageQueue::unlock()
 
 
 /** Get first message from queue.
+ * In MPSC mode, messages appended since the last operation are moved to the
+ * queue if it is empty and not locked.
  * @return first message from queue
  */
 Message *
 MessageQueue::first()
 {
+  if ( (list_ == NULL) &&
+       (__atomic_load_n(&intake_head_, __ATOMIC_RELAXED) != &intake_stub_) &&
+       mutex_->try_lock() )
+  {
+    drain();
+    mutex_->unlock();
+  }
   if ( list_ ) {
     return list_->msg;
   } else {
@@ -315,6 +488,9 @@ void
 MessageQueue::pop()
 {
   mutex_->lock();
+  if ( list_ == NULL ) {
+    drain();
+  }
   if ( list_ ) {
     remove(list_, NULL);
   }
@@ -24,6 +24,7 @@
 #ifndef _INTERFACE_MESSAGE_QUEUE_H_
 #define _INTERFACE_MESSAGE_QUEUE_H_
 
+#include <interface/message.h>
 #include <core/exception.h>
 #include <core/exceptions/software.h>
 
@@ -96,6 +97,9 @@ class MessageQueue
   void         flush();
   bool         empty() const;
 
+  void         set_mpsc(bool enabled);
+  bool         mpsc() const;
+
   void         lock();
   bool         try_lock();
   void         unlock();
@@ -108,9 +112,20 @@ class MessageQueue
 
  private:
   void remove(msg_list_t *l, msg_list_t *p);
+  msg_list_t * alloc_node();
+  void         free_node(msg_list_t *l);
+  void         push_back(Message *msg);
+  void         push_intake(Message::QueueLink *link);
+  void         drain();
+  bool         intake_empty() const;
 
   msg_list_t  *list_;
   msg_list_t  *end_el_;
+  msg_list_t  *free_list_;
+  Message::QueueLink *intake_head_;
+  Message::QueueLink *intake_tail_;
+  Message::QueueLink  intake_stub_;
+  bool         mpsc_;
   Mutex       *mutex_;
 };
 
@@ -0,0 +1,214 @@
+
+/***************************************************************************
+ *  qa_msgq_contention.cpp - Message queue contention QA
+ *
+ *  Created: Fri Oct 16 22:14:37 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+/// @cond QA
+
+#include <interface/message.h>
+#include <interface/message_queue.h>
+
+#include <core/threading/thread.h>
+#include <utils/time/time.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+using namespace fawkes;
+
+class QaMessage : public Message
+{
+ public:
+  QaMessage(unsigned int producer, unsigned int seq) : Message("QaMessage")
+  {
+    data_size = sizeof(QaMessage_data_t);
+    data_ptr  = alloc_data(data_size);
+    memset(data_ptr, 0, data_size);
+    data      = (QaMessage_data_t *)data_ptr;
+    data_ts   = (message_data_ts_t *)data_ptr;
+    data->producer = producer;
+    data->seq      = seq;
+    add_fieldinfo(IFT_UINT32, "producer", 1, &data->producer);
+    add_fieldinfo(IFT_UINT32, "seq", 1, &data->seq);
+  }
+
+  ~QaMessage()
+  {
+    free_data(data_ptr, data_size);
+  }
+
+  unsigned int producer() const { return data->producer; }
+  unsigned int seq() const { return data->seq; }
+
+ private:
+  typedef struct {
+    int64_t  timestamp_sec;
+    int64_t  timestamp_usec;
+    uint32_t producer;
+    uint32_t seq;
+  } QaMessage_data_t;
+
+  QaMessage_data_t *data;
+};
+
+
+class ProducerThread : public Thread
+{
+ public:
+  ProducerThread(MessageQueue *msgq, unsigned int producer, unsigned int num_messages)
+    : Thread("ProducerThread", Thread::OPMODE_WAITFORWAKEUP)
+  {
+    msgq_         = msgq;
+    producer_     = producer;
+    num_messages_ = num_messages;
+  }
+
+  ~ProducerThread()
+  {
+    for (unsigned int i = 0; i < messages_.size(); ++i)  messages_[i]->unref();
+  }
+
+  // create messages up front, only appending is measured
+  virtual void init()
+  {
+    for (unsigned int i = 0; i < num_messages_; ++i) {
+      QaMessage *m = new QaMessage(producer_, i);
+      m->set_id((producer_ << 24) | i);
+      // keep a reference, such that the consumer does not delete the message
+      m->ref();
+      messages_.push_back(m);
+    }
+  }
+
+  virtual void loop()
+  {
+    Time start;
+    for (unsigned int i = 0; i < num_messages_; ++i) {
+      msgq_->append(messages_[i]);
+    }
+    Time end;
+    append_sec_ = end.in_sec() - start.in_sec();
+  }
+
+  double append_sec() const { return append_sec_; }
+
+ private:
+  MessageQueue *msgq_;
+  unsigned int  producer_;
+  unsigned int  num_messages_;
+  double        append_sec_;
+  std::vector<QaMessage *> messages_;
+};
+
+
+static bool
+run(bool mpsc, unsigned int num_producers, unsigned int num_messages, bool iterate)
+{
+  MessageQueue *msgq = new MessageQueue();
+  msgq->set_mpsc(mpsc);
+
+  std::vector<ProducerThread *> producers;
+  for (unsigned int i = 0; i < num_producers; ++i) {
+    producers.push_back(new ProducerThread(msgq, i, num_messages));
+    producers.back()->init();
+    producers.back()->start();
+  }
+
+  std::vector<unsigned int> next_seq(num_producers, 0);
+  unsigned int total = num_producers * num_messages, received = 0;
+  bool ok = true;
+
+  Time start;
+  for (unsigned int i = 0; i < num_producers; ++i)  producers[i]->wakeup();
+
+  while (received < total) {
+    if (iterate) {
+      // consume in batches, like threads processing their queue once per loop
+      msgq->lock();
+      unsigned int last_id = 0;
+      for (MessageQueue::MessageIterator it = msgq->begin(); it != msgq->end(); ++it) {
+	if (it.id() != it->id())  ok = false;
+	last_id = it.id();
+      }
+      msgq->unlock();
+      while (! msgq->empty()) {
+	QaMessage *m = dynamic_cast<QaMessage *>(msgq->first());
+	if (m == NULL)  break;
+	if (m->seq() != next_seq[m->producer()]++)  ok = false;
+	++received;
+	bool last = (m->id() == last_id);
+	msgq->pop();
+	if (last)  break;
+      }
+    } else {
+      Message *m = msgq->first();
+      if (m == NULL)  continue;
+      QaMessage *qm = dynamic_cast<QaMessage *>(m);
+      if (qm->seq() != next_seq[qm->producer()]++)  ok = false;
+      if (m->id() != ((qm->producer() << 24) | qm->seq()))  ok = false;
+      ++received;
+      msgq->pop();
+    }
+  }
+  Time end;
+
+  double append_sec = 0.;
+  for (unsigned int i = 0; i < num_producers; ++i) {
+    producers[i]->wait_loop_done();
+    producers[i]->cancel();
+    producers[i]->join();
+    append_sec += producers[i]->append_sec();
+    delete producers[i];
+  }
+  if (! msgq->empty())  ok = false;
+  delete msgq;
+
+  double sec = end.in_sec() - start.in_sec();
+  printf("%-7s %-8s %2u producers  %9.0f msgs/s  append %7.1f ns  %s\n",
+	 mpsc ? "mpsc" : "locked", iterate ? "iterate" : "pop", num_producers,
+	 total / sec, append_sec * 1e9 / total, ok ? "ok" : "ORDER VIOLATED");
+  return ok;
+}
+
+
+int
+main(int argc, char **argv)
+{
+  unsigned int num_messages = (argc > 1) ? atoi(argv[1]) : 200000;
+
+  Thread::init_main();
+
+  bool ok = true;
+  unsigned int num_producers[] = {1, 2, 4, 8};
+  for (unsigned int i = 0; i < sizeof(num_producers) / sizeof(unsigned int); ++i) {
+    for (int iterate = 0; iterate <= 1; ++iterate) {
+      ok &= run(false, num_producers[i], num_messages, iterate);
+      ok &= run(true,  num_producers[i], num_messages, iterate);
+    }
+  }
+
+  Thread::destroy_main();
+  return ok ? 0 : 1;
+}
+
+/// @endcond
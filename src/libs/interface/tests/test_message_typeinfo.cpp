@@ -0,0 +1,164 @@
+/***************************************************************************
+ *  test_message_typeinfo.cpp - Message type info unit test
+ *
+ *  Created: Fri Oct 16 19:41:05 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+
+// Messages of different interfaces commonly have the same name. Their
+// field info must not be mixed up, constructing one after the other in
+// the same process must neither throw nor yield the fields of the other.
+
+#include <gtest/gtest.h>
+
+#include <interface/message.h>
+#include <interface/field_iterator.h>
+
+#include <cstring>
+#include <string>
+
+using namespace fawkes;
+
+/** @class MotorInterface
+ * Scope for a message named like the one of SwitchInterface.
+ */
+class MotorInterface
+{
+ public:
+  /** Message with two float fields. */
+  class SetMessage : public Message
+  {
+   public:
+    /** Constructor.
+     * @param x x value
+     * @param y y value
+     */
+    SetMessage(float x, float y) : Message("SetMessage")
+    {
+      data_size = sizeof(SetMessage_data_t);
+      data_ptr  = alloc_data(data_size);
+      memset(data_ptr, 0, data_size);
+      data      = (SetMessage_data_t *)data_ptr;
+      data_ts   = (message_data_ts_t *)data_ptr;
+      data->x = x;
+      data->y = y;
+      add_fieldinfo(IFT_FLOAT, "x", 1, &data->x);
+      add_fieldinfo(IFT_FLOAT, "y", 1, &data->y);
+    }
+
+    /** Destructor. */
+    ~SetMessage()
+    {
+      free_data(data_ptr, data_size);
+    }
+
+   private:
+    typedef struct {
+      int64_t timestamp_sec;
+      int64_t timestamp_usec;
+      float   x;
+      float   y;
+    } SetMessage_data_t;
+
+    SetMessage_data_t *data;
+  };
+};
+
+/** @class SwitchInterface
+ * Scope for a message named like the one of MotorInterface.
+ */
+class SwitchInterface
+{
+ public:
+  /** Message with three fields of different types. */
+  class SetMessage : public Message
+  {
+   public:
+    /** Constructor.
+     * @param mode mode value
+     * @param label label string
+     */
+    SetMessage(int32_t mode, const char *label) : Message("SetMessage")
+    {
+      data_size = sizeof(SetMessage_data_t);
+      data_ptr  = alloc_data(data_size);
+      memset(data_ptr, 0, data_size);
+      data      = (SetMessage_data_t *)data_ptr;
+      data_ts   = (message_data_ts_t *)data_ptr;
+      data->mode = mode;
+      strncpy(data->label, label, sizeof(data->label) - 1);
+      add_fieldinfo(IFT_INT32, "mode", 1, &data->mode);
+      add_fieldinfo(IFT_STRING, "label", sizeof(data->label), data->label);
+      add_fieldinfo(IFT_BOOL, "enabled", 1, &data->enabled);
+    }
+
+    /** Destructor. */
+    ~SetMessage()
+    {
+      free_data(data_ptr, data_size);
+    }
+
+   private:
+    typedef struct {
+      int64_t timestamp_sec;
+      int64_t timestamp_usec;
+      int32_t mode;
+      char    label[32];
+      bool    enabled;
+    } SetMessage_data_t;
+
+    SetMessage_data_t *data;
+  };
+};
+
+/** Join field names and values as name=value.
+ * @param m message to get fields from
+ * @return space separated fields
+ */
+static std::string
+fields_string(Message *m)
+{
+  std::string rv;
+  for (InterfaceFieldIterator i = m->fields(); i != m->fields_end(); ++i) {
+    if (! rv.empty())  rv += " ";
+    rv += std::string(i.get_name()) + "=" + i.get_value_string();
+  }
+  return rv;
+}
+
+
+TEST(MessageTypeInfoTest, SameNamedMessages)
+{
+  for (unsigned int i = 0; i < 3; ++i) {
+    MotorInterface::SetMessage  *mm = NULL;
+    SwitchInterface::SetMessage *sm = NULL;
+    ASSERT_NO_THROW(mm = new MotorInterface::SetMessage(1.5, 2.5));
+    ASSERT_NO_THROW(sm = new SwitchInterface::SetMessage(3, "on"));
+
+    EXPECT_STREQ("SetMessage", mm->type());
+    EXPECT_STREQ("SetMessage", sm->type());
+    EXPECT_EQ(2u, mm->num_fields());
+    EXPECT_EQ(3u, sm->num_fields());
+    EXPECT_EQ("x=1.500000 y=2.500000", fields_string(mm));
+    EXPECT_EQ("mode=3 label=on enabled=false", fields_string(sm));
+
+    mm->unref();
+    sm->unref();
+  }
+}
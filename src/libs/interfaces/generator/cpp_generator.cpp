@@ -782,7 +782,7 @@ CppInterfaceGenerator::write_message_ctor_dtor_cpp(FILE *f,
     fprintf(f,") : %s(\"%s\")\n"
 	    "{\n"
 	    "  data_size = sizeof(%s_data_t);\n"
-	    "  data_ptr  = malloc(data_size);\n"
+	    "  data_ptr  = alloc_data(data_size);\n"
 	    "  memset(data_ptr, 0, data_size);\n"
 	    "  data      = (%s_data_t *)data_ptr;\n"
 	    "  data_ts   = (message_data_ts_t *)data_ptr;\n",
@@ -823,7 +823,7 @@ CppInterfaceGenerator::write_message_ctor_dtor_cpp(FILE *f,
 
   fprintf(f,
 	  "  data_size = sizeof(%s_data_t);\n"
-	  "  data_ptr  = malloc(data_size);\n"
+	  "  data_ptr  = alloc_data(data_size);\n"
 	  "  memset(data_ptr, 0, data_size);\n"
 	  "  data      = (%s_data_t *)data_ptr;\n"
 	  "  data_ts   = (message_data_ts_t *)data_ptr;\n",
@@ -837,7 +837,7 @@ CppInterfaceGenerator::write_message_ctor_dtor_cpp(FILE *f,
 	  "/** Destructor */\n"
 	  "%s%s::~%s()\n"
 	  "{\n"
-	  "  free(data_ptr);\n"
+	  "  free_data(data_ptr, data_size);\n"
 	  "}\n\n",
 	  inclusion_prefix.c_str(), classname.c_str(), classname.c_str());
 
@@ -852,7 +852,7 @@ CppInterfaceGenerator::write_message_ctor_dtor_cpp(FILE *f,
 
   fprintf(f,
 	  "  data_size = m->data_size;\n"
-	  "  data_ptr  = malloc(data_size);\n"
+	  "  data_ptr  = alloc_data(data_size);\n"
 	  "  memcpy(data_ptr, m->data_ptr, data_size);\n"
 	  "  data      = (%s_data_t *)data_ptr;\n"
 	  "  data_ts   = (message_data_ts_t *)data_ptr;\n",
@@ -0,0 +1,860 @@
+
+/***************************************************************************
+ *  async.cpp - Asynchronous logger wrapper
+ *
+ *  Created: Sat Oct 17 12:20:44 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <logging/async.h>
+
+#include <core/threading/thread.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <core/threading/wait_condition.h>
+#include <core/exceptions/software.h>
+#include <core/macros.h>
+
+#include <sys/time.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace fawkes {
+
+/// @cond INTERNALS
+class AsyncLoggerWriterThread : public Thread
+{
+ public:
+  AsyncLoggerWriterThread(AsyncLogger *logger)
+    : Thread("AsyncLoggerWriterThread", Thread::OPMODE_CONTINUOUS)
+  {
+    logger_ = logger;
+    set_prepfin_conc_loop(true);
+  }
+
+  virtual void loop()
+  {
+    CancelState old_state;
+    set_cancel_state(CANCEL_DISABLED, &old_state);
+    bool busy = logger_->drain();
+    if (busy)  logger_->wake_flush();
+    set_cancel_state(old_state);
+
+    if (! busy)  logger_->wait_pending();
+  }
+
+ /** Stub to see name in backtrace for easier debugging. @see Thread::run() */
+ protected: virtual void run() { Thread::run(); }
+
+ private:
+  AsyncLogger *logger_;
+};
+
+namespace {
+
+  typedef struct {
+    uint32_t        size;
+    uint16_t        type;
+    uint16_t        level;
+    uint32_t        num_messages;
+    uint32_t        reserved;
+    struct timeval  time;
+  } RecordHeader;
+
+  enum {
+    RECORD_PADDING   = 0,
+    RECORD_MESSAGE   = 1,
+    RECORD_EXCEPTION = 2
+  };
+
+  // messages longer than this are truncated
+  const size_t MAX_COMPONENT_LENGTH = 128;
+
+  // the idle writer wakes up this often to free rings of exited threads
+  const unsigned int IDLE_WAKEUP_NSEC = 100000000;
+
+  inline size_t
+  align8(size_t s)
+  {
+    return (s + 7) & ~(size_t)7;
+  }
+}
+/// @endcond
+
+
+/** @class AsyncLogger <logging/async.h>
+ * Asynchronous logger wrapper.
+ * This logger wraps another logger and moves its formatting and output
+ * to a background thread. The calling thread only formats the message
+ * into a ring buffer, it never blocks on a mutex or I/O of the wrapped
+ * logger. Each thread logging through this logger gets its own ring
+ * buffer, which is allocated on the first message of the thread, and the
+ * writer thread merges the messages of all rings by their time stamp.
+ * While there is nothing to write the writer thread sleeps on a wait
+ * condition. Only the first message after it went to sleep wakes it up,
+ * all others are just written to the ring.
+ *
+ * If the ring of a thread is full the message is dropped and counted. The
+ * number of dropped messages is logged by the writer thread and can be
+ * queried with dropped(). Messages longer than a quarter of the ring size
+ * are truncated.
+ *
+ * Arguments cannot be kept beyond the call, strings for example might be
+ * freed right after, therefore the message text is formatted in the
+ * calling thread. The time stamp formatting, decoration and output of the
+ * wrapped logger are deferred.
+ *
+ * The wrapped logger is owned by the async logger and deleted with it,
+ * unless it is released before with release().
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param logger logger to wrap, ownership is taken over
+ * @param ring_size size of the ring buffer of each thread in bytes,
+ * rounded up to the next power of two
+ */
+AsyncLogger::AsyncLogger(Logger *logger, size_t ring_size)
+  : Logger(wrapped_loglevel(logger))
+{
+  logger_ = logger;
+  ring_size_ = 1024;
+  while (ring_size_ < ring_size)  ring_size_ <<= 1;
+
+  dropped_ = dropped_reported_ = 0;
+  rings_mutex_ = new Mutex();
+
+  writer_sleeping_ = false;
+  flush_waiters_ = 0;
+  wakeup_mutex_ = new Mutex();
+  wakeup_cond_  = new WaitCondition(wakeup_mutex_);
+  drained_cond_ = new WaitCondition(wakeup_mutex_);
+
+  if (pthread_key_create(&ring_key_, &AsyncLogger::orphan_ring) != 0) {
+    delete drained_cond_;
+    delete wakeup_cond_;
+    delete wakeup_mutex_;
+    delete rings_mutex_;
+    throw Exception(errno, "AsyncLogger: failed to create thread key");
+  }
+
+  writer_ = new AsyncLoggerWriterThread(this);
+  writer_->start();
+}
+
+
+/** Get log level of logger to wrap.
+ * @param logger logger to wrap
+ * @return log level of the logger
+ * @exception NullPointerException thrown if logger is NULL
+ */
+Logger::LogLevel
+AsyncLogger::wrapped_loglevel(Logger *logger)
+{
+  if (logger == NULL) {
+    throw NullPointerException("AsyncLogger: logger to wrap may not be NULL");
+  }
+  return logger->loglevel();
+}
+
+
+/** Destructor.
+ * Writes all pending messages and deletes the wrapped logger, if it has
+ * not been released.
+ */
+AsyncLogger::~AsyncLogger()
+{
+  stop_writer();
+
+  // threads which exit now must no longer touch their ring
+  pthread_key_delete(ring_key_);
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    free(rings_[i]->buffer);
+    delete rings_[i];
+  }
+  delete drained_cond_;
+  delete wakeup_cond_;
+  delete wakeup_mutex_;
+  delete rings_mutex_;
+  delete logger_;
+}
+
+
+/** Get wrapped logger.
+ * @return wrapped logger
+ */
+Logger *
+AsyncLogger::logger() const
+{
+  return logger_;
+}
+
+
+/** Release wrapped logger.
+ * Pending messages are written, afterwards the wrapped logger is no longer
+ * owned by this logger. Do not log through this logger anymore after
+ * calling this method, delete it.
+ * @return wrapped logger
+ */
+Logger *
+AsyncLogger::release()
+{
+  stop_writer();
+
+  Logger *l = logger_;
+  logger_ = NULL;
+  return l;
+}
+
+
+/** Wait until all pending messages have been written.
+ * Messages logged concurrently while waiting may or may not be written.
+ */
+void
+AsyncLogger::flush()
+{
+  if (! writer_)  return;
+
+  std::vector<std::pair<Ring *, uint64_t> > pending;
+  rings_mutex_->lock();
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    pending.push_back(std::make_pair(rings_[i],
+				     __atomic_load_n(&rings_[i]->head, __ATOMIC_ACQUIRE)));
+  }
+  rings_mutex_->unlock();
+
+  wakeup_mutex_->lock();
+  __atomic_add_fetch(&flush_waiters_, 1, __ATOMIC_SEQ_CST);
+  for (;;) {
+    // rings of exited threads may have been freed meanwhile, check under lock
+    rings_mutex_->lock();
+    std::vector<std::pair<Ring *, uint64_t> >::iterator p;
+    for (p = pending.begin(); p != pending.end(); ) {
+      if ((std::find(rings_.begin(), rings_.end(), p->first) == rings_.end()) ||
+	  (__atomic_load_n(&p->first->tail, __ATOMIC_ACQUIRE) >= p->second))
+      {
+	p = pending.erase(p);
+      } else {
+	++p;
+      }
+    }
+    rings_mutex_->unlock();
+    if (pending.empty())  break;
+    drained_cond_->wait();
+  }
+  __atomic_sub_fetch(&flush_waiters_, 1, __ATOMIC_SEQ_CST);
+  wakeup_mutex_->unlock();
+}
+
+
+/** Get number of dropped messages.
+ * @return number of messages dropped because a ring buffer was full
+ */
+unsigned long
+AsyncLogger::dropped() const
+{
+  return __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+}
+
+
+/** Get number of ring buffers.
+ * Rings of threads which have exited are freed once all their messages
+ * have been written.
+ * @return number of ring buffers currently allocated
+ */
+size_t
+AsyncLogger::num_rings()
+{
+  MutexLocker lock(rings_mutex_);
+  return rings_.size();
+}
+
+
+/** Stop writer thread and write remaining messages. */
+void
+AsyncLogger::stop_writer()
+{
+  if (writer_) {
+    // cancelling interrupts the wait for messages, never a drain
+    writer_->cancel();
+    writer_->join();
+    delete writer_;
+    writer_ = NULL;
+  }
+  drain();
+}
+
+
+void
+AsyncLogger::set_loglevel(LogLevel level)
+{
+  Logger::set_loglevel(level);
+  if (logger_)  logger_->set_loglevel(level);
+}
+
+
+AsyncLogger::Ring *
+AsyncLogger::ring()
+{
+  Ring *r = (Ring *)pthread_getspecific(ring_key_);
+  if (likely(r != NULL))  return r;
+
+  r = new Ring();
+  r->buffer = (char *)malloc(ring_size_);
+  if (r->buffer == NULL) {
+    delete r;
+    return NULL;
+  }
+  r->size = ring_size_;
+  r->head = r->tail = 0;
+  r->orphaned = false;
+
+  MutexLocker lock(rings_mutex_);
+  rings_.push_back(r);
+  pthread_setspecific(ring_key_, r);
+  return r;
+}
+
+
+/** Mark ring as unused.
+ * Called when a thread exits, the writer thread frees the ring once all
+ * messages have been written.
+ * @param ring ring of the exiting thread
+ */
+void
+AsyncLogger::orphan_ring(void *ring)
+{
+  __atomic_store_n(&((Ring *)ring)->orphaned, true, __ATOMIC_RELEASE);
+}
+
+
+/** Reserve space in ring.
+ * @param r ring of the calling thread
+ * @param size aligned size of the record
+ * @param head upon return the head to publish after writing the record
+ * @return pointer to write the record to, NULL if the ring is full
+ */
+char *
+AsyncLogger::reserve(Ring *r, size_t size, uint64_t &head)
+{
+  uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  size_t   used = r->head - tail;
+  size_t   pos  = r->head & (r->size - 1);
+  size_t   contiguous = r->size - pos;
+
+  head = r->head;
+  if (size > contiguous) {
+    // record does not fit before the end, pad and wrap around
+    if (used + contiguous + size > r->size)  return NULL;
+    RecordHeader *pad = (RecordHeader *)&r->buffer[pos];
+    pad->size = contiguous;
+    pad->type = RECORD_PADDING;
+    head += contiguous;
+    pos = 0;
+  } else if (used + size > r->size) {
+    return NULL;
+  }
+
+  head += size;
+  return &r->buffer[pos];
+}
+
+
+/** Publish record written to ring.
+ * Makes the record visible to the writer thread and wakes it up if it
+ * is waiting for messages.
+ * @param r ring of the calling thread
+ * @param head head returned by reserve()
+ */
+void
+AsyncLogger::publish(Ring *r, uint64_t head)
+{
+  __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+  // pairs with the fence in wait_pending(), either the writer sees the
+  // new head or we see that it is sleeping
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&writer_sleeping_, __ATOMIC_RELAXED)) {
+    wakeup_mutex_->lock();
+    wakeup_cond_->wake_all();
+    wakeup_mutex_->unlock();
+  }
+}
+
+
+/** Check if any ring has messages to write.
+ * @return true if there are pending messages, false otherwise
+ */
+bool
+AsyncLogger::pending()
+{
+  MutexLocker lock(rings_mutex_);
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    if (__atomic_load_n(&rings_[i]->head, __ATOMIC_ACQUIRE) != rings_[i]->tail) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/** Wait for messages.
+ * Called by the writer thread when there is nothing to write. The wait
+ * is a cancellation point, the wait condition releases the mutex if the
+ * writer is cancelled while waiting.
+ */
+void
+AsyncLogger::wait_pending()
+{
+  wakeup_mutex_->lock();
+  drained_cond_->wake_all();
+  __atomic_store_n(&writer_sleeping_, true, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (! pending()) {
+    wakeup_cond_->reltimed_wait(0, IDLE_WAKEUP_NSEC);
+  }
+  __atomic_store_n(&writer_sleeping_, false, __ATOMIC_RELAXED);
+  wakeup_mutex_->unlock();
+}
+
+
+/** Wake up threads waiting in flush().
+ * Called by the writer thread after it has written messages.
+ */
+void
+AsyncLogger::wake_flush()
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&flush_waiters_, __ATOMIC_RELAXED) > 0) {
+    wakeup_mutex_->lock();
+    drained_cond_->wake_all();
+    wakeup_mutex_->unlock();
+  }
+}
+
+
+void
+AsyncLogger::push(LogLevel level, struct timeval *t, const char *component,
+		  const char *format, va_list va)
+{
+  if (level < log_level)  return;
+
+  struct timeval now;
+  if (t == NULL) {
+    gettimeofday(&now, NULL);
+    t = &now;
+  }
+
+  Ring *r = ring();
+  if (unlikely(r == NULL)) {
+    __atomic_add_fetch(&dropped_, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  char buf[256];
+  va_list vac;
+  va_copy(vac, va);
+  int n = vsnprintf(buf, sizeof(buf), format, vac);
+  va_end(vac);
+  if (n < 0)  n = 0;
+
+  if (component == NULL)  component = "";
+  size_t clen = strnlen(component, MAX_COMPONENT_LENGTH);
+  size_t mlen = n;
+  size_t max_size = r->size / 4;
+  if (align8(sizeof(RecordHeader) + clen + mlen + 2) > max_size) {
+    mlen = max_size - sizeof(RecordHeader) - clen - 2 - 7;
+  }
+  size_t size = align8(sizeof(RecordHeader) + clen + mlen + 2);
+
+  uint64_t head;
+  char *p = reserve(r, size, head);
+  if (p == NULL) {
+    __atomic_add_fetch(&dropped_, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  RecordHeader *h = (RecordHeader *)p;
+  h->size = size;
+  h->type = RECORD_MESSAGE;
+  h->level = level;
+  h->num_messages = 1;
+  h->time = *t;
+  char *c = p + sizeof(RecordHeader);
+  memcpy(c, component, clen);
+  c[clen] = 0;
+  char *m = c + clen + 1;
+  if (mlen < sizeof(buf)) {
+    memcpy(m, buf, mlen);
+    m[mlen] = 0;
+  } else {
+    vsnprintf(m, mlen + 1, format, va);
+  }
+
+  publish(r, head);
+}
+
+
+void
+AsyncLogger::push(LogLevel level, struct timeval *t, const char *component,
+		  Exception &e)
+{
+  if (level < log_level)  return;
+
+  struct timeval now;
+  if (t == NULL) {
+    gettimeofday(&now, NULL);
+    t = &now;
+  }
+
+  Ring *r = ring();
+  if (unlikely(r == NULL)) {
+    __atomic_add_fetch(&dropped_, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  if (component == NULL)  component = "";
+  size_t clen = strnlen(component, MAX_COMPONENT_LENGTH);
+  size_t max_size = r->size / 4;
+
+  // take as many messages as fit, the first one always, truncated if need be
+  size_t size = sizeof(RecordHeader) + clen + 1;
+  uint32_t num_messages = 0;
+  for (Exception::iterator i = e.begin(); i != e.end(); ++i) {
+    size_t mlen = strlen(*i) + 1;
+    if (align8(size + mlen) > max_size) {
+      if (num_messages == 0) {
+	size = max_size - 7;
+	num_messages = 1;
+      }
+      break;
+    }
+    size += mlen;
+    num_messages += 1;
+  }
+  size = align8(size);
+
+  uint64_t head;
+  char *p = reserve(r, size, head);
+  if (p == NULL) {
+    __atomic_add_fetch(&dropped_, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  RecordHeader *h = (RecordHeader *)p;
+  h->size = size;
+  h->type = RECORD_EXCEPTION;
+  h->level = level;
+  h->num_messages = num_messages;
+  h->time = *t;
+  char *c = p + sizeof(RecordHeader);
+  memcpy(c, component, clen);
+  c[clen] = 0;
+  char *m   = c + clen + 1;
+  char *end = p + size;
+  Exception::iterator i = e.begin();
+  for (uint32_t k = 0; k < num_messages; ++k, ++i) {
+    size_t mlen = strnlen(*i, end - m - 1);
+    memcpy(m, *i, mlen);
+    m[mlen] = 0;
+    m += mlen + 1;
+  }
+
+  publish(r, head);
+}
+
+
+/** Write pending messages.
+ * Must only be called by one thread at a time.
+ * @return true if any message has been written, false otherwise
+ */
+bool
+AsyncLogger::drain()
+{
+  rings_mutex_->lock();
+  drain_rings_ = rings_;
+  rings_mutex_->unlock();
+
+  bool written = false;
+  std::vector<uint64_t> heads(drain_rings_.size());
+  for (size_t i = 0; i < drain_rings_.size(); ++i) {
+    heads[i] = __atomic_load_n(&drain_rings_[i]->head, __ATOMIC_ACQUIRE);
+  }
+
+  for (;;) {
+    // merge the rings by time stamp, pick the oldest first record
+    Ring *best = NULL;
+    RecordHeader *best_h = NULL;
+    for (size_t i = 0; i < drain_rings_.size(); ++i) {
+      Ring *r = drain_rings_[i];
+      while (r->tail < heads[i]) {
+	RecordHeader *h = (RecordHeader *)&r->buffer[r->tail & (r->size - 1)];
+	if (h->type != RECORD_PADDING) {
+	  if (! best_h || timercmp(&h->time, &best_h->time, <)) {
+	    best = r;
+	    best_h = h;
+	  }
+	  break;
+	}
+	__atomic_store_n(&r->tail, r->tail + h->size, __ATOMIC_RELEASE);
+      }
+    }
+    if (! best)  break;
+
+    if (logger_) {
+      const char *component = (const char *)best_h + sizeof(RecordHeader);
+      const char *msg = component + strlen(component) + 1;
+      if (best_h->type == RECORD_MESSAGE) {
+	logger_->tlog((LogLevel)best_h->level, &best_h->time, component, "%s", msg);
+      } else {
+	Exception ex("%s", msg);
+	for (uint32_t k = 1; k < best_h->num_messages; ++k) {
+	  msg += strlen(msg) + 1;
+	  ex.append("%s", msg);
+	}
+	logger_->tlog((LogLevel)best_h->level, &best_h->time, component, ex);
+      }
+    }
+    __atomic_store_n(&best->tail, best->tail + best_h->size, __ATOMIC_RELEASE);
+    written = true;
+  }
+
+  unsigned long dropped = __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+  if (dropped != dropped_reported_ && logger_) {
+    logger_->log_warn("AsyncLogger", "Dropped %lu log messages, ring buffer full",
+		      dropped - dropped_reported_);
+    dropped_reported_ = dropped;
+  }
+
+  // free rings of exited threads once they are empty
+  MutexLocker lock(rings_mutex_);
+  for (std::vector<Ring *>::iterator r = rings_.begin(); r != rings_.end(); ) {
+    if (__atomic_load_n(&(*r)->orphaned, __ATOMIC_ACQUIRE) &&
+	(__atomic_load_n(&(*r)->head, __ATOMIC_ACQUIRE) == (*r)->tail))
+    {
+      free((*r)->buffer);
+      delete *r;
+      r = rings_.erase(r);
+    } else {
+      ++r;
+    }
+  }
+
+  return written;
+}
+
+
+void
+AsyncLogger::log_debug(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_DEBUG, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::log_info(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_INFO, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::log_warn(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_WARN, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::log_error(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_ERROR, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::vlog_debug(const char *component, const char *format, va_list va)
+{
+  push(LL_DEBUG, NULL, component, format, va);
+}
+
+
+void
+AsyncLogger::vlog_info(const char *component, const char *format, va_list va)
+{
+  push(LL_INFO, NULL, component, format, va);
+}
+
+
+void
+AsyncLogger::vlog_warn(const char *component, const char *format, va_list va)
+{
+  push(LL_WARN, NULL, component, format, va);
+}
+
+
+void
+AsyncLogger::vlog_error(const char *component, const char *format, va_list va)
+{
+  push(LL_ERROR, NULL, component, format, va);
+}
+
+
+void
+AsyncLogger::log_debug(const char *component, Exception &e)
+{
+  push(LL_DEBUG, NULL, component, e);
+}
+
+
+void
+AsyncLogger::log_info(const char *component, Exception &e)
+{
+  push(LL_INFO, NULL, component, e);
+}
+
+
+void
+AsyncLogger::log_warn(const char *component, Exception &e)
+{
+  push(LL_WARN, NULL, component, e);
+}
+
+
+void
+AsyncLogger::log_error(const char *component, Exception &e)
+{
+  push(LL_ERROR, NULL, component, e);
+}
+
+
+void
+AsyncLogger::tlog_debug(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_DEBUG, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::tlog_info(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_INFO, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::tlog_warn(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_WARN, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::tlog_error(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  push(LL_ERROR, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+AsyncLogger::tlog_debug(struct timeval *t, const char *component, Exception &e)
+{
+  push(LL_DEBUG, t, component, e);
+}
+
+
+void
+AsyncLogger::tlog_info(struct timeval *t, const char *component, Exception &e)
+{
+  push(LL_INFO, t, component, e);
+}
+
+
+void
+AsyncLogger::tlog_warn(struct timeval *t, const char *component, Exception &e)
+{
+  push(LL_WARN, t, component, e);
+}
+
+
+void
+AsyncLogger::tlog_error(struct timeval *t, const char *component, Exception &e)
+{
+  push(LL_ERROR, t, component, e);
+}
+
+
+void
+AsyncLogger::vtlog_debug(struct timeval *t, const char *component,
+			 const char *format, va_list va)
+{
+  push(LL_DEBUG, t, component, format, va);
+}
+
+
+void
+AsyncLogger::vtlog_info(struct timeval *t, const char *component,
+			const char *format, va_list va)
+{
+  push(LL_INFO, t, component, format, va);
+}
+
+
+void
+AsyncLogger::vtlog_warn(struct timeval *t, const char *component,
+			const char *format, va_list va)
+{
+  push(LL_WARN, t, component, format, va);
+}
+
+
+void
+AsyncLogger::vtlog_error(struct timeval *t, const char *component,
+			 const char *format, va_list va)
+{
+  push(LL_ERROR, t, component, format, va);
+}
+
+
+} // end namespace fawkes
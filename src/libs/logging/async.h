@@ -0,0 +1,143 @@
+
+/***************************************************************************
+ *  async.h - Asynchronous logger wrapper
+ *
+ *  Created: Sat Oct 17 12:20:44 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _UTILS_LOGGING_ASYNC_H_
+#define _UTILS_LOGGING_ASYNC_H_
+
+#include <logging/logger.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace fawkes {
+
+class Mutex;
+class WaitCondition;
+class AsyncLoggerWriterThread;
+
+class AsyncLogger : public Logger
+{
+  friend AsyncLoggerWriterThread;
+ public:
+  /** Default size of the ring buffer of each thread in bytes. */
+  static const size_t DEFAULT_RING_SIZE = 64 * 1024;
+
+  AsyncLogger(Logger *logger, size_t ring_size = DEFAULT_RING_SIZE);
+  virtual ~AsyncLogger();
+
+  Logger *       logger() const;
+  Logger *       release();
+
+  void           flush();
+  unsigned long  dropped() const;
+  size_t         num_rings();
+
+  virtual void set_loglevel(LogLevel level);
+
+  virtual void log_debug(const char *component, const char *format, ...);
+  virtual void log_info(const char *component, const char *format, ...);
+  virtual void log_warn(const char *component, const char *format, ...);
+  virtual void log_error(const char *component, const char *format, ...);
+
+  virtual void vlog_debug(const char *component, const char *format, va_list va);
+  virtual void vlog_info(const char *component, const char *format, va_list va);
+  virtual void vlog_warn(const char *component, const char *format, va_list va);
+  virtual void vlog_error(const char *component, const char *format, va_list va);
+
+  virtual void log_debug(const char *component, Exception &e);
+  virtual void log_info(const char *component, Exception &e);
+  virtual void log_warn(const char *component, Exception &e);
+  virtual void log_error(const char *component, Exception &e);
+
+  virtual void tlog_debug(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_info(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_warn(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_error(struct timeval *t, const char *component, const char *format, ...);
+
+  virtual void tlog_debug(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_info(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_warn(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_error(struct timeval *t, const char *component, Exception &e);
+
+  virtual void vtlog_debug(struct timeval *t, const char *component,
+			   const char *format, va_list va);
+  virtual void vtlog_info(struct timeval *t, const char *component,
+			  const char *format, va_list va);
+  virtual void vtlog_warn(struct timeval *t, const char *component,
+			  const char *format, va_list va);
+  virtual void vtlog_error(struct timeval *t, const char *component,
+			   const char *format, va_list va);
+
+ private:
+  /// @cond INTERNALS
+  struct Ring {
+    char      *buffer;
+    size_t     size;
+    uint64_t   head;
+    uint64_t   tail;
+    bool       orphaned;
+  };
+  /// @endcond
+
+  Ring *   ring();
+  void     push(LogLevel level, struct timeval *t, const char *component,
+		const char *format, va_list va);
+  void     push(LogLevel level, struct timeval *t, const char *component,
+		Exception &e);
+  char *   reserve(Ring *r, size_t size, uint64_t &head);
+  void     publish(Ring *r, uint64_t head);
+  bool     drain();
+  bool     pending();
+  void     wait_pending();
+  void     wake_flush();
+  void     stop_writer();
+  static void orphan_ring(void *ring);
+  static LogLevel wrapped_loglevel(Logger *logger);
+
+ private:
+  Logger                   *logger_;
+  size_t                    ring_size_;
+  pthread_key_t             ring_key_;
+
+  Mutex                    *rings_mutex_;
+  std::vector<Ring *>       rings_;
+  std::vector<Ring *>       drain_rings_;
+
+  Mutex                    *wakeup_mutex_;
+  WaitCondition            *wakeup_cond_;
+  WaitCondition            *drained_cond_;
+  bool                      writer_sleeping_;
+  unsigned int              flush_waiters_;
+
+  unsigned long             dropped_;
+  unsigned long             dropped_reported_;
+
+  AsyncLoggerWriterThread  *writer_;
+};
+
+
+} // end namespace fawkes
+
+#endif
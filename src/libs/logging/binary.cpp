@@ -0,0 +1,687 @@
+
+/***************************************************************************
+ *  binary.cpp - Fawkes binary structured logger
+ *
+ *  Created: Sun Oct 18 10:42:17 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <logging/binary.h>
+
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <core/macros.h>
+
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <unistd.h>
+
+namespace fawkes {
+
+/// @cond INTERNALS
+// formats and components beyond this are written as text, this bounds
+// memory if messages are logged with varying strings as format
+static const size_t MAX_DEFINITIONS = 65536;
+/// @endcond
+
+/** @class BinaryLogger <logging/binary.h>
+ * Logger writing a compact binary log file.
+ * Instead of formatting messages, the logger writes the format string
+ * only once, when it is used for the first time, and afterwards only its
+ * ID, the time stamp and the raw arguments. Component names are handled
+ * the same way. This saves most of the formatting time and disk space of
+ * the FileLogger. The files can be converted to text offline, for example
+ * with fflogview, cf. BinaryLogReader.
+ *
+ * Each logger instance starts a new session in the file, that is it
+ * appends a session record after which all format and component IDs are
+ * defined anew. All records are written in host byte order, a byte order
+ * marker is stored in the session record.
+ *
+ * Formats with conversions which cannot be stored as raw arguments, e.g.
+ * %n or wide strings, are formatted right away and stored as text.
+ *
+ * The file is written buffered, it is flushed on warnings and errors and
+ * otherwise at most after the flush interval (default one second).
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param filename name of the log file, appended to if it exists
+ * @param min_level minimum log level
+ */
+BinaryLogger::BinaryLogger(const char *filename, LogLevel min_level)
+  : Logger(min_level)
+{
+  int fd = open(filename, O_RDWR | O_CREAT | O_APPEND,
+		S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd == -1) {
+    throw Exception(errno, "Failed to open log file %s", filename);
+  }
+  log_file_ = fdopen(fd, "a");
+  setvbuf(log_file_, NULL, _IOFBF, 64 * 1024);
+
+  mutex_ = new Mutex();
+  next_format_id_ = next_component_id_ = 1;
+  flush_interval_usec_ = 1000000;
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  last_flush_usec_ = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+
+  binary_log_session_t session;
+  memcpy(session.magic, BINARY_LOG_MAGIC, sizeof(session.magic));
+  session.version    = BINARY_LOG_VERSION;
+  session.byte_order = BINARY_LOG_BYTE_ORDER;
+  session.start_usec = last_flush_usec_;
+
+  begin_record(BINARY_LOG_SESSION, 0, 0);
+  append(&session, sizeof(session));
+  end_record(LL_NONE, last_flush_usec_);
+}
+
+
+/** Destructor. */
+BinaryLogger::~BinaryLogger()
+{
+  fclose(log_file_);
+  delete mutex_;
+
+  std::map<std::string, Definition *>::iterator d;
+  for (d = formats_.begin(); d != formats_.end(); ++d)  delete d->second;
+  for (d = components_.begin(); d != components_.end(); ++d)  delete d->second;
+}
+
+
+/** Set flush interval.
+ * @param sec maximum time in seconds that debug and info messages stay in
+ * the write buffer, 0 to flush after every message
+ */
+void
+BinaryLogger::set_flush_interval(float sec)
+{
+  MutexLocker lock(mutex_);
+  flush_interval_usec_ = (int64_t)(sec * 1000000.);
+}
+
+
+/** Flush buffered messages to the file. */
+void
+BinaryLogger::flush()
+{
+  MutexLocker lock(mutex_);
+  fflush(log_file_);
+}
+
+
+/** Scan printf conversion specification.
+ * @param spec pointer to the percent sign starting the conversion
+ * @param type upon return the type of the argument, BINARY_LOG_ARG_NONE
+ * for %%, BINARY_LOG_ARG_UNSUPPORTED if the conversion cannot be stored
+ * @param num_stars upon return the number of int arguments for field width
+ * and precision given as asterisk, which precede the argument itself
+ * @return pointer to the first character after the conversion
+ */
+const char *
+BinaryLogger::scan_conversion(const char *spec, binary_log_arg_type_t &type,
+			      unsigned int &num_stars)
+{
+  const char *p = spec + 1;
+  num_stars = 0;
+  type = BINARY_LOG_ARG_UNSUPPORTED;
+
+  if (*p == '%') {
+    type = BINARY_LOG_ARG_NONE;
+    return p + 1;
+  }
+
+  while (*p && strchr("-+ #0'I", *p))  ++p;
+  if (*p == '*') {
+    ++num_stars;
+    ++p;
+  } else {
+    while (isdigit(*p))  ++p;
+    // positional arguments are not supported
+    if (*p == '$')  return p + 1;
+  }
+  if (*p == '.') {
+    ++p;
+    if (*p == '*') {
+      ++num_stars;
+      ++p;
+    } else {
+      while (isdigit(*p))  ++p;
+    }
+  }
+
+  enum { LEN_NONE, LEN_LONG, LEN_LLONG, LEN_LDOUBLE,
+	 LEN_INTMAX, LEN_SIZE, LEN_PTRDIFF } length = LEN_NONE;
+  switch (*p) {
+  case 'h': ++p; if (*p == 'h') ++p; break;
+  case 'l': ++p; if (*p == 'l') { ++p; length = LEN_LLONG; } else length = LEN_LONG; break;
+  case 'q': ++p; length = LEN_LLONG;   break;
+  case 'L': ++p; length = LEN_LDOUBLE; break;
+  case 'j': ++p; length = LEN_INTMAX;  break;
+  case 'z':
+  case 'Z': ++p; length = LEN_SIZE;    break;
+  case 't': ++p; length = LEN_PTRDIFF; break;
+  default: break;
+  }
+
+  char c = *p;
+  if (c == 0)  return p;
+  ++p;
+
+  switch (c) {
+  case 'd':
+  case 'i':
+    switch (length) {
+    case LEN_LONG:     type = BINARY_LOG_ARG_LONG;    break;
+    case LEN_LLONG:
+    case LEN_LDOUBLE:  type = BINARY_LOG_ARG_LLONG;   break;
+    case LEN_INTMAX:   type = BINARY_LOG_ARG_INTMAX;  break;
+    case LEN_SIZE:     type = BINARY_LOG_ARG_SIZE;    break;
+    case LEN_PTRDIFF:  type = BINARY_LOG_ARG_PTRDIFF; break;
+    default:           type = BINARY_LOG_ARG_INT;     break;
+    }
+    break;
+
+  case 'o':
+  case 'u':
+  case 'x':
+  case 'X':
+    switch (length) {
+    case LEN_LONG:     type = BINARY_LOG_ARG_ULONG;   break;
+    case LEN_LLONG:
+    case LEN_LDOUBLE:  type = BINARY_LOG_ARG_ULLONG;  break;
+    case LEN_INTMAX:   type = BINARY_LOG_ARG_UINTMAX; break;
+    case LEN_SIZE:     type = BINARY_LOG_ARG_SIZE;    break;
+    case LEN_PTRDIFF:  type = BINARY_LOG_ARG_PTRDIFF; break;
+    default:           type = BINARY_LOG_ARG_UINT;    break;
+    }
+    break;
+
+  case 'e': case 'E': case 'f': case 'F':
+  case 'g': case 'G': case 'a': case 'A':
+    type = (length == LEN_LDOUBLE) ? BINARY_LOG_ARG_LDOUBLE : BINARY_LOG_ARG_DOUBLE;
+    break;
+
+  case 'c':
+    if (length != LEN_LONG)  type = BINARY_LOG_ARG_INT;
+    break;
+
+  case 's':
+    if (length != LEN_LONG)  type = BINARY_LOG_ARG_STRING;
+    break;
+
+  case 'p': type = BINARY_LOG_ARG_POINTER; break;
+  case 'm': type = BINARY_LOG_ARG_ERRNO;   break;
+
+  default: break;
+  }
+
+  return p;
+}
+
+
+/** Get definition of a format or component.
+ * The definition is looked up by pointer first, format strings are
+ * usually literals. If the pointer is not known or the string at that
+ * address has changed, it is looked up by content and written to the file
+ * if it is new. Must be called with the mutex locked.
+ * @param s format or component string
+ * @param type BINARY_LOG_FORMAT or BINARY_LOG_COMPONENT
+ * @param parse true to parse the argument types of the format
+ * @return definition, NULL if too many definitions exist already
+ */
+BinaryLogger::Definition *
+BinaryLogger::definition(const char *s, uint8_t type, bool parse)
+{
+  std::unordered_map<const char *, Definition *> &by_ptr =
+    (type == BINARY_LOG_FORMAT) ? formats_by_ptr_ : components_by_ptr_;
+  std::map<std::string, Definition *> &by_text =
+    (type == BINARY_LOG_FORMAT) ? formats_ : components_;
+
+  std::unordered_map<const char *, Definition *>::iterator p = by_ptr.find(s);
+  if (likely(p != by_ptr.end()) && (p->second->text == s))  return p->second;
+
+  Definition *d;
+  std::map<std::string, Definition *>::iterator t = by_text.find(s);
+  if (t != by_text.end()) {
+    d = t->second;
+  } else {
+    if (by_text.size() >= MAX_DEFINITIONS)  return NULL;
+
+    d = new Definition();
+    d->text = s;
+    d->supported = true;
+    d->id = (type == BINARY_LOG_FORMAT) ? next_format_id_++ : next_component_id_++;
+    if (parse) {
+      for (const char *f = strchr(s, '%'); f != NULL; f = strchr(f, '%')) {
+	binary_log_arg_type_t arg_type;
+	unsigned int num_stars;
+	f = scan_conversion(f, arg_type, num_stars);
+	if (arg_type == BINARY_LOG_ARG_UNSUPPORTED) {
+	  d->supported = false;
+	  break;
+	}
+	if (arg_type == BINARY_LOG_ARG_NONE)  continue;
+	d->args.insert(d->args.end(), num_stars, BINARY_LOG_ARG_INT);
+	d->args.push_back(arg_type);
+      }
+      if (d->args.size() > 0xFFFF)  d->supported = false;
+    }
+    by_text[d->text] = d;
+
+    binary_log_definition_t def;
+    def.id = d->id;
+    begin_record(type, 0, d->supported ? d->args.size() : 0);
+    append(&def, sizeof(def));
+    if (d->supported && ! d->args.empty())  append(&d->args[0], d->args.size());
+    append(d->text.c_str(), d->text.length() + 1);
+    end_record(LL_NONE, 0);
+  }
+
+  if (by_ptr.size() >= MAX_DEFINITIONS)  by_ptr.clear();
+  by_ptr[s] = d;
+  return d;
+}
+
+
+/** Start a new record in the record buffer.
+ * @param type record type
+ * @param level log level
+ * @param num number of arguments or messages
+ */
+void
+BinaryLogger::begin_record(uint8_t type, uint8_t level, uint16_t num)
+{
+  record_.resize(sizeof(binary_log_record_header_t));
+  binary_log_record_header_t *h = (binary_log_record_header_t *)&record_[0];
+  h->size  = 0;
+  h->type  = type;
+  h->level = level;
+  h->num   = num;
+}
+
+
+/** Append data to the current record.
+ * @param data data to append
+ * @param size number of bytes to append
+ */
+void
+BinaryLogger::append(const void *data, size_t size)
+{
+  const char *d = (const char *)data;
+  record_.insert(record_.end(), d, d + size);
+}
+
+
+/** Write the current record.
+ * @param level log level of the record, LL_NONE for definitions which are
+ * never flushed on their own
+ * @param time_usec time of the record
+ */
+void
+BinaryLogger::end_record(LogLevel level, int64_t time_usec)
+{
+  record_.resize((record_.size() + 3) & ~(size_t)3, 0);
+  ((binary_log_record_header_t *)&record_[0])->size = record_.size();
+  fwrite(&record_[0], record_.size(), 1, log_file_);
+
+  if ( (level != LL_NONE) &&
+       ((level >= LL_WARN) || (time_usec - last_flush_usec_ >= flush_interval_usec_)) )
+  {
+    fflush(log_file_);
+    last_flush_usec_ = time_usec;
+  }
+}
+
+
+void
+BinaryLogger::write_log(LogLevel level, struct timeval *t, const char *component,
+			const char *format, va_list va)
+{
+  if (level < log_level)  return;
+  int saved_errno = errno;
+
+  struct timeval now;
+  if (t == NULL) {
+    gettimeofday(&now, NULL);
+    t = &now;
+  }
+  binary_log_entry_t entry;
+  entry.time_usec = (int64_t)t->tv_sec * 1000000 + t->tv_usec;
+
+  MutexLocker lock(mutex_);
+
+  Definition *c = definition(component ? component : "", BINARY_LOG_COMPONENT, false);
+  Definition *f = definition(format, BINARY_LOG_FORMAT, true);
+  entry.component_id = c ? c->id : 0;
+
+  if (! f || ! f->supported || ! c) {
+    char buf[1024];
+    va_list vac;
+    va_copy(vac, va);
+    int n = vsnprintf(buf, sizeof(buf), format, vac);
+    va_end(vac);
+    std::string text;
+    if (! c)  text = std::string(component ? component : "") + ": ";
+    if (n >= (int)sizeof(buf)) {
+      std::vector<char> lbuf(n + 1);
+      vsnprintf(&lbuf[0], n + 1, format, va);
+      text.append(&lbuf[0], n);
+    } else if (n > 0) {
+      text.append(buf, n);
+    }
+
+    entry.format_id = 0;
+    begin_record(BINARY_LOG_TEXT, level, 1);
+    append(&entry, sizeof(entry));
+    append(text.c_str(), text.length() + 1);
+    end_record(level, entry.time_usec);
+    return;
+  }
+
+  entry.format_id = f->id;
+  begin_record(BINARY_LOG_MESSAGE, level, f->args.size());
+  append(&entry, sizeof(entry));
+
+  for (size_t i = 0; i < f->args.size(); ++i) {
+    union {
+      int64_t   i;
+      uint64_t  u;
+      double    d;
+    } v;
+    const char *s = NULL;
+
+    switch (f->args[i]) {
+    case BINARY_LOG_ARG_INT:     v.i = va_arg(va, int);                   break;
+    case BINARY_LOG_ARG_UINT:    v.u = va_arg(va, unsigned int);          break;
+    case BINARY_LOG_ARG_LONG:    v.i = va_arg(va, long);                  break;
+    case BINARY_LOG_ARG_ULONG:   v.u = va_arg(va, unsigned long);         break;
+    case BINARY_LOG_ARG_LLONG:   v.i = va_arg(va, long long);             break;
+    case BINARY_LOG_ARG_ULLONG:  v.u = va_arg(va, unsigned long long);    break;
+    case BINARY_LOG_ARG_SIZE:    v.u = va_arg(va, size_t);                break;
+    case BINARY_LOG_ARG_INTMAX:  v.i = va_arg(va, intmax_t);              break;
+    case BINARY_LOG_ARG_UINTMAX: v.u = va_arg(va, uintmax_t);             break;
+    case BINARY_LOG_ARG_PTRDIFF: v.i = va_arg(va, ptrdiff_t);             break;
+    case BINARY_LOG_ARG_DOUBLE:  v.d = va_arg(va, double);                break;
+    case BINARY_LOG_ARG_LDOUBLE: v.d = (double)va_arg(va, long double);   break;
+    case BINARY_LOG_ARG_POINTER: v.u = (uintptr_t)va_arg(va, void *);     break;
+    case BINARY_LOG_ARG_STRING:
+      s = va_arg(va, const char *);
+      if (s == NULL)  s = "(null)";
+      break;
+    case BINARY_LOG_ARG_ERRNO:
+      s = strerror(saved_errno);
+      break;
+    default:
+      v.u = 0;
+      break;
+    }
+
+    if (s) {
+      uint32_t len = strlen(s);
+      append(&len, sizeof(len));
+      append(s, len);
+      record_.resize((record_.size() + 3) & ~(size_t)3, 0);
+    } else {
+      append(&v, sizeof(v));
+    }
+  }
+
+  end_record(level, entry.time_usec);
+}
+
+
+void
+BinaryLogger::write_log(LogLevel level, struct timeval *t, const char *component,
+			Exception &e)
+{
+  if (level < log_level)  return;
+
+  struct timeval now;
+  if (t == NULL) {
+    gettimeofday(&now, NULL);
+    t = &now;
+  }
+  binary_log_entry_t entry;
+  entry.time_usec = (int64_t)t->tv_sec * 1000000 + t->tv_usec;
+  entry.format_id = 0;
+
+  MutexLocker lock(mutex_);
+
+  Definition *c = definition(component ? component : "", BINARY_LOG_COMPONENT, false);
+  entry.component_id = c ? c->id : 0;
+
+  uint16_t num = 0;
+  for (Exception::iterator i = e.begin(); (i != e.end()) && (num < 0xFFFF); ++i)  ++num;
+
+  begin_record(BINARY_LOG_EXCEPTION, level, num);
+  append(&entry, sizeof(entry));
+  Exception::iterator i = e.begin();
+  for (uint16_t k = 0; k < num; ++k, ++i) {
+    append(*i, strlen(*i) + 1);
+  }
+  end_record(level, entry.time_usec);
+}
+
+
+void
+BinaryLogger::log_debug(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_DEBUG, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::log_info(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_INFO, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::log_warn(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_WARN, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::log_error(const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_ERROR, NULL, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::vlog_debug(const char *component, const char *format, va_list va)
+{
+  write_log(LL_DEBUG, NULL, component, format, va);
+}
+
+
+void
+BinaryLogger::vlog_info(const char *component, const char *format, va_list va)
+{
+  write_log(LL_INFO, NULL, component, format, va);
+}
+
+
+void
+BinaryLogger::vlog_warn(const char *component, const char *format, va_list va)
+{
+  write_log(LL_WARN, NULL, component, format, va);
+}
+
+
+void
+BinaryLogger::vlog_error(const char *component, const char *format, va_list va)
+{
+  write_log(LL_ERROR, NULL, component, format, va);
+}
+
+
+void
+BinaryLogger::log_debug(const char *component, Exception &e)
+{
+  write_log(LL_DEBUG, NULL, component, e);
+}
+
+
+void
+BinaryLogger::log_info(const char *component, Exception &e)
+{
+  write_log(LL_INFO, NULL, component, e);
+}
+
+
+void
+BinaryLogger::log_warn(const char *component, Exception &e)
+{
+  write_log(LL_WARN, NULL, component, e);
+}
+
+
+void
+BinaryLogger::log_error(const char *component, Exception &e)
+{
+  write_log(LL_ERROR, NULL, component, e);
+}
+
+
+void
+BinaryLogger::tlog_debug(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_DEBUG, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::tlog_info(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_INFO, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::tlog_warn(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_WARN, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::tlog_error(struct timeval *t, const char *component, const char *format, ...)
+{
+  va_list va;
+  va_start(va, format);
+  write_log(LL_ERROR, t, component, format, va);
+  va_end(va);
+}
+
+
+void
+BinaryLogger::tlog_debug(struct timeval *t, const char *component, Exception &e)
+{
+  write_log(LL_DEBUG, t, component, e);
+}
+
+
+void
+BinaryLogger::tlog_info(struct timeval *t, const char *component, Exception &e)
+{
+  write_log(LL_INFO, t, component, e);
+}
+
+
+void
+BinaryLogger::tlog_warn(struct timeval *t, const char *component, Exception &e)
+{
+  write_log(LL_WARN, t, component, e);
+}
+
+
+void
+BinaryLogger::tlog_error(struct timeval *t, const char *component, Exception &e)
+{
+  write_log(LL_ERROR, t, component, e);
+}
+
+
+void
+BinaryLogger::vtlog_debug(struct timeval *t, const char *component,
+			  const char *format, va_list va)
+{
+  write_log(LL_DEBUG, t, component, format, va);
+}
+
+
+void
+BinaryLogger::vtlog_info(struct timeval *t, const char *component,
+			 const char *format, va_list va)
+{
+  write_log(LL_INFO, t, component, format, va);
+}
+
+
+void
+BinaryLogger::vtlog_warn(struct timeval *t, const char *component,
+			 const char *format, va_list va)
+{
+  write_log(LL_WARN, t, component, format, va);
+}
+
+
+void
+BinaryLogger::vtlog_error(struct timeval *t, const char *component,
+			  const char *format, va_list va)
+{
+  write_log(LL_ERROR, t, component, format, va);
+}
+
+
+} // end namespace fawkes
@@ -0,0 +1,203 @@
+
+/***************************************************************************
+ *  binary.h - Fawkes binary structured logger
+ *
+ *  Created: Sun Oct 18 10:42:17 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _UTILS_LOGGING_BINARY_H_
+#define _UTILS_LOGGING_BINARY_H_
+
+#include <logging/logger.h>
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+namespace fawkes {
+
+class Mutex;
+
+/** Magic string at the beginning of each binary log session. */
+#define BINARY_LOG_MAGIC "FFBINLOG"
+/** Binary log format version. */
+#define BINARY_LOG_VERSION 1
+/** Byte order marker, written in host byte order. */
+#define BINARY_LOG_BYTE_ORDER 0x01020304
+
+/** Binary log record types. */
+typedef enum {
+  BINARY_LOG_SESSION   = 0,	/**< session start, binary_log_session_t follows */
+  BINARY_LOG_FORMAT    = 1,	/**< format string definition */
+  BINARY_LOG_COMPONENT = 2,	/**< component name definition */
+  BINARY_LOG_MESSAGE   = 3,	/**< message given as format ID and arguments */
+  BINARY_LOG_TEXT      = 4,	/**< pre-formatted message text */
+  BINARY_LOG_EXCEPTION = 5	/**< exception with its messages */
+} binary_log_record_type_t;
+
+/** Argument types of format strings.
+ * These are the types as passed through the variable argument list. */
+typedef enum {
+  BINARY_LOG_ARG_NONE        = 0,	/**< no argument (%%) */
+  BINARY_LOG_ARG_INT         = 1,	/**< int, also char and short */
+  BINARY_LOG_ARG_UINT        = 2,	/**< unsigned int */
+  BINARY_LOG_ARG_LONG        = 3,	/**< long */
+  BINARY_LOG_ARG_ULONG       = 4,	/**< unsigned long */
+  BINARY_LOG_ARG_LLONG       = 5,	/**< long long */
+  BINARY_LOG_ARG_ULLONG      = 6,	/**< unsigned long long */
+  BINARY_LOG_ARG_SIZE        = 7,	/**< size_t */
+  BINARY_LOG_ARG_INTMAX      = 8,	/**< intmax_t */
+  BINARY_LOG_ARG_UINTMAX     = 9,	/**< uintmax_t */
+  BINARY_LOG_ARG_PTRDIFF     = 10,	/**< ptrdiff_t */
+  BINARY_LOG_ARG_DOUBLE      = 11,	/**< double, also float */
+  BINARY_LOG_ARG_LDOUBLE     = 12,	/**< long double, stored as double */
+  BINARY_LOG_ARG_STRING      = 13,	/**< string */
+  BINARY_LOG_ARG_POINTER     = 14,	/**< pointer */
+  BINARY_LOG_ARG_ERRNO       = 15,	/**< %m, error string stored as string */
+  BINARY_LOG_ARG_UNSUPPORTED = 255	/**< conversion not supported */
+} binary_log_arg_type_t;
+
+#pragma pack(push,4)
+
+/** Binary log record header.
+ * All records are padded to a multiple of four bytes. */
+typedef struct {
+  uint32_t  size;	/**< size of record in bytes including this header */
+  uint8_t   type;	/**< record type, cf. binary_log_record_type_t */
+  uint8_t   level;	/**< log level for log records, 0 otherwise */
+  uint16_t  num;	/**< number of arguments or exception messages */
+} binary_log_record_header_t;
+
+/** Session record, starts each logging session in a file. */
+typedef struct {
+  char      magic[8];		/**< BINARY_LOG_MAGIC, not null-terminated */
+  uint32_t  version;		/**< BINARY_LOG_VERSION */
+  uint32_t  byte_order;		/**< BINARY_LOG_BYTE_ORDER */
+  int64_t   start_usec;		/**< session start time in usec since the epoch */
+} binary_log_session_t;
+
+/** Format and component definition.
+ * For formats, followed by the argument types (one byte each) and the
+ * null-terminated string. Components only have the string. */
+typedef struct {
+  uint32_t  id;		/**< ID of the format or component */
+} binary_log_definition_t;
+
+/** Log record.
+ * For messages the encoded arguments follow, integers, doubles and
+ * pointers as eight bytes, strings as uint32_t length and characters,
+ * padded to four bytes. Text and exception records are followed by
+ * null-terminated strings. */
+typedef struct {
+  uint32_t  component_id;	/**< component ID */
+  uint32_t  format_id;		/**< format ID, only used for messages */
+  int64_t   time_usec;		/**< time in usec since the epoch */
+} binary_log_entry_t;
+
+#pragma pack(pop)
+
+
+class BinaryLogger : public Logger
+{
+ public:
+  BinaryLogger(const char *filename, LogLevel min_level = LL_DEBUG);
+  virtual ~BinaryLogger();
+
+  void set_flush_interval(float sec);
+  void flush();
+
+  static const char * scan_conversion(const char *spec, binary_log_arg_type_t &type,
+				      unsigned int &num_stars);
+
+  virtual void log_debug(const char *component, const char *format, ...);
+  virtual void log_info(const char *component, const char *format, ...);
+  virtual void log_warn(const char *component, const char *format, ...);
+  virtual void log_error(const char *component, const char *format, ...);
+
+  virtual void vlog_debug(const char *component, const char *format, va_list va);
+  virtual void vlog_info(const char *component, const char *format, va_list va);
+  virtual void vlog_warn(const char *component, const char *format, va_list va);
+  virtual void vlog_error(const char *component, const char *format, va_list va);
+
+  virtual void log_debug(const char *component, Exception &e);
+  virtual void log_info(const char *component, Exception &e);
+  virtual void log_warn(const char *component, Exception &e);
+  virtual void log_error(const char *component, Exception &e);
+
+  virtual void tlog_debug(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_info(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_warn(struct timeval *t, const char *component, const char *format, ...);
+  virtual void tlog_error(struct timeval *t, const char *component, const char *format, ...);
+
+  virtual void tlog_debug(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_info(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_warn(struct timeval *t, const char *component, Exception &e);
+  virtual void tlog_error(struct timeval *t, const char *component, Exception &e);
+
+  virtual void vtlog_debug(struct timeval *t, const char *component,
+			   const char *format, va_list va);
+  virtual void vtlog_info(struct timeval *t, const char *component,
+			  const char *format, va_list va);
+  virtual void vtlog_warn(struct timeval *t, const char *component,
+			  const char *format, va_list va);
+  virtual void vtlog_error(struct timeval *t, const char *component,
+			   const char *format, va_list va);
+
+ private:
+  /// @cond INTERNALS
+  typedef struct {
+    uint32_t            id;
+    std::string         text;
+    std::vector<uint8_t> args;
+    bool                supported;
+  } Definition;
+  /// @endcond
+
+  Definition * definition(const char *s, uint8_t type, bool parse);
+  void         write_log(LogLevel level, struct timeval *t, const char *component,
+			 const char *format, va_list va);
+  void         write_log(LogLevel level, struct timeval *t, const char *component,
+			 Exception &e);
+  void         begin_record(uint8_t type, uint8_t level, uint16_t num);
+  void         append(const void *data, size_t size);
+  void         end_record(LogLevel level, int64_t time_usec);
+
+ private:
+  FILE     *log_file_;
+  Mutex    *mutex_;
+  int64_t   flush_interval_usec_;
+  int64_t   last_flush_usec_;
+
+  std::vector<char> record_;
+
+  std::unordered_map<const char *, Definition *>  formats_by_ptr_;
+  std::map<std::string, Definition *>             formats_;
+  std::unordered_map<const char *, Definition *>  components_by_ptr_;
+  std::map<std::string, Definition *>             components_;
+  uint32_t  next_format_id_;
+  uint32_t  next_component_id_;
+};
+
+
+} // end namespace fawkes
+
+#endif
@@ -0,0 +1,417 @@
+
+/***************************************************************************
+ *  binary_reader.cpp - Fawkes binary log reader
+ *
+ *  Created: Sun Oct 18 14:05:36 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <logging/binary_reader.h>
+#include <logging/binary.h>
+#include <core/exception.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+namespace fawkes {
+
+/// @cond INTERNALS
+template <typename T>
+static void
+append_formatted(std::string &out, const char *spec,
+		 unsigned int num_stars, const int *stars, T value)
+{
+  char buf[128];
+  int n;
+  switch (num_stars) {
+  case 0:  n = snprintf(buf, sizeof(buf), spec, value); break;
+  case 1:  n = snprintf(buf, sizeof(buf), spec, stars[0], value); break;
+  default: n = snprintf(buf, sizeof(buf), spec, stars[0], stars[1], value); break;
+  }
+  if (n < 0)  return;
+  if (n < (int)sizeof(buf)) {
+    out.append(buf, n);
+  } else {
+    std::vector<char> lbuf(n + 1);
+    switch (num_stars) {
+    case 0:  snprintf(&lbuf[0], n + 1, spec, value); break;
+    case 1:  snprintf(&lbuf[0], n + 1, spec, stars[0], value); break;
+    default: snprintf(&lbuf[0], n + 1, spec, stars[0], stars[1], value); break;
+    }
+    out.append(&lbuf[0], n);
+  }
+}
+/// @endcond
+
+
+/** @class BinaryLogReader <logging/binary_reader.h>
+ * Reader for binary log files.
+ * Reads files written by the BinaryLogger and formats the entries. The
+ * file is memory-mapped, entries are decoded one by one with next(). To
+ * follow a file which is still being written call update() and then read
+ * further entries.
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param filename name of the binary log file
+ * @exception Exception thrown if the file cannot be opened or is not a
+ * binary log file
+ */
+BinaryLogReader::BinaryLogReader(const char *filename)
+  : filename_(filename)
+{
+  data_ = NULL;
+  size_ = offset_ = 0;
+  have_session_ = false;
+
+  fd_ = open(filename, O_RDONLY);
+  if (fd_ == -1) {
+    throw Exception(errno, "Failed to open binary log %s", filename);
+  }
+  try {
+    map();
+  } catch (Exception &e) {
+    close(fd_);
+    throw;
+  }
+}
+
+
+/** Destructor. */
+BinaryLogReader::~BinaryLogReader()
+{
+  unmap();
+  close(fd_);
+}
+
+
+void
+BinaryLogReader::map()
+{
+  struct stat s;
+  if (fstat(fd_, &s) == -1) {
+    throw Exception(errno, "Failed to stat binary log %s", filename_.c_str());
+  }
+  size_ = s.st_size;
+  if (size_ == 0)  return;
+
+  void *d = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (d == MAP_FAILED) {
+    size_ = 0;
+    throw Exception(errno, "Failed to map binary log %s", filename_.c_str());
+  }
+  data_ = (const char *)d;
+}
+
+
+void
+BinaryLogReader::unmap()
+{
+  if (data_)  munmap((void *)data_, size_);
+  data_ = NULL;
+  size_ = 0;
+}
+
+
+/** Update mapping to the current file size.
+ * If the file has been truncated, reading starts again at the beginning.
+ * @return true if the file has grown, false otherwise
+ */
+bool
+BinaryLogReader::update()
+{
+  struct stat s;
+  if (fstat(fd_, &s) == -1) {
+    throw Exception(errno, "Failed to stat binary log %s", filename_.c_str());
+  }
+  if ((size_t)s.st_size == size_)  return false;
+
+  bool grown = ((size_t)s.st_size > size_);
+  unmap();
+  map();
+  if (size_ < offset_) {
+    offset_ = 0;
+    have_session_ = false;
+  }
+  return grown;
+}
+
+
+/** Get current read offset.
+ * @return offset in bytes of the next record to read
+ */
+size_t
+BinaryLogReader::offset() const
+{
+  return offset_;
+}
+
+
+/** Get size of mapped file.
+ * @return size in bytes of the file at the last update
+ */
+size_t
+BinaryLogReader::size() const
+{
+  return size_;
+}
+
+
+/** Read next entry.
+ * Format and component definitions are processed on the way, entries below
+ * the given log level are skipped without formatting them.
+ * @param entry upon return the next entry
+ * @param min_level minimum log level of entries to return
+ * @return true if an entry was read, false if the end of the file has been
+ * reached or the last record has not been written completely
+ * @exception Exception thrown if the file is corrupt
+ */
+bool
+BinaryLogReader::next(Entry &entry, Logger::LogLevel min_level)
+{
+  while (offset_ + sizeof(binary_log_record_header_t) <= size_) {
+    const binary_log_record_header_t *h =
+      (const binary_log_record_header_t *)(data_ + offset_);
+    if ((h->size < sizeof(binary_log_record_header_t)) || (h->size & 3)) {
+      throw Exception("Corrupt record in binary log %s at offset %zu",
+		      filename_.c_str(), offset_);
+    }
+    if (! have_session_ && (h->type != BINARY_LOG_SESSION)) {
+      throw Exception("%s is not a binary log file", filename_.c_str());
+    }
+    if (offset_ + h->size > size_)  return false;
+
+    const char *p   = (const char *)(h + 1);
+    const char *end = data_ + offset_ + h->size;
+    size_t record_offset = offset_;
+    offset_ += h->size;
+
+    if (h->type == BINARY_LOG_SESSION) {
+      const binary_log_session_t *s = (const binary_log_session_t *)p;
+      if ( (p + sizeof(binary_log_session_t) > end) ||
+	   (memcmp(s->magic, BINARY_LOG_MAGIC, sizeof(s->magic)) != 0) )
+      {
+	throw Exception("%s is not a binary log file", filename_.c_str());
+      }
+      if (s->version != BINARY_LOG_VERSION) {
+	throw Exception("Binary log %s has unsupported version %u",
+			filename_.c_str(), s->version);
+      }
+      if (s->byte_order != BINARY_LOG_BYTE_ORDER) {
+	throw Exception("Binary log %s has been written with a different byte order",
+			filename_.c_str());
+      }
+      formats_.clear();
+      components_.clear();
+      have_session_ = true;
+      continue;
+    }
+
+    switch (h->type) {
+    case BINARY_LOG_FORMAT:
+    case BINARY_LOG_COMPONENT:
+      {
+	const binary_log_definition_t *d = (const binary_log_definition_t *)p;
+	if ((p + sizeof(binary_log_definition_t) > end) ||
+	    (p + sizeof(binary_log_definition_t) + h->num >= end))
+	{
+	  throw Exception("Corrupt definition in binary log %s at offset %zu",
+			  filename_.c_str(), record_offset);
+	}
+	p += sizeof(binary_log_definition_t);
+
+	// IDs are assigned in order starting at 1, a definition either
+	// repeats a known ID or defines the next one
+	size_t next_id =
+	  (h->type == BINARY_LOG_FORMAT) ? formats_.size() : components_.size();
+	if ((d->id == 0) || (d->id > std::max(next_id, (size_t)1))) {
+	  throw Exception("Corrupt definition ID %u in binary log %s at offset %zu",
+			  d->id, filename_.c_str(), record_offset);
+	}
+
+	if (h->type == BINARY_LOG_FORMAT) {
+	  if (formats_.size() <= d->id)  formats_.resize(d->id + 1);
+	  formats_[d->id].args.assign((const uint8_t *)p, (const uint8_t *)p + h->num);
+	  p += h->num;
+	  formats_[d->id].text.assign(p, strnlen(p, end - p));
+	} else {
+	  if (components_.size() <= d->id)  components_.resize(d->id + 1);
+	  components_[d->id].assign(p, strnlen(p, end - p));
+	}
+      }
+      break;
+
+    case BINARY_LOG_MESSAGE:
+    case BINARY_LOG_TEXT:
+    case BINARY_LOG_EXCEPTION:
+      {
+	if (h->level < min_level)  break;
+
+	const binary_log_entry_t *e = (const binary_log_entry_t *)p;
+	p += sizeof(binary_log_entry_t);
+	if (p > end) {
+	  throw Exception("Corrupt entry in binary log %s", filename_.c_str());
+	}
+
+	entry.level        = (Logger::LogLevel)h->level;
+	entry.time.tv_sec  = e->time_usec / 1000000;
+	entry.time.tv_usec = e->time_usec % 1000000;
+	entry.exception    = (h->type == BINARY_LOG_EXCEPTION);
+	if (e->component_id < components_.size()) {
+	  entry.component = components_[e->component_id];
+	} else {
+	  entry.component.clear();
+	}
+	entry.messages.clear();
+
+	if (h->type == BINARY_LOG_MESSAGE) {
+	  entry.messages.resize(1);
+	  if (e->format_id < formats_.size()) {
+	    if (! format(formats_[e->format_id], p, end, entry.messages[0])) {
+	      throw Exception("Argument types of message in binary log %s at offset %zu "
+			      "do not match its format", filename_.c_str(), record_offset);
+	    }
+	  } else {
+	    entry.messages[0] = "<unknown format>";
+	  }
+	} else {
+	  for (uint16_t i = 0; (i < h->num) && (p < end); ++i) {
+	    size_t len = strnlen(p, end - p);
+	    entry.messages.push_back(std::string(p, len));
+	    p += len + 1;
+	  }
+	}
+	return true;
+      }
+
+    default:
+      // unknown record types are skipped
+      break;
+    }
+  }
+
+  return false;
+}
+
+
+/** Format message.
+ * The conversions are taken from the format text. Each must match the
+ * argument type recorded for the format, otherwise the arguments would
+ * be passed to snprintf() with the wrong type.
+ * @param f format definition
+ * @param payload encoded arguments
+ * @param end end of the record
+ * @param out upon return the formatted message, possibly marked as
+ * truncated if the record ends early
+ * @return false if the argument types do not match the format text
+ */
+bool
+BinaryLogReader::format(const Format &f, const char *payload, const char *end,
+			std::string &out) const
+{
+  out.clear();
+  const char *t = f.text.c_str();
+  size_t arg = 0;
+
+  while (*t) {
+    const char *pct = strchr(t, '%');
+    if (pct == NULL) {
+      out.append(t);
+      break;
+    }
+    out.append(t, pct - t);
+
+    binary_log_arg_type_t type;
+    unsigned int num_stars;
+    t = BinaryLogger::scan_conversion(pct, type, num_stars);
+    if (type == BINARY_LOG_ARG_NONE) {
+      out.append(1, '%');
+      continue;
+    }
+    if (type == BINARY_LOG_ARG_UNSUPPORTED)  return false;
+
+    std::string spec(pct, t - pct);
+    int stars[2] = {0, 0};
+    for (unsigned int s = 0; s < num_stars; ++s) {
+      if ((arg >= f.args.size()) || (f.args[arg] != BINARY_LOG_ARG_INT))  return false;
+      if (payload + sizeof(int64_t) > end)  goto truncated;
+      int64_t v;
+      memcpy(&v, payload, sizeof(v));
+      payload += sizeof(v);
+      stars[s < 2 ? s : 1] = v;
+      ++arg;
+    }
+    if ((arg >= f.args.size()) || (f.args[arg] != type))  return false;
+
+    if ((type == BINARY_LOG_ARG_STRING) || (type == BINARY_LOG_ARG_ERRNO)) {
+      uint32_t len;
+      if (payload + sizeof(len) > end)  goto truncated;
+      memcpy(&len, payload, sizeof(len));
+      payload += sizeof(len);
+      if (payload + len > end)  goto truncated;
+      std::string s(payload, len);
+      payload += (len + 3) & ~(uint32_t)3;
+      if (type == BINARY_LOG_ARG_ERRNO)  spec[spec.length() - 1] = 's';
+      append_formatted(out, spec.c_str(), num_stars, stars, s.c_str());
+
+    } else {
+      union {
+	int64_t   i;
+	uint64_t  u;
+	double    d;
+      } v;
+      if (payload + sizeof(v) > end)  goto truncated;
+      memcpy(&v, payload, sizeof(v));
+      payload += sizeof(v);
+
+      const char *sp = spec.c_str();
+      switch (type) {
+      case BINARY_LOG_ARG_INT:     append_formatted(out, sp, num_stars, stars, (int)v.i); break;
+      case BINARY_LOG_ARG_UINT:    append_formatted(out, sp, num_stars, stars, (unsigned int)v.u); break;
+      case BINARY_LOG_ARG_LONG:    append_formatted(out, sp, num_stars, stars, (long)v.i); break;
+      case BINARY_LOG_ARG_ULONG:   append_formatted(out, sp, num_stars, stars, (unsigned long)v.u); break;
+      case BINARY_LOG_ARG_LLONG:   append_formatted(out, sp, num_stars, stars, (long long)v.i); break;
+      case BINARY_LOG_ARG_ULLONG:  append_formatted(out, sp, num_stars, stars, (unsigned long long)v.u); break;
+      case BINARY_LOG_ARG_SIZE:    append_formatted(out, sp, num_stars, stars, (size_t)v.u); break;
+      case BINARY_LOG_ARG_INTMAX:  append_formatted(out, sp, num_stars, stars, (intmax_t)v.i); break;
+      case BINARY_LOG_ARG_UINTMAX: append_formatted(out, sp, num_stars, stars, (uintmax_t)v.u); break;
+      case BINARY_LOG_ARG_PTRDIFF: append_formatted(out, sp, num_stars, stars, (ptrdiff_t)v.i); break;
+      case BINARY_LOG_ARG_DOUBLE:  append_formatted(out, sp, num_stars, stars, v.d); break;
+      case BINARY_LOG_ARG_LDOUBLE: append_formatted(out, sp, num_stars, stars, (long double)v.d); break;
+      case BINARY_LOG_ARG_POINTER: append_formatted(out, sp, num_stars, stars, (void *)(uintptr_t)v.u); break;
+      default: return false;
+      }
+    }
+    ++arg;
+  }
+  return (arg == f.args.size());
+
+ truncated:
+  out.append("<truncated>");
+  return true;
+}
+
+
+} // end namespace fawkes
@@ -0,0 +1,85 @@
+
+/***************************************************************************
+ *  binary_reader.h - Fawkes binary log reader
+ *
+ *  Created: Sun Oct 18 14:05:36 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _UTILS_LOGGING_BINARY_READER_H_
+#define _UTILS_LOGGING_BINARY_READER_H_
+
+#include <logging/logger.h>
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+namespace fawkes {
+
+class BinaryLogReader
+{
+ public:
+  /** Decoded log entry. */
+  typedef struct {
+    Logger::LogLevel          level;	/**< log level */
+    struct timeval            time;	/**< time of the entry */
+    std::string               component;	/**< component name */
+    std::vector<std::string>  messages;	/**< message, multiple for exceptions */
+    bool                      exception;	/**< true if logged as exception */
+  } Entry;
+
+  BinaryLogReader(const char *filename);
+  ~BinaryLogReader();
+
+  bool   next(Entry &entry, Logger::LogLevel min_level = Logger::LL_DEBUG);
+  bool   update();
+
+  size_t offset() const;
+  size_t size() const;
+
+ private:
+  /// @cond INTERNALS
+  typedef struct {
+    std::string           text;
+    std::vector<uint8_t>  args;
+  } Format;
+  /// @endcond
+
+  void  map();
+  void  unmap();
+  bool  format(const Format &f, const char *payload, const char *end,
+	       std::string &out) const;
+
+ private:
+  std::string  filename_;
+  int          fd_;
+  const char  *data_;
+  size_t       size_;
+  size_t       offset_;
+  bool         have_session_;
+
+  std::vector<Format>       formats_;
+  std::vector<std::string>  components_;
+};
+
+
+} // end namespace fawkes
+
+#endif
@@ -25,7 +25,9 @@
 #include <logging/console.h>
 #include <logging/file.h>
 #include <logging/syslog.h>
+#include <logging/binary.h>
 #include <logging/multi.h>
+#include <logging/async.h>
 
 #include <cstring>
 #include <cstdlib>
@@ -87,6 +89,7 @@ LoggerFactory::string_to_loglevel(const char *log_level)
  * - console, ConsoleLogger
  * - file, FileLogger
  * - syslog, SyslogLogger
+ * - binary, BinaryLogger, argument is the file name
  * NOT supported:
  * - NetworkLogger, needs a FawkesNetworkHub which cannot be passed by parameter
  * @param type logger type
@@ -118,6 +121,8 @@ LoggerFactory::instance(const char *type, const char *as)
     free(tmp);
   } else if ( strcmp(type, "syslog") == 0 ) {
     l = new SyslogLogger(as);
+  } else if ( strcmp(type, "binary") == 0 ) {
+    l = new BinaryLogger((as[0] != 0) ? as : "fawkes.blog");
   }
 
   if ( l == NULL )  throw UnknownLoggerTypeException();
@@ -134,6 +139,10 @@ LoggerFactory::instance(const char *type, const char *as)
  * So it is a list of logger type/argument tuples separated by columns concatenated
  * to one list with exclamation marks. The list is not pre-processed, so if you
  * mention a logger twice this logger is added twice.
+ * The type may be followed by modifiers separated by slashes, a log level
+ * and the keyword "async", e.g. "file/debug/async:fawkes.log". An async
+ * logger is wrapped in an AsyncLogger, output is then written by a
+ * background thread.
  * @param as logger argument string
  * @param default_ll default log level for multi logger
  * @return multi logger instance with requested loggers
@@ -148,7 +157,7 @@ LoggerFactory::multilogger_instance(const char *as, Logger::LogLevel default_ll)
   char *logger_string = strdup(as);
   char *str = logger_string;
   char *saveptr, *r;
-  const char *type, *args, *level;
+  const char *type, *args, *level, *modifier;
   char *typeargs_saveptr, *level_saveptr, *type_str;
   const char *logger_delim = ";";
   const char *logger_typeargs_delim = ":";
@@ -160,7 +169,15 @@ LoggerFactory::multilogger_instance(const char *as, Logger::LogLevel default_ll)
     type_str = strdup(type);
 
     type  = strtok_r(type_str, logger_level_delim, &level_saveptr);
-    level = strtok_r(NULL, logger_level_delim, &level_saveptr);
+    level = NULL;
+    bool async = false;
+    while ((modifier = strtok_r(NULL, logger_level_delim, &level_saveptr)) != NULL) {
+      if (strcmp(modifier, "async") == 0) {
+	async = true;
+      } else {
+	level = modifier;
+      }
+    }
 
     if ( type == NULL ) {
       throw UnknownLoggerTypeException();
@@ -171,6 +188,7 @@ LoggerFactory::multilogger_instance(const char *as, Logger::LogLevel default_ll)
 
     try {
       Logger *l = instance(type, args);
+      if (async)  l = new AsyncLogger(l);
       m->add_logger(l);
       if (level) {
 	Logger::LogLevel ll = string_to_loglevel(level);
@@ -23,6 +23,7 @@
 
 #include <logging/multi.h>
 #include <logging/logger.h>
+#include <logging/async.h>
 
 #include <core/utils/lock_list.h>
 #include <core/threading/thread.h>
@@ -114,6 +115,21 @@ MultiLogger::~MultiLogger()
 void
 MultiLogger::add_logger(Logger *logger)
 {
+  add_logger(logger, false);
+}
+
+
+/** Add a logger.
+ * @param logger new sub-logger to add
+ * @param async true to wrap the logger in an AsyncLogger, its output is
+ * then written by a background thread and logging through the multi logger
+ * no longer blocks on it
+ */
+void
+MultiLogger::add_logger(Logger *logger, bool async)
+{
+  if (async)  logger = new AsyncLogger(logger);
+
   data->mutex->lock();
   Thread::set_cancel_state(Thread::CANCEL_DISABLED, &(data->old_state));
   data->loggers.lock();
@@ -128,17 +144,37 @@ MultiLogger::add_logger(Logger *logger)
 
 
 /** Remove logger.
+ * If the logger has been added asynchronously, pending messages are
+ * written and its AsyncLogger wrapper is deleted.
  * @param logger Sub-logger to remove
  */
 void
 MultiLogger::remove_logger(Logger *logger)
 {
+  AsyncLogger *async = NULL;
+
   data->mutex->lock();
   Thread::set_cancel_state(Thread::CANCEL_DISABLED, &(data->old_state));
 
-  data->loggers.remove_locked(logger);
+  data->loggers.lock();
+  for (data->logit = data->loggers.begin(); data->logit != data->loggers.end(); ++data->logit) {
+    AsyncLogger *al = dynamic_cast<AsyncLogger *>(*data->logit);
+    if (al && (al->logger() == logger)) {
+      async = al;
+      data->loggers.erase(data->logit);
+      break;
+    }
+  }
+  data->loggers.remove(logger);
+  data->loggers.unlock();
+
   Thread::set_cancel_state(data->old_state);
   data->mutex->unlock();
+
+  if (async) {
+    async->release();
+    delete async;
+  }
 }
 
 
@@ -40,6 +40,7 @@ class MultiLoggerData;
   virtual ~MultiLogger();
 
   void add_logger(Logger *logger);
+  void add_logger(Logger *logger, bool async);
   void remove_logger(Logger *logger);
 
   virtual void set_loglevel(LogLevel level);
@@ -0,0 +1,249 @@
+/***************************************************************************
+ *  test_async.cpp - Asynchronous logger unit test
+ *
+ *  Created: Sat Oct 17 14:05:12 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <logging/async.h>
+#include <logging/cache.h>
+#include <logging/multi.h>
+#include <core/threading/mutex.h>
+#include <core/exceptions/software.h>
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace fawkes;
+
+/** Get current time.
+ * @return current time in seconds
+ */
+static double
+now_sec()
+{
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1e6;
+}
+
+/** @class TestLogger
+ * Cache logger which counts messages and can hold back the writer thread.
+ * The cache must only be read while no message is being written.
+ */
+class TestLogger : public CacheLogger
+{
+ public:
+  /** Constructor. */
+  TestLogger() : CacheLogger(100000) { num_written = num_warnings = 0; }
+
+  using CacheLogger::log_warn;
+  virtual void log_warn(const char *component, const char *format, ...)
+  {
+    va_list va;
+    va_start(va, format);
+    CacheLogger::vlog_warn(component, format, va);
+    va_end(va);
+    __atomic_add_fetch(&num_warnings, 1, __ATOMIC_RELEASE);
+  }
+
+  virtual void vtlog_info(struct timeval *t, const char *component,
+			  const char *format, va_list va)
+  {
+    gate.lock();
+    gate.unlock();
+    CacheLogger::vtlog_info(t, component, format, va);
+    __atomic_add_fetch(&num_written, 1, __ATOMIC_RELEASE);
+  }
+
+  /** Get number of info messages written.
+   * @return number of info messages written */
+  unsigned int written() { return __atomic_load_n(&num_written, __ATOMIC_ACQUIRE); }
+  /** Get number of warnings written.
+   * @return number of warnings written */
+  unsigned int warnings() { return __atomic_load_n(&num_warnings, __ATOMIC_ACQUIRE); }
+
+  /** Count messages.
+   * @param prefix message prefix
+   * @return number of messages with the given prefix
+   */
+  unsigned int count(const char *prefix)
+  {
+    unsigned int rv = 0;
+    std::list<CacheEntry> &msgs = get_messages();
+    for (std::list<CacheEntry>::iterator m = msgs.begin(); m != msgs.end(); ++m) {
+      if (m->message.compare(0, strlen(prefix), prefix) == 0)  ++rv;
+    }
+    return rv;
+  }
+
+  /** Lock to hold back writing info messages */
+  Mutex        gate;
+  /** Number of info messages written */
+  unsigned int num_written;
+  /** Number of warnings written */
+  unsigned int num_warnings;
+};
+
+/** Wait for messages to be written.
+ * @param l logger to wait for
+ * @param num number of messages to wait for
+ * @param timeout_sec maximum time to wait
+ * @return true if the messages have been written in time
+ */
+static bool
+wait_written(TestLogger *l, unsigned int num, double timeout_sec)
+{
+  double until = now_sec() + timeout_sec;
+  while (l->written() < num) {
+    if (now_sec() > until)  return false;
+    usleep(100);
+  }
+  return true;
+}
+
+/** Log a few messages and exit.
+ * @param arg logger to log to
+ * @return NULL
+ */
+static void *
+log_and_exit(void *arg)
+{
+  Logger *l = (Logger *)arg;
+  for (unsigned int i = 0; i < 5; ++i)  l->log_info("Test", "thread message %u", i);
+  return NULL;
+}
+
+
+TEST(AsyncLoggerTest, NullLogger)
+{
+  EXPECT_THROW(AsyncLogger al(NULL), NullPointerException);
+}
+
+TEST(AsyncLoggerTest, OrderAndWakeup)
+{
+  TestLogger *tl = new TestLogger();
+  AsyncLogger *al = new AsyncLogger(tl);
+
+  for (unsigned int i = 0; i < 10; ++i)  al->log_info("Test", "message %u", i);
+  al->flush();
+  EXPECT_EQ(10u, tl->written());
+  std::list<CacheLogger::CacheEntry> &msgs = tl->get_messages();
+  unsigned int i = 9;
+  for (std::list<CacheLogger::CacheEntry>::iterator m = msgs.begin(); m != msgs.end(); ++m, --i) {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "message %u", i);
+    EXPECT_EQ(expected, m->message);
+  }
+
+  // the idle writer must be woken up by the next message, not by a timeout
+  usleep(200000);
+  double start = now_sec();
+  al->log_info("Test", "wakeup");
+  EXPECT_TRUE(wait_written(tl, 11, 1.0));
+  EXPECT_LT(now_sec() - start, 0.050);
+
+  delete al;
+}
+
+TEST(AsyncLoggerTest, Overflow)
+{
+  TestLogger *tl = new TestLogger();
+  AsyncLogger *al = new AsyncLogger(tl, 1024);
+
+  // hold back the writer on the first message, then fill the ring
+  tl->gate.lock();
+  al->log_info("Test", "first");
+  usleep(50000);
+  const unsigned int num = 100;
+  for (unsigned int i = 0; i < num; ++i) {
+    al->log_info("Test", "overflow message %u with some text to fill the ring", i);
+  }
+  unsigned long dropped = al->dropped();
+  tl->gate.unlock();
+  al->flush();
+
+  EXPECT_GT(dropped, 0ul);
+  EXPECT_EQ(num, tl->count("overflow message") + dropped);
+  EXPECT_EQ(1 + num - dropped, tl->written());
+
+  // the drop report is written after the messages of the pass
+  double until = now_sec() + 1.0;
+  while (tl->warnings() == 0 && now_sec() < until)  usleep(1000);
+  char report[64];
+  snprintf(report, sizeof(report), "Dropped %lu log messages", dropped);
+  EXPECT_EQ(1u, tl->count(report));
+
+  delete al;
+}
+
+TEST(AsyncLoggerTest, OrphanedRings)
+{
+  TestLogger *tl = new TestLogger();
+  AsyncLogger *al = new AsyncLogger(tl);
+
+  al->log_info("Test", "main");
+  const unsigned int num_threads = 8;
+  pthread_t threads[num_threads];
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    pthread_create(&threads[i], NULL, log_and_exit, al);
+  }
+  for (unsigned int i = 0; i < num_threads; ++i)  pthread_join(threads[i], NULL);
+
+  EXPECT_TRUE(wait_written(tl, 1 + 5 * num_threads, 1.0));
+
+  // rings of exited threads are freed once drained, the main ring is kept
+  double until = now_sec() + 1.0;
+  while (al->num_rings() > 1 && now_sec() < until)  usleep(1000);
+  EXPECT_EQ(1u, al->num_rings());
+
+  delete al;
+}
+
+TEST(AsyncLoggerTest, MultiLoggerUnwrap)
+{
+  MultiLogger *ml = new MultiLogger();
+  TestLogger *tl = new TestLogger();
+  TestLogger *sl = new TestLogger();
+  ml->add_logger(tl, /* async */ true);
+  ml->add_logger(sl);
+
+  ml->log_info("Test", "before removal");
+  ml->remove_logger(tl);
+  EXPECT_EQ(1u, tl->written());
+
+  // the unwrapped logger is handed back, not deleted, and no longer used
+  ml->log_info("Test", "after removal");
+  EXPECT_EQ(1u, tl->written());
+  EXPECT_EQ(1u, tl->count("before removal"));
+  EXPECT_EQ(1u, sl->count("before removal"));
+  EXPECT_EQ(1u, sl->count("after removal"));
+
+  ml->remove_logger(sl);
+  delete sl;
+  delete tl;
+  delete ml;
+}
@@ -0,0 +1,361 @@
+/***************************************************************************
+ *  test_binary.cpp - Binary logger and reader unit test
+ *
+ *  Created: Sat Oct 17 15:31:48 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <logging/binary.h>
+#include <logging/binary_reader.h>
+#include <core/exception.h>
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace fawkes;
+
+/** Get name of a non-existing temporary file.
+ * @return temporary file name
+ */
+static std::string
+temp_file()
+{
+  char tmpl[] = "/tmp/test_binary_log_XXXXXX";
+  int fd = mkstemp(tmpl);
+  close(fd);
+  unlink(tmpl);
+  return tmpl;
+}
+
+/** Write data to file.
+ * @param filename file to write to
+ * @param data data to write
+ */
+static void
+write_file(const std::string &filename, const std::vector<char> &data)
+{
+  FILE *f = fopen(filename.c_str(), "w");
+  if (! data.empty())  fwrite(&data[0], data.size(), 1, f);
+  fclose(f);
+}
+
+/** Append record to buffer, padded to four bytes.
+ * @param buf buffer to append to
+ * @param type record type
+ * @param level log level
+ * @param num number of arguments
+ * @param payload record payload
+ * @param size size of payload
+ */
+static void
+add_record(std::vector<char> &buf, uint8_t type, uint8_t level, uint16_t num,
+	   const void *payload, size_t size)
+{
+  binary_log_record_header_t h;
+  h.size  = (sizeof(h) + size + 3) & ~(size_t)3;
+  h.type  = type;
+  h.level = level;
+  h.num   = num;
+  size_t start = buf.size();
+  buf.insert(buf.end(), (const char *)&h, (const char *)&h + sizeof(h));
+  buf.insert(buf.end(), (const char *)payload, (const char *)payload + size);
+  buf.resize(start + h.size, 0);
+}
+
+/** Append session record to buffer.
+ * @param buf buffer to append to
+ */
+static void
+add_session(std::vector<char> &buf)
+{
+  binary_log_session_t s;
+  memcpy(s.magic, BINARY_LOG_MAGIC, sizeof(s.magic));
+  s.version    = BINARY_LOG_VERSION;
+  s.byte_order = BINARY_LOG_BYTE_ORDER;
+  s.start_usec = 0;
+  add_record(buf, BINARY_LOG_SESSION, 0, 0, &s, sizeof(s));
+}
+
+/** Append component or format definition to buffer.
+ * @param buf buffer to append to
+ * @param type definition record type
+ * @param id definition ID
+ * @param args argument types
+ * @param text component name or format text
+ */
+static void
+add_definition(std::vector<char> &buf, uint8_t type, uint32_t id,
+	       const std::vector<uint8_t> &args, const char *text)
+{
+  std::vector<char> p((const char *)&id, (const char *)&id + sizeof(id));
+  p.insert(p.end(), args.begin(), args.end());
+  p.insert(p.end(), text, text + strlen(text) + 1);
+  add_record(buf, type, 0, args.size(), &p[0], p.size());
+}
+
+/** Append message with a single integer argument to buffer.
+ * @param buf buffer to append to
+ * @param format_id ID of format definition
+ * @param num_args number of arguments stated in the header
+ * @param arg argument value
+ */
+static void
+add_message(std::vector<char> &buf, uint32_t format_id, uint16_t num_args, int64_t arg)
+{
+  binary_log_entry_t e;
+  e.component_id = 1;
+  e.format_id    = format_id;
+  e.time_usec    = 1000000;
+  std::vector<char> p((const char *)&e, (const char *)&e + sizeof(e));
+  p.insert(p.end(), (const char *)&arg, (const char *)&arg + sizeof(arg));
+  add_record(buf, BINARY_LOG_MESSAGE, Logger::LL_INFO, num_args, &p[0], p.size());
+}
+
+/** Append pre-formatted text message to buffer.
+ * @param buf buffer to append to
+ * @param text message text
+ */
+static void
+add_text(std::vector<char> &buf, const char *text)
+{
+  binary_log_entry_t e;
+  e.component_id = 1;
+  e.format_id    = 0;
+  e.time_usec    = 2000000;
+  std::vector<char> p((const char *)&e, (const char *)&e + sizeof(e));
+  p.insert(p.end(), text, text + strlen(text) + 1);
+  add_record(buf, BINARY_LOG_TEXT, Logger::LL_INFO, 1, &p[0], p.size());
+}
+
+/** Read next entry and report whether reading threw.
+ * @param r reader to read from
+ * @param e entry to read into
+ * @return true if reading threw an exception, false otherwise
+ */
+static bool
+next_throws(BinaryLogReader &r, BinaryLogReader::Entry &e)
+{
+  try {
+    r.next(e);
+  } catch (Exception &ex) {
+    return true;
+  }
+  return false;
+}
+
+/** Log info message and remember the expected formatted text. */
+#define LOG_EXPECT(format, ...)						\
+  do {									\
+    errno = ENOENT;							\
+    bl->log_info("QA", format, __VA_ARGS__);				\
+    errno = ENOENT;							\
+    snprintf(buf, sizeof(buf), format, __VA_ARGS__);			\
+    expected.push_back(buf);						\
+  } while (0)
+
+
+/** @class BinaryLogCorruptTest
+ * Fixture providing a temporary file and a valid log prefix defining
+ * component 1 and the formats 1 ("value %d") and 2 ("value %s").
+ */
+class BinaryLogCorruptTest : public ::testing::Test
+{
+ protected:
+  virtual void SetUp()
+  {
+    filename = temp_file();
+    int_arg.assign(1, BINARY_LOG_ARG_INT);
+    add_session(good);
+    add_definition(good, BINARY_LOG_COMPONENT, 1, std::vector<uint8_t>(), "QA");
+    add_definition(good, BINARY_LOG_FORMAT, 1, int_arg, "value %d");
+    add_definition(good, BINARY_LOG_FORMAT, 2, int_arg, "value %s");
+    add_message(good, 1, 1, 42);
+    data = good;
+  }
+
+  virtual void TearDown()
+  {
+    unlink(filename.c_str());
+  }
+
+  /** Write data, read the valid message, and check the next record.
+   * @return true if reading the record after the valid prefix threw
+   */
+  bool next_after_good_throws()
+  {
+    write_file(filename, data);
+    BinaryLogReader reader(filename.c_str());
+    reader.next(entry);
+    return next_throws(reader, entry);
+  }
+
+  /** Get header of the first record after the valid prefix.
+   * @return record header
+   */
+  binary_log_record_header_t * appended_header()
+  {
+    return (binary_log_record_header_t *)&data[good.size()];
+  }
+
+  /** Temporary file name. */
+  std::string                 filename;
+  /** Argument types of a single integer argument. */
+  std::vector<uint8_t>        int_arg;
+  /** Valid log prefix. */
+  std::vector<char>           good;
+  /** Log data written to the file. */
+  std::vector<char>           data;
+  /** Entry to read into. */
+  BinaryLogReader::Entry      entry;
+};
+
+TEST(BinaryLogTest, RoundTrip)
+{
+  std::string filename = temp_file();
+  std::vector<std::string> expected;
+  char buf[1024];
+
+  BinaryLogger *bl = new BinaryLogger(filename.c_str());
+  LOG_EXPECT("int %d uint %u hex %x char %c", -5, 7u, 0xbeef, 'q');
+  LOG_EXPECT("long %ld ulong %lu llong %lld", -123456789012L, 123456789012UL, -5LL);
+  LOG_EXPECT("size %zu ptrdiff %td intmax %jd", (size_t)42, (ptrdiff_t)-3, (intmax_t)-9);
+  LOG_EXPECT("double %5.2f exp %e ldouble %Lf", 3.14159, 1e-10, (long double)2.5);
+  LOG_EXPECT("string |%-8s|%.3s|", "left", "truncated");
+  LOG_EXPECT("stars |%*d|%.*f|", 6, 42, 2, 1.23456);
+  LOG_EXPECT("errno %m percent %% pointer %p", (void *)0x1234);
+  // positional arguments are stored as pre-formatted text
+  LOG_EXPECT("positional %2$s %1$d", 1, "two");
+  bl->log_debug("QA", "debug message %d", 1);
+  Exception e("first message");
+  e.append("second message");
+  bl->log_error("QA", e);
+  delete bl;
+
+  BinaryLogReader reader(filename.c_str());
+  BinaryLogReader::Entry entry;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_TRUE(reader.next(entry, Logger::LL_INFO));
+    EXPECT_EQ("QA", entry.component);
+    EXPECT_EQ(Logger::LL_INFO, entry.level);
+    EXPECT_FALSE(entry.exception);
+    ASSERT_EQ(1u, entry.messages.size());
+    EXPECT_EQ(expected[i], entry.messages[0]);
+  }
+  // debug message is skipped
+  ASSERT_TRUE(reader.next(entry, Logger::LL_INFO));
+  EXPECT_TRUE(entry.exception);
+  EXPECT_EQ(Logger::LL_ERROR, entry.level);
+  ASSERT_EQ(2u, entry.messages.size());
+  EXPECT_EQ("first message", entry.messages[0]);
+  EXPECT_EQ("second message", entry.messages[1]);
+  EXPECT_FALSE(reader.next(entry));
+  EXPECT_EQ(reader.size(), reader.offset());
+
+  unlink(filename.c_str());
+}
+
+TEST_F(BinaryLogCorruptTest, MismatchingArgumentType)
+{
+  // the record is rejected and reading continues with the next one
+  add_message(data, 2, 1, 42);
+  add_text(data, "after");
+  write_file(filename, data);
+
+  BinaryLogReader reader(filename.c_str());
+  ASSERT_TRUE(reader.next(entry));
+  EXPECT_EQ("value 42", entry.messages[0]);
+  EXPECT_TRUE(next_throws(reader, entry));
+  ASSERT_TRUE(reader.next(entry));
+  EXPECT_EQ("after", entry.messages[0]);
+}
+
+TEST_F(BinaryLogCorruptTest, MissingArgument)
+{
+  add_message(data, 1, 0, 42);
+  data.resize(data.size() - sizeof(int64_t));
+  appended_header()->size -= sizeof(int64_t);
+  write_file(filename, data);
+
+  BinaryLogReader reader(filename.c_str());
+  reader.next(entry);
+  ASSERT_TRUE(reader.next(entry));
+  EXPECT_EQ("value <truncated>", entry.messages[0]);
+}
+
+TEST_F(BinaryLogCorruptTest, DefinitionOutOfSequence)
+{
+  add_definition(data, BINARY_LOG_FORMAT, 0x7fffffff, int_arg, "%d");
+  EXPECT_TRUE(next_after_good_throws());
+}
+
+TEST_F(BinaryLogCorruptTest, DefinitionIdZero)
+{
+  add_definition(data, BINARY_LOG_COMPONENT, 0, std::vector<uint8_t>(), "zero");
+  EXPECT_TRUE(next_after_good_throws());
+}
+
+TEST_F(BinaryLogCorruptTest, ShortDefinition)
+{
+  add_record(data, BINARY_LOG_FORMAT, 0, 0, NULL, 0);
+  EXPECT_TRUE(next_after_good_throws());
+}
+
+TEST_F(BinaryLogCorruptTest, TooManyDefinitionArguments)
+{
+  // argument types beyond the end of the definition
+  add_definition(data, BINARY_LOG_FORMAT, 3, int_arg, "%d");
+  appended_header()->num = 200;
+  EXPECT_TRUE(next_after_good_throws());
+}
+
+TEST_F(BinaryLogCorruptTest, InvalidRecordSize)
+{
+  add_text(data, "bad size");
+  appended_header()->size = 3;
+  EXPECT_TRUE(next_after_good_throws());
+}
+
+TEST_F(BinaryLogCorruptTest, IncompleteRecord)
+{
+  // incomplete last record is not read until complete
+  add_text(data, "incomplete");
+  data.resize(data.size() - 4);
+  EXPECT_FALSE(next_after_good_throws());
+
+  BinaryLogReader reader(filename.c_str());
+  reader.next(entry);
+  reader.next(entry);
+  EXPECT_EQ(good.size(), reader.offset());
+}
+
+TEST_F(BinaryLogCorruptTest, OtherFile)
+{
+  data.assign(64, 'x');
+  write_file(filename, data);
+  BinaryLogReader reader(filename.c_str());
+  EXPECT_TRUE(next_throws(reader, entry));
+}
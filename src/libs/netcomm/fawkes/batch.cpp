@@ -0,0 +1,255 @@
+
+/***************************************************************************
+ *  batch.cpp - Fawkes network message batch frames
+ *
+ *  Created: Fri Oct 16 19:02:13 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <netcomm/fawkes/batch.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
+#include <netcomm/fawkes/message.h>
+#include <netcomm/fawkes/message_queue.h>
+#include <core/exception.h>
+
+#include <netinet/in.h>
+#include <cstring>
+
+namespace fawkes {
+
+/// @cond INTERNALS
+static const char batch_padding[FAWKES_NETWORK_BATCH_ALIGN] = { 0 };
+
+static inline size_t
+batch_padding_size(size_t payload_size)
+{
+  return (FAWKES_NETWORK_BATCH_ALIGN - (payload_size % FAWKES_NETWORK_BATCH_ALIGN))
+    % FAWKES_NETWORK_BATCH_ALIGN;
+}
+/// @endcond
+
+
+/** @class FawkesNetworkMessageBatch <netcomm/fawkes/batch.h>
+ * Batch frame of Fawkes network messages.
+ * Many small messages can be sent as a single MSG_TRANSPORT_BATCH frame
+ * instead of a frame each. This saves the per-frame overhead on the
+ * receiving side, which reads a whole batch with two reads, and lets
+ * many messages share a single send.
+ *
+ * For sending, messages are appended to the content, which references
+ * their headers and payloads without copying them. Received frames are
+ * split with unpack(), the resulting messages reference the payload of
+ * the batch frame.
+ * @see transport.h for the frame format
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+FawkesNetworkMessageBatch::FawkesNetworkMessageBatch()
+{
+  size_ = 0;
+}
+
+
+/** Destructor.
+ * Releases all appended messages.
+ */
+FawkesNetworkMessageBatch::~FawkesNetworkMessageBatch()
+{
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    messages_[i]->unref();
+  }
+}
+
+
+/** Append message.
+ * This method takes ownership of the message. If you want to use the message
+ * after appending you must reference it explicitly.
+ * @param msg message to append, must not be a batch frame itself
+ */
+void
+FawkesNetworkMessageBatch::append(FawkesNetworkMessage *msg)
+{
+  size_ += frame_size(msg);
+  messages_.push_back(msg);
+}
+
+
+/** Get size of batch.
+ * @return size of the payload of the batch frame in bytes
+ */
+size_t
+FawkesNetworkMessageBatch::size() const
+{
+  return size_;
+}
+
+
+/** Get number of messages.
+ * @return number of messages in the batch
+ */
+unsigned int
+FawkesNetworkMessageBatch::num_messages() const
+{
+  return messages_.size();
+}
+
+
+void
+FawkesNetworkMessageBatch::serialize()
+{
+  std::vector<struct iovec> payload;
+
+  clear_segments();
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    FawkesNetworkMessage *m = messages_[i];
+    add_segment(&(m->fmsg().header), sizeof(fawkes_message_header_t));
+    payload.clear();
+    m->payload_segments(payload);
+    for (size_t p = 0; p < payload.size(); ++p) {
+      add_segment(payload[p].iov_base, payload[p].iov_len);
+    }
+    add_segment(batch_padding, batch_padding_size(m->payload_size()));
+  }
+}
+
+
+/** Get size of message in a batch frame.
+ * The message is packed if that has not been done before.
+ * @param msg message to get the size for
+ * @return number of bytes the message takes in a batch frame
+ */
+size_t
+FawkesNetworkMessageBatch::frame_size(FawkesNetworkMessage *msg)
+{
+  msg->pack();
+  size_t payload_size = msg->payload_size();
+  return sizeof(fawkes_message_header_t) + payload_size + batch_padding_size(payload_size);
+}
+
+
+/** Check if message is a batch frame.
+ * @param msg message to check
+ * @return true if the message is a MSG_TRANSPORT_BATCH frame
+ */
+bool
+FawkesNetworkMessageBatch::is_batch(const FawkesNetworkMessage *msg)
+{
+  return (msg->cid() == FAWKES_CID_TRANSPORT) && (msg->msgid() == MSG_TRANSPORT_BATCH);
+}
+
+
+/** Split batch frame into messages.
+ * The messages are pushed to the queue in the order of the batch. They
+ * reference the payload of the batch frame and keep it alive, the frame
+ * itself is not modified and must still be unref'd by the caller.
+ * @param batch received batch frame
+ * @param msgq queue to push the messages to
+ * @exception Exception thrown if the frame is malformed, in that case no
+ * message is pushed to the queue
+ */
+void
+FawkesNetworkMessageBatch::unpack(FawkesNetworkMessage *batch, FawkesNetworkMessageQueue *msgq)
+{
+  const size_t hsize = sizeof(fawkes_message_header_t);
+  const char *payload = (const char *)batch->payload();
+  size_t size = batch->payload_size();
+
+  // validate completely before creating any message
+  size_t pos = 0;
+  while (pos < size) {
+    fawkes_message_header_t header;
+    if (size - pos < hsize) {
+      throw Exception("Batch frame truncated");
+    }
+    memcpy(&header, payload + pos, hsize);
+    size_t payload_size = ntohl(header.payload_size);
+    size_t frame_size   = hsize + payload_size + batch_padding_size(payload_size);
+    if (size - pos < frame_size) {
+      throw Exception("Batch frame truncated");
+    }
+    if ((ntohs(header.cid) == FAWKES_CID_TRANSPORT) &&
+	(ntohs(header.msg_id) == MSG_TRANSPORT_BATCH))
+    {
+      throw Exception("Nested batch frame");
+    }
+    pos += frame_size;
+  }
+
+  pos = 0;
+  while (pos < size) {
+    fawkes_message_header_t header;
+    memcpy(&header, payload + pos, hsize);
+    size_t payload_size = ntohl(header.payload_size);
+    FawkesNetworkMessage *m;
+    if (payload_size > 0) {
+      m = new FawkesNetworkMessage(batch->clid(), ntohs(header.cid), ntohs(header.msg_id),
+				   payload + pos + hsize, payload_size, batch);
+    } else {
+      m = new FawkesNetworkMessage(batch->clid(), ntohs(header.cid), ntohs(header.msg_id));
+    }
+    msgq->push(m);
+    pos += hsize + payload_size + batch_padding_size(payload_size);
+  }
+}
+
+
+/** Coalesce messages into batch frames.
+ * Replaces runs of consecutive messages, which fit into a frame of the
+ * given maximum size, by batch frames. Messages which are too large and
+ * batch frames are left as they are.
+ * @param msgs list of messages to send
+ * @param first first message which may be coalesced, messages before are
+ * left untouched, e.g. because they have been sent partially
+ * @param max_size maximum size of the payload of a batch frame
+ */
+void
+FawkesNetworkMessageBatch::coalesce(std::list<FawkesNetworkMessage *> &msgs,
+				    std::list<FawkesNetworkMessage *>::iterator first,
+				    size_t max_size)
+{
+  std::list<FawkesNetworkMessage *>::iterator m = first;
+  while (m != msgs.end()) {
+    std::list<FawkesNetworkMessage *>::iterator end = m;
+    size_t size = 0;
+    unsigned int num = 0;
+    while ((end != msgs.end()) && ! is_batch(*end)) {
+      size_t fsize = frame_size(*end);
+      if (size + fsize > max_size)  break;
+      size += fsize;
+      ++num;
+      ++end;
+    }
+
+    if (num < 2) {
+      ++m;
+      continue;
+    }
+
+    FawkesNetworkMessageBatch *batch = new FawkesNetworkMessageBatch();
+    for (std::list<FawkesNetworkMessage *>::iterator b = m; b != end; ++b) {
+      batch->append(*b);
+    }
+    m = msgs.erase(m, end);
+    msgs.insert(m, new FawkesNetworkMessage(FAWKES_CID_TRANSPORT, MSG_TRANSPORT_BATCH, batch));
+  }
+}
+
+} // end namespace fawkes
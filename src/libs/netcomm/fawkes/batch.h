@@ -0,0 +1,63 @@
+
+/***************************************************************************
+ *  batch.h - Fawkes network message batch frames
+ *
+ *  Created: Fri Oct 16 19:02:13 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _NETCOMM_FAWKES_BATCH_H_
+#define _NETCOMM_FAWKES_BATCH_H_
+
+#include <netcomm/fawkes/message_content.h>
+
+#include <list>
+#include <vector>
+
+namespace fawkes {
+
+class FawkesNetworkMessage;
+class FawkesNetworkMessageQueue;
+
+class FawkesNetworkMessageBatch : public FawkesNetworkMessageContent
+{
+ public:
+  FawkesNetworkMessageBatch();
+  virtual ~FawkesNetworkMessageBatch();
+
+  void          append(FawkesNetworkMessage *msg);
+  size_t        size() const;
+  unsigned int  num_messages() const;
+
+  virtual void serialize();
+
+  static size_t  frame_size(FawkesNetworkMessage *msg);
+  static bool    is_batch(const FawkesNetworkMessage *msg);
+  static void    unpack(FawkesNetworkMessage *batch, FawkesNetworkMessageQueue *msgq);
+  static void    coalesce(std::list<FawkesNetworkMessage *> &msgs,
+			  std::list<FawkesNetworkMessage *>::iterator first,
+			  size_t max_size);
+
+ private:
+  std::vector<FawkesNetworkMessage *>  messages_;
+  size_t                               size_;
+};
+
+} // end namespace fawkes
+
+#endif
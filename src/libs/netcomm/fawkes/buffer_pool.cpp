@@ -0,0 +1,136 @@
+
+/***************************************************************************
+ *  buffer_pool.cpp - Fawkes network payload buffer pool
+ *
+ *  Created: Fri Oct 16 18:11:20 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <netcomm/fawkes/buffer_pool.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+
+#include <cstdlib>
+
+namespace fawkes {
+
+/** @class FawkesNetworkBufferPool <netcomm/fawkes/buffer_pool.h>
+ * Pool of payload buffers for received network messages.
+ * Buffers up to 2^FNBP_MAX_SHIFT bytes are rounded up to the next power
+ * of two and recycled instead of being freed, such that the receiving
+ * side does not need a heap allocation for every message. Larger buffers
+ * are allocated and freed directly. The pool is shared by all connections
+ * of the process and is never destroyed, messages may therefore release
+ * their buffers at any time.
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+FawkesNetworkBufferPool::FawkesNetworkBufferPool()
+{
+  mutex_ = new Mutex();
+}
+
+
+/** Destructor. */
+FawkesNetworkBufferPool::~FawkesNetworkBufferPool()
+{
+  for (unsigned int c = 0; c <= FNBP_MAX_SHIFT - FNBP_MIN_SHIFT; ++c) {
+    for (size_t i = 0; i < free_[c].size(); ++i) {
+      free(free_[c][i]);
+    }
+  }
+  delete mutex_;
+}
+
+
+/** Get the pool instance.
+ * @return process-wide buffer pool
+ */
+FawkesNetworkBufferPool *
+FawkesNetworkBufferPool::instance()
+{
+  // intentionally never deleted, messages may outlive static destruction
+  static FawkesNetworkBufferPool *pool = new FawkesNetworkBufferPool();
+  return pool;
+}
+
+
+/** Get size class of a buffer.
+ * @param size requested buffer size
+ * @return index of the size class
+ */
+unsigned int
+FawkesNetworkBufferPool::size_class(size_t size)
+{
+  unsigned int c = 0;
+  while (((size_t)1 << (c + FNBP_MIN_SHIFT)) < size)  ++c;
+  return c;
+}
+
+
+/** Allocate buffer.
+ * @param size minimum size of the buffer in bytes
+ * @return buffer, must be released with release() passing the same size
+ */
+void *
+FawkesNetworkBufferPool::alloc(size_t size)
+{
+  if (size > ((size_t)1 << FNBP_MAX_SHIFT)) {
+    return malloc(size);
+  }
+
+  unsigned int c = size_class(size);
+  mutex_->lock();
+  if (! free_[c].empty()) {
+    void *buf = free_[c].back();
+    free_[c].pop_back();
+    mutex_->unlock();
+    return buf;
+  }
+  mutex_->unlock();
+
+  return malloc((size_t)1 << (c + FNBP_MIN_SHIFT));
+}
+
+
+/** Release buffer.
+ * @param buf buffer allocated with alloc()
+ * @param size size that was passed to alloc()
+ */
+void
+FawkesNetworkBufferPool::release(void *buf, size_t size)
+{
+  if (buf == NULL)  return;
+  if (size > ((size_t)1 << FNBP_MAX_SHIFT)) {
+    free(buf);
+    return;
+  }
+
+  unsigned int c = size_class(size);
+  MutexLocker lock(mutex_);
+  if (free_[c].size() < FNBP_MAX_FREE) {
+    free_[c].push_back(buf);
+  } else {
+    lock.unlock();
+    free(buf);
+  }
+}
+
+} // end namespace fawkes
@@ -0,0 +1,62 @@
+
+/***************************************************************************
+ *  buffer_pool.h - Fawkes network payload buffer pool
+ *
+ *  Created: Fri Oct 16 18:11:20 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _NETCOMM_FAWKES_BUFFER_POOL_H_
+#define _NETCOMM_FAWKES_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <vector>
+
+/** Smallest pooled buffer size is 2^FNBP_MIN_SHIFT bytes. */
+#define FNBP_MIN_SHIFT     6
+/** Largest pooled buffer size is 2^FNBP_MAX_SHIFT bytes. */
+#define FNBP_MAX_SHIFT    16
+/** Maximum number of free buffers kept per size class. */
+#define FNBP_MAX_FREE    128
+
+namespace fawkes {
+
+class Mutex;
+
+class FawkesNetworkBufferPool
+{
+ public:
+  static FawkesNetworkBufferPool * instance();
+
+  void * alloc(size_t size);
+  void   release(void *buf, size_t size);
+
+ private:
+  FawkesNetworkBufferPool();
+  ~FawkesNetworkBufferPool();
+
+  static unsigned int size_class(size_t size);
+
+ private:
+  Mutex               *mutex_;
+  std::vector<void *>  free_[FNBP_MAX_SHIFT - FNBP_MIN_SHIFT + 1];
+};
+
+} // end namespace fawkes
+
+#endif
@@ -24,7 +24,11 @@
 #include <netcomm/fawkes/client.h>
 #include <netcomm/fawkes/client_handler.h>
 #include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/outbound_queue.h>
 #include <netcomm/fawkes/transceiver.h>
+#include <netcomm/fawkes/reactor.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
 #include <netcomm/socket/stream.h>
 #include <netcomm/utils/exceptions.h>
 
@@ -75,27 +79,13 @@ class FawkesNetworkClientSendThread : public Thread
   {
     s_ = s;
     parent_ = parent;
-    outbound_mutex_    = new Mutex();
-    outbound_msgqs_[0] = new FawkesNetworkMessageQueue();
-    outbound_msgqs_[1] = new FawkesNetworkMessageQueue();
-    outbound_active_   = 0;
-    outbound_msgq_     = outbound_msgqs_[0];
-    outbound_havemore_ = false;
+    outbound_ = new FawkesNetworkOutboundQueue();
   }
 
   /** Destructor. */
   ~FawkesNetworkClientSendThread()
   {
-    for (unsigned int i = 0; i < 2; ++i) {
-      while ( ! outbound_msgqs_[i]->empty() ) {
-	FawkesNetworkMessage *m = outbound_msgqs_[i]->front();
-	m->unref();
-	outbound_msgqs_[i]->pop();
-      }
-    }
-    delete outbound_msgqs_[0];
-    delete outbound_msgqs_[1];
-    delete outbound_mutex_;
+    delete outbound_;
   }
 
   virtual void once()
@@ -107,14 +97,8 @@ class FawkesNetworkClientSendThread : public Thread
   {
     if ( ! parent_->connected() )  return;
 
-    while ( outbound_havemore_ ) {
-      outbound_mutex_->lock();
-      outbound_havemore_ = false;
-      FawkesNetworkMessageQueue *q = outbound_msgq_;
-      outbound_active_ = 1 - outbound_active_;
-      outbound_msgq_ = outbound_msgqs_[outbound_active_];
-      outbound_mutex_->unlock();
-
+    while ( outbound_->has_more() ) {
+      FawkesNetworkMessageQueue *q = outbound_->swap();
       if ( ! q->empty() ) {
 	try {
 	  FawkesNetworkTransceiver::send(s_, q);
@@ -131,6 +115,7 @@ class FawkesNetworkClientSendThread : public Thread
    */
   void force_send()
   {
+    outbound_->flush();
     if ( loop_mutex->try_lock() ) {
       loop();
       loop_mutex->unlock();
@@ -150,25 +135,27 @@ class FawkesNetworkClientSendThread : public Thread
    */
   void enqueue(FawkesNetworkMessage *message)
   {
-    outbound_mutex_->lock();
-    outbound_msgq_->push(message);
-    outbound_havemore_ = true;
-    outbound_mutex_->unlock();
+    outbound_->push(message);
     wakeup();
   }
 
+  /** Enable or disable batching.
+   * @param max_size maximum size of a batch frame, 0 to disable batching
+   * @param max_age_usec maximum time in microseconds to hold back a message
+   * to fill a batch, 0 to only batch messages which are queued anyway
+   */
+  void set_batching(size_t max_size, unsigned int max_age_usec)
+  {
+    outbound_->set_batching(max_size, max_age_usec);
+  }
+
  /** Stub to see name in backtrace for easier debugging. @see Thread::run() */
  protected: virtual void run() { Thread::run(); }
 
  private:
   StreamSocket *s_;
   FawkesNetworkClient *parent_;
-  Mutex                     *outbound_mutex_;
-  unsigned int               outbound_active_;
-  bool                       outbound_havemore_;
-  FawkesNetworkMessageQueue *outbound_msgq_;
-  FawkesNetworkMessageQueue *outbound_msgqs_[2];
-  
+  FawkesNetworkOutboundQueue *outbound_;
 };
 
 
@@ -283,6 +270,58 @@ class FawkesNetworkClientRecvThread : public Thread
 };
 
 
+/** Fawkes network client reactor handler.
+ * Used by the FawkesNetworkClient instead of the send and receive threads
+ * if the connection is served by a FawkesNetworkReactor.
+ *
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+class FawkesNetworkClientReactorHandler : public FawkesNetworkReactorHandler
+{
+ public:
+  /** Constructor.
+   * @param parent parent FawkesNetworkClient instance
+   * @param recv_mutex receive mutex, locked while messages are dispatched
+   */
+  FawkesNetworkClientReactorHandler(FawkesNetworkClient *parent, Mutex *recv_mutex)
+  {
+    parent_ = parent;
+    recv_mutex_ = recv_mutex;
+  }
+
+  virtual void reactor_inbound(unsigned int conn_id, FawkesNetworkMessageQueue *msgq)
+  {
+    std::list<unsigned int> wakeup_list;
+
+    MutexLocker lock(recv_mutex_);
+    while ( ! msgq->empty() ) {
+      FawkesNetworkMessage *m = msgq->front();
+      wakeup_list.push_back(m->cid());
+      parent_->dispatch_message(m);
+      m->unref();
+      msgq->pop();
+    }
+    lock.unlock();
+
+    wakeup_list.sort();
+    wakeup_list.unique();
+    for (std::list<unsigned int>::iterator i = wakeup_list.begin(); i != wakeup_list.end(); ++i) {
+      parent_->wake_handlers(*i);
+    }
+  }
+
+  virtual void reactor_connection_died(unsigned int conn_id)
+  {
+    parent_->connection_died();
+  }
+
+ private:
+  FawkesNetworkClient *parent_;
+  Mutex *recv_mutex_;
+};
+
+
 /** @class FawkesNetworkClient netcomm/fawkes/client.h
  * Simple Fawkes network client. Allows access to a remote instance via the
  * network. Encapsulates all needed interaction with the network.
@@ -305,6 +344,11 @@ FawkesNetworkClient::FawkesNetworkClient(const char *host, unsigned short int po
   s = NULL;
   send_slave_ = NULL;
   recv_slave_ = NULL;
+  reactor_    = NULL;
+  reactor_handler_ = NULL;
+  reactor_conn_    = 0;
+  batch_max_size_  = FAWKES_NETWORK_BATCH_MAX_SIZE;
+  batch_max_age_   = 0;
 
   connection_died_recently = false;
   send_slave_alive_ = false;
@@ -338,6 +382,11 @@ FawkesNetworkClient::FawkesNetworkClient()
   s = NULL;
   send_slave_ = NULL;
   recv_slave_ = NULL;
+  reactor_    = NULL;
+  reactor_handler_ = NULL;
+  reactor_conn_    = 0;
+  batch_max_size_  = FAWKES_NETWORK_BATCH_MAX_SIZE;
+  batch_max_age_   = 0;
 
   connection_died_recently = false;
   send_slave_alive_ = false;
@@ -373,6 +422,11 @@ FawkesNetworkClient::FawkesNetworkClient(unsigned int id, const char *host,
   s = NULL;
   send_slave_ = NULL;
   recv_slave_ = NULL;
+  reactor_    = NULL;
+  reactor_handler_ = NULL;
+  reactor_conn_    = 0;
+  batch_max_size_  = FAWKES_NETWORK_BATCH_MAX_SIZE;
+  batch_max_age_   = 0;
 
   connection_died_recently = false;
   send_slave_alive_ = false;
@@ -436,12 +490,23 @@ FawkesNetworkClient::connect()
     } else {
 	    throw NullPointerException("Nothing to connect to!?");
     }
-    send_slave_ = new FawkesNetworkClientSendThread(s, this);
-    send_slave_->start();
-    recv_slave_ = new FawkesNetworkClientRecvThread(s, this, recv_mutex_);
-    recv_slave_->start();
-  } catch (SocketException &e) {
+    if ( reactor_ ) {
+      reactor_handler_ = new FawkesNetworkClientReactorHandler(this, recv_mutex_);
+      reactor_conn_ = reactor_->add_connection(s, reactor_handler_);
+      connest_mutex_->lock();
+      connest_ = true;
+      connest_mutex_->unlock();
+    } else {
+      send_slave_ = new FawkesNetworkClientSendThread(s, this);
+      send_slave_->start();
+      recv_slave_ = new FawkesNetworkClientRecvThread(s, this, recv_mutex_);
+      recv_slave_->start();
+    }
+    request_transport_features();
+  } catch (Exception &e) {
     connection_died_recently = true;
+    delete reactor_handler_;
+    reactor_handler_ = NULL;
     if ( send_slave_ ) {
       send_slave_->cancel();
       send_slave_->join();
@@ -530,6 +595,17 @@ FawkesNetworkClient::disconnect()
 {
   if ( s == NULL ) return;
 
+  if ( reactor_conn_ ) {
+    if ( ! connection_died_recently ) {
+      reactor_->flush(reactor_conn_);
+      // Give other side some time to read the messages just sent
+      usleep(100000);
+    }
+    reactor_->remove_connection(reactor_conn_);
+    delete reactor_handler_;
+    reactor_handler_ = NULL;
+    reactor_conn_ = 0;
+  }
   if ( send_slave_alive_ ) {
     if ( ! connection_died_recently ) {
       send_slave_->force_send();
@@ -586,7 +662,12 @@ FawkesNetworkClient::interrupt_connect()
 void
 FawkesNetworkClient::enqueue(FawkesNetworkMessage *message)
 {
-  if (send_slave_)  send_slave_->enqueue(message);
+  message->pack();
+  if (reactor_conn_) {
+    reactor_->enqueue(reactor_conn_, message);
+  } else if (send_slave_) {
+    send_slave_->enqueue(message);
+  }
 }
 
 
@@ -605,7 +686,7 @@ void
 FawkesNetworkClient::enqueue_and_wait(FawkesNetworkMessage *message,
 				      unsigned int timeout_sec)
 {
-  if (send_slave_ && recv_slave_) {
+  if ((send_slave_ && recv_slave_) || reactor_conn_) {
     recv_mutex_->lock();
     if ( recv_received_.find(message->cid()) != recv_received_.end()) {
       recv_mutex_->unlock();
@@ -613,8 +694,8 @@ FawkesNetworkClient::enqueue_and_wait(FawkesNetworkMessage *message,
       throw Exception("There is already a thread waiting for messages of "
 		      "component id %u", cid);
     }
-    send_slave_->enqueue(message);
     unsigned int cid = message->cid();
+    enqueue(message);
     recv_received_[cid] = false;
     while (!recv_received_[cid] && ! connection_died_recently) {
       if (!recv_waitcond_->reltimed_wait(timeout_sec, 0)) {
@@ -635,6 +716,73 @@ FawkesNetworkClient::enqueue_and_wait(FawkesNetworkMessage *message,
 }
 
 
+/** Set batching parameters.
+ * Small messages are combined into batch frames of up to the given size
+ * if the server supports it. With a maximum age, messages are held back
+ * for at most that time to fill a batch, which trades latency for fewer
+ * frames. If the connection is served by a reactor, only messages which
+ * are queued anyway are batched. Takes effect on the next connect().
+ * @param max_size maximum size of a batch frame in bytes, 0 to disable
+ * batching
+ * @param max_age_usec maximum time in microseconds to hold back messages
+ */
+void
+FawkesNetworkClient::set_batching(size_t max_size, unsigned int max_age_usec)
+{
+  batch_max_size_ = max_size;
+  batch_max_age_  = max_age_usec;
+}
+
+
+/** Request transport features from the server.
+ * Sent as the first message after connecting. Servers which do not know
+ * the request ignore it, batching is then not used.
+ */
+void
+FawkesNetworkClient::request_transport_features()
+{
+  enqueue(FawkesNetworkTransport::features_request());
+}
+
+
+/** Handle transport message.
+ * Enables batching if the server can decode batch frames.
+ * @param m transport message received from the server
+ */
+void
+FawkesNetworkClient::handle_transport(FawkesNetworkMessage *m)
+{
+  uint32_t features;
+  if ( ! FawkesNetworkTransport::features_reply(m, features) )  return;
+
+  if ( (features & TRANSPORT_FEATURE_BATCH) && (batch_max_size_ > 0) ) {
+    if ( reactor_conn_ ) {
+      reactor_->set_batching(reactor_conn_, batch_max_size_);
+    } else if ( send_slave_ ) {
+      send_slave_->set_batching(batch_max_size_, batch_max_age_);
+    }
+  }
+}
+
+
+/** Use a reactor to serve the connection.
+ * Instead of spawning a receiving and a sending thread on connect() the
+ * connection is then served by the given reactor, which can be shared
+ * among many clients. Handlers are called from the reactor thread. The
+ * reactor must be running and outlive the connection.
+ * @param reactor reactor to use, NULL to use own threads again
+ * @exception Exception thrown if called while connected
+ */
+void
+FawkesNetworkClient::set_reactor(FawkesNetworkReactor *reactor)
+{
+  if ( s != NULL ) {
+    throw Exception("Cannot change reactor while connected");
+  }
+  reactor_ = reactor;
+}
+
+
 /** Register handler.
  * Handlers are used to handle incoming packets. There may only be one handler per
  * component!
@@ -683,6 +831,10 @@ void
 FawkesNetworkClient::dispatch_message(FawkesNetworkMessage *m)
 {
   unsigned int cid = m->cid();
+  if ( cid == FAWKES_CID_TRANSPORT ) {
+    handle_transport(m);
+    return;
+  }
   handlers.lock();
   if (handlers.find(cid) != handlers.end()) {
     handlers[cid]->inbound_received(m, _id);
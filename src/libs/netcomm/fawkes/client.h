@@ -40,6 +40,8 @@ class WaitCondition;
 class FawkesNetworkClientHandler;
 class FawkesNetworkClientSendThread;
 class FawkesNetworkClientRecvThread;
+class FawkesNetworkClientReactorHandler;
+class FawkesNetworkReactor;
 
 class HandlerAlreadyRegisteredException : public Exception
 {
@@ -53,6 +55,7 @@ class FawkesNetworkClient
 {
  friend FawkesNetworkClientSendThread;
  friend FawkesNetworkClientRecvThread;
+ friend FawkesNetworkClientReactorHandler;
  public:
  FawkesNetworkClient();
  FawkesNetworkClient(const char *host, unsigned short int port);
@@ -74,6 +77,9 @@ class FawkesNetworkClient
 
   void interrupt_connect();
 
+  void set_reactor(FawkesNetworkReactor *reactor);
+  void set_batching(size_t max_size, unsigned int max_age_usec);
+
   void register_handler(FawkesNetworkClientHandler *handler, unsigned int component_id);
   void deregister_handler(unsigned int component_id);
 
@@ -91,6 +97,8 @@ class FawkesNetworkClient
 
   void wake_handlers(unsigned int cid);
   void dispatch_message(FawkesNetworkMessage *m);
+  void handle_transport(FawkesNetworkMessage *m);
+  void request_transport_features();
   void connection_died();
   void set_send_slave_alive();
   void set_recv_slave_alive();
@@ -116,6 +124,13 @@ class FawkesNetworkClient
   bool                           recv_slave_alive_;
   bool                           send_slave_alive_;
 
+  FawkesNetworkReactor               *reactor_;
+  FawkesNetworkClientReactorHandler  *reactor_handler_;
+  unsigned int                        reactor_conn_;
+
+  size_t       batch_max_size_;
+  unsigned int batch_max_age_;
+
   bool connection_died_recently;
   Mutex *slave_status_mutex;
   bool _has_id;
@@ -55,6 +55,9 @@
 // NetworkLogger: netcomm/utils/network_logger.h
 #define FAWKES_CID_NETWORKLOGGER         4
 
+// Transport: netcomm/fawkes/transport.h, handled by the connections
+#define FAWKES_CID_TRANSPORT             5
+
 
 /* **** Normal component CIDs **** */
 
@@ -25,6 +25,7 @@
 
 #include <netcomm/fawkes/message.h>
 #include <netcomm/fawkes/message_content.h>
+#include <netcomm/fawkes/buffer_pool.h>
 
 #include <netinet/in.h>
 #include <cstring>
@@ -76,6 +77,14 @@ FawkesNetworkMessageTooBigException::FawkesNetworkMessageTooBigException(size_t
  * FawkesNetworkMessage *m = new FawkesNetworkMessage(clid, cid, msgid, u, sizeof(unsigned int));
  * @endcode
  *
+ * To avoid copying payloads, a message can also reference memory owned
+ * by a reference counted object. The message holds a reference to the
+ * owner until it is destroyed and sends the memory in place. Currently
+ * this is used for messages unpacked from a received batch frame, which
+ * reference the frame. Blackboard interface data and FUSE images are
+ * still copied into the message, interface data may change while the
+ * message is queued and FUSE has its own transceiver.
+ *
  * @ingroup NetComm
  * @author Tim Niemueller
  */
@@ -86,6 +95,9 @@ FawkesNetworkMessageTooBigException::FawkesNetworkMessageTooBigException(size_t
  */
 FawkesNetworkMessage::FawkesNetworkMessage()
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   memset(&_msg, 0, sizeof(_msg));
   _clid = 0;
   _content = NULL;
@@ -98,6 +110,9 @@ FawkesNetworkMessage::FawkesNetworkMessage()
  */
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid, fawkes_message_t &msg)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   _clid = clid;
   memcpy(&_msg, &msg, sizeof(fawkes_message_t));
@@ -110,6 +125,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid, fawkes_message_t &
  */
 FawkesNetworkMessage::FawkesNetworkMessage(fawkes_message_t &msg)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   _clid = 0;
   memcpy(&_msg, &msg, sizeof(fawkes_message_t));
@@ -126,6 +144,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(fawkes_message_t &msg)
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id,
 					   void *payload, size_t payload_size)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _clid = 0;
   _content = NULL;
   if ( payload_size > 0xFFFFFFFF ) {
@@ -149,6 +170,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned shor
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id,
 					   size_t payload_size)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   _clid = 0;
   if ( payload_size > 0xFFFFFFFF ) {
@@ -169,6 +193,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned shor
  */
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   _clid = 0;
   _msg.header.cid = htons(cid);
@@ -187,6 +214,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned shor
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id,
 					   FawkesNetworkMessageContent *content)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = content;
   _clid = 0;
   _msg.header.cid = htons(cid);
@@ -206,6 +236,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
 					   unsigned short int cid, unsigned short int msg_id,
 					   FawkesNetworkMessageContent *content)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = content;
   _clid = clid;
   _msg.header.cid = htons(cid);
@@ -227,6 +260,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
 					   unsigned short int cid, unsigned short int msg_id,
 					   void *payload, size_t payload_size)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   if ( payload_size > 0xFFFFFFFF ) {
     // cannot carry that many bytes
@@ -248,6 +284,9 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
 FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
 					   unsigned short int cid, unsigned short int msg_id)
 {
+  _payload_owner = NULL;
+  _pooled_size = 0;
+  _packed = false;
   _content = NULL;
   _clid = clid;
   _msg.header.cid = htons(cid);
@@ -257,12 +296,47 @@ FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
 }
 
 
+/** Constructor to reference payload owned by another object.
+ * The payload is not copied and not freed by the message. Instead, the
+ * message keeps a reference to the owner as long as it exists.
+ * @param clid client ID
+ * @param cid component ID
+ * @param msg_id message type ID
+ * @param payload pointer to payload, must stay valid and unchanged as long
+ * as the owner exists
+ * @param payload_size size of payload buffer
+ * @param payload_owner reference counted owner of the payload memory
+ */
+FawkesNetworkMessage::FawkesNetworkMessage(unsigned int clid,
+					   unsigned short int cid, unsigned short int msg_id,
+					   const void *payload, size_t payload_size,
+					   RefCount *payload_owner)
+{
+  _content = NULL;
+  _pooled_size = 0;
+  _packed = false;
+  if ( payload_size > 0xFFFFFFFF ) {
+    // cannot carry that many bytes
+    throw FawkesNetworkMessageTooBigException(payload_size);
+  }
+  _clid = clid;
+  _msg.header.cid = htons(cid);
+  _msg.header.msg_id = htons(msg_id);
+  _msg.header.payload_size = htonl(payload_size);
+  _msg.payload = (void *)payload;
+  _payload_owner = payload_owner;
+  if ( _payload_owner )  _payload_owner->ref();
+}
+
+
 /** Destructor.
  * This destructor also frees the payload buffer if set!
  */
 FawkesNetworkMessage::~FawkesNetworkMessage()
 {
-  if ( _content == NULL ) {
+  if ( _payload_owner || _pooled_size ) {
+    release_payload_owner();
+  } else if ( _content == NULL ) {
     if ( _msg.payload != NULL ) {
       free(_msg.payload);
       _msg.payload = NULL;
@@ -375,6 +449,7 @@ FawkesNetworkMessage::set_payload(void *payload, size_t payload_size)
     // cannot carry that many bytes
     throw FawkesNetworkMessageTooBigException(payload_size);
   }
+  release_payload_owner();
   _msg.payload = payload;
   _msg.header.payload_size = htonl(payload_size);
 }
@@ -386,10 +461,49 @@ FawkesNetworkMessage::set_payload(void *payload, size_t payload_size)
 void
 FawkesNetworkMessage::set(fawkes_message_t &msg)
 {
+  release_payload_owner();
   memcpy(&_msg, &msg, sizeof(fawkes_message_t));
 }
 
 
+/** Set payload from buffer pool.
+ * The message takes ownership of the payload and releases it to the
+ * FawkesNetworkBufferPool when it is destroyed.
+ * @param payload payload buffer allocated with FawkesNetworkBufferPool::alloc()
+ * @param payload_size size of payload, must be the size passed to alloc()
+ */
+void
+FawkesNetworkMessage::set_pooled_payload(void *payload, size_t payload_size)
+{
+  if ( payload_size > 0xFFFFFFFF ) {
+    // cannot carry that many bytes
+    throw FawkesNetworkMessageTooBigException(payload_size);
+  }
+  release_payload_owner();
+  _msg.payload = payload;
+  _msg.header.payload_size = htonl(payload_size);
+  _pooled_size = payload_size;
+}
+
+
+/** Release referenced or pooled payload.
+ * Called if the payload is replaced or the message is destroyed.
+ */
+void
+FawkesNetworkMessage::release_payload_owner()
+{
+  if ( _payload_owner ) {
+    _payload_owner->unref();
+    _payload_owner = NULL;
+    _msg.payload = NULL;
+  } else if ( _pooled_size ) {
+    FawkesNetworkBufferPool::instance()->release(_msg.payload, _pooled_size);
+    _pooled_size = 0;
+    _msg.payload = NULL;
+  }
+}
+
+
 /** Set complex message content.
  * @param content complex message content.
  */
@@ -403,15 +517,43 @@ FawkesNetworkMessage::set_content(FawkesNetworkMessageContent *content)
 /** Pack data for sending.
  * If complex message sending is required (message content object has been set)
  * then serialize() is called for the content and the message is prepared for
- * sending.
+ * sending. The content is serialized only once, even if the message is
+ * sent to multiple clients.
+ * This method is not thread-safe. The network hub and client call it
+ * before enqueuing a message, i.e. before it is shared among the threads
+ * sending it, so that later calls on sending threads only read the flag.
  */
 void
 FawkesNetworkMessage::pack()
 {
-  if ( _content != NULL ) {
+  if ( (_content != NULL) && ! _packed ) {
     _content->serialize();
-    _msg.payload = _content->payload();
+    if ( _content->segments().empty() ) {
+      _msg.payload = _content->payload();
+    }
     _msg.header.payload_size = htonl(_content->payload_size());
+    _packed = true;
+  }
+}
+
+
+/** Get payload segments for sending.
+ * Appends the memory regions which make up the payload, without copying
+ * them. This is a single region unless the message has a content which
+ * serialized to multiple segments. The message must have been packed.
+ * @param segments vector to append the payload segments to
+ */
+void
+FawkesNetworkMessage::payload_segments(std::vector<struct iovec> &segments) const
+{
+  if ( (_content != NULL) && ! _content->segments().empty() ) {
+    const std::vector<struct iovec> &cs = _content->segments();
+    segments.insert(segments.end(), cs.begin(), cs.end());
+  } else if ( payload_size() > 0 ) {
+    struct iovec iov;
+    iov.iov_base = _msg.payload;
+    iov.iov_len  = payload_size();
+    segments.push_back(iov);
   }
 }
 
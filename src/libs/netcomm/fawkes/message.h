@@ -28,6 +28,12 @@
 #include <core/exceptions/software.h>
 
 #include <cstddef>
+#include <vector>
+#include <sys/uio.h>
+
+/** Default maximum payload size of a received message in bytes.
+ * Connections announcing larger messages are considered broken. */
+#define FAWKES_NET_MAX_PAYLOAD_SIZE  (16 * 1024 * 1024)
 
 namespace fawkes {
 
@@ -92,6 +98,10 @@ class FawkesNetworkMessage : public RefCount
   FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id,
 		       size_t payload_size);
   FawkesNetworkMessage(unsigned short int cid, unsigned short int msg_id);
+  FawkesNetworkMessage(unsigned int clid,
+		       unsigned short int cid, unsigned short int msg_id,
+		       const void *payload, size_t payload_size,
+		       RefCount *payload_owner);
   FawkesNetworkMessage();
 
   virtual ~FawkesNetworkMessage();
@@ -169,17 +179,23 @@ class FawkesNetworkMessage : public RefCount
   void set_payload(void *payload, size_t payload_size);
   void set(fawkes_message_t &msg);
   void set_content(FawkesNetworkMessageContent *content);
+  void set_pooled_payload(void *payload, size_t payload_size);
 
   void pack();
+  void payload_segments(std::vector<struct iovec> &segments) const;
 
  private:
   void init_cid_msgid(unsigned short int cid, unsigned short int msg_id);
   void init_payload(size_t payload_size);
+  void release_payload_owner();
 
   unsigned int _clid;
   fawkes_message_t _msg;
 
   FawkesNetworkMessageContent *_content;
+  RefCount                    *_payload_owner;
+  size_t                       _pooled_size;
+  bool                         _packed;
 };
 
 } // end namespace fawkes
@@ -24,6 +24,7 @@
 #include <netcomm/fawkes/message_content.h>
 #include <core/exceptions/software.h>
 
+#include <cstdlib>
 #include <cstring>
 
 namespace fawkes {
@@ -39,6 +40,13 @@ namespace fawkes {
  * buffer that contains all the data that has to be sent. Make _payload point
  * to this buffer and _payload_size contain the size of the buffer.
  *
+ * Alternatively, serialize() can describe the payload as a sequence of
+ * segments with add_segment(), each referencing memory owned by the content,
+ * for example a message struct and the buffer of a DynamicBuffer. The
+ * segments are then sent with a single gather write without copying them
+ * into a contiguous buffer first. The memory must stay valid and unchanged
+ * as long as the content exists.
+ *
  * @see DynamicBuffer
  * @ingroup NetComm
  * @author Tim Niemueller
@@ -46,7 +54,8 @@ namespace fawkes {
  * @fn void FawkesNetworkMessageContent::serialize() = 0
  * Serialize message content.
  * Generate a single contiguous buffer. Make _payload point to this buffer and
- * _payload_size contain the size of the buffer.
+ * _payload_size contain the size of the buffer. Alternatively add segments
+ * with add_segment().
  */
 
 /** Constructor. */
@@ -54,12 +63,14 @@ FawkesNetworkMessageContent::FawkesNetworkMessageContent()
 {
   _payload = NULL;
   _payload_size = 0;
+  flat_payload_ = NULL;
 }
 
 
-/** Virtual empty destructor. */
+/** Virtual destructor. */
 FawkesNetworkMessageContent::~FawkesNetworkMessageContent()
 {
+  if (flat_payload_)  free(flat_payload_);
 }
 
 
@@ -71,6 +82,19 @@ FawkesNetworkMessageContent::~FawkesNetworkMessageContent()
 void *
 FawkesNetworkMessageContent::payload()
 {
+  if ( (_payload == NULL) && ! segments_.empty() ) {
+    // only needed if a contiguous buffer is requested explicitly
+    if ( flat_payload_ == NULL ) {
+      size_t size = payload_size();
+      flat_payload_ = malloc(size);
+      size_t offset = 0;
+      for (size_t i = 0; i < segments_.size(); ++i) {
+	memcpy((char *)flat_payload_ + offset, segments_[i].iov_base, segments_[i].iov_len);
+	offset += segments_[i].iov_len;
+      }
+    }
+    return flat_payload_;
+  }
   if ( (_payload == NULL) || (_payload_size == 0) ) {
     throw NullPointerException("Payload in network message content may not be NULL");
   }
@@ -87,6 +111,13 @@ FawkesNetworkMessageContent::payload()
 size_t
 FawkesNetworkMessageContent::payload_size()
 {
+  if ( (_payload == NULL) && ! segments_.empty() ) {
+    size_t size = 0;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      size += segments_[i].iov_len;
+    }
+    return size;
+  }
   if ( (_payload == NULL) || (_payload_size == 0) ) {
     throw NullPointerException("Payload in network message content may not be NULL");
   }
@@ -107,4 +138,46 @@ FawkesNetworkMessageContent::copy_payload(size_t offset, const void *buf, size_t
   memcpy(tmp, buf, len);
 }
 
+
+/** Get payload segments.
+ * @return segments added with add_segment(), empty if the content has been
+ * serialized into a contiguous buffer
+ */
+const std::vector<struct iovec> &
+FawkesNetworkMessageContent::segments() const
+{
+  return segments_;
+}
+
+
+/** Add payload segment.
+ * The memory is referenced, not copied. It must stay valid and unchanged
+ * until the content is deleted.
+ * @param buf buffer to send
+ * @param len number of bytes to send from buf
+ */
+void
+FawkesNetworkMessageContent::add_segment(const void *buf, size_t len)
+{
+  if (len == 0)  return;
+  struct iovec iov;
+  iov.iov_base = (void *)buf;
+  iov.iov_len  = len;
+  segments_.push_back(iov);
+}
+
+
+/** Remove all payload segments.
+ * Call this at the beginning of serialize() if using segments.
+ */
+void
+FawkesNetworkMessageContent::clear_segments()
+{
+  segments_.clear();
+  if (flat_payload_) {
+    free(flat_payload_);
+    flat_payload_ = NULL;
+  }
+}
+
 } // end namespace fawkes
@@ -25,7 +25,9 @@
 #define _NETCOMM_FAWKES_MESSAGE_CONTENT_H_
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <cstddef>
+#include <vector>
 
 namespace fawkes {
 
@@ -39,14 +41,22 @@ class FawkesNetworkMessageContent
   virtual void * payload();
   virtual size_t payload_size();
 
+  const std::vector<struct iovec> & segments() const;
+
  protected:
   void copy_payload(size_t offset, const void *buf, size_t len);
+  void add_segment(const void *buf, size_t len);
+  void clear_segments();
 
  protected:
   /** Pointer to payload. */
   void *  _payload;
   /** Payloda size. */
   size_t  _payload_size;
+
+ private:
+  std::vector<struct iovec>  segments_;
+  void                      *flat_payload_;
 };
 
 } // end namespace fawkes
@@ -22,6 +22,9 @@
  */
 
 #include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/batch.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
 
 namespace fawkes {
 
@@ -29,6 +32,11 @@ namespace fawkes {
  * A LockQueue of FawkesNetworkMessage to hold messages in inbound and
  * outbound queues.
  *
+ * Outbound queues can batch small messages. If enabled, pop_frame()
+ * combines consecutive messages into a MSG_TRANSPORT_BATCH frame, as long
+ * as they fit into the configured maximum size. Only enable batching if
+ * the peer announced TRANSPORT_FEATURE_BATCH.
+ *
  * @ingroup NetComm
  * @author Tim Niemueller
  */
@@ -36,6 +44,7 @@ namespace fawkes {
 /** Constructor. */
 FawkesNetworkMessageQueue::FawkesNetworkMessageQueue()
 {
+  batch_max_size_ = 0;
 }
 
 
@@ -44,4 +53,64 @@ FawkesNetworkMessageQueue::~FawkesNetworkMessageQueue()
 {
 }
 
+
+/** Enable or disable batching.
+ * @param max_size maximum size of the payload of a batch frame in bytes,
+ * 0 to disable batching
+ */
+void
+FawkesNetworkMessageQueue::set_batching(size_t max_size)
+{
+  lock();
+  batch_max_size_ = max_size;
+  unlock();
+}
+
+
+/** Get maximum batch size.
+ * @return maximum size of the payload of a batch frame, 0 if batching is
+ * disabled
+ */
+size_t
+FawkesNetworkMessageQueue::batch_max_size() const
+{
+  return batch_max_size_;
+}
+
+
+/** Pop next frame to send.
+ * Removes the first message from the queue. If batching is enabled, it is
+ * combined with the following messages into a batch frame, as long as
+ * they fit. The queue must not be empty and should be locked. The caller
+ * owns the returned message and must unref it after sending.
+ * @return next message or batch frame to send
+ */
+FawkesNetworkMessage *
+FawkesNetworkMessageQueue::pop_frame()
+{
+  FawkesNetworkMessage *m = front();
+  pop();
+
+  if ( (batch_max_size_ == 0) || empty() ||
+       FawkesNetworkMessageBatch::is_batch(m) || FawkesNetworkMessageBatch::is_batch(front()) )
+  {
+    return m;
+  }
+  if ( FawkesNetworkMessageBatch::frame_size(m) +
+       FawkesNetworkMessageBatch::frame_size(front()) > batch_max_size_ )
+  {
+    return m;
+  }
+
+  FawkesNetworkMessageBatch *batch = new FawkesNetworkMessageBatch();
+  batch->append(m);
+  while ( ! empty() && ! FawkesNetworkMessageBatch::is_batch(front()) &&
+	  (batch->size() + FawkesNetworkMessageBatch::frame_size(front()) <= batch_max_size_) )
+  {
+    batch->append(front());
+    pop();
+  }
+  return new FawkesNetworkMessage(FAWKES_CID_TRANSPORT, MSG_TRANSPORT_BATCH, batch);
+}
+
 } // end namespace fawkes
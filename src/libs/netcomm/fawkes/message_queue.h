@@ -35,6 +35,14 @@ class FawkesNetworkMessageQueue : public LockQueue<FawkesNetworkMessage *>
  public:
   FawkesNetworkMessageQueue();
   ~FawkesNetworkMessageQueue();
+
+  void   set_batching(size_t max_size);
+  size_t batch_max_size() const;
+
+  FawkesNetworkMessage * pop_frame();
+
+ private:
+  size_t batch_max_size_;
 };
 
 } // end namespace fawkes
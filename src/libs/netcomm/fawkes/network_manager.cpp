@@ -57,19 +57,23 @@ namespace fawkes {
  * empty string or :: to listen on any local address
  * @param fawkes_port port to listen on for Fawkes network connections
  * @param service_name Avahi service name for Fawkes network service
+ * @param num_io_threads number of I/O reactor threads serving all clients,
+ * 0 to use a receiving and a sending thread per client
  */
 FawkesNetworkManager::FawkesNetworkManager(ThreadCollector *thread_collector,
                                            bool enable_ipv4, bool enable_ipv6,
                                            const std::string &listen_ipv4, const std::string &listen_ipv6,
                                            unsigned short int fawkes_port,
-                                           const char *service_name)
+                                           const char *service_name,
+                                           unsigned int num_io_threads)
 {
   fawkes_port_      = fawkes_port;
   thread_collector_ = thread_collector;
   fawkes_network_thread_ = new FawkesNetworkServerThread(enable_ipv4, enable_ipv6,
                                                           listen_ipv4, listen_ipv6,
                                                           fawkes_port_,
-                                                          thread_collector_);
+                                                          thread_collector_,
+                                                          num_io_threads);
   thread_collector_->add(fawkes_network_thread_);
 #ifdef HAVE_AVAHI
   avahi_thread_          = new AvahiThread(enable_ipv4, enable_ipv6);
@@ -145,6 +149,20 @@ FawkesNetworkManager::service_browser()
   return service_browser_;
 }
 
+/** Set batching parameters of the Fawkes network server.
+ * @param max_size maximum size of a batch frame in bytes, 0 to disable
+ * batching
+ * @param max_age_usec maximum time in microseconds to hold back messages
+ * to fill a batch
+ * @see FawkesNetworkServerThread::set_batching()
+ */
+void
+FawkesNetworkManager::set_batching(size_t max_size, unsigned int max_age_usec)
+{
+  fawkes_network_thread_->set_batching(max_size, max_age_usec);
+}
+
+
 /** Get Fawkes TCP port.
  * @return TCP port on which Fawkes is listening
  */
@@ -25,6 +25,7 @@
 #define _FAWKES_NETWORK_MANAGER_H_
 
 #include <string>
+#include <cstddef>
 
 namespace fawkes {
 class ThreadCollector;
@@ -43,7 +44,8 @@ class FawkesNetworkManager
 	                     bool enable_ipv4, bool enable_ipv6,
 	                     const std::string &listen_ipv4, const std::string &listen_ipv6,
                        unsigned short int fawkes_port,
-                       const char *service_name);
+                       const char *service_name,
+                       unsigned int num_io_threads = 0);
   ~FawkesNetworkManager();
 
   FawkesNetworkHub *     hub();
@@ -53,6 +55,8 @@ class FawkesNetworkManager
 
   unsigned short int     fawkes_port() const;
 
+  void set_batching(size_t max_size, unsigned int max_age_usec);
+
  private:
   unsigned short int          fawkes_port_;
   ThreadCollector            *thread_collector_;
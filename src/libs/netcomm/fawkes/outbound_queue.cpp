@@ -0,0 +1,183 @@
+
+/***************************************************************************
+ *  outbound_queue.cpp - Fawkes network outbound message queue
+ *
+ *  Created: Sat Oct 17 00:21:45 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <netcomm/fawkes/outbound_queue.h>
+#include <netcomm/fawkes/message.h>
+#include <netcomm/fawkes/message_queue.h>
+#include <core/threading/thread.h>
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <core/threading/wait_condition.h>
+
+namespace fawkes {
+
+/** @class FawkesNetworkOutboundQueue <netcomm/fawkes/outbound_queue.h>
+ * Outbound messages of a connection served by a sending thread.
+ * Messages are pushed by any thread to the active of two queues. The
+ * sending thread swaps the queues and sends the inactive one without
+ * blocking producers. If batching has been negotiated, swap() may hold
+ * back messages for a short time to fill a batch frame.
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+FawkesNetworkOutboundQueue::FawkesNetworkOutboundQueue()
+{
+  mutex_         = new Mutex();
+  waitcond_      = new WaitCondition(mutex_);
+  msgqs_[0]      = new FawkesNetworkMessageQueue();
+  msgqs_[1]      = new FawkesNetworkMessageQueue();
+  active_        = 0;
+  msgq_          = msgqs_[0];
+  havemore_      = false;
+  flush_         = false;
+  bytes_         = 0;
+  batch_max_age_ = 0;
+}
+
+
+/** Destructor.
+ * Messages which have not been sent are released.
+ */
+FawkesNetworkOutboundQueue::~FawkesNetworkOutboundQueue()
+{
+  for (unsigned int i = 0; i < 2; ++i) {
+    while ( ! msgqs_[i]->empty() ) {
+      msgqs_[i]->front()->unref();
+      msgqs_[i]->pop();
+    }
+  }
+  delete msgqs_[0];
+  delete msgqs_[1];
+  delete waitcond_;
+  delete mutex_;
+}
+
+
+/** Push message.
+ * This method takes ownership of the message. If you want to use the message
+ * after pushing you must reference it explicitly.
+ * @param msg message to send
+ */
+void
+FawkesNetworkOutboundQueue::push(FawkesNetworkMessage *msg)
+{
+  // the payload size of complex messages is only known after packing
+  msg->pack();
+
+  MutexLocker lock(mutex_);
+  if ( msgq_->empty() ) {
+    clock_gettime(CLOCK_MONOTONIC, &first_);
+  }
+  msgq_->push(msg);
+  bytes_ += sizeof(fawkes_message_header_t) + msg->payload_size();
+  havemore_ = true;
+  if ( (batch_max_age_ > 0) && (bytes_ >= msgq_->batch_max_size()) ) {
+    waitcond_->wake_all();
+  }
+}
+
+
+/** Check if messages have been pushed since the last swap.
+ * @return true if there are messages to send, false otherwise
+ */
+bool
+FawkesNetworkOutboundQueue::has_more()
+{
+  MutexLocker lock(mutex_);
+  return havemore_;
+}
+
+
+/** Swap queues.
+ * To be called by the sending thread only. With a maximum batch age, this
+ * waits for more messages first, see set_batching().
+ * @return queue with the messages to send, the sending thread may use it
+ * until the next call to swap()
+ */
+FawkesNetworkMessageQueue *
+FawkesNetworkOutboundQueue::swap()
+{
+  MutexLocker lock(mutex_);
+  if ( batch_max_age_ > 0 )  hold_batch();
+  havemore_ = false;
+  flush_    = false;
+  bytes_    = 0;
+  FawkesNetworkMessageQueue *q = msgq_;
+  active_ = 1 - active_;
+  msgq_ = msgqs_[active_];
+  return q;
+}
+
+
+/** Stop holding back messages.
+ * A sending thread waiting in swap() returns immediately.
+ */
+void
+FawkesNetworkOutboundQueue::flush()
+{
+  MutexLocker lock(mutex_);
+  flush_ = true;
+  waitcond_->wake_all();
+}
+
+
+/** Enable or disable batching.
+ * @param max_size maximum size of a batch frame, 0 to disable batching
+ * @param max_age_usec maximum time in microseconds to hold back a message
+ * to fill a batch, 0 to only batch messages which are queued anyway
+ */
+void
+FawkesNetworkOutboundQueue::set_batching(size_t max_size, unsigned int max_age_usec)
+{
+  MutexLocker lock(mutex_);
+  msgqs_[0]->set_batching(max_size);
+  msgqs_[1]->set_batching(max_size);
+  batch_max_age_ = (max_size > 0) ? max_age_usec : 0;
+}
+
+
+/** Wait for more messages to fill a batch.
+ * Returns when the first queued message reached the maximum batch age,
+ * the batch is full, or a flush has been requested. The mutex must be
+ * locked.
+ */
+void
+FawkesNetworkOutboundQueue::hold_batch()
+{
+  Thread::CancelState old_cancel_state;
+  Thread::set_cancel_state(Thread::CANCEL_DISABLED, &old_cancel_state);
+  while ( ! msgq_->empty() && ! flush_ && (bytes_ < msgq_->batch_max_size()) ) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long int age_usec = (now.tv_sec - first_.tv_sec) * 1000000L +
+      (now.tv_nsec - first_.tv_nsec) / 1000;
+    if ( age_usec >= (long int)batch_max_age_ )  break;
+    long int wait_usec = batch_max_age_ - age_usec;
+    waitcond_->reltimed_wait(wait_usec / 1000000, (wait_usec % 1000000) * 1000);
+  }
+  Thread::set_cancel_state(old_cancel_state);
+}
+
+} // end namespace fawkes
@@ -0,0 +1,67 @@
+
+/***************************************************************************
+ *  outbound_queue.h - Fawkes network outbound message queue
+ *
+ *  Created: Sat Oct 17 00:21:45 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _NETCOMM_FAWKES_OUTBOUND_QUEUE_H_
+#define _NETCOMM_FAWKES_OUTBOUND_QUEUE_H_
+
+#include <cstddef>
+#include <ctime>
+
+namespace fawkes {
+
+class Mutex;
+class WaitCondition;
+class FawkesNetworkMessage;
+class FawkesNetworkMessageQueue;
+
+class FawkesNetworkOutboundQueue
+{
+ public:
+  FawkesNetworkOutboundQueue();
+  ~FawkesNetworkOutboundQueue();
+
+  void push(FawkesNetworkMessage *msg);
+  bool has_more();
+  FawkesNetworkMessageQueue * swap();
+  void flush();
+  void set_batching(size_t max_size, unsigned int max_age_usec);
+
+ private:
+  void hold_batch();
+
+ private:
+  Mutex                     *mutex_;
+  WaitCondition             *waitcond_;
+  unsigned int               active_;
+  bool                       havemore_;
+  bool                       flush_;
+  size_t                     bytes_;
+  struct timespec            first_;
+  unsigned int               batch_max_age_;
+  FawkesNetworkMessageQueue *msgq_;
+  FawkesNetworkMessageQueue *msgqs_[2];
+};
+
+} // end namespace fawkes
+
+#endif
@@ -0,0 +1,696 @@
+
+/***************************************************************************
+ *  reactor.cpp - Fawkes network I/O reactor
+ *
+ *  Created: Fri Oct 16 17:02:44 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <netcomm/fawkes/reactor.h>
+#include <netcomm/fawkes/message.h>
+#include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/buffer_pool.h>
+#include <netcomm/fawkes/batch.h>
+#include <netcomm/socket/stream.h>
+
+#include <core/threading/mutex.h>
+#include <core/threading/mutex_locker.h>
+#include <core/threading/wait_condition.h>
+#include <core/exception.h>
+#include <logging/liblogger.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <list>
+#include <vector>
+
+/** Maximum number of events handled per epoll_wait() call. */
+#define FNR_MAX_EVENTS  64
+/** Size of a single read from a socket. */
+#define FNR_READ_CHUNK  65536
+/** Maximum number of reads from one socket per event, for fairness. */
+#define FNR_MAX_READS   4
+/** Maximum number of buffers passed to a single sendmsg() call. */
+#define FNR_MAX_IOV     256
+
+namespace fawkes {
+
+/** @class FawkesNetworkReactorHandler <netcomm/fawkes/reactor.h>
+ * Handler for connections served by a FawkesNetworkReactor.
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Virtual empty destructor. */
+FawkesNetworkReactorHandler::~FawkesNetworkReactorHandler()
+{
+}
+
+
+/// @cond INTERNALS
+class FawkesNetworkReactor::Connection
+{
+ public:
+  Connection(unsigned int conn_id, int sock_fd, FawkesNetworkReactorHandler *h)
+  {
+    id         = conn_id;
+    fd         = sock_fd;
+    handler    = h;
+    alive      = true;
+    want_out   = false;
+    batch_max_size = 0;
+    in_length  = 0;
+    out_offset = 0;
+    inbuf.resize(FNR_READ_CHUNK);
+  }
+
+  ~Connection()
+  {
+    clear_outbound();
+  }
+
+  bool has_outbound() const
+  {
+    return ! outq.empty();
+  }
+
+  void clear_outbound()
+  {
+    for (std::list<FawkesNetworkMessage *>::iterator m = outq.begin(); m != outq.end(); ++m) {
+      (*m)->unref();
+    }
+    outq.clear();
+    out_offset = 0;
+  }
+
+  unsigned int                  id;
+  int                           fd;
+  FawkesNetworkReactorHandler  *handler;
+  bool                          alive;
+  bool                          want_out;
+  size_t                        batch_max_size;
+
+  std::vector<char>             inbuf;
+  size_t                        in_length;
+
+  std::list<FawkesNetworkMessage *>  outq;
+  size_t                        out_offset;
+  std::vector<struct iovec>     iov;
+};
+/// @endcond
+
+
+/** @class FawkesNetworkReactor <netcomm/fawkes/reactor.h>
+ * Fawkes network I/O reactor.
+ * The reactor multiplexes any number of Fawkes network protocol connections
+ * on a single thread using epoll. Sockets are switched to non-blocking mode,
+ * inbound data is assembled into messages which are passed to the handler
+ * of the connection, and outbound messages are written as the socket
+ * becomes writable. Outbound messages are written in place with gather
+ * writes, the progress into the first queued message is tracked. If
+ * batching is enabled for a connection, small messages queued at the
+ * time of writing are combined into batch frames. Received batch frames
+ * are always split into their messages. This replaces the pair of receive and send threads
+ * per connection.
+ *
+ * Handlers are called from the reactor thread without any internal lock
+ * held, they may therefore enqueue messages or remove connections.
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Constructor.
+ * @param name name of the reactor thread
+ * @param max_payload_size maximum payload size of a received message in
+ * bytes, connections announcing a larger message are closed
+ */
+FawkesNetworkReactor::FawkesNetworkReactor(const char *name, size_t max_payload_size)
+  : Thread(name, Thread::OPMODE_CONTINUOUS)
+{
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ == -1) {
+    throw Exception(errno, "FawkesNetworkReactor: failed to create epoll instance");
+  }
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ == -1) {
+    ::close(epoll_fd_);
+    throw Exception(errno, "FawkesNetworkReactor: failed to create event fd");
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events   = EPOLLIN;
+  ev.data.u32 = 0;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev) == -1) {
+    ::close(event_fd_);
+    ::close(epoll_fd_);
+    throw Exception(errno, "FawkesNetworkReactor: failed to watch event fd");
+  }
+
+  mutex_        = new Mutex();
+  waitcond_     = new WaitCondition(mutex_);
+  inbound_      = new FawkesNetworkMessageQueue();
+  next_conn_id_ = 1;
+  dispatching_  = 0;
+  max_payload_size_ = max_payload_size;
+
+  set_prepfin_conc_loop(true);
+}
+
+
+/** Destructor.
+ * The thread must have been stopped before. Connections which have not
+ * been removed are dropped, the sockets are not closed.
+ */
+FawkesNetworkReactor::~FawkesNetworkReactor()
+{
+  std::map<unsigned int, Connection *>::iterator c;
+  for (c = conns_.begin(); c != conns_.end(); ++c) {
+    delete c->second;
+  }
+  conns_.clear();
+  while (! inbound_->empty()) {
+    inbound_->front()->unref();
+    inbound_->pop();
+  }
+  delete inbound_;
+  delete waitcond_;
+  delete mutex_;
+  ::close(event_fd_);
+  ::close(epoll_fd_);
+}
+
+
+/** Add a connection.
+ * The socket is switched to non-blocking mode. It must not be used for
+ * reading or writing by anyone else while it is served by the reactor
+ * and must not be closed before the connection has been removed.
+ * @param s connected stream socket
+ * @param handler handler to call for events of the connection
+ * @return connection ID, never 0
+ * @exception Exception thrown if the socket cannot be monitored
+ */
+unsigned int
+FawkesNetworkReactor::add_connection(StreamSocket *s, FawkesNetworkReactorHandler *handler)
+{
+  int fd = s->fd();
+  if (fd == -1) {
+    throw Exception("FawkesNetworkReactor: cannot add unconnected socket");
+  }
+  int flags = fcntl(fd, F_GETFL);
+  if ((flags == -1) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+    throw Exception(errno, "FawkesNetworkReactor: failed to set socket non-blocking");
+  }
+
+  MutexLocker lock(mutex_);
+  unsigned int conn_id = next_conn_id_++;
+  if (next_conn_id_ == 0)  next_conn_id_ = 1;
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events   = EPOLLIN | EPOLLRDHUP;
+  ev.data.u32 = conn_id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    int err = errno;
+    // the socket remains owned by the caller, leave it as we found it
+    fcntl(fd, F_SETFL, flags);
+    throw Exception(err, "FawkesNetworkReactor: failed to watch socket");
+  }
+
+  conns_[conn_id] = new Connection(conn_id, fd, handler);
+  return conn_id;
+}
+
+
+/** Remove a connection.
+ * Pending outbound messages are dropped, use flush() before if required.
+ * If called from another thread than the reactor this waits until a
+ * currently running handler call for the connection has finished. After
+ * the method returns the handler is no longer called and the socket may
+ * be closed.
+ * @param conn_id ID of the connection to remove
+ */
+void
+FawkesNetworkReactor::remove_connection(unsigned int conn_id)
+{
+  MutexLocker lock(mutex_);
+  std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+  if (ci == conns_.end())  return;
+
+  Connection *c = ci->second;
+  if (c->alive) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c->fd, NULL);
+  }
+  conns_.erase(ci);
+  pending_out_.erase(conn_id);
+
+  if (Thread::current_thread_noexc() != this) {
+    while (dispatching_ == conn_id) {
+      waitcond_->wait();
+    }
+  }
+  delete c;
+}
+
+
+/** Check if connection is alive.
+ * @param conn_id ID of the connection to check
+ * @return true if the connection exists and has not died, false otherwise
+ */
+bool
+FawkesNetworkReactor::alive(unsigned int conn_id)
+{
+  MutexLocker lock(mutex_);
+  std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+  return (ci != conns_.end()) && ci->second->alive;
+}
+
+
+/** Enable or disable batching for a connection.
+ * Only enable batching if the peer announced TRANSPORT_FEATURE_BATCH.
+ * @param conn_id ID of the connection
+ * @param max_size maximum size of the payload of a batch frame in bytes,
+ * 0 to disable batching
+ */
+void
+FawkesNetworkReactor::set_batching(unsigned int conn_id, size_t max_size)
+{
+  MutexLocker lock(mutex_);
+  std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+  if (ci != conns_.end()) {
+    ci->second->batch_max_size = max_size;
+  }
+}
+
+
+/** Get number of connections.
+ * @return number of connections currently served, including dead ones
+ * which have not been removed, yet
+ */
+unsigned int
+FawkesNetworkReactor::num_connections()
+{
+  MutexLocker lock(mutex_);
+  return conns_.size();
+}
+
+
+/** Enqueue message to send.
+ * This method takes ownership of the message. If you want to use the message
+ * after enqueuing you must reference it explicitly. Messages enqueued for
+ * a dead or unknown connection are silently dropped.
+ * @param conn_id ID of the connection to send the message over
+ * @param msg message to send
+ */
+void
+FawkesNetworkReactor::enqueue(unsigned int conn_id, FawkesNetworkMessage *msg)
+{
+  MutexLocker lock(mutex_);
+  std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+  if ((ci == conns_.end()) || ! ci->second->alive) {
+    lock.unlock();
+    msg->unref();
+    return;
+  }
+
+  ci->second->outq.push_back(msg);
+  // if waiting for the socket to become writable the message is sent then,
+  // otherwise the reactor thread needs to be notified once
+  if (! ci->second->want_out) {
+    bool notify = pending_out_.empty();
+    pending_out_.insert(conn_id);
+    if (notify)  notify_loop();
+  }
+}
+
+
+/** Wait until all enqueued messages have been sent.
+ * Returns early if the connection dies. If called from the reactor thread,
+ * e.g. from within a handler, this does not wait, the messages are sent
+ * when the handler returns.
+ * @param conn_id ID of the connection to flush
+ * @param timeout_ms maximum time to wait in milliseconds
+ */
+void
+FawkesNetworkReactor::flush(unsigned int conn_id, unsigned int timeout_ms)
+{
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec  += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec  += 1;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  bool in_reactor = (Thread::current_thread_noexc() == this);
+
+  MutexLocker lock(mutex_);
+  forever {
+    std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+    if ((ci == conns_.end()) || ! ci->second->alive || ! ci->second->has_outbound()) {
+      return;
+    }
+    if (! ci->second->want_out) {
+      bool notify = pending_out_.empty();
+      pending_out_.insert(conn_id);
+      if (notify)  notify_loop();
+    }
+    if (in_reactor)  return;
+    if (! waitcond_->abstimed_wait(deadline.tv_sec, deadline.tv_nsec))  return;
+  }
+}
+
+
+/** Reactor loop.
+ * Waits for events on any of the sockets, receives and dispatches inbound
+ * messages, and sends pending outbound messages.
+ */
+void
+FawkesNetworkReactor::loop()
+{
+  struct epoll_event events[FNR_MAX_EVENTS];
+  int num_events = epoll_wait(epoll_fd_, events, FNR_MAX_EVENTS, -1);
+  if (num_events == -1)  return;
+
+  CancelState old_cancel_state;
+  set_cancel_state(CANCEL_DISABLED, &old_cancel_state);
+
+  for (int i = 0; i < num_events; ++i) {
+    unsigned int conn_id = events[i].data.u32;
+    if (conn_id == 0) {
+      uint64_t v;
+      if (::read(event_fd_, &v, sizeof(v)) == -1) {} // only reset counter
+      continue;
+    }
+
+    bool died = false;
+    mutex_->lock();
+    std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+    if ((ci == conns_.end()) || ! ci->second->alive) {
+      mutex_->unlock();
+      continue;
+    }
+    if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+      died = ! read_connection(ci->second, inbound_);
+    }
+    if (! died && (events[i].events & EPOLLOUT)) {
+      died = ! write_connection(ci->second);
+    }
+    if (died)  connection_failed(ci->second);
+    mutex_->unlock();
+
+    dispatch(conn_id, inbound_, died);
+  }
+
+  // send messages which have been enqueued since the last iteration
+  std::list<unsigned int> failed;
+  mutex_->lock();
+  std::set<unsigned int> pending;
+  pending.swap(pending_out_);
+  for (std::set<unsigned int>::iterator p = pending.begin(); p != pending.end(); ++p) {
+    std::map<unsigned int, Connection *>::iterator ci = conns_.find(*p);
+    if ((ci != conns_.end()) && ci->second->alive && ! write_connection(ci->second)) {
+      connection_failed(ci->second);
+      failed.push_back(*p);
+    }
+  }
+  mutex_->unlock();
+
+  for (std::list<unsigned int>::iterator f = failed.begin(); f != failed.end(); ++f) {
+    dispatch(*f, NULL, true);
+  }
+
+  set_cancel_state(old_cancel_state);
+}
+
+
+/** Notify the reactor thread to wake up from epoll_wait(). */
+void
+FawkesNetworkReactor::notify_loop()
+{
+  uint64_t v = 1;
+  if (::write(event_fd_, &v, sizeof(v)) == -1) {} // counter overflow only
+}
+
+
+/** Read from connection and assemble messages.
+ * The input buffer holds at most one incomplete message of the maximum
+ * payload size plus one read chunk. Remaining data stays in the socket
+ * until the buffered messages have been assembled. A message header
+ * announcing a payload beyond the maximum kills the connection.
+ * The mutex must be held when calling this method.
+ * @param c connection to read from
+ * @param msgq queue to push complete messages to
+ * @return false if the connection died, true otherwise
+ */
+bool
+FawkesNetworkReactor::read_connection(Connection *c, FawkesNetworkMessageQueue *msgq)
+{
+  const size_t hsize = sizeof(fawkes_message_header_t);
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  bool alive = true;
+
+  for (unsigned int r = 0; r < FNR_MAX_READS; ++r) {
+    if (c->in_length >= hsize + max_payload_size_)  break;
+    if (c->inbuf.size() - c->in_length < FNR_READ_CHUNK) {
+      c->inbuf.resize(c->in_length + FNR_READ_CHUNK);
+    }
+    ssize_t bytes = ::recv(c->fd, &c->inbuf[c->in_length], c->inbuf.size() - c->in_length, 0);
+    if (bytes == 0) {
+      alive = false;
+      break;
+    } else if (bytes == -1) {
+      if (errno == EINTR)  continue;
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK))  alive = false;
+      break;
+    }
+    c->in_length += bytes;
+    if ((size_t)bytes < FNR_READ_CHUNK)  break;
+  }
+
+  // assemble complete messages
+  size_t pos = 0;
+  while (c->in_length - pos >= hsize) {
+    fawkes_message_t msg;
+    memcpy(&msg.header, &c->inbuf[pos], hsize);
+    size_t payload_size = ntohl(msg.header.payload_size);
+    if (payload_size > max_payload_size_) {
+      alive = false;
+      break;
+    }
+    if (c->in_length - pos - hsize < payload_size)  break;
+
+    msg.payload = NULL;
+    FawkesNetworkMessage *m = new FawkesNetworkMessage(msg);
+    if (payload_size > 0) {
+      m->set_pooled_payload(pool->alloc(payload_size), payload_size);
+      memcpy(m->payload(), &c->inbuf[pos + hsize], payload_size);
+    }
+    pos += hsize + payload_size;
+    if (FawkesNetworkMessageBatch::is_batch(m)) {
+      try {
+	FawkesNetworkMessageBatch::unpack(m, msgq);
+      } catch (Exception &e) {
+	alive = false;
+      }
+      m->unref();
+      if (! alive)  break;
+    } else {
+      msgq->push(m);
+    }
+  }
+  if (pos > 0) {
+    memmove(&c->inbuf[0], &c->inbuf[pos], c->in_length - pos);
+    c->in_length -= pos;
+  }
+  if ((c->in_length == 0) && (c->inbuf.size() > 4 * FNR_READ_CHUNK)) {
+    // release memory after a very large message
+    std::vector<char>(FNR_READ_CHUNK).swap(c->inbuf);
+  }
+
+  return alive;
+}
+
+
+/** Write pending messages to connection.
+ * Writes until all messages have been sent or the socket would block, in
+ * the latter case the reactor waits for the socket to become writable.
+ * The mutex must be held when calling this method.
+ * @param c connection to write to
+ * @return false if the connection died, true otherwise
+ */
+bool
+FawkesNetworkReactor::write_connection(Connection *c)
+{
+  const size_t hsize = sizeof(fawkes_message_header_t);
+
+  if ((c->batch_max_size > 0) && ! c->outq.empty()) {
+    // the first message is kept as is if it has been sent partially
+    std::list<FawkesNetworkMessage *>::iterator first = c->outq.begin();
+    if (c->out_offset > 0)  ++first;
+    FawkesNetworkMessageBatch::coalesce(c->outq, first, c->batch_max_size);
+  }
+
+  while (! c->outq.empty()) {
+    // gather headers and payloads of queued messages in place
+    c->iov.clear();
+    std::list<FawkesNetworkMessage *>::iterator m;
+    for (m = c->outq.begin(); (m != c->outq.end()) && (c->iov.size() < FNR_MAX_IOV); ++m) {
+      (*m)->pack();
+      struct iovec header;
+      header.iov_base = (void *)&((*m)->fmsg().header);
+      header.iov_len  = hsize;
+      c->iov.push_back(header);
+      (*m)->payload_segments(c->iov);
+    }
+
+    // skip what has already been sent of the first message
+    size_t first = 0, skip = c->out_offset;
+    while (skip >= c->iov[first].iov_len) {
+      skip -= c->iov[first++].iov_len;
+    }
+    c->iov[first].iov_base = (char *)c->iov[first].iov_base + skip;
+    c->iov[first].iov_len -= skip;
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov    = &c->iov[first];
+    mh.msg_iovlen = std::min(c->iov.size() - first, (size_t)IOV_MAX);
+    ssize_t bytes = ::sendmsg(c->fd, &mh, MSG_NOSIGNAL);
+    if (bytes == -1) {
+      if (errno == EINTR)  continue;
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))  break;
+      return false;
+    }
+
+    // release messages which have been sent completely
+    size_t sent = c->out_offset + bytes;
+    while (! c->outq.empty()) {
+      size_t msg_size = hsize + c->outq.front()->payload_size();
+      if (sent < msg_size)  break;
+      sent -= msg_size;
+      c->outq.front()->unref();
+      c->outq.pop_front();
+    }
+    c->out_offset = sent;
+  }
+
+  update_events(c);
+  if (! c->has_outbound())  waitcond_->wake_all();
+  return true;
+}
+
+
+/** Update the events the reactor waits for on a connection.
+ * Writability is only monitored while there is data which could not be
+ * written immediately. The mutex must be held when calling this method.
+ * @param c connection to update
+ */
+void
+FawkesNetworkReactor::update_events(Connection *c)
+{
+  bool want_out = c->has_outbound();
+  if (want_out == c->want_out)  return;
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events   = EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0);
+  ev.data.u32 = c->id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c->fd, &ev) == 0) {
+    c->want_out = want_out;
+  }
+}
+
+
+/** Mark connection as dead.
+ * Stops monitoring the socket and drops pending outbound messages.
+ * The mutex must be held when calling this method.
+ * @param c connection that failed
+ */
+void
+FawkesNetworkReactor::connection_failed(Connection *c)
+{
+  c->alive = false;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c->fd, NULL);
+  c->clear_outbound();
+  waitcond_->wake_all();
+}
+
+
+/** Pass events to the handler of a connection.
+ * Messages left in the queue afterwards are dropped.
+ * @param conn_id ID of the connection the events belong to
+ * @param msgq queue of received messages, may be NULL
+ * @param died true to notify the handler that the connection died
+ */
+void
+FawkesNetworkReactor::dispatch(unsigned int conn_id, FawkesNetworkMessageQueue *msgq, bool died)
+{
+  if (((msgq == NULL) || msgq->empty()) && ! died)  return;
+
+  mutex_->lock();
+  std::map<unsigned int, Connection *>::iterator ci = conns_.find(conn_id);
+  FawkesNetworkReactorHandler *handler = NULL;
+  if (ci != conns_.end()) {
+    handler = ci->second->handler;
+    dispatching_ = conn_id;
+  }
+  mutex_->unlock();
+
+  if (handler) {
+    try {
+      if (msgq && ! msgq->empty())  handler->reactor_inbound(conn_id, msgq);
+      if (died)  handler->reactor_connection_died(conn_id);
+    } catch (Exception &e) {
+      // a handler must not bring down the reactor for all other connections
+      LibLogger::log_error(name(), "Handler of connection %u failed, exception follows",
+			   conn_id);
+      LibLogger::log_error(name(), e);
+    } catch (std::exception &e) {
+      LibLogger::log_error(name(), "Handler of connection %u failed: %s",
+			   conn_id, e.what());
+    }
+
+    mutex_->lock();
+    dispatching_ = 0;
+    waitcond_->wake_all();
+    mutex_->unlock();
+  }
+
+  if (msgq) {
+    while (! msgq->empty()) {
+      msgq->front()->unref();
+      msgq->pop();
+    }
+  }
+}
+
+} // end namespace fawkes
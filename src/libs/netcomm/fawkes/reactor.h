@@ -0,0 +1,111 @@
+
+/***************************************************************************
+ *  reactor.h - Fawkes network I/O reactor
+ *
+ *  Created: Fri Oct 16 17:02:44 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _NETCOMM_FAWKES_REACTOR_H_
+#define _NETCOMM_FAWKES_REACTOR_H_
+
+#include <core/threading/thread.h>
+#include <netcomm/fawkes/message.h>
+
+#include <map>
+#include <set>
+
+namespace fawkes {
+
+class StreamSocket;
+class Mutex;
+class WaitCondition;
+class FawkesNetworkMessage;
+class FawkesNetworkMessageQueue;
+
+class FawkesNetworkReactorHandler
+{
+ public:
+  virtual ~FawkesNetworkReactorHandler();
+
+  /** Messages have been received.
+   * Called from the reactor thread. The handler shall pop all messages from
+   * the queue and unref them, messages left in the queue after the call are
+   * unref'd by the reactor.
+   * @param conn_id ID of the connection the messages were received from
+   * @param msgq queue of received messages in the order of arrival
+   */
+  virtual void reactor_inbound(unsigned int conn_id, FawkesNetworkMessageQueue *msgq) = 0;
+
+  /** Connection died.
+   * Called from the reactor thread once for a connection if the remote side
+   * closed the connection or an error occured. The connection must still be
+   * removed with FawkesNetworkReactor::remove_connection().
+   * @param conn_id ID of the connection that died
+   */
+  virtual void reactor_connection_died(unsigned int conn_id) = 0;
+};
+
+
+class FawkesNetworkReactor : public Thread
+{
+ public:
+  FawkesNetworkReactor(const char *name = "FawkesNetworkReactor",
+		       size_t max_payload_size = FAWKES_NET_MAX_PAYLOAD_SIZE);
+  virtual ~FawkesNetworkReactor();
+
+  unsigned int add_connection(StreamSocket *s, FawkesNetworkReactorHandler *handler);
+  void         remove_connection(unsigned int conn_id);
+  bool         alive(unsigned int conn_id);
+  void         enqueue(unsigned int conn_id, FawkesNetworkMessage *msg);
+  void         flush(unsigned int conn_id, unsigned int timeout_ms = 1000);
+  void         set_batching(unsigned int conn_id, size_t max_size);
+  unsigned int num_connections();
+
+  virtual void loop();
+
+ /** Stub to see name in backtrace for easier debugging. @see Thread::run() */
+ protected: virtual void run() { Thread::run(); }
+
+ private:
+  class Connection;
+
+  void notify_loop();
+  bool read_connection(Connection *c, FawkesNetworkMessageQueue *msgq);
+  bool write_connection(Connection *c);
+  void update_events(Connection *c);
+  void connection_failed(Connection *c);
+  void dispatch(unsigned int conn_id, FawkesNetworkMessageQueue *msgq, bool died);
+
+ private:
+  int                         epoll_fd_;
+  int                         event_fd_;
+  Mutex                      *mutex_;
+  WaitCondition              *waitcond_;
+  FawkesNetworkMessageQueue  *inbound_;
+  unsigned int                next_conn_id_;
+  unsigned int                dispatching_;
+  size_t                      max_payload_size_;
+
+  std::map<unsigned int, Connection *>  conns_;
+  std::set<unsigned int>                pending_out_;
+};
+
+} // end namespace fawkes
+
+#endif
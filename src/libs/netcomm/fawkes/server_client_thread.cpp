@@ -26,11 +26,12 @@
 #include <netcomm/fawkes/server_client_thread.h>
 #include <netcomm/fawkes/server_thread.h>
 #include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/outbound_queue.h>
 #include <netcomm/fawkes/transceiver.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
 #include <netcomm/socket/stream.h>
 #include <netcomm/utils/exceptions.h>
-#include <core/threading/mutex.h>
-#include <core/threading/wait_condition.h>
 
 #include <unistd.h>
 
@@ -39,7 +40,8 @@ namespace fawkes {
 /** @class FawkesNetworkServerClientSendThread <netcomm/fawkes/server_client_thread.h>
  * Sending thread for a Fawkes client connected to the server.
  * This thread is spawned for each client connected to the server to handle the
- * server-side sending
+ * server-side sending. If batching has been negotiated, messages may be
+ * held back for a short time to send them in a single batch frame.
  * @ingroup NetComm
  * @author Tim Niemueller
  */
@@ -58,40 +60,21 @@ class FawkesNetworkServerClientSendThread
   {
     s_ = s;
     parent_ = parent;
-    outbound_mutex_    = new Mutex();
-    outbound_msgqs_[0] = new FawkesNetworkMessageQueue();
-    outbound_msgqs_[1] = new FawkesNetworkMessageQueue();
-    outbound_active_   = 0;
-    outbound_msgq_     = outbound_msgqs_[0];
+    outbound_ = new FawkesNetworkOutboundQueue();
   }
 
   /** Destructor. */
   ~FawkesNetworkServerClientSendThread()
   {
-    for (unsigned int i = 0; i < 2; ++i) {
-      while ( ! outbound_msgqs_[i]->empty() ) {
-	FawkesNetworkMessage *m = outbound_msgqs_[i]->front();
-	m->unref();
-	outbound_msgqs_[i]->pop();
-      }
-    }
-    delete outbound_msgqs_[0];
-    delete outbound_msgqs_[1];
-    delete outbound_mutex_;
+    delete outbound_;
   }
 
   virtual void loop()
   {
     if ( ! parent_->alive() )  return;
 
-    while ( outbound_havemore_ ) {
-      outbound_mutex_->lock();
-      outbound_havemore_ = false;
-      FawkesNetworkMessageQueue *q = outbound_msgq_;
-      outbound_active_ = 1 - outbound_active_;
-      outbound_msgq_ = outbound_msgqs_[outbound_active_];
-      outbound_mutex_->unlock();
-
+    while ( outbound_->has_more() ) {
+      FawkesNetworkMessageQueue *q = outbound_->swap();
       if ( ! q->empty() ) {
 	try {
 	  FawkesNetworkTransceiver::send(s_, q);
@@ -113,17 +96,26 @@ class FawkesNetworkServerClientSendThread
    */
   void enqueue(FawkesNetworkMessage *msg)
   {
-    outbound_mutex_->lock();
-    outbound_msgq_->push(msg);
-    outbound_havemore_ = true;
-    outbound_mutex_->unlock();
+    outbound_->push(msg);
     wakeup();
   }
 
 
+  /** Enable or disable batching.
+   * @param max_size maximum size of a batch frame, 0 to disable batching
+   * @param max_age_usec maximum time in microseconds to hold back a message
+   * to fill a batch, 0 to only batch messages which are queued anyway
+   */
+  void set_batching(size_t max_size, unsigned int max_age_usec)
+  {
+    outbound_->set_batching(max_size, max_age_usec);
+  }
+
+
   /** Wait until all data has been sent. */
   void wait_for_all_sent()
   {
+    outbound_->flush();
     loop_mutex->lock();
     loop_mutex->unlock();
   }
@@ -134,13 +126,7 @@ class FawkesNetworkServerClientSendThread
  private:
   StreamSocket                    *s_;
   FawkesNetworkServerClientThread *parent_;
-
-  Mutex                     *outbound_mutex_;
-  unsigned int               outbound_active_;
-  bool                       outbound_havemore_;
-  FawkesNetworkMessageQueue *outbound_msgq_;
-  FawkesNetworkMessageQueue *outbound_msgqs_[2];
-
+  FawkesNetworkOutboundQueue      *outbound_;
 };
 
 
@@ -221,8 +207,12 @@ FawkesNetworkServerClientThread::recv()
     _inbound_queue->lock();
     while ( ! _inbound_queue->empty() ) {
       FawkesNetworkMessage *m = _inbound_queue->front();
-      m->set_client_id(_clid);
-      _parent->dispatch(m);
+      if ( m->cid() == FAWKES_CID_TRANSPORT ) {
+	handle_transport(m);
+      } else {
+	m->set_client_id(_clid);
+	_parent->dispatch(m);
+      }
       m->unref();
       _inbound_queue->pop();
     }
@@ -237,6 +227,26 @@ FawkesNetworkServerClientThread::recv()
 }
 
 
+/** Handle transport message.
+ * Answers a feature request with the supported features and enables
+ * batching if the client can decode batch frames.
+ * @param msg transport message received from the client
+ */
+void
+FawkesNetworkServerClientThread::handle_transport(FawkesNetworkMessage *msg)
+{
+  uint32_t features;
+  FawkesNetworkMessage *reply =
+    FawkesNetworkTransport::answer_features_request(msg, _clid, features);
+  if ( ! reply )  return;
+  enqueue(reply);
+
+  if ( features & TRANSPORT_FEATURE_BATCH ) {
+    _send_slave->set_batching(_parent->batch_max_size(), _parent->batch_max_age());
+  }
+}
+
+
 void
 FawkesNetworkServerClientThread::once()
 {
@@ -60,6 +60,7 @@ class FawkesNetworkServerClientThread : public Thread
 
  private:
   void recv();
+  void handle_transport(FawkesNetworkMessage *msg);
 
   unsigned int                _clid;
   bool                        _alive;
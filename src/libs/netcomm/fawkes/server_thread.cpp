@@ -23,25 +23,190 @@
 
 #include <netcomm/fawkes/server_thread.h>
 #include <netcomm/fawkes/server_client_thread.h>
+#include <netcomm/fawkes/reactor.h>
 #include <netcomm/utils/acceptor_thread.h>
 #include <netcomm/fawkes/message.h>
 #include <netcomm/fawkes/handler.h>
 #include <netcomm/fawkes/message_queue.h>
 #include <netcomm/fawkes/message_content.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
+#include <netcomm/socket/stream.h>
 #include <core/threading/thread_collector.h>
 #include <core/threading/mutex.h>
 #include <core/threading/mutex_locker.h>
 #include <core/exception.h>
 
 #include <unistd.h>
+#include <atomic>
+#include <cstdio>
 
 namespace fawkes {
 
+/// @cond INTERNALS
+/** Client of the server served by a FawkesNetworkReactor.
+ * Counterpart of FawkesNetworkServerClientThread for the reactor mode.
+ */
+class FawkesNetworkServerReactorClient : public FawkesNetworkReactorHandler
+{
+ public:
+  FawkesNetworkServerReactorClient(unsigned int clid, StreamSocket *s,
+				   FawkesNetworkReactor *reactor,
+				   FawkesNetworkServerThread *parent)
+  {
+    clid_    = clid;
+    s_       = s;
+    reactor_ = reactor;
+    parent_  = parent;
+    alive_   = true;
+    conn_id_ = reactor_->add_connection(s_, this);
+  }
+
+  ~FawkesNetworkServerReactorClient()
+  {
+    reactor_->remove_connection(conn_id_);
+    // closing the socket is a cancellation point, must not unwind a destructor
+    Thread::CancelState old_cancel_state;
+    Thread::set_cancel_state(Thread::CANCEL_DISABLED, &old_cancel_state);
+    delete s_;
+    Thread::set_cancel_state(old_cancel_state);
+  }
+
+  bool alive() const
+  {
+    return alive_;
+  }
+
+  void enqueue(FawkesNetworkMessage *msg)
+  {
+    reactor_->enqueue(conn_id_, msg);
+  }
+
+  void force_send()
+  {
+    reactor_->flush(conn_id_);
+  }
+
+  virtual void reactor_inbound(unsigned int conn_id, FawkesNetworkMessageQueue *msgq)
+  {
+    while ( ! msgq->empty() ) {
+      FawkesNetworkMessage *m = msgq->front();
+      if ( m->cid() == FAWKES_CID_TRANSPORT ) {
+	handle_transport(m);
+      } else {
+	m->set_client_id(clid_);
+	parent_->dispatch(m);
+      }
+      m->unref();
+      msgq->pop();
+    }
+    parent_->wakeup();
+  }
+
+  virtual void reactor_connection_died(unsigned int conn_id)
+  {
+    alive_ = false;
+    parent_->wakeup();
+  }
+
+ private:
+  void handle_transport(FawkesNetworkMessage *m)
+  {
+    uint32_t features;
+    FawkesNetworkMessage *reply =
+      FawkesNetworkTransport::answer_features_request(m, clid_, features);
+    if ( ! reply )  return;
+    enqueue(reply);
+
+    if ( features & TRANSPORT_FEATURE_BATCH ) {
+      reactor_->set_batching(conn_id_, parent_->batch_max_size());
+    }
+  }
+
+ private:
+  unsigned int               clid_;
+  unsigned int               conn_id_;
+  std::atomic<bool>          alive_;
+  StreamSocket              *s_;
+  FawkesNetworkReactor      *reactor_;
+  FawkesNetworkServerThread *parent_;
+};
+
+
+// Helpers for both client maps, clients served by their own threads and
+// clients served by a reactor provide the same operations.
+
+template <class Client>
+static void
+collect_dead_clients(LockMap<unsigned int, Client *> &clients,
+		     std::list<unsigned int> &dead_clients)
+{
+  MutexLocker lock(clients.mutex());
+  typename LockMap<unsigned int, Client *>::iterator c;
+  for (c = clients.begin(); c != clients.end(); ++c) {
+    if ( ! c->second->alive() ) {
+      dead_clients.push_back(c->first);
+    }
+  }
+}
+
+template <class Client>
+static void
+force_send_clients(LockMap<unsigned int, Client *> &clients)
+{
+  MutexLocker lock(clients.mutex());
+  typename LockMap<unsigned int, Client *>::iterator c;
+  for (c = clients.begin(); c != clients.end(); ++c) {
+    c->second->force_send();
+  }
+}
+
+template <class Client>
+static void
+broadcast_clients(LockMap<unsigned int, Client *> &clients, FawkesNetworkMessage *msg)
+{
+  MutexLocker lock(clients.mutex());
+  typename LockMap<unsigned int, Client *>::iterator c;
+  for (c = clients.begin(); c != clients.end(); ++c) {
+    if ( c->second->alive() ) {
+      msg->ref();
+      c->second->enqueue(msg);
+    }
+  }
+}
+
+template <class Client>
+static void
+send_client(LockMap<unsigned int, Client *> &clients, FawkesNetworkMessage *msg)
+{
+  unsigned int clid = msg->clid();
+  MutexLocker lock(clients.mutex());
+  typename LockMap<unsigned int, Client *>::iterator c = clients.find(clid);
+  if ( c == clients.end() ) {
+    throw Exception("Client %u not found", clid);
+  } else if ( ! c->second->alive() ) {
+    throw Exception("Client %u not alive", clid);
+  }
+  c->second->enqueue(msg);
+}
+/// @endcond
+
+
 /** @class FawkesNetworkServerThread <netcomm/fawkes/server_thread.h>
  * Fawkes Network Thread.
  * Maintains a list of clients and reacts on events triggered by the clients.
  * Also runs the acceptor thread.
  *
+ * By default every client is handled by two threads, one for receiving
+ * and one for sending. Alternatively, a number of I/O threads can be
+ * given, each being a FawkesNetworkReactor which multiplexes connections
+ * using epoll. New clients are assigned to the reactor serving the
+ * fewest connections. The FawkesNetworkHandler interface is the same in
+ * both modes, handlers are still called from this thread.
+ *
+ * Clients which announce TRANSPORT_FEATURE_BATCH on connect get small
+ * messages sent in batch frames, see set_batching().
+ *
  * @ingroup NetComm
  * @author Tim Niemueller
  */
@@ -55,18 +220,34 @@ namespace fawkes {
  * :: to listen on any local address
  * @param fawkes_port port for Fawkes network protocol
  * @param thread_collector thread collector to register new threads with
+ * @param num_io_threads number of reactor threads to serve all clients,
+ * 0 to use a receiving and sending thread per client
  */
 FawkesNetworkServerThread::FawkesNetworkServerThread(bool enable_ipv4, bool enable_ipv6,
                                                      const std::string &listen_ipv4, const std::string &listen_ipv6,
                                                      unsigned int fawkes_port,
-                                                     ThreadCollector *thread_collector)
+                                                     ThreadCollector *thread_collector,
+                                                     unsigned int num_io_threads)
   : Thread("FawkesNetworkServerThread", Thread::OPMODE_WAITFORWAKEUP)
 {
   this->thread_collector = thread_collector;
   clients.clear();
   next_client_id = 1;
+  batch_max_size_ = FAWKES_NETWORK_BATCH_MAX_SIZE;
+  batch_max_age_  = 0;
   inbound_messages = new FawkesNetworkMessageQueue();
 
+  for (unsigned int i = 0; i < num_io_threads; ++i) {
+	  char tmp[32];
+	  snprintf(tmp, sizeof(tmp), "FawkesNetworkReactor %u", i);
+	  reactors_.push_back(new FawkesNetworkReactor(tmp));
+	  if ( thread_collector ) {
+		  thread_collector->add(reactors_.back());
+	  } else {
+		  reactors_.back()->start();
+	  }
+  }
+
   if (enable_ipv4) {
 	  acceptor_threads.push_back(new NetworkAcceptorThread(this, Socket::IPv4, listen_ipv4, fawkes_port,
 	                                                       "FawkesNetworkAcceptorThread"));
@@ -100,6 +281,11 @@ FawkesNetworkServerThread::~FawkesNetworkServerThread()
     }
     delete (*cit).second;
   }
+  LockMap<unsigned int, FawkesNetworkServerReactorClient *>::iterator rcit;
+  for (rcit = reactor_clients_.begin(); rcit != reactor_clients_.end(); ++rcit) {
+    delete rcit->second;
+  }
+  reactor_clients_.clear();
   for (size_t i = 0; i < acceptor_threads.size(); ++i) {
 	  if ( thread_collector ) {
 		  thread_collector->remove(acceptor_threads[i]);
@@ -110,6 +296,16 @@ FawkesNetworkServerThread::~FawkesNetworkServerThread()
 	  delete acceptor_threads[i];
   }
   acceptor_threads.clear();
+  for (size_t i = 0; i < reactors_.size(); ++i) {
+	  if ( thread_collector ) {
+		  thread_collector->remove(reactors_[i]);
+	  } else {
+		  reactors_[i]->cancel();
+		  reactors_[i]->join();
+	  }
+	  delete reactors_[i];
+  }
+  reactors_.clear();
 
   delete inbound_messages;
 }
@@ -122,6 +318,41 @@ FawkesNetworkServerThread::~FawkesNetworkServerThread()
 void
 FawkesNetworkServerThread::add_connection(StreamSocket *s) throw()
 {
+  if ( ! reactors_.empty() ) {
+    // serve by the reactor with the fewest connections
+    FawkesNetworkReactor *reactor = reactors_[0];
+    unsigned int min_conns = reactor->num_connections();
+    for (size_t i = 1; i < reactors_.size(); ++i) {
+      unsigned int num_conns = reactors_[i]->num_connections();
+      if ( num_conns < min_conns ) {
+	reactor   = reactors_[i];
+	min_conns = num_conns;
+      }
+    }
+
+    reactor_clients_.lock();
+    unsigned int cid = next_client_id;
+    try {
+      reactor_clients_[cid] = new FawkesNetworkServerReactorClient(cid, s, reactor, this);
+    } catch (Exception &e) {
+      reactor_clients_.erase(cid);
+      reactor_clients_.unlock();
+      delete s;
+      return;
+    }
+    ++next_client_id;
+    reactor_clients_.unlock();
+
+    MutexLocker handlers_lock(handlers.mutex());
+    for (hit = handlers.begin(); hit != handlers.end(); ++hit) {
+      (*hit).second->client_connected(cid);
+    }
+    handlers_lock.unlock();
+
+    wakeup();
+    return;
+  }
+
   FawkesNetworkServerClientThread *client = new FawkesNetworkServerClientThread(s, this);
 
   clients.lock();
@@ -181,15 +412,10 @@ FawkesNetworkServerThread::remove_handler(FawkesNetworkHandler *handler)
 void
 FawkesNetworkServerThread::loop()
 {
-  std::list<unsigned int> dead_clients;
-  clients.lock();
   // check for dead clients
-  for (cit = clients.begin(); cit != clients.end(); ++cit) {
-    if ( ! cit->second->alive() ) {
-	    dead_clients.push_back(cit->first);
-    }
-  }
-  clients.unlock();
+  std::list<unsigned int> dead_clients;
+  collect_dead_clients(clients, dead_clients);
+  collect_dead_clients(reactor_clients_, dead_clients);
 
   std::list<unsigned int>::iterator dci;
   for (dci = dead_clients.begin(); dci != dead_clients.end(); ++dci) {
@@ -204,15 +430,25 @@ FawkesNetworkServerThread::loop()
 
 	  {
 		  MutexLocker clients_lock(clients.mutex());
-		  if ( thread_collector ) {
-			  thread_collector->remove(clients[clid]);
-		  } else {
-			  clients[clid]->cancel();
-			  clients[clid]->join();
+		  if ( clients.find(clid) != clients.end() ) {
+			  if ( thread_collector ) {
+				  thread_collector->remove(clients[clid]);
+			  } else {
+				  clients[clid]->cancel();
+				  clients[clid]->join();
+			  }
+			  usleep(5000);
+			  delete clients[clid];
+			  clients.erase(clid);
+		  }
+	  }
+
+	  {
+		  MutexLocker clients_lock(reactor_clients_.mutex());
+		  if ( reactor_clients_.find(clid) != reactor_clients_.end() ) {
+			  delete reactor_clients_[clid];
+			  reactor_clients_.erase(clid);
 		  }
-		  usleep(5000);
-		  delete clients[clid];
-      clients.erase(clid);
 	  }
   }
 
@@ -233,15 +469,50 @@ FawkesNetworkServerThread::loop()
 }
 
 
+/** Set batching parameters.
+ * Applies to clients which negotiate batching afterwards. Small messages
+ * queued for a client are then combined into batch frames of up to the
+ * given size. With a maximum age, messages are held back for at most that
+ * time to fill a batch, which trades latency for fewer frames. Clients
+ * served by a reactor only batch messages which are queued anyway.
+ * @param max_size maximum size of a batch frame in bytes, 0 to disable
+ * batching
+ * @param max_age_usec maximum time in microseconds to hold back messages
+ */
+void
+FawkesNetworkServerThread::set_batching(size_t max_size, unsigned int max_age_usec)
+{
+  batch_max_size_ = max_size;
+  batch_max_age_  = max_age_usec;
+}
+
+
+/** Get maximum batch size.
+ * @return maximum size of a batch frame in bytes, 0 if batching is disabled
+ */
+size_t
+FawkesNetworkServerThread::batch_max_size() const
+{
+  return batch_max_size_;
+}
+
+
+/** Get maximum batch age.
+ * @return maximum time in microseconds messages are held back to fill a batch
+ */
+unsigned int
+FawkesNetworkServerThread::batch_max_age() const
+{
+  return batch_max_age_;
+}
+
+
 /** Force sending of all pending messages. */
 void
 FawkesNetworkServerThread::force_send()
 {
-  clients.lock();
-  for (cit = clients.begin(); cit != clients.end(); ++cit) {
-    (*cit).second->force_send();
-  }
-  clients.unlock();
+  force_send_clients(clients);
+  force_send_clients(reactor_clients_);
 }
 
 
@@ -254,14 +525,10 @@ FawkesNetworkServerThread::force_send()
 void
 FawkesNetworkServerThread::broadcast(FawkesNetworkMessage *msg)
 {
-  clients.lock();
-  for (cit = clients.begin(); cit != clients.end(); ++cit) {
-    if ( (*cit).second->alive() ) {
-      msg->ref();
-      (*cit).second->enqueue(msg);
-    }
-  }
-  clients.unlock();
+  // serialize once, before the sending threads of all clients get the message
+  msg->pack();
+  broadcast_clients(clients, msg);
+  broadcast_clients(reactor_clients_, msg);
   msg->unref();
 }
 
@@ -311,16 +578,11 @@ FawkesNetworkServerThread::broadcast(unsigned short int component_id, unsigned s
 void
 FawkesNetworkServerThread::send(FawkesNetworkMessage *msg)
 {
-	MutexLocker lock(clients.mutex());
-	unsigned int clid = msg->clid();
-  if ( clients.find(clid) != clients.end() ) {
-    if ( clients[clid]->alive() ) {
-      clients[clid]->enqueue(msg);
-    } else {
-      throw Exception("Client %u not alive", clid);
-    }
+  msg->pack();
+  if ( reactors_.empty() ) {
+    send_client(clients, msg);
   } else {
-    throw Exception("Client %u not found", clid);
+    send_client(reactor_clients_, msg);
   }
 }
 
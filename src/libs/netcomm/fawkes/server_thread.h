@@ -37,6 +37,8 @@ namespace fawkes {
 class ThreadCollector;
 class Mutex;
 class FawkesNetworkServerClientThread;
+class FawkesNetworkServerReactorClient;
+class FawkesNetworkReactor;
 class NetworkAcceptorThread;
 class FawkesNetworkHandler;
 class FawkesNetworkMessage;
@@ -52,7 +54,8 @@ class FawkesNetworkServerThread
   FawkesNetworkServerThread(bool enable_ipv4, bool enable_ipv6,
                             const std::string &listen_ipv4, const std::string &listen_ipv6,
                             unsigned int fawkes_port,
-                            ThreadCollector *thread_collector = 0);
+                            ThreadCollector *thread_collector = 0,
+                            unsigned int num_io_threads = 0);
   virtual ~FawkesNetworkServerThread();
 
   virtual void loop();
@@ -80,6 +83,10 @@ class FawkesNetworkServerThread
 
   void force_send();
 
+  void         set_batching(size_t max_size, unsigned int max_age_usec);
+  size_t       batch_max_size() const;
+  unsigned int batch_max_age() const;
+
  /** Stub to see name in backtrace for easier debugging. @see Thread::run() */
  protected: virtual void run() { Thread::run(); }
 
@@ -96,7 +103,14 @@ class FawkesNetworkServerThread
   LockMap<unsigned int, FawkesNetworkServerClientThread *> clients;
   LockMap<unsigned int, FawkesNetworkServerClientThread *>::iterator cit;
 
+  // reactor mode, key: client id, value: client served by a reactor
+  std::vector<FawkesNetworkReactor *> reactors_;
+  LockMap<unsigned int, FawkesNetworkServerReactorClient *> reactor_clients_;
+
   FawkesNetworkMessageQueue *inbound_messages;
+
+  size_t       batch_max_size_;
+  unsigned int batch_max_age_;
 };
 
 } // end namespace fawkes
@@ -24,11 +24,18 @@
 #include <netcomm/fawkes/transceiver.h>
 #include <netcomm/fawkes/message.h>
 #include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/buffer_pool.h>
+#include <netcomm/fawkes/batch.h>
 #include <netcomm/socket/stream.h>
 #include <netcomm/utils/exceptions.h>
 
 #include <netinet/in.h>
 #include <cstdlib>
+#include <list>
+#include <vector>
+
+/** Maximum number of buffers passed to a single gather write. */
+#define FNT_MAX_IOV 256
 
 namespace fawkes {
 
@@ -37,6 +44,10 @@ namespace fawkes {
  * Utility class that provides methods to send and receive messages via
  * the network. Operates on message queues and a given socket.
  *
+ * Messages are sent with gather writes, headers and payloads are passed
+ * in place without copying them into a contiguous buffer. Received
+ * payloads are allocated from the FawkesNetworkBufferPool.
+ *
  * @ingroup NetComm
  * @author Tim Niemueller
  */
@@ -50,19 +61,35 @@ namespace fawkes {
 void
 FawkesNetworkTransceiver::send(StreamSocket *s, FawkesNetworkMessageQueue *msgq)
 {
+  std::vector<struct iovec> iov;
+  std::list<FawkesNetworkMessage *> batch;
+
   msgq->lock();
   try {
     while ( ! msgq->empty() ) {
-      FawkesNetworkMessage *m = msgq->front();
+      FawkesNetworkMessage *m = msgq->pop_frame();
       m->pack();
       const fawkes_message_t &f = m->fmsg();
-      unsigned int payload_size = m->payload_size();
-      s->write(&(f.header), sizeof(f.header));
-      s->write(f.payload, payload_size);
-      m->unref();
-      msgq->pop();
+      struct iovec header;
+      header.iov_base = (void *)&(f.header);
+      header.iov_len  = sizeof(f.header);
+      iov.push_back(header);
+      m->payload_segments(iov);
+      batch.push_back(m);
+
+      if ( (iov.size() >= FNT_MAX_IOV) || msgq->empty() ) {
+	s->writev(&iov[0], iov.size());
+	iov.clear();
+	for (std::list<FawkesNetworkMessage *>::iterator b = batch.begin(); b != batch.end(); ++b) {
+	  (*b)->unref();
+	}
+	batch.clear();
+      }
     }
   } catch (SocketException &e) {
+    for (std::list<FawkesNetworkMessage *>::iterator b = batch.begin(); b != batch.end(); ++b) {
+      (*b)->unref();
+    }
     msgq->unlock();
     throw ConnectionDiedException("Write failed");
   }
@@ -79,13 +106,16 @@ FawkesNetworkTransceiver::send(StreamSocket *s, FawkesNetworkMessageQueue *msgq)
  * @param s socket to gather messages from
  * @param msgq message queue to store received messages in
  * @param max_num_msgs maximum number of messages to read from stream in one go.
+ * @param max_payload_size maximum payload size of a message in bytes
  * @exception ConnectionDiedException Thrown if any error occurs during the
- * operation since for any error the conncetion is considered dead.
+ * operation since for any error the conncetion is considered dead, or if
+ * a message exceeds the maximum payload size.
  */
 void
 FawkesNetworkTransceiver::recv(StreamSocket *s, FawkesNetworkMessageQueue *msgq,
-			       unsigned int max_num_msgs)
+			       unsigned int max_num_msgs, size_t max_payload_size)
 {
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
   msgq->lock();
 
   try {
@@ -95,16 +125,34 @@ FawkesNetworkTransceiver::recv(StreamSocket *s, FawkesNetworkMessageQueue *msgq,
       s->read(&(msg.header), sizeof(msg.header));
 
       unsigned int payload_size = ntohl(msg.header.payload_size);
+      if ( payload_size > max_payload_size ) {
+	msgq->unlock();
+	throw ConnectionDiedException("Message payload too large");
+      }
+      msg.payload = NULL;
 
+      FawkesNetworkMessage *m = new FawkesNetworkMessage(msg);
       if ( payload_size > 0 ) {
-	msg.payload = malloc(payload_size);
-	s->read(msg.payload, payload_size);
+	m->set_pooled_payload(pool->alloc(payload_size), payload_size);
+	try {
+	  s->read(m->payload(), payload_size);
+	} catch (SocketException &e) {
+	  m->unref();
+	  throw;
+	}
+      }
+      if ( FawkesNetworkMessageBatch::is_batch(m) ) {
+	try {
+	  FawkesNetworkMessageBatch::unpack(m, msgq);
+	} catch (Exception &e) {
+	  m->unref();
+	  msgq->unlock();
+	  throw ConnectionDiedException("Malformed batch frame");
+	}
+	m->unref();
       } else {
-	msg.payload = NULL;
+	msgq->push(m);
       }
-
-      FawkesNetworkMessage *m = new FawkesNetworkMessage(msg);
-      msgq->push(m);
     }
   } catch (SocketException &e) {
     msgq->unlock();
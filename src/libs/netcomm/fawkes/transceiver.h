@@ -25,6 +25,7 @@
 #define _NETCOMM_FAWKES_TRANSCEIVER_H_
 
 #include <core/exception.h>
+#include <netcomm/fawkes/message.h>
 
 namespace fawkes {
 
@@ -36,7 +37,8 @@ class FawkesNetworkTransceiver
  public:
   static void send(StreamSocket *s, FawkesNetworkMessageQueue *msgq);
   static void recv(StreamSocket *s, FawkesNetworkMessageQueue *msgq,
-		   unsigned int max_num_msgs = 8);
+		   unsigned int max_num_msgs = 8,
+		   size_t max_payload_size = FAWKES_NET_MAX_PAYLOAD_SIZE);
 };
 
 } // end namespace fawkes
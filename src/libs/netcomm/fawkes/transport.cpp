@@ -0,0 +1,107 @@
+
+/***************************************************************************
+ *  transport.cpp - Fawkes network transport messages
+ *
+ *  Created: Sat Oct 17 00:40:02 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
+#include <netcomm/fawkes/message.h>
+
+#include <netinet/in.h>
+#include <cstdlib>
+
+namespace fawkes {
+
+/** @class FawkesNetworkTransport <netcomm/fawkes/transport.h>
+ * Transport feature negotiation.
+ * Used by all connection types, i.e. clients, server connections with
+ * their own threads and server connections served by a reactor, so that
+ * they negotiate features the same way.
+ * @ingroup NetComm
+ * @author Tim Niemueller
+ */
+
+/** Create features request.
+ * To be sent by a client right after connecting.
+ * @return MSG_TRANSPORT_FEATURES_REQUEST message announcing all supported
+ * features
+ */
+FawkesNetworkMessage *
+FawkesNetworkTransport::features_request()
+{
+  transport_features_msg_t *fm =
+    (transport_features_msg_t *)malloc(sizeof(transport_features_msg_t));
+  fm->features = htonl(TRANSPORT_FEATURES_SUPPORTED);
+  return new FawkesNetworkMessage(FAWKES_CID_TRANSPORT, MSG_TRANSPORT_FEATURES_REQUEST,
+				  fm, sizeof(transport_features_msg_t));
+}
+
+
+/** Answer features request.
+ * @param request transport message received from a client
+ * @param clid ID of the client the request was received from
+ * @param features upon return contains the features supported by both
+ * sides if the request is valid
+ * @return MSG_TRANSPORT_FEATURES reply to send to the client, or NULL if
+ * the message is not a valid features request
+ */
+FawkesNetworkMessage *
+FawkesNetworkTransport::answer_features_request(FawkesNetworkMessage *request,
+						unsigned int clid, uint32_t &features)
+{
+  if ( (request->msgid() != MSG_TRANSPORT_FEATURES_REQUEST) ||
+       (request->payload_size() < sizeof(transport_features_msg_t)) )
+  {
+    return NULL;
+  }
+
+  transport_features_msg_t *rm = request->msg<transport_features_msg_t>();
+  features = ntohl(rm->features) & TRANSPORT_FEATURES_SUPPORTED;
+
+  transport_features_msg_t *fm =
+    (transport_features_msg_t *)malloc(sizeof(transport_features_msg_t));
+  fm->features = htonl(features);
+  return new FawkesNetworkMessage(clid, FAWKES_CID_TRANSPORT, MSG_TRANSPORT_FEATURES,
+				  fm, sizeof(transport_features_msg_t));
+}
+
+
+/** Parse features reply.
+ * @param reply transport message received from the server
+ * @param features upon return contains the features supported by both
+ * sides if the reply is valid
+ * @return true if the message is a valid features reply, false otherwise
+ */
+bool
+FawkesNetworkTransport::features_reply(FawkesNetworkMessage *reply, uint32_t &features)
+{
+  if ( (reply->msgid() != MSG_TRANSPORT_FEATURES) ||
+       (reply->payload_size() < sizeof(transport_features_msg_t)) )
+  {
+    return false;
+  }
+
+  transport_features_msg_t *fm = reply->msg<transport_features_msg_t>();
+  features = ntohl(fm->features) & TRANSPORT_FEATURES_SUPPORTED;
+  return true;
+}
+
+} // end namespace fawkes
@@ -0,0 +1,92 @@
+
+/***************************************************************************
+ *  transport.h - Fawkes network transport messages
+ *
+ *  Created: Fri Oct 16 19:02:13 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _NETCOMM_FAWKES_TRANSPORT_H_
+#define _NETCOMM_FAWKES_TRANSPORT_H_
+
+#include <stdint.h>
+
+/** Default maximum size of a batch frame in bytes. */
+#define FAWKES_NETWORK_BATCH_MAX_SIZE 16384
+/** Messages in a batch frame are padded to a multiple of this many bytes. */
+#define FAWKES_NETWORK_BATCH_ALIGN        8
+
+namespace fawkes {
+
+#pragma pack(push,4)
+
+/** Transport message types, component FAWKES_CID_TRANSPORT.
+ * These messages are handled by the connections themselves and are
+ * never passed to handlers.
+ */
+typedef enum {
+  MSG_TRANSPORT_FEATURES_REQUEST	= 1,
+  MSG_TRANSPORT_FEATURES		= 2,
+  MSG_TRANSPORT_BATCH			= 3
+} transport_msgid_t;
+
+/** Optional transport features, negotiated per connection. */
+typedef enum {
+  TRANSPORT_FEATURE_BATCH	= 0x00000001	/**< Peer can decode MSG_TRANSPORT_BATCH
+						 * frames. */
+} transport_feature_t;
+
+/** Transport features supported by this implementation. */
+#define TRANSPORT_FEATURES_SUPPORTED TRANSPORT_FEATURE_BATCH
+
+/** Transport features message.
+ * Sent by the client as MSG_TRANSPORT_FEATURES_REQUEST right after the
+ * connection has been established. The server answers with
+ * MSG_TRANSPORT_FEATURES containing the subset of features it supports.
+ * Servers which do not know the request drop it, hence clients must
+ * assume that no optional features are available.
+ */
+typedef struct {
+  uint32_t features;	/**< bit field of transport_feature_t (big endian) */
+} transport_features_msg_t;
+
+/* A MSG_TRANSPORT_BATCH frame carries a sequence of complete messages as
+ * its payload, each a fawkes_message_header_t followed by the payload of
+ * the message and zero padding up to the next multiple of
+ * FAWKES_NETWORK_BATCH_ALIGN bytes. The padding keeps the payloads
+ * aligned for in-place decoding. Batch frames are not nested.
+ */
+
+#pragma pack(pop)
+
+class FawkesNetworkMessage;
+
+class FawkesNetworkTransport
+{
+ public:
+  static FawkesNetworkMessage * features_request();
+  static FawkesNetworkMessage * answer_features_request(FawkesNetworkMessage *request,
+							 unsigned int clid,
+							 uint32_t &features);
+  static bool                   features_reply(FawkesNetworkMessage *reply,
+					       uint32_t &features);
+};
+
+} // end namespace fawkes
+
+#endif
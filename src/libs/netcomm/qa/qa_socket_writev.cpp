@@ -0,0 +1,156 @@
+
+/***************************************************************************
+ *  qa_socket_writev.cpp - Fawkes QA gather writes with partial writes
+ *
+ *  Created: Fri Oct 16 23:41:12 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+/// @cond QA
+
+#include <netcomm/socket/stream.h>
+#include <core/exception.h>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace fawkes;
+
+// more segments than a single writev() call takes
+#define NUM_SEGMENTS  (3 * IOV_MAX + 17)
+
+static unsigned char
+pattern(size_t offset)
+{
+  return (offset * 131 + 7) & 0xFF;
+}
+
+typedef struct {
+  Socket *s;
+  size_t  expected;
+  size_t  received;
+  size_t  mismatches;
+} reader_t;
+
+// read slowly in small chunks, so that the writer runs into a full
+// send buffer and has to continue after partial writes
+static void *
+reader(void *arg)
+{
+  reader_t *r = (reader_t *)arg;
+  unsigned char buf[4096];
+  try {
+    while (r->received < r->expected) {
+      size_t n = r->s->read(buf, sizeof(buf), /* read all */ false);
+      if (n == 0)  break;
+      for (size_t i = 0; i < n; ++i) {
+	if (buf[i] != pattern(r->received + i))  ++r->mismatches;
+      }
+      r->received += n;
+      usleep(100);
+    }
+  } catch (Exception &e) {
+    e.print_trace();
+  }
+  return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned short int port = 19199;
+
+  StreamSocket server(Socket::IPv4);
+  server.bind(port, "127.0.0.1");
+  server.listen();
+
+  StreamSocket client(Socket::IPv4, /* timeout sec */ 10.f);
+  client.connect("127.0.0.1", port);
+  StreamSocket *conn = server.accept<StreamSocket>();
+
+  // small send buffer and non-blocking writes force partial writes
+  int sndbuf = 4096;
+  setsockopt(client.fd(), SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+  fcntl(client.fd(), F_SETFL, fcntl(client.fd(), F_GETFL) | O_NONBLOCK);
+
+  // segments of varying size, including empty ones
+  std::vector<struct iovec> iov(NUM_SEGMENTS);
+  std::vector<unsigned char *> bufs(NUM_SEGMENTS);
+  size_t total = 0;
+  for (unsigned int i = 0; i < NUM_SEGMENTS; ++i) {
+    size_t len = (i % 5 == 0) ? 0 : (i * 37) % 701;
+    bufs[i] = (unsigned char *)malloc(len + 1);
+    for (size_t j = 0; j < len; ++j)  bufs[i][j] = pattern(total + j);
+    iov[i].iov_base = bufs[i];
+    iov[i].iov_len  = len;
+    total += len;
+  }
+
+  reader_t r;
+  r.s = conn;
+  r.expected = total;
+  r.received = 0;
+  r.mismatches = 0;
+  pthread_t reader_thread;
+  pthread_create(&reader_thread, NULL, reader, &r);
+
+  bool ok = true;
+  try {
+    client.writev(&iov[0], iov.size());
+  } catch (Exception &e) {
+    e.print_trace();
+    ok = false;
+  }
+  pthread_join(reader_thread, NULL);
+
+  // the caller's vector must not be modified
+  size_t total_after = 0;
+  for (unsigned int i = 0; i < NUM_SEGMENTS; ++i) {
+    if (iov[i].iov_base != bufs[i])  ok = false;
+    total_after += iov[i].iov_len;
+  }
+
+  printf("Wrote %zu bytes in %u segments, received %zu bytes, %zu mismatches\n",
+	 total, NUM_SEGMENTS, r.received, r.mismatches);
+  if (total_after != total) {
+    printf("FAILED: segment vector modified\n");
+    ok = false;
+  }
+  if (r.received != total || r.mismatches > 0) {
+    printf("FAILED: received data differs\n");
+    ok = false;
+  }
+
+  for (unsigned int i = 0; i < NUM_SEGMENTS; ++i)  free(bufs[i]);
+  conn->close();
+  delete conn;
+  client.close();
+  server.close();
+
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
+
+/// @endcond
@@ -46,6 +46,9 @@
 #include <netinet/ip.h> 
 #include <arpa/inet.h>
 #include <poll.h>
+#include <algorithm>
+#include <climits>
+#include <vector>
 
 #include <cstdio>
 
@@ -747,6 +750,62 @@ Socket::write(const void *buf, size_t count)
 }
 
 
+/** Write multiple buffers to the socket.
+ * Gather write of all given buffers, which are written as if they had been
+ * concatenated, but without copying them. This method can only be used on
+ * streams. Writing continues as long as data can be written, if the socket
+ * would block the timeout is handled the same way as for write().
+ * @param iov array of buffers to write
+ * @param iovcnt number of elements in iov
+ * @exception SocketException if the data could not be written or if a timeout occured.
+ */
+void
+Socket::writev(const struct iovec *iov, int iovcnt)
+{
+	if (sock_fd == -1) {
+		throw SocketException("Socket not initialized, call bind() or connect()");
+	}
+
+  // local copy, advanced on partial writes
+  std::vector<struct iovec> v(iov, iov + iovcnt);
+  size_t first = 0;
+  while ((first < v.size()) && (v[first].iov_len == 0))  ++first;
+
+  struct timeval start, now;
+  gettimeofday(&start, NULL);
+
+  bool progress;
+  do {
+    int cnt = std::min((size_t)IOV_MAX, v.size() - first);
+    ssize_t retval = ::writev(sock_fd, &v[first], cnt);
+    progress = (retval > 0);
+    if (retval == -1) {
+      if (errno != EAGAIN) {
+	throw SocketException(errno, "Could not write data");
+      }
+    } else {
+      size_t written = retval;
+      while ((first < v.size()) && (written >= v[first].iov_len)) {
+	written -= v[first].iov_len;
+	++first;
+      }
+      if (first < v.size()) {
+	v[first].iov_base = (char *)v[first].iov_base + written;
+	v[first].iov_len -= written;
+      }
+      // reset timeout
+      gettimeofday(&start, NULL);
+    }
+    gettimeofday(&now, NULL);
+    usleep(0);
+  } while ((first < v.size()) && (progress || (time_diff_sec(now, start) < timeout)) );
+
+  if ( first < v.size() ) {
+    throw SocketException("Write timeout");
+  }
+}
+
+
 /** Read from socket.
  * Read from the socket. This method can only be used on streams.
  * @param buf buffer to write from
@@ -1006,4 +1065,16 @@ Socket::mtu()
   return m;
 }
 
+
+/** Get file descriptor.
+ * The descriptor can be used to monitor the socket with an external
+ * event loop, e.g. epoll. Do not close it, use close() instead.
+ * @return file descriptor of the socket, -1 if not initialized
+ */
+int
+Socket::fd() const
+{
+  return sock_fd;
+}
+
 } // end namespace fawkes
@@ -0,0 +1,332 @@
+
+/***************************************************************************
+ *  test_batch.cpp - Fawkes network message batch frame unit test
+ *
+ *  Created: Sat Oct 17 00:58:14 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <netcomm/fawkes/batch.h>
+#include <netcomm/fawkes/message.h>
+#include <netcomm/fawkes/message_queue.h>
+#include <netcomm/fawkes/transport.h>
+#include <netcomm/fawkes/component_ids.h>
+#include <core/exception.h>
+
+#include <netinet/in.h>
+#include <sys/uio.h>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <vector>
+
+using namespace fawkes;
+
+/** Component ID of test messages. */
+#define TEST_CID  42
+
+/** Create message with payload bytes derived from the ID.
+ * @param id message ID
+ * @param size payload size
+ * @return new message
+ */
+static FawkesNetworkMessage *
+make_message(unsigned short int id, size_t size)
+{
+  if (size == 0)  return new FawkesNetworkMessage(TEST_CID, id);
+  unsigned char *p = (unsigned char *)malloc(size);
+  for (size_t i = 0; i < size; ++i)  p[i] = (id + i) & 0xFF;
+  return new FawkesNetworkMessage(TEST_CID, id, p, size);
+}
+
+/** Check message created by make_message().
+ * @param m message to check
+ * @param id expected message ID
+ * @param size expected payload size
+ * @return true if the message matches
+ */
+static bool
+message_ok(FawkesNetworkMessage *m, unsigned short int id, size_t size)
+{
+  if (m->cid() != TEST_CID || m->msgid() != id || m->payload_size() != size)  return false;
+  const unsigned char *p = (const unsigned char *)m->payload();
+  for (size_t i = 0; i < size; ++i) {
+    if (p[i] != ((id + i) & 0xFF))  return false;
+  }
+  return true;
+}
+
+/** Get contiguous copy of the payload of a frame as it goes over the wire.
+ * @param m frame
+ * @return payload bytes
+ */
+static std::vector<char>
+wire_payload(FawkesNetworkMessage *m)
+{
+  m->pack();
+  std::vector<struct iovec> segs;
+  m->payload_segments(segs);
+  std::vector<char> buf;
+  for (size_t i = 0; i < segs.size(); ++i) {
+    buf.insert(buf.end(), (char *)segs[i].iov_base,
+	       (char *)segs[i].iov_base + segs[i].iov_len);
+  }
+  return buf;
+}
+
+/** Create received frame.
+ * @param payload frame payload
+ * @param size payload size
+ * @return new frame message
+ */
+static FawkesNetworkMessage *
+received_frame(const char *payload, size_t size)
+{
+  void *p = malloc(size > 0 ? size : 1);
+  if (size > 0)  memcpy(p, payload, size);
+  return new FawkesNetworkMessage(1, FAWKES_CID_TRANSPORT, MSG_TRANSPORT_BATCH, p, size);
+}
+
+/** Unpack received frame.
+ * @param payload frame payload
+ * @param size payload size
+ * @return true if the frame was rejected without output
+ */
+static bool
+rejected(const char *payload, size_t size)
+{
+  FawkesNetworkMessage *f = received_frame(payload, size);
+  FawkesNetworkMessageQueue q;
+  bool rv = false;
+  try {
+    FawkesNetworkMessageBatch::unpack(f, &q);
+  } catch (Exception &e) {
+    rv = q.empty();
+  }
+  while (! q.empty()) {
+    q.front()->unref();
+    q.pop();
+  }
+  f->unref();
+  return rv;
+}
+
+
+/** @class FawkesNetworkBatchTest
+ * Test class for batch frames, provides a serialized well-formed frame.
+ */
+class FawkesNetworkBatchTest : public ::testing::Test
+{
+ protected:
+  /** Serialize frame of messages of various sizes */
+  virtual void SetUp()
+  {
+    const size_t s[] = { 0, 1, 7, 8, 9, 100, 3 };
+    sizes.assign(s, s + sizeof(s) / sizeof(s[0]));
+
+    FawkesNetworkMessageBatch *batch = new FawkesNetworkMessageBatch();
+    for (unsigned int i = 0; i < sizes.size(); ++i) {
+      batch->append(make_message(i + 1, sizes[i]));
+    }
+    num_messages = batch->num_messages();
+    batch_size = batch->size();
+    FawkesNetworkMessage *frame =
+      new FawkesNetworkMessage(FAWKES_CID_TRANSPORT, MSG_TRANSPORT_BATCH, batch);
+    is_batch = FawkesNetworkMessageBatch::is_batch(frame);
+    wire = wire_payload(frame);
+    frame_payload_size = frame->payload_size();
+    frame->unref();
+  }
+
+  /** Unref all messages in list.
+   * @param msgs messages to unref, list is cleared
+   */
+  void clear(std::list<FawkesNetworkMessage *> &msgs)
+  {
+    for (std::list<FawkesNetworkMessage *>::iterator i = msgs.begin(); i != msgs.end(); ++i) {
+      (*i)->unref();
+    }
+    msgs.clear();
+  }
+
+  /** Payload sizes of the messages in the frame */
+  std::vector<size_t> sizes;
+  /** Number of messages in the batch */
+  unsigned int        num_messages;
+  /** Size of the batch */
+  size_t              batch_size;
+  /** Payload size of the frame */
+  size_t              frame_payload_size;
+  /** True if the frame was detected as batch */
+  bool                is_batch;
+  /** Serialized frame payload */
+  std::vector<char>   wire;
+};
+
+
+TEST_F(FawkesNetworkBatchTest, Serialize)
+{
+  EXPECT_EQ(sizes.size(), num_messages);
+  EXPECT_TRUE(is_batch);
+  EXPECT_EQ(batch_size, wire.size());
+  EXPECT_EQ(batch_size, frame_payload_size);
+  EXPECT_EQ(0u, wire.size() % FAWKES_NETWORK_BATCH_ALIGN);
+}
+
+TEST_F(FawkesNetworkBatchTest, RoundTrip)
+{
+  FawkesNetworkMessage *rf = received_frame(&wire[0], wire.size());
+  FawkesNetworkMessageQueue q;
+  EXPECT_NO_THROW(FawkesNetworkMessageBatch::unpack(rf, &q));
+  rf->unref();  // messages keep the frame payload alive
+  EXPECT_EQ(sizes.size(), q.size());
+  for (unsigned int i = 0; i < sizes.size() && ! q.empty(); ++i) {
+    EXPECT_TRUE(message_ok(q.front(), i + 1, sizes[i])) << "message " << i + 1;
+    EXPECT_EQ(1u, q.front()->clid());
+    q.front()->unref();
+    q.pop();
+  }
+}
+
+TEST_F(FawkesNetworkBatchTest, Empty)
+{
+  EXPECT_FALSE(rejected(NULL, 0));
+}
+
+TEST_F(FawkesNetworkBatchTest, Truncated)
+{
+  for (size_t s = 1; s < wire.size(); ++s) {
+    // cuts at message boundaries yield valid shorter frames
+    size_t pos = 0;
+    bool boundary = false;
+    for (unsigned int i = 0; i < sizes.size() && pos <= s; ++i) {
+      if (pos == s)  boundary = true;
+      size_t pad = (FAWKES_NETWORK_BATCH_ALIGN - sizes[i] % FAWKES_NETWORK_BATCH_ALIGN)
+	% FAWKES_NETWORK_BATCH_ALIGN;
+      pos += sizeof(fawkes_message_header_t) + sizes[i] + pad;
+    }
+    if (! boundary) {
+      EXPECT_TRUE(rejected(&wire[0], s)) << "truncated to " << s;
+    }
+  }
+}
+
+TEST_F(FawkesNetworkBatchTest, Malformed)
+{
+  // oversized payload size in a header
+  std::vector<char> bad(wire);
+  fawkes_message_header_t h;
+  memcpy(&h, &bad[0], sizeof(h));
+  h.payload_size = htonl(0xFFFFFFFF);
+  memcpy(&bad[0], &h, sizeof(h));
+  EXPECT_TRUE(rejected(&bad[0], bad.size())) << "oversized message";
+
+  // nested batch frames
+  bad = wire;
+  h.cid = htons(FAWKES_CID_TRANSPORT);
+  h.msg_id = htons(MSG_TRANSPORT_BATCH);
+  h.payload_size = htonl(sizes.back());
+  size_t last = bad.size() - sizeof(fawkes_message_header_t) - FAWKES_NETWORK_BATCH_ALIGN;
+  memcpy(&bad[last], &h, sizeof(h));
+  EXPECT_TRUE(rejected(&bad[0], bad.size())) << "nested batch frame";
+}
+
+TEST_F(FawkesNetworkBatchTest, Coalesce)
+{
+  // large messages and messages before first stay untouched
+  std::list<FawkesNetworkMessage *> msgs;
+  for (unsigned short int id = 1; id <= 8; ++id) {
+    msgs.push_back(make_message(id, (id == 5) ? 1000 : 10));
+  }
+  const size_t small = FawkesNetworkMessageBatch::frame_size(msgs.front());
+  std::list<FawkesNetworkMessage *>::iterator first = msgs.begin();
+  ++first;
+  FawkesNetworkMessageBatch::coalesce(msgs, first, 2 * small);
+  ASSERT_EQ(6u, msgs.size());
+  std::list<FawkesNetworkMessage *>::iterator m = msgs.begin();
+  EXPECT_TRUE(message_ok(*m, 1, 10));
+  ++m;
+  EXPECT_TRUE(FawkesNetworkMessageBatch::is_batch(*m));
+  ++m;
+  EXPECT_TRUE(message_ok(*m, 4, 10));
+  ++m;
+  EXPECT_TRUE(message_ok(*m, 5, 1000));
+  ++m;
+  EXPECT_TRUE(FawkesNetworkMessageBatch::is_batch(*m));
+  ++m;
+  EXPECT_TRUE(message_ok(*m, 8, 10));
+
+  // coalesced frames unpack into the original order
+  FawkesNetworkMessageQueue cq;
+  for (m = msgs.begin(); m != msgs.end(); ++m) {
+    if (FawkesNetworkMessageBatch::is_batch(*m)) {
+      std::vector<char> w = wire_payload(*m);
+      FawkesNetworkMessage *f = received_frame(&w[0], w.size());
+      FawkesNetworkMessageBatch::unpack(f, &cq);
+      f->unref();
+    } else {
+      (*m)->ref();
+      cq.push(*m);
+    }
+  }
+  EXPECT_EQ(8u, cq.size());
+  for (unsigned short int id = 1; ! cq.empty(); ++id) {
+    EXPECT_TRUE(message_ok(cq.front(), id, (id == 5) ? 1000 : 10)) << "message " << id;
+    cq.front()->unref();
+    cq.pop();
+  }
+  clear(msgs);
+}
+
+TEST_F(FawkesNetworkBatchTest, PopFrame)
+{
+  FawkesNetworkMessageQueue pq;
+  pq.push(make_message(1, 10));
+  pq.push(make_message(2, 10));
+  FawkesNetworkMessage *pf = pq.pop_frame();
+  EXPECT_FALSE(FawkesNetworkMessageBatch::is_batch(pf));
+  EXPECT_TRUE(message_ok(pf, 1, 10));
+  const size_t small = FawkesNetworkMessageBatch::frame_size(pf);
+  pf->unref();
+  pf = pq.pop_frame();
+  pf->unref();
+
+  pq.set_batching(3 * small);
+  for (unsigned short int id = 1; id <= 5; ++id)  pq.push(make_message(id, 10));
+  pq.push(make_message(6, 5000));
+  pq.push(make_message(7, 10));
+  pf = pq.pop_frame();
+  EXPECT_TRUE(FawkesNetworkMessageBatch::is_batch(pf));
+  pf->pack();
+  EXPECT_EQ(3 * small, pf->payload_size());
+  pf->unref();
+  pf = pq.pop_frame();
+  pf->pack();
+  EXPECT_TRUE(FawkesNetworkMessageBatch::is_batch(pf));
+  EXPECT_EQ(2 * small, pf->payload_size());
+  pf->unref();
+  pf = pq.pop_frame();
+  EXPECT_TRUE(message_ok(pf, 6, 5000));
+  pf->unref();
+  pf = pq.pop_frame();
+  EXPECT_TRUE(message_ok(pf, 7, 10));
+  pf->unref();
+  EXPECT_TRUE(pq.empty());
+}
@@ -0,0 +1,147 @@
+
+/***************************************************************************
+ *  test_buffer_pool.cpp - Fawkes network message buffer pool unit test
+ *
+ *  Created: Fri Oct 16 23:58:30 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <netcomm/fawkes/buffer_pool.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+using namespace fawkes;
+
+/** Number of threads for the concurrency test. */
+#define NUM_THREADS   4
+/** Number of allocations per thread. */
+#define NUM_ROUNDS    20000
+
+/** Allocate, fill completely and verify buffers of random size.
+ * @param arg seed and fill value
+ * @return number of corrupted bytes found
+ */
+static void *
+worker(void *arg)
+{
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  unsigned int seed = (unsigned long)arg;
+  unsigned char tag = (unsigned long)arg & 0xFF;
+  unsigned long corrupt = 0;
+  for (unsigned int i = 0; i < NUM_ROUNDS; ++i) {
+    size_t size = 1 + rand_r(&seed) % ((1 << FNBP_MAX_SHIFT) + 1024);
+    unsigned char *buf = (unsigned char *)pool->alloc(size);
+    memset(buf, tag, size);
+    sched_yield();
+    for (size_t j = 0; j < size; j += 64) {
+      if (buf[j] != tag)  ++corrupt;
+    }
+    if (buf[size - 1] != tag)  ++corrupt;
+    pool->release(buf, size);
+  }
+  return (void *)corrupt;
+}
+
+
+TEST(FawkesNetworkBufferPoolTest, Singleton)
+{
+  EXPECT_EQ(FawkesNetworkBufferPool::instance(), FawkesNetworkBufferPool::instance());
+}
+
+TEST(FawkesNetworkBufferPoolTest, ReuseWithinClass)
+{
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  void *b = pool->alloc(100);
+  pool->release(b, 100);
+  EXPECT_EQ(b, pool->alloc(128));
+  pool->release(b, 128);
+  EXPECT_EQ(b, pool->alloc(100));
+  pool->release(b, 100);
+}
+
+TEST(FawkesNetworkBufferPoolTest, ClassBoundary)
+{
+  // a 64 byte buffer must not serve 65 bytes
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  void *s = pool->alloc(1 << FNBP_MIN_SHIFT);
+  pool->release(s, 1 << FNBP_MIN_SHIFT);
+  void *l = pool->alloc((1 << FNBP_MIN_SHIFT) + 1);
+  EXPECT_NE(s, l);
+  memset(l, 0, (1 << FNBP_MIN_SHIFT) + 1);
+  EXPECT_EQ(s, pool->alloc(1 << FNBP_MIN_SHIFT));
+  pool->release(s, 1 << FNBP_MIN_SHIFT);
+  pool->release(l, (1 << FNBP_MIN_SHIFT) + 1);
+}
+
+TEST(FawkesNetworkBufferPoolTest, Oversized)
+{
+  // oversized buffers bypass the pool, the largest class is pooled
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  size_t big = (1 << FNBP_MAX_SHIFT) + 1;
+  void *o = pool->alloc(big);
+  memset(o, 0, big);
+  pool->release(o, big);
+  void *m = pool->alloc(1 << FNBP_MAX_SHIFT);
+  memset(m, 0, 1 << FNBP_MAX_SHIFT);
+  pool->release(m, 1 << FNBP_MAX_SHIFT);
+  EXPECT_EQ(m, pool->alloc(1 << FNBP_MAX_SHIFT));
+  pool->release(m, 1 << FNBP_MAX_SHIFT);
+
+  pool->release(NULL, 10);
+}
+
+TEST(FawkesNetworkBufferPoolTest, FreeLimit)
+{
+  // at most FNBP_MAX_FREE buffers are kept per class
+  FawkesNetworkBufferPool *pool = FawkesNetworkBufferPool::instance();
+  std::set<void *> released;
+  void *bufs[FNBP_MAX_FREE + 10];
+  for (unsigned int i = 0; i < FNBP_MAX_FREE + 10; ++i)  bufs[i] = pool->alloc(1000);
+  for (unsigned int i = 0; i < FNBP_MAX_FREE + 10; ++i) {
+    pool->release(bufs[i], 1000);
+    if (i < FNBP_MAX_FREE)  released.insert(bufs[i]);
+  }
+  unsigned int reused = 0;
+  for (unsigned int i = 0; i < FNBP_MAX_FREE; ++i) {
+    bufs[i] = pool->alloc(1000);
+    if (released.find(bufs[i]) != released.end())  ++reused;
+  }
+  EXPECT_EQ((unsigned int)FNBP_MAX_FREE, reused);
+  for (unsigned int i = 0; i < FNBP_MAX_FREE; ++i)  pool->release(bufs[i], 1000);
+}
+
+TEST(FawkesNetworkBufferPoolTest, Concurrent)
+{
+  pthread_t threads[NUM_THREADS];
+  for (unsigned long i = 0; i < NUM_THREADS; ++i) {
+    pthread_create(&threads[i], NULL, worker, (void *)(i + 1));
+  }
+  unsigned long corrupt = 0;
+  for (unsigned int i = 0; i < NUM_THREADS; ++i) {
+    void *rv;
+    pthread_join(threads[i], &rv);
+    corrupt += (unsigned long)rv;
+  }
+  EXPECT_EQ(0ul, corrupt);
+}
@@ -0,0 +1,172 @@
+/***************************************************************************
+ *  test_reactor.cpp - Fawkes network reactor unit test
+ *
+ *  Created: Sat Oct 17 20:14:37 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <netcomm/fawkes/reactor.h>
+#include <netcomm/fawkes/message.h>
+#include <netcomm/fawkes/message_queue.h>
+#include <netcomm/socket/stream.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace fawkes;
+
+/** Maximum payload size accepted by the reactor under test. */
+static const size_t MAX_PAYLOAD = 1024;
+
+/** @class ReactorTestHandler
+ * Handler counting received messages and connection deaths.
+ */
+class ReactorTestHandler : public FawkesNetworkReactorHandler
+{
+ public:
+  /** Constructor. */
+  ReactorTestHandler() : num_msgs(0), died(false) {}
+
+  virtual void reactor_inbound(unsigned int conn_id, FawkesNetworkMessageQueue *msgq)
+  {
+    while (! msgq->empty()) {
+      __atomic_add_fetch(&num_msgs, 1, __ATOMIC_RELEASE);
+      msgq->front()->unref();
+      msgq->pop();
+    }
+  }
+
+  virtual void reactor_connection_died(unsigned int conn_id)
+  {
+    __atomic_store_n(&died, true, __ATOMIC_RELEASE);
+  }
+
+  /** Number of received messages */
+  unsigned int num_msgs;
+  /** True once the connection died */
+  bool         died;
+};
+
+
+/** @class FawkesNetworkReactorTest
+ * Test class for the network reactor, serves one local TCP connection.
+ */
+class FawkesNetworkReactorTest : public ::testing::Test
+{
+ protected:
+  /** Connect client and server socket and start reactor */
+  virtual void SetUp()
+  {
+    StreamSocket listen_sock(Socket::IPv4);
+    listen_sock.bind(0, "127.0.0.1");
+    listen_sock.listen();
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    getsockname(listen_sock.fd(), (struct sockaddr *)&addr, &addr_len);
+
+    client = new StreamSocket(Socket::IPv4);
+    client->connect("127.0.0.1", ntohs(addr.sin_port));
+    server = listen_sock.accept<StreamSocket>();
+
+    reactor = new FawkesNetworkReactor("ReactorTest", MAX_PAYLOAD);
+    reactor->start();
+    conn_id = reactor->add_connection(server, &handler);
+  }
+
+  /** Stop reactor and close sockets */
+  virtual void TearDown()
+  {
+    reactor->remove_connection(conn_id);
+    reactor->cancel();
+    reactor->join();
+    delete reactor;
+    delete server;
+    delete client;
+  }
+
+  /** Send message header and payload from client.
+   * @param payload_size payload size announced in the header
+   * @param send_size number of payload bytes to actually send
+   */
+  void send(size_t payload_size, size_t send_size)
+  {
+    fawkes_message_header_t h;
+    h.cid          = htons(1);
+    h.msg_id       = htons(1);
+    h.payload_size = htonl(payload_size);
+    client->write(&h, sizeof(h));
+    if (send_size > 0) {
+      std::vector<char> payload(send_size, 0);
+      client->write(&payload[0], send_size);
+    }
+  }
+
+  /** Wait until the connection died, at most 5 sec.
+   * @return true if the connection died */
+  bool wait_died()
+  {
+    for (unsigned int i = 0; i < 5000; ++i) {
+      if (__atomic_load_n(&handler.died, __ATOMIC_ACQUIRE))  return true;
+      usleep(1000);
+    }
+    return false;
+  }
+
+  /** Reactor under test */
+  FawkesNetworkReactor *reactor;
+  /** Handler of the connection */
+  ReactorTestHandler    handler;
+  /** Connection ID */
+  unsigned int          conn_id;
+  /** Client side socket */
+  StreamSocket         *client;
+  /** Server side socket served by the reactor */
+  StreamSocket         *server;
+};
+
+
+TEST_F(FawkesNetworkReactorTest, MaxPayloadAccepted)
+{
+  send(MAX_PAYLOAD, MAX_PAYLOAD);
+  for (unsigned int i = 0; i < 5000 && __atomic_load_n(&handler.num_msgs, __ATOMIC_ACQUIRE) == 0; ++i) {
+    usleep(1000);
+  }
+  EXPECT_EQ(1u, __atomic_load_n(&handler.num_msgs, __ATOMIC_ACQUIRE));
+  EXPECT_TRUE(reactor->alive(conn_id));
+}
+
+TEST_F(FawkesNetworkReactorTest, OversizedPayloadRejected)
+{
+  // only the header is sent, the reactor must not wait for the payload
+  send(0x7FFFFFFF, 0);
+  EXPECT_TRUE(wait_died());
+  EXPECT_FALSE(reactor->alive(conn_id));
+  EXPECT_EQ(0u, __atomic_load_n(&handler.num_msgs, __ATOMIC_ACQUIRE));
+}
+
+TEST_F(FawkesNetworkReactorTest, OversizedPayloadAfterValid)
+{
+  send(16, 16);
+  send(MAX_PAYLOAD + 1, MAX_PAYLOAD + 1);
+  EXPECT_TRUE(wait_died());
+  EXPECT_EQ(1u, __atomic_load_n(&handler.num_msgs, __ATOMIC_ACQUIRE));
+}
@@ -96,10 +96,9 @@ PluginListMessage::append(const char *plugin_name, size_t len)
 void
 PluginListMessage::serialize()
 {
-  _payload_size = sizeof(msg) + plugin_list->buffer_size();
-  _payload = malloc(_payload_size);
-  copy_payload(0, &msg, sizeof(msg));
-  copy_payload(sizeof(msg), plugin_list->buffer(), plugin_list->buffer_size());
+  clear_segments();
+  add_segment(&msg, sizeof(msg));
+  add_segment(plugin_list->buffer(), plugin_list->buffer_size());
 }
 
 
@@ -27,6 +27,7 @@
 
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 
 using namespace std;
 
@@ -68,8 +69,10 @@ SyncPoint::SyncPoint(string identifier, MultiLogger *logger,
       cond_next_wait_(new WaitCondition(mutex_next_wait_)),
       mutex_wait_for_one_(new Mutex()),
       cond_wait_for_one_(new WaitCondition(mutex_wait_for_one_)),
+      cond_waiting_for_one_(new WaitCondition(mutex_wait_for_one_)),
       mutex_wait_for_all_(new Mutex()),
       cond_wait_for_all_(new WaitCondition(mutex_wait_for_all_)),
+      cond_waiting_for_all_(new WaitCondition(mutex_wait_for_all_)),
       wait_for_all_timer_running_(false),
       max_waittime_sec_(max_waittime_sec),
       max_waittime_nsec_(max_waittime_nsec),
@@ -247,6 +250,7 @@ SyncPoint::wait(const std::string & component,
 
   std::set<std::string> *watchers;
   WaitCondition *cond;
+  WaitCondition *cond_waiting;
   CircularBuffer<SyncPointCall> *calls;
   Mutex *mutex_cond;
   bool *timer_running;
@@ -255,12 +259,14 @@ SyncPoint::wait(const std::string & component,
   if (type == WAIT_FOR_ONE) {
     watchers = &watchers_wait_for_one_;
     cond = cond_wait_for_one_;
+    cond_waiting = cond_waiting_for_one_;
     mutex_cond = mutex_wait_for_one_;
     calls = &wait_for_one_calls_;
     timer_running = NULL;
   } else if (type == WAIT_FOR_ALL) {
     watchers = &watchers_wait_for_all_;
     cond = cond_wait_for_all_;
+    cond_waiting = cond_waiting_for_all_;
     mutex_cond = mutex_wait_for_all_;
     timer_running = &wait_for_all_timer_running_;
     timer_owner = &wait_for_all_timer_owner_;
@@ -290,6 +296,7 @@ SyncPoint::wait(const std::string & component,
   bool need_to_wait = !emitters_.empty() || type == WAIT_FOR_ONE;
   if (need_to_wait) {
     watchers->insert(component);
+    cond_waiting->wake_all();
   }
 
   mutex_next_wait_->lock();
@@ -576,6 +583,61 @@ SyncPoint::watcher_is_waiting(std::string watcher, WakeupType type) const
   }
 }
 
+/**
+ * Wait until the given watchers are waiting with the given type.
+ * This blocks until each of the watchers has called wait() and has not
+ * been released since, e.g. to make sure that a subsequent emit() reaches
+ * all of them.
+ * @param watchers the string identifiers of the watchers to wait for
+ * @param type the type of call to wait for
+ * @param wait_sec number of seconds to wait at most
+ * @param wait_nsec number of nanoseconds to wait additionally to wait_sec,
+ * wait without limit if both are zero
+ * @return true if all watchers are waiting, false if the time ran out
+ */
+bool
+SyncPoint::wait_until_waiting(const std::set<std::string> &watchers, WakeupType type,
+  uint wait_sec /* = 0 */, uint wait_nsec /* = 0 */)
+{
+  std::set<std::string> *waiting;
+  WaitCondition *cond;
+  Mutex *mutex_cond;
+  if (type == WAIT_FOR_ONE) {
+    waiting = &watchers_wait_for_one_;
+    cond = cond_waiting_for_one_;
+    mutex_cond = mutex_wait_for_one_;
+  } else if (type == WAIT_FOR_ALL) {
+    waiting = &watchers_wait_for_all_;
+    cond = cond_waiting_for_all_;
+    mutex_cond = mutex_wait_for_all_;
+  } else {
+    throw SyncPointInvalidTypeException();
+  }
+
+  bool timed = (wait_sec != 0 || wait_nsec != 0);
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec  += wait_sec + wait_nsec / 1000000000;
+  until.tv_nsec += wait_nsec % 1000000000;
+  if (until.tv_nsec >= 1000000000) {
+    until.tv_sec  += 1;
+    until.tv_nsec -= 1000000000;
+  }
+
+  MutexLocker ml(mutex_cond);
+  std::set<std::string>::const_iterator w = watchers.begin();
+  while (w != watchers.end()) {
+    if (waiting->count(*w)) {
+      ++w;
+    } else if (! timed) {
+      cond->wait();
+    } else if (! cond->abstimed_wait(until.tv_sec, until.tv_nsec)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void
 SyncPoint::reset_emitters() {
   last_emitter_reset_ = Time();
@@ -623,8 +685,10 @@ void
 SyncPoint::cleanup()
 {
   delete cond_wait_for_one_;
+  delete cond_waiting_for_one_;
   delete mutex_wait_for_one_;
   delete cond_wait_for_all_;
+  delete cond_waiting_for_all_;
   delete mutex_wait_for_all_;
   delete mutex_next_wait_;
   delete mutex_;
@@ -101,6 +101,8 @@ class SyncPoint
     CircularBuffer<SyncPointCall> get_wait_calls(WakeupType type = WAIT_FOR_ONE) const;
     CircularBuffer<SyncPointCall> get_emit_calls() const;
     bool watcher_is_waiting(std::string watcher, WakeupType type) const;
+    bool wait_until_waiting(const std::set<std::string> &watchers, WakeupType type,
+      uint wait_sec = 0, uint wait_nsec = 0);
 
 
     /**
@@ -142,10 +144,14 @@ class SyncPoint
     Mutex *mutex_wait_for_one_;
     /** WaitCondition which is used for wait_for_one() */
     WaitCondition *cond_wait_for_one_;
+    /** WaitCondition signaled when a component starts wait_for_one() */
+    WaitCondition *cond_waiting_for_one_;
     /** Mutex used for cond_wait_for_all_ */
     Mutex *mutex_wait_for_all_;
     /** WaitCondition which is used for wait_for_all() */
     WaitCondition *cond_wait_for_all_;
+    /** WaitCondition signaled when a component starts wait_for_all() */
+    WaitCondition *cond_waiting_for_all_;
     /** true if the wait for all timer is running */
     bool wait_for_all_timer_running_;
     /** the component that started the wait-for-all timer */
@@ -1215,6 +1215,49 @@ TEST_F(SyncPointManagerTest, LockUntilNextWaitWaiterComesFirstTest)
   pthread_join(waiter_thread, NULL);
 }
 
+/** Test whether wait_until_waiting() blocks until all given watchers wait and
+ *  times out if one of them does not wait */
+TEST_F(SyncPointManagerTest, WaitUntilWaitingTest)
+{
+  RefPtr<SyncPoint> sp = manager->get_syncpoint("emitter", "/test");
+  sp->register_emitter("emitter");
+
+  uint num_waiters = 2;
+  pthread_t threads[num_waiters];
+  waiter_thread_params *params[num_waiters];
+  set<string> watchers;
+  for (uint i = 0; i < num_waiters; i++) {
+    params[i] = new waiter_thread_params();
+    params[i]->component = "waiter" + to_string(i);
+    params[i]->manager = manager;
+    params[i]->type = SyncPoint::WAIT_FOR_ALL;
+    params[i]->num_wait_calls = 1;
+    params[i]->sp_identifier = "/test";
+    watchers.insert(params[i]->component);
+  }
+  watchers.insert("late waiter");
+  RefPtr<SyncPoint> late_sp = manager->get_syncpoint("late waiter", "/test");
+
+  EXPECT_FALSE(sp->wait_until_waiting(watchers, SyncPoint::WAIT_FOR_ALL, 0, 10000000));
+  for (uint i = 0; i < num_waiters; i++) {
+    pthread_create(&threads[i], &attrs, start_waiter_thread, params[i]);
+  }
+  EXPECT_FALSE(sp->wait_until_waiting(watchers, SyncPoint::WAIT_FOR_ALL, 0, 10000000));
+  watchers.erase("late waiter");
+  EXPECT_TRUE(sp->wait_until_waiting(watchers, SyncPoint::WAIT_FOR_ALL, 1, 0));
+  for (uint i = 0; i < num_waiters; i++) {
+    EXPECT_TRUE(sp->watcher_is_waiting(params[i]->component, SyncPoint::WAIT_FOR_ALL));
+  }
+
+  sp->emit("emitter");
+  for (uint i = 0; i < num_waiters; i++) {
+    ASSERT_TRUE(wait_for_finished(params[i]));
+    pthread_join(threads[i], NULL);
+    delete params[i];
+  }
+  EXPECT_FALSE(sp->wait_until_waiting(watchers, SyncPoint::WAIT_FOR_ALL, 0, 10000000));
+}
+
 /** Test whether all waiters are always released at the same time, even if one
  *  waiter called wait after one emitter already emitted. In particular, this
  *  tests the following scenario:
@@ -54,6 +54,7 @@
 #include <tf/exceptions.h>
 #include <tf/types.h>
 #include <tf/utils.h>
+#include <core/threading/scoped_rwlock.h>
 
 #include <sstream>
 #include <algorithm>
@@ -132,10 +133,14 @@ BufferCore::BufferCore(float cache_time)
   frameIDs_["NO_PARENT"] = 0;
   frames_.push_back(TimeCacheInterfacePtr());
   frameIDs_reverse.push_back("NO_PARENT");
+  frame_chains_ = new M_FrameChain();
+  num_retired_frame_chains_ = 0;
 }
 
 BufferCore::~BufferCore()
 {
+  clear_frame_chains();
+  delete frame_chains_;
 }
 
 /** Clear all data. */
@@ -143,7 +148,8 @@ void
 BufferCore::clear()
 {
   //old_tf_.clear();
-  std::unique_lock<std::mutex> lock(frame_mutex_);
+  ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_WRITE);
+  clear_frame_chains();
   if ( frames_.size() > 1 )
   {
     for (std::vector<TimeCacheInterfacePtr>::iterator cache_it = frames_.begin() + 1; cache_it != frames_.end(); ++cache_it)
@@ -211,15 +217,25 @@ BufferCore::set_transform(const StampedTransform &transform_in,
 	  return false;
   
   {
-    std::unique_lock<std::mutex> lock(frame_mutex_);
+    ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_WRITE);
     CompactFrameID frame_number = lookup_or_insert_frame_number(stripped.child_frame_id);
     TimeCacheInterfacePtr frame = get_frame(frame_number);
     if (! frame)
       frame = allocate_frame(frame_number, is_static);
 
+    CompactFrameID prev_parent = frame->get_latest_time_and_parent().second;
     if (frame->insert_data(TransformStorage(stripped, lookup_or_insert_frame_number(stripped.frame_id), frame_number)))
     {
       frame_authority_[frame_number] = authority;
+
+      // The tree changed, remembered frame chains might be outdated
+      if (frame->get_latest_time_and_parent().second != prev_parent) {
+        clear_frame_chains();
+      } else {
+        // no lookup is running, delete replaced maps
+        std::unique_lock<std::mutex> chains_lock(frame_chains_mutex_);
+        delete_retired_frame_chains();
+      }
     }
     else
     {
@@ -262,6 +278,105 @@ enum WalkEnding
   FullPath,
 };
 
+/// @cond INTERNAL
+/** Return value of walk_frame_chain() if the tree differs from the chain. */
+static const int FRAME_CHAIN_MISMATCH = -1;
+/// @endcond
+
+/** Get key for frame chain map.
+ * @param target_id frame number of target
+ * @param source_id frame number of source
+ * @return key for the pair of frames
+ */
+static inline uint64_t
+frame_chain_key(CompactFrameID target_id, CompactFrameID source_id)
+{
+  return ((uint64_t)target_id << 32) | source_id;
+}
+
+/** Find remembered frame chain.
+ * @param target_id frame number of target
+ * @param source_id frame number of source
+ * @return frame chain, or NULL if none has been remembered. The chain
+ * is valid as long as the frame lock is held.
+ */
+const BufferCore::FrameChain *
+BufferCore::find_frame_chain(CompactFrameID target_id, CompactFrameID source_id) const
+{
+  const M_FrameChain *chains = __atomic_load_n(&frame_chains_, __ATOMIC_ACQUIRE);
+  M_FrameChain::const_iterator c = chains->find(frame_chain_key(target_id, source_id));
+  return (c != chains->end()) ? &c->second : NULL;
+}
+
+/** Remember frame chain.
+ * This may be called with only the read lock held. The map is copied
+ * and the copy is published, the old map is deleted once the write
+ * lock is held the next time. No chain is added while the retired
+ * maps hold MAX_FRAME_CHAINS chains, this bounds the memory used by
+ * copies if no write lock is acquired for a while.
+ * @param target_id frame number of target
+ * @param source_id frame number of source
+ * @param chain frame chain between the two frames
+ */
+void
+BufferCore::add_frame_chain(CompactFrameID target_id, CompactFrameID source_id,
+                            const FrameChain &chain) const
+{
+  std::unique_lock<std::mutex> lock(frame_chains_mutex_);
+  if (frame_chains_->size() >= MAX_FRAME_CHAINS)  return;
+  if (num_retired_frame_chains_ + frame_chains_->size() + 1 > MAX_FRAME_CHAINS)  return;
+
+  M_FrameChain *chains = new M_FrameChain(*frame_chains_);
+  (*chains)[frame_chain_key(target_id, source_id)] = chain;
+  retired_frame_chains_.push_back(frame_chains_);
+  __atomic_store_n(&num_retired_frame_chains_,
+                   num_retired_frame_chains_ + frame_chains_->size() + 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&frame_chains_, chains, __ATOMIC_RELEASE);
+}
+
+/** Forget all frame chains.
+ * Must be called with the write lock held.
+ */
+void
+BufferCore::clear_frame_chains()
+{
+  std::unique_lock<std::mutex> lock(frame_chains_mutex_);
+  delete_retired_frame_chains();
+  if (! frame_chains_->empty()) {
+    delete frame_chains_;
+    frame_chains_ = new M_FrameChain();
+  }
+}
+
+/** Delete replaced frame chain maps.
+ * Must be called with the write lock and the frame chains mutex held.
+ */
+void
+BufferCore::delete_retired_frame_chains() const
+{
+  for (M_FrameChain *c : retired_frame_chains_)  delete c;
+  retired_frame_chains_.clear();
+  __atomic_store_n(&num_retired_frame_chains_, 0, __ATOMIC_RELAXED);
+}
+
+/** Reclaim replaced frame chain maps if no lookup is running.
+ * Called before locking for reading, such that the maps copied by
+ * lookups are freed without waiting for new transforms. Must be called
+ * without holding the frame lock.
+ */
+void
+BufferCore::reclaim_frame_chains() const
+{
+  if (__atomic_load_n(&num_retired_frame_chains_, __ATOMIC_RELAXED) == 0)  return;
+  if (frame_lock_.try_lock_for_write()) {
+    {
+      std::unique_lock<std::mutex> lock(frame_chains_mutex_);
+      delete_retired_frame_chains();
+    }
+    frame_lock_.unlock();
+  }
+}
+
 /** Traverse transform tree: walk from frame to top-parent of both.
  * @param f accumulator
  * @param time timestamp
@@ -275,7 +390,134 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time,
                                    CompactFrameID target_id, CompactFrameID source_id,
                                    std::string* error_string) const
 {
-  return walk_to_top_parent(f, time, target_id, source_id, error_string, NULL);
+  if (source_id == target_id)
+    return walk_to_top_parent(f, time, target_id, source_id, error_string, NULL);
+
+  // Hot pairs of frames are looked up over and over, only walk the
+  // frames between the two and not up to the root.
+  const FrameChain *known_chain = find_frame_chain(target_id, source_id);
+  if (known_chain) {
+    int retval = walk_frame_chain(f, time, target_id, source_id, *known_chain, error_string);
+    if (retval != FRAME_CHAIN_MISMATCH)
+      return retval;
+    f = F();
+  }
+
+  FrameChain chain;
+  int retval = walk_to_top_parent(f, time, target_id, source_id, error_string, NULL, &chain);
+  if (retval == NO_ERROR)
+    add_frame_chain(target_id, source_id, chain);
+  return retval;
+}
+
+/** Traverse known frame chain.
+ * The frames between source and target are known, walk only these.
+ * The parents of all frames are verified to match the chain.
+ * @param f accumulator
+ * @param time timestamp
+ * @param target_id frame number of target
+ * @param source_id frame number of source
+ * @param chain known frame chain between source and target
+ * @param error_string accumulated error string
+ * @return error flag from ErrorValues, or FRAME_CHAIN_MISMATCH if the
+ * frame tree differs from the chain at the given time
+ */
+template<typename F>
+int BufferCore::walk_frame_chain(F& f, fawkes::Time time,
+                                 CompactFrameID target_id, CompactFrameID source_id,
+                                 const FrameChain &chain, std::string* error_string) const
+{
+  const std::vector<CompactFrameID> &sf = chain.source_frames;
+  const std::vector<CompactFrameID> &tf = chain.target_frames;
+  // the common parent is the last parent on either side
+  CompactFrameID common_parent = tf.empty() ? target_id : (sf.empty() ? source_id : 0);
+
+  //If getting the latest get the latest common time
+  if (time == fawkes::Time(0,0))
+  {
+    fawkes::Time common_time = fawkes::TIME_MAX;
+    CompactFrameID top[2] = {common_parent, common_parent};
+    for (int side = 0; side < 2; ++side) {
+      const std::vector<CompactFrameID> &frames = (side == 0) ? sf : tf;
+      for (size_t i = 0; i < frames.size(); ++i) {
+        TimeCacheInterface *cache = get_frame_cache_ptr(frames[i]);
+        if (!cache)  return FRAME_CHAIN_MISMATCH;
+        P_TimeAndFrameID latest = cache->get_latest_time_and_parent();
+        if (latest.second == 0 ||
+            (i + 1 < frames.size() && latest.second != frames[i + 1]))
+        {
+          return FRAME_CHAIN_MISMATCH;
+        }
+        if (!latest.first.is_zero())
+          common_time = std::min(latest.first, common_time);
+        if (i + 1 == frames.size())  top[side] = latest.second;
+      }
+    }
+    if (top[0] != top[1])  return FRAME_CHAIN_MISMATCH;
+    time = (common_time == fawkes::TIME_MAX) ? fawkes::Time(0,0) : common_time;
+  }
+
+  std::string extrapolation_error_string;
+  bool extrapolation_occurred = false;
+  CompactFrameID source_top = 0;
+
+  for (size_t i = 0; i < sf.size(); ++i) {
+    TimeCacheInterface *cache = get_frame_cache_ptr(sf[i]);
+    if (!cache)  return FRAME_CHAIN_MISMATCH;
+    CompactFrameID parent = f.gather(cache, time, &extrapolation_error_string);
+    if (parent == 0) {
+      extrapolation_occurred = true;
+      break;
+    }
+    if (i + 1 < sf.size() && parent != sf[i + 1])  return FRAME_CHAIN_MISMATCH;
+    f.accum(true);
+    source_top = parent;
+  }
+
+  for (size_t i = 0; i < tf.size(); ++i) {
+    TimeCacheInterface *cache = get_frame_cache_ptr(tf[i]);
+    if (!cache)  return FRAME_CHAIN_MISMATCH;
+    CompactFrameID parent = f.gather(cache, time, error_string);
+    if (parent == 0) {
+      if (error_string)
+      {
+        std::stringstream ss;
+        ss << *error_string << ", when looking up transform from frame [" << lookup_frame_string(source_id) << "] to frame [" << lookup_frame_string(target_id) << "]";
+        *error_string = ss.str();
+      }
+      return EXTRAPOLATION_ERROR;
+    }
+    if (i + 1 < tf.size() && parent != tf[i + 1])  return FRAME_CHAIN_MISMATCH;
+    if (i + 1 == tf.size()) {
+      if (sf.empty() ? (parent != source_id)
+                     : (! extrapolation_occurred && parent != source_top))
+      {
+        return FRAME_CHAIN_MISMATCH;
+      }
+    }
+    f.accum(false);
+  }
+
+  if (extrapolation_occurred)
+  {
+    if (error_string)
+    {
+      std::stringstream ss;
+      ss << extrapolation_error_string << ", when looking up transform from frame [" << lookup_frame_string(source_id) << "] to frame [" << lookup_frame_string(target_id) << "]";
+      *error_string = ss.str();
+    }
+    return EXTRAPOLATION_ERROR;
+  }
+
+  if (tf.empty()) {
+    if (source_top != target_id)  return FRAME_CHAIN_MISMATCH;
+    f.finalize(TargetParentOfSource, time);
+  } else if (sf.empty()) {
+    f.finalize(SourceParentOfTarget, time);
+  } else {
+    f.finalize(FullPath, time);
+  }
+  return NO_ERROR;
 }
 
 /** Traverse transform tree: walk from frame to top-parent of both.
@@ -286,15 +528,22 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time,
  * @param error_string accumulated error string
  * @param frame_chain If frame_chain is not NULL, store the traversed
  * frame tree in vector frame_chain.
+ * @param chain If chain is not NULL, store the frames between source
+ * and target on a successful walk.
  * @return error flag from ErrorValues
  */
 template<typename F>
 int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID target_id,
                                    CompactFrameID source_id, std::string* error_string,
-                                   std::vector<CompactFrameID> *frame_chain) const
+                                   std::vector<CompactFrameID> *frame_chain,
+                                   FrameChain *chain) const
 {
   if (frame_chain)
     frame_chain->clear();
+  if (chain) {
+    chain->source_frames.clear();
+    chain->target_frames.clear();
+  }
 
   // Short circuit if zero length transform to allow lookups on non existant links
   if (source_id == target_id)
@@ -323,9 +572,11 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID targe
 
   while (frame != 0)
   {
-    TimeCacheInterfacePtr cache = get_frame(frame);
+    TimeCacheInterface *cache = get_frame_cache_ptr(frame);
     if (frame_chain)
       frame_chain->push_back(frame);
+    if (chain)
+      chain->source_frames.push_back(frame);
 
     if (!cache)
     {
@@ -347,6 +598,8 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID targe
     if (frame == target_id)
     {
       f.finalize(TargetParentOfSource, time);
+      if (chain)
+        chain->source_frames.pop_back();
       return NO_ERROR;
     }
 
@@ -376,9 +629,11 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID targe
 
   while (frame != top_parent)
   {
-    TimeCacheInterfacePtr cache = get_frame(frame);
+    TimeCacheInterface *cache = get_frame_cache_ptr(frame);
     if (frame_chain)
       reverse_frame_chain.push_back(frame);
+    if (chain)
+      chain->target_frames.push_back(frame);
 
     if (!cache)
     {
@@ -406,6 +661,11 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID targe
       {
         frame_chain->swap(reverse_frame_chain);
       }
+      if (chain)
+      {
+        chain->source_frames.clear();
+        chain->target_frames.pop_back();
+      }
       return NO_ERROR;
     }
 
@@ -447,6 +707,18 @@ int BufferCore::walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID targe
   }
 
   f.finalize(FullPath, time);
+  if (chain)
+  {
+    // Both walks end in top_parent, strip the common part to keep
+    // only the frames below the lowest common parent
+    std::vector<CompactFrameID> &sf = chain->source_frames;
+    std::vector<CompactFrameID> &tf = chain->target_frames;
+    tf.push_back(top_parent);
+    while (! sf.empty() && ! tf.empty() && sf.back() == tf.back()) {
+      sf.pop_back();
+      tf.pop_back();
+    }
+  }
   if (frame_chain)
   {
     // Pruning: Compare the chains starting at the parent (end) until they differ
@@ -487,7 +759,7 @@ struct TransformAccum
   {
   }
 
-  CompactFrameID gather(TimeCacheInterfacePtr cache, fawkes::Time time, std::string* error_string)
+  CompactFrameID gather(TimeCacheInterface *cache, fawkes::Time time, std::string* error_string)
   {
     if (!cache->get_data(time, st, error_string))
     {
@@ -574,7 +846,8 @@ BufferCore::lookup_transform(const std::string& target_frame,
                              const fawkes::Time& time,
                              StampedTransform& transform) const
 {
-	std::unique_lock<std::mutex> lock(frame_mutex_);
+	reclaim_frame_chains();
+	ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
 
 	if (target_frame == source_frame) {
 		transform.setIdentity();
@@ -663,7 +936,7 @@ BufferCore::lookup_transform(const std::string& target_frame, const fawkes::Time
 /// @cond INTERNAL
 struct CanTransformAccum
 {
-  CompactFrameID gather(TimeCacheInterfacePtr cache, fawkes::Time time, std::string* error_string)
+  CompactFrameID gather(TimeCacheInterface *cache, fawkes::Time time, std::string* error_string)
   {
     return cache->get_parent(time, error_string);
   }
@@ -723,7 +996,8 @@ bool
 BufferCore::can_transform_internal(CompactFrameID target_id, CompactFrameID source_id,
                                    const fawkes::Time& time, std::string* error_msg) const
 {
-  std::unique_lock<std::mutex> lock(frame_mutex_);
+  reclaim_frame_chains();
+  ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
   return can_transform_no_lock(target_id, source_id, time, error_msg);
 }
 
@@ -747,7 +1021,8 @@ BufferCore::can_transform(const std::string& target_frame, const std::string& so
 	if (warn_frame_id("canTransform argument source_frame", source_frame))
     return false;
 
-  std::unique_lock<std::mutex> lock(frame_mutex_);
+  reclaim_frame_chains();
+  ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
 
   CompactFrameID target_id = lookup_frame_number(target_frame);
   CompactFrameID source_id = lookup_frame_number(source_frame);
@@ -799,6 +1074,22 @@ BufferCore::get_frame(CompactFrameID frame_id) const
   }
 }
 
+/** Accessor to get frame cache pointer.
+ * Like get_frame(), but does not copy the shared pointer. This avoids
+ * modifying the reference count from concurrent lookups. The pointer
+ * is valid as long as the frame lock is held.
+ * @param frame_id The frameID of the desired Reference Frame
+ * @return pointer to time cache, NULL if there is none
+ */
+TimeCacheInterface *
+BufferCore::get_frame_cache_ptr(CompactFrameID frame_id) const
+{
+  if (frame_id >= frames_.size())
+    return NULL;
+  else
+    return frames_[frame_id].get();
+}
+
 /** Get compact ID for frame.
  * @param frameid_str frame ID string
  * @return compact frame ID, zero if frame unknown
@@ -881,7 +1172,7 @@ BufferCore::create_connectivity_error_string(CompactFrameID source_frame,
 std::string
 BufferCore::all_frames_as_string() const
 {
-  std::unique_lock<std::mutex> lock(frame_mutex_);
+  ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
   return this->all_frames_as_string_no_lock();
 }
 
@@ -950,7 +1241,7 @@ BufferCore::get_latest_common_time(CompactFrameID target_id, CompactFrameID sour
 
   if (source_id == target_id)
   {
-    TimeCacheInterfacePtr cache = get_frame(source_id);
+    TimeCacheInterface *cache = get_frame_cache_ptr(source_id);
     //Set time to latest timestamp of frameid in case of target and source frame id are the same
     if (cache)
       time = cache->get_latest_timestamp();
@@ -969,7 +1260,7 @@ BufferCore::get_latest_common_time(CompactFrameID target_id, CompactFrameID sour
   fawkes::Time common_time = fawkes::TIME_MAX;
   while (frame != 0)
   {
-    TimeCacheInterfacePtr cache = get_frame(frame);
+    TimeCacheInterface *cache = get_frame_cache_ptr(frame);
 
     if (!cache)
     {
@@ -1026,7 +1317,7 @@ BufferCore::get_latest_common_time(CompactFrameID target_id, CompactFrameID sour
   CompactFrameID common_parent = 0;
   while (true)
   {
-    TimeCacheInterfacePtr cache = get_frame(frame);
+    TimeCacheInterface *cache = get_frame_cache_ptr(frame);
 
     if (!cache)
     {
@@ -1131,7 +1422,7 @@ std::string
 BufferCore::all_frames_as_YAML(double current_time) const
 {
   std::stringstream mstream;
-  std::unique_lock<std::mutex> lock(frame_mutex_);
+  ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
 
   TransformStorage temp;
 
@@ -56,6 +56,7 @@
 #include <tf/transform_storage.h>
 
 #include <utils/time/time.h>
+#include <core/threading/read_write_lock.h>
 
 #include <string>
 #include <memory>
@@ -111,6 +112,7 @@ class BufferCore
 	static const int DEFAULT_CACHE_TIME = 10;  //!< The default amount of time to cache data in seconds
 	static const uint32_t MAX_GRAPH_DEPTH = 1000UL;  //!< Maximum number of times to recurse before
 																									 //! assuming the tree has a loop
+	static const unsigned int MAX_FRAME_CHAINS = 1024;  //!< Maximum number of frame pairs to remember frame chains for
 
 	BufferCore(float cache_time = DEFAULT_CACHE_TIME);
 	virtual ~BufferCore(void);
@@ -166,8 +168,10 @@ class BufferCore
    * first time. */
   V_TimeCacheInterface frames_;
   
-  /** \brief A mutex to protect testing and allocating new frames on the above vector. */
-  mutable std::mutex frame_mutex_;
+  /** \brief A lock to protect testing and allocating new frames on the above vector.
+   * Lookups only lock for reading and may run concurrently, adding
+   * transforms locks for writing. */
+  mutable ReadWriteLock frame_lock_;
 
   /** \brief A map from string frame ids to CompactFrameID */
   typedef std::unordered_map<std::string, CompactFrameID> M_StringToCompactFrameID;
@@ -182,9 +186,33 @@ class BufferCore
   /// How long to cache transform history
   float cache_time_;
 
+  /// @cond INTERNAL
+  /** Frames between a source and a target frame. */
+  typedef struct {
+    /** frames from the source up to the common parent, exclusively */
+    std::vector<CompactFrameID> source_frames;
+    /** frames from the target up to the common parent, exclusively */
+    std::vector<CompactFrameID> target_frames;
+  } FrameChain;
+  /** Map from target and source frame ID to frame chain. */
+  typedef std::unordered_map<uint64_t, FrameChain> M_FrameChain;
+  /// @endcond
+
+  /** Frame chains of previous lookups. Readers access the map without
+   * locking, it is replaced as a whole when a chain is added. Replaced
+   * maps are deleted when holding the write lock. */
+  mutable M_FrameChain *frame_chains_;
+  /** Replaced frame chain maps that may still be in use by readers. */
+  mutable std::vector<M_FrameChain *> retired_frame_chains_;
+  /** Number of chains in retired maps, each map counting at least one. */
+  mutable unsigned int num_retired_frame_chains_;
+  /** Mutex to serialize adding frame chains. */
+  mutable std::mutex frame_chains_mutex_;
+
   /************************* Internal Functions ****************************/
 
   TimeCacheInterfacePtr get_frame(CompactFrameID c_frame_id) const;
+  TimeCacheInterface *  get_frame_cache_ptr(CompactFrameID c_frame_id) const;
 
   TimeCacheInterfacePtr allocate_frame(CompactFrameID cfid, bool is_static);
 
@@ -210,7 +238,16 @@ class BufferCore
   int walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string) const;
 
   template<typename F>
-  int walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID> *frame_chain) const;
+  int walk_to_top_parent(F& f, fawkes::Time time, CompactFrameID target_id, CompactFrameID source_id, std::string* error_string, std::vector<CompactFrameID> *frame_chain, FrameChain *chain = NULL) const;
+
+  template<typename F>
+  int walk_frame_chain(F& f, fawkes::Time time, CompactFrameID target_id, CompactFrameID source_id, const FrameChain &chain, std::string* error_string) const;
+
+  const FrameChain * find_frame_chain(CompactFrameID target_id, CompactFrameID source_id) const;
+  void add_frame_chain(CompactFrameID target_id, CompactFrameID source_id, const FrameChain &chain) const;
+  void clear_frame_chains();
+  void reclaim_frame_chains() const;
+  void delete_retired_frame_chains() const;
 
   bool can_transform_internal(CompactFrameID target_id, CompactFrameID source_id,
                               const fawkes::Time& time, std::string* error_msg) const;
@@ -0,0 +1,215 @@
+
+/***************************************************************************
+ *  qa_tf_lookup_benchmark.cpp - Benchmark for tf transform lookups
+ *
+ *  Created: Tue Oct 20 10:14:36 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+// Do not include in api reference
+///@cond QA
+
+#include <tf/transformer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fawkes;
+using namespace fawkes::tf;
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.;
+}
+
+static void
+usage(const char *progname)
+{
+  printf("Usage: %s [-d depth] [-t trunk] [-r rate] [-c cache_sec] [-n lookups] [-j threads]\n"
+	 " -d depth      depth of each of the two branches of the frame tree\n"
+	 " -t trunk      depth of the trunk the two branches are attached to\n"
+	 " -r rate       publishing rate of each frame in Hz\n"
+	 " -c cache_sec  cache time in seconds, filled completely\n"
+	 " -n lookups    number of lookups per measurement\n"
+	 " -j threads    number of threads for concurrent lookups\n",
+	 progname);
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned int depth   = 10;
+  unsigned int trunk   = 5;
+  unsigned int rate    = 100;
+  float        cache   = 10.;
+  unsigned int lookups = 100000;
+  unsigned int threads = 4;
+
+  int c;
+  while ((c = getopt(argc, argv, "hd:t:r:c:n:j:")) != -1) {
+    switch (c) {
+    case 'd': depth   = atoi(optarg); break;
+    case 't': trunk   = atoi(optarg); break;
+    case 'j': threads = atoi(optarg); break;
+    case 'r': rate    = atoi(optarg); break;
+    case 'c': cache   = atof(optarg); break;
+    case 'n': lookups = atoi(optarg); break;
+    default:  usage(argv[0]); return (c == 'h') ? 0 : -1;
+    }
+  }
+  if (depth == 0 || rate == 0 || lookups == 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  // A trunk below /base with two branches attached to its top,
+  // lookups go from leaf to leaf over 2 * depth frames.
+  std::vector<std::string> parents, children;
+  std::string trunk_top = "/base";
+  for (unsigned int d = 1; d <= trunk; ++d) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "/t%u", d);
+    parents.push_back(trunk_top);
+    children.push_back(tmp);
+    trunk_top = tmp;
+  }
+  for (unsigned int b = 0; b < 2; ++b) {
+    std::string parent = trunk_top;
+    for (unsigned int d = 1; d <= depth; ++d) {
+      char tmp[32];
+      snprintf(tmp, sizeof(tmp), "/%c%u", 'a' + b, d);
+      parents.push_back(parent);
+      children.push_back(tmp);
+      parent = tmp;
+    }
+  }
+  const std::string &leaf_a = children[trunk + depth - 1];
+  const std::string &leaf_b = children.back();
+
+  Transformer transformer(cache);
+
+  unsigned int steps = (unsigned int)(cache * rate);
+  long step_usec = 1000000 / rate;
+  fawkes::Time start(1000000000L, 0L);
+  fawkes::Time t(start);
+
+  printf("Populating %zu frames with %u transforms each\n", children.size(), steps);
+  double t_insert_start = now();
+  for (unsigned int s = 0; s < steps; ++s) {
+    for (unsigned int i = 0; i < children.size(); ++i) {
+      Transform tr(create_quaternion_from_yaw(0.001 * s + 0.1 * i),
+		   Vector3(0.01 * s, 0.1 * i, 0.));
+      transformer.set_transform(StampedTransform(tr, t, parents[i], children[i]), "qa");
+    }
+    t += step_usec;
+  }
+  double t_insert = now() - t_insert_start;
+  fawkes::Time latest(t);
+  latest -= step_usec;
+  printf("Insert:  %8.1f ns per transform\n",
+	 t_insert * 1.e9 / (steps * children.size()));
+
+  // Lookup times spread over the cache, skipping the first step to
+  // avoid extrapolation, and taken between stored stamps to require
+  // interpolation.
+  std::vector<fawkes::Time> times(1024);
+  srand(42);
+  for (unsigned int i = 0; i < times.size(); ++i) {
+    times[i] = start;
+    times[i] += (long)(step_usec + rand() % ((steps - 2) * step_usec));
+  }
+
+  StampedTransform result;
+  double checksum = 0.;
+
+  double t_latest_start = now();
+  for (unsigned int i = 0; i < lookups; ++i) {
+    transformer.lookup_transform(leaf_a, leaf_b, fawkes::Time(0, 0), result);
+    checksum += result.getOrigin().x();
+  }
+  double t_latest = now() - t_latest_start;
+
+  double t_interp_start = now();
+  for (unsigned int i = 0; i < lookups; ++i) {
+    transformer.lookup_transform(leaf_a, leaf_b, times[i % times.size()], result);
+    checksum += result.getOrigin().x();
+  }
+  double t_interp = now() - t_interp_start;
+
+  double t_recent_start = now();
+  for (unsigned int i = 0; i < lookups; ++i) {
+    fawkes::Time rt(latest);
+    rt -= (long)((i % 10) * step_usec + step_usec / 2);
+    transformer.lookup_transform(leaf_a, leaf_b, rt, result);
+    checksum += result.getOrigin().x();
+  }
+  double t_recent = now() - t_recent_start;
+
+  printf("Lookup over %u frames (%u lookups each, checksum %f)\n",
+	 2 * depth, lookups, checksum);
+  printf("  latest:  %8.1f ns\n", t_latest * 1.e9 / lookups);
+  printf("  recent:  %8.1f ns\n", t_recent * 1.e9 / lookups);
+  printf("  random:  %8.1f ns\n", t_interp * 1.e9 / lookups);
+
+  if (threads > 1) {
+    // All threads look up the same pair of frames at recent times,
+    // while the main thread keeps adding transforms
+    bool running = true;
+    std::vector<std::thread> workers;
+    double t_threads_start = now();
+    for (unsigned int j = 0; j < threads; ++j) {
+      workers.push_back(std::thread([&, j]() {
+	StampedTransform r;
+	for (unsigned int i = 0; i < lookups; ++i) {
+	  fawkes::Time rt(latest);
+	  rt -= (long)(((i + j) % 10) * step_usec + step_usec / 2);
+	  transformer.lookup_transform(leaf_a, leaf_b, rt, r);
+	}
+      }));
+    }
+    std::thread writer([&]() {
+      fawkes::Time wt(latest);
+      while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+	wt += 1L;
+	Transform tr(create_quaternion_from_yaw(0.), Vector3(0., 0., 0.));
+	transformer.set_transform(StampedTransform(tr, wt, parents[0], children[0]), "qa");
+	usleep(1000);
+      }
+    });
+    for (unsigned int j = 0; j < threads; ++j)  workers[j].join();
+    double t_threads = now() - t_threads_start;
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    writer.join();
+
+    printf("Concurrent lookups in %u threads with 1 kHz writer\n", threads);
+    printf("  recent:  %8.1f ns per lookup and thread, %.0f lookups/sec\n",
+	   t_threads * 1.e9 / lookups, threads * lookups / t_threads);
+  }
+
+  return 0;
+}
+
+/// @endcond
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *  test_frame_chains.cpp - Remembered tf frame chains unit test
+ *
+ *  Created: Sat Oct 17 17:20:41 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <tf/transformer.h>
+#include <tf/exceptions.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace fawkes;
+using namespace fawkes::tf;
+
+/** Lookup result or failure, identical if both fail. */
+struct LookupResult {
+  bool             ok;	/**< true if the lookup succeeded */
+  StampedTransform st;	/**< looked up transform */
+};
+
+/** Lookup transform.
+ * @param transformer transformer to query
+ * @param target target frame
+ * @param source source frame
+ * @param sec time in seconds, 0 for the latest data
+ * @return lookup result
+ */
+static LookupResult
+lookup(Transformer &transformer, const char *target, const char *source, long sec)
+{
+  LookupResult r;
+  r.ok = true;
+  try {
+    transformer.lookup_transform(target, source, fawkes::Time(sec, 0), r.st);
+  } catch (Exception &e) {
+    r.ok = false;
+  }
+  return r;
+}
+
+/** Check if two lookup results are the same.
+ * @param a first result
+ * @param b second result
+ * @return true if both failed or both yield the same transform
+ */
+static bool
+same(const LookupResult &a, const LookupResult &b)
+{
+  if (a.ok != b.ok)  return false;
+  if (! a.ok)  return true;
+  if (a.st.stamp != b.st.stamp)  return false;
+  if (a.st.frame_id != b.st.frame_id || a.st.child_frame_id != b.st.child_frame_id) {
+    return false;
+  }
+  Vector3 d = a.st.getOrigin() - b.st.getOrigin();
+  double dot = a.st.getRotation().dot(b.st.getRotation());
+  return (d.length() < 1e-9 && std::fabs(std::fabs(dot) - 1.) < 1e-9);
+}
+
+/** @class FrameChainsTest
+ * Fixture with a long-lived transformer which remembers frame chains.
+ * All transforms are recorded and replayed into a new transformer whose
+ * first lookup walks the full tree. Initially /base has the branches
+ * a1 - a2 and b1 - b2, and c1 is below a1.
+ */
+class FrameChainsTest : public ::testing::Test
+{
+ protected:
+  virtual void SetUp()
+  {
+    add("/base", "/a1", 1, 0, 100);
+    add("/a1",   "/a2", 2, 0, 100);
+    add("/base", "/b1", 0, 1, 100);
+    add("/b1",   "/b2", 0, 2, 100);
+    add("/a1",   "/c1", 3, 3, 100);
+    add("/base", "/a1", 1, 0, 102);
+    add("/a1",   "/a2", 2, 0, 102);
+    add("/base", "/b1", 0, 1, 102);
+    add("/b1",   "/b2", 0, 2, 102);
+    add("/a1",   "/c1", 3, 3, 102);
+  }
+
+  /** Add transform.
+   * @param parent parent frame
+   * @param child child frame
+   * @param x translation in x, also determines the rotation
+   * @param y translation in y
+   * @param sec time stamp in seconds
+   */
+  void add(const char *parent, const char *child, double x, double y, long sec)
+  {
+    Transform t(create_quaternion_from_yaw(x * 0.1), Vector3(x, y, 0.));
+    StampedTransform st(t, fawkes::Time(sec, 0), parent, child);
+    history.push_back(st);
+    transformer.set_transform(st, "test");
+  }
+
+  /** Compare lookup in the long-lived transformer with a full walk.
+   * @param target target frame
+   * @param source source frame
+   * @param sec time in seconds, 0 for the latest data
+   * @param what description of the check
+   */
+  void compare(const char *target, const char *source, long sec, const char *what)
+  {
+    // twice, the first might only remember the chain
+    lookup(transformer, target, source, sec);
+    LookupResult rc = lookup(transformer, target, source, sec);
+
+    Transformer fresh;
+    for (size_t i = 0; i < history.size(); ++i) {
+      fresh.set_transform(history[i], "test");
+    }
+    LookupResult rf = lookup(fresh, target, source, sec);
+    EXPECT_TRUE(same(rc, rf)) << what;
+  }
+
+  /** Look up frequently used frame pairs to have their chains remembered. */
+  void remember_chains()
+  {
+    const char *pairs[][2] = { { "/a2", "/b2" }, { "/b2", "/a2" }, { "/a2", "/c1" },
+			       { "/base", "/a2" }, { "/a2", "/base" } };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i) {
+      lookup(transformer, pairs[i][0], pairs[i][1], 0);
+      lookup(transformer, pairs[i][0], pairs[i][1], 0);
+      lookup(transformer, pairs[i][0], pairs[i][1], 101);
+    }
+  }
+
+  /** Re-parent a1 below b2.
+   * The common parent of a2 and c1 stays a1, the common parent of
+   * a2 and b2 changes from base to b2.
+   */
+  void reparent_below_b2()
+  {
+    add("/b2", "/a1", 5, 5, 104);
+    add("/a1", "/a2", 2, 0, 104);
+    add("/b1", "/b2", 0, 2, 104);
+    add("/base", "/b1", 0, 1, 104);
+    add("/a1", "/c1", 3, 3, 104);
+  }
+
+  /** Long-lived transformer. */
+  Transformer                   transformer;
+  /** All transforms added so far. */
+  std::vector<StampedTransform> history;
+};
+
+TEST_F(FrameChainsTest, InitialTree)
+{
+  compare("/a2", "/b2", 0,   "leaf to leaf, latest");
+  compare("/a2", "/b2", 101, "leaf to leaf, interpolated");
+  compare("/b2", "/a2", 101, "leaf to leaf, reversed");
+  compare("/a2", "/c1", 101, "siblings");
+  compare("/base", "/a2", 0, "target parent of source");
+  compare("/a2", "/base", 0, "source parent of target");
+}
+
+TEST_F(FrameChainsTest, Reparented)
+{
+  remember_chains();
+  reparent_below_b2();
+
+  compare("/a2", "/b2", 0,   "latest");
+  compare("/a2", "/b2", 103, "interpolated");
+  compare("/a2", "/b2", 101, "before change");
+  compare("/b2", "/a2", 0,   "reversed");
+  compare("/a2", "/c1", 0,   "siblings");
+  compare("/base", "/a2", 0, "to root");
+}
+
+TEST_F(FrameChainsTest, OutOfOrderParent)
+{
+  remember_chains();
+  reparent_below_b2();
+  remember_chains();
+
+  // out-of-order data with another parent, the latest parent of a1
+  // stays b2 and remembered chains are not dropped
+  add("/base", "/a1", 7, 0, 103);
+  compare("/a2", "/b2", 103, "at out-of-order stamp");
+  compare("/a2", "/b2", 104, "later");
+  compare("/a2", "/b2", 0,   "latest");
+}
+
+TEST_F(FrameChainsTest, ReparentedBack)
+{
+  remember_chains();
+  reparent_below_b2();
+  remember_chains();
+
+  add("/base", "/a1", 1, 0, 106);
+  add("/a1",   "/a2", 2, 0, 106);
+  add("/a1",   "/c1", 3, 3, 106);
+  compare("/a2", "/b2", 0,   "latest");
+  compare("/a2", "/b2", 105, "interpolated");
+  compare("/a2", "/b2", 110, "extrapolation");
+}
+
+TEST_F(FrameChainsTest, DisconnectedFrames)
+{
+  remember_chains();
+  add("/other", "/o1", 1, 1, 106);
+  compare("/a2", "/o1", 0, "disconnected frames");
+}
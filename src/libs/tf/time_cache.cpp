@@ -143,17 +143,27 @@ TransformStorage::TransformStorage(const StampedTransform& data,
 
 /** @class TimeCache <tf/time_cache.h>
  * Time based transform cache.
- * A class to keep a sorted linked list in time. This builds and
- * maintains a list of timestamped data.  And provides lookup
- * functions to get data out as a function of time.
+ * A class to keep a sorted list in time. This builds and maintains a
+ * list of timestamped data.  And provides lookup functions to get
+ * data out as a function of time.
+ *
+ * The data is kept in a ring buffer sorted by time. Lookups perform a
+ * binary search, inserting data newer than all stored data and
+ * pruning old data are O(1). The storage is grown by doubling and
+ * never shrunk, after the cache has been filled once no further
+ * allocations happen.
  */
 
 /** Constructor.
  * @param max_storage_time maximum time in seconds to cache, defaults to 10 seconds
  */
 TimeCache::TimeCache(float max_storage_time)
-: max_storage_time_(max_storage_time)
-{}
+: head_(0), size_(0), mask_(0),
+  max_storage_time_(max_storage_time),
+  max_storage_usec_((int64_t)((double)max_storage_time * 1000000.))
+{
+  reserve(INITIAL_CAPACITY);
+}
 
 /** Destructor. */
 TimeCache::~TimeCache()
@@ -225,6 +235,50 @@ create_extrapolation_exception3(fawkes::Time t0, fawkes::Time t1, std::string* e
   }
 }
 
+/** Find position of first element newer than the given time.
+ * @param stamp time stamp in microseconds
+ * @return position of the first element with a time stamp greater
+ * than @p stamp, or the number of elements if there is none
+ */
+size_t
+TimeCache::upper_bound(int64_t stamp) const
+{
+  size_t first = 0, count = size_;
+  while (count > 0) {
+    size_t step = count / 2;
+    if (stamp_at(first + step) <= stamp) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return first;
+}
+
+/** Grow storage.
+ * @param capacity minimum number of elements to make room for, the
+ * capacity is rounded up to the next power of two
+ */
+void
+TimeCache::reserve(size_t capacity)
+{
+  size_t new_capacity = 1;
+  while (new_capacity < capacity)  new_capacity <<= 1;
+  if (new_capacity <= storage_.size())  return;
+
+  std::vector<TransformStorage> storage(new_capacity);
+  std::vector<int64_t>          stamps(new_capacity);
+  for (size_t i = 0; i < size_; ++i) {
+    storage[i] = at(i);
+    stamps[i]  = stamp_at(i);
+  }
+  storage_.swap(storage);
+  stamps_.swap(stamps);
+  head_ = 0;
+  mask_ = new_capacity - 1;
+}
+
 /// A helper function for getData
 //Assumes storage is already locked for it
 uint8_t
@@ -232,21 +286,23 @@ TimeCache::find_closest(TransformStorage*& one, TransformStorage*& two,
                         fawkes::Time target_time, std::string* error_str)
 {
   //No values stored
-  if (storage_.empty()) {
+  if (size_ == 0) {
     if (error_str) *error_str = "Transform cache storage is empty";
     return 0;
   }
 
   //If time == 0 return the latest
   if (target_time.is_zero()) {
-    one = &storage_.front();
+    one = &at(size_ - 1);
     return 1;
   }
 
+  int64_t target = target_time.in_usec();
+
   // One value stored
-  if (++storage_.begin() == storage_.end()) {
-    TransformStorage& ts = *storage_.begin();
-    if (ts.stamp == target_time) {
+  if (size_ == 1) {
+    TransformStorage& ts = at(0);
+    if (stamp_at(0) == target) {
       one = &ts;
       return 1;
     } else {
@@ -255,35 +311,32 @@ TimeCache::find_closest(TransformStorage*& one, TransformStorage*& two,
     }
   }
 
-  fawkes::Time latest_time = (*storage_.begin()).stamp;
-  fawkes::Time earliest_time = (*(storage_.rbegin())).stamp;
+  int64_t latest_time = stamp_at(size_ - 1);
+  int64_t earliest_time = stamp_at(0);
 
-  if (target_time == latest_time) {
-    one = &(*storage_.begin());
+  if (target == latest_time) {
+    one = &at(size_ - 1);
     return 1;
-  } else if (target_time == earliest_time) {
-    one = &(*storage_.rbegin());
+  } else if (target == earliest_time) {
+    one = &at(0);
     return 1;
-  } else if (target_time > latest_time) {
+  } else if (target > latest_time) {
     // Catch cases that would require extrapolation
-    create_extrapolation_exception2(target_time, latest_time, error_str);
+    create_extrapolation_exception2(target_time, at(size_ - 1).stamp, error_str);
     return 0;
-  } else if (target_time < earliest_time) {
-    create_extrapolation_exception3(target_time, earliest_time, error_str);
+  } else if (target < earliest_time) {
+    create_extrapolation_exception3(target_time, at(0).stamp, error_str);
     return 0;
   }
 
   //At least 2 values stored
-  //Find the first value less than the target value
-  L_TransformStorage::iterator storage_it = storage_.begin();
-  while(storage_it != storage_.end()) {
-    if (storage_it->stamp <= target_time)  break;
-    storage_it++;
-  }
+  //Find the newest value less than or equal to the target value,
+  //cannot be the newest element as target < latest_time
+  size_t pos = upper_bound(target) - 1;
 
   //Finally the case were somewhere in the middle  Guarenteed no extrapolation :-)
-  one = &*(storage_it); //Older
-  two = &*(--storage_it); //Newer
+  one = &at(pos); //Older
+  two = &at(pos + 1); //Newer
   return 2;
 }
 
@@ -318,14 +371,15 @@ TimeCacheInterfacePtr
 TimeCache::clone(const fawkes::Time &look_back_until) const
 {
 	TimeCache *copy = new TimeCache(max_storage_time_);
-	if (look_back_until.is_zero()) {
-		copy->storage_ = storage_;
-	} else {
-		L_TransformStorage::const_iterator storage_it = storage_.begin();
-		for (storage_it = storage_.begin(); storage_it != storage_.end(); ++storage_it) {
-			if (storage_it->stamp <= look_back_until)  break;
-			copy->storage_.push_back(*storage_it);
-		}
+	size_t first = 0;
+	if (! look_back_until.is_zero()) {
+		first = upper_bound(look_back_until.in_usec());
+	}
+	copy->reserve(size_ - first);
+	for (size_t i = first; i < size_; ++i) {
+		copy->storage_[copy->size_] = at(i);
+		copy->stamps_[copy->size_]  = stamp_at(i);
+		copy->size_ += 1;
 	}
 	return std::shared_ptr<TimeCacheInterface>(copy);
 }
@@ -372,88 +426,108 @@ TimeCache::get_parent(fawkes::Time time, std::string* error_str)
 bool
 TimeCache::insert_data(const TransformStorage& new_data)
 {
-  L_TransformStorage::iterator storage_it = storage_.begin();
+  int64_t stamp = new_data.stamp.in_usec();
+  int64_t latest_stamp = stamp;
 
-  if(storage_it != storage_.end()) {
-    if (storage_it->stamp > new_data.stamp + max_storage_time_) {
+  if (size_ > 0) {
+    if (stamp_at(size_ - 1) > stamp + max_storage_usec_) {
       return false;
     }
+    if (stamp_at(size_ - 1) > latest_stamp)  latest_stamp = stamp_at(size_ - 1);
   }
 
+  // prune before inserting so that a full cache does not grow
+  prune_list(latest_stamp);
+
+  if (size_ == storage_.size())  reserve(size_ + 1);
 
-  while(storage_it != storage_.end()) {
-    if (storage_it->stamp <= new_data.stamp)
-      break;
-    storage_it++;
+  // insert behind all elements with the same or an older time stamp,
+  // commonly this is the end and no elements need to be moved
+  size_t pos = size_;
+  if (size_ > 0 && stamp < stamp_at(size_ - 1))  pos = upper_bound(stamp);
+  for (size_t i = size_; i > pos; --i) {
+    at(i) = at(i - 1);
+    stamps_[(head_ + i) & mask_] = stamp_at(i - 1);
   }
-  storage_.insert(storage_it, new_data);
+  at(pos) = new_data;
+  stamps_[(head_ + pos) & mask_] = stamp;
+  size_ += 1;
 
-  prune_list();
   return true;
 }
 
 void
 TimeCache::clear_list()
 {
-  storage_.clear();
+  head_ = 0;
+  size_ = 0;
 }
 
 unsigned int
 TimeCache::get_list_length() const
 {
-  return storage_.size();
+  return size_;
 }
 
 
+/** Get storage list.
+ * The list is ordered from the newest to the oldest element. It is
+ * created from the ring buffer on each call and remains valid until the
+ * next call to this method.
+ * @return reference to list of storage elements
+ */
 const TimeCacheInterface::L_TransformStorage &
 TimeCache::get_storage() const
 {
-  return storage_;
+  storage_list_ = get_storage_copy();
+  return storage_list_;
 }
 
 TimeCacheInterface::L_TransformStorage
 TimeCache::get_storage_copy() const
 {
-  return storage_;
+  L_TransformStorage rv;
+  for (size_t i = size_; i > 0; --i) {
+    rv.push_back(at(i - 1));
+  }
+  return rv;
 }
 
 P_TimeAndFrameID
 TimeCache::get_latest_time_and_parent()
 {
-  if (storage_.empty()) {
+  if (size_ == 0) {
     return std::make_pair(fawkes::Time(), 0);
   }
 
-  const TransformStorage& ts = storage_.front();
+  const TransformStorage& ts = at(size_ - 1);
   return std::make_pair(ts.stamp, ts.frame_id);
 }
 
 fawkes::Time
 TimeCache::get_latest_timestamp() const
 {
-  if (storage_.empty()) return fawkes::Time(0,0); //empty list case
-  return storage_.front().stamp;
+  if (size_ == 0) return fawkes::Time(0,0); //empty list case
+  return at(size_ - 1).stamp;
 }
 
 fawkes::Time
 TimeCache::get_oldest_timestamp() const
 {
-  if (storage_.empty()) return fawkes::Time(0,0); //empty list case
-  return storage_.back().stamp;
+  if (size_ == 0) return fawkes::Time(0,0); //empty list case
+  return at(0).stamp;
 }
 
-/** Prune storage list based on maximum cache lifetime. */
+/** Prune storage list based on maximum cache lifetime.
+ * @param latest_stamp time stamp of latest element in microseconds
+ */
 void
-TimeCache::prune_list()
+TimeCache::prune_list(int64_t latest_stamp)
 {
-  fawkes::Time latest_time = storage_.begin()->stamp;
-  
-  while(!storage_.empty() &&
-        storage_.back().stamp + max_storage_time_ < latest_time)
-  {
-    storage_.pop_back();
+  while (size_ > 0 && stamp_at(0) + max_storage_usec_ < latest_stamp) {
+    head_ = (head_ + 1) & mask_;
+    size_ -= 1;
   }
-
 }
 
 
@@ -56,6 +56,7 @@
 #include <tf/transform_storage.h>
 
 #include <list>
+#include <vector>
 #include <cstdint>
 #include <memory>
 
@@ -101,6 +102,8 @@ class TimeCache : public TimeCacheInterface
   static const unsigned int MAX_LENGTH_LINKED_LIST = 1000000;
   /// default value of 10 seconds storage
   static const int64_t DEFAULT_MAX_STORAGE_TIME = 1ULL * 1000000000LL; //!< default value of 10 seconds storage
+  /// Number of transforms storage is initially allocated for.
+  static const unsigned int INITIAL_CAPACITY = 64;
   
   TimeCache(float max_storage_time = DEFAULT_MAX_STORAGE_TIME);
   virtual ~TimeCache();
@@ -121,10 +124,26 @@ class TimeCache : public TimeCacheInterface
   virtual fawkes::Time get_oldest_timestamp() const;
 
  private:
-  L_TransformStorage storage_;
-
-  float max_storage_time_;
-
+  /** Get element by position.
+   * @param i position, 0 is the oldest element
+   * @return reference to element */
+  inline TransformStorage & at(size_t i)
+  { return storage_[(head_ + i) & mask_]; }
+
+  /** Get element by position.
+   * @param i position, 0 is the oldest element
+   * @return reference to element */
+  inline const TransformStorage & at(size_t i) const
+  { return storage_[(head_ + i) & mask_]; }
+
+  /** Get time stamp of element by position.
+   * @param i position, 0 is the oldest element
+   * @return time stamp in microseconds */
+  inline int64_t stamp_at(size_t i) const
+  { return stamps_[(head_ + i) & mask_]; }
+
+  size_t upper_bound(int64_t stamp) const;
+  void   reserve(size_t capacity);
 
   inline uint8_t find_closest(TransformStorage*& one, TransformStorage*& two,
                               fawkes::Time target_time, std::string* error_str);
@@ -132,7 +151,21 @@ class TimeCache : public TimeCacheInterface
   inline void interpolate(const TransformStorage& one, const TransformStorage& two,
                           fawkes::Time time, TransformStorage& output);
 
-  void prune_list();
+  void prune_list(int64_t latest_stamp);
+
+ private:
+  // Ring buffer sorted by time, oldest element at head_. The time
+  // stamps are kept separately for a cache-friendly binary search.
+  std::vector<TransformStorage> storage_;
+  std::vector<int64_t>          stamps_;
+  size_t head_;
+  size_t size_;
+  size_t mask_;
+
+  mutable L_TransformStorage storage_list_;
+
+  float   max_storage_time_;
+  int64_t max_storage_usec_;
 };
 
 
@@ -55,6 +55,7 @@
 #include <tf/utils.h>
 
 #include <core/threading/mutex_locker.h>
+#include <core/threading/scoped_rwlock.h>
 #include <core/macros.h>
 #include <iostream>
 #include <sstream>
@@ -143,7 +144,7 @@ Transformer::get_cache_time() const
 void
 Transformer::lock()
 {
-  frame_mutex_.lock();
+  frame_lock_.lock_for_write();
 }
 
 
@@ -153,7 +154,7 @@ Transformer::lock()
 bool
 Transformer::try_lock()
 {
-  return frame_mutex_.try_lock();
+  return frame_lock_.try_lock_for_write();
 }
 
 
@@ -163,7 +164,7 @@ Transformer::try_lock()
 void
 Transformer::unlock()
 {
-  frame_mutex_.unlock();
+  frame_lock_.unlock();
 }
 
 
@@ -174,7 +175,7 @@ Transformer::unlock()
 bool
 Transformer::frame_exists(const std::string& frame_id_str) const
 {
-	std::unique_lock<std::mutex> lock(frame_mutex_);
+	ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
 
 	return (frameIDs_.count(frame_id_str) > 0);
 }
@@ -661,7 +662,7 @@ Transformer::transform_pose(const std::string& target_frame,
 std::string
 Transformer::all_frames_as_dot(bool print_time, fawkes::Time *time) const
 {
-	std::unique_lock<std::mutex> lock(frame_mutex_);
+	ScopedRWLock lock(&frame_lock_, ScopedRWLock::LOCK_READ);
 
 	fawkes::Time current_time;
 	if (time)  *time = current_time;
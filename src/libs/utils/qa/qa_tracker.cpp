@@ -0,0 +1,81 @@
+
+/***************************************************************************
+ *  qa_tracker.cpp - QA for time tracker overhead and summaries
+ *
+ *  Created: Fri Oct 16 23:10:48 2026
+ *  Copyright  2005-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+/// @cond QA
+
+#include <utils/time/tracker.h>
+#include <utils/time/time.h>
+
+#include <unistd.h>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace fawkes;
+
+static void
+measure(TimeTracker &tt, const char *name, unsigned int num_pings)
+{
+  unsigned int ttc_empty = tt.add_class(name);
+
+  Time start;
+  for (unsigned int i = 0; i < num_pings; ++i) {
+    ScopedClassItemTracker scope(tt, ttc_empty);
+  }
+  Time end;
+
+  TimeTracker::Summary s = tt.summary(ttc_empty);
+  printf("%-10s %8lu pings  %7.1f ns/ping  p50=%.0f ns  p99=%.0f ns  max=%.0f ns\n",
+	 name, s.count, (end.in_sec() - start.in_sec()) * 1e9 / num_pings,
+	 s.p50 * 1e9, s.p99 * 1e9, s.max * 1e9);
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned int num_pings = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+  TimeTracker tt;
+  measure(tt, "monotonic", num_pings);
+
+  tt.set_clock_source(TimeTracker::CLOCK_SOURCE_TSC);
+  if (tt.clock_source() == TimeTracker::CLOCK_SOURCE_TSC) {
+    measure(tt, "tsc", num_pings);
+  }
+
+  // known durations to check the percentiles and tick conversion
+  tt.set_sample_capacity(100);
+  unsigned int ttc_sleep = tt.add_class("usleep 0.1..10 ms");
+  for (unsigned int i = 1; i <= 100; ++i) {
+    tt.ping_start(ttc_sleep);
+    usleep(i * 100);
+    tt.ping_end(ttc_sleep);
+  }
+  TimeTracker::Summary s = tt.summary(ttc_sleep);
+  printf("sleep      p50=%.2f ms (~5)  p95=%.2f ms (~9.5)  p99=%.2f ms (~9.9)  max=%.2f ms\n",
+	 s.p50 * 1000., s.p95 * 1000., s.p99 * 1000., s.max * 1000.);
+
+  tt.print_to_stdout();
+  return 0;
+}
+
+/// @endcond
@@ -0,0 +1,128 @@
+/***************************************************************************
+ *  test_histogram.cpp - Time histogram unit test
+ *
+ *  Created: Sat Oct 17 21:41:16 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/time/histogram.h>
+
+using namespace fawkes;
+
+/** Largest value, copy to avoid odr-use of the class constant. */
+static const uint64_t MAX_VALUE = TimeHistogram::MAX_VALUE;
+/** Number of values below which buckets are exact. */
+static const uint64_t EXACT_LIMIT = 1ULL << TimeHistogram::SUB_BUCKET_BITS;
+
+/** Get upper bound of the bucket a value falls into.
+ * @param v value to look up
+ * @return upper bound of the bucket of v
+ */
+static uint64_t
+bucket_upper(uint64_t v)
+{
+  // with a larger second value the median is the bucket bound of v
+  TimeHistogram h;
+  h.record(v);
+  h.record(MAX_VALUE);
+  return h.percentile(50.);
+}
+
+
+TEST(TimeHistogramTest, Empty)
+{
+  TimeHistogram h;
+  EXPECT_EQ(0u, h.count());
+  EXPECT_EQ(0u, h.max());
+  EXPECT_EQ(0., h.mean());
+  EXPECT_EQ(0u, h.percentile(50.));
+}
+
+TEST(TimeHistogramTest, ExactSmallValues)
+{
+  for (uint64_t v = 0; v < EXACT_LIMIT; ++v) {
+    EXPECT_EQ(v, bucket_upper(v));
+  }
+}
+
+TEST(TimeHistogramTest, BucketBoundaries)
+{
+  // a power of two starts a bucket, the value before ends the previous one
+  for (unsigned int k = TimeHistogram::SUB_BUCKET_BITS; k < 40; ++k) {
+    uint64_t p = 1ULL << k;
+    uint64_t width = 1ULL << (k - TimeHistogram::SUB_BUCKET_BITS + 1);
+    EXPECT_EQ(p - 1, bucket_upper(p - 1)) << "2^" << k << " - 1";
+    EXPECT_EQ(p + width - 1, bucket_upper(p)) << "2^" << k;
+    EXPECT_EQ(p + width - 1, bucket_upper(p + width - 1)) << "2^" << k << " + width - 1";
+    EXPECT_EQ(p + 2 * width - 1, bucket_upper(p + width)) << "2^" << k << " + width";
+  }
+}
+
+TEST(TimeHistogramTest, RelativeError)
+{
+  const double bound = 1. / (1ULL << (TimeHistogram::SUB_BUCKET_BITS - 1));
+  for (uint64_t v = 1; v < MAX_VALUE; v = v * 9 / 8 + 1) {
+    uint64_t u = bucket_upper(v);
+    EXPECT_GE(u, v);
+    EXPECT_LT((double)(u - v) / v, bound) << "value " << v;
+  }
+}
+
+TEST(TimeHistogramTest, Statistics)
+{
+  // 1 us to 1 ms in steps of 1 us
+  TimeHistogram h;
+  for (uint64_t i = 1; i <= 1000; ++i)  h.record(i * 1000);
+  const double bound = 1. / (1ULL << (TimeHistogram::SUB_BUCKET_BITS - 1));
+
+  EXPECT_EQ(1000u, h.count());
+  EXPECT_EQ(1000000u, h.max());
+  EXPECT_DOUBLE_EQ(500500., h.mean());
+  EXPECT_GE(h.percentile(50.), 500000u);
+  EXPECT_LT(h.percentile(50.), 500000 * (1. + bound));
+  EXPECT_GE(h.percentile(99.), 990000u);
+  EXPECT_LT(h.percentile(99.), 990000 * (1. + bound));
+  EXPECT_EQ(1000000u, h.percentile(100.));
+  EXPECT_GE(h.percentile(0.), 1000u);
+  EXPECT_LT(h.percentile(0.), 1000 * (1. + bound));
+}
+
+TEST(TimeHistogramTest, Clamp)
+{
+  TimeHistogram h;
+  h.record(MAX_VALUE + 10);
+  EXPECT_EQ(MAX_VALUE, h.max());
+  EXPECT_EQ(MAX_VALUE, h.percentile(100.));
+}
+
+TEST(TimeHistogramTest, Reset)
+{
+  TimeHistogram h;
+  for (uint64_t i = 1; i <= 100; ++i)  h.record(i);
+  h.reset();
+  EXPECT_EQ(0u, h.count());
+  EXPECT_EQ(0u, h.max());
+  EXPECT_EQ(0., h.mean());
+  EXPECT_EQ(0u, h.percentile(99.));
+  h.record(42);
+  EXPECT_EQ(1u, h.count());
+  EXPECT_EQ(42u, h.max());
+  EXPECT_EQ(42u, h.percentile(50.));
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *  test_tracker.cpp - Time tracker unit test
+ *
+ *  Created: Sat Oct 17 21:08:44 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/time/tracker.h>
+#include <core/exception.h>
+
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+using namespace fawkes;
+
+/** Check scoped pings of an empty block.
+ * @param tt time tracker to use
+ * @param num_pings number of pings
+ */
+static void
+check_scoped(TimeTracker &tt, unsigned int num_pings)
+{
+  unsigned int ttc_empty = tt.add_class("empty");
+  for (unsigned int i = 0; i < num_pings; ++i) {
+    ScopedClassItemTracker scope(tt, ttc_empty);
+  }
+
+  TimeTracker::Summary s = tt.summary(ttc_empty);
+  EXPECT_EQ(num_pings, s.count);
+  EXPECT_EQ(std::min(num_pings, tt.sample_capacity()), s.window);
+  EXPECT_LE(s.p50, s.p99);
+  EXPECT_LE(s.p99, s.max);
+}
+
+
+TEST(TimeTrackerTest, ScopedMonotonic)
+{
+  TimeTracker tt;
+  check_scoped(tt, 10000);
+}
+
+TEST(TimeTrackerTest, ScopedTSC)
+{
+  TimeTracker tt;
+  tt.set_clock_source(TimeTracker::CLOCK_SOURCE_TSC);
+  check_scoped(tt, 10000);
+}
+
+TEST(TimeTrackerTest, KnownDurations)
+{
+  // known durations to check the percentiles, sleeps only take longer
+  // than requested, allow generous scheduling delays
+  TimeTracker tt;
+  tt.set_sample_capacity(100);
+  unsigned int ttc_sleep = tt.add_class("usleep 0.1..10 ms");
+  for (unsigned int i = 1; i <= 100; ++i) {
+    tt.ping_start(ttc_sleep);
+    usleep(i * 100);
+    tt.ping_end(ttc_sleep);
+  }
+  TimeTracker::Summary s = tt.summary(ttc_sleep);
+  EXPECT_EQ(100u, s.count);
+  EXPECT_EQ(100u, s.window);
+  EXPECT_GE(s.p50, 0.0050);
+  EXPECT_LT(s.p50, 0.0250);
+  EXPECT_GE(s.p95, 0.0095);
+  EXPECT_LT(s.p95, 0.0300);
+  EXPECT_GE(s.p99, 0.0099);
+  EXPECT_LE(s.p99, s.max);
+  EXPECT_GE(s.avg, 0.00505);
+  EXPECT_LT(s.avg, 0.0250);
+  EXPECT_GT(s.dev, 0.0015);
+  EXPECT_LT(s.dev, s.avg);
+
+  // ring wraps, count and max since reset, the rest over the window
+  for (unsigned int i = 0; i < 50; ++i) {
+    tt.ping_start(ttc_sleep);
+    tt.ping_end(ttc_sleep);
+  }
+  TimeTracker::Summary w = tt.summary(ttc_sleep);
+  EXPECT_EQ(150u, w.count);
+  EXPECT_EQ(100u, w.window);
+  EXPECT_DOUBLE_EQ(s.max, w.max);
+  // window holds sleeps of 5.1..10 ms and 50 empty times
+  EXPECT_GE(w.avg, 0.00378);
+  EXPECT_LT(w.avg, s.avg * 0.9);
+  EXPECT_LT(w.p50, 0.0050);
+}
+
+TEST(TimeTrackerTest, Abort)
+{
+  TimeTracker tt;
+  unsigned int ttc = tt.add_class("abort");
+  tt.ping_start(ttc);
+  tt.ping_end(ttc);
+  tt.ping_start(ttc);
+  tt.ping_abort(ttc);
+  tt.ping_end(ttc);
+  EXPECT_EQ(1u, tt.summary(ttc).count);
+}
+
+TEST(TimeTrackerTest, ClassPing)
+{
+  // class pings take the time since the last ping of any class
+  TimeTracker tt;
+  unsigned int ttc_a = tt.add_class("ping a");
+  unsigned int ttc_b = tt.add_class("ping b");
+  usleep(20000);
+  tt.ping(ttc_a);
+  tt.ping(ttc_b);
+  TimeTracker::Summary a = tt.summary(ttc_a);
+  TimeTracker::Summary b = tt.summary(ttc_b);
+  EXPECT_EQ(1u, a.count);
+  EXPECT_GE(a.avg, 0.020);
+  EXPECT_EQ(1u, b.count);
+  EXPECT_LT(b.avg, 0.010);
+
+  EXPECT_THROW(tt.ping(ttc_b + 1), Exception);
+}
+
+TEST(TimeTrackerTest, ClasslessPingRing)
+{
+  // classless pings are bounded by the sample capacity
+  TimeTracker tt;
+  tt.set_sample_capacity(4);
+  for (unsigned int i = 0; i < 10; ++i) {
+    char comment[8];
+    snprintf(comment, sizeof(comment), "c%u", i);
+    tt.ping(comment);
+  }
+  testing::internal::CaptureStdout();
+  tt.print_to_stdout();
+  std::string out = testing::internal::GetCapturedStdout();
+  EXPECT_NE(std::string::npos, out.find("6 earlier pings dropped"));
+  EXPECT_EQ(std::string::npos, out.find("  6."));
+  EXPECT_NE(std::string::npos, out.find("  7.  (c6)"));
+  EXPECT_NE(std::string::npos, out.find(" 10.  (c9)"));
+  EXPECT_EQ(std::string::npos, out.find("(c5)"));
+}
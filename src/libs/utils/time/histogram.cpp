@@ -0,0 +1,165 @@
+
+/***************************************************************************
+ *  histogram.cpp - High dynamic range histogram of durations
+ *
+ *  Created: Sat Oct 17 09:14:05 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <utils/time/histogram.h>
+
+#include <cstring>
+
+namespace fawkes {
+
+/** @class TimeHistogram <utils/time/histogram.h>
+ * High dynamic range histogram of durations.
+ * Durations are recorded in nanoseconds into log-linear buckets: values
+ * below 2^SUB_BUCKET_BITS have a bucket each, larger values are grouped
+ * such that the relative error of a bucket is below 2^-(SUB_BUCKET_BITS-1),
+ * i.e. about 3%. The histogram has a fixed size, recording is a few
+ * instructions and never allocates memory.
+ *
+ * There must be only one thread recording values at a time. Other threads
+ * may read the statistics concurrently, the values they get may lag behind
+ * by the value which is being recorded.
+ * @author Tim Niemueller
+ */
+
+/** Constructor. */
+TimeHistogram::TimeHistogram()
+{
+  reset();
+}
+
+
+/** Reset histogram.
+ * Must not be called while values are recorded.
+ */
+void
+TimeHistogram::reset()
+{
+  memset(counts_, 0, sizeof(counts_));
+  count_ = sum_ = max_ = 0;
+}
+
+
+/** Record a duration.
+ * @param nsec duration in nanoseconds, clamped to MAX_VALUE
+ */
+void
+TimeHistogram::record(uint64_t nsec)
+{
+  if (nsec > MAX_VALUE)  nsec = MAX_VALUE;
+
+  unsigned int idx = bucket_index(nsec);
+  __atomic_store_n(&counts_[idx], counts_[idx] + 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&sum_, sum_ + nsec, __ATOMIC_RELAXED);
+  if (nsec > max_)  __atomic_store_n(&max_, nsec, __ATOMIC_RELAXED);
+  __atomic_store_n(&count_, count_ + 1, __ATOMIC_RELEASE);
+}
+
+
+/** Get number of recorded values.
+ * @return number of recorded values
+ */
+uint64_t
+TimeHistogram::count() const
+{
+  return __atomic_load_n(&count_, __ATOMIC_ACQUIRE);
+}
+
+
+/** Get largest recorded value.
+ * @return largest recorded value in nanoseconds
+ */
+uint64_t
+TimeHistogram::max() const
+{
+  return __atomic_load_n(&max_, __ATOMIC_RELAXED);
+}
+
+
+/** Get mean of recorded values.
+ * @return mean of the recorded values in nanoseconds, 0 if empty
+ */
+double
+TimeHistogram::mean() const
+{
+  uint64_t count = __atomic_load_n(&count_, __ATOMIC_ACQUIRE);
+  if (count == 0)  return 0.;
+  return (double)__atomic_load_n(&sum_, __ATOMIC_RELAXED) / count;
+}
+
+
+/** Get percentile.
+ * @param p percentile in the range [0, 100]
+ * @return value in nanoseconds such that at least p percent of the recorded
+ * values are less or equal, this is the upper bound of the bucket the
+ * percentile falls into, but never more than max(). 0 if empty.
+ */
+uint64_t
+TimeHistogram::percentile(double p) const
+{
+  // sum up the buckets rather than using count_, it might be ahead
+  uint64_t total = 0;
+  for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+    total += __atomic_load_n(&counts_[i], __ATOMIC_RELAXED);
+  }
+  if (total == 0)  return 0;
+
+  if (p < 0.)    p = 0.;
+  if (p > 100.)  p = 100.;
+  uint64_t rank = (uint64_t)(p / 100. * total + 0.5);
+  if (rank == 0)  rank = 1;
+
+  uint64_t seen = 0;
+  uint64_t max = __atomic_load_n(&max_, __ATOMIC_RELAXED);
+  for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+    seen += __atomic_load_n(&counts_[i], __ATOMIC_RELAXED);
+    if (seen >= rank) {
+      uint64_t v = bucket_upper(i);
+      return (v < max) ? v : max;
+    }
+  }
+  return max;
+}
+
+
+unsigned int
+TimeHistogram::bucket_index(uint64_t v)
+{
+  if (v < 2 * SUB_BUCKET_HALF)  return (unsigned int)v;
+
+  unsigned int msb = 63 - __builtin_clzll(v);
+  unsigned int shift = msb - (SUB_BUCKET_BITS - 1);
+  return SUB_BUCKET_HALF * shift + (unsigned int)(v >> shift);
+}
+
+
+uint64_t
+TimeHistogram::bucket_upper(unsigned int idx)
+{
+  if (idx < 2 * SUB_BUCKET_HALF)  return idx;
+
+  unsigned int shift = idx / SUB_BUCKET_HALF - 1;
+  uint64_t sub = idx - SUB_BUCKET_HALF * shift;
+  return ((sub + 1) << shift) - 1;
+}
+
+} // end namespace fawkes
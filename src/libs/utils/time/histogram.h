@@ -0,0 +1,66 @@
+
+/***************************************************************************
+ *  histogram.h - High dynamic range histogram of durations
+ *
+ *  Created: Sat Oct 17 09:14:05 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#ifndef _UTILS_TIME_HISTOGRAM_H_
+#define _UTILS_TIME_HISTOGRAM_H_
+
+#include <stdint.h>
+
+namespace fawkes {
+
+class TimeHistogram
+{
+ public:
+  /** Number of bits of precision of a bucket. */
+  static const unsigned int SUB_BUCKET_BITS  = 6;
+  /** Largest value that can be recorded, larger values are clamped. */
+  static const uint64_t     MAX_VALUE        = (1ULL << 40) - 1;
+
+  TimeHistogram();
+
+  void     record(uint64_t nsec);
+  void     reset();
+
+  uint64_t count() const;
+  uint64_t max() const;
+  double   mean() const;
+  uint64_t percentile(double p) const;
+
+ private:
+  static const unsigned int SUB_BUCKET_HALF = 1U << (SUB_BUCKET_BITS - 1);
+  static const unsigned int NUM_BUCKETS     =
+    (40 - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF;
+
+  static unsigned int bucket_index(uint64_t v);
+  static uint64_t     bucket_upper(unsigned int idx);
+
+ private:
+  uint64_t counts_[NUM_BUCKETS];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+};
+
+} // end namespace fawkes
+
+#endif
@@ -26,10 +26,16 @@
 #include <core/exceptions/system.h>
 
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cerrno>
 #include <cstdio>
+#include <ctime>
+#if defined(__i386__) || defined(__x86_64__)
+#  include <x86intrin.h>
+#  define HAVE_TSC
+#endif
 
 using namespace std;
 
@@ -40,11 +46,13 @@ namespace fawkes {
  * This class provides means to track time of different tasks in a process.
  * You can assign an arbitrary number of tracking classes per object (although
  * using a few classes is recommended for minimal influence of the measurement
- * on the measured process). You can then print out averages and (max) deviation
- * to get a feeling for the average performance and how flaky the runtimes are.
+ * on the measured process). You can then print out averages, (max) deviation
+ * and percentiles to get a feeling for the average performance and how flaky
+ * the runtimes are.
  *
  * The time tracker can also be operated without any class if you only want to
- * track a single process.
+ * track a single process. Classless pings are kept in a ring buffer of the
+ * sample capacity as well, only the most recent ones are printed.
  *
  * You can either just ping classless or a specific class which will then take
  * the time difference between now and the last ping as the measured time. This
@@ -53,12 +61,43 @@ namespace fawkes {
  * a specific point in time and then stop it after the sub-task is done to measure
  * only this very task. This can be done by using pingStart() and pingEnd().
  *
+ * Class times are taken from a monotonic clock, or optionally the time stamp
+ * counter of the CPU, and are stored as raw ticks in a ring buffer which is
+ * allocated when the class is added. Pinging a class therefore neither
+ * allocates memory nor does it cause the memory usage to grow on long runs.
+ * Count and maximum cover all times since the last reset. Average,
+ * deviation and percentiles are computed on the last sample_capacity()
+ * times, which are all times since the last reset unless the ring buffer
+ * has wrapped.
+ *
  * @author Tim Niemueller
  */
 
 /** The default tracking class. Optionally added in the constructor. */
   const unsigned int TimeTracker::DEFAULT_CLASS = 0;
 
+/** Default number of times kept per class for percentiles. */
+const unsigned int TimeTracker::DEFAULT_SAMPLE_CAPACITY = 4096;
+
+static inline int64_t
+monotonic_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+inline int64_t
+TimeTracker::now() const
+{
+#ifdef HAVE_TSC
+  if (clock_source_ == CLOCK_SOURCE_TSC)  return (int64_t)__rdtsc();
+#endif
+  return monotonic_ns();
+}
+
+
 /** Constructor.
  * @param add_default_class if true a default time class is added.
  */
@@ -66,10 +105,11 @@ TimeTracker::TimeTracker(bool add_default_class)
 {
   timelog_ = NULL;
   write_cycle_ = 0;
+  clock_source_ = CLOCK_SOURCE_MONOTONIC;
+  capacity_ = DEFAULT_SAMPLE_CAPACITY;
   reset();
   if ( add_default_class ) {
-    class_times_.push_back(vector<struct timeval *>());
-    class_names_.push_back("Default");
+    add_class("Default");
   }
 }
 
@@ -81,10 +121,11 @@ TimeTracker::TimeTracker(bool add_default_class)
 TimeTracker::TimeTracker(const char *filename, bool add_default_class)
 {
   write_cycle_ = 0;
+  clock_source_ = CLOCK_SOURCE_MONOTONIC;
+  capacity_ = DEFAULT_SAMPLE_CAPACITY;
   reset();
   if ( add_default_class ) {
-    class_times_.push_back(vector<struct timeval *>());
-    class_names_.push_back("Default");
+    add_class("Default");
   }
   timelog_ = fopen(filename, "w");
   if (!timelog_) {
@@ -99,9 +140,7 @@ TimeTracker::~TimeTracker()
   if (timelog_) {
     fclose(timelog_);
   }
-  reset();
-  class_times_.clear();
-  class_names_.clear();
+  classes_.clear();
 }
 
 
@@ -113,38 +152,46 @@ void
 TimeTracker::reset(std::string comment)
 {
   tracker_comment_ = comment;
-  for (vector<vector<struct timeval *> >::iterator i = class_times_.begin(); i != class_times_.end(); ++i) {
-    for (vector<struct timeval *>::iterator j = i->begin(); j != i->end(); ++j) {
-      free(*j);
-    }
-    i->clear();
+  for (vector<ClassTimes>::iterator i = classes_.begin(); i != classes_.end(); ++i) {
+    clear(*i);
   }
   times_.clear();
+  num_times_ = 0;
   comments_.clear();
   gettimeofday(&start_time, NULL);
   gettimeofday(&last_time, NULL);
+  reset_mono_ns_ = monotonic_ns();
+  reset_tick_ = last_tick_ = now();
 }
 
 
 /** Ping classless.
  * This takes the time difference between now and the last ping and adds this
- * to classless tracking.
+ * to classless tracking. Once sample_capacity() pings have been recorded,
+ * each ping replaces the oldest one and its comment.
  * @param comment optional ping comment.
  */
 void
 TimeTracker::ping(std::string comment)
 {
-  timeval *t = (timeval *)malloc(sizeof(timeval));
-  gettimeofday(t, NULL);
-  times_.push_back(t);
+  timeval t;
+  gettimeofday(&t, NULL);
+  if (times_.size() < capacity_) {
+    times_.push_back(t);
+  } else {
+    times_[num_times_ % capacity_] = t;
+    comments_.erase(num_times_ - capacity_);
+  }
   if (!comment.empty()) {
-    comments_[ times_.size() - 1 ] = comment;
+    comments_[num_times_] = comment;
   }
+  num_times_ += 1;
 }
 
 
 /** Add a new class.
- * Adds a new class and gives the class ID.
+ * Adds a new class and gives the class ID. The ring buffer of the class
+ * is allocated with the current sample capacity.
  * @param name name of the class
  * @return new class ID which is used for pinging this specific
  * class.
@@ -155,9 +202,12 @@ TimeTracker::add_class(std::string name)
   if ( name == "" ) {
     throw Exception("TimeTracker::add_class(): Class name may not be empty");
   }
-  class_times_.push_back(vector<struct timeval *>());
-  class_names_.push_back(name);
-  return class_times_.size() - 1;
+  classes_.push_back(ClassTimes());
+  ClassTimes &c = classes_.back();
+  c.name = name;
+  c.samples.resize(capacity_);
+  clear(c);
+  return classes_.size() - 1;
 }
 
 
@@ -170,13 +220,15 @@ TimeTracker::add_class(std::string name)
 void
 TimeTracker::remove_class(unsigned int cls)
 {
-  if ( cls < class_names_.size() ) {
-    class_names_[cls] = "";
+  if ( cls < classes_.size() ) {
+    classes_[cls].name = "";
+    vector<int64_t>().swap(classes_[cls].samples);
+    clear(classes_[cls]);
   } else {
-    if ( class_times_.size() == 0 ) {
+    if ( classes_.size() == 0 ) {
       throw Exception("No classes have been added, cannot delete class %u", cls);
     } else {
-      throw OutOfBoundsException("Invalid class given", cls, 0, class_times_.size()-1);
+      throw OutOfBoundsException("Invalid class given", cls, 0, classes_.size()-1);
     }
   }
 }
@@ -190,28 +242,18 @@ TimeTracker::remove_class(unsigned int cls)
 void
 TimeTracker::ping(unsigned int cls)
 {
-  timeval *t = (timeval *)malloc(sizeof(timeval));
-  gettimeofday(t, NULL);
-
-  long sec  = t->tv_sec - last_time.tv_sec;
-  long usec = t->tv_usec - last_time.tv_usec;
-  if (usec < 0) {
-    sec -= 1;
-    usec += 1000000;
-  }
-  last_time.tv_sec  = t->tv_sec;
-  last_time.tv_usec = t->tv_usec;
-
-  t->tv_sec  = sec;
-  t->tv_usec = usec;
+  int64_t t = now();
+  int64_t diff = t - last_tick_;
+  last_tick_ = t;
+  gettimeofday(&last_time, NULL);
 
-  if (cls < class_times_.size()) {
-    class_times_[cls].push_back(t);
+  if (cls < classes_.size()) {
+    record(classes_[cls], diff);
   } else {
-    if ( class_times_.size() == 0 ) {
+    if ( classes_.size() == 0 ) {
       throw Exception("No classes have been added, cannot track times");
     } else {
-      throw OutOfBoundsException("Invalid class given", cls, 0, class_times_.size()-1);
+      throw OutOfBoundsException("Invalid class given", cls, 0, classes_.size()-1);
     }
   }
 }
@@ -224,21 +266,10 @@ TimeTracker::ping(unsigned int cls)
 void
 TimeTracker::ping_start(unsigned int cls)
 {
-  if (cls >= class_times_.size()) return;
-
-  timeval *t = (timeval *)malloc(sizeof(timeval));
-  gettimeofday(t, NULL);
-
-  if (cls < class_times_.size()) {
-    class_times_[cls].push_back(t);
-  } else {
-    if ( class_times_.size() == 0 ) {
-      throw Exception("No classes have been added, cannot track times");
-    } else {
-      throw OutOfBoundsException("Invalid class given", cls, 0, class_times_.size()-1);
-    }
-  }
+  if (cls >= classes_.size()) return;
 
+  classes_[cls].start   = now();
+  classes_[cls].running = true;
 }
 
 
@@ -250,24 +281,14 @@ TimeTracker::ping_start(unsigned int cls)
 void
 TimeTracker::ping_end(unsigned int cls)
 {
-  if (cls >= class_times_.size()) return;
-
-  timeval t2;
-  gettimeofday(&t2, NULL);
-
-  timeval *t1 = class_times_[cls].back();
-
-  long sec  = t2.tv_sec - t1->tv_sec;
-  long usec = t2.tv_usec - t1->tv_usec;
+  if (cls >= classes_.size()) return;
 
-  if (usec < 0) {
-    sec  -= 1;
-    usec += 1000000;
+  int64_t t = now();
+  ClassTimes &c = classes_[cls];
+  if (c.running) {
+    c.running = false;
+    record(c, t - c.start);
   }
-
-  t1->tv_sec  = sec;
-  t1->tv_usec = usec;
-
 }
 
 
@@ -278,44 +299,175 @@ TimeTracker::ping_end(unsigned int cls)
 void
 TimeTracker::ping_abort(unsigned int cls)
 {
-  if (cls >= class_times_.size()) return;
+  if (cls >= classes_.size()) return;
+
+  classes_[cls].running = false;
+}
+
+
+/** Set number of times kept per class.
+ * The percentiles are computed on this many of the most recent times. All
+ * classes are reallocated and their times are discarded. This is also the
+ * number of classless pings kept, these are discarded as well.
+ * @param capacity number of times to keep per class, must be at least 1
+ */
+void
+TimeTracker::set_sample_capacity(unsigned int capacity)
+{
+  if (capacity == 0) {
+    throw Exception("TimeTracker: sample capacity must be at least 1");
+  }
+  capacity_ = capacity;
+  for (vector<ClassTimes>::iterator i = classes_.begin(); i != classes_.end(); ++i) {
+    if (! i->name.empty()) {
+      i->samples.assign(capacity_, 0);
+    }
+    clear(*i);
+  }
+  times_.clear();
+  num_times_ = 0;
+  comments_.clear();
+}
 
-  free(class_times_[cls].back());
-  class_times_[cls].pop_back();
+
+/** Get number of times kept per class.
+ * @return sample capacity
+ */
+unsigned int
+TimeTracker::sample_capacity() const
+{
+  return capacity_;
 }
 
 
+/** Set clock source.
+ * The time stamp counter is cheaper to read than the monotonic clock, but
+ * it is only meaningful on CPUs with an invariant TSC. It is converted to
+ * seconds by relating it to the monotonic clock since the last reset. If
+ * the platform has no TSC the monotonic clock is used. Changing the clock
+ * source resets the tracker.
+ * @param source clock source
+ */
 void
-TimeTracker::average_and_deviation(vector<struct timeval *> &values,
-				   double &average_sec, double &average_ms,
-				   double &deviation_sec, double &deviation_ms)
+TimeTracker::set_clock_source(ClockSource source)
 {
-  vector<struct timeval * >::iterator tit;
+#ifdef HAVE_TSC
+  clock_source_ = source;
+#else
+  clock_source_ = CLOCK_SOURCE_MONOTONIC;
+#endif
+  reset(tracker_comment_);
+}
+
+
+/** Get clock source.
+ * @return clock source in use
+ */
+TimeTracker::ClockSource
+TimeTracker::clock_source() const
+{
+  return clock_source_;
+}
 
-  average_sec = average_ms = deviation_sec = deviation_ms = 0.f;
 
-  for (tit = values.begin(); tit != values.end(); ++tit) {
-    average_sec += float((*tit)->tv_sec);
-    average_sec += (*tit)->tv_usec / 1000000.f;
+/** Get summary of class.
+ * @param cls class ID
+ * @return summary of the times of the given class
+ */
+TimeTracker::Summary
+TimeTracker::summary(unsigned int cls)
+{
+  if (cls >= classes_.size()) {
+    if ( classes_.size() == 0 ) {
+      throw Exception("No classes have been added, no summary available");
+    } else {
+      throw OutOfBoundsException("Invalid class given", cls, 0, classes_.size()-1);
+    }
   }
-  average_sec /= values.size();
 
-  for (tit = values.begin(); tit != values.end(); ++tit) {
-    deviation_sec += fabs((*tit)->tv_sec + ((*tit)->tv_usec / 1000000.f) - average_sec);
+  ClassTimes &c = classes_[cls];
+  Summary s;
+  s.count  = c.count;
+  s.window = c.size;
+  s.avg = s.dev = s.p50 = s.p95 = s.p99 = s.max = 0.;
+  if (c.count == 0)  return s;
+
+  double tick = tick_seconds();
+  s.max = c.max * tick;
+
+  // average and deviation are both taken over the window, older times
+  // are no longer available to compute the deviation
+  scratch_.assign(c.samples.begin(), c.samples.begin() + c.size);
+  double sum = 0.;
+  for (unsigned int i = 0; i < c.size; ++i) {
+    sum += scratch_[i];
   }
-  deviation_sec /= values.size();
+  s.avg = sum / c.size;
+  for (unsigned int i = 0; i < c.size; ++i) {
+    s.dev += fabs(scratch_[i] - s.avg);
+  }
+  s.dev = s.dev / c.size * tick;
+  s.avg *= tick;
+
+  const double pct[3] = { 0.50, 0.95, 0.99 };
+  double *out[3] = { &s.p50, &s.p95, &s.p99 };
+  for (unsigned int i = 0; i < 3; ++i) {
+    size_t rank = (size_t)ceil(pct[i] * c.size);
+    if (rank > 0)  rank -= 1;
+    nth_element(scratch_.begin(), scratch_.begin() + rank, scratch_.end());
+    *out[i] = scratch_[rank] * tick;
+  }
+
+  return s;
+}
+
 
-  average_ms   = average_sec   * 1000.f;
-  deviation_ms = deviation_sec * 1000.f;
+void
+TimeTracker::record(ClassTimes &c, int64_t ticks)
+{
+  if (c.samples.empty())  return;
+
+  c.samples[c.next] = ticks;
+  if (++c.next == c.samples.size())  c.next = 0;
+  if (c.size < c.samples.size())     c.size += 1;
+  c.count += 1;
+  if (ticks > c.max)  c.max = ticks;
 }
 
+
+void
+TimeTracker::clear(ClassTimes &c)
+{
+  c.next = c.size = 0;
+  c.count = 0;
+  c.max = 0;
+  c.start = 0;
+  c.running = false;
+}
+
+
+/** Get duration of a tick.
+ * @return seconds per tick of the current clock source
+ */
+double
+TimeTracker::tick_seconds()
+{
+  if (clock_source_ == CLOCK_SOURCE_MONOTONIC)  return 1e-9;
+
+  int64_t ticks = now() - reset_tick_;
+  int64_t ns    = monotonic_ns() - reset_mono_ns_;
+  if (ticks <= 0)  return 1e-9;
+  return (double)ns / (double)ticks * 1e-9;
+}
+
+
 /** Print results to stdout. */
 void
 TimeTracker::print_to_stdout()
 {
 
   if ( ! times_.empty()) {
-    unsigned int i = 0;
+    unsigned long i = num_times_ - times_.size();
     unsigned int j = 0;
     long diff_sec_start = 0;
     long diff_usec_start = 0;
@@ -336,57 +488,62 @@ TimeTracker::print_to_stdout()
     }
 
     cout << endl << "TimeTracker stats - individual times";
-    if (tracker_comment_.empty()) {
+    if (!tracker_comment_.empty()) {
       cout << " (" << tracker_comment_ << ")";
     }
     cout << endl
 	 << "==================================================================" << endl
 	 << "Initialized: " << time_string << " (" << start_time.tv_sec << ")" << endl << endl;
+    if (i > 0) {
+      // older pings have been overwritten, take diffs from the oldest kept
+      cout << i << " earlier pings dropped" << endl << endl;
+      last_sec  = times_[i % capacity_].tv_sec;
+      last_usec = times_[i % capacity_].tv_usec;
+    }
 
-    for (time_it_ = times_.begin(); time_it_ != times_.end(); ++time_it_) {
-      char tmp[10];
-      sprintf(tmp, "%3u.", i + 1);
+    for (; i < num_times_; ++i) {
+      const timeval *t = &times_[i % capacity_];
+      char tmp[24];
+      sprintf(tmp, "%3lu.", i + 1);
       cout << tmp;
       if (comments_.count(i) > 0) {
 	cout << "  (" << comments_[i] << ")";
       }
       cout << endl;
 
-      diff_sec_start  = (*time_it_)->tv_sec  - start_time.tv_sec;
-      diff_usec_start = (*time_it_)->tv_usec - start_time.tv_usec;
+      diff_sec_start  = t->tv_sec  - start_time.tv_sec;
+      diff_usec_start = t->tv_usec - start_time.tv_usec;
       if (diff_usec_start < 0) {
 	diff_sec_start -= 1;
 	diff_usec_start = 1000000 + diff_usec_start;
       }
       diff_msec_start = diff_usec_start / 1000.f;
 
-      diff_sec_last  = (*time_it_)->tv_sec  - last_sec;
-      diff_usec_last = (*time_it_)->tv_usec - last_usec;
+      diff_sec_last  = t->tv_sec  - last_sec;
+      diff_usec_last = t->tv_usec - last_usec;
       if (diff_usec_last < 0) {
 	diff_sec_last -= 1;
 	diff_usec_last = 1000000 + diff_usec_last;
       }
       diff_msec_last = diff_usec_last / 1000.f;
 
-      last_sec  = (*time_it_)->tv_sec;
-      last_usec = (*time_it_)->tv_usec;
+      last_sec  = t->tv_sec;
+      last_usec = t->tv_usec;
 
-      ctime_r(&(*time_it_)->tv_sec, time_string);
+      ctime_r(&t->tv_sec, time_string);
       for (j = 26; j > 0; --j) {
 	if (time_string[j] == '\n') {
 	  time_string[j] = 0;
 	  break;
 	}
       }
-      cout << time_string << " (" << (*time_it_)->tv_sec << ")" << endl;
+      cout << time_string << " (" << t->tv_sec << ")" << endl;
       cout << "Diff to start: " << diff_sec_start << " sec and " << diff_usec_start
 	   << " usec  (which are "
 	   << diff_msec_start << " msec)" << endl;
       cout << "Diff to last:  " << diff_sec_last  << " sec and " << diff_usec_last
 	   << " usec (which are "
 	   << diff_msec_last << " msec)" << endl << endl;
-
-      i += 1;
     }
   }
 
@@ -397,28 +554,21 @@ TimeTracker::print_to_stdout()
   cout << endl
        << "==================================================================" << endl;
 
-  vector<vector<struct timeval *> >::iterator it = class_times_.begin();
-  vector<string>::iterator sit = class_names_.begin();
-
-  double deviation = 0.f;
-  double average = 0.f;
-  double average_ms = 0.f;
-  double deviation_ms = 0.f;
-
-  for (; (it != class_times_.end()) && (sit != class_names_.end()); ++it, ++sit) {
-    if (sit->empty()) continue;
+  for (unsigned int c = 0; c < classes_.size(); ++c) {
+    if (classes_[c].name.empty()) continue;
 
-    if (it->size() > 0) {
+    if (classes_[c].count > 0) {
+      Summary s = summary(c);
 
-      average_and_deviation(*it, average, average_ms, deviation, deviation_ms);
-
-      cout << "Class '" <<  *sit << "'" << endl
-	   << "  avg=" << average << " (" << average_ms << " ms)" << endl
-	   << "  dev=" << deviation << " (" << deviation_ms << " ms)" << endl
-	   << "  res=" << it->size() << " results"
+      cout << "Class '" <<  classes_[c].name << "'" << endl
+	   << "  avg=" << s.avg << " (" << s.avg * 1000. << " ms)" << endl
+	   << "  dev=" << s.dev << " (" << s.dev * 1000. << " ms)" << endl
+	   << "  p50=" << s.p50 * 1000. << " ms  p95=" << s.p95 * 1000.
+	   << " ms  p99=" << s.p99 * 1000. << " ms  max=" << s.max * 1000. << " ms" << endl
+	   << "  res=" << s.count << " results"
 	   << endl;
     } else {
-      cout << "Class '" <<  *sit << "' has no results." << endl;
+      cout << "Class '" <<  classes_[c].name << "' has no results." << endl;
     }
 
   }
@@ -440,24 +590,17 @@ TimeTracker::print_to_file()
 {
   if ( ! timelog_)  throw Exception("Time log not opened, use other ctor");
 
-  vector<vector<struct timeval *> >::iterator it = class_times_.begin();
-  vector<string>::iterator sit = class_names_.begin();
-
-  double deviation = 0.f;
-  double average = 0.f;
-  double average_ms = 0.f;
-  double deviation_ms = 0.f;
   double avgsum = 0.f;
 
   fprintf(timelog_, "%u ", ++write_cycle_);
-  for (; (it != class_times_.end()) && (sit != class_names_.end()); ++it, ++sit) {
-    if (sit->empty()) continue;
+  for (unsigned int c = 0; c < classes_.size(); ++c) {
+    if (classes_[c].name.empty()) continue;
 
-    average_and_deviation(*it, average, average_ms, deviation, deviation_ms);
+    Summary s = summary(c);
 
-    avgsum += average;
+    avgsum += s.avg;
     fprintf(timelog_, "%lf %lf %lf %lf %lf ",
-	    average, average_ms, avgsum, deviation, deviation_ms);
+	    s.avg, s.avg * 1000., avgsum, s.dev, s.dev * 1000.);
   }
   fprintf(timelog_, "\n");
   fflush(timelog_);
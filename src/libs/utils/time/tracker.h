@@ -28,6 +28,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <stdint.h>
 #include <sys/time.h>
 
 namespace fawkes {
@@ -35,6 +36,25 @@ namespace fawkes {
 class TimeTracker {
  public:
   static const unsigned int DEFAULT_CLASS;
+  static const unsigned int DEFAULT_SAMPLE_CAPACITY;
+
+  /** Clock source used to take class times. */
+  typedef enum {
+    CLOCK_SOURCE_MONOTONIC,	///< clock_gettime(CLOCK_MONOTONIC)
+    CLOCK_SOURCE_TSC		///< CPU time stamp counter, if available
+  } ClockSource;
+
+  /** Summary of the times of a class. All times are in seconds. */
+  typedef struct {
+    unsigned long  count;	///< number of times recorded since reset
+    unsigned int   window;	///< number of times percentiles are computed on
+    double         avg;		///< average time of the window
+    double         dev;		///< average absolute deviation from avg of the window
+    double         p50;		///< median of the window
+    double         p95;		///< 95th percentile of the window
+    double         p99;		///< 99th percentile of the window
+    double         max;		///< maximum time since reset
+  } Summary;
 
   TimeTracker(const char *filename, bool add_default_class = false);
   TimeTracker(bool add_default_class = false);
@@ -53,22 +73,49 @@ class TimeTracker {
   void print_to_stdout();
 
   void print_to_file();
-  
+
+  void         set_sample_capacity(unsigned int capacity);
+  unsigned int sample_capacity() const;
+
+  void         set_clock_source(ClockSource source);
+  ClockSource  clock_source() const;
+
+  Summary      summary(unsigned int cls);
+
  private:
-  void average_and_deviation(std::vector<struct timeval *> &values,
-			     double &average_sec, double &average_ms,
-			     double &deviation_sec, double &deviation_ms);
+  /// @cond INTERNALS
+  struct ClassTimes {
+    std::string           name;
+    std::vector<int64_t>  samples;
+    unsigned int          next;
+    unsigned int          size;
+    unsigned long         count;
+    int64_t               max;
+    int64_t               start;
+    bool                  running;
+  };
+  /// @endcond
+
+  int64_t now() const;
+  void record(ClassTimes &c, int64_t ticks);
+  void clear(ClassTimes &c);
+  double tick_seconds();
 
  private:
   timeval start_time;
   timeval last_time;
-  std::vector<std::vector<struct timeval *> >    class_times_;
-  std::vector<std::string>                       class_names_;
-  std::vector<struct timeval *>                  times_;
-  std::map<unsigned int, std::string>            comments_;
-  std::vector<struct timeval *>::iterator        time_it_;
-  std::map<unsigned int, std::string>::iterator  comment_it_;
+  std::vector<ClassTimes>                        classes_;
+  std::vector<timeval>                           times_;
+  unsigned long                                  num_times_;
+  std::map<unsigned long, std::string>           comments_;
   std::string                                    tracker_comment_;
+  std::vector<int64_t>                           scratch_;
+
+  ClockSource  clock_source_;
+  unsigned int capacity_;
+  int64_t      last_tick_;
+  int64_t      reset_tick_;
+  int64_t      reset_mono_ns_;
 
   unsigned int write_cycle_;
   FILE *timelog_;
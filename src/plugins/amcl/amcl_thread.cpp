@@ -42,6 +42,7 @@
 #include <cstdio>
 #include <cstring>
 #include <libgen.h>
+#include <unistd.h>
 
 using namespace fawkes;
 
@@ -192,6 +193,14 @@ void AmclThread::init()
   angle_min_ = deg2rad(angle_min_idx_);
 
   max_beams_ = config->get_uint(AMCL_CFG_PREFIX"max_beams");
+  sensor_threads_ = 0;
+  try {
+    sensor_threads_ = config->get_uint(AMCL_CFG_PREFIX"sensor_threads");
+  } catch (Exception &e) {} // ignored, use default
+  if (sensor_threads_ == 0) {
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    sensor_threads_ = (num_cpus > 0) ? num_cpus : 1;
+  }
   min_particles_ = config->get_uint(AMCL_CFG_PREFIX"min_particles");
   max_particles_ = config->get_uint(AMCL_CFG_PREFIX"max_particles");
   resample_interval_ = config->get_uint(AMCL_CFG_PREFIX"resample_interval");
@@ -217,6 +226,19 @@ void AmclThread::init()
     laser_model_type_ = ::amcl::LASER_MODEL_LIKELIHOOD_FIELD;
   }
 
+  cspace_method_ = MAP_CSPACE_WAVEFRONT;
+  try {
+    std::string tmp_cspace_method =
+      config->get_string(AMCL_CFG_PREFIX"cspace_method");
+    if (tmp_cspace_method == "edt") {
+      cspace_method_ = MAP_CSPACE_EDT;
+    } else if (tmp_cspace_method != "wavefront") {
+      logger->log_warn(name(),
+		       "Unknown cspace method \"%s\"; defaulting to wavefront",
+		       tmp_cspace_method.c_str());
+    }
+  } catch (Exception &e) {} // ignored, use default
+
   tmp_model_type = config->get_string(AMCL_CFG_PREFIX"odom_model_type");
   if (tmp_model_type == "diff")
     odom_model_type_ = ::amcl::ODOM_MODEL_DIFF;
@@ -318,7 +340,7 @@ void AmclThread::init()
     odom_->SetModelDiff(alpha1_, alpha2_, alpha3_, alpha4_);
 
   // Laser
-  laser_ = new ::amcl::AMCLLaser(max_beams_, map_);
+  laser_ = new ::amcl::AMCLLaser(max_beams_, map_, sensor_threads_);
 
   if (laser_model_type_ == ::amcl::LASER_MODEL_BEAM) {
     laser_->SetModelBeam(z_hit_, z_short_, z_max_, z_rand_, sigma_hit_,
@@ -328,7 +350,7 @@ void AmclThread::init()
 		     "Initializing likelihood field model; "
                      "this can take some time on large maps...");
     laser_->SetModelLikelihoodField(z_hit_, z_rand_, sigma_hit_,
-				    laser_likelihood_max_dist_);
+				    laser_likelihood_max_dist_, cspace_method_);
     logger->log_info(name(), "Done initializing likelihood field model.");
   }
 
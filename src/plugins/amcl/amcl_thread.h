@@ -128,8 +128,10 @@ private:
 
   amcl::odom_model_t  odom_model_type_;
   amcl::laser_model_t laser_model_type_;
+  map_cspace_method_t cspace_method_;
 
   int max_beams_, min_particles_, max_particles_;
+  unsigned int sensor_threads_;
 
   bool sent_first_transform_;
   bool latest_tf_valid_;
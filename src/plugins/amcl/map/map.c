@@ -59,6 +59,13 @@ map_t *map_alloc(void)
   
   // Allocate storage for main map
   map->cells = (map_cell_t*) NULL;
+
+  // Distance field is built by map_update_cspace()
+  map->max_occ_dist = 0;
+  map->occ_dist_codes = (uint16_t*) NULL;
+  map->occ_dist_table = (double*) NULL;
+  map->occ_dist_max_code = 0;
+  map->occ_dist_tiles_x = 0;
   
   return map;
 }
@@ -68,6 +75,8 @@ map_t *map_alloc(void)
 void map_free(map_t *map)
 {
   free(map->cells);
+  free(map->occ_dist_codes);
+  free(map->occ_dist_table);
   free(map);
   return;
 }
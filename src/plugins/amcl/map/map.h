@@ -57,9 +57,6 @@ typedef struct
   // Occupancy state (-1 = free, 0 = unknown, +1 = occ)
   int occ_state;
 
-  // Distance to the nearest occupied cell
-  double occ_dist;
-
   // Wifi levels
   //int wifi_levels[MAP_WIFI_MAX_LEVELS];
 
@@ -84,6 +81,16 @@ typedef struct
   // Max distance at which we care about obstacles, for constructing
   // likelihood field
   double max_occ_dist;
+
+  // Distance to the nearest occupied cell, built by map_update_cspace().
+  // Stored as 16 bit codes in tiles of MAP_TILE_SIZE x MAP_TILE_SIZE
+  // cells (see MAP_DIST_INDEX) to keep nearby cells in few cache lines.
+  // occ_dist_table maps a code to the distance, codes grow with the
+  // distance and the largest code denotes max_occ_dist.
+  uint16_t *occ_dist_codes;
+  double *occ_dist_table;
+  int occ_dist_max_code;
+  int occ_dist_tiles_x;
   
 } map_t;
 
@@ -108,9 +115,23 @@ int map_load_occ(map_t *map, const char *filename, double scale, int negate);
 // Load a wifi signal strength map
 //int map_load_wifi(map_t *map, const char *filename, int index);
 
+// Methods to compute the cspace distances
+typedef enum
+{
+  // Wavefront propagation from the obstacles using a priority queue
+  MAP_CSPACE_WAVEFRONT,
+  // Exact separable Euclidean distance transform in linear time
+  MAP_CSPACE_EDT
+} map_cspace_method_t;
+
 // Update the cspace distances
 void map_update_cspace(map_t *map, double max_occ_dist);
 
+// Update the cspace distances with the given method, the distance
+// transform is run in num_threads threads
+void map_update_cspace_method(map_t *map, double max_occ_dist,
+                              map_cspace_method_t method, int num_threads);
+
 
 /**************************************************************************
  * Range functions
@@ -119,6 +140,11 @@ void map_update_cspace(map_t *map, double max_occ_dist);
 // Extract a single range reading from the map
 double map_calc_range(map_t *map, double ox, double oy, double oa, double max_range);
 
+// Extract a single range reading from the map, ray given by the
+// cosine and sine of its angle
+double map_calc_range_dir(map_t *map, double ox, double oy,
+                          double cos_oa, double sin_oa, double max_range);
+
 
 /**************************************************************************
  * GUI/diagnostic functions
@@ -152,6 +178,26 @@ void map_draw_wifi(map_t *map, struct _rtk_fig_t *fig, int index);
 // Compute the cell index for the given map coords.
 #define MAP_INDEX(map, i, j) ((i) + (j) * map->size_x)
 
+// Tiles of the distance field, MAP_TILE_SIZE = 1 << MAP_TILE_BITS
+#define MAP_TILE_BITS 3
+#define MAP_TILE_SIZE (1 << MAP_TILE_BITS)
+#define MAP_TILE_MASK (MAP_TILE_SIZE - 1)
+
+// Compute the distance field index for the given map coords.
+#define MAP_DIST_INDEX(map, i, j)                                        \
+  (((((j) >> MAP_TILE_BITS) * map->occ_dist_tiles_x + ((i) >> MAP_TILE_BITS)) \
+    << (2 * MAP_TILE_BITS)) |                                            \
+   (((j) & MAP_TILE_MASK) << MAP_TILE_BITS) | ((i) & MAP_TILE_MASK))
+
+// Distance to the nearest occupied cell for the given map coords,
+// max_occ_dist for coords outside the map
+static inline double map_get_occ_dist(const map_t *map, int i, int j)
+{
+  if (!MAP_VALID(map, i, j))
+    return map->max_occ_dist;
+  return map->occ_dist_table[map->occ_dist_codes[MAP_DIST_INDEX(map, i, j)]];
+}
+
 /// @endcond
 
 #ifdef __cplusplus
@@ -28,6 +28,9 @@
  */
 
 #include <queue>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,111 +38,69 @@
 
 /// @cond EXTERNAL
 
+// Largest cell radius for which squared distances in cells are used as
+// codes directly, which stores distances on the grid without loss.
+// Larger radii fall back to a linear quantization of the distance.
+#define MAP_OCC_DIST_EXACT_RADIUS 255
+#define MAP_OCC_DIST_NUM_CODES    65536
+
 class CellData
 {
   public:
-    map_t* map_;
     unsigned int i_, j_;
     unsigned int src_i_, src_j_;
+    // squared distance in cells to the source obstacle
+    unsigned int dist2_;
 };
 
-class CachedDistanceMap
+bool operator<(const CellData& a, const CellData& b)
 {
-public:
-  CachedDistanceMap(double scale, double max_dist) : 
-  distances_(NULL), scale_(scale), max_dist_(max_dist) 
-  {
-    cell_radius_ = max_dist / scale;
-    distances_ = new double *[cell_radius_+2];
-    for(int i=0; i<=cell_radius_+1; i++)
-    {
-      distances_[i] = new double[cell_radius_+2];
-      for(int j=0; j<=cell_radius_+1; j++)
-      {
-        distances_[i][j] = sqrt(i*i + j*j);
-      }
-    }
-  }
-
-  CachedDistanceMap(const CachedDistanceMap &other)
-  : distances_(NULL), scale_(other.scale_), max_dist_(other.max_dist_) 
-  {
-    cell_radius_ = other.cell_radius_;
-    distances_ = new double *[cell_radius_+2];
-    for(int i=0; i<=cell_radius_+1; i++)
-    {
-      distances_[i] = new double[cell_radius_+2];
-      for(int j=0; j<=cell_radius_+1; j++)
-      {
-        distances_[i][j] = other.distances_[i][j];
-      }
-    }
-  }
-
-
-  ~CachedDistanceMap()
-  {
-    if(distances_)
-    {
-      for(int i=0; i<=cell_radius_+1; i++)
-        delete[] distances_[i];
-      delete[] distances_;
-    }
-  }
+  return a.dist2_ > b.dist2_;
+}
 
-  CachedDistanceMap&
-  operator=(const CachedDistanceMap &other)
+// Allocate the distance field and code table, all cells initialized
+// to the code of max_occ_dist
+static int
+alloc_occ_dist(map_t *map, int cell_radius)
+{
+  free(map->occ_dist_codes);
+  free(map->occ_dist_table);
+
+  int num_codes;
+  if (cell_radius <= MAP_OCC_DIST_EXACT_RADIUS)
+    num_codes = cell_radius * cell_radius + 2;
+  else
+    num_codes = MAP_OCC_DIST_NUM_CODES;
+
+  map->occ_dist_max_code = num_codes - 1;
+  map->occ_dist_table = (double *) malloc(num_codes * sizeof(double));
+  for (int c = 0; c < num_codes - 1; c++)
   {
-    if(distances_)
-    {
-      for(int i=0; i<=cell_radius_+1; i++)
-        delete[] distances_[i];
-      delete[] distances_;
-    }
-
-    distances_ = NULL;
-    scale_     = other.scale_;
-    max_dist_  = other.max_dist_;
-
-    cell_radius_ = other.cell_radius_;
-    distances_ = new double *[cell_radius_+2];
-    for(int i=0; i<=cell_radius_+1; i++)
-    {
-      distances_[i] = new double[cell_radius_+2];
-      for(int j=0; j<=cell_radius_+1; j++)
-      {
-        distances_[i][j] = other.distances_[i][j];
-      }
-    }
-
-    return *this;
+    if (cell_radius <= MAP_OCC_DIST_EXACT_RADIUS)
+      map->occ_dist_table[c] = sqrt(c) * map->scale;
+    else
+      map->occ_dist_table[c] = c * (cell_radius * map->scale) / (num_codes - 2);
   }
+  map->occ_dist_table[num_codes - 1] = map->max_occ_dist;
 
-  double** distances_;
-  double scale_;
-  double max_dist_;
-  int cell_radius_;
-};
-
+  map->occ_dist_tiles_x = (map->size_x + MAP_TILE_MASK) >> MAP_TILE_BITS;
+  int tiles_y = (map->size_y + MAP_TILE_MASK) >> MAP_TILE_BITS;
+  size_t num_cells = (size_t)map->occ_dist_tiles_x * tiles_y * MAP_TILE_SIZE * MAP_TILE_SIZE;
+  map->occ_dist_codes = (uint16_t *) malloc(num_cells * sizeof(uint16_t));
+  for (size_t i = 0; i < num_cells; i++)
+    map->occ_dist_codes[i] = map->occ_dist_max_code;
 
-bool operator<(const CellData& a, const CellData& b)
-{
-  return a.map_->cells[MAP_INDEX(a.map_, a.i_, a.j_)].occ_dist > a.map_->cells[MAP_INDEX(b.map_, b.i_, b.j_)].occ_dist;
+  return num_codes;
 }
 
-CachedDistanceMap*
-get_distance_map(double scale, double max_dist)
+// Code for a squared distance in cells within the cell radius
+static inline uint16_t
+occ_dist_code(const map_t *map, int cell_radius, unsigned int dist2)
 {
-  static CachedDistanceMap* cdm = NULL;
-
-  if(!cdm || (cdm->scale_ != scale) || (cdm->max_dist_ != max_dist))
-  {
-    if(cdm)
-      delete cdm;
-    cdm = new CachedDistanceMap(scale, max_dist);
-  }
-
-  return cdm;
+  if (cell_radius <= MAP_OCC_DIST_EXACT_RADIUS)
+    return dist2;
+  else
+    return (uint16_t) lrint(sqrt(dist2) * (map->occ_dist_max_code - 1) / cell_radius);
 }
 
 static unsigned int delta(const unsigned int x, const unsigned int y)
@@ -154,7 +115,7 @@ static unsigned int delta(const unsigned int x, const unsigned int y)
 void enqueue(map_t* map, unsigned int i, unsigned int j, 
 	     unsigned int src_i, unsigned int src_j,
 	     std::priority_queue<CellData>& Q,
-	     CachedDistanceMap* cdm,
+	     int cell_radius,
 	     unsigned char* marked)
 {
   if(marked[MAP_INDEX(map, i, j)])
@@ -162,27 +123,29 @@ void enqueue(map_t* map, unsigned int i, unsigned int j,
 
   unsigned int di = delta(i, src_i);
   unsigned int dj = delta(j, src_j);
-  double distance = cdm->distances_[di][dj];
+  unsigned int dist2 = di * di + dj * dj;
 
-  if(distance > cdm->cell_radius_)
+  if(dist2 > (unsigned int)(cell_radius * cell_radius))
     return;
 
-  map->cells[MAP_INDEX(map, i, j)].occ_dist = distance * map->scale;
+  map->occ_dist_codes[MAP_DIST_INDEX(map, i, j)] =
+    occ_dist_code(map, cell_radius, dist2);
 
   CellData cell;
-  cell.map_ = map;
   cell.i_ = i;
   cell.j_ = j;
   cell.src_i_ = src_i;
   cell.src_j_ = src_j;
+  cell.dist2_ = dist2;
 
   Q.push(cell);
 
   marked[MAP_INDEX(map, i, j)] = 1;
 }
 
-// Update the cspace distance values
-void map_update_cspace(map_t *map, double max_occ_dist)
+// Update the cspace distance values by a wavefront from the obstacles
+static void
+update_cspace_wavefront(map_t *map, int cell_radius)
 {
   unsigned char* marked;
   std::priority_queue<CellData> Q;
@@ -190,13 +153,9 @@ void map_update_cspace(map_t *map, double max_occ_dist)
   marked = new unsigned char[map->size_x*map->size_y];
   memset(marked, 0, sizeof(unsigned char) * map->size_x*map->size_y);
 
-  map->max_occ_dist = max_occ_dist;
-
-  CachedDistanceMap* cdm = get_distance_map(map->scale, map->max_occ_dist);
-
   // Enqueue all the obstacle cells
   CellData cell;
-  cell.map_ = map;
+  cell.dist2_ = 0;
   for(int i=0; i<map->size_x; i++)
   {
     cell.src_i_ = cell.i_ = i;
@@ -204,13 +163,11 @@ void map_update_cspace(map_t *map, double max_occ_dist)
     {
       if(map->cells[MAP_INDEX(map, i, j)].occ_state == +1)
       {
-	map->cells[MAP_INDEX(map, i, j)].occ_dist = 0.0;
+	map->occ_dist_codes[MAP_DIST_INDEX(map, i, j)] = 0;
 	cell.src_j_ = cell.j_ = j;
 	marked[MAP_INDEX(map, i, j)] = 1;
 	Q.push(cell);
       }
-      else
-	map->cells[MAP_INDEX(map, i, j)].occ_dist = max_occ_dist;
     }
   }
 
@@ -220,19 +177,19 @@ void map_update_cspace(map_t *map, double max_occ_dist)
     if(current_cell.i_ > 0)
       enqueue(map, current_cell.i_-1, current_cell.j_, 
 	      current_cell.src_i_, current_cell.src_j_,
-	      Q, cdm, marked);
+	      Q, cell_radius, marked);
     if(current_cell.j_ > 0)
       enqueue(map, current_cell.i_, current_cell.j_-1, 
 	      current_cell.src_i_, current_cell.src_j_,
-	      Q, cdm, marked);
+	      Q, cell_radius, marked);
     if((int)current_cell.i_ < map->size_x - 1)
       enqueue(map, current_cell.i_+1, current_cell.j_, 
 	      current_cell.src_i_, current_cell.src_j_,
-	      Q, cdm, marked);
+	      Q, cell_radius, marked);
     if((int)current_cell.j_ < map->size_y - 1)
       enqueue(map, current_cell.i_, current_cell.j_+1, 
 	      current_cell.src_i_, current_cell.src_j_,
-	      Q, cdm, marked);
+	      Q, cell_radius, marked);
 
     Q.pop();
   }
@@ -240,61 +197,159 @@ void map_update_cspace(map_t *map, double max_occ_dist)
   delete[] marked;
 }
 
-#if 0
-// TODO: replace this with a more efficient implementation.  Not crucial,
-// because we only do it once, at startup.
-void map_update_cspace(map_t *map, double max_occ_dist)
+// Run f(begin, end) on consecutive ranges of [0, n) in num_threads threads,
+// ranges for which no thread could be started are run in this thread
+template <typename F>
+static void
+parallel_for(int n, int num_threads, F f)
 {
-  int i, j;
-  int ni, nj;
-  int s;
-  double d;
-  map_cell_t *cell, *ncell;
-
-  map->max_occ_dist = max_occ_dist;
-  s = (int) ceil(map->max_occ_dist / map->scale);
+  if (num_threads > n)
+    num_threads = n;
+  if (num_threads < 2)
+  {
+    f(0, n);
+    return;
+  }
 
-  // Reset the distance values
-  for (j = 0; j < map->size_y; j++)
+  std::vector<std::thread> threads;
+  int chunk = (n + num_threads - 1) / num_threads;
+  threads.reserve(num_threads - 1);
+  int begin = chunk;
+  try
+  {
+    for (; begin < n; begin += chunk)
+      threads.push_back(std::thread(f, begin, std::min(begin + chunk, n)));
+  }
+  catch (std::system_error &e)
   {
-    for (i = 0; i < map->size_x; i++)
+    // out of threads, the threads started so far keep running
+  }
+  f(0, chunk);
+  for (; begin < n; begin += chunk)
+    f(begin, std::min(begin + chunk, n));
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+}
+
+// Update the cspace distance values by the separable Euclidean distance
+// transform of Meijster et al. (2000), "A General Algorithm for
+// Computing Distance Transforms in Linear Time".  The first phase
+// computes the distance to the closest obstacle within each column,
+// the second phase the lower envelope of the resulting parabolas along
+// each row.  Integer arithmetic yields exact squared distances.
+static void
+update_cspace_edt(map_t *map, int cell_radius, int num_threads)
+{
+  const int w = map->size_x;
+  const int h = map->size_y;
+  // larger than any distance within the map
+  const int32_t inf = w + h;
+
+  if (w == 0 || h == 0)
+    return;
+
+  // Phase 1: vertical distances, swept row by row for ranges of columns
+  std::vector<int32_t> g((size_t)w * h);
+  parallel_for(w, num_threads, [&](int begin, int end) {
+    for (int i = begin; i < end; i++)
+      g[i] = (map->cells[MAP_INDEX(map, i, 0)].occ_state == +1) ? 0 : inf;
+    for (int j = 1; j < h; j++)
     {
-      cell = map->cells + MAP_INDEX(map, i, j);
-      cell->occ_dist = map->max_occ_dist;
+      int32_t *row = &g[(size_t)j * w];
+      const int32_t *prev = row - w;
+      for (int i = begin; i < end; i++)
+      {
+        if (map->cells[MAP_INDEX(map, i, j)].occ_state == +1)
+          row[i] = 0;
+        else
+          row[i] = (prev[i] < inf) ? prev[i] + 1 : inf;
+      }
     }
-  }
+    for (int j = h - 2; j >= 0; j--)
+    {
+      int32_t *row = &g[(size_t)j * w];
+      const int32_t *next = row + w;
+      for (int i = begin; i < end; i++)
+      {
+        if (next[i] + 1 < row[i])
+          row[i] = next[i] + 1;
+      }
+    }
+  });
 
-  // Find all the occupied cells and update their neighbours
-  for (j = 0; j < map->size_y; j++)
-  {
-    for (i = 0; i < map->size_x; i++)
+  // Phase 2: lower envelope of parabolas (x - u)^2 + g(u)^2 per row
+  const int64_t max_dist2 = (int64_t)cell_radius * cell_radius;
+  parallel_for(h, num_threads, [&](int begin, int end) {
+    std::vector<int> s(w), t(w);
+    for (int j = begin; j < end; j++)
     {
-      cell = map->cells + MAP_INDEX(map, i, j);
-      if (cell->occ_state != +1)
-        continue;
-          
-      cell->occ_dist = 0;
-
-      // Update adjacent cells
-      for (nj = -s; nj <= +s; nj++)
+      const int32_t *gr = &g[(size_t)j * w];
+      // squared distance of x to the closest obstacle in column u
+      auto f = [gr](int64_t x, int64_t u) -> int64_t {
+        return (x - u) * (x - u) + (int64_t)gr[u] * gr[u];
+      };
+      // intersection of the parabolas of columns i < u, rounded down
+      auto sep = [gr](int64_t i, int64_t u) -> int64_t {
+        return (u * u - i * i + (int64_t)gr[u] * gr[u] - (int64_t)gr[i] * gr[i])
+          / (2 * (u - i));
+      };
+
+      int q = 0;
+      s[0] = 0;
+      t[0] = 0;
+      for (int u = 1; u < w; u++)
       {
-        for (ni = -s; ni <= +s; ni++)
+        while (q >= 0 && f(t[q], s[q]) > f(t[q], u))
+          q--;
+        if (q < 0)
         {
-          if (!MAP_VALID(map, i + ni, j + nj))
-            continue;
-
-          ncell = map->cells + MAP_INDEX(map, i + ni, j + nj);
-          d = map->scale * sqrt(ni * ni + nj * nj);
-
-          if (d < ncell->occ_dist)
-            ncell->occ_dist = d;
+          q = 0;
+          s[0] = u;
+        }
+        else
+        {
+          int64_t x = 1 + sep(s[q], u);
+          if (x < w)
+          {
+            q++;
+            s[q] = u;
+            t[q] = x;
+          }
         }
       }
+
+      for (int u = w - 1; u >= 0; u--)
+      {
+        int64_t dist2 = f(u, s[q]);
+        if (dist2 <= max_dist2)
+          map->occ_dist_codes[MAP_DIST_INDEX(map, u, j)] =
+            occ_dist_code(map, cell_radius, dist2);
+        if (u == t[q])
+          q--;
+      }
     }
-  }
-  
-  return;
+  });
+}
+
+// Update the cspace distance values
+void map_update_cspace(map_t *map, double max_occ_dist)
+{
+  map_update_cspace_method(map, max_occ_dist, MAP_CSPACE_WAVEFRONT, 1);
+}
+
+// Update the cspace distance values with the given method
+void map_update_cspace_method(map_t *map, double max_occ_dist,
+                              map_cspace_method_t method, int num_threads)
+{
+  map->max_occ_dist = max_occ_dist;
+
+  int cell_radius = max_occ_dist / map->scale;
+  alloc_occ_dist(map, cell_radius);
+
+  if (method == MAP_CSPACE_EDT)
+    update_cspace_edt(map, cell_radius, num_threads);
+  else
+    update_cspace_wavefront(map, cell_radius);
 }
-#endif
 
 /// @endcond
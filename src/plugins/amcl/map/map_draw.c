@@ -84,7 +84,6 @@ void map_draw_cspace(map_t *map, rtk_fig_t *fig)
 {
   int i, j;
   int col;
-  map_cell_t *cell;
   uint16_t *image;
   uint16_t *pixel;
 
@@ -95,10 +94,9 @@ void map_draw_cspace(map_t *map, rtk_fig_t *fig)
   {
     for (i =  0; i < map->size_x; i++)
     {
-      cell = map->cells + MAP_INDEX(map, i, j);
       pixel = image + (j * map->size_x + i);
 
-      col = 255 * cell->occ_dist / map->max_occ_dist;
+      col = 255 * map_get_occ_dist(map, i, j) / map->max_occ_dist;
 
       *pixel = RTK_RGB16(col, col, col);
     }
@@ -44,6 +44,15 @@
 // out-of-bound cells are treated as occupied, which makes it easy to
 // use Stage bitmap files.
 double map_calc_range(map_t *map, double ox, double oy, double oa, double max_range)
+{
+  return map_calc_range_dir(map, ox, oy, cos(oa), sin(oa), max_range);
+}
+
+// Extract a single range reading from the map for a ray given by the
+// cosine and sine of its angle.  This allows callers casting many rays
+// to compute these by angle addition instead of calling cos and sin.
+double map_calc_range_dir(map_t *map, double ox, double oy,
+                          double cos_oa, double sin_oa, double max_range)
 {
   // Bresenham raytracing
   int x0,x1,y0,y1;
@@ -55,8 +64,8 @@ double map_calc_range(map_t *map, double ox, double oy, double oa, double max_ra
   x0 = MAP_GXWX(map,ox);
   y0 = MAP_GYWY(map,oy);
   
-  x1 = MAP_GXWX(map,ox + max_range * cos(oa));
-  y1 = MAP_GYWY(map,oy + max_range * sin(oa));
+  x1 = MAP_GXWX(map,ox + max_range * cos_oa);
+  y1 = MAP_GYWY(map,oy + max_range * sin_oa);
 
   if(abs(y1-y0) > abs(x1-x0))
     steep = 1;
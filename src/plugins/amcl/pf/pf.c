@@ -96,8 +96,8 @@ pf_t *pf_alloc(int min_samples, int max_samples,
       sample->weight = 1.0 / max_samples;
     }
 
-    // HACK: is 3 times max_samples enough?
-    set->kdtree = pf_kdtree_alloc(3 * max_samples);
+    // Each sample occupies at most one bin
+    set->kdtree = pf_kdtree_alloc(max_samples);
 
     set->cluster_count = 0;
     set->cluster_max_count = max_samples;
@@ -113,6 +113,8 @@ pf_t *pf_alloc(int min_samples, int max_samples,
   pf->alpha_slow = alpha_slow;
   pf->alpha_fast = alpha_fast;
 
+  pf->resample_pool = calloc(max_samples, sizeof(int));
+
   return pf;
 }
 
@@ -128,6 +130,7 @@ void pf_free(pf_t *pf)
     pf_kdtree_free(pf->sets[i].kdtree);
     free(pf->sets[i].samples);
   }
+  free(pf->resample_pool);
   free(pf);
   
   return;
@@ -275,28 +278,44 @@ void pf_update_sensor(pf_t *pf, pf_sensor_model_fn_t sensor_fn, void *sensor_dat
 // Resample the distribution
 void pf_update_resample(pf_t *pf)
 {
-  int i;
+  int i, m;
   double total;
   pf_sample_set_t *set_a, *set_b;
   pf_sample_t *sample_a, *sample_b;
 
-  //double r,c,U;
-  //int m;
-  //double count_inv;
-  double* c;
+  double r, c, U, step;
+  int pool_count, limit, limit_k;
 
   double w_diff;
 
   set_a = pf->sets + pf->current_set;
   set_b = pf->sets + (pf->current_set + 1) % 2;
 
-  // Build up cumulative probability table for resampling.
-  // TODO: Replace this with a more efficient procedure
-  // (e.g., http://www.network-theory.co.uk/docs/gslref/GeneralDiscreteDistributions.html)
-  c = (double*)malloc(sizeof(double)*(set_a->sample_count+1));
-  c[0] = 0.0;
-  for(i=0;i<set_a->sample_count;i++)
-    c[i+1] = c[i]+set_a->samples[i].weight;
+  // Low-variance resampler, taken from Probabilistic Robotics, p110.
+  // Draw a pool of max_samples indices in one pass over set a.  KLD
+  // adaptive sampling may stop before the pool is used up, therefore
+  // the pool is consumed in random order below (a partial Fisher-Yates
+  // shuffle), so that each drawn sample is distributed according to
+  // the weights while the set as a whole keeps the low variance.
+  total = 0;
+  for (i = 0; i < set_a->sample_count; i++)
+    total += set_a->samples[i].weight;
+
+  step = total / pf->max_samples;
+  r = drand48() * step;
+  c = set_a->samples[0].weight;
+  i = 0;
+  for (m = 0; m < pf->max_samples; m++)
+  {
+    U = r + m * step;
+    while (U >= c && i < set_a->sample_count - 1)
+    {
+      i++;
+      c += set_a->samples[i].weight;
+    }
+    pf->resample_pool[m] = i;
+  }
+  pool_count = 0;
 
   // Create the kd tree for adaptive sampling
   pf_kdtree_clear(set_b->kdtree);
@@ -310,16 +329,10 @@ void pf_update_resample(pf_t *pf)
     w_diff = 0.0;
   //printf("w_diff: %9.6f\n", w_diff);
 
-  // Can't (easily) combine low-variance sampler with KLD adaptive
-  // sampling, so we'll take the more traditional route.
-  /*
-  // Low-variance resampler, taken from Probabilistic Robotics, p110
-  count_inv = 1.0/set_a->sample_count;
-  r = drand48() * count_inv;
-  c = set_a->samples[0].weight;
-  i = 0;
-  m = 0;
-  */
+  // The limit only changes when a new bin is occupied
+  limit_k = -1;
+  limit = pf->max_samples;
+
   while(set_b->sample_count < pf->max_samples)
   {
     sample_b = set_b->samples + set_b->sample_count++;
@@ -328,39 +341,11 @@ void pf_update_resample(pf_t *pf)
       sample_b->pose = (pf->random_pose_fn)(pf->random_pose_data);
     else
     {
-      // Can't (easily) combine low-variance sampler with KLD adaptive
-      // sampling, so we'll take the more traditional route.
-      /*
-      // Low-variance resampler, taken from Probabilistic Robotics, p110
-      U = r + m * count_inv;
-      while(U>c)
-      {
-        i++;
-        // Handle wrap-around by resetting counters and picking a new random
-        // number
-        if(i >= set_a->sample_count)
-        {
-          r = drand48() * count_inv;
-          c = set_a->samples[0].weight;
-          i = 0;
-          m = 0;
-          U = r + m * count_inv;
-          continue;
-        }
-        c += set_a->samples[i].weight;
-      }
-      m++;
-      */
-
-      // Naive discrete event sampler
-      double r;
-      r = drand48();
-      for(i=0;i<set_a->sample_count;i++)
-      {
-        if((c[i] <= r) && (r < c[i+1]))
-          break;
-      }
-      assert(i<set_a->sample_count);
+      // Take a random index from the remainder of the pool
+      m = pool_count + (int)(drand48() * (pf->max_samples - pool_count));
+      i = pf->resample_pool[m];
+      pf->resample_pool[m] = pf->resample_pool[pool_count];
+      pf->resample_pool[pool_count++] = i;
 
       sample_a = set_a->samples + i;
 
@@ -377,7 +362,12 @@ void pf_update_resample(pf_t *pf)
     pf_kdtree_insert(set_b->kdtree, sample_b->pose, sample_b->weight);
 
     // See if we have enough samples yet
-    if (set_b->sample_count > pf_resample_limit(pf, set_b->kdtree->leaf_count))
+    if (set_b->kdtree->leaf_count != limit_k)
+    {
+      limit_k = set_b->kdtree->leaf_count;
+      limit = pf_resample_limit(pf, limit_k);
+    }
+    if (set_b->sample_count > limit)
       break;
   }
   
@@ -400,7 +390,6 @@ void pf_update_resample(pf_t *pf)
   // Use the newly created sample set
   pf->current_set = (pf->current_set + 1) % 2;
 
-  free(c);
   return;
 }
 
@@ -431,24 +420,39 @@ int pf_resample_limit(pf_t *pf, int k)
 }
 
 
-// Re-compute the cluster statistics for a sample set
+// Re-compute the cluster statistics for a sample set.  The statistics
+// are accumulated per histogram bin while inserting the samples, so
+// only the bins need to be visited here.
 void pf_cluster_stats(pf_t *pf, pf_sample_set_t *set)
 {
   int i, j, k;
   pf_cluster_t *cluster;
+  pf_kdtree_node_t *node;
   
   // Workspace
   double m[4], c[2][2];
   size_t count;
-  double weight;
+  double weight, norm;
 
   // Cluster the samples
   pf_kdtree_cluster(set->kdtree);
   
-  // Initialize cluster stats
+  // Initialize cluster stats, the bins hold the sums of the inserted
+  // sample weights, which are normalized here
   set->cluster_count = 0;
+  norm = 0.0;
+  for (i = 0; i < set->kdtree->node_count; i++)
+  {
+    node = set->kdtree->nodes + i;
+    assert(node->cluster >= 0);
+    if (node->cluster < set->cluster_max_count &&
+        node->cluster + 1 > set->cluster_count)
+      set->cluster_count = node->cluster + 1;
+    norm += node->value;
+  }
+  norm = (norm > 0.0) ? 1.0 / norm : 0.0;
 
-  for (i = 0; i < set->cluster_max_count; i++)
+  for (i = 0; i < set->cluster_count; i++)
   {
     cluster = set->clusters + i;
     cluster->count = 0;
@@ -475,45 +479,34 @@ void pf_cluster_stats(pf_t *pf, pf_sample_set_t *set)
       c[j][k] = 0.0;
   
   // Compute cluster stats
-  for (i = 0; i < set->sample_count; i++)
+  for (i = 0; i < set->kdtree->node_count; i++)
   {
-    pf_sample_t *sample = set->samples + i;
+    node = set->kdtree->nodes + i;
 
-    //printf("%d %f %f %f\n", i, sample->pose.v[0], sample->pose.v[1], sample->pose.v[2]);
-
-    // Get the cluster label for this sample
-    int cidx = pf_kdtree_get_cluster(set->kdtree, sample->pose);
-    assert(cidx >= 0);
-    if (cidx >= set->cluster_max_count)
+    if (node->cluster >= set->cluster_max_count)
       continue;
-    if (cidx + 1 > set->cluster_count)
-      set->cluster_count = cidx + 1;
     
-    cluster = set->clusters + cidx;
+    cluster = set->clusters + node->cluster;
 
-    cluster->count += 1;
-    cluster->weight += sample->weight;
+    cluster->count += node->count;
+    cluster->weight += node->value * norm;
 
-    count += 1;
-    weight += sample->weight;
+    count += node->count;
+    weight += node->value * norm;
 
     // Compute mean
-    cluster->m[0] += sample->weight * sample->pose.v[0];
-    cluster->m[1] += sample->weight * sample->pose.v[1];
-    cluster->m[2] += sample->weight * cos(sample->pose.v[2]);
-    cluster->m[3] += sample->weight * sin(sample->pose.v[2]);
-
-    m[0] += sample->weight * sample->pose.v[0];
-    m[1] += sample->weight * sample->pose.v[1];
-    m[2] += sample->weight * cos(sample->pose.v[2]);
-    m[3] += sample->weight * sin(sample->pose.v[2]);
+    for (j = 0; j < 4; j++)
+    {
+      cluster->m[j] += node->m[j] * norm;
+      m[j] += node->m[j] * norm;
+    }
 
     // Compute covariance in linear components
     for (j = 0; j < 2; j++)
       for (k = 0; k < 2; k++)
       {
-        cluster->c[j][k] += sample->weight * sample->pose.v[j] * sample->pose.v[k];
-        c[j][k] += sample->weight * sample->pose.v[j] * sample->pose.v[k];
+        cluster->c[j][k] += node->c[j][k] * norm;
+        c[j][k] += node->c[j][k] * norm;
       }
   }
 
@@ -139,6 +139,9 @@ typedef struct _pf_t
   // Function used to draw random pose samples
   pf_init_model_fn_t random_pose_fn;
   void *random_pose_data;
+
+  // Pool of sample indices drawn by the low-variance resampler
+  int *resample_pool;
 } pf_t;
 
 
@@ -42,30 +42,18 @@
 #include "pf_kdtree.h"
 
 
+// Compute the key for a pose
+static void pf_kdtree_key(pf_kdtree_t *self, pf_vector_t pose, int key[]);
+
 // Compare keys to see if they are equal
 static int pf_kdtree_equal(pf_kdtree_t *self, int key_a[], int key_b[]);
 
-// Insert a node into the tree
-static pf_kdtree_node_t *pf_kdtree_insert_node(pf_kdtree_t *self, pf_kdtree_node_t *parent,
-                                               pf_kdtree_node_t *node, int key[], double value);
-
-// Recursive node search
-static pf_kdtree_node_t *pf_kdtree_find_node(pf_kdtree_t *self, pf_kdtree_node_t *node, int key[]);
-
-// Recursively label nodes in this cluster
-static void pf_kdtree_cluster_node(pf_kdtree_t *self, pf_kdtree_node_t *node, int depth);
-
-// Recursive node printing
-//static void pf_kdtree_print_node(pf_kdtree_t *self, pf_kdtree_node_t *node);
-
-
-#ifdef INCLUDE_RTKGUI
-
-// Recursively draw nodes
-static void pf_kdtree_draw_node(pf_kdtree_t *self, pf_kdtree_node_t *node, rtk_fig_t *fig);
-
-#endif
+// Find the hash table slot for the given key; the slot is either
+// empty or holds the node with this key
+static int pf_kdtree_find_slot(pf_kdtree_t *self, int key[]);
 
+// Node search
+static pf_kdtree_node_t *pf_kdtree_find_node(pf_kdtree_t *self, int key[]);
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -73,6 +61,7 @@ static void pf_kdtree_draw_node(pf_kdtree_t *self, pf_kdtree_node_t *node, rtk_f
 pf_kdtree_t *pf_kdtree_alloc(int max_size)
 {
   pf_kdtree_t *self;
+  int hash_size;
 
   self = calloc(1, sizeof(pf_kdtree_t));
 
@@ -80,14 +69,22 @@ pf_kdtree_t *pf_kdtree_alloc(int max_size)
   self->size[1] = 0.50;
   self->size[2] = (10 * M_PI / 180);
 
-  self->root = NULL;
-
   self->node_count = 0;
   self->node_max_count = max_size;
   self->nodes = calloc(self->node_max_count, sizeof(pf_kdtree_node_t));
 
   self->leaf_count = 0;
 
+  // Keep the load factor of the hash table at or below 0.5
+  hash_size = 1;
+  while (hash_size < 2 * max_size)
+    hash_size *= 2;
+  self->hash_mask = hash_size - 1;
+  self->hash = malloc(hash_size * sizeof(int));
+  memset(self->hash, -1, hash_size * sizeof(int));
+
+  self->queue = calloc(self->node_max_count, sizeof(int));
+
   return self;
 }
 
@@ -96,6 +93,8 @@ pf_kdtree_t *pf_kdtree_alloc(int max_size)
 // Destroy a tree
 void pf_kdtree_free(pf_kdtree_t *self)
 {
+  free(self->queue);
+  free(self->hash);
   free(self->nodes);
   free(self);
   return;
@@ -106,7 +105,13 @@ void pf_kdtree_free(pf_kdtree_t *self)
 // Clear all entries from the tree
 void pf_kdtree_clear(pf_kdtree_t *self)
 {
-  self->root = NULL;
+  int i;
+
+  // Only reset the used slots, this is cheaper than clearing the
+  // whole table if there are few bins
+  for (i = 0; i < self->node_count; i++)
+    self->hash[self->nodes[i].slot] = -1;
+
   self->leaf_count = 0;
   self->node_count = 0;
 
@@ -119,33 +124,44 @@ void pf_kdtree_clear(pf_kdtree_t *self)
 void pf_kdtree_insert(pf_kdtree_t *self, pf_vector_t pose, double value)
 {
   int key[3];
+  int slot;
+  double wx, wy;
+  pf_kdtree_node_t *node;
 
-  key[0] = floor(pose.v[0] / self->size[0]);
-  key[1] = floor(pose.v[1] / self->size[1]);
-  key[2] = floor(pose.v[2] / self->size[2]);
-
-  self->root = pf_kdtree_insert_node(self, NULL, self->root, key, value);
-
-  // Test code
-  /*
-  printf("find %d %d %d\n", key[0], key[1], key[2]);
-  assert(pf_kdtree_find_node(self, self->root, key) != NULL);
+  pf_kdtree_key(self, pose, key);
 
-  pf_kdtree_print_node(self, self->root);
+  slot = pf_kdtree_find_slot(self, key);
+  if (self->hash[slot] < 0)
+  {
+    assert(self->node_count < self->node_max_count);
+    self->hash[slot] = self->node_count;
+    node = self->nodes + self->node_count++;
+    memset(node, 0, sizeof(pf_kdtree_node_t));
 
-  printf("\n");
+    node->key[0] = key[0];
+    node->key[1] = key[1];
+    node->key[2] = key[2];
+    node->cluster = -1;
+    node->slot = slot;
 
-  for (i = 0; i < self->node_count; i++)
-  {
-    node = self->nodes + i;
-    if (node->leaf)
-    {
-      printf("find %d %d %d\n", node->key[0], node->key[1], node->key[2]);
-      assert(pf_kdtree_find_node(self, self->root, node->key) == node);
-    }
+    self->leaf_count += 1;
   }
-  printf("\n\n");
-  */
+  else
+    node = self->nodes + self->hash[slot];
+
+  node->value += value;
+  node->count += 1;
+
+  wx = value * pose.v[0];
+  wy = value * pose.v[1];
+  node->m[0] += wx;
+  node->m[1] += wy;
+  node->m[2] += value * cos(pose.v[2]);
+  node->m[3] += value * sin(pose.v[2]);
+  node->c[0][0] += wx * pose.v[0];
+  node->c[0][1] += wx * pose.v[1];
+  node->c[1][0] += wy * pose.v[0];
+  node->c[1][1] += wy * pose.v[1];
 
   return;
 }
@@ -159,11 +175,9 @@ double pf_kdtree_get_prob(pf_kdtree_t *self, pf_vector_t pose)
   int key[3];
   pf_kdtree_node_t *node;
 
-  key[0] = floor(pose.v[0] / self->size[0]);
-  key[1] = floor(pose.v[1] / self->size[1]);
-  key[2] = floor(pose.v[2] / self->size[2]);
+  pf_kdtree_key(self, pose, key);
 
-  node = pf_kdtree_find_node(self, self->root, key);
+  node = pf_kdtree_find_node(self, key);
   if (node == NULL)
     return 0.0;
   return node->value;
@@ -177,17 +191,25 @@ int pf_kdtree_get_cluster(pf_kdtree_t *self, pf_vector_t pose)
   int key[3];
   pf_kdtree_node_t *node;
 
-  key[0] = floor(pose.v[0] / self->size[0]);
-  key[1] = floor(pose.v[1] / self->size[1]);
-  key[2] = floor(pose.v[2] / self->size[2]);
+  pf_kdtree_key(self, pose, key);
 
-  node = pf_kdtree_find_node(self, self->root, key);
+  node = pf_kdtree_find_node(self, key);
   if (node == NULL)
     return -1;
   return node->cluster;
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// Compute the key for a pose
+void pf_kdtree_key(pf_kdtree_t *self, pf_vector_t pose, int key[])
+{
+  key[0] = floor(pose.v[0] / self->size[0]);
+  key[1] = floor(pose.v[1] / self->size[1]);
+  key[2] = floor(pose.v[2] / self->size[2]);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Compare keys to see if they are equal
 int pf_kdtree_equal(pf_kdtree_t *self, int key_a[], int key_b[])
@@ -218,229 +240,99 @@ int pf_kdtree_equal(pf_kdtree_t *self, int key_a[], int key_b[])
 
 
 ////////////////////////////////////////////////////////////////////////////////
-// Insert a node into the tree
-pf_kdtree_node_t *pf_kdtree_insert_node(pf_kdtree_t *self, pf_kdtree_node_t *parent,
-                                        pf_kdtree_node_t *node, int key[], double value)
+// Find the hash table slot for the given key, linear probing
+int pf_kdtree_find_slot(pf_kdtree_t *self, int key[])
 {
-  int i;
-  int split, max_split;
-
-  // If the node doesnt exist yet...
-  if (node == NULL)
-  {
-    assert(self->node_count < self->node_max_count);
-    node = self->nodes + self->node_count++;
-    memset(node, 0, sizeof(pf_kdtree_node_t));
-
-    node->leaf = 1;
-
-    if (parent == NULL)
-      node->depth = 0;
-    else
-      node->depth = parent->depth + 1;
-
-    for (i = 0; i < 3; i++)
-      node->key[i] = key[i];
-
-    node->value = value;
-    self->leaf_count += 1;
-  }
-
-  // If the node exists, and it is a leaf node...
-  else if (node->leaf)
-  {
-    // If the keys are equal, increment the value
-    if (pf_kdtree_equal(self, key, node->key))
-    {
-      node->value += value;
-    }
-
-    // The keys are not equal, so split this node
-    else
-    {
-      // Find the dimension with the largest variance and do a mean
-      // split
-      max_split = 0;
-      node->pivot_dim = -1;
-      for (i = 0; i < 3; i++)
-      {
-        split = abs(key[i] - node->key[i]);
-        if (split > max_split)
-        {
-          max_split = split;
-          node->pivot_dim = i;
-        }
-      }
-      assert(node->pivot_dim >= 0);
-
-      node->pivot_value = (key[node->pivot_dim] + node->key[node->pivot_dim]) / 2.0;
+  unsigned int h;
+  int slot, n;
 
-      if (key[node->pivot_dim] < node->pivot_value)
-      {
-        node->children[0] = pf_kdtree_insert_node(self, node, NULL, key, value);
-        node->children[1] = pf_kdtree_insert_node(self, node, NULL, node->key, node->value);
-      }
-      else
-      {
-        node->children[0] = pf_kdtree_insert_node(self, node, NULL, node->key, node->value);
-        node->children[1] = pf_kdtree_insert_node(self, node, NULL, key, value);
-      }
-
-      node->leaf = 0;
-      self->leaf_count -= 1;
-    }
-  }
+  h = ((unsigned int) key[0] * 73856093u) ^
+      ((unsigned int) key[1] * 19349663u) ^
+      ((unsigned int) key[2] * 83492791u);
+  slot = (int) (h & (unsigned int) self->hash_mask);
 
-  // If the node exists, and it has children...
-  else
+  while ((n = self->hash[slot]) >= 0)
   {
-    assert(node->children[0] != NULL);
-    assert(node->children[1] != NULL);
-
-    if (key[node->pivot_dim] < node->pivot_value)
-      pf_kdtree_insert_node(self, node, node->children[0], key, value);
-    else
-      pf_kdtree_insert_node(self, node, node->children[1], key, value);
+    if (pf_kdtree_equal(self, key, self->nodes[n].key))
+      break;
+    slot = (slot + 1) & self->hash_mask;
   }
 
-  return node;
+  return slot;
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
-// Recursive node search
-pf_kdtree_node_t *pf_kdtree_find_node(pf_kdtree_t *self, pf_kdtree_node_t *node, int key[])
+// Node search
+pf_kdtree_node_t *pf_kdtree_find_node(pf_kdtree_t *self, int key[])
 {
-  if (node->leaf)
-  {
-    //printf("find  : leaf %p %d %d %d\n", node, node->key[0], node->key[1], node->key[2]);
-
-    // If the keys are the same...
-    if (pf_kdtree_equal(self, key, node->key))
-      return node;
-    else
-      return NULL;
-  }
-  else
-  {
-    //printf("find  : brch %p %d %f\n", node, node->pivot_dim, node->pivot_value);
-
-    assert(node->children[0] != NULL);
-    assert(node->children[1] != NULL);
-
-    // If the keys are different...
-    if (key[node->pivot_dim] < node->pivot_value)
-      return pf_kdtree_find_node(self, node->children[0], key);
-    else
-      return pf_kdtree_find_node(self, node->children[1], key);
-  }
-
-  return NULL;
+  int n = self->hash[pf_kdtree_find_slot(self, key)];
+  if (n < 0)
+    return NULL;
+  return self->nodes + n;
 }
 
 
-////////////////////////////////////////////////////////////////////////////////
-// Recursive node printing
-/*
-void pf_kdtree_print_node(pf_kdtree_t *self, pf_kdtree_node_t *node)
-{
-  if (node->leaf)
-  {
-    printf("(%+02d %+02d %+02d)\n", node->key[0], node->key[1], node->key[2]);
-    printf("%*s", node->depth * 11, "");
-  }
-  else
-  {
-    printf("(%+02d %+02d %+02d) ", node->key[0], node->key[1], node->key[2]);
-    pf_kdtree_print_node(self, node->children[0]);
-    pf_kdtree_print_node(self, node->children[1]);
-  }
-  return;
-}
-*/
-
-
 ////////////////////////////////////////////////////////////////////////////////
 // Cluster the leaves in the tree
 void pf_kdtree_cluster(pf_kdtree_t *self)
 {
-  int i;
+  int i, j;
   int queue_count, cluster_count;
-  pf_kdtree_node_t **queue, *node;
-
-  queue_count = 0;
-  queue = calloc(self->node_count, sizeof(queue[0]));
+  int nkey[3];
+  pf_kdtree_node_t *node, *nnode;
 
-  // Put all the leaves in a queue
   for (i = 0; i < self->node_count; i++)
-  {
-    node = self->nodes + i;
-    if (node->leaf)
-    {
-      node->cluster = -1;
-      assert(queue_count < self->node_count);
-      queue[queue_count++] = node;
-
-      // TESTING; remove
-      assert(node == pf_kdtree_find_node(self, self->root, node->key));
-    }
-  }
+    self->nodes[i].cluster = -1;
 
   cluster_count = 0;
 
-  // Do connected components for each node
-  while (queue_count > 0)
+  // Do connected components for each node, starting with the most
+  // recently inserted one.  The queue holds nodes that are labelled
+  // but whose neighbours have not been visited yet.
+  for (i = self->node_count - 1; i >= 0; i--)
   {
-    node = queue[--queue_count];
-
     // If this node has already been labelled, skip it
-    if (node->cluster >= 0)
+    if (self->nodes[i].cluster >= 0)
       continue;
 
     // Assign a label to this cluster
-    node->cluster = cluster_count++;
+    self->nodes[i].cluster = cluster_count++;
 
-    // Recursively label nodes in this cluster
-    pf_kdtree_cluster_node(self, node, 0);
-  }
+    queue_count = 0;
+    self->queue[queue_count++] = i;
 
-  free(queue);
-  return;
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Recursively label nodes in this cluster
-void pf_kdtree_cluster_node(pf_kdtree_t *self, pf_kdtree_node_t *node, int depth)
-{
-  int i;
-  int nkey[3];
+    // Label all nodes in this cluster
+    while (queue_count > 0)
+    {
+      node = self->nodes + self->queue[--queue_count];
 
-  for (i = 0; i < 3 * 3 * 3; i++)
-  {
-    nkey[0] = node->key[0] + (i / 9) - 1;
-    nkey[1] = node->key[1] + ((i % 9) / 3) - 1;
-    nkey[2] = node->key[2] + ((i % 9) % 3) - 1;
+      for (j = 0; j < 3 * 3 * 3; j++)
+      {
+        nkey[0] = node->key[0] + (j / 9) - 1;
+        nkey[1] = node->key[1] + ((j % 9) / 3) - 1;
+        nkey[2] = node->key[2] + ((j % 9) % 3) - 1;
 
-    pf_kdtree_node_t *nnode = pf_kdtree_find_node(self, self->root, nkey);
-    if (nnode == NULL)
-      continue;
+        nnode = pf_kdtree_find_node(self, nkey);
+        if (nnode == NULL)
+          continue;
 
-    assert(nnode->leaf);
+        // This node already has a label; skip it.  The label should be
+        // consistent, however.
+        if (nnode->cluster >= 0)
+        {
+          assert(nnode->cluster == node->cluster);
+          continue;
+        }
 
-    // This node already has a label; skip it.  The label should be
-    // consistent, however.
-    if (nnode->cluster >= 0)
-    {
-      assert(nnode->cluster == node->cluster);
-      continue;
+        // Label this node and visit its neighbours later
+        nnode->cluster = node->cluster;
+        assert(queue_count < self->node_max_count);
+        self->queue[queue_count++] = nnode - self->nodes;
+      }
     }
-
-    // Label this node and recurse
-    nnode->cluster = node->cluster;
-
-    pf_kdtree_cluster_node(self, nnode, depth + 1);
   }
+
   return;
 }
 
@@ -452,21 +344,16 @@ void pf_kdtree_cluster_node(pf_kdtree_t *self, pf_kdtree_node_t *node, int depth
 // Draw the tree
 void pf_kdtree_draw(pf_kdtree_t *self, rtk_fig_t *fig)
 {
-  if (self->root != NULL)
-    pf_kdtree_draw_node(self, self->root, fig);
-  return;
-}
-
+  int i;
+  pf_kdtree_node_t *node;
+  char text[64];
 
-////////////////////////////////////////////////////////////////////////////////
-// Recursively draw nodes
-void pf_kdtree_draw_node(pf_kdtree_t *self, pf_kdtree_node_t *node, rtk_fig_t *fig)
-{
-  if (node->leaf)
+  for (i = 0; i < self->node_count; i++)
   {
+    node = self->nodes + i;
+
     double ox = (node->key[0] + 0.5) * self->size[0];
     double oy = (node->key[1] + 0.5) * self->size[1];
-    char text[64];
 
     rtk_fig_rectangle(fig, ox, oy, 0.0, self->size[0], self->size[1], 0);
 
@@ -476,13 +363,6 @@ void pf_kdtree_draw_node(pf_kdtree_t *self, pf_kdtree_node_t *node, rtk_fig_t *f
     snprintf(text, sizeof(text), "%d", node->cluster);
     rtk_fig_text(fig, ox, oy, 0.0, text);
   }
-  else
-  {
-    assert(node->children[0] != NULL);
-    assert(node->children[1] != NULL);
-    pf_kdtree_draw_node(self, node->children[0], fig);
-    pf_kdtree_draw_node(self, node->children[1], fig);
-  }
 
   return;
 }
@@ -41,27 +41,27 @@
 
 /// @cond EXTERNAL
 
-// Info for a node in the tree
+// Info for a node in the tree.  The tree is flat: every node is a
+// histogram bin (a leaf), found through an open addressing hash table
+// on the key.
 typedef struct pf_kdtree_node
 {
-  // Depth in the tree
-  int leaf, depth;
-
-  // Pivot dimension and value
-  int pivot_dim;
-  double pivot_value;
-
   // The key for this node
   int key[3];
 
-  // The value for this node
+  // The value for this node and the number of inserted poses
   double value;
+  int count;
 
   // The cluster label (leaf nodes)
   int cluster;
 
-  // Child nodes
-  struct pf_kdtree_node *children[2];
+  // The hash table slot of this node
+  int slot;
+
+  // Weighted sums of the poses inserted into this bin, used to
+  // compute cluster statistics without visiting the samples again
+  double m[4], c[2][2];
 
 } pf_kdtree_node_t;
 
@@ -72,9 +72,6 @@ typedef struct
   // Cell size
   double size[3];
 
-  // The root node of the tree
-  pf_kdtree_node_t *root;
-
   // The number of nodes in the tree
   int node_count, node_max_count;
   pf_kdtree_node_t *nodes;
@@ -82,6 +79,14 @@ typedef struct
   // The number of leaf nodes in the tree
   int leaf_count;
 
+  // Hash table of node indices, -1 for empty slots; the number of
+  // slots is a power of two
+  int hash_mask;
+  int *hash;
+
+  // Workspace for clustering
+  int *queue;
+
 } pf_kdtree_t;
 
 
@@ -0,0 +1,340 @@
+
+/***************************************************************************
+ *  qa_amcl_laser_benchmark.cpp - Benchmark for the AMCL laser sensor model
+ *
+ *  Created: Fri Oct 16 14:21:07 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+// Do not include in api reference
+///@cond QA
+
+#include "../amcl_utils.h"
+#include "../map/map.h"
+#include "../pf/pf.h"
+#include "../sensors/amcl_laser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.;
+}
+
+static void
+usage(const char *progname)
+{
+  printf("Usage: %s [-m map.png | -g WxH] [-s scan.txt] [-w scan.txt] [-l model]\n"
+	 "          [-c cspace] [-p particles] [-b beams] [-n updates] [-j threads]\n"
+	 "          [-x X] [-y Y] [-a A]\n"
+	 " -m map.png    map to use, a room with pillars is generated if not given\n"
+	 " -g WxH        size of the generated room in m, 20x20 by default\n"
+	 " -r res        resolution of the map; m/pixel\n"
+	 " -s scan.txt   recorded scan to replay, ranges in m over 360 deg,\n"
+	 "               ray cast from the pose in the map if not given\n"
+	 " -w scan.txt   write the scan that is replayed to the given file\n"
+	 " -l model      laser model, beam or likelihood_field\n"
+	 " -c cspace     likelihood field cspace method, edt or wavefront\n"
+	 " -p particles  number of particles\n"
+	 " -b beams      maximum number of beams to consider\n"
+	 " -n updates    number of sensor updates per measurement\n"
+	 " -j threads    number of threads to compare to a single thread\n"
+	 " -x/-y/-a      pose to cast the scan from and to spread particles around\n",
+	 progname);
+}
+
+// A room with walls and a few pillars
+static map_t *
+generate_map(float width, float height, float resolution)
+{
+  map_t *map = map_alloc();
+  map->scale  = resolution;
+  map->size_x = (int)roundf(width / resolution);
+  map->size_y = (int)roundf(height / resolution);
+  map->origin_x = (map->size_x / 2) * map->scale;
+  map->origin_y = (map->size_y / 2) * map->scale;
+  map->cells =
+    (map_cell_t *)malloc(sizeof(map_cell_t) * map->size_x * map->size_y);
+
+  int wall = std::max(1, (int)roundf(0.2 / resolution));
+  int box  = (int)roundf(0.8 / resolution);
+  for (int j = 0; j < map->size_y; ++j) {
+    for (int i = 0; i < map->size_x; ++i) {
+      bool occ = i < wall || j < wall ||
+	i >= map->size_x - wall || j >= map->size_y - wall;
+      // pillars every 4 m
+      int pi = i % (int)roundf(4. / resolution);
+      int pj = j % (int)roundf(4. / resolution);
+      occ = occ || (i > wall && j > wall && pi < box && pj < box &&
+		    (i / (int)roundf(4. / resolution)) % 2 == 1);
+      map->cells[MAP_INDEX(map, i, j)].occ_state = occ ? +1 : -1;
+    }
+  }
+  return map;
+}
+
+static bool
+read_scan(const char *filename, std::vector<double> &ranges)
+{
+  FILE *f = fopen(filename, "r");
+  if (! f)  return false;
+  char line[4096];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#')  continue;
+    char *p = line, *end;
+    for (double r = strtod(p, &end); end != p; r = strtod(p, &end)) {
+      ranges.push_back(r);
+      p = end;
+    }
+  }
+  fclose(f);
+  return ! ranges.empty();
+}
+
+// number of weights differing, the weights must not depend on the
+// number of threads, every sample is weighed the same way in any thread
+static unsigned int
+count_differing(const std::vector<double> &a, const std::vector<double> &b)
+{
+  if (a.size() != b.size())  return std::max(a.size(), b.size());
+  unsigned int num_diff = 0;
+  for (unsigned int i = 0; i < a.size(); ++i) {
+    if (a[i] != b[i])  ++num_diff;
+  }
+  return num_diff;
+}
+
+static double
+run(pf_t *pf, const std::vector<pf_sample_t> &initial, amcl::AMCLLaser *laser,
+    amcl::AMCLLaserData &ldata, unsigned int updates, std::vector<double> &weights)
+{
+  pf_sample_set_t *set = pf->sets + pf->current_set;
+  std::copy(initial.begin(), initial.end(), set->samples);
+  pf->w_slow = pf->w_fast = 0.0;
+
+  ldata.sensor = laser;
+  double start = now();
+  for (unsigned int i = 0; i < updates; ++i) {
+    laser->UpdateSensor(pf, &ldata);
+  }
+  double duration = now() - start;
+
+  weights.resize(set->sample_count);
+  for (int i = 0; i < set->sample_count; ++i) {
+    weights[i] = set->samples[i].weight;
+  }
+  return duration;
+}
+
+int
+main(int argc, char **argv)
+{
+  const char  *map_file  = NULL;
+  const char  *scan_file = NULL;
+  const char  *out_file  = NULL;
+  std::string  model     = "likelihood_field";
+  std::string  cspace    = "edt";
+  float        res       = 0.05;
+  float        width     = 20., height = 20.;
+  unsigned int particles = 5000;
+  unsigned int beams     = 60;
+  unsigned int updates   = 20;
+  unsigned int threads   = 4;
+  double       pose_x = 5.5, pose_y = 3.1, pose_a = 0.3;
+  const double range_max = 5.6;
+
+  int c;
+  while ((c = getopt(argc, argv, "hm:g:r:s:w:l:c:p:b:n:j:x:y:a:")) != -1) {
+    switch (c) {
+    case 'm': map_file  = optarg;       break;
+    case 'g':
+      if (sscanf(optarg, "%fx%f", &width, &height) != 2) {
+	usage(argv[0]);
+	return -1;
+      }
+      break;
+    case 'r': res       = atof(optarg); break;
+    case 's': scan_file = optarg;       break;
+    case 'w': out_file  = optarg;       break;
+    case 'l': model     = optarg;       break;
+    case 'c': cspace    = optarg;       break;
+    case 'p': particles = atoi(optarg); break;
+    case 'b': beams     = atoi(optarg); break;
+    case 'n': updates   = atoi(optarg); break;
+    case 'j': threads   = atoi(optarg); break;
+    case 'x': pose_x    = atof(optarg); break;
+    case 'y': pose_y    = atof(optarg); break;
+    case 'a': pose_a    = atof(optarg); break;
+    default:  usage(argv[0]); return (c == 'h') ? 0 : -1;
+    }
+  }
+  if (particles == 0 || updates == 0 || threads == 0 || beams < 2 ||
+      (model != "beam" && model != "likelihood_field") ||
+      (cspace != "edt" && cspace != "wavefront"))
+  {
+    usage(argv[0]);
+    return -1;
+  }
+
+  map_t *map;
+  if (map_file) {
+    std::vector<std::pair<int, int> > free_space_indices;
+    map = fawkes::amcl::read_map(map_file, 0., 0., res, 0.8, 0.2, free_space_indices);
+  } else {
+    map = generate_map(width, height, res);
+  }
+
+  std::vector<double> ranges;
+  if (scan_file) {
+    if (! read_scan(scan_file, ranges)) {
+      printf("Failed to read scan from %s\n", scan_file);
+      return -1;
+    }
+  } else {
+    ranges.resize(360);
+    for (unsigned int i = 0; i < ranges.size(); ++i) {
+      ranges[i] = map_calc_range(map, pose_x, pose_y,
+				 pose_a + i * 2 * M_PI / ranges.size(), range_max);
+    }
+  }
+  if (out_file) {
+    FILE *f = fopen(out_file, "w");
+    if (f) {
+      fprintf(f, "# %zu ranges over 360 deg\n", ranges.size());
+      for (unsigned int i = 0; i < ranges.size(); ++i) {
+	fprintf(f, "%f%c", ranges[i], (i + 1 == ranges.size()) ? '\n' : ' ');
+      }
+      fclose(f);
+    }
+  }
+
+  amcl::AMCLLaserData ldata;
+  ldata.range_count = ranges.size();
+  ldata.range_max   = range_max;
+  ldata.ranges      = new double[ldata.range_count][2];
+  for (int i = 0; i < ldata.range_count; ++i) {
+    ldata.ranges[i][0] = std::min(ranges[i], range_max);
+    ldata.ranges[i][1] = fmod(i * 2 * M_PI / ldata.range_count, 2 * M_PI);
+  }
+
+  pf_t *pf = pf_alloc(particles, particles, 0., 0., NULL, NULL);
+  pf_vector_t mean = pf_vector_zero();
+  mean.v[0] = pose_x;
+  mean.v[1] = pose_y;
+  mean.v[2] = pose_a;
+  pf_matrix_t cov = pf_matrix_zero();
+  cov.m[0][0] = 0.5 * 0.5;
+  cov.m[1][1] = 0.5 * 0.5;
+  cov.m[2][2] = (M_PI / 12.0) * (M_PI / 12.0);
+  pf_init(pf, &mean, &cov);
+  pf_sample_set_t *set = pf->sets + pf->current_set;
+  std::vector<pf_sample_t> initial(set->samples, set->samples + set->sample_count);
+
+  pf_vector_t laser_pose = pf_vector_zero();
+
+  map_cspace_method_t cspace_method =
+    (cspace == "edt") ? MAP_CSPACE_EDT : MAP_CSPACE_WAVEFRONT;
+
+  double t_model_start = now();
+  amcl::AMCLLaser *laser_single = new amcl::AMCLLaser(beams, map, 1);
+  if (model == "beam") {
+    laser_single->SetModelBeam(0.95, 0.05, 0.05, 0.05, 0.2, 0.1, 0.0);
+  } else {
+    laser_single->SetModelLikelihoodField(0.95, 0.05, 0.2, 2.5, cspace_method);
+  }
+  double t_model = now() - t_model_start;
+  laser_single->SetLaserPose(laser_pose);
+
+  double t_model_multi_start = now();
+  amcl::AMCLLaser *laser_multi = new amcl::AMCLLaser(beams, map, threads);
+  if (model == "beam") {
+    laser_multi->SetModelBeam(0.95, 0.05, 0.05, 0.05, 0.2, 0.1, 0.0);
+  } else {
+    // recomputes the cspace, in parallel for the distance transform
+    laser_multi->SetModelLikelihoodField(0.95, 0.05, 0.2, 2.5, cspace_method);
+  }
+  double t_model_multi = now() - t_model_multi_start;
+  laser_multi->SetLaserPose(laser_pose);
+
+  std::vector<double> w_single, w_multi;
+  double t_single = run(pf, initial, laser_single, ldata, updates, w_single);
+  double t_multi  = run(pf, initial, laser_multi, ldata, updates, w_multi);
+
+  unsigned int num_diff = count_differing(w_single, w_multi);
+  double checksum = 0.;
+  for (unsigned int i = 0; i < w_single.size(); ++i) {
+    checksum += w_single[i] * (i + 1);
+  }
+
+  printf("Map %dx%d cells, %s model (setup %.1f ms), %d ranges, %u particles\n",
+	 map->size_x, map->size_y, model.c_str(), t_model * 1000.,
+	 ldata.range_count, particles);
+  if (model == "likelihood_field") {
+    printf("Cspace by %s in %u threads: %.1f ms\n", cspace.c_str(), threads,
+	   t_model_multi * 1000.);
+  }
+  if (map->occ_dist_codes) {
+    size_t num_cells = (size_t)map->size_x * map->size_y;
+    printf("Map memory %zu KB occupancy, %zu KB distance field\n",
+	   num_cells * sizeof(map_cell_t) / 1024,
+	   (num_cells * sizeof(uint16_t) +
+	    (map->occ_dist_max_code + 1) * sizeof(double)) / 1024);
+  }
+  printf("Sensor update (%u updates each, checksum %.17g)\n", updates, checksum);
+  printf("  1 thread:   %8.3f ms\n", t_single * 1000. / updates);
+  printf("  %u threads:  %8.3f ms  (speedup %.2f)\n", threads,
+	 t_multi * 1000. / updates, t_single / t_multi);
+  printf("  weights differing between single and %u threads: %u\n",
+	 threads, num_diff);
+  if (num_diff > 0 || ! (checksum > 0.)) {
+    printf("FAILED: weights of single and %u threads differ or are zero\n", threads);
+  }
+
+  // Only max range readings, the likelihood field model then has no
+  // beams to consider
+  unsigned int num_diff_empty = 0;
+  if (model == "likelihood_field") {
+    for (int i = 0; i < ldata.range_count; ++i)  ldata.ranges[i][0] = range_max;
+    run(pf, initial, laser_single, ldata, 1, w_single);
+    run(pf, initial, laser_multi, ldata, 1, w_multi);
+    num_diff_empty = count_differing(w_single, w_multi);
+    if (num_diff_empty > 0) {
+      printf("FAILED: weights differ for scan without valid beams\n");
+    }
+  }
+
+  delete laser_single;
+  delete laser_multi;
+  pf_free(pf);
+  map_free(map);
+
+  return (num_diff == 0 && num_diff_empty == 0 && checksum > 0.) ? 0 : 1;
+}
+
+/// @endcond
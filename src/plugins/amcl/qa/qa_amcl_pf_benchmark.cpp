@@ -0,0 +1,204 @@
+
+/***************************************************************************
+ *  qa_amcl_pf_benchmark.cpp - Benchmark for AMCL particle filter resampling
+ *
+ *  Created: Fri Oct 16 17:42:19 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+// Do not include in api reference
+///@cond QA
+
+#include "../pf/pf.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.;
+}
+
+static void
+usage(const char *progname)
+{
+  printf("Usage: %s [-p particles] [-m min_particles] [-k hypotheses] [-s sigma]\n"
+	 "          [-g WxH] [-n updates]\n"
+	 " -p particles      maximum number of particles\n"
+	 " -m min_particles  minimum number of particles\n"
+	 " -k hypotheses     number of poses the sensor model favours\n"
+	 " -s sigma          standard deviation of the sensor model in m\n"
+	 " -g WxH            size of the area the filter is initialized in\n"
+	 " -n updates        number of filter updates\n",
+	 progname);
+}
+
+typedef struct {
+  double width;
+  double height;
+} area_t;
+
+typedef struct {
+  std::vector<pf_vector_t> hyps;
+  double sigma;
+} sensor_t;
+
+static pf_vector_t
+uniform_pose(void *data)
+{
+  area_t *area = (area_t *)data;
+  pf_vector_t p;
+  p.v[0] = drand48() * area->width;
+  p.v[1] = drand48() * area->height;
+  p.v[2] = drand48() * 2 * M_PI - M_PI;
+  return p;
+}
+
+// Jitter all samples a little, like the odometry model does
+static void
+action_model(void *data, pf_sample_set_t *set)
+{
+  for (int i = 0; i < set->sample_count; ++i) {
+    pf_sample_t *s = set->samples + i;
+    s->pose.v[0] += (drand48() - 0.5) * 0.1;
+    s->pose.v[1] += (drand48() - 0.5) * 0.1;
+    s->pose.v[2] += (drand48() - 0.5) * 0.05;
+  }
+}
+
+// Mixture of Gaussians around the hypotheses, with a uniform floor
+static double
+sensor_model(void *data, pf_sample_set_t *set)
+{
+  sensor_t *sensor = (sensor_t *)data;
+  double total = 0.;
+  double k = -0.5 / (sensor->sigma * sensor->sigma);
+  for (int i = 0; i < set->sample_count; ++i) {
+    pf_sample_t *s = set->samples + i;
+    double w = 1e-3;
+    for (size_t h = 0; h < sensor->hyps.size(); ++h) {
+      double dx = s->pose.v[0] - sensor->hyps[h].v[0];
+      double dy = s->pose.v[1] - sensor->hyps[h].v[1];
+      w += exp(k * (dx * dx + dy * dy));
+    }
+    s->weight *= w;
+    total += s->weight;
+  }
+  return total;
+}
+
+int
+main(int argc, char **argv)
+{
+  int max_particles = 10000;
+  int min_particles = 100;
+  unsigned int num_hyps = 8;
+  double sigma = 1.0;
+  unsigned int updates = 100;
+  area_t area = { 40., 20. };
+
+  int c;
+  while ((c = getopt(argc, argv, "hp:m:k:s:g:n:")) != -1) {
+    switch (c) {
+    case 'p': max_particles = atoi(optarg); break;
+    case 'm': min_particles = atoi(optarg); break;
+    case 'k': num_hyps = atoi(optarg); break;
+    case 's': sigma = atof(optarg); break;
+    case 'n': updates = atoi(optarg); break;
+    case 'g':
+      if (sscanf(optarg, "%lfx%lf", &area.width, &area.height) != 2) {
+	usage(argv[0]);
+	return -1;
+      }
+      break;
+    default:  usage(argv[0]); return (c == 'h') ? 0 : -1;
+    }
+  }
+  if (max_particles <= 0 || min_particles > max_particles || updates == 0 ||
+      sigma <= 0.)
+  {
+    usage(argv[0]);
+    return -1;
+  }
+
+  srand48(42);
+  sensor_t sensor;
+  sensor.sigma = sigma;
+  for (unsigned int h = 0; h < num_hyps; ++h) {
+    sensor.hyps.push_back(uniform_pose(&area));
+  }
+
+  pf_t *pf = pf_alloc(min_particles, max_particles, 0.001, 0.1,
+		      (pf_init_model_fn_t)uniform_pose, &area);
+
+  double t_init_start = now();
+  pf_init_model(pf, (pf_init_model_fn_t)uniform_pose, &area);
+  double t_init = now() - t_init_start;
+  srand48(42);
+
+  printf("%d to %d particles in %.0fx%.0f m, %u hypotheses (sigma %.2f m)\n",
+	 min_particles, max_particles, area.width, area.height, num_hyps, sigma);
+  printf("Init:      %8.3f ms\n", t_init * 1000.);
+
+  double t_resample = 0., t_resample_max = 0.;
+  long samples = 0, clusters = 0;
+  for (unsigned int u = 0; u < updates; ++u) {
+    pf_update_action(pf, (pf_action_model_fn_t)action_model, NULL);
+    pf_update_sensor(pf, (pf_sensor_model_fn_t)sensor_model, &sensor);
+
+    double t_start = now();
+    pf_update_resample(pf);
+    double t = now() - t_start;
+    t_resample += t;
+    if (t > t_resample_max)  t_resample_max = t;
+
+    samples  += pf->sets[pf->current_set].sample_count;
+    clusters += pf->sets[pf->current_set].cluster_count;
+  }
+
+  double weight;
+  pf_vector_t mean;
+  pf_matrix_t cov;
+  double best_weight = 0.;
+  pf_vector_t best_mean = pf_vector_zero();
+  for (int i = 0; pf_get_cluster_stats(pf, i, &weight, &mean, &cov); ++i) {
+    if (weight > best_weight) {
+      best_weight = weight;
+      best_mean = mean;
+    }
+  }
+
+  printf("Resample:  %8.3f ms avg, %8.3f ms max over %u updates\n",
+	 t_resample * 1000. / updates, t_resample_max * 1000., updates);
+  printf("Samples:   %8.1f avg, %.1f clusters avg\n",
+	 (double)samples / updates, (double)clusters / updates);
+  printf("Best cluster weight %.3f at (%.2f, %.2f, %.2f)\n",
+	 best_weight, best_mean.v[0], best_mean.v[1], best_mean.v[2]);
+
+  pf_free(pf);
+  return 0;
+}
+
+/// @endcond
@@ -34,12 +34,18 @@
 #include <sys/types.h> // required by Darwin
 #include <math.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #ifdef USE_ASSERT_EXCEPTION
 #  include <core/assert_exception.h>
 #else
 #  include <assert.h>
 #endif
 #include <unistd.h>
+#include <algorithm>
+
+#include <core/threading/thread.h>
+#include <core/threading/barrier.h>
 
 #include "amcl_laser.h"
 
@@ -47,9 +53,85 @@ using namespace amcl;
 
 /// @cond EXTERNAL
 
+namespace amcl {
+
+// Thread evaluating the sensor model for blocks of samples on wakeup
+class AMCLLaserWorker : public fawkes::Thread
+{
+ public:
+  AMCLLaserWorker(AMCLLaser *laser, unsigned int thread_index)
+    : fawkes::Thread("AMCLLaserWorker", fawkes::Thread::OPMODE_WAITFORWAKEUP),
+      laser_(laser), thread_index_(thread_index)
+  {
+    set_name("AMCLLaserWorker-%u", thread_index);
+  }
+
+  virtual void loop()
+  {
+    laser_->ProcessBlocks(thread_index_);
+  }
+
+ private:
+  AMCLLaser    *laser_;
+  unsigned int  thread_index_;
+};
+
+}
+
+// Approximation of exp(x) with a relative error below 1e-9 for
+// -708 < x < 709, smaller arguments yield the smallest normal double.
+// Computes 2^n * e^f with n = round(x / ln 2) and |f| <= ln(2)/2.  It
+// has no branches or calls, loops over it can be vectorized.
+static inline double
+fast_exp(double x)
+{
+  // 1.5 * 2^52, adding it rounds to an integer kept in the low mantissa bits
+  const double round_shift = 6755399441055744.0;
+
+  double t = x * M_LOG2E;
+  t = (t < -1022.) ? -1022. : t;
+  t = (t >  1023.) ?  1023. : t;
+  double tn = t + round_shift;
+  double f = (t - (tn - round_shift)) * M_LN2;
+
+  double p = 1. + f * (1. + f * (1. / 2. + f * (1. / 6. + f * (1. / 24. +
+             f * (1. / 120. + f * (1. / 720. + f * (1. / 5040. +
+             f * (1. / 40320.))))))));
+
+  // The low 11 bits of tn hold n + 1023 after the addition, shifting
+  // them into the exponent yields 2^n.
+  uint64_t bits;
+  memcpy(&bits, &tn, sizeof(bits));
+  bits = (bits + 1023) << 52;
+  double scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+// Combine beam probabilities, clamping invalid ones to zero
+static inline double
+combine_beam_probabilities(double *pz, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    double v = pz[i];
+    v = (v < 0. || v > 1.) ? 0. : v;
+    pz[i] = v * v * v;
+  }
+
+  //      p *= pz;
+  // here we have an ad-hoc weighting scheme for combining beam probs
+  // works well, though...
+  double p = 1.0;
+  for (int i = 0; i < count; i++)
+    p += pz[i];
+  return p;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Default constructor
-AMCLLaser::AMCLLaser(size_t max_beams, map_t* map) : AMCLSensor()
+AMCLLaser::AMCLLaser(size_t max_beams, map_t* map, unsigned int num_threads)
+  : AMCLSensor()
 {
   this->time = 0.0;
 
@@ -65,9 +147,41 @@ AMCLLaser::AMCLLaser(size_t max_beams, map_t* map) : AMCLSensor()
   this->lambda_short = .1;
   this->chi_outlier = 0.0;
 
+  this->beam_count = 0;
+  this->beam_range_max = 0.0;
+  this->block_model = LASER_MODEL_BEAM;
+  this->block_set = NULL;
+  this->block_next = 0;
+
+  if (num_threads < 1)
+    num_threads = 1;
+  this->scratch.resize(num_threads, std::vector<double>(1));
+  this->barrier = NULL;
+  if (num_threads > 1)
+  {
+    this->barrier = new fawkes::Barrier(num_threads);
+    for (unsigned int i = 1; i < num_threads; i++)
+    {
+      AMCLLaserWorker *worker = new AMCLLaserWorker(this, i);
+      worker->start();
+      this->workers.push_back(worker);
+    }
+  }
+
   return;
 }
 
+AMCLLaser::~AMCLLaser()
+{
+  for (size_t i = 0; i < this->workers.size(); i++)
+  {
+    this->workers[i]->cancel();
+    this->workers[i]->join();
+    delete this->workers[i];
+  }
+  delete this->barrier;
+}
+
 void 
 AMCLLaser::SetModelBeam(double z_hit,
                         double z_short,
@@ -91,14 +205,26 @@ void
 AMCLLaser::SetModelLikelihoodField(double z_hit,
                                    double z_rand,
                                    double sigma_hit,
-                                   double max_occ_dist)
+                                   double max_occ_dist,
+                                   map_cspace_method_t cspace_method)
 {
   this->model_type = LASER_MODEL_LIKELIHOOD_FIELD;
   this->z_hit = z_hit;
   this->z_rand = z_rand;
   this->sigma_hit = sigma_hit;
 
-  map_update_cspace(this->map, max_occ_dist);
+  map_update_cspace_method(this->map, max_occ_dist, cspace_method,
+                           this->scratch.size());
+
+  // Gaussian model, pre-computed for each distance code of the map
+  // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
+  double z_hit_denom = 2 * this->sigma_hit * this->sigma_hit;
+  this->field_hit.resize(this->map->occ_dist_max_code + 1);
+  for (size_t c = 0; c < this->field_hit.size(); c++)
+  {
+    double z = this->map->occ_dist_table[c];
+    this->field_hit[c] = this->z_hit * exp(-(z * z) / z_hit_denom);
+  }
 }
 
 
@@ -129,146 +255,227 @@ bool AMCLLaser::UpdateSensor(pf_t *pf, AMCLSensorData *data)
 double AMCLLaser::BeamModel(AMCLLaserData *data, pf_sample_set_t* set)
 {
   AMCLLaser *self = static_cast<AMCLLaser*>(data->sensor);
-  double total_weight = 0.0;
+  return self->UpdateSamples(LASER_MODEL_BEAM, data, set);
+}
 
-  // Compute the sample weights
-  for (int j = 0; j < set->sample_count; j++)
+double AMCLLaser::LikelihoodFieldModel(AMCLLaserData *data, pf_sample_set_t* set)
+{
+  AMCLLaser *self = static_cast<AMCLLaser*>(data->sensor);
+  return self->UpdateSamples(LASER_MODEL_LIKELIHOOD_FIELD, data, set);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Weigh all samples, distributing blocks of samples over the workers
+double AMCLLaser::UpdateSamples(laser_model_t model, AMCLLaserData *data,
+                                pf_sample_set_t* set)
+{
+  PrepareBeams(model, data);
+
+  this->block_model = model;
+  this->block_set = set;
+  this->block_next = 0;
+  this->block_weight.assign((set->sample_count + BLOCK_SIZE - 1) / BLOCK_SIZE, 0.0);
+
+  if (this->workers.empty() || this->block_weight.size() < 2)
   {
-    pf_sample_t *sample = set->samples + j;
-    pf_vector_t  pose{sample->pose};
+    ProcessBlocks(0);
+  }
+  else
+  {
+    for (size_t i = 0; i < this->workers.size(); i++)
+      this->workers[i]->wakeup(this->barrier);
+    ProcessBlocks(0);
+    this->barrier->wait();
+  }
 
-    // Take account of the laser pose relative to the robot
-    pose = pf_vector_coord_add(self->laser_pose, pose);
+  double total_weight = 0.0;
+  for (size_t b = 0; b < this->block_weight.size(); b++)
+    total_weight += this->block_weight[b];
 
-    double p = 1.0;
+  return(total_weight);
+}
 
-    int step = (data->range_count - 1) / (self->max_beams - 1);
-    for (int i = 0; i < data->range_count; i += step)
-    {
-      double obs_range = data->ranges[i][0];
-      double obs_bearing = data->ranges[i][1];
 
-      // Compute the range according to the map
-      double map_range = map_calc_range(self->map, pose.v[0], pose.v[1],
-                                        pose.v[2] + obs_bearing, data->range_max);
-      double pz = 0.0;
+////////////////////////////////////////////////////////////////////////////////
+// Select the beams to consider and pre-compute everything which does
+// not depend on the sample pose
+void AMCLLaser::PrepareBeams(laser_model_t model, AMCLLaserData *data)
+{
+  this->beam_range.clear();
+  this->beam_cos.clear();
+  this->beam_sin.clear();
+  this->beam_short.clear();
+  this->beam_const.clear();
+  this->beam_range_max = data->range_max;
+
+  int step = (data->range_count - 1) / (this->max_beams - 1);
+  if (step < 1)
+    step = 1;
+  for (int i = 0; i < data->range_count; i += step)
+  {
+    double obs_range = data->ranges[i][0];
+    double obs_bearing = data->ranges[i][1];
+
+    // The likelihood field model ignores max range readings
+    if (model == LASER_MODEL_LIKELIHOOD_FIELD && obs_range >= data->range_max)
+      continue;
 
-      // Part 1: good, but noisy, hit
-      double z = obs_range - map_range;
-      pz += self->z_hit * exp(-(z * z) / (2 * self->sigma_hit * self->sigma_hit));
+    this->beam_range.push_back(obs_range);
+    this->beam_cos.push_back(cos(obs_bearing));
+    this->beam_sin.push_back(sin(obs_bearing));
 
-      // Part 2: short reading from unexpected obstacle (e.g., a person)
-      if(z < 0)
-        pz += self->z_short * self->lambda_short * exp(-self->lambda_short*obs_range);
+    if (model == LASER_MODEL_BEAM)
+    {
+      // Part 2: short reading from unexpected obstacle (e.g., a person),
+      // only applies if shorter than the expected range
+      this->beam_short.push_back(this->z_short * this->lambda_short *
+                                 exp(-this->lambda_short*obs_range));
 
+      double pz = 0.0;
       // Part 3: Failure to detect obstacle, reported as max-range
       if(obs_range == data->range_max)
-        pz += self->z_max * 1.0;
-
+        pz += this->z_max * 1.0;
       // Part 4: Random measurements
       if(obs_range < data->range_max)
-        pz += self->z_rand * 1.0/data->range_max;
-
-      // TODO: outlier rejection for short readings
-
-      //assert(pz <= 1.0);
-      //assert(pz >= 0.0);
-      if ( (pz < 0.) || (pz > 1.) )  pz = 0.;
-
-      //      p *= pz;
-      // here we have an ad-hoc weighting scheme for combining beam probs
-      // works well, though...
-      p += pz*pz*pz;
+        pz += this->z_rand * 1.0/data->range_max;
+      this->beam_const.push_back(pz);
     }
-
-    sample->weight *= p;
-    total_weight += sample->weight;
   }
 
-  return(total_weight);
+  this->beam_count = this->beam_range.size();
+  for (size_t i = 0; i < this->scratch.size(); i++)
+  {
+    if (this->scratch[i].size() < 3 * (size_t)this->beam_count)
+      this->scratch[i].resize(3 * this->beam_count);
+  }
 }
 
-double AMCLLaser::LikelihoodFieldModel(AMCLLaserData *data, pf_sample_set_t* set)
+
+////////////////////////////////////////////////////////////////////////////////
+// Weigh blocks of samples until all have been processed
+void AMCLLaser::ProcessBlocks(unsigned int thread_index)
 {
-  AMCLLaser *self;
-  int i, j, step;
-  double z, pz;
-  double p;
-  double obs_range, obs_bearing;
-  double total_weight;
-  pf_sample_t *sample;
-  pf_vector_t pose;
-  pf_vector_t hit;
-
-  self = (AMCLLaser*) data->sensor;
-
-  total_weight = 0.0;
-
-  // Compute the sample weights
-  for (j = 0; j < set->sample_count; j++)
-  {
-    sample = set->samples + j;
-    pose = sample->pose;
+  double *buffer = this->scratch[thread_index].data();
+  int num_blocks = this->block_weight.size();
 
-    // Take account of the laser pose relative to the robot
-    pose = pf_vector_coord_add(self->laser_pose, pose);
+  int b;
+  while ((b = __atomic_fetch_add(&this->block_next, 1, __ATOMIC_RELAXED)) < num_blocks)
+  {
+    int first = b * BLOCK_SIZE;
+    int last = std::min(first + BLOCK_SIZE, this->block_set->sample_count);
+    double weight = 0.0;
 
-    p = 1.0;
+    for (int j = first; j < last; j++)
+    {
+      pf_sample_t *sample = this->block_set->samples + j;
 
-    // Pre-compute a couple of things
-    double z_hit_denom = 2 * self->sigma_hit * self->sigma_hit;
-    double z_rand_mult = 1.0/data->range_max;
+      // Take account of the laser pose relative to the robot
+      pf_vector_t pose = pf_vector_coord_add(this->laser_pose, sample->pose);
 
-    step = (data->range_count - 1) / (self->max_beams - 1);
-    for (i = 0; i < data->range_count; i += step)
-    {
-      obs_range = data->ranges[i][0];
-      obs_bearing = data->ranges[i][1];
-
-      // This model ignores max range readings
-      if(obs_range >= data->range_max)
-        continue;
-
-      pz = 0.0;
-
-      // Compute the endpoint of the beam
-      hit.v[0] = pose.v[0] + obs_range * cos(pose.v[2] + obs_bearing);
-      hit.v[1] = pose.v[1] + obs_range * sin(pose.v[2] + obs_bearing);
-
-      // Convert to map grid coords.
-      int mi, mj;
-      mi = MAP_GXWX(self->map, hit.v[0]);
-      mj = MAP_GYWY(self->map, hit.v[1]);
-      
-      // Part 1: Get distance from the hit to closest obstacle.
-      // Off-map penalized as max distance
-      if(!MAP_VALID(self->map, mi, mj))
-        z = self->map->max_occ_dist;
+      double p;
+      if (this->block_model == LASER_MODEL_LIKELIHOOD_FIELD)
+        p = LikelihoodFieldWeight(pose, buffer);
       else
-        z = self->map->cells[MAP_INDEX(self->map,mi,mj)].occ_dist;
-      // Gaussian model
-      // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
-      pz += self->z_hit * exp(-(z * z) / z_hit_denom);
-      // Part 2: random measurements
-      pz += self->z_rand * z_rand_mult;
-
-      // TODO: outlier rejection for short readings
-
-      //assert(pz <= 1.0);
-      //assert(pz >= 0.0);
-      if ( (pz < 0.) || (pz > 1.) )  pz = 0.;
-
-      //      p *= pz;
-      // here we have an ad-hoc weighting scheme for combining beam probs
-      // works well, though...
-      p += pz*pz*pz;
+        p = BeamWeight(pose, buffer);
+
+      sample->weight *= p;
+      weight += sample->weight;
     }
 
-    sample->weight *= p;
-    total_weight += sample->weight;
+    this->block_weight[b] = weight;
   }
+}
 
-  return(total_weight);
+
+////////////////////////////////////////////////////////////////////////////////
+// Determine the probability for the given pose
+double AMCLLaser::BeamWeight(const pf_vector_t &pose, double *buffer) const
+{
+  const int n = this->beam_count;
+  const double *obs_range = this->beam_range.data();
+  const double *obs_cos = this->beam_cos.data();
+  const double *obs_sin = this->beam_sin.data();
+  const double *obs_short = this->beam_short.data();
+  const double *obs_const = this->beam_const.data();
+  double *map_range = buffer;
+  double *pz = buffer + n;
+
+  // Beam angles by angle addition with the pose's orientation
+  const double ca = cos(pose.v[2]);
+  const double sa = sin(pose.v[2]);
+
+  // Compute the range according to the map
+  for (int i = 0; i < n; i++)
+  {
+    double c = ca * obs_cos[i] - sa * obs_sin[i];
+    double s = sa * obs_cos[i] + ca * obs_sin[i];
+    map_range[i] = map_calc_range_dir(this->map, pose.v[0], pose.v[1], c, s,
+                                      this->beam_range_max);
+  }
+
+  const double z_hit_denom = 2 * this->sigma_hit * this->sigma_hit;
+  for (int i = 0; i < n; i++)
+  {
+    // Part 1: good, but noisy, hit
+    double z = obs_range[i] - map_range[i];
+    double p = this->z_hit * fast_exp(-(z * z) / z_hit_denom);
+    // Part 2, 3, and 4, pre-computed per beam
+    double p_short = obs_short[i];
+    p += (z < 0) ? p_short : 0.0;
+    p += obs_const[i];
+    // TODO: outlier rejection for short readings
+    pz[i] = p;
+  }
+
+  return combine_beam_probabilities(pz, n);
+}
+
+double AMCLLaser::LikelihoodFieldWeight(const pf_vector_t &pose, double *buffer) const
+{
+  const int n = this->beam_count;
+  const double *obs_range = this->beam_range.data();
+  const double *obs_cos = this->beam_cos.data();
+  const double *obs_sin = this->beam_sin.data();
+  const map_t *map = this->map;
+  double *hit_x = buffer;
+  double *hit_y = buffer + n;
+  double *pz = buffer + 2 * n;
+
+  // Beam angles by angle addition with the pose's orientation
+  const double px = pose.v[0];
+  const double py = pose.v[1];
+  const double ca = cos(pose.v[2]);
+  const double sa = sin(pose.v[2]);
+
+  // Compute the endpoint of the beam, one coordinate per loop to keep
+  // the number of possibly aliasing arrays low for the vectorizer
+  for (int i = 0; i < n; i++)
+    hit_x[i] = px + obs_range[i] * (ca * obs_cos[i] - sa * obs_sin[i]);
+  for (int i = 0; i < n; i++)
+    hit_y[i] = py + obs_range[i] * (sa * obs_cos[i] + ca * obs_sin[i]);
+
+  // Part 1: Get distance from the hit to closest obstacle, the
+  // Gaussian model is looked up by the distance code.
+  // Off-map penalized as max distance
+  const uint16_t *occ_dist_codes = map->occ_dist_codes;
+  const double *field_hit = this->field_hit.data();
+  const double z_rand_mult = 1.0/this->beam_range_max;
+  const double p_rand = this->z_rand * z_rand_mult;
+  for (int i = 0; i < n; i++)
+  {
+    // Convert to map grid coords.
+    int mi = MAP_GXWX(map, hit_x[i]);
+    int mj = MAP_GYWY(map, hit_y[i]);
+    int code = map->occ_dist_max_code;
+    if(MAP_VALID(map, mi, mj))
+      code = occ_dist_codes[MAP_DIST_INDEX(map,mi,mj)];
+    // Part 2: random measurements
+    // TODO: outlier rejection for short readings
+    pz[i] = field_hit[code] + p_rand;
+  }
+
+  return combine_beam_probabilities(pz, n);
 }
 
 /// @endcond
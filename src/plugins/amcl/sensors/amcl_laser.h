@@ -38,11 +38,19 @@
 #include "amcl_sensor.h"
 #include "../map/map.h"
 
+#include <vector>
+
 /// @cond EXTERNAL
 
+namespace fawkes {
+  class Barrier;
+}
+
 namespace amcl
 {
 
+class AMCLLaserWorker;
+
 typedef enum
 {
   LASER_MODEL_BEAM,
@@ -65,8 +73,14 @@ class AMCLLaserData : public AMCLSensorData
 // Laseretric sensor model
 class AMCLLaser : public AMCLSensor
 {
-  // Default constructor
-  public: AMCLLaser(size_t max_beams, map_t* map);
+  friend class AMCLLaserWorker;
+
+  // Default constructor, the sensor model is evaluated in num_threads
+  // threads including the one calling UpdateSensor()
+  public: AMCLLaser(size_t max_beams, map_t* map, unsigned int num_threads = 1);
+
+  // Destructor, stops the worker threads
+  public: virtual ~AMCLLaser();
 
   public: void SetModelBeam(double z_hit,
                             double z_short,
@@ -79,7 +93,8 @@ class AMCLLaser : public AMCLSensor
   public: void SetModelLikelihoodField(double z_hit,
                                        double z_rand,
                                        double sigma_hit,
-                                       double max_occ_dist);
+                                       double max_occ_dist,
+                                       map_cspace_method_t cspace_method = MAP_CSPACE_WAVEFRONT);
   
   // Update the filter based on the sensor model.  Returns true if the
   // filter has been updated.
@@ -96,6 +111,20 @@ class AMCLLaser : public AMCLSensor
   private: static double LikelihoodFieldModel(AMCLLaserData *data, 
                                               pf_sample_set_t* set);
 
+  // Weigh all samples with the given model, blocks of samples are
+  // distributed over the worker threads
+  private: double UpdateSamples(laser_model_t model, AMCLLaserData *data,
+                                pf_sample_set_t* set);
+  // Select the beams of a scan and pre-compute per-beam terms
+  private: void PrepareBeams(laser_model_t model, AMCLLaserData *data);
+  // Weigh blocks of samples until none is left, called in the workers
+  // and the thread running UpdateSensor()
+  private: void ProcessBlocks(unsigned int thread_index);
+  // Beam probability sum for a single (laser) pose
+  private: double BeamWeight(const pf_vector_t &pose, double *buffer) const;
+  private: double LikelihoodFieldWeight(const pf_vector_t &pose,
+                                        double *buffer) const;
+
   private: laser_model_t model_type;
 
   // Current data timestamp
@@ -124,6 +153,32 @@ class AMCLLaser : public AMCLSensor
   private: double lambda_short;
   // Threshold for outlier rejection (unused)
   private: double chi_outlier;
+
+  // Beams selected from the current scan, bearing as cosine and sine
+  private: int beam_count;
+  private: double beam_range_max;
+  private: std::vector<double> beam_range;
+  private: std::vector<double> beam_cos;
+  private: std::vector<double> beam_sin;
+  // Beam model terms which only depend on the observed range
+  private: std::vector<double> beam_short;
+  private: std::vector<double> beam_const;
+  // Likelihood field model hit term per distance code of the map
+  private: std::vector<double> field_hit;
+
+  // Samples are weighed in blocks of fixed size, the total weight is
+  // summed up per block and in block order, hence it does not depend
+  // on the number of threads or on scheduling.
+  private: static const int BLOCK_SIZE = 64;
+  private: laser_model_t block_model;
+  private: pf_sample_set_t *block_set;
+  private: int block_next;
+  private: std::vector<double> block_weight;
+
+  // Worker threads and per-thread scratch buffers
+  private: std::vector<AMCLLaserWorker *> workers;
+  private: fawkes::Barrier *barrier;
+  private: std::vector<std::vector<double> > scratch;
 };
 
 
@@ -0,0 +1,137 @@
+
+/***************************************************************************
+ *  test_cspace.cpp - AMCL cspace distance computation unit test
+ *
+ *  Created: Sat Oct 17 18:02:36 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../map/map.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/** Create random map.
+ * Cells are occupied with the given obstacle density, some of the free
+ * cells are unknown.
+ * @param width map width in cells
+ * @param height map height in cells
+ * @param density obstacle density
+ * @return newly allocated map
+ */
+static map_t *
+random_map(int width, int height, double density)
+{
+  map_t *map = map_alloc();
+  map->scale  = 0.05;
+  map->size_x = width;
+  map->size_y = height;
+  map->cells  = (map_cell_t *)malloc(sizeof(map_cell_t) * width * height);
+  for (int i = 0; i < width * height; ++i) {
+    if (rand() / (double)RAND_MAX < density) {
+      map->cells[i].occ_state = +1;
+    } else {
+      map->cells[i].occ_state = (rand() % 5 == 0) ? 0 : -1;
+    }
+  }
+  return map;
+}
+
+/** Get distance to the closest obstacle by comparing to all of them.
+ * @param map map
+ * @param i cell x index
+ * @param j cell y index
+ * @param max_occ_dist maximum distance
+ * @return distance, the maximum distance if there is no obstacle within it
+ */
+static double
+brute_force_dist(map_t *map, int i, int j, double max_occ_dist)
+{
+  int cell_radius = max_occ_dist / map->scale;
+  long best = -1;
+  for (int jj = 0; jj < map->size_y; ++jj) {
+    for (int ii = 0; ii < map->size_x; ++ii) {
+      if (map->cells[MAP_INDEX(map, ii, jj)].occ_state != +1)  continue;
+      long d2 = (long)(ii - i) * (ii - i) + (long)(jj - j) * (jj - j);
+      if (best < 0 || d2 < best)  best = d2;
+    }
+  }
+  if (best < 0 || best > (long)cell_radius * cell_radius)  return max_occ_dist;
+  return sqrt((double)best) * map->scale;
+}
+
+/** @class CSpaceTest
+ * Fixture running both cspace methods on random maps of various sizes,
+ * densities, maximum distances and thread counts.
+ */
+class CSpaceTest : public ::testing::Test
+{
+ protected:
+  /** Compute cspace for one random map per seed.
+   * @param method cspace computation method
+   * @param check function called with the map, the maximum distance, and
+   * the cell indices of every cell
+   */
+  template <typename Check>
+  void run(map_cspace_method_t method, Check check)
+  {
+    for (unsigned int seed = 1; seed <= 60; ++seed) {
+      srand(seed);
+      int    width        = 1 + rand() % 90;
+      int    height       = 1 + rand() % 90;
+      double density      = (rand() % 100) / 1000.;
+      double max_occ_dist = (rand() % 40) * 0.05 + 0.01;
+      int    num_threads  = 1 + seed % 4;
+
+      map_t *map = random_map(width, height, density);
+      map_update_cspace_method(map, max_occ_dist, method, num_threads);
+      for (int j = 0; j < height && ! HasFailure(); ++j) {
+	for (int i = 0; i < width && ! HasFailure(); ++i) {
+	  check(map, max_occ_dist, i, j);
+	}
+      }
+      map_free(map);
+
+      // report the first failing cell only
+      if (HasFailure())  FAIL() << "seed " << seed;
+    }
+  }
+};
+
+TEST_F(CSpaceTest, EdtExact)
+{
+  // both computed from the same exact squared distance
+  run(MAP_CSPACE_EDT, [](map_t *map, double max_occ_dist, int i, int j) {
+      ASSERT_EQ(brute_force_dist(map, i, j, max_occ_dist), map_get_occ_dist(map, i, j))
+	<< "cell " << i << "," << j;
+    });
+}
+
+TEST_F(CSpaceTest, WavefrontBounds)
+{
+  // the wavefront finds an obstacle, but not always the closest
+  run(MAP_CSPACE_WAVEFRONT, [](map_t *map, double max_occ_dist, int i, int j) {
+      double wave = map_get_occ_dist(map, i, j);
+      ASSERT_GE(wave, brute_force_dist(map, i, j, max_occ_dist) - 1e-9)
+	<< "cell " << i << "," << j;
+      ASSERT_LE(wave, max_occ_dist + 1e-9) << "cell " << i << "," << j;
+    });
+}
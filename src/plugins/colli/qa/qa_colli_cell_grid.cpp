@@ -0,0 +1,157 @@
+
+/***************************************************************************
+ *  qa_colli_cell_grid.cpp - Benchmark for the colli occupancy grid update
+ *
+ *  Created: Fri Oct 16 21:03:55 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ *
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version. A runtime exception applies to
+ *  this software (see LICENSE.GPL_WRE file mentioned below for details).
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL_WRE file in the doc directory.
+ */
+
+// Do not include in api reference
+///@cond QA
+
+#include "../search/obstacle.h"
+#include "../utils/occupancygrid/cell_grid.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+using namespace fawkes;
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.;
+}
+
+static void
+usage(const char *progname)
+{
+  printf("Usage: %s [-g cells] [-o obstacles] [-s size] [-r] [-n updates]\n"
+	 " -g cells      width and height of the grid in cells\n"
+	 " -o obstacles  number of obstacles stamped per update\n"
+	 " -s size       width and height of the obstacles in cells\n"
+	 " -r            use rectangular instead of elliptic obstacles\n"
+	 " -n updates    number of grid updates per measurement\n",
+	 progname);
+}
+
+int
+main(int argc, char **argv)
+{
+  int cells = 130;
+  int num_obstacles = 1000;
+  int size = 12;
+  bool rectangle = false;
+  unsigned int updates = 100;
+
+  int c;
+  while ((c = getopt(argc, argv, "hg:o:s:rn:")) != -1) {
+    switch (c) {
+    case 'g': cells = atoi(optarg); break;
+    case 'o': num_obstacles = atoi(optarg); break;
+    case 's': size = atoi(optarg); break;
+    case 'r': rectangle = true; break;
+    case 'n': updates = atoi(optarg); break;
+    default:  usage(argv[0]); return (c == 'h') ? 0 : -1;
+    }
+  }
+  if (cells <= 0 || num_obstacles < 0 || size <= 0 || updates == 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  colli_cell_cost_t costs;
+  costs.occ = 1000;
+  costs.near = 4;
+  costs.mid = 3;
+  costs.far = 2;
+  costs.free = 1;
+
+  ColliFastObstacle *obstacle;
+  if (rectangle) {
+    obstacle = new ColliFastRectangle(size, size, costs);
+  } else {
+    obstacle = new ColliFastEllipse(size, size, costs, true);
+  }
+  const std::vector<int> &obstacle_cells = obstacle->get_obstacle();
+  const ColliCellMask &mask = obstacle->get_mask();
+
+  // Obstacle positions, some of them overlapping the grid borders
+  srand(42);
+  std::vector<int> pos(2 * num_obstacles);
+  for (int i = 0; i < 2 * num_obstacles; ++i) {
+    pos[i] = rand() % (cells + 2 * size) - size;
+  }
+
+  // Reference: grid of columns, updated cell by cell
+  std::vector<std::vector<Probability> > ref(cells, std::vector<Probability>(cells));
+  double t_ref_start = now();
+  for (unsigned int u = 0; u < updates; ++u) {
+    for (int y = 0; y < cells; ++y)
+      for (int x = 0; x < cells; ++x)
+	ref[x][y] = costs.free;
+
+    for (int o = 0; o < num_obstacles; ++o) {
+      for (unsigned int i = 0; i < obstacle_cells.size(); i += 3) {
+	int x = pos[2 * o] + obstacle_cells[i];
+	int y = pos[2 * o + 1] + obstacle_cells[i + 1];
+	if ((x > 0) && (x < cells) && (y > 0) && (y < cells) &&
+	    (ref[x][y] < obstacle_cells[i + 2]))
+	{
+	  ref[x][y] = obstacle_cells[i + 2];
+	}
+      }
+    }
+  }
+  double t_ref = now() - t_ref_start;
+
+  ColliCellGrid grid;
+  grid.resize(cells, cells);
+  double t_grid_start = now();
+  for (unsigned int u = 0; u < updates; ++u) {
+    grid.fill(costs.free);
+    for (int o = 0; o < num_obstacles; ++o) {
+      grid.stamp_max(pos[2 * o], pos[2 * o + 1], mask);
+    }
+  }
+  double t_grid = now() - t_grid_start;
+
+  unsigned int mismatches = 0;
+  for (int y = 0; y < cells; ++y) {
+    for (int x = 0; x < cells; ++x) {
+      if (ref[x][y] != grid(x, y))  ++mismatches;
+    }
+  }
+
+  printf("%dx%d cells, %d %s obstacles of %d cells (mask %dx%d)\n",
+	 cells, cells, num_obstacles, rectangle ? "rectangular" : "elliptic",
+	 (int)obstacle_cells.size() / 3, mask.width(), mask.height());
+  printf("Per cell:  %8.3f ms per update\n", t_ref * 1000. / updates);
+  printf("Flat grid: %8.3f ms per update\n", t_grid * 1000. / updates);
+  printf("Mismatching cells: %u\n", mismatches);
+
+  delete obstacle;
+  return mismatches > 0 ? 1 : 0;
+}
+
+/// @endcond
@@ -24,10 +24,12 @@
 #define _PLUGINS_COLLI_SEARCH_OBSTACLE_H_
 
 #include "../common/types.h"
+#include "../utils/occupancygrid/cell_grid.h"
 #include <utils/math/common.h>
 
 #include <vector>
 #include <cmath>
+#include <memory>
 
 namespace fawkes
 {
@@ -46,11 +48,21 @@ class ColliFastObstacle
   /** Return the occupied cells with their values
    * @return vector containing the occupied cells (alternating x and y coordinates)
    */
-  inline const std::vector< int > get_obstacle()
+  inline const std::vector< int > & get_obstacle()
   {
     return occupied_cells_;
   }
 
+  /** Return the occupied cells as a dense mask, created on first use
+   * @return mask to stamp into a ColliCellGrid
+   */
+  inline const ColliCellMask & get_mask()
+  {
+    if ( ! mask_ )
+      mask_.reset( new ColliCellMask( occupied_cells_ ) );
+    return *mask_;
+  }
+
   /** Get the key
    * @return The key
    */
@@ -76,6 +88,9 @@ class ColliFastObstacle
  private:
   // a unique identifier for each obstacle
   int key_;
+
+  // dense mask of the occupied cells
+  std::shared_ptr< ColliCellMask > mask_;
 };
 
 /** @class ColliFastRectangle
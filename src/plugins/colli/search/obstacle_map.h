@@ -42,9 +42,12 @@ class ColliObstacleMap
   ColliObstacleMap(colli_cell_cost_t cell_costs, bool is_rectangle = false);
   ~ColliObstacleMap() { obstacles_.clear(); }
 
-  const std::vector< int > get_obstacle( int width, int height, bool obstacle_increasement = true );
+  const std::vector< int > & get_obstacle( int width, int height, bool obstacle_increasement = true );
+  const ColliCellMask & get_obstacle_mask( int width, int height, bool obstacle_increasement = true );
 
  private:
+  ColliFastObstacle * find_obstacle( int width, int height, bool obstacle_increasement );
+
   std::map< unsigned int, ColliFastObstacle * > obstacles_;
   bool is_rectangle_;
   colli_cell_cost_t cell_costs_;
@@ -67,8 +70,32 @@ ColliObstacleMap::ColliObstacleMap(colli_cell_cost_t cell_costs, bool is_rectang
  * @param obstacle_increasement Enable obstacle increasement?
  * @return vector with pairwise cell coordinates (x,y), that are occupied by such an obstacle
  */
-inline const std::vector< int >
+inline const std::vector< int > &
 ColliObstacleMap::get_obstacle( int width, int height, bool obstacle_increasement )
+{
+  return find_obstacle( width, height, obstacle_increasement )->get_obstacle();
+}
+
+/** Get the dense mask of a given obstacle.
+ * @param width The width of the obstacle
+ * @param height The height of the obstacle
+ * @param obstacle_increasement Enable obstacle increasement?
+ * @return mask of the cells occupied by such an obstacle
+ */
+inline const ColliCellMask &
+ColliObstacleMap::get_obstacle_mask( int width, int height, bool obstacle_increasement )
+{
+  return find_obstacle( width, height, obstacle_increasement )->get_mask();
+}
+
+/** Find an obstacle, create it if it does not exist yet.
+ * @param width The width of the obstacle
+ * @param height The height of the obstacle
+ * @param obstacle_increasement Enable obstacle increasement?
+ * @return the obstacle
+ */
+inline ColliFastObstacle *
+ColliObstacleMap::find_obstacle( int width, int height, bool obstacle_increasement )
 {
   unsigned int key = ((unsigned int)width << 16) | (unsigned int)height;
 
@@ -82,11 +109,11 @@ ColliObstacleMap::get_obstacle( int width, int height, bool obstacle_increasemen
       obstacle = new ColliFastEllipse( width, height, cell_costs_, obstacle_increasement );
     obstacle->set_key( key );
     obstacles_[ key ] = obstacle;
-    return obstacle->get_obstacle();
+    return obstacle;
 
   } else {
     // obstacle found in p (previously created obstacles)
-    return obstacles_[ key ]->get_obstacle();
+    return p->second;
   }
 }
 
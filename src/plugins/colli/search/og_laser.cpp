@@ -359,9 +359,7 @@ LaserOccupancyGrid::update_occ_grid( int midX, int midY, float inc, float vx, fl
   laser_pos_.x = midX;
   laser_pos_.y = midY;
 
-  for ( int y = 0; y < width_; ++y )
-    for ( int x = 0; x < height_; ++x )
-      occupancy_probs_[x][y] = cell_costs_.free;
+  occupancy_probs_.fill( cell_costs_.free );
 
   update_laser();
 
@@ -453,6 +451,14 @@ LaserOccupancyGrid::integrate_old_readings( int midX, int midY, float inc, float
   Clock* clock = Clock::instance();
   Time history = Time(clock) - Time(double(std::max( min_history_length_, max_history_length_)));
 
+  // 25 cm's in my opinion, that are here: 0.25*100/cell_width_
+  //int size = (int)(((0.25f+inc)*100.f)/(float)cell_width_);
+  float width = robo_shape_->get_complete_width_y();
+  width = std::max( 4.f, ((width + inc)*100.f)/cell_width_ );
+  float height = robo_shape_->get_complete_width_x();
+  height = std::max( 4.f, ((height + inc)*100.f)/cell_height_ );
+  const ColliCellMask &mask = obstacle_map_->get_obstacle_mask( width, height, cfg_obstacle_inc_ );
+
   // update all old readings
   for ( unsigned int i = 0; i < pointsTransformed->size(); ++i ) {
 
@@ -488,13 +494,7 @@ LaserOccupancyGrid::integrate_old_readings( int midX, int midY, float inc, float
       {
 	      old_readings.push_back( old_readings_[i] );
 
-	      // 25 cm's in my opinion, that are here: 0.25*100/cell_width_
-	      //int size = (int)(((0.25f+inc)*100.f)/(float)cell_width_);
-	      float width = robo_shape_->get_complete_width_y();
-	      width = std::max( 4.f, ((width + inc)*100.f)/cell_width_ );
-	      float height = robo_shape_->get_complete_width_x();
-	      height = std::max( 4.f, ((height + inc)*100.f)/cell_height_ );
-	      integrate_obstacle( posX, posY, width, height );
+	      integrate_obstacle( posX, posY, mask );
       }
       //}
     }
@@ -525,6 +525,12 @@ LaserOccupancyGrid::integrate_new_readings( int midX, int midY, float inc, float
   float oldp_x = 1000.f;
   float oldp_y = 1000.f;
 
+  float width = robo_shape_->get_complete_width_y();
+  width = std::max( 4.f, ((width + inc)*100.f)/cell_width_ );
+  float height = robo_shape_->get_complete_width_x();
+  height = std::max( 4.f, ((height + inc)*100.f)/cell_height_ );
+  const ColliCellMask &mask = obstacle_map_->get_obstacle_mask( width, height, cfg_obstacle_inc_ );
+
   for ( int i = 0; i < numberOfReadings; i++ ) {
     point = (*pointsTransformed)[i].coord;
 
@@ -537,13 +543,7 @@ LaserOccupancyGrid::integrate_new_readings( int midX, int midY, float inc, float
       posY = midY + (int)((point.y*100.f) / ((float)cell_width_ ));
 
       if ( !( posX <= 5 || posX >= height_-6 || posY <= 5 || posY >= width_-6 ) ) {
-	      float width = robo_shape_->get_complete_width_y();
-	      width = std::max( 4.f, ((width + inc)*100.f)/cell_width_ );
-
-        float height = robo_shape_->get_complete_width_x();
-        height = std::max( 4.f, ((height + inc)*100.f)/cell_height_ );
-
-        integrate_obstacle( posX, posY, width, height );
+        integrate_obstacle( posX, posY, mask );
 
         old_readings_.push_back( new_readings_[i] );
       }
@@ -553,27 +553,14 @@ LaserOccupancyGrid::integrate_new_readings( int midX, int midY, float inc, float
 }
 
 void
-LaserOccupancyGrid::integrate_obstacle( int x, int y, int width, int height )
+LaserOccupancyGrid::integrate_obstacle( int x, int y, const ColliCellMask &mask )
 {
-  std::vector< int > fast_obstacle = obstacle_map_->get_obstacle( width, height, cfg_obstacle_inc_ );
-
-  // i = x offset, i+1 = y offset, i+2 is cost
-  for( unsigned int i = 0; i < fast_obstacle.size(); i+=3 ) {
-    /* On the laser-points, we draw obstacles based on base_link. The obstacle has the robot-shape,
-     * which means that we need to rotate the shape 180° around base_link and move that rotation-
-     * point onto the laser-point on the grid. That's the same as adding the center_to_base_offset
-     * to the calculated position of the obstacle-center ("x + fast_obstacle[i]" and "y" respectively).
-     */
-    int posX = x + fast_obstacle[i]   + offset_base_.x;
-    int posY = y + fast_obstacle[i+1] + offset_base_.y;
-
-    if( (posX > 0) && (posX < height_)
-     && (posY > 0) && (posY < width_)
-     && (occupancy_probs_[posX][posY] < fast_obstacle[i+2]) )
-      {
-      occupancy_probs_[posX][posY] = fast_obstacle[i+2];
-    }
-  }
+  /* On the laser-points, we draw obstacles based on base_link. The obstacle has the robot-shape,
+   * which means that we need to rotate the shape 180° around base_link and move that rotation-
+   * point onto the laser-point on the grid. That's the same as adding the center_to_base_offset
+   * to the calculated position of the obstacle-center ("x" and "y" respectively).
+   */
+  occupancy_probs_.stamp_max( x + offset_base_.x, y + offset_base_.y, mask );
 }
 
 } // namespace fawkes
@@ -103,10 +103,9 @@ class LaserOccupancyGrid : public OccupancyGrid
   /** Integrate a single obstacle
    * @param x x coordinate of obstacle center
    * @param y y coordinate of obstacle center
-   * @param width total width of obstacle
-   * @param height total height of obstacle
+   * @param mask mask of the obstacle, see ColliObstacleMap::get_obstacle_mask()
    */
-  void integrate_obstacle( int x, int y, int width, int height );
+  void integrate_obstacle( int x, int y, const ColliCellMask &mask );
 
   tf::Transformer* tf_listener_;
   std::string reference_frame_;
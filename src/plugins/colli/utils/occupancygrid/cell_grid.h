@@ -0,0 +1,210 @@
+
+/***************************************************************************
+ *  cell_grid.h - Flat grid of cell values for the colli occupancy grids
+ *
+ *  Created: Fri Oct 16 20:12:48 2026
+ *  Copyright  2006-2026  Tim Niemueller [www.niemueller.de]
+ ****************************************************************************/
+
+/*  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  Read the full text in the LICENSE.GPL file in the doc directory.
+ */
+
+#ifndef _PLUGINS_COLLI_UTILS_OCCUPANCYGRID_CELL_GRID_H_
+#define _PLUGINS_COLLI_UTILS_OCCUPANCYGRID_CELL_GRID_H_
+
+#include "probability.h"
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace fawkes
+{
+
+/** @class ColliCellMask <plugins/colli/utils/occupancygrid/cell_grid.h>
+ * Dense rectangular mask of cell values to stamp into a ColliCellGrid.
+ * Cells outside of the stamped shape hold the lowest float value, so
+ * that stamping them does not change the grid.
+ */
+class ColliCellMask
+{
+ public:
+  ColliCellMask(const std::vector<int> &cells);
+
+  /** Get x offset of the first mask column relative to the stamp position.
+   * @return x offset in cells */
+  int x_offset() const { return x_offset_; }
+  /** Get y offset of the first mask row relative to the stamp position.
+   * @return y offset in cells */
+  int y_offset() const { return y_offset_; }
+  /** Get the width of the mask.
+   * @return number of columns */
+  int width() const { return width_; }
+  /** Get the height of the mask.
+   * @return number of rows */
+  int height() const { return height_; }
+  /** Get a row of the mask.
+   * @param y row index
+   * @return pointer to the first value of the row */
+  const Probability * row(int y) const { return &values_[y * width_]; }
+
+ private:
+  int x_offset_, y_offset_;
+  int width_, height_;
+  std::vector<Probability> values_;
+};
+
+
+/** @class ColliCellGrid <plugins/colli/utils/occupancygrid/cell_grid.h>
+ * Grid of cell values in a single row-major allocation. Rows run along
+ * the first (x) coordinate. The bulk operations work on whole rows at
+ * once and are written to be vectorized by the compiler.
+ */
+class ColliCellGrid
+{
+ public:
+  ColliCellGrid() : width_(0), height_(0) {}
+
+  void resize(int width, int height, Probability value = 0.f);
+
+  /** Get the width of the grid.
+   * @return number of cells in x direction */
+  int width() const { return width_; }
+  /** Get the height of the grid.
+   * @return number of cells in y direction */
+  int height() const { return height_; }
+
+  /** Access a cell.
+   * @param x x coordinate of the cell
+   * @param y y coordinate of the cell
+   * @return reference to the cell value */
+  Probability & operator()(int x, int y) { return cells_[y * width_ + x]; }
+  /** Access a cell.
+   * @param x x coordinate of the cell
+   * @param y y coordinate of the cell
+   * @return cell value */
+  Probability operator()(int x, int y) const { return cells_[y * width_ + x]; }
+
+  void fill(Probability value);
+  void decay(float factor, Probability base);
+  void stamp_max(int x, int y, const ColliCellMask &mask);
+
+ private:
+  int width_, height_;
+  std::vector<Probability> cells_;
+};
+
+
+/** Constructor.
+ * @param cells occupied cells, triples of x offset, y offset and value,
+ * as provided by ColliFastObstacle::get_obstacle()
+ */
+inline
+ColliCellMask::ColliCellMask(const std::vector<int> &cells)
+{
+  int x_min = 0, x_max = -1, y_min = 0, y_max = -1;
+  for (unsigned int i = 0; i < cells.size(); i += 3) {
+    if (x_max < x_min) {
+      x_min = x_max = cells[i];
+      y_min = y_max = cells[i+1];
+    } else {
+      x_min = std::min(x_min, cells[i]);
+      x_max = std::max(x_max, cells[i]);
+      y_min = std::min(y_min, cells[i+1]);
+      y_max = std::max(y_max, cells[i+1]);
+    }
+  }
+
+  x_offset_ = x_min;
+  y_offset_ = y_min;
+  width_    = x_max - x_min + 1;
+  height_   = y_max - y_min + 1;
+  values_.resize(width_ * height_, std::numeric_limits<Probability>::lowest());
+
+  for (unsigned int i = 0; i < cells.size(); i += 3) {
+    Probability &v = values_[(cells[i+1] - y_min) * width_ + (cells[i] - x_min)];
+    v = std::max(v, (Probability)cells[i+2]);
+  }
+}
+
+
+/** Resize the grid, all cells are reset.
+ * @param width number of cells in x direction
+ * @param height number of cells in y direction
+ * @param value value to set all cells to
+ */
+inline void
+ColliCellGrid::resize(int width, int height, Probability value)
+{
+  width_  = std::max(0, width);
+  height_ = std::max(0, height);
+  cells_.assign(width_ * height_, value);
+}
+
+/** Set all cells to the same value.
+ * @param value value to set all cells to
+ */
+inline void
+ColliCellGrid::fill(Probability value)
+{
+  std::fill(cells_.begin(), cells_.end(), value);
+}
+
+/** Decay all cells towards a base value.
+ * Each cell c becomes base + factor * (c - base).
+ * @param factor decay factor, 0 resets all cells to base, 1 keeps them
+ * @param base value the cells decay to
+ */
+inline void
+ColliCellGrid::decay(float factor, Probability base)
+{
+  Probability *c = cells_.data();
+  const int n = width_ * height_;
+  for (int i = 0; i < n; ++i) {
+    c[i] = base + factor * (c[i] - base);
+  }
+}
+
+/** Stamp a mask into the grid.
+ * Each cell covered by the mask is raised to the mask value if that is
+ * higher. Cells in the first row and column of the grid and outside of
+ * the grid are never modified.
+ * @param x x coordinate of the stamp position
+ * @param y y coordinate of the stamp position
+ * @param mask mask to stamp
+ */
+inline void
+ColliCellGrid::stamp_max(int x, int y, const ColliCellMask &mask)
+{
+  const int x0 = x + mask.x_offset();
+  const int y0 = y + mask.y_offset();
+
+  const int mx_begin = std::max(0, 1 - x0);
+  const int mx_end   = std::min(mask.width(), width_ - x0);
+  const int my_begin = std::max(0, 1 - y0);
+  const int my_end   = std::min(mask.height(), height_ - y0);
+  if (mx_begin >= mx_end)  return;
+
+  const int n = mx_end - mx_begin;
+  for (int my = my_begin; my < my_end; ++my) {
+    Probability * __restrict__ d = &cells_[(y0 + my) * width_ + x0 + mx_begin];
+    const Probability * __restrict__ m = mask.row(my) + mx_begin;
+    for (int i = 0; i < n; ++i) {
+      d[i] = (d[i] < m[i]) ? m[i] : d[i];
+    }
+  }
+}
+
+} // namespace fawkes
+
+#endif
@@ -52,7 +52,6 @@ OccupancyGrid::OccupancyGrid(int width, int height, int cell_width, int cell_hei
 /** Destructor */
 OccupancyGrid::~OccupancyGrid()
 {
-  occupancy_probs_.clear();
 }
 
 /** Get the cell width
@@ -139,7 +138,7 @@ void
 OccupancyGrid::set_prob(int x, int y, Probability prob)
 {
   if( (x < width_) && (y < height_) && ((isProb(prob)) || (prob == 2.f)) )
-    occupancy_probs_[x][y] = prob;
+    occupancy_probs_(x, y) = prob;
 }
 
 /** Resets all occupancy probabilities
@@ -149,49 +148,15 @@ void
 OccupancyGrid::fill(Probability prob)
 {
   if((isProb(prob)) || (prob == -1.f)) {
-    for(int x = 0; x < width_; x++) {
-      for(int y = 0; y < height_; y++) {
-        occupancy_probs_[x][y] = prob;
-      }
-    }
+    occupancy_probs_.fill(prob);
   }
 }
 
-/** Get the occupancy probability of a cell
- * @param x the x-position of the cell
- * @param y the y-position of the cell
- * @return the occupancy probability of cell (x,y)
- */
-Probability
-OccupancyGrid::get_prob(int x, int y)
-{
-  if( (x >= 0) && (x < width_) && (y >= 0) && (y < height_) ) {
-    return occupancy_probs_[x][y];
-  } else {
-    return 1;
-  }
-}
-
-/** Operator (), get occupancy probability of a cell
- * @param x the x-position of the cell
- * @param y the y-position of the cell
- * @return the occupancy probability of cell (x,y)
- */
-Probability&
-OccupancyGrid::operator () (const int x, const int y)
-{
-  return occupancy_probs_[x][y];
-}
-
 /** Init a new empty grid with the predefined parameters */
 void
 OccupancyGrid::init_grid()
 {
-  occupancy_probs_.clear();
-  std::vector<Probability> column;
-  column.resize(height_, 0.f);
-  occupancy_probs_.resize(width_, column);
-  fill( 0.f );
+  occupancy_probs_.resize(width_, height_, 0.f);
 }
 
 } // namespace fawkes
@@ -24,8 +24,7 @@
 #define _PLUGINS_COLLI_UTILS_OCCUPANCYGRID_OCCUPANCYGRID_H_
 
 #include "probability.h"
-
-#include <vector>
+#include "cell_grid.h"
 
 namespace fawkes
 {
@@ -64,7 +63,7 @@ class OccupancyGrid
   void set_height(int height);
 
   ///\brief Reset the occupancy probability of a cell
-  virtual void set_prob(int x, int y, Probability prob);
+  void set_prob(int x, int y, Probability prob);
 
   ///\brief Resets all occupancy probabilities
   void fill(Probability prob);
@@ -78,8 +77,8 @@ class OccupancyGrid
   ///\brief Init a new empty grid with the predefined parameters */
   void init_grid();
 
-  /// The occupancy probability of the cells in a 2D array
-  std::vector<std::vector<Probability> > occupancy_probs_;
+  /// The occupancy probability of the cells in a flat row-major array
+  ColliCellGrid occupancy_probs_;
 
  protected:
   int cell_width_;   /**< Cell width in cm */
@@ -89,6 +88,33 @@ class OccupancyGrid
 
 };
 
+
+/** Get the occupancy probability of a cell
+ * @param x the x-position of the cell
+ * @param y the y-position of the cell
+ * @return the occupancy probability of cell (x,y)
+ */
+inline Probability
+OccupancyGrid::get_prob(int x, int y)
+{
+  if( (x >= 0) && (x < width_) && (y >= 0) && (y < height_) ) {
+    return occupancy_probs_(x, y);
+  } else {
+    return 1;
+  }
+}
+
+/** Operator (), get occupancy probability of a cell
+ * @param x the x-position of the cell
+ * @param y the y-position of the cell
+ * @return the occupancy probability of cell (x,y)
+ */
+inline Probability&
+OccupancyGrid::operator () (const int x, const int y)
+{
+  return occupancy_probs_(x, y);
+}
+
 } // namespace fawkes
 
 #endif
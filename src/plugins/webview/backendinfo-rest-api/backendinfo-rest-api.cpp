@@ -22,6 +22,7 @@
 #include "backendinfo-rest-api.h"
 
 #include <webview/rest_api_manager.h>
+#include <interfaces/ThreadLoopTimeInterface.h>
 
 #include <set>
 
@@ -83,6 +84,9 @@ BackendInfoRestApi::init()
 	rest_api_->add_handler<WebviewRestArray<Backend>>
 		(WebRequest::METHOD_GET, "/?",
 		 std::bind(&BackendInfoRestApi::cb_list_backends, this));
+	rest_api_->add_handler<WebviewRestArray<ThreadLoopTime>>
+		(WebRequest::METHOD_GET, "/loop-times",
+		 std::bind(&BackendInfoRestApi::cb_list_loop_times, this));
 	webview_rest_api_manager->register_api(rest_api_);
 }
 
@@ -105,3 +109,37 @@ BackendInfoRestApi::cb_list_backends()
 {
 	return backends_;
 }
+
+
+WebviewRestArray<ThreadLoopTime>
+BackendInfoRestApi::cb_list_loop_times()
+{
+	WebviewRestArray<ThreadLoopTime> rv;
+
+	std::list<ThreadLoopTimeInterface *> ifs =
+		blackboard->open_multiple_for_reading<ThreadLoopTimeInterface>();
+	for (auto i : ifs) {
+		i->read();
+		if (i->has_writer()) {
+			ThreadLoopTime t;
+			t.set_kind("ThreadLoopTime");
+			t.set_apiVersion(ThreadLoopTime::api_version());
+			t.set_thread(i->thread());
+			t.set_hook(i->hook());
+			t.set_loops(i->loops());
+			t.set_loop_mean(i->loop_mean());
+			t.set_loop_p50(i->loop_p50());
+			t.set_loop_p90(i->loop_p90());
+			t.set_loop_p99(i->loop_p99());
+			t.set_loop_max(i->loop_max());
+			t.set_latency_mean(i->latency_mean());
+			t.set_latency_p50(i->latency_p50());
+			t.set_latency_p99(i->latency_p99());
+			t.set_latency_max(i->latency_max());
+			rv.push_back(std::move(t));
+		}
+		blackboard->close(i);
+	}
+
+	return rv;
+}
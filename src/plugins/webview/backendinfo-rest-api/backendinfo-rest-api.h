@@ -22,6 +22,7 @@
 #pragma once
 
 #include <core/threading/thread.h>
+#include <aspect/blackboard.h>
 #include <aspect/configurable.h>
 #include <aspect/logging.h>
 #include <aspect/webview.h>
@@ -30,9 +31,11 @@
 #include <webview/rest_array.h>
 
 #include "model/Backend.h"
+#include "model/ThreadLoopTime.h"
 
 class BackendInfoRestApi
 : public fawkes::Thread,
+	public fawkes::BlackBoardAspect,
 	public fawkes::ConfigurableAspect,
   public fawkes::LoggingAspect,
 	public fawkes::WebviewAspect
@@ -47,6 +50,7 @@ class BackendInfoRestApi
 
  private:
 	WebviewRestArray<Backend> cb_list_backends();
+	WebviewRestArray<ThreadLoopTime> cb_list_loop_times();
 
  private:
 	fawkes::WebviewRestApi        *rest_api_;
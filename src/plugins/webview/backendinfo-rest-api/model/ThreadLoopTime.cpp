@@ -0,0 +1,225 @@
+
+/****************************************************************************
+ *  ThreadLoopTime
+ *  (auto-generated, do not modify directly)
+ *
+ *  Fawkes Backend Info REST API.
+ *  Provides backend meta information to the frontend.
+ *
+ *  API Contact: Tim Niemueller <niemueller@kbsg.rwth-aachen.de>
+ *  API Version: v1beta1
+ *  API License: Apache 2.0
+ ****************************************************************************/
+
+#include "ThreadLoopTime.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <sstream>
+
+ThreadLoopTime::ThreadLoopTime()
+{
+}
+
+ThreadLoopTime::ThreadLoopTime(const std::string &json)
+{
+	from_json(json);
+}
+
+ThreadLoopTime::ThreadLoopTime(const rapidjson::Value& v)
+{
+	from_json_value(v);
+}
+
+ThreadLoopTime::~ThreadLoopTime()
+{
+}
+
+std::string
+ThreadLoopTime::to_json(bool pretty) const
+{
+	rapidjson::Document d;
+
+	to_json_value(d, d);
+
+	rapidjson::StringBuffer buffer;
+	if (pretty) {
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		d.Accept(writer);
+	} else {
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		d.Accept(writer);
+	}
+
+	return buffer.GetString();
+}
+
+void
+ThreadLoopTime::to_json_value(rapidjson::Document& d, rapidjson::Value& v) const
+{
+	rapidjson::Document::AllocatorType& allocator = d.GetAllocator();
+	v.SetObject();
+	// Avoid unused variable warnings
+	(void)allocator;
+
+	if (kind_) {
+		rapidjson::Value v_kind;
+		v_kind.SetString(*kind_, allocator);
+		v.AddMember("kind", v_kind, allocator);
+	}
+	if (apiVersion_) {
+		rapidjson::Value v_apiVersion;
+		v_apiVersion.SetString(*apiVersion_, allocator);
+		v.AddMember("apiVersion", v_apiVersion, allocator);
+	}
+	if (thread_) {
+		rapidjson::Value v_thread;
+		v_thread.SetString(*thread_, allocator);
+		v.AddMember("thread", v_thread, allocator);
+	}
+	if (hook_) {
+		rapidjson::Value v_hook;
+		v_hook.SetString(*hook_, allocator);
+		v.AddMember("hook", v_hook, allocator);
+	}
+	if (loops_) {
+		rapidjson::Value v_loops;
+		v_loops.SetInt64(*loops_);
+		v.AddMember("loops", v_loops, allocator);
+	}
+	if (loop_mean_) {
+		rapidjson::Value v_loop_mean;
+		v_loop_mean.SetDouble(*loop_mean_);
+		v.AddMember("loop_mean", v_loop_mean, allocator);
+	}
+	if (loop_p50_) {
+		rapidjson::Value v_loop_p50;
+		v_loop_p50.SetDouble(*loop_p50_);
+		v.AddMember("loop_p50", v_loop_p50, allocator);
+	}
+	if (loop_p90_) {
+		rapidjson::Value v_loop_p90;
+		v_loop_p90.SetDouble(*loop_p90_);
+		v.AddMember("loop_p90", v_loop_p90, allocator);
+	}
+	if (loop_p99_) {
+		rapidjson::Value v_loop_p99;
+		v_loop_p99.SetDouble(*loop_p99_);
+		v.AddMember("loop_p99", v_loop_p99, allocator);
+	}
+	if (loop_max_) {
+		rapidjson::Value v_loop_max;
+		v_loop_max.SetDouble(*loop_max_);
+		v.AddMember("loop_max", v_loop_max, allocator);
+	}
+	if (latency_mean_) {
+		rapidjson::Value v_latency_mean;
+		v_latency_mean.SetDouble(*latency_mean_);
+		v.AddMember("latency_mean", v_latency_mean, allocator);
+	}
+	if (latency_p50_) {
+		rapidjson::Value v_latency_p50;
+		v_latency_p50.SetDouble(*latency_p50_);
+		v.AddMember("latency_p50", v_latency_p50, allocator);
+	}
+	if (latency_p99_) {
+		rapidjson::Value v_latency_p99;
+		v_latency_p99.SetDouble(*latency_p99_);
+		v.AddMember("latency_p99", v_latency_p99, allocator);
+	}
+	if (latency_max_) {
+		rapidjson::Value v_latency_max;
+		v_latency_max.SetDouble(*latency_max_);
+		v.AddMember("latency_max", v_latency_max, allocator);
+	}
+
+}
+
+void
+ThreadLoopTime::from_json(const std::string &json)
+{
+	rapidjson::Document d;
+	d.Parse(json);
+
+	from_json_value(d);
+}
+
+void
+ThreadLoopTime::from_json_value(const rapidjson::Value& d)
+{
+	if (d.HasMember("kind") && d["kind"].IsString()) {
+		kind_ = d["kind"].GetString();
+	}
+	if (d.HasMember("apiVersion") && d["apiVersion"].IsString()) {
+		apiVersion_ = d["apiVersion"].GetString();
+	}
+	if (d.HasMember("thread") && d["thread"].IsString()) {
+		thread_ = d["thread"].GetString();
+	}
+	if (d.HasMember("hook") && d["hook"].IsString()) {
+		hook_ = d["hook"].GetString();
+	}
+	if (d.HasMember("loops") && d["loops"].IsInt64()) {
+		loops_ = d["loops"].GetInt64();
+	}
+	if (d.HasMember("loop_mean") && d["loop_mean"].IsDouble()) {
+		loop_mean_ = d["loop_mean"].GetDouble();
+	}
+	if (d.HasMember("loop_p50") && d["loop_p50"].IsDouble()) {
+		loop_p50_ = d["loop_p50"].GetDouble();
+	}
+	if (d.HasMember("loop_p90") && d["loop_p90"].IsDouble()) {
+		loop_p90_ = d["loop_p90"].GetDouble();
+	}
+	if (d.HasMember("loop_p99") && d["loop_p99"].IsDouble()) {
+		loop_p99_ = d["loop_p99"].GetDouble();
+	}
+	if (d.HasMember("loop_max") && d["loop_max"].IsDouble()) {
+		loop_max_ = d["loop_max"].GetDouble();
+	}
+	if (d.HasMember("latency_mean") && d["latency_mean"].IsDouble()) {
+		latency_mean_ = d["latency_mean"].GetDouble();
+	}
+	if (d.HasMember("latency_p50") && d["latency_p50"].IsDouble()) {
+		latency_p50_ = d["latency_p50"].GetDouble();
+	}
+	if (d.HasMember("latency_p99") && d["latency_p99"].IsDouble()) {
+		latency_p99_ = d["latency_p99"].GetDouble();
+	}
+	if (d.HasMember("latency_max") && d["latency_max"].IsDouble()) {
+		latency_max_ = d["latency_max"].GetDouble();
+	}
+
+}
+
+void
+ThreadLoopTime::validate(bool subcall) const
+{
+  std::vector<std::string> missing;
+	if (! kind_)  missing.push_back("kind");
+	if (! apiVersion_)  missing.push_back("apiVersion");
+	if (! thread_)  missing.push_back("thread");
+	if (! hook_)  missing.push_back("hook");
+	if (! loops_)  missing.push_back("loops");
+
+	if (! missing.empty()) {
+		if (subcall) {
+			throw missing;
+		} else {
+			std::ostringstream s;
+			s << "ThreadLoopTime is missing field"
+			  << ((missing.size() > 0) ? "s" : "")
+			  << ": ";
+			for (std::vector<std::string>::size_type i = 0; i < missing.size(); ++i) {
+				s << missing[i];
+				if (i < (missing.size() - 1)) {
+					s << ", ";
+				}
+			}
+			throw std::runtime_error(s.str());
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,343 @@
+
+/****************************************************************************
+ *  BackendInfo -- Schema ThreadLoopTime
+ *  (auto-generated, do not modify directly)
+ *
+ *  Fawkes Backend Info REST API.
+ *  Provides backend meta information to the frontend.
+ *
+ *  API Contact: Tim Niemueller <niemueller@kbsg.rwth-aachen.de>
+ *  API Version: v1beta1
+ *  API License: Apache 2.0
+ ****************************************************************************/
+
+#pragma once
+
+#define RAPIDJSON_HAS_STDSTRING 1
+#include <rapidjson/fwd.h>
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <optional>
+
+
+
+/** ThreadLoopTime representation for JSON transfer. */
+class ThreadLoopTime
+
+{
+ public:
+	/** Constructor. */
+	ThreadLoopTime();
+	/** Constructor from JSON.
+	 * @param json JSON string to initialize from
+	 */
+	ThreadLoopTime(const std::string &json);
+	/** Constructor from JSON.
+	 * @param v RapidJSON value object to initialize from.
+	 */
+	ThreadLoopTime(const rapidjson::Value& v);
+
+	/** Destructor. */
+	virtual ~ThreadLoopTime();
+
+	/** Get version of implemented API.
+	 * @return string representation of version
+	 */
+	static std::string api_version()
+	{
+	  return "v1beta1";
+	}
+
+	/** Render object to JSON.
+	 * @param pretty true to enable pretty printing (readable spacing)
+	 * @return JSON string
+	 */
+	virtual std::string to_json(bool pretty = false) const;
+	/** Render object to JSON.
+	 * @param d RapidJSON document to retrieve allocator from
+	 * @param v RapidJSON value to add data to
+	 */
+	virtual void        to_json_value(rapidjson::Document& d, rapidjson::Value& v) const;
+	/** Retrieve data from JSON string.
+	 * @param json JSON representation suitable for this object.
+	 * Will allow partial assignment and not validate automaticaly.
+	 * @see validate()
+	 */
+	virtual void        from_json(const std::string& json);
+	/** Retrieve data from JSON string.
+	 * @param v RapidJSON value suitable for this object.
+	 * Will allow partial assignment and not validate automaticaly.
+	 * @see validate()
+	 */
+	virtual void        from_json_value(const rapidjson::Value& v);
+
+	/** Validate if all required fields have been set.
+	 * @param subcall true if this is called from another class, e.g.,
+	 * a sub-class or array holder. Will modify the kind of exception thrown.
+	 * @exception std::vector<std::string> thrown if required information is
+	 * missing and @p subcall is set to true. Contains a list of missing fields.
+	 * @exception std::runtime_error informative message describing the missing
+	 * fields
+	 */
+	virtual void validate(bool subcall = false) const;
+
+	// Schema: ThreadLoopTime
+ public:
+  /** Get kind value.
+   * @return kind value
+   */
+	std::optional<std::string>
+ kind() const
+	{
+		return kind_;
+	}
+
+	/** Set kind value.
+	 * @param kind new value
+	 */
+	void set_kind(const std::string& kind)
+	{
+		kind_ = kind;
+	}
+  /** Get apiVersion value.
+   * @return apiVersion value
+   */
+	std::optional<std::string>
+ apiVersion() const
+	{
+		return apiVersion_;
+	}
+
+	/** Set apiVersion value.
+	 * @param apiVersion new value
+	 */
+	void set_apiVersion(const std::string& apiVersion)
+	{
+		apiVersion_ = apiVersion;
+	}
+  /** Get thread value.
+   * @return thread value
+   */
+	std::optional<std::string>
+ thread() const
+	{
+		return thread_;
+	}
+
+	/** Set thread value.
+	 * @param thread new value
+	 */
+	void set_thread(const std::string& thread)
+	{
+		thread_ = thread;
+	}
+  /** Get hook value.
+   * @return hook value
+   */
+	std::optional<std::string>
+ hook() const
+	{
+		return hook_;
+	}
+
+	/** Set hook value.
+	 * @param hook new value
+	 */
+	void set_hook(const std::string& hook)
+	{
+		hook_ = hook;
+	}
+  /** Get loops value.
+   * @return loops value
+   */
+	std::optional<int64_t>
+ loops() const
+	{
+		return loops_;
+	}
+
+	/** Set loops value.
+	 * @param loops new value
+	 */
+	void set_loops(const int64_t& loops)
+	{
+		loops_ = loops;
+	}
+  /** Get loop_mean value.
+   * @return loop_mean value
+   */
+	std::optional<double>
+ loop_mean() const
+	{
+		return loop_mean_;
+	}
+
+	/** Set loop_mean value.
+	 * @param loop_mean new value
+	 */
+	void set_loop_mean(const double& loop_mean)
+	{
+		loop_mean_ = loop_mean;
+	}
+  /** Get loop_p50 value.
+   * @return loop_p50 value
+   */
+	std::optional<double>
+ loop_p50() const
+	{
+		return loop_p50_;
+	}
+
+	/** Set loop_p50 value.
+	 * @param loop_p50 new value
+	 */
+	void set_loop_p50(const double& loop_p50)
+	{
+		loop_p50_ = loop_p50;
+	}
+  /** Get loop_p90 value.
+   * @return loop_p90 value
+   */
+	std::optional<double>
+ loop_p90() const
+	{
+		return loop_p90_;
+	}
+
+	/** Set loop_p90 value.
+	 * @param loop_p90 new value
+	 */
+	void set_loop_p90(const double& loop_p90)
+	{
+		loop_p90_ = loop_p90;
+	}
+  /** Get loop_p99 value.
+   * @return loop_p99 value
+   */
+	std::optional<double>
+ loop_p99() const
+	{
+		return loop_p99_;
+	}
+
+	/** Set loop_p99 value.
+	 * @param loop_p99 new value
+	 */
+	void set_loop_p99(const double& loop_p99)
+	{
+		loop_p99_ = loop_p99;
+	}
+  /** Get loop_max value.
+   * @return loop_max value
+   */
+	std::optional<double>
+ loop_max() const
+	{
+		return loop_max_;
+	}
+
+	/** Set loop_max value.
+	 * @param loop_max new value
+	 */
+	void set_loop_max(const double& loop_max)
+	{
+		loop_max_ = loop_max;
+	}
+  /** Get latency_mean value.
+   * @return latency_mean value
+   */
+	std::optional<double>
+ latency_mean() const
+	{
+		return latency_mean_;
+	}
+
+	/** Set latency_mean value.
+	 * @param latency_mean new value
+	 */
+	void set_latency_mean(const double& latency_mean)
+	{
+		latency_mean_ = latency_mean;
+	}
+  /** Get latency_p50 value.
+   * @return latency_p50 value
+   */
+	std::optional<double>
+ latency_p50() const
+	{
+		return latency_p50_;
+	}
+
+	/** Set latency_p50 value.
+	 * @param latency_p50 new value
+	 */
+	void set_latency_p50(const double& latency_p50)
+	{
+		latency_p50_ = latency_p50;
+	}
+  /** Get latency_p99 value.
+   * @return latency_p99 value
+   */
+	std::optional<double>
+ latency_p99() const
+	{
+		return latency_p99_;
+	}
+
+	/** Set latency_p99 value.
+	 * @param latency_p99 new value
+	 */
+	void set_latency_p99(const double& latency_p99)
+	{
+		latency_p99_ = latency_p99;
+	}
+  /** Get latency_max value.
+   * @return latency_max value
+   */
+	std::optional<double>
+ latency_max() const
+	{
+		return latency_max_;
+	}
+
+	/** Set latency_max value.
+	 * @param latency_max new value
+	 */
+	void set_latency_max(const double& latency_max)
+	{
+		latency_max_ = latency_max;
+	}
+ private:
+	std::optional<std::string>
+ kind_;
+	std::optional<std::string>
+ apiVersion_;
+	std::optional<std::string>
+ thread_;
+	std::optional<std::string>
+ hook_;
+	std::optional<int64_t>
+ loops_;
+	std::optional<double>
+ loop_mean_;
+	std::optional<double>
+ loop_p50_;
+	std::optional<double>
+ loop_p90_;
+	std::optional<double>
+ loop_p99_;
+	std::optional<double>
+ loop_max_;
+	std::optional<double>
+ latency_mean_;
+	std::optional<double>
+ latency_p50_;
+	std::optional<double>
+ latency_p99_;
+	std::optional<double>
+ latency_max_;
+
+};
\ No newline at end of file
@@ -25,12 +25,16 @@
 #include <netcomm/fawkes/component_ids.h>
 #include <network_logger/network_logger.h>
 #include <logging/console.h>
+#include <logging/binary_reader.h>
 #include <utils/system/signal.h>
 #include <utils/system/argparser.h>
 
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
+#include <string>
+#include <unistd.h>
 
 using namespace fawkes;
 
@@ -121,25 +125,147 @@ class NetLogConsolePrinter
   ConsoleLogger *logger;
   bool quit;
 };
+
+
+class BinaryLogPrinter : public SignalHandler
+{
+ public:
+  BinaryLogPrinter(const char *filename, Logger::LogLevel min_level,
+		   const char *component, const char *text)
+  {
+    reader = new BinaryLogReader(filename);
+    logger = new ConsoleLogger();
+    this->min_level = min_level;
+    this->component = component;
+    this->text = text;
+    quit = false;
+  }
+
+  ~BinaryLogPrinter()
+  {
+    delete reader;
+    delete logger;
+  }
+
+  void handle_signal(int signal)
+  {
+    quit = true;
+  }
+
+  bool matches(const BinaryLogReader::Entry &entry)
+  {
+    if ( component && (entry.component.find(component) == std::string::npos) ) {
+      return false;
+    }
+    if ( text ) {
+      for (size_t i = 0; i < entry.messages.size(); ++i) {
+	if (entry.messages[i].find(text) != std::string::npos)  return true;
+      }
+      return false;
+    }
+    return true;
+  }
+
+  void print(BinaryLogReader::Entry &entry)
+  {
+    if ( entry.exception ) {
+      Exception e("%s", entry.messages.empty() ? "" : entry.messages[0].c_str());
+      for (size_t i = 1; i < entry.messages.size(); ++i) {
+	e.append("%s", entry.messages[i].c_str());
+      }
+      logger->tlog(entry.level, &entry.time, entry.component.c_str(), e);
+    } else {
+      logger->tlog(entry.level, &entry.time, entry.component.c_str(), "%s",
+		   entry.messages.empty() ? "" : entry.messages[0].c_str());
+    }
+  }
+
+  void run(bool follow, long int last)
+  {
+    BinaryLogReader::Entry entry;
+
+    if ( last >= 0 ) {
+      std::deque<BinaryLogReader::Entry> tail;
+      while ( ! quit && reader->next(entry, min_level) ) {
+	if ( ! matches(entry) )  continue;
+	tail.push_back(entry);
+	if ( (long int)tail.size() > last )  tail.pop_front();
+      }
+      for (size_t i = 0; i < tail.size(); ++i)  print(tail[i]);
+    }
+
+    do {
+      while ( ! quit && reader->next(entry, min_level) ) {
+	if ( matches(entry) )  print(entry);
+      }
+      if ( follow && ! quit ) {
+	usleep(100000);
+	reader->update();
+      }
+    } while ( follow && ! quit );
+  }
+
+ private:
+  BinaryLogReader  *reader;
+  ConsoleLogger    *logger;
+  Logger::LogLevel  min_level;
+  const char       *component;
+  const char       *text;
+  bool              quit;
+};
 /// @endcond
 
 
 void
 print_usage(const char *program_name)
 {
-  printf("Usage: %s [hostname[:port]]\n", program_name);
+  printf("Usage: %s [-h] [hostname[:port]]\n"
+	 "       %s -r file [-f] [-n N] [-l level] [-c component] [-g text]\n"
+	 " -h              this help message\n"
+	 " -r file         read binary log file written by the binary logger\n"
+	 " -f              follow file, print entries as they are appended\n"
+	 " -n N            only print the last N entries of the file\n"
+	 " -l level        minimum log level (debug, info, warn, error)\n"
+	 " -c component    only print entries whose component contains this string\n"
+	 " -g text         only print entries whose message contains this string\n",
+	 program_name, program_name);
 }
 
 int
 main(int argc, char **argv)
 {
-  ArgumentParser argp(argc, argv, "h");
+  ArgumentParser argp(argc, argv, "hr:fn:l:c:g:");
 
   if ( argp.has_arg("h") ) {
     print_usage(argv[0]);
     exit(0);
   }
 
+  if ( argp.has_arg("r") ) {
+    Logger::LogLevel min_level = Logger::LL_DEBUG;
+    if ( argp.has_arg("l") ) {
+      std::string ll = argp.arg("l");
+      if (ll == "info") {
+	min_level = Logger::LL_INFO;
+      } else if (ll == "warn") {
+	min_level = Logger::LL_WARN;
+      } else if (ll == "error") {
+	min_level = Logger::LL_ERROR;
+      }
+    }
+    long int last = argp.has_arg("n") ? argp.parse_int("n") : -1;
+
+    try {
+      BinaryLogPrinter printer(argp.arg("r"), min_level, argp.arg("c"), argp.arg("g"));
+      SignalManager::register_handler(SIGINT, &printer);
+      printer.run(argp.has_arg("f"), last);
+    } catch (Exception &e) {
+      printf("Failed to read binary log: %s\n", e.what_no_backtrace());
+      return 1;
+    }
+    return 0;
+  }
+
   const char *hostport = (argp.num_items() > 0) ? argp.items()[0] : "localhost:1910";
   NetLogConsolePrinter printer(hostport);
 